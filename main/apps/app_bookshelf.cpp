@@ -6,37 +6,84 @@
 #include "apps.h"
 #include "hal.h"
 #include <mooncake_log.h>
-#include <dirent.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <sys/stat.h>
 #include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <cJSON.h>
+#include "gray_png.h"
+#include "dictionary.h"
+#include "bookshelf_ui.h"
 
 using namespace mooncake;
 
-// 屏幕和布局常量
-static constexpr int SCREEN_WIDTH = 540;
-static constexpr int SCREEN_HEIGHT = 960;
-static constexpr int PAGE_CONTENT_HEIGHT = 900;  // 页面内容高度
-static constexpr int UI_HEIGHT = 60;             // 底部UI高度
 static constexpr int MENU_HEIGHT = 80;
 
 // 列表布局常量
-static constexpr int LIST_HEADER_HEIGHT = 80;
 static constexpr int LIST_ITEM_HEIGHT = 200;
 static constexpr int LIST_PADDING = 20;
 static constexpr int COVER_SIZE = 160;
 
-// 颜色常量
-static constexpr uint32_t COLOR_BG = 0xFFFFFF;
-static constexpr uint32_t COLOR_TEXT = 0x000000;
-static constexpr uint32_t COLOR_TEXT_GRAY = 0x666666;
-static constexpr uint32_t COLOR_BORDER = 0xCCCCCC;
-static constexpr uint32_t COLOR_BTN = 0xEEEEEE;
-static constexpr uint32_t COLOR_PROGRESS = 0x333333;
-
 // 翻页刷新控制
 static constexpr int FULL_REFRESH_INTERVAL = 8;  // 每8页全刷新一次
 
+// 快速路径每次推送到屏幕的行数（540 × 30 = 16KB 缓冲）
+static constexpr int DECODE_BAND_ROWS = 30;
+
+// 条带布局（连续滚动）
+static constexpr int STRIP_SCROLL_PAGE = PAGE_CONTENT_HEIGHT - 100;  // 点按翻页，保留 100px 上下文
+static constexpr int STRIP_SCROLL_HALF = PAGE_CONTENT_HEIGHT / 2;    // 纵向滑动，半页
+static constexpr int STRIP_CACHE_COUNT = 16;                         // 一屏约 10 条 + 半页滚动
+
+// 逐行灰度攒成条带后推送到屏幕，减少 pushGrayscaleImage 调用次数
+class GrayBandWriter {
+public:
+    GrayBandWriter(book::AppArena& arena, int width, int y) : _arena(arena), _width(width), _y(y)
+    {
+        _band = (uint8_t*)_arena.alloc(width * DECODE_BAND_ROWS);
+        GetHAL().display.startWrite();
+    }
+    ~GrayBandWriter()
+    {
+        flush();
+        GetHAL().display.endWrite();
+        _arena.free(_band);
+    }
+
+    bool valid() const
+    {
+        return _band != nullptr;
+    }
+
+    void push(const uint8_t* gray)
+    {
+        memcpy(_band + _rows * _width, gray, _width);
+        if (++_rows == DECODE_BAND_ROWS) {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        if (_rows == 0 || !_band) return;
+        // grayscale_8bit：0x00 取 backcolor（传入黑色），0xFF 取 forecolor（传入白色）
+        GetHAL().display.pushGrayscaleImage(0, _y, _width, _rows, _band, lgfx::grayscale_8bit, COLOR_BG,
+                                            COLOR_TEXT);
+        _y += _rows;
+        _rows = 0;
+    }
+
+private:
+    book::AppArena& _arena;
+    uint8_t* _band = nullptr;
+    int _width     = 0;
+    int _y         = 0;
+    int _rows      = 0;
+};
+
 void AppBookshelf::onCreate()
 {
     setAppInfo().name = "AppBookshelf";
@@ -45,7 +92,8 @@ void AppBookshelf::onCreate()
     GetHAL().display.setRotation(0);
     _state = STATE_LOADING;
     
-    loadBooks();
+    // 书籍列表由 BookLibrary 保留，这里只处理上次关闭书架之后的变化
+    BookLibrary::getInstance().sync();
     
     if (_books.empty()) {
         mclog::tagInfo(getAppInfo().name, "No books found");
@@ -72,12 +120,25 @@ void AppBookshelf::onRunning()
             _need_redraw = false;
         }
         handleListTouch();
+    } else if (_state == STATE_SEARCH) {
+        if (_need_redraw) {
+            _search.draw();
+            _need_redraw = false;
+        }
+        _search.poll();
+        handleSearchTouch();
     } else if (_state == STATE_READING) {
         if (_need_redraw) {
             drawReading();
             _need_redraw = false;
         }
         handleReadingTouch();
+        
+        // 面板刷新期间把下一页解码到后缓冲（书写中不做，以免耽误触摸采样）
+        if (_read_ahead_pending && !_need_redraw && !_ink.writing()) {
+            _read_ahead_pending = false;
+            prepareNextFrame();
+        }
     }
 }
 
@@ -89,165 +150,31 @@ void AppBookshelf::onDestroy()
         saveReadingProgress();
     }
     
-    freeBookCovers();
+    _thumbs.close();
+    _text.close();
+    closeFulltext();
+    _dict.close();
+    _ink.close();
+    
     freePageImage();
+    _strip_reader.close();
+    _band_decoder.stop();
+    freeFrameBuffers();
+    _screen_tiles = book::ArenaVector<uint32_t>(book::ArenaAllocator<uint32_t>(_arena));
+    
+    // 各 free*() 漏掉的块在这里一并归还，记为泄漏
+    _arena.release();
+    logArenaStats("destroy");
 }
 
-void AppBookshelf::loadBooks()
+void AppBookshelf::logArenaStats(const char* when)
 {
-    mclog::tagInfo(getAppInfo().name, "Loading books from /sdcard/books");
-    
-    _books.clear();
-    
-    DIR* dir = opendir("/sdcard/books");
-    if (!dir) {
-        mclog::tagError(getAppInfo().name, "Failed to open /sdcard/books");
-        return;
-    }
-    
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        if (entry->d_type != DT_DIR) continue;
-        if (entry->d_name[0] == '.') continue;
-        
-        std::string bookId = entry->d_name;
-        std::string bookPath = "/sdcard/books/" + bookId;
-        
-        mclog::tagInfo(getAppInfo().name, "Found book: {}", bookId);
-        
-        // 读取 metadata.json
-        std::string metadataPath = bookPath + "/metadata.json";
-        FILE* f = fopen(metadataPath.c_str(), "r");
-        if (!f) {
-            mclog::tagError(getAppInfo().name, "Failed to open {}", metadataPath);
-            continue;
-        }
-        
-        fseek(f, 0, SEEK_END);
-        size_t size = ftell(f);
-        fseek(f, 0, SEEK_SET);
-        
-        char* buffer = (char*)malloc(size + 1);
-        fread(buffer, 1, size, f);
-        buffer[size] = '\0';
-        fclose(f);
-        
-        cJSON* json = cJSON_Parse(buffer);
-        free(buffer);
-        
-        if (!json) {
-            mclog::tagError(getAppInfo().name, "Failed to parse metadata.json");
-            continue;
-        }
-        
-        BookInfo book;
-        book.id = bookId;
-        
-        cJSON* titleItem = cJSON_GetObjectItem(json, "title");
-        cJSON* authorItem = cJSON_GetObjectItem(json, "author");
-        cJSON* addedAtItem = cJSON_GetObjectItem(json, "addedAt");
-        
-        book.title = titleItem ? titleItem->valuestring : "未知书名";
-        book.author = authorItem ? authorItem->valuestring : "未知作者";
-        book.addedAt = addedAtItem ? addedAtItem->valuestring : "";
-        
-        // 解析 anchorMap（可选）
-        cJSON* anchorMapItem = cJSON_GetObjectItem(json, "anchorMap");
-        if (anchorMapItem) {
-            cJSON* anchor = nullptr;
-            cJSON_ArrayForEach(anchor, anchorMapItem) {
-                if (anchor->string) {
-                    cJSON* sectionItem = cJSON_GetObjectItem(anchor, "section");
-                    cJSON* pageItem = cJSON_GetObjectItem(anchor, "page");
-                    if (sectionItem && pageItem) {
-                        book.anchorMap[anchor->string] = 
-                            std::make_pair(sectionItem->valueint, pageItem->valueint);
-                    }
-                }
-            }
-            mclog::tagInfo(getAppInfo().name, "Loaded {} anchors for book {}", 
-                          book.anchorMap.size(), bookId);
-        }
-        
-        // 读取章节信息
-        cJSON* sectionsArray = cJSON_GetObjectItem(json, "sections");
-        if (sectionsArray) {
-            int sectionCount = cJSON_GetArraySize(sectionsArray);
-            for (int i = 0; i < sectionCount; i++) {
-                cJSON* section = cJSON_GetArrayItem(sectionsArray, i);
-                SectionInfo info;
-                info.index = cJSON_GetObjectItem(section, "index")->valueint;
-                info.title = cJSON_GetObjectItem(section, "title")->valuestring;
-                info.pageCount = cJSON_GetObjectItem(section, "pageCount")->valueint;
-                book.sections.push_back(info);
-                
-                mclog::tagInfo(getAppInfo().name, 
-                              "Loaded section: index={}, title={}, pageCount={}", 
-                              info.index, info.title, info.pageCount);
-            }
-        }
-        
-        cJSON_Delete(json);
-        
-        // 读取阅读进度
-        std::string statusPath = bookPath + "/reading_status.json";
-        f = fopen(statusPath.c_str(), "r");
-        if (f) {
-            fseek(f, 0, SEEK_END);
-            size = ftell(f);
-            fseek(f, 0, SEEK_SET);
-            
-            buffer = (char*)malloc(size + 1);
-            fread(buffer, 1, size, f);
-            buffer[size] = '\0';
-            fclose(f);
-            
-            cJSON* statusJson = cJSON_Parse(buffer);
-            free(buffer);
-            
-            if (statusJson) {
-                cJSON* secItem = cJSON_GetObjectItem(statusJson, "currentSection");
-                cJSON* pageItem = cJSON_GetObjectItem(statusJson, "currentPage");
-                cJSON* timeItem = cJSON_GetObjectItem(statusJson, "lastReadTime");
-                
-                book.currentSection = secItem ? secItem->valueint : 1;
-                book.currentPage = pageItem ? pageItem->valueint : 1;
-                book.lastReadTime = timeItem ? timeItem->valuestring : "";
-                
-                cJSON_Delete(statusJson);
-            }
-        } else {
-            book.currentSection = 1;
-            book.currentPage = 1;
-            book.lastReadTime = "";
-        }
-        
-        // 加载封面（支持 cover.png 和 COVER.png）
-        std::string coverPath = bookPath + "/cover.png";
-        f = fopen(coverPath.c_str(), "rb");
-        if (!f) {
-            coverPath = bookPath + "/COVER.png";
-            f = fopen(coverPath.c_str(), "rb");
-        }
-        if (f) {
-            fseek(f, 0, SEEK_END);
-            book.coverSize = ftell(f);
-            fseek(f, 0, SEEK_SET);
-            
-            book.coverData = (uint8_t*)malloc(book.coverSize);
-            fread(book.coverData, 1, book.coverSize, f);
-            fclose(f);
-        }
-        
-        _books.push_back(std::move(book));
-    }
-    
-    closedir(dir);
-    
-    // 按最后阅读时间排序（最近的在前）
-    std::sort(_books.begin(), _books.end(), [](const BookInfo& a, const BookInfo& b) {
-        return a.lastReadTime > b.lastReadTime;
-    });
+    book::ArenaStats stats = _arena.stats();
+    mclog::tagInfo(getAppInfo().name,
+                   "Arena ({}): {} KB held, peak {} KB, reserved peak {} KB, {} allocations, {} failed, "
+                   "{} bad frees, {} blocks / {} KB leaked",
+                   when, stats.current / 1024, stats.peak / 1024, stats.reservedPeak / 1024, stats.allocations,
+                   stats.failures, stats.badFrees, stats.leakedBlocks, stats.leakedBytes / 1024);
 }
 
 void AppBookshelf::drawBookList()
@@ -273,6 +200,16 @@ void AppBookshelf::drawBookList()
     GetHAL().display.setTextDatum(middle_center);
     GetHAL().display.drawString("返回", _back_btn_x + _back_btn_w / 2, _back_btn_y + _back_btn_h / 2);
     
+    // 搜索按钮
+    _search_btn_x = _back_btn_x - 100;
+    _search_btn_y = _back_btn_y;
+    _search_btn_w = _back_btn_w;
+    _search_btn_h = _back_btn_h;
+    if (!_books.empty()) {
+        GetHAL().display.fillRoundRect(_search_btn_x, _search_btn_y, _search_btn_w, _search_btn_h, 10, COLOR_BTN);
+        GetHAL().display.drawString("搜索", _search_btn_x + _search_btn_w / 2, _search_btn_y + _search_btn_h / 2);
+    }
+    
     // 分隔线
     GetHAL().display.drawLine(0, LIST_HEADER_HEIGHT, SCREEN_WIDTH, LIST_HEADER_HEIGHT, COLOR_BORDER);
     
@@ -292,6 +229,7 @@ void AppBookshelf::drawBookList()
         int bookIdx = startIdx + i;
         if (bookIdx >= (int)_books.size()) break;
         
+        BookLibrary::getInstance().revalidate(bookIdx);
         drawBookItem(bookIdx, y);
         y += LIST_ITEM_HEIGHT + LIST_PADDING;
     }
@@ -343,10 +281,12 @@ void AppBookshelf::drawBookItem(int index, int y)
     int coverX = LIST_PADDING + 10;
     int coverY = y + (LIST_ITEM_HEIGHT - COVER_SIZE) / 2;
     
-    if (book.coverData && book.coverSize > 0) {
+    const uint8_t* coverData = nullptr;
+    size_t coverSize = 0;
+    if (BookLibrary::getInstance().cover(index, coverData, coverSize)) {
         // 封面是 540×540，缩放到 160×160
         // scale = 160.0 / 540.0 = 0.296
-        GetHAL().display.drawPng(book.coverData, book.coverSize, coverX, coverY, 0, 0, 0, 0, 160.0f / 540.0f, 0.0f);
+        GetHAL().display.drawPng(coverData, coverSize, coverX, coverY, 0, 0, 0, 0, 160.0f / 540.0f, 0.0f);
     } else {
         GetHAL().display.fillRect(coverX, coverY, COVER_SIZE, COVER_SIZE, COLOR_BTN);
         GetHAL().display.setFont(&fonts::efontCN_16_b);
@@ -383,7 +323,12 @@ void AppBookshelf::drawBookItem(int index, int y)
     }
     
     char progressStr[64];
-    if (totalPages > 0) {
+    if (book.txt) {
+        // 纯文本书籍按字节位置估算
+        totalPages = book.txtSize > 0 ? 1000 : 0;
+        currentGlobal = book.txtSize > 0 ? (int)((uint64_t)book.txtOffset * 1000 / book.txtSize) : 0;
+        snprintf(progressStr, sizeof(progressStr), "进度: %d%% (TXT)", currentGlobal / 10);
+    } else if (totalPages > 0) {
         int percent = currentGlobal * 100 / totalPages;
         snprintf(progressStr, sizeof(progressStr), "进度: %d%% (%d/%d页)", percent, currentGlobal, totalPages);
     } else {
@@ -419,6 +364,16 @@ void AppBookshelf::handleListTouch()
         return;
     }
     
+    // 搜索
+    if (!_books.empty() &&
+        x >= _search_btn_x && x < _search_btn_x + _search_btn_w &&
+        y >= _search_btn_y && y < _search_btn_y + _search_btn_h) {
+        _search.enterTitleSearch();
+        _state = STATE_SEARCH;
+        _need_redraw = true;
+        return;
+    }
+    
     // 上一页
     if (_list_page > 0 &&
         x >= _prev_list_x && x < _prev_list_x + _prev_list_w &&
@@ -462,6 +417,27 @@ void AppBookshelf::openBook(int bookIndex)
     _selected_book = bookIndex;
     BookInfo& book = _books[bookIndex];
     
+    openInkStore();
+    
+    if (book.txt) {
+        mclog::tagInfo(getAppInfo().name, "Opening text book: {} (offset {})", book.title, book.txtOffset);
+        _reading_section = 0;
+        _reading_page = 1;
+        _back_section = -1;
+        _back_page = -1;
+        
+        // 读取编码和已有的分页索引，未完成的部分在后台继续
+        _text.open(book);
+        loadPage();
+        
+        _state = STATE_READING;
+        _show_toc = false;
+        _dict.hide();
+        _page_flip_count = 0;
+        _need_redraw = true;
+        return;
+    }
+    
     mclog::tagInfo(getAppInfo().name, "Opening book: {} (section {}, page {})", 
                    book.title, book.currentSection, book.currentPage);
     
@@ -490,11 +466,28 @@ void AppBookshelf::openBook(int bookIndex)
         _reading_page = 1;
     }
     
+    // 后缓冲属于上一本书
+    _back_section = -1;
+    _back_page = -1;
+    
+    // 条带布局从保存的纵向偏移继续
+    _strip_reader.close();
+    _strip_section = -1;
+    _scroll_y = book.strips ? book.currentOffsetY : 0;
+    
     // 加载当前页面
     loadPage();
     
+    // 缩略图集在后台补齐，已完成的书不会启动任务
+    _thumbs.start(_books[_selected_book]);
+    
+    // 有文字层的书在后台生成全文索引，已有有效索引时不启动任务
+    closeFulltext();
+    _search.startIndexJob(_selected_book);
+    
     _state = STATE_READING;
     _show_toc = false;
+    _dict.hide();
     _page_flip_count = 0;  // 重置翻页计数
     _need_redraw = true;
 }
@@ -506,34 +499,92 @@ void AppBookshelf::loadPage()
     if (_selected_book < 0) return;
     const BookInfo& book = _books[_selected_book];
     
+    if (book.txt) {
+        loadTextPage();
+        return;
+    }
+    
+    if (book.strips) {
+        loadStripViewport();
+        return;
+    }
+    
     mclog::tagInfo(getAppInfo().name, "drawReadingPage: section={}, page={}", 
                    _reading_section, _reading_page);
     
-    // 构建页面文件路径: /sdcard/books/{id}/sections/{section:03d}/{page:03d}.png
+    // 预读命中：后缓冲里已经是这一页，交换后直接推送，不再读卡解码
+    if (_back_section == _reading_section && _back_page == _reading_page) {
+        std::swap(_frame_buffer, _back_buffer);
+        _back_section = -1;
+        _back_page = -1;
+        _frame_ready = true;
+        loadPageLinks();
+        return;
+    }
+    
+    _page_corrupt = false;
+    if (!readPageFile(_reading_section, _reading_page, _page_image, _page_image_size)) {
+        mclog::tagError(getAppInfo().name, "Failed to open page file");
+        return;
+    }
+    
+    mclog::tagInfo(getAppInfo().name, "Page loaded, size: {} bytes", _page_image_size);
+    
+    if (book.tiles && !_tile_view.parse(_page_image, _page_image_size)) {
+        mclog::tagError(getAppInfo().name, "Invalid tiled page");
+    }
+    
+    // 加载当前页面的链接信息
+    loadPageLinks();
+}
+
+bool AppBookshelf::readPageFile(int section, int page, uint8_t*& data, size_t& size)
+{
+    const BookInfo& book = _books[_selected_book];
+    
+    // 构建页面文件路径: /sdcard/books/{id}/sections/{section:03d}/{page:03d}.png（分块页面为 .tpg，行带页面为 .bnd）
+    const char* extension = ".png";
+    if (book.tiles) {
+        extension = book::TILE_PAGE_EXTENSION;
+    } else if (book.bands) {
+        extension = book::BAND_PAGE_EXTENSION;
+    }
     char path[256];
-    snprintf(path, sizeof(path), "/sdcard/books/%s/sections/%03d/%03d.png",
-             book.id.c_str(), _reading_section, _reading_page);
+    snprintf(path, sizeof(path), "/sdcard/books/%s/sections/%03d/%03d%s",
+             book.id.c_str(), section, page, extension);
     
     mclog::tagInfo(getAppInfo().name, "Loading page: {}", path);
     
     FILE* f = fopen(path, "rb");
     if (!f) {
-        mclog::tagError(getAppInfo().name, "Failed to open page file");
-        return;
+        return false;
     }
     
     fseek(f, 0, SEEK_END);
-    _page_image_size = ftell(f);
+    size = ftell(f);
     fseek(f, 0, SEEK_SET);
     
-    _page_image = (uint8_t*)malloc(_page_image_size);
-    fread(_page_image, 1, _page_image_size, f);
+    data = (uint8_t*)_arena.alloc(size);
+    if (!data || fread(data, 1, size, f) != size) {
+        _arena.free(data);
+        data = nullptr;
+        size = 0;
+        fclose(f);
+        return false;
+    }
     fclose(f);
     
-    mclog::tagInfo(getAppInfo().name, "Page loaded, size: {} bytes", _page_image_size);
-    
-    // 加载当前页面的链接信息
-    loadPageLinks();
+    // 抽样校验：内容与上传时记录的 CRC32C 不符时按读取失败处理，不把坏数据交给解码器
+    if (_page_verifier.verify(path, data, size) == book::VerifyResult::Corrupt) {
+        mclog::tagError(getAppInfo().name, "Page checksum mismatch: {} ({} of {} checked pages)", path,
+                        _page_verifier.corrupt(), _page_verifier.checked());
+        _page_corrupt = true;
+        _arena.free(data);
+        data = nullptr;
+        size = 0;
+        return false;
+    }
+    return true;
 }
 
 void AppBookshelf::drawReading(bool fastMode)
@@ -552,21 +603,74 @@ void AppBookshelf::drawReading(bool fastMode)
         // 全刷新模式（每8页一次）
         GetHAL().display.setEpdMode(epd_mode_t::epd_quality);  // 全刷新用高质量模式
     }
-    GetHAL().display.fillScreen(COLOR_BG);
+    // 分块页面快速翻页时不清屏，只重绘与屏幕上不同的块，EPD 只刷新被写入的区域
+    bool tiled = isTiledBook() && _tile_view.tileCount() > 0;
+    if (!fastMode || !tiled || _screen_tiles.size() != (size_t)_tile_view.tileCount()) {
+        GetHAL().display.fillScreen(COLOR_BG);
+        _screen_tiles.clear();
+    }
     
     // 喂狗，防止解码超时
     GetHAL().feedTheDog();
     
-    if (!_page_image || _page_image_size == 0) {
+    if (isTextBook()) {
+        if (!_text.draw()) {
+            GetHAL().display.setFont(&fonts::efontCN_24_b);
+            GetHAL().display.setTextDatum(middle_center);
+            GetHAL().display.setTextColor(COLOR_TEXT);
+            GetHAL().display.drawString("加载失败", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+            return;
+        }
+    } else if (isStripBook()) {
+        if (!drawStripViewport()) {
+            GetHAL().display.setFont(&fonts::efontCN_24_b);
+            GetHAL().display.setTextDatum(middle_center);
+            GetHAL().display.setTextColor(COLOR_TEXT);
+            GetHAL().display.drawString("加载失败", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+            return;
+        }
+    } else if (tiled) {
+        if (!drawTiledPage()) {
+            _screen_tiles.clear();
+            GetHAL().display.fillRect(0, 0, SCREEN_WIDTH, PAGE_CONTENT_HEIGHT, COLOR_BG);
+            GetHAL().display.setFont(&fonts::efontCN_24_b);
+            GetHAL().display.setTextDatum(middle_center);
+            GetHAL().display.setTextColor(COLOR_TEXT);
+            GetHAL().display.drawString("加载失败", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+            return;
+        }
+    } else if (_frame_ready) {
+        // 预读命中：页面已在帧缓冲中，关键路径上只剩推送
+        pushFrameBuffer();
+    } else if (!_page_image || _page_image_size == 0) {
         GetHAL().display.setFont(&fonts::efontCN_24_b);
         GetHAL().display.setTextDatum(middle_center);
         GetHAL().display.setTextColor(COLOR_TEXT);
-        GetHAL().display.drawString("加载失败", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+        GetHAL().display.drawString(_page_corrupt ? "页面已损坏，请重新传输" : "加载失败", SCREEN_WIDTH / 2,
+                                    SCREEN_HEIGHT / 2);
         return;
+    } else if (isBandedBook()) {
+        if (!drawBandedPage()) {
+            GetHAL().display.setFont(&fonts::efontCN_24_b);
+            GetHAL().display.setTextDatum(middle_center);
+            GetHAL().display.setTextColor(COLOR_TEXT);
+            GetHAL().display.drawString("加载失败", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+            return;
+        }
+    } else {
+        // 绘制页面图片（540x900，显示在顶部）
+        // 灰度 PNG 走快速路径，其余格式（RGB、调色板、Alpha）回退到 drawPng
+        uint32_t start = GetHAL().millis();
+        bool fastPath  = drawPageImageFast();
+        if (!fastPath) {
+            GetHAL().display.drawPng(_page_image, _page_image_size, 0, 0);
+        }
+        mclog::tagInfo(getAppInfo().name, "Page decoded in {} ms ({})", GetHAL().millis() - start,
+                       fastPath ? "gray fast path" : "drawPng");
     }
     
-    // 绘制页面图片（540x900，显示在顶部）
-    GetHAL().display.drawPng(_page_image, _page_image_size, 0, 0);
+    // 批注笔迹盖在页面上
+    _ink.draw(inkPageKey());
     
     // 喂狗
     GetHAL().feedTheDog();
@@ -577,10 +681,307 @@ void AppBookshelf::drawReading(bool fastMode)
     // 绘制链接指示器（如果有链接）
     drawLinkIndicators();
     
+    // 从全文检索结果跳转来的页面标出命中
+    drawHighlights();
+    
+    // 词典释义浮层
+    if (_dict.visible()) {
+        _dict.draw();
+    }
+    
     // 绘制目录（如果显示）
     if (_show_toc) {
         drawTOC();
+        _screen_tiles.clear();
+    }
+    
+    // 推送完成后面板在后台刷新，主循环趁这段时间预读下一页
+    _read_ahead_pending = true;
+}
+
+bool AppBookshelf::drawPageImageFast()
+{
+    book::GrayPngInfo info;
+    if (!book::gray_png_probe(_page_image, _page_image_size, info) || info.width != SCREEN_WIDTH ||
+        info.height > PAGE_CONTENT_HEIGHT) {
+        return false;
+    }
+
+    // 打包行在解码器内展开为 8-bit 灰度（16 级即 0x00, 0x11 … 0xFF），
+    // 攒够一个条带后直接推送，省去 drawPng 的通用像素格式转换
+    bool ok = false;
+    {
+        GrayBandWriter writer(_arena, info.width, 0);
+        if (!writer.valid()) {
+            return false;
+        }
+        ok = book::decode_gray_png(_page_image, _page_image_size, [&](int y, const uint8_t* gray, int width) {
+            writer.push(gray);
+            return true;
+        });
+    }
+
+    if (!ok) {
+        // 数据损坏：已推送的条带会被 drawPng 覆盖
+        mclog::tagWarn(getAppInfo().name, "Gray PNG fast path failed, fallback to drawPng");
+        GetHAL().display.fillRect(0, 0, SCREEN_WIDTH, PAGE_CONTENT_HEIGHT, COLOR_BG);
+    }
+    return ok;
+}
+
+bool AppBookshelf::drawTiledPage()
+{
+    const int count = _tile_view.tileCount();
+    if (_tile_view.width() != SCREEN_WIDTH || _tile_view.height() > PAGE_CONTENT_HEIGHT) {
+        return false;
+    }
+    
+    // 刚清过屏时屏幕上全是空白块
+    if (_screen_tiles.size() != (size_t)count) {
+        _screen_tiles.assign(count, book::TILE_HASH_BLANK);
+    }
+    
+    uint8_t* gray = (uint8_t*)_arena.alloc(_tile_view.tileSize() * _tile_view.tileSize());
+    if (!gray) {
+        return false;
+    }
+    
+    uint32_t start = GetHAL().millis();
+    int drawn      = 0;
+    bool ok        = true;
+    auto& lcd      = GetHAL().display;
+    lcd.startWrite();
+    for (int tile = 0; tile < count; tile++) {
+        uint32_t hash = _tile_view.hash(tile);
+        if (_screen_tiles[tile] == hash) continue;
+        
+        int x, y, w, h;
+        _tile_view.tileRect(tile, x, y, w, h);
+        if (hash == book::TILE_HASH_BLANK) {
+            lcd.fillRect(x, y, w, h, COLOR_BG);
+        } else if (_tile_view.decodeTile(tile, gray)) {
+            lcd.pushGrayscaleImage(x, y, w, h, gray, lgfx::grayscale_8bit, COLOR_BG, COLOR_TEXT);
+        } else {
+            ok = false;
+            break;
+        }
+        _screen_tiles[tile] = hash;
+        drawn++;
+    }
+    lcd.endWrite();
+    _arena.free(gray);
+    
+    mclog::tagInfo(getAppInfo().name, "Tiled page: {} of {} tiles redrawn in {} ms", drawn, count,
+                   GetHAL().millis() - start);
+    return ok;
+}
+
+bool AppBookshelf::drawBandedPage()
+{
+    if (!allocFrameBuffers()) {
+        return false;
+    }
+    if (_band_decoder.workers() < 2) {
+        _band_decoder.start(2);
+    }
+    
+    // 调用方和另一核心上的工作任务各自领取行带，屏障返回后整页已在帧缓冲中
+    uint32_t start = GetHAL().millis();
+    book::StripFileHeader info;
+    if (!_band_decoder.decode(_page_image, _page_image_size, _frame_buffer, SCREEN_WIDTH * PAGE_CONTENT_HEIGHT,
+                              &info) ||
+        info.width != SCREEN_WIDTH) {
+        mclog::tagError(getAppInfo().name, "Banded page decode failed");
+        return false;
+    }
+    uint32_t decoded = GetHAL().millis();
+    pushFrameBuffer();
+    _frame_ready = true;  // 重绘（关闭目录等）时直接推送
+    
+    const auto& bands = _band_decoder.bandsPerWorker();
+    mclog::tagInfo(getAppInfo().name, "Banded page: {} bands decoded in {} ms ({} + {} per core), pushed in {} ms",
+                   info.stripCount, decoded - start, bands[0], bands.size() > 1 ? bands[1] : 0,
+                   GetHAL().millis() - decoded);
+    return true;
+}
+
+bool AppBookshelf::allocFrameBuffers()
+{
+    // 各 486KB，在 PSRAM
+    if (!_frame_buffer) {
+        _frame_buffer = (uint8_t*)_arena.alloc(SCREEN_WIDTH * PAGE_CONTENT_HEIGHT);
+    }
+    if (!_back_buffer) {
+        _back_buffer = (uint8_t*)_arena.alloc(SCREEN_WIDTH * PAGE_CONTENT_HEIGHT);
+    }
+    if (!_frame_buffer || !_back_buffer) {
+        mclog::tagError(getAppInfo().name, "Failed to allocate frame buffers");
+        return false;
+    }
+    return true;
+}
+
+void AppBookshelf::freeFrameBuffers()
+{
+    _arena.free(_frame_buffer);
+    _arena.free(_back_buffer);
+    _frame_buffer = nullptr;
+    _back_buffer = nullptr;
+    _back_section = -1;
+    _back_page = -1;
+    _frame_ready = false;
+}
+
+void AppBookshelf::pushFrameBuffer()
+{
+    auto& lcd = GetHAL().display;
+    lcd.startWrite();
+    lcd.pushGrayscaleImage(0, 0, SCREEN_WIDTH, PAGE_CONTENT_HEIGHT, _frame_buffer, lgfx::grayscale_8bit, COLOR_BG,
+                           COLOR_TEXT);
+    lcd.endWrite();
+}
+
+bool AppBookshelf::decodePageTo(const uint8_t* data, size_t size, uint8_t* frame)
+{
+    const size_t frameSize = SCREEN_WIDTH * PAGE_CONTENT_HEIGHT;
+    
+    if (isBandedBook()) {
+        if (_band_decoder.workers() < 2) {
+            _band_decoder.start(2);
+        }
+        book::StripFileHeader info;
+        if (!_band_decoder.decode(data, size, frame, frameSize, &info) || info.width != SCREEN_WIDTH) {
+            return false;
+        }
+        memset(frame + info.width * info.height, 0xFF, frameSize - info.width * info.height);
+        return true;
     }
+    
+    book::GrayPngInfo info;
+    if (!book::gray_png_probe(data, size, info) || info.width != SCREEN_WIDTH || info.height > PAGE_CONTENT_HEIGHT) {
+        return false;
+    }
+    bool ok = book::decode_gray_png(data, size, [&](int y, const uint8_t* gray, int width) {
+        memcpy(frame + y * width, gray, width);
+        return true;
+    });
+    if (ok) {
+        memset(frame + info.width * info.height, 0xFF, frameSize - info.width * info.height);
+    }
+    return ok;
+}
+
+void AppBookshelf::prepareNextFrame()
+{
+    // 分块页面按差异推送、条带布局按视口拼接、纯文本直接绘制文字，都不经过整页帧缓冲
+    if (_selected_book < 0 || isStripBook() || isTiledBook() || isTextBook()) return;
+    
+    int section = _reading_section;
+    int page = _reading_page;
+    if (!adjacentPage(_flip_direction, section, page)) return;
+    if (section == _back_section && page == _back_page) return;
+    if (!allocFrameBuffers()) return;
+    
+    uint32_t start = GetHAL().millis();
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    _back_section = -1;
+    _back_page = -1;
+    if (!readPageFile(section, page, data, size)) return;
+    
+    bool ok = decodePageTo(data, size, _back_buffer);
+    _arena.free(data);
+    if (!ok) {
+        // 非灰度 PNG 等只能由 drawPng 直接绘制，不预读
+        return;
+    }
+    
+    _back_section = section;
+    _back_page = page;
+    mclog::tagInfo(getAppInfo().name, "Read-ahead: section {} page {} ready in {} ms", section, page,
+                   GetHAL().millis() - start);
+}
+
+bool AppBookshelf::adjacentPage(int direction, int& section, int& page) const
+{
+    const BookInfo& book = _books[_selected_book];
+    
+    if (direction > 0) {
+        for (const auto& sec : book.sections) {
+            if (sec.index == section) {
+                if (page < sec.pageCount) {
+                    page++;
+                    return true;
+                }
+                break;
+            }
+        }
+        for (const auto& sec : book.sections) {
+            if (sec.index > section) {
+                section = sec.index;
+                page = 1;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    if (page > 1) {
+        page--;
+        return true;
+    }
+    for (int i = book.sections.size() - 1; i >= 0; i--) {
+        if (book.sections[i].index < section) {
+            section = book.sections[i].index;
+            page = book.sections[i].pageCount;
+            return true;
+        }
+    }
+    return false;
+}
+
+void AppBookshelf::invalidateScreenTiles(int x, int y, int w, int h)
+{
+    if (_screen_tiles.empty() || _tile_view.tileCount() == 0) return;
+    
+    const int size = _tile_view.tileSize();
+    const int cols = _tile_view.cols();
+    const int rows = _tile_view.rows();
+    int col0 = std::max(0, x / size);
+    int col1 = std::min(cols - 1, (x + w - 1) / size);
+    int row0 = std::max(0, y / size);
+    int row1 = std::min(rows - 1, (y + h - 1) / size);
+    for (int row = row0; row <= row1; row++) {
+        for (int col = col0; col <= col1; col++) {
+            _screen_tiles[row * cols + col] = book::TILE_HASH_INVALID;
+        }
+    }
+}
+
+bool AppBookshelf::drawStripViewport()
+{
+    if (!_strip_reader.isOpen() || _strip_reader.width() != SCREEN_WIDTH) {
+        return false;
+    }
+
+    // 视口由缓存的条带拼接，只有新露出的条带需要读卡解码
+    uint32_t start         = GetHAL().millis();
+    uint32_t decodedBefore = _strip_reader.stripsDecoded();
+    bool ok                = false;
+    {
+        GrayBandWriter writer(_arena, SCREEN_WIDTH, 0);
+        if (!writer.valid()) {
+            return false;
+        }
+        ok = _strip_reader.composeRows(_scroll_y, PAGE_CONTENT_HEIGHT, [&](int y, const uint8_t* gray, int width) {
+            writer.push(gray);
+            return true;
+        });
+    }
+
+    mclog::tagInfo(getAppInfo().name, "Viewport y={} drawn in {} ms, {} new strips decoded", _scroll_y,
+                   GetHAL().millis() - start, _strip_reader.stripsDecoded() - decodedBefore);
+    return ok;
 }
 
 void AppBookshelf::drawBottomBar()
@@ -590,7 +991,7 @@ void AppBookshelf::drawBottomBar()
     GetHAL().display.fillRect(0, barY, SCREEN_WIDTH, UI_HEIGHT, COLOR_BG);
     GetHAL().display.drawLine(0, barY, SCREEN_WIDTH, barY, COLOR_BORDER);
     
-    // 按钮布局：目录 | 进度信息 | 返回
+    // 按钮布局：目录 | 进度信息 | 批注 | 返回
     int btnW = 80;
     int btnH = 40;
     int btnY = barY + (UI_HEIGHT - btnH) / 2;
@@ -599,11 +1000,23 @@ void AppBookshelf::drawBottomBar()
     GetHAL().display.setTextDatum(middle_center);
     GetHAL().display.setTextColor(COLOR_TEXT);
     
-    // 目录按钮（左侧）
+    // 目录按钮（左侧，没有章节表的 .txt 不显示）；批注模式中为撤销
     int btnX = 10;
-    GetHAL().display.fillRoundRect(btnX, btnY, btnW, btnH, 6, COLOR_BTN);
-    GetHAL().display.drawRoundRect(btnX, btnY, btnW, btnH, 6, COLOR_BORDER);
-    GetHAL().display.drawString("目录", btnX + btnW / 2, btnY + btnH / 2);
+    if (_ink.active() || hasTableOfContents()) {
+        GetHAL().display.fillRoundRect(btnX, btnY, btnW, btnH, 6, COLOR_BTN);
+        GetHAL().display.drawRoundRect(btnX, btnY, btnW, btnH, 6, COLOR_BORDER);
+        GetHAL().display.drawString(_ink.active() ? "撤销" : "目录", btnX + btnW / 2, btnY + btnH / 2);
+    }
+    
+    // 批注开关，批注模式中反色显示
+    if (inkAvailable()) {
+        btnX = INK_BTN_X;
+        GetHAL().display.fillRoundRect(btnX, btnY, btnW, btnH, 6, _ink.active() ? COLOR_TEXT : COLOR_BTN);
+        GetHAL().display.drawRoundRect(btnX, btnY, btnW, btnH, 6, _ink.active() ? COLOR_TEXT : COLOR_BORDER);
+        GetHAL().display.setTextColor(_ink.active() ? COLOR_BG : COLOR_TEXT);
+        GetHAL().display.drawString(_ink.active() ? "完成" : "批注", btnX + btnW / 2, btnY + btnH / 2);
+        GetHAL().display.setTextColor(COLOR_TEXT);
+    }
     
     // 返回按钮（右侧）
     btnX = SCREEN_WIDTH - btnW - 10;
@@ -616,7 +1029,19 @@ void AppBookshelf::drawBottomBar()
     int currentGlobal = getCurrentGlobalPage();
     
     char info[64];
-    if (_selected_book >= 0 && _reading_section > 0 && 
+    if (isTextBook()) {
+        // 分页完成前总页数只是下限
+        const BookInfo& book = _books[_selected_book];
+        int knownPages = 0;
+        bool complete = false;
+        int page = _text.pageNumber(knownPages, complete);
+        int percent = book.txtSize > 0 ? (int)((uint64_t)_text.offset() * 100 / book.txtSize) : 0;
+        if (page > 0) {
+            snprintf(info, sizeof(info), complete ? "%d/%d页 · %d%%" : "%d/≥%d页 · %d%%", page, knownPages, percent);
+        } else {
+            snprintf(info, sizeof(info), "?/≥%d页 · %d%%", knownPages, percent);
+        }
+    } else if (_selected_book >= 0 && _reading_section > 0 && 
         _reading_section <= (int)_books[_selected_book].sections.size()) {
         snprintf(info, sizeof(info), "%d/%d页 · %d%%", 
                  currentGlobal, totalPages,
@@ -628,6 +1053,22 @@ void AppBookshelf::drawBottomBar()
     GetHAL().display.drawString(info, SCREEN_WIDTH / 2, barY + UI_HEIGHT / 2);
 }
 
+bool AppBookshelf::hasTableOfContents() const
+{
+    return !isTextBook() || !_books[_selected_book].sections.empty();
+}
+
+int AppBookshelf::tocFirstItem() const
+{
+    // 目录一屏 10 项，章节多时让当前章节出现在列表中
+    const auto& sections = _books[_selected_book].sections;
+    int current = 0;
+    for (size_t i = 0; i < sections.size(); i++) {
+        if (sections[i].index == _reading_section) current = (int)i;
+    }
+    return std::max(0, std::min(current - 4, (int)sections.size() - 10));
+}
+
 void AppBookshelf::drawTOC()
 {
     if (_selected_book < 0) return;
@@ -648,6 +1089,14 @@ void AppBookshelf::drawTOC()
     GetHAL().display.setTextColor(COLOR_TEXT);
     GetHAL().display.drawString("目录", tocX + tocW / 2, tocY + 30);
     
+    // 有文字层的书：右上角为全文搜索入口
+    if (book.textLayer) {
+        GetHAL().display.setFont(&fonts::efontCN_16_b);
+        GetHAL().display.fillRoundRect(tocX + tocW - 100, tocY + 10, 80, 40, 6, COLOR_BTN);
+        GetHAL().display.drawRoundRect(tocX + tocW - 100, tocY + 10, 80, 40, 6, COLOR_BORDER);
+        GetHAL().display.drawString("搜索", tocX + tocW - 60, tocY + 30);
+    }
+    
     GetHAL().display.drawLine(tocX + 20, tocY + 55, tocX + tocW - 20, tocY + 55, COLOR_BORDER);
     
     // 章节列表（最多显示10个）
@@ -656,10 +1105,11 @@ void AppBookshelf::drawTOC()
     
     int itemY = tocY + 70;
     int itemH = 45;
-    int maxItems = std::min((int)book.sections.size(), 10);
+    int firstItem = tocFirstItem();
+    int maxItems = std::min((int)book.sections.size() - firstItem, 10);
     
     for (int i = 0; i < maxItems; i++) {
-        const SectionInfo& sec = book.sections[i];
+        const SectionInfo& sec = book.sections[firstItem + i];
         
         // 高亮当前章节
         if (sec.index == _reading_section) {
@@ -667,8 +1117,13 @@ void AppBookshelf::drawTOC()
         }
         
         // 显示章节标题
-        char title[128];
-        snprintf(title, sizeof(title), "%d. %s (%d页)", sec.index, sec.title.c_str(), sec.pageCount);
+        // 纯文本书籍的章节没有固定页数
+        char title[160];
+        if (book.txt) {
+            snprintf(title, sizeof(title), "%d. %s", sec.index + 1, sec.title.c_str());
+        } else {
+            snprintf(title, sizeof(title), "%d. %s (%d页)", sec.index, sec.title.c_str(), sec.pageCount);
+        }
         GetHAL().display.setTextColor(sec.index == _reading_section ? COLOR_TEXT : COLOR_TEXT_GRAY);
         GetHAL().display.drawString(title, tocX + 20, itemY + 10);
         
@@ -685,11 +1140,44 @@ void AppBookshelf::drawTOC()
 void AppBookshelf::handleReadingTouch()
 {
     auto touch = GetHAL().getTouchDetail();
+    
+    // 按住底部进度区域左右拖动，预览缩略图，松手跳转（纯文本书籍没有缩略图集）
+    if (!_show_toc && !_dict.visible() && !_ink.active() && !isTextBook() && handleScrubTouch(touch)) {
+        return;
+    }
+    
+    // 批注模式：内容区的触摸都用来书写
+    if (_ink.active() && _ink.handleTouch(touch, inkPageKey())) {
+        return;
+    }
+    
+    // 条带布局：纵向滑动滚动半页（上滑前进，下滑后退）
+    if (touch.wasFlicked() && isStripBook() && !_show_toc) {
+        int dy = touch.distanceY();
+        if (abs(dy) > abs(touch.distanceX())) {
+            scrollBy(dy < 0 ? STRIP_SCROLL_HALF : -STRIP_SCROLL_HALF);
+        }
+        return;
+    }
+    
+    // 长按正文取词，查离线词典
+    if (touch.wasHold() && !_show_toc && touch.y < PAGE_CONTENT_HEIGHT) {
+        lookupAt(touch.x, touch.y);
+        return;
+    }
+    
     if (!touch.wasClicked()) return;
     
     int x = touch.x;
     int y = touch.y;
     
+    // 释义浮层显示时，点击任意位置关闭
+    if (_dict.visible()) {
+        _dict.hide();
+        _need_redraw = true;
+        return;
+    }
+    
     // 显示目录时，点击章节或关闭
     if (_show_toc) {
         const BookInfo& book = _books[_selected_book];
@@ -699,13 +1187,20 @@ void AppBookshelf::handleReadingTouch()
         int tocW = SCREEN_WIDTH - 80;
         int itemY = tocY + 70;
         int itemH = 45;
-        int maxItems = std::min((int)book.sections.size(), 10);
+        int firstItem = tocFirstItem();
+        int maxItems = std::min((int)book.sections.size() - firstItem, 10);
+        
+        // 全文搜索
+        if (book.textLayer && x >= tocX + tocW - 100 && x < tocX + tocW - 20 && y >= tocY + 10 && y < tocY + 50) {
+            enterFulltextSearch();
+            return;
+        }
         
         // 检查是否点击了章节
         for (int i = 0; i < maxItems; i++) {
             if (x >= tocX && x < tocX + tocW &&
                 y >= itemY && y < itemY + itemH) {
-                gotoSection(book.sections[i].index);
+                gotoSection(book.sections[firstItem + i].index);
                 _show_toc = false;
                 return;
             }
@@ -726,19 +1221,38 @@ void AppBookshelf::handleReadingTouch()
     
     // 检查是否点击底部栏
     if (y >= barY) {
+        // 批注模式：左侧为撤销按钮
+        if (_ink.active() && x >= 10 && x < 10 + btnW && y >= btnY && y < btnY + btnH) {
+            undoInkStroke();
+            return;
+        }
+        
         // 目录按钮（左侧）
-        if (x >= 10 && x < 10 + btnW && y >= btnY && y < btnY + btnH) {
+        if (!_ink.active() && hasTableOfContents() && x >= 10 && x < 10 + btnW && y >= btnY && y < btnY + btnH) {
             _show_toc = true;
             _need_redraw = true;
             return;
         }
         
+        // 批注开关
+        if (inkAvailable() && x >= INK_BTN_X && x < INK_BTN_X + btnW && y >= btnY && y < btnY + btnH) {
+            setInkMode(!_ink.active());
+            return;
+        }
+        
         // 返回按钮（右侧）
         int returnBtnX = SCREEN_WIDTH - btnW - 10;
         if (x >= returnBtnX && x < returnBtnX + btnW && y >= btnY && y < btnY + btnH) {
             saveReadingProgress();
+            _thumbs.close();
+            _text.close();
+            closeFulltext();
+            _ink.close();
+            _strip_reader.close();
+            _strip_section = -1;
             _state = STATE_LIST;
             _need_redraw = true;
+            logArenaStats("close book");
             return;
         }
         
@@ -767,6 +1281,23 @@ void AppBookshelf::nextPage()
     if (_selected_book < 0) return;
     const BookInfo& book = _books[_selected_book];
     
+    if (book.txt) {
+        if (!_text.next(book)) {
+            mclog::tagInfo(getAppInfo().name, "Already at last page");
+            return;
+        }
+        _flip_direction = 1;
+        flipToCurrentPage();
+        return;
+    }
+    
+    if (book.strips) {
+        scrollBy(STRIP_SCROLL_PAGE);
+        return;
+    }
+    
+    _flip_direction = 1;
+    
     // 查找当前章节
     const SectionInfo* currentSec = nullptr;
     for (const auto& sec : book.sections) {
@@ -803,14 +1334,7 @@ void AppBookshelf::nextPage()
         }
     }
     
-    loadPage();
-    _page_flip_count++;
-    
-    // 根据翻页次数决定刷新模式
-    bool needFullRefresh = (_page_flip_count % FULL_REFRESH_INTERVAL == 0);
-    drawReading(!needFullRefresh);  // fast模式 = !needFullRefresh
-    
-    saveReadingProgress();
+    flipToCurrentPage();
 }
 
 void AppBookshelf::prevPage()
@@ -818,6 +1342,23 @@ void AppBookshelf::prevPage()
     if (_selected_book < 0) return;
     const BookInfo& book = _books[_selected_book];
     
+    if (book.txt) {
+        if (!_text.previous()) {
+            mclog::tagInfo(getAppInfo().name, "Already at first page");
+            return;
+        }
+        _flip_direction = -1;
+        flipToCurrentPage();
+        return;
+    }
+    
+    if (book.strips) {
+        scrollBy(-STRIP_SCROLL_PAGE);
+        return;
+    }
+    
+    _flip_direction = -1;
+    
     if (_reading_page > 1) {
         // 当前章节还有上一页
         _reading_page--;
@@ -846,13 +1387,27 @@ void AppBookshelf::prevPage()
         }
     }
     
+    flipToCurrentPage();
+}
+
+void AppBookshelf::flipToCurrentPage()
+{
+    uint32_t start = GetHAL().millis();
+    
     loadPage();
+    bool hit = _frame_ready;
     _page_flip_count++;
     
     // 根据翻页次数决定刷新模式
     bool needFullRefresh = (_page_flip_count % FULL_REFRESH_INTERVAL == 0);
     drawReading(!needFullRefresh);  // fast模式 = !needFullRefresh
     
+    // 连续翻页时关注两项：本次翻页的耗时，以及距上次翻页结束的间隔（预读是否来得及完成）
+    uint32_t end = GetHAL().millis();
+    mclog::tagInfo(getAppInfo().name, "Page flip: {} ms ({}), {} ms since previous flip", end - start,
+                   hit ? "back buffer" : "decoded", _last_flip_end ? start - _last_flip_end : 0);
+    _last_flip_end = end;
+    
     saveReadingProgress();
 }
 
@@ -877,8 +1432,14 @@ void AppBookshelf::gotoSection(int sectionIndex)
     
     mclog::tagInfo(getAppInfo().name, "Goto section {}", sectionIndex);
     
+    if (book.txt) {
+        gotoTextSection(sectionIndex);
+        return;
+    }
+    
     _reading_section = sectionIndex;
     _reading_page = 1;
+    _scroll_y = 0;
     _page_flip_count = 0;  // 跳转章节重置计数，使用全刷新
     
     loadPage();
@@ -894,6 +1455,7 @@ void AppBookshelf::saveReadingProgress()
     
     book.currentSection = _reading_section;
     book.currentPage = _reading_page;
+    book.currentOffsetY = _scroll_y;
     
     // 生成时间戳
     char timeStr[64];
@@ -902,13 +1464,22 @@ void AppBookshelf::saveReadingProgress()
     strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%SZ", tm_info);
     book.lastReadTime = timeStr;
     
-    // 写入文件
-    std::string statusPath = "/sdcard/books/" + book.id + "/reading_status.json";
+    // 写入文件（纯文本书籍的进度文件与正文放在一起）
+    std::string statusPath =
+        book.txt ? book.txtPath + book::TEXT_STATUS_SUFFIX : "/sdcard/books/" + book.id + "/reading_status.json";
     
     cJSON* json = cJSON_CreateObject();
-    cJSON_AddNumberToObject(json, "currentSection", _reading_section);
-    cJSON_AddNumberToObject(json, "currentPage", _reading_page);
+    if (book.txt) {
+        book.txtOffset = _text.offset();
+        cJSON_AddNumberToObject(json, "offset", _text.offset());
+    } else {
+        cJSON_AddNumberToObject(json, "currentSection", _reading_section);
+        cJSON_AddNumberToObject(json, "currentPage", _reading_page);
+    }
     cJSON_AddStringToObject(json, "lastReadTime", timeStr);
+    if (book.strips) {
+        cJSON_AddNumberToObject(json, "offsetY", _scroll_y);
+    }
     
     char* jsonStr = cJSON_PrintUnformatted(json);
     
@@ -916,6 +1487,7 @@ void AppBookshelf::saveReadingProgress()
     if (f) {
         fputs(jsonStr, f);
         fclose(f);
+        BookLibrary::getInstance().progressSaved(_selected_book);
         mclog::tagInfo(getAppInfo().name, "Progress saved: section {}, page {}", _reading_section, _reading_page);
     }
     
@@ -953,49 +1525,482 @@ int AppBookshelf::getCurrentGlobalPage()
 }
 
 /* -------------------------------------------------------------------------- */
-/*                              链接处理功能                                  */
+/*                                进度条拖动                                  */
 /* -------------------------------------------------------------------------- */
 
-void AppBookshelf::loadPageLinks()
+bool AppBookshelf::handleScrubTouch(const m5::Touch_Class::touch_detail_t& touch)
 {
-    _current_page_links.clear();
-    _current_page_has_image = false;  // 默认无图片
+    if (_selected_book < 0) return false;
     
-    if (_selected_book < 0) return;
+    int jumpTo = -1;
+    if (!_thumbs.handleTouch(touch, _books[_selected_book], jumpTo)) return false;
+    if (jumpTo >= 0) {
+        jumpToGlobalPage(jumpTo);
+    }
+    return true;
+}
+
+void AppBookshelf::jumpToGlobalPage(int globalPage)
+{
     const BookInfo& book = _books[_selected_book];
     
-    // 构建 links.json 路径
+    for (const auto& sec : book.sections) {
+        if (globalPage >= sec.pageCount) {
+            globalPage -= sec.pageCount;
+            continue;
+        }
+        
+        mclog::tagInfo(getAppInfo().name, "Jump to section {}, page {}", sec.index, globalPage + 1);
+        _reading_section = sec.index;
+        _reading_page = globalPage + 1;
+        _scroll_y = (_reading_page - 1) * PAGE_CONTENT_HEIGHT;  // 条带布局：第几屏
+        _page_flip_count = 0;  // 跳转后全刷新，清除预览残影
+        
+        loadPage();
+        saveReadingProgress();
+        _need_redraw = true;
+        return;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          条带布局（连续滚动）                              */
+/* -------------------------------------------------------------------------- */
+
+bool AppBookshelf::isTiledBook() const
+{
+    return _selected_book >= 0 && _selected_book < (int)_books.size() && _books[_selected_book].tiles;
+}
+
+bool AppBookshelf::isBandedBook() const
+{
+    return _selected_book >= 0 && _selected_book < (int)_books.size() && _books[_selected_book].bands;
+}
+
+bool AppBookshelf::isStripBook() const
+{
+    return _selected_book >= 0 && _selected_book < (int)_books.size() && _books[_selected_book].strips;
+}
+
+int AppBookshelf::getSectionHeight(int sectionIndex)
+{
+    if (_selected_book < 0) return 0;
+    for (const auto& sec : _books[_selected_book].sections) {
+        if (sec.index == sectionIndex) {
+            return sec.height;
+        }
+    }
+    return 0;
+}
+
+void AppBookshelf::loadStripViewport()
+{
+    const BookInfo& book = _books[_selected_book];
+    
+    // 切换章节时才重新打开条带文件，同一章节内滚动复用已解码的条带
+    if (_strip_section != _reading_section || !_strip_reader.isOpen()) {
+        char path[256];
+        snprintf(path, sizeof(path), "/sdcard/books/%s/sections/%03d/%s",
+                 book.id.c_str(), _reading_section, book::STRIP_FILE_NAME);
+        
+        if (!_strip_reader.open(path, STRIP_CACHE_COUNT)) {
+            mclog::tagError(getAppInfo().name, "Failed to open strips: {}", path);
+            _strip_section = -1;
+            _current_page_links.clear();
+            return;
+        }
+        _strip_section = _reading_section;
+        loadSectionLinks();
+        
+        mclog::tagInfo(getAppInfo().name, "Strips opened: section={}, height={}, strip={}px", 
+                       _reading_section, _strip_reader.height(), _strip_reader.stripHeight());
+    }
+    
+    int maxScroll = std::max(0, _strip_reader.height() - PAGE_CONTENT_HEIGHT);
+    _scroll_y = std::max(0, std::min(_scroll_y, maxScroll));
+    
+    // 进度显示按整屏计算：视口底部所在的屏
+    int pageCount = std::max(1, (_strip_reader.height() + PAGE_CONTENT_HEIGHT - 1) / PAGE_CONTENT_HEIGHT);
+    _reading_page = std::min(pageCount, (_scroll_y + 2 * PAGE_CONTENT_HEIGHT - 1) / PAGE_CONTENT_HEIGHT);
+    
+    // 完整落在视口内的链接转换为屏幕坐标
+    _current_page_links.clear();
+    for (const auto& link : _section_links) {
+        if (link.y >= _scroll_y && link.y + link.h <= _scroll_y + PAGE_CONTENT_HEIGHT) {
+            LinkInfo visible = link;
+            visible.y -= _scroll_y;
+            _current_page_links.push_back(visible);
+        }
+    }
+    
+    _current_page_has_image = false;
+    for (const auto& image : _section_images) {
+        if (image.first < _scroll_y + PAGE_CONTENT_HEIGHT && image.second > _scroll_y) {
+            _current_page_has_image = true;
+            break;
+        }
+    }
+}
+
+void AppBookshelf::loadSectionLinks()
+{
+    _section_links.clear();
+    _section_images.clear();
+    
+    const BookInfo& book = _books[_selected_book];
     char linksPath[256];
     snprintf(linksPath, sizeof(linksPath), 
              "/sdcard/books/%s/sections/%03d/links.json",
              book.id.c_str(), _reading_section);
     
-    // 检查文件是否存在
-    FILE* f = fopen(linksPath, "r");
-    if (!f) {
-        // 文件不存在是正常的，说明这个章节没有链接
+    // 没有 links.json 说明本章没有链接；解析失败时 read_json 已记录日志
+    cJSON* json = read_json(_arena, linksPath);
+    if (!json) return;
+    
+    // 条带布局的 links.json：整章一个列表，坐标为章节长图坐标
+    cJSON* item = nullptr;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(json, "links")) {
+        LinkInfo link;
+        cJSON* text = cJSON_GetObjectItem(item, "text");
+        cJSON* href = cJSON_GetObjectItem(item, "href");
+        cJSON* type = cJSON_GetObjectItem(item, "type");
+        cJSON* rect = cJSON_GetObjectItem(item, "rect");
+        
+        if (text) link.text = text->valuestring;
+        if (href) link.href = href->valuestring;
+        if (type) link.type = type->valuestring;
+        
+        cJSON* x = rect ? cJSON_GetObjectItem(rect, "x") : nullptr;
+        cJSON* y = rect ? cJSON_GetObjectItem(rect, "y") : nullptr;
+        cJSON* w = rect ? cJSON_GetObjectItem(rect, "width") : nullptr;
+        cJSON* h = rect ? cJSON_GetObjectItem(rect, "height") : nullptr;
+        link.x = x ? x->valueint : 0;
+        link.y = y ? y->valueint : 0;
+        link.w = w ? w->valueint : 0;
+        link.h = h ? h->valueint : 0;
+        
+        link.targetSection = -1;
+        link.targetPage = 0;
+        cJSON* target = cJSON_GetObjectItem(item, "target");
+        if (target) {
+            cJSON* sec = cJSON_GetObjectItem(target, "section");
+            cJSON* ty = cJSON_GetObjectItem(target, "y");
+            link.targetSection = sec ? sec->valueint : -1;
+            link.targetY = ty ? ty->valueint : -1;
+        }
+        _section_links.push_back(link);
+    }
+    
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(json, "images")) {
+        cJSON* y = cJSON_GetObjectItem(item, "y");
+        cJSON* h = cJSON_GetObjectItem(item, "height");
+        if (y && h) {
+            _section_images.emplace_back(y->valueint, y->valueint + h->valueint);
+        }
+    }
+    
+    cJSON_Delete(json);
+    mclog::tagInfo(getAppInfo().name, "Loaded {} links, {} images for section {}", 
+                   _section_links.size(), _section_images.size(), _reading_section);
+}
+
+void AppBookshelf::scrollBy(int dy)
+{
+    if (_selected_book < 0) return;
+    const BookInfo& book = _books[_selected_book];
+    
+    int height = _strip_section == _reading_section ? _strip_reader.height() : getSectionHeight(_reading_section);
+    int maxScroll = std::max(0, height - PAGE_CONTENT_HEIGHT);
+    
+    if (dy > 0 && _scroll_y >= maxScroll) {
+        // 已到章节末尾：进入下一章节开头
+        const SectionInfo* nextSec = nullptr;
+        for (const auto& sec : book.sections) {
+            if (sec.index > _reading_section) {
+                nextSec = &sec;
+                break;
+            }
+        }
+        if (!nextSec) {
+            mclog::tagInfo(getAppInfo().name, "Already at last page");
+            return;
+        }
+        _reading_section = nextSec->index;
+        _scroll_y = 0;
+    } else if (dy < 0 && _scroll_y <= 0) {
+        // 已到章节开头：进入上一章节末尾
+        const SectionInfo* prevSec = nullptr;
+        for (int i = book.sections.size() - 1; i >= 0; i--) {
+            if (book.sections[i].index < _reading_section) {
+                prevSec = &book.sections[i];
+                break;
+            }
+        }
+        if (!prevSec) {
+            mclog::tagInfo(getAppInfo().name, "Already at first page");
+            return;
+        }
+        _reading_section = prevSec->index;
+        _scroll_y = INT_MAX;  // loadStripViewport() 会夹到章节末尾
+    } else {
+        _scroll_y = std::max(0, std::min(_scroll_y + dy, maxScroll));
+    }
+    
+    loadPage();
+    _page_flip_count++;
+    
+    // 根据翻页次数决定刷新模式
+    bool needFullRefresh = (_page_flip_count % FULL_REFRESH_INTERVAL == 0);
+    drawReading(!needFullRefresh);
+    
+    saveReadingProgress();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  检索                                      */
+/* -------------------------------------------------------------------------- */
+
+void AppBookshelf::handleSearchTouch()
+{
+    SearchPanel::Action action = _search.handleTouch();
+    switch (action.type) {
+        case SearchPanel::Action::BACK:
+            // 返回书架列表；全文模式返回阅读
+            _state = _search.fulltextMode() ? STATE_READING : STATE_LIST;
+            _page_flip_count = 0;
+            _need_redraw = true;
+            break;
+        case SearchPanel::Action::OPEN_BOOK:
+            openBook(action.book);
+            break;
+        case SearchPanel::Action::OPEN_HIT:
+            openFulltextHit(action.hit);
+            break;
+        default:
+            break;
+    }
+}
+
+void AppBookshelf::enterFulltextSearch()
+{
+    _search.enterFulltextSearch();
+    _show_toc = false;
+    _state = STATE_SEARCH;
+    _need_redraw = true;
+}
+
+void AppBookshelf::closeFulltext()
+{
+    _search.closeFulltext();
+    _highlight_boxes.clear();
+    _highlight_section = -1;
+    _highlight_page = -1;
+}
+
+void AppBookshelf::openFulltextHit(const book::FulltextHit& hit)
+{
+    mclog::tagInfo(getAppInfo().name, "Full-text hit: section {}, page {}", hit.section, hit.page);
+    
+    _highlight_boxes = hit.boxes;
+    _highlight_section = hit.section;
+    _highlight_page = hit.page;
+    
+    _reading_section = hit.section;
+    _reading_page = hit.page;
+    _page_flip_count = 0;
+    _state = STATE_READING;
+    
+    loadPage();
+    saveReadingProgress();
+    _need_redraw = true;
+}
+
+void AppBookshelf::drawHighlights()
+{
+    // 只在跳转到的页面上显示，翻页后清除
+    if (_highlight_section != _reading_section || _highlight_page != _reading_page) {
+        _highlight_boxes.clear();
+        _highlight_section = -1;
+        _highlight_page = -1;
         return;
     }
     
-    // 读取文件内容
-    fseek(f, 0, SEEK_END);
-    size_t size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    auto& lcd = GetHAL().display;
+    for (const auto& box : _highlight_boxes) {
+        int x = box.x - 3;
+        int y = box.y - 2;
+        int w = box.w + 6;
+        int h = std::min(box.h + 4, PAGE_CONTENT_HEIGHT - y);
+        lcd.drawRect(x, y, w, h, COLOR_TEXT);
+        lcd.drawRect(x + 1, y + 1, w - 2, h - 2, COLOR_TEXT);
+        
+        // 框线不属于页面内容，下一页需要重绘这些块
+        invalidateScreenTiles(x, y, w, h);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                离线词典                                    */
+/* -------------------------------------------------------------------------- */
+
+bool AppBookshelf::textAtPoint(int x, int y, std::string& text)
+{
+    if (_selected_book < 0) return false;
     
-    char* buffer = (char*)malloc(size + 1);
-    fread(buffer, 1, size, f);
-    buffer[size] = '\0';
-    fclose(f);
+    // 纯文本书籍：按 TextReader 的版面取词
+    if (isTextBook()) {
+        return _text.textAt(x, y, text);
+    }
+    
+    // 有文字层的书：找到按住的行框，与全文检索共用已读入的文字层
+    const BookInfo& book = _books[_selected_book];
+    if (!book.textLayer || isStripBook()) return false;
+    const book::TextLayer* layer = _search.sectionLayer(book, _reading_section);
+    if (!layer) return false;
+    
+    size_t begin = 0, end = 0;
+    layer->pageLines(_reading_page, begin, end);
+    for (size_t i = begin; i < end; i++) {
+        book::TextBox box = layer->lineBox(i);
+        if (box.w <= 0 || x < box.x || x >= box.x + box.w || y < box.y - 4 || y >= box.y + box.h + 4) continue;
+        
+        size_t bytes = 0;
+        const char* data = layer->lineText(i, bytes);
+        std::string line(data, bytes);
+        
+        // 文字层只有行框，页面字体未知：按 efontCN_24 的字宽比例估算按住的是哪个字
+        int width = efont_line_width(line);
+        if (width <= 0) return false;
+        size_t offset = efont_offset_at(line, (x - box.x) * width / box.w);
+        if (offset == std::string::npos) return false;
+        text = book::dictionary_text_at(line, offset);
+        return !text.empty();
+    }
+    return false;
+}
+
+void AppBookshelf::lookupAt(int x, int y)
+{
+    std::string text;
+    if (!textAtPoint(x, y, text)) return;
+    _dict.lookup(text, y);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  批注笔迹                                  */
+/* -------------------------------------------------------------------------- */
+
+bool AppBookshelf::inkAvailable() const
+{
+    return _selected_book >= 0 && _selected_book < (int)_books.size() && !isStripBook();
+}
+
+uint32_t AppBookshelf::inkPageKey() const
+{
+    if (isTextBook()) return _text.offset();
+    return ((uint32_t)_reading_section << 16) | ((uint32_t)_reading_page & 0xFFFF);
+}
+
+void AppBookshelf::openInkStore()
+{
+    _ink.close();
+    if (!inkAvailable()) return;
     
-    // 解析 JSON
-    cJSON* json = cJSON_Parse(buffer);
-    free(buffer);
+    const BookInfo& book = _books[_selected_book];
+    _ink.open(book.txt ? book.txtPath + book::INK_TEXT_SUFFIX
+                       : "/sdcard/books/" + book.id + "/" + book::INK_FILE_NAME);
+}
+
+void AppBookshelf::setInkMode(bool enabled)
+{
+    if (enabled == _ink.active()) return;
+    _ink.setActive(enabled);
     
-    if (!json) {
-        mclog::tagError(getAppInfo().name, "Failed to parse links.json");
+    if (enabled) {
+        // 页面不动，只重画底部栏
+        GetHAL().display.setEpdMode(epd_mode_t::epd_fastest);
+        drawBottomBar();
         return;
     }
     
+    // 最快波形留下的残影在退出时用一次全刷新清掉
+    _need_redraw = true;
+}
+
+void AppBookshelf::undoInkStroke()
+{
+    // 重绘页面擦掉这一笔，快速刷新不闪屏
+    if (_ink.undo(inkPageKey())) {
+        drawReading(true);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              纯文本书籍                                    */
+/* -------------------------------------------------------------------------- */
+
+bool AppBookshelf::isTextBook() const
+{
+    return _selected_book >= 0 && _selected_book < (int)_books.size() && _books[_selected_book].txt;
+}
+
+void AppBookshelf::loadTextPage()
+{
+    _current_page_links.clear();
+    _current_page_has_image = false;
+    if (_text.loadPage(_books[_selected_book])) {
+        updateTextSection();
+    }
+}
+
+void AppBookshelf::gotoTextSection(int sectionIndex)
+{
+    const BookInfo& book = _books[_selected_book];
+    uint32_t offset = 0;
+    for (const auto& sec : book.sections) {
+        if (sec.index == sectionIndex) offset = sec.offset;
+    }
+    if (offset >= book.txtSize) return;
+    
+    _text.seek(offset);
+    _page_flip_count = 0;  // 跳转章节重置计数，使用全刷新
+    
+    loadPage();
+    saveReadingProgress();
+    _need_redraw = true;
+}
+
+void AppBookshelf::updateTextSection()
+{
+    const BookInfo& book = _books[_selected_book];
+    for (const auto& sec : book.sections) {
+        if (sec.offset > _text.offset()) break;
+        _reading_section = sec.index;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              链接处理功能                                  */
+/* -------------------------------------------------------------------------- */
+
+void AppBookshelf::loadPageLinks()
+{
+    _current_page_links.clear();
+    _current_page_has_image = false;  // 默认无图片
+    
+    if (_selected_book < 0) return;
+    const BookInfo& book = _books[_selected_book];
+    
+    // 构建 links.json 路径
+    char linksPath[256];
+    snprintf(linksPath, sizeof(linksPath), 
+             "/sdcard/books/%s/sections/%03d/links.json",
+             book.id.c_str(), _reading_section);
+    
+    // 文件不存在是正常的，说明这个章节没有链接；解析失败时 read_json 已记录日志
+    cJSON* json = read_json(_arena, linksPath);
+    if (!json) return;
+    
     // 获取 pages 数组
     cJSON* pagesArray = cJSON_GetObjectItem(json, "pages");
     if (!pagesArray) {
@@ -1086,6 +2091,9 @@ void AppBookshelf::drawLinkIndicators()
         int underlineY = link.y + link.h - 2;
         lcd.drawLine(link.x, underlineY, link.x + link.w, underlineY);
         
+        // 下划线不属于页面内容，下一页需要重绘这些块
+        invalidateScreenTiles(link.x, underlineY, link.w + 1, 1);
+        
         // 可选：在链接周围绘制虚线边框（用于调试）
         // lcd.drawRect(link.x, link.y, link.w, link.h);
     }
@@ -1107,6 +2115,19 @@ bool AppBookshelf::handleLinkTouch(int x, int y)
                           link.type, link.href);
             
             if (link.type == "internal") {
+                // 条带布局：精确跳转到目标纵向偏移
+                if (isStripBook() && link.targetSection >= 0 && link.targetY >= 0) {
+                    _reading_section = link.targetSection;
+                    _scroll_y = link.targetY;
+                    loadPage();
+                    _need_redraw = true;
+                    
+                    mclog::tagInfo(getAppInfo().name, 
+                                  "Jump to section {}, y {}", 
+                                  _reading_section, _scroll_y);
+                    return true;
+                }
+                
                 // 内部跳转
                 if (link.targetSection > 0 && link.targetPage > 0) {
                     _reading_section = link.targetSection;
@@ -1143,6 +2164,7 @@ bool AppBookshelf::handleLinkTouch(int x, int y)
                 lcd.drawString("点击任意处继续", SCREEN_WIDTH / 2, boxY + 100);
                 
                 lcd.display();
+                _screen_tiles.clear();
                 
                 // 等待触摸后恢复
                 vTaskDelay(pdMS_TO_TICKS(2000));
@@ -1173,6 +2195,11 @@ void AppBookshelf::jumpToAnchor(const std::string& anchor)
         _reading_section = targetSection;
         _reading_page = targetPage;
         
+        auto offset = book.anchorOffsets.find(anchor);
+        if (book.strips && offset != book.anchorOffsets.end()) {
+            _scroll_y = offset->second;
+        }
+        
         freePageImage();
         loadPage();
         _need_redraw = true;
@@ -1182,21 +2209,12 @@ void AppBookshelf::jumpToAnchor(const std::string& anchor)
     }
 }
 
-void AppBookshelf::freeBookCovers()
-{
-    for (auto& book : _books) {
-        if (book.coverData) {
-            free(book.coverData);
-            book.coverData = nullptr;
-            book.coverSize = 0;
-        }
-    }
-}
-
 void AppBookshelf::freePageImage()
 {
+    _tile_view.parse(nullptr, 0);  // 视图引用 _page_image，一并失效
+    _frame_ready = false;
     if (_page_image) {
-        free(_page_image);
+        _arena.free(_page_image);
         _page_image = nullptr;
         _page_image_size = 0;
     }
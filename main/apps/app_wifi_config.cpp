@@ -944,6 +944,8 @@ void AppWifiConfig::drawServerRunning()
     lcd.drawString("DELETE /api/rmdir?path= - 递归删除目录", info_x, info_y);
     info_y += line_height;
     lcd.drawString("POST /api/upload-batch?dir= - 批量上传", info_x, info_y);
+    info_y += line_height;
+    lcd.drawString("POST /api/upload?name= - 上传书籍", info_x, info_y);
     
     // 停止服务器按钮
     _stop_btn_w = 300;
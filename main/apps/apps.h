@@ -5,11 +5,25 @@
  */
 #include <mooncake.h>
 #include <M5GFX.h>
+#include <atomic>
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include "usb/usb_host.h"
+#include "strip_reader.h"
+#include "tile_page.h"
+#include "band_decoder.h"
+#include "fs_events.h"
+#include "file_checksums.h"
+#include "app_arena.h"
+#include "book_library.h"
+#include "reader_ink.h"
+#include "dictionary_panel.h"
+#include "thumb_scrubber.h"
+#include "text_reader.h"
+#include "search_panel.h"
 
 /**
  * @brief
@@ -258,6 +272,8 @@ public:
     int getAppId() const { return _app_id; }
 
 private:
+    // 本应用的缓冲都从这里分配，声明在最前面，最后析构
+    book::AppArena _arena{"AppBookshelf"};
     int _app_id = -1;
     bool _need_destroy = false;
     bool _need_redraw = true;
@@ -266,16 +282,14 @@ private:
     enum State {
         STATE_LOADING,
         STATE_LIST,
+        STATE_SEARCH,
         STATE_READING
     };
     State _state = STATE_LOADING;
     
-    // 章节信息
-    struct SectionInfo {
-        int index;
-        std::string title;
-        int pageCount;
-    };
+    // 章节与图书信息由 BookLibrary 持有，关闭书架后保留
+    using SectionInfo = LibrarySection;
+    using BookInfo = LibraryBook;
     
     // 链接信息
     struct LinkInfo {
@@ -285,23 +299,10 @@ private:
         std::string type;      // "internal" 或 "external"
         int targetSection;     // 目标章节（internal类型）
         int targetPage;        // 目标页面（internal类型）
+        int targetY = -1;      // 目标纵向偏移（条带布局）
     };
     
-    // 图书信息
-    struct BookInfo {
-        std::string id;
-        std::string title;
-        std::string author;
-        std::string addedAt;        // 新增：添加时间
-        std::string lastReadTime;
-        int currentSection;
-        int currentPage;
-        std::vector<SectionInfo> sections;
-        std::map<std::string, std::pair<int, int>> anchorMap;  // 新增：锚点映射 anchor_id -> (section, page)
-        uint8_t* coverData = nullptr;
-        size_t coverSize = 0;
-    };
-    std::vector<BookInfo> _books;
+    std::vector<BookInfo>& _books = BookLibrary::getInstance().books();
     
     // 列表分页
     int _list_page = 0;
@@ -318,23 +319,113 @@ private:
     int _page_flip_count = 0;  // 翻页计数，用于控制全刷新
     std::vector<LinkInfo> _current_page_links;  // 新增：当前页面的链接信息
     bool _current_page_has_image = false;  // 新增：当前页面是否包含图片
+    book::ChecksumSampler _page_verifier;  // 抽样校验读入的页面
+    bool _page_corrupt = false;            // 当前页与上传时记录的 CRC32C 不符
+    
+    // 条带布局（连续滚动）
+    int _scroll_y = 0;                      // 视口在章节长图中的纵向偏移
+    int _strip_section = -1;                // _strip_reader 当前打开的章节
+    book::StripReader _strip_reader;
+    std::vector<LinkInfo> _section_links;   // 整章链接，长图坐标
+    std::vector<std::pair<int, int>> _section_images;  // 整章图片区域 [y, y + height)
+    
+    // 分块页面
+    book::TilePageView _tile_view;          // 解析 _page_image，parse 失败时 tileCount() 为 0
+    // 屏幕上各块当前内容的哈希，为空表示需要整页重绘
+    book::ArenaVector<uint32_t> _screen_tiles{book::ArenaAllocator<uint32_t>(_arena)};
+    
+    // 行带页面：两个核心并行解码到 PSRAM 帧缓冲，再一次性推送
+    book::BandDecoder _band_decoder;
+    
+    // 双缓冲：面板刷新当前页时把下一页解码到后缓冲，翻页时交换后只需推送
+    uint8_t* _frame_buffer = nullptr;       // 前缓冲，SCREEN_WIDTH × PAGE_CONTENT_HEIGHT，8-bit 灰度
+    uint8_t* _back_buffer = nullptr;        // 后缓冲，尺寸同上
+    int _back_section = -1;                 // 后缓冲中的页面，-1 表示无效
+    int _back_page = -1;
+    bool _frame_ready = false;              // 当前页已在前缓冲中（预读命中）
+    bool _read_ahead_pending = false;       // 本页绘制完成，等待预读
+    int _flip_direction = 1;                // 最近一次翻页方向，决定预读哪一页
+    uint32_t _last_flip_end = 0;
+    
+    // 缩略图集：打开书籍后由后台任务逐页生成，拖动底部进度条时预览
+    ThumbScrubber _thumbs{_arena};
+    
+    // 纯文本书籍：后台任务分页并写入索引，阅读器只排版当前页
+    TextReader _text{_arena};
+    
+    // 书名 / 作者检索和当前书的全文检索
+    SearchPanel _search;
+    std::vector<book::TextBox> _highlight_boxes;  // 从检索结果跳转后在页面上标出的命中
+    int _highlight_section = -1;
+    int _highlight_page = -1;
+    
+    // 离线词典：阅读时长按正文取词，释义浮层盖在页面上
+    DictionaryPanel _dict{[this](int x, int y, int w, int h) { invalidateScreenTiles(x, y, w, h); }};
+    
+    // 批注：笔迹画过的块在下一页重绘
+    ReaderInk _ink{[this](int x, int y, int w, int h) { invalidateScreenTiles(x, y, w, h); }};
     
     // 触摸区域（列表）
     int _back_btn_x = 0, _back_btn_y = 0, _back_btn_w = 0, _back_btn_h = 0;
+    int _search_btn_x = 0, _search_btn_y = 0, _search_btn_w = 0, _search_btn_h = 0;
     int _prev_list_x = 0, _prev_list_y = 0, _prev_list_w = 0, _prev_list_h = 0;
     int _next_list_x = 0, _next_list_y = 0, _next_list_w = 0, _next_list_h = 0;
     
     // 图书列表UI
-    void loadBooks();
     void drawBookList();
     void drawBookItem(int index, int y);
     void handleListTouch();
     
+    // 检索UI
+    void handleSearchTouch();
+    void enterFulltextSearch();
+    void closeFulltext();           // 返回书架或换书时停止全文索引任务、清空结果和页面上的命中
+    void openFulltextHit(const book::FulltextHit& hit);
+    void drawHighlights();
+    
+    // 离线词典
+    bool textAtPoint(int x, int y, std::string& text);  // 按住位置起的一段文字，交给 dictionary_text_at 取词
+    void lookupAt(int x, int y);
+    
+    // 批注
+    bool inkAvailable() const;      // 条带布局没有固定的页，不支持
+    uint32_t inkPageKey() const;    // 分页的书为 章节 << 16 | 页码，纯文本书籍为页首偏移
+    void openInkStore();
+    void setInkMode(bool enabled);
+    void undoInkStroke();
+    
     // 阅读器UI
     void openBook(int bookIndex);
     void loadPage();
     void drawReading(bool fastMode = false);
+    bool drawPageImageFast();       // 灰度 PNG（1/2/4/8-bit）快速解码绘制
+    bool drawStripViewport();       // 条带布局：从缓存条带拼出视口
+    bool drawTiledPage();           // 分块页面：只解码推送与屏幕上不同的块
+    bool drawBandedPage();          // 行带页面：双核并行解码后整页推送
+    bool readPageFile(int section, int page, uint8_t*& data, size_t& size);
+    
+    // 双缓冲流水线
+    bool allocFrameBuffers();
+    void freeFrameBuffers();
+    void logArenaStats(const char* when);
+    void pushFrameBuffer();
+    bool decodePageTo(const uint8_t* data, size_t size, uint8_t* frame);  // 整页解码到帧缓冲
+    void prepareNextFrame();        // 预读：按翻页方向把相邻页解码到后缓冲
+    bool adjacentPage(int direction, int& section, int& page) const;
+    void invalidateScreenTiles(int x, int y, int w, int h);  // 标记被覆盖的块，下次翻页时重绘
+    
+    // 缩略图集与进度条拖动
+    bool handleScrubTouch(const m5::Touch_Class::touch_detail_t& touch);  // 松手时跳转到预览的页面
+    void jumpToGlobalPage(int globalPage);  // 全书页序从 0 开始
+    
+    // 纯文本书籍
+    bool isTextBook() const;
+    void loadTextPage();            // 从当前页首排出一页
+    void gotoTextSection(int sectionIndex);
+    void updateTextSection();       // 按当前页首更新 _reading_section
     void drawBottomBar();
+    bool hasTableOfContents() const;
+    int tocFirstItem() const;       // 目录列表第一项的下标
     void drawTOC();
     void handleReadingTouch();
     void saveReadingProgress();
@@ -342,6 +433,16 @@ private:
     // 翻页
     void nextPage();
     void prevPage();
+    void flipToCurrentPage();       // 加载并绘制 _reading_section / _reading_page，记录翻页耗时
+    
+    // 条带布局
+    bool isStripBook() const;
+    bool isTiledBook() const;
+    bool isBandedBook() const;
+    void loadStripViewport();       // 打开章节条带文件，计算视口内的链接和图片
+    void loadSectionLinks();        // 读取整章 links.json（长图坐标）
+    void scrollBy(int dy);          // 滚动视口，越过章节边界时切换章节
+    int getSectionHeight(int sectionIndex);
     
     // 链接处理
     void loadPageLinks();           // 加载当前页面的链接信息
@@ -351,7 +452,6 @@ private:
     void gotoSection(int sectionIndex);
     
     // 工具函数
-    void freeBookCovers();
     void freePageImage();
     int getTotalPages();
     int getCurrentGlobalPage();
@@ -0,0 +1,492 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "book_library.h"
+#include "hal.h"
+#include <mooncake_log.h>
+#include <dirent.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <cJSON.h>
+#include "epub_ingest.h"
+#include "library_changes.h"
+#include "text_book.h"
+
+static const char* TAG = "BookLibrary";
+
+static constexpr size_t LIBRARY_COVER_CACHE = 9;  // 三页书架
+
+BookLibrary& BookLibrary::getInstance()
+{
+    static BookLibrary instance;
+    return instance;
+}
+
+// 签名：把各文件的 mtime 和大小（不存在记为 0）依次混入 FNV-1a
+static void mix_stat(uint64_t& hash, const std::string& path)
+{
+    struct stat st;
+    uint64_t values[2] = {0, 0};
+    if (stat(path.c_str(), &st) == 0) {
+        values[0] = (uint64_t)st.st_mtime;
+        values[1] = (uint64_t)st.st_size + 1;
+    }
+    for (uint64_t v : values) {
+        for (int i = 0; i < 8; i++) {
+            hash ^= (v >> (i * 8)) & 0xFF;
+            hash *= 0x100000001B3ULL;
+        }
+    }
+}
+
+static std::string cover_path(const std::string& bookPath)
+{
+    // 支持 cover.png 和 COVER.png
+    struct stat st;
+    std::string path = bookPath + "/cover.png";
+    if (stat(path.c_str(), &st) == 0) return path;
+    path = bookPath + "/COVER.png";
+    return stat(path.c_str(), &st) == 0 ? path : std::string();
+}
+
+uint64_t BookLibrary::signature(const std::string& id, bool isText) const
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    std::string path = std::string(book::LIBRARY_ROOT) + "/" + id;
+    mix_stat(hash, path);
+    if (isText) {
+        mix_stat(hash, path + book::TEXT_STATUS_SUFFIX);
+    } else {
+        mix_stat(hash, path + "/metadata.json");
+        mix_stat(hash, path + "/reading_status.json");
+        mix_stat(hash, cover_path(path));
+    }
+    return hash;
+}
+
+cJSON* read_json(book::AppArena& arena, const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return nullptr;
+
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (length < 0) {
+        fclose(f);
+        return nullptr;
+    }
+
+    char* buffer = (char*)arena.alloc((size_t)length + 1);
+    if (!buffer) {
+        fclose(f);
+        return nullptr;
+    }
+    size_t size  = fread(buffer, 1, (size_t)length, f);
+    buffer[size] = '\0';
+    fclose(f);
+
+    cJSON* json = cJSON_Parse(buffer);
+    arena.free(buffer);
+    if (!json) mclog::tagError(TAG, "Failed to parse {}", path);
+    return json;
+}
+
+bool BookLibrary::sync()
+{
+    uint32_t start = GetHAL().millis();
+    std::vector<std::string> ids;
+    bool all = book::LibraryChanges::getInstance().take(ids);
+
+    struct stat st;
+    int64_t rootMtime = stat(book::LIBRARY_ROOT, &st) == 0 ? (int64_t)st.st_mtime : -1;
+
+    bool changed = false;
+    if (!_scanned || all || rootMtime != _root_mtime) {
+        changed = scan();
+        _scanned = true;
+        _root_mtime = rootMtime;
+    } else {
+        for (const auto& id : ids) {
+            changed = reload(id) || changed;
+        }
+    }
+
+    if (changed || _order_dirty) {
+        std::stable_sort(_books.begin(), _books.end(), [](const LibraryBook& a, const LibraryBook& b) {
+            return a.lastReadTime > b.lastReadTime;
+        });
+        _order_dirty = false;
+    }
+
+    _stats.syncMs = GetHAL().millis() - start;
+    mclog::tagInfo(TAG, "Sync: {} books, {} changed, {} ({} parsed, {} reused in total), {} ms", _books.size(),
+                   ids.size(), changed ? "updated" : "unchanged", _stats.parsed, _stats.reused, _stats.syncMs);
+    return changed;
+}
+
+bool BookLibrary::scan()
+{
+    mclog::tagInfo(TAG, "Scanning {}", book::LIBRARY_ROOT);
+    _stats.scans++;
+
+    DIR* dir = opendir(book::LIBRARY_ROOT);
+    if (!dir) {
+        mclog::tagError(TAG, "Failed to open {}", book::LIBRARY_ROOT);
+        bool changed = !_books.empty();
+        _books.clear();
+        return changed;
+    }
+
+    std::unordered_map<std::string, size_t> existing;
+    for (size_t i = 0; i < _books.size(); i++) {
+        existing[_books[i].id] = i;
+    }
+
+    std::vector<LibraryBook> books;
+    books.reserve(_books.size());
+    std::vector<bool> kept(_books.size(), false);
+    size_t reused = 0;
+    bool changed = false;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.') continue;
+
+        // 纯文本书籍直接放在 books/ 下
+        std::string id = entry->d_name;
+        bool isText = entry->d_type == DT_REG;
+        if (isText) {
+            size_t dot = id.rfind('.');
+            if (dot == std::string::npos || strcasecmp(id.c_str() + dot, ".txt") != 0) continue;
+        } else if (entry->d_type != DT_DIR) {
+            continue;
+        }
+
+        uint64_t sig = signature(id, isText);
+        auto it = existing.find(id);
+        if (it != existing.end() && _books[it->second].signature == sig) {
+            books.push_back(std::move(_books[it->second]));
+            kept[it->second] = true;
+            reused++;
+            continue;
+        }
+
+        LibraryBook book;
+        if (loadBook(id, isText, book)) {
+            book.signature = sig;
+            books.push_back(std::move(book));
+        }
+        dropCover(id);
+        changed = true;
+    }
+    closedir(dir);
+
+    // 重新解析和不再出现的书籍，封面已失效
+    changed = changed || reused != _books.size();
+    for (size_t i = 0; i < _books.size(); i++) {
+        if (!kept[i]) dropCover(_books[i].id);
+    }
+    _books.swap(books);
+    _stats.reused += reused;
+    return changed;
+}
+
+bool BookLibrary::reload(const std::string& id)
+{
+    int index = -1;
+    for (size_t i = 0; i < _books.size(); i++) {
+        if (_books[i].id == id) {
+            index = (int)i;
+            break;
+        }
+    }
+    dropCover(id);
+
+    std::string path = std::string(book::LIBRARY_ROOT) + "/" + id;
+    struct stat st;
+    bool exists = stat(path.c_str(), &st) == 0 && (S_ISREG(st.st_mode) || S_ISDIR(st.st_mode));
+    bool isText = exists && S_ISREG(st.st_mode);
+    LibraryBook book;
+    if (!exists || !loadBook(id, isText, book)) {
+        if (index < 0) return false;
+        _books.erase(_books.begin() + index);
+        return true;
+    }
+
+    book.signature = signature(id, isText);
+    if (index >= 0) {
+        _books[index] = std::move(book);
+    } else {
+        _books.push_back(std::move(book));
+    }
+    return true;
+}
+
+void BookLibrary::revalidate(size_t index)
+{
+    if (index >= _books.size()) return;
+    LibraryBook& current = _books[index];
+    bool isText = current.txt && current.txtPath == std::string(book::LIBRARY_ROOT) + "/" + current.id;
+    uint64_t sig = signature(current.id, isText);
+    if (sig == current.signature) return;
+
+    // 读取失败（例如书籍目录正被删除）时保留原来的数据，等删除的通知到达后下次打开书架时移除
+    LibraryBook book;
+    if (!loadBook(current.id, isText, book)) return;
+    mclog::tagInfo(TAG, "Book changed on card: {}", current.id);
+    book.signature = sig;
+    dropCover(current.id);
+    current = std::move(book);
+}
+
+void BookLibrary::progressSaved(size_t index)
+{
+    if (index >= _books.size()) return;
+    LibraryBook& book = _books[index];
+    bool isText = book.txt && book.txtPath == std::string(book::LIBRARY_ROOT) + "/" + book.id;
+    book.signature = signature(book.id, isText);
+    _order_dirty = true;
+}
+
+bool BookLibrary::cover(size_t index, const uint8_t*& data, size_t& size)
+{
+    if (index >= _books.size() || _books[index].coverPath.empty()) return false;
+    const LibraryBook& book = _books[index];
+
+    for (auto& entry : _covers) {
+        if (entry.id == book.id) {
+            entry.lastUse = ++_cover_clock;
+            data = entry.data;
+            size = entry.size;
+            _stats.coverHit++;
+            return true;
+        }
+    }
+    _stats.coverMiss++;
+
+    FILE* f = fopen(book.coverPath.c_str(), "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    size_t fileSize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    // 淘汰最久未用的封面
+    if (_covers.size() >= LIBRARY_COVER_CACHE) {
+        auto oldest = std::min_element(_covers.begin(), _covers.end(), [](const CoverEntry& a, const CoverEntry& b) {
+            return a.lastUse < b.lastUse;
+        });
+        _arena.free(oldest->data);
+        _covers.erase(oldest);
+    }
+
+    CoverEntry entry;
+    entry.data = (uint8_t*)_arena.alloc(fileSize);
+    if (!entry.data || fread(entry.data, 1, fileSize, f) != fileSize) {
+        _arena.free(entry.data);
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+
+    entry.id = book.id;
+    entry.size = fileSize;
+    entry.lastUse = ++_cover_clock;
+    _covers.push_back(entry);
+    data = entry.data;
+    size = entry.size;
+    return true;
+}
+
+void BookLibrary::dropCover(const std::string& id)
+{
+    for (auto it = _covers.begin(); it != _covers.end(); ++it) {
+        if (it->id == id) {
+            _arena.free(it->data);
+            _covers.erase(it);
+            return;
+        }
+    }
+}
+
+bool BookLibrary::loadBook(const std::string& id, bool isText, LibraryBook& book)
+{
+    _stats.parsed++;
+    return isText ? loadTextBook(id, book) : loadBookDir(id, book);
+}
+
+bool BookLibrary::loadBookDir(const std::string& bookId, LibraryBook& book)
+{
+    std::string bookPath = std::string(book::LIBRARY_ROOT) + "/" + bookId;
+
+    mclog::tagInfo(TAG, "Found book: {}", bookId);
+
+    // 上传的 EPUB 尚未导入（或导入被重启打断）：交给后台导入，完成后通知书架重新读取
+    if (book::epub_ingest_pending(bookPath)) {
+        mclog::tagInfo(TAG, "EPUB not ingested yet: {}", bookId);
+        book::EpubIngestQueue::getInstance().enqueue(bookPath);
+        return false;
+    }
+
+    // 读取 metadata.json
+    std::string metadataPath = bookPath + "/metadata.json";
+    cJSON* json = read_json(_arena, metadataPath);
+    if (!json) {
+        mclog::tagError(TAG, "Failed to read {}", metadataPath);
+        return false;
+    }
+
+    book.id = bookId;
+
+    cJSON* titleItem = cJSON_GetObjectItem(json, "title");
+    cJSON* authorItem = cJSON_GetObjectItem(json, "author");
+    cJSON* addedAtItem = cJSON_GetObjectItem(json, "addedAt");
+
+    book.title = titleItem ? titleItem->valuestring : "未知书名";
+    book.author = authorItem ? authorItem->valuestring : "未知作者";
+    book.addedAt = addedAtItem ? addedAtItem->valuestring : "";
+
+    // 条带布局（可选）
+    cJSON* layoutItem = cJSON_GetObjectItem(json, "layout");
+    book.strips = layoutItem && cJSON_IsString(layoutItem) && strcmp(layoutItem->valuestring, "strips") == 0;
+
+    // 分块页面（可选）
+    cJSON* pageFormatItem = cJSON_GetObjectItem(json, "pageFormat");
+    book.tiles = pageFormatItem && cJSON_IsString(pageFormatItem) &&
+                 strcmp(pageFormatItem->valuestring, "tiles") == 0;
+    book.bands = pageFormatItem && cJSON_IsString(pageFormatItem) &&
+                 strcmp(pageFormatItem->valuestring, "bands") == 0;
+
+    // 文字层（可选），条带布局不支持
+    cJSON* textLayerItem = cJSON_GetObjectItem(json, "textLayer");
+    book.textLayer = cJSON_IsTrue(textLayerItem) && !book.strips;
+
+    // 纯文本引擎的书籍目录（EPUB 导入生成）：正文为 textFile，章节以字节偏移定位
+    cJSON* formatItem = cJSON_GetObjectItem(json, "format");
+    if (formatItem && cJSON_IsString(formatItem) && strcmp(formatItem->valuestring, "text") == 0) {
+        cJSON* textFileItem = cJSON_GetObjectItem(json, "textFile");
+        book.txt = true;
+        book.txtPath = bookPath + "/" +
+                       (textFileItem && cJSON_IsString(textFileItem) ? textFileItem->valuestring
+                                                                    : book::EPUB_TEXT_FILE_NAME);
+        struct stat st;
+        if (stat(book.txtPath.c_str(), &st) != 0) {
+            mclog::tagError(TAG, "Missing text file {}", book.txtPath);
+            cJSON_Delete(json);
+            return false;
+        }
+        book.txtSize = (uint32_t)st.st_size;
+    }
+
+    // 解析 anchorMap（可选）
+    cJSON* anchorMapItem = cJSON_GetObjectItem(json, "anchorMap");
+    if (anchorMapItem) {
+        cJSON* anchor = nullptr;
+        cJSON_ArrayForEach(anchor, anchorMapItem) {
+            if (anchor->string) {
+                cJSON* sectionItem = cJSON_GetObjectItem(anchor, "section");
+                cJSON* pageItem = cJSON_GetObjectItem(anchor, "page");
+                if (sectionItem && pageItem) {
+                    book.anchorMap[anchor->string] =
+                        std::make_pair(sectionItem->valueint, pageItem->valueint);
+                }
+                cJSON* yItem = cJSON_GetObjectItem(anchor, "y");
+                if (yItem) {
+                    book.anchorOffsets[anchor->string] = yItem->valueint;
+                }
+            }
+        }
+        mclog::tagInfo(TAG, "Loaded {} anchors for book {}", book.anchorMap.size(), bookId);
+    }
+
+    // 读取章节信息
+    cJSON* sectionsArray = cJSON_GetObjectItem(json, "sections");
+    if (sectionsArray) {
+        int sectionCount = cJSON_GetArraySize(sectionsArray);
+        for (int i = 0; i < sectionCount; i++) {
+            cJSON* section = cJSON_GetArrayItem(sectionsArray, i);
+            LibrarySection info;
+            info.index = cJSON_GetObjectItem(section, "index")->valueint;
+            info.title = cJSON_GetObjectItem(section, "title")->valuestring;
+            info.pageCount = cJSON_GetObjectItem(section, "pageCount")->valueint;
+            cJSON* heightItem = cJSON_GetObjectItem(section, "height");
+            info.height = heightItem ? heightItem->valueint : 0;
+            cJSON* offsetItem = cJSON_GetObjectItem(section, "offset");
+            info.offset = offsetItem ? (uint32_t)offsetItem->valuedouble : 0;
+            book.sections.push_back(info);
+        }
+        mclog::tagInfo(TAG, "Loaded {} sections for book {}", book.sections.size(), bookId);
+    }
+
+    cJSON_Delete(json);
+
+    // 读取阅读进度
+    if (book.txt) {
+        loadTextStatus(book);
+    } else {
+        book.currentSection = 1;
+        book.currentPage = 1;
+        book.lastReadTime = "";
+        cJSON* statusJson = read_json(_arena, bookPath + "/reading_status.json");
+        if (statusJson) {
+            cJSON* secItem = cJSON_GetObjectItem(statusJson, "currentSection");
+            cJSON* pageItem = cJSON_GetObjectItem(statusJson, "currentPage");
+            cJSON* timeItem = cJSON_GetObjectItem(statusJson, "lastReadTime");
+            cJSON* offsetItem = cJSON_GetObjectItem(statusJson, "offsetY");
+
+            book.currentSection = secItem ? secItem->valueint : 1;
+            book.currentPage = pageItem ? pageItem->valueint : 1;
+            book.lastReadTime = timeItem ? timeItem->valuestring : "";
+            book.currentOffsetY = offsetItem ? offsetItem->valueint : 0;
+
+            cJSON_Delete(statusJson);
+        }
+    }
+
+    // 封面在书架显示到这本书时才读取
+    book.coverPath = cover_path(bookPath);
+    return true;
+}
+
+bool BookLibrary::loadTextBook(const std::string& fileName, LibraryBook& book)
+{
+    size_t dot = fileName.rfind('.');
+    if (dot == std::string::npos || strcasecmp(fileName.c_str() + dot, ".txt") != 0) return false;
+
+    std::string textPath = std::string(book::LIBRARY_ROOT) + "/" + fileName;
+    struct stat st;
+    if (stat(textPath.c_str(), &st) != 0) return false;
+
+    mclog::tagInfo(TAG, "Found text book: {} ({} bytes)", fileName, (uint32_t)st.st_size);
+
+    book.id = fileName;
+    book.title = fileName.substr(0, dot);
+    book.author = "纯文本";
+    book.txt = true;
+    book.txtPath = textPath;
+    book.txtSize = (uint32_t)st.st_size;
+    loadTextStatus(book);
+    return true;
+}
+
+void BookLibrary::loadTextStatus(LibraryBook& book)
+{
+    book.currentSection = 0;
+    book.currentPage = 1;
+
+    // 读取阅读进度：{正文}.status.json，与正文放在一起
+    cJSON* statusJson = read_json(_arena, book.txtPath + book::TEXT_STATUS_SUFFIX);
+    if (statusJson) {
+        cJSON* offsetItem = cJSON_GetObjectItem(statusJson, "offset");
+        cJSON* timeItem = cJSON_GetObjectItem(statusJson, "lastReadTime");
+        book.txtOffset = offsetItem ? (uint32_t)offsetItem->valuedouble : 0;
+        book.lastReadTime = timeItem && cJSON_IsString(timeItem) ? timeItem->valuestring : "";
+        cJSON_Delete(statusJson);
+    }
+    if (book.txtOffset >= book.txtSize) book.txtOffset = 0;
+}
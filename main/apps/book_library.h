@@ -0,0 +1,136 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "app_arena.h"
+
+struct cJSON;
+
+// 章节信息
+struct LibrarySection {
+    int index;
+    std::string title;
+    int pageCount;
+    int height = 0;       // 条带布局：章节长图高度
+    uint32_t offset = 0;  // 纯文本书籍：章节起点的字节偏移
+};
+
+// 图书信息
+struct LibraryBook {
+    std::string id;
+    std::string title;
+    std::string author;
+    std::string addedAt;        // 新增：添加时间
+    std::string lastReadTime;
+    int currentSection;
+    int currentPage;
+    std::vector<LibrarySection> sections;
+    std::map<std::string, std::pair<int, int>> anchorMap;  // 新增：锚点映射 anchor_id -> (section, page)
+    std::map<std::string, int> anchorOffsets;              // 条带布局：anchor_id -> 章节内纵向偏移
+    bool strips = false;                                   // 条带布局（连续滚动）
+    int currentOffsetY = 0;                                // 条带布局的阅读位置
+    bool tiles = false;                                    // 页面为 .tpg 分块格式
+    bool bands = false;                                    // 页面为 .bnd 行带格式
+    bool txt = false;                                      // 纯文本书籍：.txt 文件或 EPUB 导入的书籍目录
+    std::string txtPath;                                   // 纯文本书籍的正文路径
+    uint32_t txtOffset = 0;                                // 纯文本书籍的阅读位置（当前页首的字节偏移）
+    uint32_t txtSize = 0;                                  // 纯文本文件长度
+    bool textLayer = false;                                // 章节带文字层 text.bin，可全文检索
+    std::string coverPath;                                 // 封面 PNG，没有封面时为空
+    uint64_t signature = 0;                                // 读取时书籍各文件的 mtime / 大小，用于发现变化
+};
+
+struct LibraryStats {
+    uint32_t syncMs    = 0;  // 最近一次 sync() 的耗时
+    uint32_t scans     = 0;  // 全量扫描次数
+    uint32_t parsed    = 0;  // 累计重新解析的书籍数
+    uint32_t reused    = 0;  // 全量扫描中签名未变、直接沿用的书籍数
+    uint32_t coverHit  = 0;
+    uint32_t coverMiss = 0;
+};
+
+/**
+ * @brief 读取并解析整个 JSON 文件，读取缓冲从 arena 分配、解析后即释放
+ * @return 文件不存在、读取或解析失败时返回 nullptr；成功时由调用方 cJSON_Delete
+ */
+cJSON* read_json(book::AppArena& arena, const std::string& path);
+
+/**
+ * @brief 书架数据服务：书籍列表、阅读进度和封面保存在应用实例之外，重新打开书架时不再重新扫描
+ *
+ * 第一次 sync() 全量扫描 books/；之后只重新读取 book::LibraryChanges 中有变化通知的书籍
+ * （HTTP 上传 / 删除、EPUB 导入完成），根目录 mtime 变化（换卡）时全量扫描，但签名不变的书籍沿用已解析的数据。
+ * 书架只对当前一页的书籍调用 revalidate() 和 cover()，打开书架的开销与可见项数成正比。
+ * 只在界面任务中使用，不加锁。
+ */
+class BookLibrary {
+public:
+    static BookLibrary& getInstance();
+
+    /**
+     * @brief 打开书架时调用，按最后阅读时间排序（最近的在前）
+     * @return 书籍列表有变化时返回 true
+     */
+    bool sync();
+
+    std::vector<LibraryBook>& books()
+    {
+        return _books;
+    }
+
+    /**
+     * @brief 复查一本书的文件签名，变化时重新读取
+     */
+    void revalidate(size_t index);
+
+    /**
+     * @brief 封面 PNG 数据，按最近使用保留 LIBRARY_COVER_CACHE 本
+     * @return 没有封面或读取失败时返回 false
+     */
+    bool cover(size_t index, const uint8_t*& data, size_t& size);
+
+    /**
+     * @brief 阅读进度写入后调用：更新签名，下次 sync() 时重新排序
+     */
+    void progressSaved(size_t index);
+
+    const LibraryStats& stats() const
+    {
+        return _stats;
+    }
+
+private:
+    struct CoverEntry {
+        std::string id;
+        uint8_t* data    = nullptr;
+        size_t size      = 0;
+        uint32_t lastUse = 0;
+    };
+
+    BookLibrary() = default;
+
+    book::AppArena _arena{"BookLibrary"};
+    std::vector<LibraryBook> _books;
+    std::vector<CoverEntry> _covers;
+    uint32_t _cover_clock = 0;
+    bool _scanned = false;
+    bool _order_dirty = false;
+    int64_t _root_mtime = 0;
+    LibraryStats _stats;
+
+    bool scan();
+    bool reload(const std::string& id);
+    bool loadBook(const std::string& id, bool isText, LibraryBook& book);
+    bool loadBookDir(const std::string& id, LibraryBook& book);
+    bool loadTextBook(const std::string& fileName, LibraryBook& book);
+    void loadTextStatus(LibraryBook& book);
+    uint64_t signature(const std::string& id, bool isText) const;
+    void dropCover(const std::string& id);
+};
@@ -0,0 +1,28 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstdint>
+
+// 书架与阅读器各部分（app_bookshelf.cpp 及拆出的面板）共用的屏幕布局和颜色
+
+// 屏幕和布局常量
+static constexpr int SCREEN_WIDTH = 540;
+static constexpr int SCREEN_HEIGHT = 960;
+static constexpr int PAGE_CONTENT_HEIGHT = 900;  // 页面内容高度
+static constexpr int UI_HEIGHT = 60;             // 底部UI高度
+static constexpr int LIST_HEADER_HEIGHT = 80;    // 书架和检索界面的标题栏
+
+// 批注：底部栏返回按钮左侧为批注开关
+static constexpr int INK_BTN_X = SCREEN_WIDTH - 180;
+
+// 颜色常量
+static constexpr uint32_t COLOR_BG = 0xFFFFFF;
+static constexpr uint32_t COLOR_TEXT = 0x000000;
+static constexpr uint32_t COLOR_TEXT_GRAY = 0x666666;
+static constexpr uint32_t COLOR_BORDER = 0xCCCCCC;
+static constexpr uint32_t COLOR_BTN = 0xEEEEEE;
+static constexpr uint32_t COLOR_PROGRESS = 0x333333;
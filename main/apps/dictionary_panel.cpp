@@ -0,0 +1,205 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "dictionary_panel.h"
+#include "bookshelf_ui.h"
+#include "hal.h"
+#include <mooncake_log.h>
+#include <dirent.h>
+#include <strings.h>
+#include <algorithm>
+#include <cstring>
+
+static const char* TAG = "DictionaryPanel";
+
+// 词典释义浮层：efontCN_16 排版，按住位置在上半屏时放在下方，反之放在上方
+static constexpr int DICT_PANEL_MARGIN = 20;
+static constexpr int DICT_PANEL_HEIGHT = 380;
+static constexpr int DICT_HEADER_HEIGHT = 56;
+static constexpr int DICT_FOOTER_HEIGHT = 32;
+static constexpr int DICT_LINE_HEIGHT = 24;
+static constexpr int DICT_TEXT_PADDING = 16;
+
+static int efont_small_width(uint32_t codepoint)
+{
+    lgfx::FontMetrics metrics;
+    fonts::efontCN_16.getDefaultMetric(&metrics);
+    if (codepoint > 0xFFFF || !fonts::efontCN_16.updateFontMetric(&metrics, (uint16_t)codepoint)) {
+        return 8;
+    }
+    return metrics.x_advance;
+}
+
+void DictionaryPanel::lookup(const std::string& text, int touchY)
+{
+    loadDictionaries();
+    
+    uint32_t start = GetHAL().millis();
+    uint32_t reads = 0;
+    bool found = false;
+    _source.clear();
+    for (auto& dict : _dictionaries) {
+        // 英文单词整词取出，不限字数；查不到时退到较短的前缀，变形词（walked）能落到原形（walk）
+        uint32_t before = dict->reads();
+        found = dict->lookupLongest(text, _entry, text.size());
+        reads += dict->reads() - before;
+        if (found) {
+            _source = dict->name();
+            break;
+        }
+    }
+    mclog::tagInfo(TAG, "Dictionary lookup '{}': {} in {} ms, {} reads", text,
+                   found ? _entry.headword : "not found", GetHAL().millis() - start, reads);
+    
+    // 没有命中也弹出浮层，说明取到的字和原因
+    if (!found) {
+        _entry.headword = text;
+        _entry.definition = _dictionaries.empty() ? "没有可用的词典，请把 dict_compiler 生成的 .pdict 文件放到 /sdcard/dict"
+                                                  : "词典中没有找到这个词";
+    }
+    
+    _panel_y = touchY < PAGE_CONTENT_HEIGHT / 2 ? PAGE_CONTENT_HEIGHT - DICT_PANEL_HEIGHT - DICT_PANEL_MARGIN
+                                                     : DICT_PANEL_MARGIN;
+    _visible = true;
+    
+    // 只画浮层，EPD 只刷新这一块；关闭时再整页重绘
+    GetHAL().display.setEpdMode(epd_mode_t::epd_text);
+    draw();
+}
+
+void DictionaryPanel::draw()
+{
+    auto& lcd = GetHAL().display;
+    int x = DICT_PANEL_MARGIN;
+    int y = _panel_y;
+    int w = SCREEN_WIDTH - 2 * DICT_PANEL_MARGIN;
+    int h = DICT_PANEL_HEIGHT;
+    
+    lcd.fillRect(x, y, w, h, COLOR_BG);
+    lcd.drawRect(x, y, w, h, COLOR_TEXT);
+    lcd.drawRect(x + 1, y + 1, w - 2, h - 2, COLOR_TEXT);
+    
+    // 词头和词典名
+    lcd.setTextColor(COLOR_TEXT);
+    lcd.setTextDatum(middle_left);
+    lcd.setFont(&fonts::efontCN_24_b);
+    lcd.drawString(_entry.headword.c_str(), x + DICT_TEXT_PADDING, y + DICT_HEADER_HEIGHT / 2);
+    if (!_source.empty()) {
+        lcd.setFont(&fonts::efontCN_14);
+        lcd.setTextColor(COLOR_TEXT_GRAY);
+        lcd.setTextDatum(middle_right);
+        lcd.drawString(_source.c_str(), x + w - DICT_TEXT_PADDING, y + DICT_HEADER_HEIGHT / 2);
+    }
+    lcd.drawFastHLine(x + DICT_TEXT_PADDING, y + DICT_HEADER_HEIGHT, w - 2 * DICT_TEXT_PADDING, COLOR_BORDER);
+    
+    // 释义按 efontCN_16 断行，放不下时最后一行以省略号结尾（悬挂在右边距内）
+    if (!_widths) {
+        _widths.reset(new book::GlyphWidths(efont_small_width));
+    }
+    const std::string& definition = _entry.definition;
+    const uint8_t* data = (const uint8_t*)definition.data();
+    const size_t maxLines = (h - DICT_HEADER_HEIGHT - DICT_FOOTER_HEIGHT - 8) / DICT_LINE_HEIGHT;
+    std::vector<book::TextLine> lines;
+    book::TextLineBreaker breaker(*_widths, w - 2 * DICT_TEXT_PADDING);
+    breaker.reset(0);
+    book::TextLine line;
+    bool truncated = false;
+    size_t pos = 0;
+    while (pos < definition.size() && !truncated) {
+        uint32_t cp;
+        size_t n = book::decode_text_char(book::TextEncoding::Utf8, data + pos, definition.size() - pos, cp);
+        if (n == 0) {
+            cp = book::TEXT_REPLACEMENT_CHAR;
+            n = 1;
+        }
+        if (breaker.push(cp, (uint32_t)pos, (uint32_t)n, line)) {
+            lines.push_back(line);
+            truncated = lines.size() == maxLines && breaker.lineStart() < definition.size();
+        }
+        pos += n;
+    }
+    if (!truncated && lines.size() < maxLines && breaker.finish(line)) {
+        lines.push_back(line);
+    }
+    
+    lcd.setFont(&fonts::efontCN_16);
+    lcd.setTextColor(COLOR_TEXT);
+    lcd.setTextDatum(top_left);
+    int lineY = y + DICT_HEADER_HEIGHT + 8;
+    for (size_t i = 0; i < lines.size() && i < maxLines; i++) {
+        std::string text = definition.substr(lines[i].start, lines[i].end - lines[i].start);
+        if (truncated && i + 1 == maxLines) {
+            text += "…";
+        }
+        lcd.drawString(text.c_str(), x + DICT_TEXT_PADDING, lineY);
+        lineY += DICT_LINE_HEIGHT;
+    }
+    
+    lcd.setFont(&fonts::efontCN_14);
+    lcd.setTextColor(COLOR_TEXT_GRAY);
+    lcd.setTextDatum(middle_center);
+    lcd.drawString("点击任意位置关闭", x + w / 2, y + h - DICT_FOOTER_HEIGHT / 2);
+    
+    // 浮层不属于页面内容，下一页需要重绘这些块
+    _damage(x, y, w, h);
+}
+
+void DictionaryPanel::close()
+{
+    _visible = false;
+    _dictionaries.clear();
+    _loaded = false;
+}
+
+void DictionaryPanel::loadDictionaries()
+{
+    // 阅读期间通过 HTTP 增删或覆盖了词典文件
+    book::FsEvent event;
+    bool changed = false;
+    while (_loaded && book::FsEventBus::getInstance().poll(_events, event)) changed = true;
+    if (changed) {
+        mclog::tagInfo(TAG, "Dictionary directory changed, reopening");
+        _dictionaries.clear();
+        _loaded = false;
+    }
+    
+    if (_loaded) return;
+    _loaded = true;
+    // 先订阅再列目录，列目录期间的改动也不会漏掉
+    book::FsEventBus::getInstance().subscribe(_events, book::DICTIONARY_DIR);
+    
+    DIR* dir = opendir(book::DICTIONARY_DIR);
+    if (!dir) {
+        mclog::tagInfo(TAG, "No dictionary directory {}", book::DICTIONARY_DIR);
+        return;
+    }
+    
+    std::vector<std::string> files;
+    const size_t extLen = strlen(book::DICTIONARY_EXTENSION);
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.' || entry->d_type != DT_REG) continue;
+        std::string name = entry->d_name;
+        if (name.size() > extLen && strcasecmp(name.c_str() + name.size() - extLen, book::DICTIONARY_EXTENSION) == 0) {
+            files.push_back(name);
+        }
+    }
+    closedir(dir);
+    
+    // 按文件名顺序查，同一个词以排在前面的词典为准
+    std::sort(files.begin(), files.end());
+    for (const auto& name : files) {
+        std::string path = std::string(book::DICTIONARY_DIR) + "/" + name;
+        uint32_t start = GetHAL().millis();
+        std::unique_ptr<book::Dictionary> dict(new book::Dictionary());
+        if (!dict->open(path)) {
+            mclog::tagError(TAG, "Failed to open dictionary {}", path);
+            continue;
+        }
+        mclog::tagInfo(TAG, "Dictionary {}: {} entries, {} KB resident ({} ms)", dict->name(),
+                       dict->entryCount(), dict->memoryBytes() / 1024, GetHAL().millis() - start);
+        _dictionaries.push_back(std::move(dict));
+    }
+}
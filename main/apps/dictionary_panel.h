@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "dictionary.h"
+#include "fs_events.h"
+#include "text_book.h"
+
+/**
+ * @brief 阅读器的离线词典：/sdcard/dict/ 目录下的 .pdict 文件，第一次查词时打开；释义浮层盖在页面上
+ *
+ * 取词由阅读器完成（按住位置起的一段文字），这里只负责查词和画浮层。
+ * 浮层画过的区域通过 DamageFn 通知阅读器，分块页面下一页时重绘这些块。
+ */
+class DictionaryPanel {
+public:
+    using DamageFn = std::function<void(int x, int y, int w, int h)>;
+
+    explicit DictionaryPanel(DamageFn damage) : _damage(std::move(damage))
+    {
+    }
+
+    /**
+     * @brief 查词并弹出浮层；没有命中也弹出，说明取到的字和原因
+     * @param text 按住位置起的一段文字
+     * @param touchY 按住位置，浮层放在另一半屏
+     */
+    void lookup(const std::string& text, int touchY);
+    /**
+     * @brief 画出浮层（整页重绘时调用）
+     */
+    void draw();
+
+    bool visible() const
+    {
+        return _visible;
+    }
+    void hide()
+    {
+        _visible = false;
+    }
+    /**
+     * @brief 关闭所有词典，下次查词时重新打开
+     */
+    void close();
+
+private:
+    DamageFn _damage;
+    std::vector<std::unique_ptr<book::Dictionary>> _dictionaries;
+    bool _loaded = false;
+    book::FsSubscription _events;                // 打开词典后 /sdcard/dict 的改动，下次查词时重新打开
+    bool _visible = false;
+    int _panel_y = 0;                            // 浮层避开按住的位置
+    std::string _source;                         // 命中的词典名
+    book::DictionaryEntry _entry;
+    std::unique_ptr<book::GlyphWidths> _widths;  // 释义排版（efontCN_16）
+
+    void loadDictionaries();
+};
@@ -0,0 +1,181 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "reader_ink.h"
+#include "bookshelf_ui.h"
+#include "hal.h"
+#include <mooncake_log.h>
+#include <algorithm>
+
+static const char* TAG = "ReaderInk";
+
+static constexpr uint8_t INK_PEN_WIDTH = 3;  // 笔宽 3px
+
+bool ReaderInk::open(const std::string& path)
+{
+    close();
+    uint32_t start = GetHAL().millis();
+    if (!_store.open(path)) {
+        mclog::tagError(TAG, "Failed to open {}", path);
+        return false;
+    }
+    if (_store.fileBytes() > 0) {
+        mclog::tagInfo(TAG, "Ink: {} bytes ({} ms)", (uint32_t)_store.fileBytes(), GetHAL().millis() - start);
+    }
+    return true;
+}
+
+void ReaderInk::close()
+{
+    if (_batcher.active()) {
+        endStroke();
+    }
+    _active = false;
+    _store.close();
+    _strokes.clear();
+    _key = UINT32_MAX;
+}
+
+void ReaderInk::setActive(bool active)
+{
+    if (active == _active) return;
+    _active = active;
+
+    if (active) {
+        _push_latency.clear();
+        _panel_latency.clear();
+        return;
+    }
+
+    if (_panel_latency.count() > 0) {
+        mclog::tagInfo(TAG,
+                       "Ink session: {} strokes, touch->push p50 {} ms p99 {} ms, touch->panel p50 {} ms p99 {} ms max {} ms",
+                       _panel_latency.count(), _push_latency.percentile(50), _push_latency.percentile(99),
+                       _panel_latency.percentile(50), _panel_latency.percentile(99), _panel_latency.max());
+    }
+}
+
+void ReaderInk::draw(uint32_t pageKey)
+{
+    if (!_store.isOpen()) return;
+
+    if (pageKey != _key) {
+        _key = pageKey;
+        _strokes.clear();
+        if (_store.strokeCount(pageKey) > 0 && !_store.loadPage(pageKey, _strokes)) {
+            mclog::tagError(TAG, "Failed to load ink for page {}", pageKey);
+        }
+    }
+
+    auto& lcd = GetHAL().display;
+    for (const auto& stroke : _strokes) {
+        if (stroke.points.empty()) continue;
+        float radius = stroke.width / 2.0f;
+        const auto& points = stroke.points;
+        if (points.size() == 1) {
+            lcd.fillCircle(points[0].x, points[0].y, stroke.width / 2, COLOR_TEXT);
+        }
+        for (size_t i = 1; i < points.size(); i++) {
+            lcd.drawWideLine(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y, radius, COLOR_TEXT);
+        }
+
+        // 笔迹不属于页面内容，下一页需要重绘这些块
+        book::InkRect rect = book::ink_stroke_bounds(stroke);
+        _damage(rect.x, rect.y, rect.w, rect.h);
+    }
+}
+
+bool ReaderInk::handleTouch(const m5::Touch_Class::touch_detail_t& touch, uint32_t pageKey)
+{
+    // 书写中每次主循环取一次触摸：新采样点加入当前一批，到期且面板空闲时输出
+    if (_batcher.active()) {
+        uint32_t now = GetHAL().millis();
+        if (touch.isPressed()) {
+            book::InkPoint point;
+            point.x = (int16_t)touch.x;
+            point.y = (int16_t)std::min<int>(touch.y, PAGE_CONTENT_HEIGHT - 1);
+            _batcher.add(point, now);
+            _last_sample = now;
+        }
+        if (_batcher.due(now) && !GetHAL().display.displayBusy()) {
+            flushBatch();
+        }
+        if (!touch.isPressed()) {
+            endStroke();
+        }
+        return true;
+    }
+
+    if (touch.y >= PAGE_CONTENT_HEIGHT) return false;
+
+    // 落笔：第一个点立即画出
+    if (touch.wasPressed()) {
+        book::InkPoint point;
+        point.x = (int16_t)touch.x;
+        point.y = (int16_t)touch.y;
+        _last_sample = GetHAL().millis();
+        _stroke_key = pageKey;
+        _batcher.begin(point, _last_sample, INK_PEN_WIDTH);
+        flushBatch();
+    }
+    // 内容区的点击、长按不再翻页或查词
+    return true;
+}
+
+void ReaderInk::flushBatch()
+{
+    book::InkRect rect;
+    uint32_t oldest = 0;
+    _batcher.take(_segments, rect, oldest);
+    if (_segments.empty()) return;
+
+    // 一批线段在一次 startWrite / endWrite 之间画完，面板只刷新它们的包围盒
+    auto& lcd = GetHAL().display;
+    float radius = INK_PEN_WIDTH / 2.0f;
+    lcd.setEpdMode(epd_mode_t::epd_fastest);
+    lcd.startWrite();
+    for (const auto& segment : _segments) {
+        if (segment.a.x == segment.b.x && segment.a.y == segment.b.y) {
+            lcd.fillCircle(segment.a.x, segment.a.y, INK_PEN_WIDTH / 2, COLOR_TEXT);
+        } else {
+            lcd.drawWideLine(segment.a.x, segment.a.y, segment.b.x, segment.b.y, radius, COLOR_TEXT);
+        }
+    }
+    lcd.endWrite();
+
+    _push_latency.add(GetHAL().millis() - oldest);
+    _damage(rect.x, rect.y, rect.w, rect.h);
+}
+
+void ReaderInk::endStroke()
+{
+    if (_batcher.pending()) {
+        flushBatch();
+    }
+    book::InkStroke stroke = _batcher.finish();
+
+    // 等最后一批刷新完：抬笔前最后一个采样点到墨迹出现在面板上的完整延迟
+    GetHAL().display.waitDisplay();
+    uint32_t panelMs = GetHAL().millis() - _last_sample;
+    _panel_latency.add(panelMs);
+
+    size_t points = stroke.points.size();
+    if (!_store.append(_stroke_key, stroke)) {
+        mclog::tagError(TAG, "Failed to save ink stroke");
+    } else if (_stroke_key == _key) {
+        _strokes.push_back(std::move(stroke));
+    }
+    mclog::tagInfo(TAG, "Ink stroke: {} points, touch->push p50 {} ms max {} ms, touch->panel {} ms", points,
+                   _push_latency.percentile(50), _push_latency.max(), panelMs);
+}
+
+bool ReaderInk::undo(uint32_t pageKey)
+{
+    if (!_store.undo(pageKey)) return false;
+    if (pageKey == _key && !_strokes.empty()) {
+        _strokes.pop_back();
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <M5GFX.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ink_layer.h"
+
+/**
+ * @brief 阅读器的批注：批注模式中内容区的触摸用来书写，笔迹按页保存在 ink.bin（纯文本书籍为 {正文}.ink）
+ *
+ * 页键由阅读器给出：分页的书为 章节 << 16 | 页码，纯文本书籍为页首偏移。
+ * 笔迹画在页面之上，画过的区域通过 DamageFn 通知阅读器，分块页面下一页时重绘这些块。
+ */
+class ReaderInk {
+public:
+    using DamageFn = std::function<void(int x, int y, int w, int h)>;
+
+    explicit ReaderInk(DamageFn damage) : _damage(std::move(damage))
+    {
+    }
+
+    /**
+     * @brief 打开一本书的笔迹文件；文件不存在时第一次写入时创建
+     */
+    bool open(const std::string& path);
+    /**
+     * @brief 结束书写中的一笔、退出批注模式并关闭文件
+     */
+    void close();
+
+    bool active() const
+    {
+        return _active;
+    }
+    /**
+     * @brief 进入或退出批注模式；退出时输出本次书写的延迟统计
+     */
+    void setActive(bool active);
+
+    /**
+     * @brief 正在书写（落笔到抬笔之间）
+     */
+    bool writing() const
+    {
+        return _batcher.active();
+    }
+
+    /**
+     * @brief 画出一页的笔迹，页键变化时重新读取
+     */
+    void draw(uint32_t pageKey);
+    /**
+     * @brief 批注模式中的触摸
+     * @return 触摸已被书写消耗时返回 true；底部栏的触摸返回 false
+     */
+    bool handleTouch(const m5::Touch_Class::touch_detail_t& touch, uint32_t pageKey);
+    /**
+     * @brief 撤销该页最后一笔
+     * @return 有笔画被撤销、需要重绘页面时返回 true
+     */
+    bool undo(uint32_t pageKey);
+
+private:
+    DamageFn _damage;
+    bool _active = false;
+    book::InkStore _store;
+    book::InkBatcher _batcher;
+    std::vector<book::InkStroke> _strokes;    // 当前页的笔画
+    uint32_t _key = UINT32_MAX;               // _strokes 所属的页键
+    uint32_t _stroke_key = 0;                 // 书写中的一笔所在的页键
+    std::vector<book::InkSegment> _segments;  // 输出一批时复用
+    uint32_t _last_sample = 0;                // 本笔最后一个采样点的时间
+    book::InkLatencyStats _push_latency;      // 采样 → 所在的一批推送完成
+    book::InkLatencyStats _panel_latency;     // 抬笔前最后一个采样点 → 面板刷新完成
+
+    void flushBatch();
+    void endStroke();
+};
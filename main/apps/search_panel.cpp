@@ -0,0 +1,537 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "search_panel.h"
+#include "bookshelf_ui.h"
+#include "hal.h"
+#include "text_book.h"
+#include <mooncake_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+static const char* TAG = "SearchPanel";
+
+// 检索界面：搜索框 | 结果 | 联想字 | 键盘
+static constexpr int SEARCH_BOX_Y = LIST_HEADER_HEIGHT + 10;
+static constexpr int SEARCH_BOX_H = 56;
+static constexpr int SEARCH_RESULT_Y = SEARCH_BOX_Y + SEARCH_BOX_H + 10;
+static constexpr int SEARCH_RESULT_H = 56;
+static constexpr int SEARCH_RESULT_COUNT = 6;
+static constexpr int SEARCH_CHAR_Y = SEARCH_RESULT_Y + SEARCH_RESULT_COUNT * SEARCH_RESULT_H + 12;
+static constexpr int SEARCH_CHAR_SIZE = 52;
+static constexpr int SEARCH_CHAR_COLS = 10;
+static constexpr int SEARCH_CHAR_ROWS = 2;
+static constexpr int SEARCH_KEY_Y = SEARCH_CHAR_Y + SEARCH_CHAR_ROWS * SEARCH_CHAR_SIZE + 16;
+static constexpr int SEARCH_KEY_W = 52;
+static constexpr int SEARCH_KEY_H = 64;
+static constexpr int SEARCH_KEY_MARGIN = 4;
+static constexpr int SEARCH_BACK_X = SCREEN_WIDTH - 100;  // 返回按钮与书架标题栏的返回按钮重合
+static constexpr int SEARCH_BACK_Y = 10;
+static constexpr int SEARCH_BACK_W = 80;
+static constexpr int SEARCH_BACK_H = 50;
+static const char* SEARCH_KEY_ROWS[] = {"1234567890", "qwertyuiop", "asdfghjkl", "zxcvbnm"};
+
+// 全文检索
+static constexpr int FULLTEXT_TASK_STACK_SIZE = 1024 * 8;
+static constexpr int FULLTEXT_TASK_PRIORITY = 1;  // 同缩略图任务，每章之后主动让出
+
+namespace {
+
+struct SearchKey {
+    int x, y, w;
+    std::string label;
+    char value;  // 输入的字符；退格和清空为 0
+};
+
+}  // namespace
+
+// 键盘：数字、字母三行，退格在第四行末尾占两格，最后一行为空格和清空
+static std::vector<SearchKey> search_keys()
+{
+    std::vector<SearchKey> keys;
+    int startX = (SCREEN_WIDTH - 10 * SEARCH_KEY_W) / 2;
+    int y = SEARCH_KEY_Y;
+    for (int row = 0; row < 4; row++) {
+        int x = startX + (row >= 2 ? SEARCH_KEY_W / 2 : 0);
+        for (const char* c = SEARCH_KEY_ROWS[row]; *c; c++) {
+            keys.push_back({x, y, SEARCH_KEY_W, std::string(1, *c), *c});
+            x += SEARCH_KEY_W;
+        }
+        if (row == 3) keys.push_back({x, y, SEARCH_KEY_W * 2, "退格", 0});
+        y += SEARCH_KEY_H;
+    }
+    keys.push_back({startX, y, SEARCH_KEY_W * 6, "空格", ' '});
+    keys.push_back({startX + SEARCH_KEY_W * 6, y, SEARCH_KEY_W * 4, "清空", 0});
+    return keys;
+}
+
+void SearchPanel::enterTitleSearch()
+{
+    if (!_title_synced) {
+        syncTitleIndex();
+        _title_synced = true;
+    }
+    runTitleSearch();
+}
+
+void SearchPanel::syncTitleIndex()
+{
+    uint32_t start = GetHAL().millis();
+    std::string path = std::string("/sdcard/books/") + book::TITLE_INDEX_FILE_NAME;
+    
+    // 书名或作者变化的书重新加入，已不在书架上的删除；没有变化时不写文件
+    bool loaded = _title_index.load(path);
+    std::vector<std::string> ids;
+    ids.reserve(_books.size());
+    for (const auto& book : _books) {
+        _title_index.update(book.id, book.title, book.author);
+        ids.push_back(book.id);
+    }
+    _title_index.prune(ids);
+    if (_title_index.dirty() && !_title_index.save(path)) {
+        mclog::tagError(TAG, "Failed to save {}", path);
+    }
+    mclog::tagInfo(TAG, "Title index: {} books ({}), {} KB, {} ms", _title_index.size(),
+                   loaded ? "loaded" : "rebuilt", _title_index.memoryBytes() / 1024, GetHAL().millis() - start);
+}
+
+int SearchPanel::findBook(const std::string& id) const
+{
+    for (size_t i = 0; i < _books.size(); i++) {
+        if (_books[i].id == id) return (int)i;
+    }
+    return -1;
+}
+
+void SearchPanel::runTitleSearch()
+{
+    uint32_t start = GetHAL().millis();
+    _title_index.search(_query, SEARCH_RESULT_COUNT, SEARCH_CHAR_COLS * SEARCH_CHAR_ROWS, _title_result);
+    mclog::tagInfo(TAG, "Search '{}': {} results in {} ms", _query, _title_result.total, GetHAL().millis() - start);
+}
+
+void SearchPanel::draw(bool fastMode)
+{
+    auto& lcd = GetHAL().display;
+    
+    if (fastMode) {
+        // 输入时只重绘搜索框、结果和联想字，键盘不变
+        lcd.setEpdMode(epd_mode_t::epd_fastest);
+        lcd.fillRect(0, SEARCH_BOX_Y, SCREEN_WIDTH, SEARCH_KEY_Y - SEARCH_BOX_Y, COLOR_BG);
+    } else {
+        lcd.setEpdMode(epd_mode_t::epd_quality);
+        lcd.fillScreen(COLOR_BG);
+        
+        // 标题栏
+        lcd.setFont(&fonts::efontCN_24_b);
+        lcd.setTextDatum(middle_left);
+        lcd.setTextColor(COLOR_TEXT);
+        lcd.drawString(_fulltext_mode ? "全文搜索" : "搜索", 20, LIST_HEADER_HEIGHT / 2);
+        
+        lcd.fillRoundRect(SEARCH_BACK_X, SEARCH_BACK_Y, SEARCH_BACK_W, SEARCH_BACK_H, 10, COLOR_BTN);
+        lcd.setFont(&fonts::efontCN_16_b);
+        lcd.setTextDatum(middle_center);
+        lcd.drawString("返回", SEARCH_BACK_X + SEARCH_BACK_W / 2, SEARCH_BACK_Y + SEARCH_BACK_H / 2);
+        lcd.drawLine(0, LIST_HEADER_HEIGHT, SCREEN_WIDTH, LIST_HEADER_HEIGHT, COLOR_BORDER);
+        
+        // 键盘
+        lcd.setFont(&fonts::efontCN_24_b);
+        for (const auto& key : search_keys()) {
+            lcd.fillRect(key.x + SEARCH_KEY_MARGIN / 2, key.y + SEARCH_KEY_MARGIN / 2, key.w - SEARCH_KEY_MARGIN,
+                         SEARCH_KEY_H - SEARCH_KEY_MARGIN, COLOR_BTN);
+            lcd.drawString(key.label.c_str(), key.x + key.w / 2, key.y + SEARCH_KEY_H / 2);
+        }
+    }
+    
+    // 搜索框：查询串和匹配数
+    lcd.drawRect(20, SEARCH_BOX_Y, SCREEN_WIDTH - 40, SEARCH_BOX_H, COLOR_BORDER);
+    lcd.setFont(&fonts::efontCN_24_b);
+    lcd.setTextDatum(middle_left);
+    lcd.setTextColor(_query.empty() ? COLOR_TEXT_GRAY : COLOR_TEXT);
+    const char* placeholder = _fulltext_mode ? "正文中的字词" : "书名或作者";
+    lcd.drawString(_query.empty() ? placeholder : _query.c_str(), 34, SEARCH_BOX_Y + SEARCH_BOX_H / 2);
+    if (!_query.empty() && (!_fulltext_mode || _index.isOpen())) {
+        char count[32];
+        if (!_fulltext_mode) {
+            snprintf(count, sizeof(count), "%d 本", (int)_title_result.total);
+        } else if (_next >= _pages.size()) {
+            snprintf(count, sizeof(count), "%d 页", (int)_hits.size());
+        } else {
+            // 候选页尚未全部确认，实际页数不超过候选页数
+            snprintf(count, sizeof(count), "≤%d 页", (int)_pages.size());
+        }
+        lcd.setFont(&fonts::efontCN_16_b);
+        lcd.setTextDatum(middle_right);
+        lcd.setTextColor(COLOR_TEXT_GRAY);
+        lcd.drawString(count, SCREEN_WIDTH - 34, SEARCH_BOX_Y + SEARCH_BOX_H / 2);
+    }
+    
+    // 结果：书名 + 作者（全文模式见 drawFulltextResults）
+    int y = SEARCH_RESULT_Y;
+    lcd.setTextDatum(top_left);
+    for (size_t i = 0; !_fulltext_mode && i < _title_result.ids.size(); i++) {
+        int index = findBook(_title_result.ids[i]);
+        if (index < 0) continue;
+        lcd.setFont(&fonts::efontCN_16_b);
+        lcd.setTextColor(COLOR_TEXT);
+        lcd.drawString(_books[index].title.c_str(), 30, y + 8);
+        lcd.setFont(&fonts::efontCN_14);
+        lcd.setTextColor(COLOR_TEXT_GRAY);
+        lcd.drawString(_books[index].author.c_str(), 30, y + 32);
+        lcd.drawLine(20, y + SEARCH_RESULT_H - 1, SCREEN_WIDTH - 20, y + SEARCH_RESULT_H - 1, COLOR_BORDER);
+        y += SEARCH_RESULT_H;
+    }
+    if (_fulltext_mode) {
+        drawFulltextResults();
+    } else if (!_query.empty() && _title_result.total == 0) {
+        lcd.setFont(&fonts::efontCN_16_b);
+        lcd.setTextColor(COLOR_TEXT_GRAY);
+        lcd.drawString("没有匹配的书", 30, SEARCH_RESULT_Y + 8);
+    }
+    
+    // 联想字：没有输入法，中文靠点选书库中出现过的字输入；全文模式为全书最常见的字
+    const std::vector<uint32_t>& nextChars = _fulltext_mode ? _index.topChars() : _title_result.nextChars;
+    size_t charCount = std::min(nextChars.size(), (size_t)(SEARCH_CHAR_COLS * SEARCH_CHAR_ROWS));
+    lcd.setFont(&fonts::efontCN_24_b);
+    lcd.setTextDatum(middle_center);
+    lcd.setTextColor(COLOR_TEXT);
+    int startX = (SCREEN_WIDTH - SEARCH_CHAR_COLS * SEARCH_CHAR_SIZE) / 2;
+    for (size_t i = 0; i < charCount; i++) {
+        int cx = startX + (int)(i % SEARCH_CHAR_COLS) * SEARCH_CHAR_SIZE;
+        int cy = SEARCH_CHAR_Y + (int)(i / SEARCH_CHAR_COLS) * SEARCH_CHAR_SIZE;
+        char utf8[5] = {0};
+        book::encode_utf8(nextChars[i], utf8);
+        lcd.drawRect(cx + 2, cy + 2, SEARCH_CHAR_SIZE - 4, SEARCH_CHAR_SIZE - 4, COLOR_BORDER);
+        lcd.drawString(utf8, cx + SEARCH_CHAR_SIZE / 2, cy + SEARCH_CHAR_SIZE / 2);
+    }
+}
+
+SearchPanel::Action SearchPanel::handleTouch()
+{
+    auto touch = GetHAL().getTouchDetail();
+    Action action;
+    
+    // 全文结果：上滑下一屏，下滑上一屏
+    if (_fulltext_mode && touch.wasFlicked()) {
+        int dy = touch.distanceY();
+        if (abs(dy) <= abs(touch.distanceX())) return action;
+        size_t first = _first;
+        if (dy < 0) {
+            fillHits(_first + SEARCH_RESULT_COUNT * 2);
+            if (_first + SEARCH_RESULT_COUNT < _hits.size()) _first += SEARCH_RESULT_COUNT;
+        } else {
+            _first -= std::min(_first, (size_t)SEARCH_RESULT_COUNT);
+        }
+        if (_first != first) draw(true);
+        return action;
+    }
+    
+    if (!touch.wasClicked()) return action;
+    
+    int x = touch.x;
+    int y = touch.y;
+    
+    // 返回书架列表；全文模式返回阅读
+    if (x >= SEARCH_BACK_X && x < SEARCH_BACK_X + SEARCH_BACK_W &&
+        y >= SEARCH_BACK_Y && y < SEARCH_BACK_Y + SEARCH_BACK_H) {
+        action.type = Action::BACK;
+        return action;
+    }
+    
+    // 点击结果打开图书，全文模式跳到命中的页面
+    if (y >= SEARCH_RESULT_Y && y < SEARCH_RESULT_Y + SEARCH_RESULT_COUNT * SEARCH_RESULT_H) {
+        size_t row = (size_t)((y - SEARCH_RESULT_Y) / SEARCH_RESULT_H);
+        if (_fulltext_mode) {
+            if (_first + row < _hits.size()) {
+                action.type = Action::OPEN_HIT;
+                action.hit = _hits[_first + row];
+            }
+        } else if (row < _title_result.ids.size()) {
+            action.book = findBook(_title_result.ids[row]);
+            if (action.book >= 0) action.type = Action::OPEN_BOOK;
+        }
+        return action;
+    }
+    
+    std::string query = _query;
+    
+    // 联想字
+    const std::vector<uint32_t>& nextChars = _fulltext_mode ? _index.topChars() : _title_result.nextChars;
+    int startX = (SCREEN_WIDTH - SEARCH_CHAR_COLS * SEARCH_CHAR_SIZE) / 2;
+    if (y >= SEARCH_CHAR_Y && y < SEARCH_CHAR_Y + SEARCH_CHAR_ROWS * SEARCH_CHAR_SIZE && x >= startX) {
+        size_t col = (size_t)((x - startX) / SEARCH_CHAR_SIZE);
+        size_t row = (size_t)((y - SEARCH_CHAR_Y) / SEARCH_CHAR_SIZE);
+        size_t i = row * SEARCH_CHAR_COLS + col;
+        if (col < (size_t)SEARCH_CHAR_COLS && i < nextChars.size()) {
+            char utf8[4];
+            query.append(utf8, book::encode_utf8(nextChars[i], utf8));
+        }
+    }
+    
+    // 键盘
+    if (y >= SEARCH_KEY_Y) {
+        for (const auto& key : search_keys()) {
+            if (x < key.x || x >= key.x + key.w || y < key.y || y >= key.y + SEARCH_KEY_H) continue;
+            if (key.value) {
+                query += key.value;
+            } else if (key.label == "清空") {
+                query.clear();
+            } else {
+                // 退格：删除最后一个 UTF-8 字符
+                while (!query.empty() && ((uint8_t)query.back() & 0xC0) == 0x80) query.pop_back();
+                if (!query.empty()) query.pop_back();
+            }
+            break;
+        }
+    }
+    
+    if (query != _query) {
+        _query = query;
+        if (_fulltext_mode) {
+            runFulltextSearch();
+        } else {
+            runTitleSearch();
+        }
+        draw(true);
+    }
+    return action;
+}
+
+void SearchPanel::startIndexJob(int bookIndex)
+{
+    closeFulltext();
+    _book = bookIndex;
+    if (_book < 0) return;
+    const LibraryBook& book = _books[_book];
+    if (!book.textLayer) return;
+    
+    // 没有文字层的章节在生成时跳过
+    book::FulltextSource source;
+    source.bookDir = "/sdcard/books/" + book.id;
+    for (const auto& sec : book.sections) {
+        source.sections.push_back(sec.index);
+    }
+    
+    if (!_builder.begin(source)) {
+        mclog::tagError(TAG, "Full-text index: {}", _builder.lastError());
+        return;
+    }
+    if (_builder.done()) {
+        _builder.end();
+        return;
+    }
+    
+    mclog::tagInfo(TAG, "Full-text index: {} sections, generating in background",
+                   _builder.total());
+    
+    _cancel = false;
+    _progress = 0;
+    _running = true;
+    BaseType_t ok = xTaskCreate(
+        [](void* arg) {
+            SearchPanel* self = (SearchPanel*)arg;
+            self->runIndexJob();
+            self->_running = false;
+            vTaskDelete(NULL);
+        },
+        "fulltext", FULLTEXT_TASK_STACK_SIZE, this, FULLTEXT_TASK_PRIORITY, NULL);
+    if (ok != pdPASS) {
+        mclog::tagError(TAG, "Failed to start full-text task");
+        _builder.end();
+        _running = false;
+    }
+}
+
+void SearchPanel::stopIndexJob()
+{
+    // 任务在章与章之间检查取消标志；最后的归并不可中断，中断后下次打开从头生成
+    _cancel = true;
+    while (_running) {
+        GetHAL().delay(5);
+    }
+}
+
+void SearchPanel::runIndexJob()
+{
+    uint32_t start = GetHAL().millis();
+    
+    while (!_cancel && _builder.step()) {
+        _progress = _builder.processed();
+        // 每章之后让出 CPU，翻页和触摸优先
+        vTaskDelay(1);
+    }
+    
+    const book::FulltextBuildStats& stats = _builder.stats();
+    if (!_builder.lastError().empty()) {
+        mclog::tagError(TAG, "Full-text index: {}", _builder.lastError());
+    } else if (_builder.done()) {
+        mclog::tagInfo(TAG, "Full-text index: {} pages, {} keys, {} KB, {} runs in {} ms",
+                       stats.pages, stats.keys, (uint32_t)(stats.bytes / 1024), stats.runs,
+                       GetHAL().millis() - start);
+    } else {
+        mclog::tagInfo(TAG, "Full-text index: stopped at section {}/{}", _builder.processed(), _builder.total());
+    }
+    _builder.end();
+}
+
+void SearchPanel::closeFulltext()
+{
+    stopIndexJob();
+    _index.close();
+    _layer.clear();
+    _layer_section = -1;
+    _fulltext_query.clear();
+    _pages.clear();
+    _hits.clear();
+    _next = 0;
+    _first = 0;
+    
+    // 书名检索与全文检索共用查询串
+    if (_fulltext_mode) {
+        _fulltext_mode = false;
+        _query.clear();
+    }
+}
+
+void SearchPanel::enterFulltextSearch()
+{
+    // 同一本书再次进入时保留上次的查询和结果，便于逐个查看
+    if (!_fulltext_mode) {
+        _fulltext_mode = true;
+        _query.clear();
+        runFulltextSearch();
+    }
+}
+
+bool SearchPanel::openIndex()
+{
+    if (_index.isOpen()) return true;
+    if (_running || _book < 0) return false;
+    
+    std::string path = "/sdcard/books/" + _books[_book].id + "/" + book::FULLTEXT_INDEX_FILE_NAME;
+    if (!_index.open(path)) return false;
+    mclog::tagInfo(TAG, "Full-text index: {} pages, {} KB in memory", _index.pageCount(), _index.memoryBytes() / 1024);
+    return true;
+}
+
+void SearchPanel::runFulltextSearch()
+{
+    _pages.clear();
+    _hits.clear();
+    _next = 0;
+    _first = 0;
+    book::fold_search_query(_query, _fulltext_query);
+    if (!openIndex() || _fulltext_query.empty()) return;
+    
+    // 索引只给出候选页，一屏的结果在文字层中确认，其余翻屏时再确认
+    uint32_t start = GetHAL().millis();
+    uint32_t reads = _index.reads();
+    if (!_index.search(_fulltext_query, _pages)) {
+        mclog::tagError(TAG, "Full-text search failed");
+        _pages.clear();
+        return;
+    }
+    uint32_t lookup = GetHAL().millis() - start;
+    fillHits(SEARCH_RESULT_COUNT);
+    mclog::tagInfo(TAG, "Full-text '{}': {} candidate pages ({} reads, {} ms), first screen in {} ms",
+                   _query, _pages.size(), _index.reads() - reads, lookup, GetHAL().millis() - start);
+}
+
+void SearchPanel::poll()
+{
+    if (!_fulltext_mode || _index.isOpen()) return;
+    int total = (int)_books[_book].sections.size();
+    int step = _running ? (total > 0 ? _progress * 10 / total : 0) : -2;
+    if (step != _shown) {
+        runFulltextSearch();
+        draw(true);
+    }
+}
+
+void SearchPanel::fillHits(size_t count)
+{
+    if (_book < 0) return;
+    const LibraryBook& book = _books[_book];
+    
+    // 候选页按页序即章节顺序排列，同一章的文字层只读一次
+    while (_hits.size() < count && _next < _pages.size()) {
+        book::FulltextPageRef ref = _index.pageRef(_pages[_next++]);
+        const book::TextLayer* layer = sectionLayer(book, ref.section);
+        
+        book::FulltextHit hit;
+        if (layer && book::find_page_matches(*layer, ref.page, _fulltext_query, hit)) {
+            hit.section = ref.section;
+            hit.page = ref.page;
+            _hits.push_back(std::move(hit));
+        }
+    }
+}
+
+void SearchPanel::drawFulltextResults()
+{
+    auto& lcd = GetHAL().display;
+    const LibraryBook& book = _books[_book];
+    lcd.setTextDatum(top_left);
+    
+    // 索引生成中或不可用
+    int total = (int)book.sections.size();
+    _shown = _running ? (total > 0 ? _progress * 10 / total : 0) : -2;
+    if (!openIndex()) {
+        char status[64];
+        if (_running) {
+            snprintf(status, sizeof(status), "正在建立全文索引（%d/%d 章）", _progress.load(), total);
+        } else {
+            snprintf(status, sizeof(status), "全文索引不可用");
+        }
+        lcd.setFont(&fonts::efontCN_16_b);
+        lcd.setTextColor(COLOR_TEXT_GRAY);
+        lcd.drawString(status, 30, SEARCH_RESULT_Y + 8);
+        return;
+    }
+    
+    // 每条结果：章节标题 · 页码 · 本页命中次数，下一行为第一处命中的上下文
+    int y = SEARCH_RESULT_Y;
+    size_t end = std::min(_hits.size(), _first + SEARCH_RESULT_COUNT);
+    for (size_t i = _first; i < end; i++) {
+        const book::FulltextHit& hit = _hits[i];
+        const char* title = "";
+        for (const auto& sec : book.sections) {
+            if (sec.index == hit.section) title = sec.title.c_str();
+        }
+        char head[192];
+        snprintf(head, sizeof(head), "%s · 第%d页 · %d处", title, hit.page, hit.matches);
+        lcd.setFont(&fonts::efontCN_16_b);
+        lcd.setTextColor(COLOR_TEXT);
+        lcd.drawString(head, 30, y + 8);
+        lcd.setFont(&fonts::efontCN_14);
+        lcd.setTextColor(COLOR_TEXT_GRAY);
+        lcd.drawString(hit.snippet.c_str(), 30, y + 32);
+        lcd.drawLine(20, y + SEARCH_RESULT_H - 1, SCREEN_WIDTH - 20, y + SEARCH_RESULT_H - 1, COLOR_BORDER);
+        y += SEARCH_RESULT_H;
+    }
+    if (!_query.empty() && _hits.empty()) {
+        lcd.setFont(&fonts::efontCN_16_b);
+        lcd.setTextColor(COLOR_TEXT_GRAY);
+        lcd.drawString("没有找到", 30, SEARCH_RESULT_Y + 8);
+    }
+}
+
+const book::TextLayer* SearchPanel::sectionLayer(const LibraryBook& book, int section)
+{
+    if (section != _layer_section) {
+        char path[256];
+        snprintf(path, sizeof(path), "/sdcard/books/%s/sections/%03d/%s", book.id.c_str(), section,
+                 book::TEXT_LAYER_FILE_NAME);
+        _layer_section = section;
+        if (!_layer.load(path)) {
+            mclog::tagError(TAG, "Failed to load {}", path);
+            return nullptr;
+        }
+    }
+    return &_layer;
+}
@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "title_index.h"
+#include "fulltext_index.h"
+#include "book_library.h"
+
+/**
+ * @brief 检索界面：书架的书名 / 作者检索，以及阅读时对当前书的全文检索
+ *
+ * 没有输入法，中文靠点选联想字输入。两种模式共用查询串、结果区和键盘；
+ * 全文模式的 search.idx 由打开书籍后启动的后台任务生成，生成期间显示进度。
+ * 只在界面任务中使用，点击结果后的跳转由书架完成。
+ */
+class SearchPanel {
+public:
+    /**
+     * @brief 检索界面上的触摸结果
+     */
+    struct Action {
+        enum Type {
+            NONE,
+            BACK,       // 返回书架；全文模式返回阅读
+            OPEN_BOOK,  // 打开 book 指向的书
+            OPEN_HIT,   // 跳到 hit 所在的页面
+        };
+        Type type = NONE;
+        int book  = -1;
+        book::FulltextHit hit;
+    };
+
+    /**
+     * @brief 进入书名检索，第一次进入时按书架增量更新 books/.title_index
+     */
+    void enterTitleSearch();
+    /**
+     * @brief 进入当前书的全文检索；同一本书再次进入时保留上次的查询和结果，便于逐个查看
+     */
+    void enterFulltextSearch();
+    bool fulltextMode() const
+    {
+        return _fulltext_mode;
+    }
+
+    /**
+     * @brief 打开书籍时调用：有文字层的书在后台生成全文索引，已有有效索引时不启动任务
+     */
+    void startIndexJob(int bookIndex);
+    /**
+     * @brief 返回书架或换书时停止任务、关闭索引、清空结果
+     */
+    void closeFulltext();
+
+    /**
+     * @brief 全文索引生成中：进度每过 10% 或生成结束时刷新结果区
+     */
+    void poll();
+    void draw(bool fastMode = false);
+    Action handleTouch();
+
+    /**
+     * @brief 一章的文字层，与全文检索的结果确认共用最近读入的一章
+     * @return 读取失败时返回 nullptr
+     */
+    const book::TextLayer* sectionLayer(const LibraryBook& book, int section);
+
+private:
+    std::vector<LibraryBook>& _books = BookLibrary::getInstance().books();
+    std::string _query;
+
+    // 书名 / 作者检索：books/.title_index
+    book::TitleIndex _title_index;
+    bool _title_synced = false;
+    book::TitleSearchResult _title_result;
+
+    // 全文检索：search.idx 由后台任务生成，检索当前书
+    int _book = -1;                                // 当前书在书架中的下标
+    book::FulltextIndexBuilder _builder;           // begin() 之后只由后台任务访问
+    book::FulltextIndex _index;
+    std::atomic<bool> _cancel{false};
+    std::atomic<bool> _running{false};
+    std::atomic<int> _progress{0};                 // 已处理的章节数，检索界面显示生成进度
+    int _shown = -1;                               // 检索界面上显示的进度
+    bool _fulltext_mode = false;
+    std::vector<uint32_t> _fulltext_query;         // 归一化后的查询串
+    std::vector<uint32_t> _pages;                  // 候选页序
+    size_t _next = 0;                              // 下一个待确认的候选页
+    std::vector<book::FulltextHit> _hits;          // 已确认的结果，翻屏时按需补充
+    size_t _first = 0;                             // 当前一屏的第一条结果
+    book::TextLayer _layer;                        // 最近确认过的章节的文字层
+    int _layer_section = -1;
+
+    void syncTitleIndex();
+    void runTitleSearch();
+    int findBook(const std::string& id) const;
+
+    void stopIndexJob();
+    void runIndexJob();
+    bool openIndex();               // 任务完成后打开 search.idx
+    void runFulltextSearch();
+    void fillHits(size_t count);    // 按顺序确认候选页，直到有 count 条结果或候选页用完
+    void drawFulltextResults();
+};
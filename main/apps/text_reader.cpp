@@ -0,0 +1,316 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "text_reader.h"
+#include "bookshelf_ui.h"
+#include "hal.h"
+#include "dictionary.h"
+#include <mooncake_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <cstdio>
+
+static const char* TAG = "TextReader";
+
+// 纯文本书籍版面：efontCN_24，行宽 492px，每页 23 行
+static constexpr int TEXT_FONT_SIZE = 24;
+static constexpr int TEXT_MARGIN_X = 24;
+static constexpr int TEXT_MARGIN_TOP = 24;
+static constexpr int TEXT_LINE_HEIGHT = 36;
+static constexpr size_t TEXT_PAGINATE_STEP = 32 * 1024;  // 后台分页每次处理的字节数，之间让出 CPU
+static constexpr int TEXT_TASK_STACK_SIZE = 1024 * 8;
+static constexpr int TEXT_TASK_PRIORITY = 1;
+
+static book::TextLayoutParams text_layout_params()
+{
+    book::TextLayoutParams params;
+    params.lineWidth = SCREEN_WIDTH - 2 * TEXT_MARGIN_X;
+    params.linesPerPage = (PAGE_CONTENT_HEIGHT - 2 * TEXT_MARGIN_TOP) / TEXT_LINE_HEIGHT;
+    params.fontId = TEXT_FONT_SIZE;
+    return params;
+}
+
+int efont_text_width(uint32_t codepoint)
+{
+    lgfx::FontMetrics metrics;
+    fonts::efontCN_24.getDefaultMetric(&metrics);
+    if (codepoint > 0xFFFF || !fonts::efontCN_24.updateFontMetric(&metrics, (uint16_t)codepoint)) {
+        return TEXT_FONT_SIZE / 2;
+    }
+    return metrics.x_advance;
+}
+
+int efont_line_width(const std::string& line)
+{
+    const uint8_t* data = (const uint8_t*)line.data();
+    int width = 0;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        uint32_t cp;
+        size_t n = book::decode_text_char(book::TextEncoding::Utf8, data + pos, line.size() - pos, cp);
+        if (n == 0) {
+            cp = book::TEXT_REPLACEMENT_CHAR;
+            n = 1;
+        }
+        width += efont_text_width(cp);
+        pos += n;
+    }
+    return width;
+}
+
+size_t efont_offset_at(const std::string& line, int x)
+{
+    const uint8_t* data = (const uint8_t*)line.data();
+    int left = 0;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        uint32_t cp;
+        size_t n = book::decode_text_char(book::TextEncoding::Utf8, data + pos, line.size() - pos, cp);
+        if (n == 0) {
+            cp = book::TEXT_REPLACEMENT_CHAR;
+            n = 1;
+        }
+        left += efont_text_width(cp);
+        if (x < left) return pos;
+        pos += n;
+    }
+    return std::string::npos;
+}
+
+void TextReader::open(const LibraryBook& book)
+{
+    startPagination(book);
+    _offset = book.txtOffset < book.txtSize ? book.txtOffset : 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_offset == 0 && !_pages.empty()) {
+            _offset = _pages.front();  // 跳过 BOM
+        }
+    }
+    _history.clear();
+    _lines.clear();
+    _next = _offset;
+}
+
+void TextReader::close()
+{
+    stopPagination();
+    _lines.clear();
+    // 翻页记录从应用 arena 分配，关闭书籍时归还
+    _history = book::ArenaVector<uint32_t>(_history.get_allocator());
+}
+
+void TextReader::startPagination(const LibraryBook& book)
+{
+    stopPagination();
+    
+    if (!_widths) {
+        _widths.reset(new book::GlyphWidths(efont_text_width));
+    }
+    
+    // 打开文本和已有索引在主循环完成，编码和已分页的部分立即可用
+    _paginator.reset(new book::TextPaginator(efont_text_width));
+    bool ok = _paginator->begin(book.txtPath, text_layout_params());
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pages = _paginator->pages();
+        _complete = ok && _paginator->done();
+    }
+    _encoding = _paginator->encoding();
+    
+    if (!ok) {
+        mclog::tagError(TAG, "Text pagination: {}", _paginator->lastError());
+        _paginator.reset();
+        return;
+    }
+    mclog::tagInfo(TAG, "Text book: {}, {} pages indexed ({}/{} bytes){}",
+                   _encoding == book::TextEncoding::Gbk ? "GBK" : "UTF-8", _pages.size(),
+                   _paginator->processed(), _paginator->fileSize(), _complete ? "" : ", paginating");
+    if (_complete) {
+        _paginator.reset();
+        return;
+    }
+    
+    _cancel = false;
+    _running = true;
+    BaseType_t created = xTaskCreate(
+        [](void* arg) {
+            TextReader* self = (TextReader*)arg;
+            self->runPagination();
+            self->_running = false;
+            vTaskDelete(NULL);
+        },
+        "txt_page", TEXT_TASK_STACK_SIZE, this, TEXT_TASK_PRIORITY, NULL);
+    if (created != pdPASS) {
+        mclog::tagError(TAG, "Failed to start pagination task");
+        _paginator.reset();
+        _running = false;
+    }
+}
+
+void TextReader::stopPagination()
+{
+    // 任务在每段文本之后检查取消标志；已写入索引的页首保留，下次打开时继续
+    _cancel = true;
+    while (_running) {
+        GetHAL().delay(5);
+    }
+    _paginator.reset();
+}
+
+void TextReader::runPagination()
+{
+    uint32_t start = GetHAL().millis();
+    uint32_t first = _paginator->processed();
+    
+    bool more = true;
+    while (!_cancel && more) {
+        more = _paginator->step(TEXT_PAGINATE_STEP);
+        
+        // 只追加新的页首；结束时末尾的空页会被去掉，所以先按长度截断
+        const std::vector<uint32_t>& pages = _paginator->pages();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_pages.size() > pages.size()) _pages.resize(pages.size());
+            for (size_t i = _pages.size(); i < pages.size(); i++) {
+                _pages.push_back(pages[i]);
+            }
+            _complete = _paginator->done();
+        }
+        // 每段之后让出 CPU，翻页和触摸优先
+        vTaskDelay(1);
+    }
+    
+    uint32_t bytes = _paginator->processed() - first;
+    uint32_t elapsed = GetHAL().millis() - start;
+    if (!_paginator->lastError().empty()) {
+        mclog::tagError(TAG, "Text pagination: {}", _paginator->lastError());
+    } else {
+        mclog::tagInfo(TAG, "Text pagination: {} pages, {} KB in {} ms{}",
+                       _paginator->pages().size(), bytes / 1024, elapsed,
+                       _paginator->done() ? "" : ", paused");
+    }
+    _paginator->end();
+}
+
+bool TextReader::loadPage(const LibraryBook& book)
+{
+    uint32_t start = GetHAL().millis();
+    
+    _lines.clear();
+    _next = _offset;
+    
+    FILE* f = fopen(book.txtPath.c_str(), "rb");
+    if (!f) {
+        mclog::tagError(TAG, "Failed to open text book {}", book.id);
+        return false;
+    }
+    
+    // 一页最多 linesPerPage × TEXT_MAX_LINE_BYTES 字节，只读这一段
+    const book::TextLayoutParams params = text_layout_params();
+    std::vector<uint8_t> window(book::text_page_window(params));
+    size_t size = 0;
+    if (fseek(f, _offset, SEEK_SET) == 0) {
+        size = fread(window.data(), 1, window.size(), f);
+    }
+    fclose(f);
+    
+    std::vector<book::TextLine> lines;
+    bool atEof = (uint64_t)_offset + size >= book.txtSize;
+    book::layout_text_page(_encoding, window.data(), size, _offset, atEof, *_widths, params, lines,
+                           _next);
+    
+    _lines.reserve(lines.size());
+    for (const auto& line : lines) {
+        _lines.push_back(book::text_to_utf8(_encoding, window.data() + (line.start - _offset),
+                                                line.end - line.start));
+    }
+    
+    mclog::tagInfo(TAG, "Text page at {}: {} lines, next {} ({} ms)", _offset, _lines.size(),
+                   _next, GetHAL().millis() - start);
+    return true;
+}
+
+bool TextReader::draw() const
+{
+    if (_lines.empty() && _next <= _offset) return false;
+    
+    GetHAL().display.setFont(&fonts::efontCN_24);
+    GetHAL().display.setTextDatum(top_left);
+    GetHAL().display.setTextColor(COLOR_TEXT);
+    for (size_t i = 0; i < _lines.size(); i++) {
+        if (_lines[i].empty()) continue;
+        GetHAL().display.drawString(_lines[i].c_str(), TEXT_MARGIN_X, TEXT_MARGIN_TOP + (int)i * TEXT_LINE_HEIGHT);
+    }
+    return true;
+}
+
+bool TextReader::next(const LibraryBook& book)
+{
+    // 下一页页首在排版当前页时已经得到，不依赖后台分页进度
+    if (_next <= _offset || _next >= book.txtSize) return false;
+    _history.push_back(_offset);
+    _offset = _next;
+    return true;
+}
+
+bool TextReader::previous()
+{
+    // 分页已覆盖当前位置时按索引找上一页
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_pages.empty() && (_complete || _pages.back() >= _offset)) {
+            auto it = std::lower_bound(_pages.begin(), _pages.end(), _offset);
+            if (it == _pages.begin()) return false;
+            _offset = *(it - 1);
+            if (!_history.empty() && _history.back() == _offset) _history.pop_back();
+            return true;
+        }
+    }
+    
+    // 否则沿本次阅读翻过的页首返回
+    if (_history.empty()) return false;
+    _offset = _history.back();
+    _history.pop_back();
+    return true;
+}
+
+void TextReader::seek(uint32_t offset)
+{
+    // 章节起点在行首，但不一定是页首：已分页到这里时跳到包含它的那一页，页码保持连续
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = std::upper_bound(_pages.begin(), _pages.end(), offset);
+        bool covered = it != _pages.end() || (_complete && !_pages.empty());
+        if (covered && it != _pages.begin()) offset = *(it - 1);
+    }
+    _offset = offset;
+    _history.clear();
+}
+
+int TextReader::pageNumber(int& knownPages, bool& complete)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    knownPages = (int)_pages.size();
+    complete = _complete;
+    
+    // 从保存的位置打开时页首可能不在当前排版参数的分页上，此时没有页码
+    auto it = std::lower_bound(_pages.begin(), _pages.end(), _offset);
+    if (it == _pages.end() || *it != _offset) return 0;
+    return (int)(it - _pages.begin()) + 1;
+}
+
+bool TextReader::textAt(int x, int y, std::string& text) const
+{
+    // 行号和行内位置都按 draw() 的版面算
+    if (y < TEXT_MARGIN_TOP || x < TEXT_MARGIN_X) return false;
+    size_t row = (y - TEXT_MARGIN_TOP) / TEXT_LINE_HEIGHT;
+    if (row >= _lines.size()) return false;
+    size_t offset = efont_offset_at(_lines[row], x - TEXT_MARGIN_X);
+    if (offset == std::string::npos) return false;
+    text = book::dictionary_text_at(_lines[row], offset);
+    return !text.empty();
+}
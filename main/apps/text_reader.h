@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "text_book.h"
+#include "app_arena.h"
+#include "book_library.h"
+
+/**
+ * @brief efontCN_24 的字宽，直接查字体数据，不经过 display 的字体状态，后台分页任务也可以调用
+ */
+int efont_text_width(uint32_t codepoint);
+/**
+ * @brief 一行 UTF-8 文字按 efontCN_24 排出的宽度
+ */
+int efont_line_width(const std::string& line);
+/**
+ * @brief 距行首 x 像素处的字符在行中的字节位置，超出行尾时返回 npos
+ */
+size_t efont_offset_at(const std::string& line, int x);
+
+/**
+ * @brief 纯文本书籍的阅读器：后台任务分页并写入索引，主循环只排版当前页
+ *
+ * 阅读位置为当前页首的字节偏移。下一页页首在排版当前页时得到，不依赖后台分页进度；
+ * 向前翻页在分页已覆盖当前位置时按索引查找，否则沿本次阅读翻过的页首返回。
+ */
+class TextReader {
+public:
+    explicit TextReader(book::AppArena& arena) : _history(book::ArenaAllocator<uint32_t>(arena))
+    {
+    }
+
+    /**
+     * @brief 读取编码和已有的分页索引，未完成的部分在后台继续；从书籍保存的位置开始
+     */
+    void open(const LibraryBook& book);
+    /**
+     * @brief 停止后台分页并释放当前页（关闭书籍时调用）
+     */
+    void close();
+
+    /**
+     * @brief 当前页首的字节偏移
+     */
+    uint32_t offset() const
+    {
+        return _offset;
+    }
+
+    /**
+     * @brief 从当前页首排出一页
+     * @return 正文无法打开时返回 false
+     */
+    bool loadPage(const LibraryBook& book);
+    /**
+     * @brief 画出当前页
+     * @return 当前页没有内容（加载失败）时返回 false
+     */
+    bool draw() const;
+
+    /**
+     * @brief 移到下一页页首，需要再调用 loadPage()
+     * @return 已是最后一页时返回 false
+     */
+    bool next(const LibraryBook& book);
+    /**
+     * @brief 移到上一页页首，需要再调用 loadPage()
+     * @return 已是第一页时返回 false
+     */
+    bool previous();
+    /**
+     * @brief 跳到包含 offset 的页（章节起点在行首，但不一定是页首），清空翻页记录
+     */
+    void seek(uint32_t offset);
+
+    /**
+     * @brief 当前页码，分页尚未到达或页首不在分页上时返回 0
+     * @param knownPages 已分页的页数
+     * @param complete 分页是否已完成
+     */
+    int pageNumber(int& knownPages, bool& complete);
+    /**
+     * @brief 屏幕上 (x, y) 处起的一段文字，交给 dictionary_text_at 取词
+     */
+    bool textAt(int x, int y, std::string& text) const;
+
+private:
+    std::unique_ptr<book::TextPaginator> _paginator;  // begin() 之后只由后台任务访问
+    std::unique_ptr<book::GlyphWidths> _widths;       // 主循环排版当前页使用
+    std::mutex _mutex;                                // 保护 _pages 和 _complete
+    std::vector<uint32_t> _pages;                     // 已分页的页首偏移，后台任务追加
+    bool _complete = false;
+    std::atomic<bool> _cancel{false};
+    std::atomic<bool> _running{false};
+    book::TextEncoding _encoding = book::TextEncoding::Utf8;
+    uint32_t _offset = 0;                             // 当前页首
+    uint32_t _next = 0;                               // 下一页页首，排版当前页时得到
+    book::ArenaVector<uint32_t> _history;             // 本次阅读向后翻过的页首，分页尚未覆盖时用于向前翻页
+    std::vector<std::string> _lines;                  // 当前页各行（UTF-8）
+
+    void startPagination(const LibraryBook& book);
+    void stopPagination();
+    void runPagination();
+};
@@ -0,0 +1,208 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "thumb_scrubber.h"
+#include "bookshelf_ui.h"
+#include "hal.h"
+#include "tile_page.h"
+#include "band_decoder.h"
+#include <mooncake_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <algorithm>
+
+static const char* TAG = "ThumbScrubber";
+
+// 缩略图集：后台生成任务和拖动预览
+static constexpr int THUMB_TASK_STACK_SIZE = 1024 * 8;
+static constexpr int THUMB_TASK_PRIORITY = 1;   // 与主循环同级，时间片轮转，每页之后主动让出
+static constexpr int THUMB_CACHE_COUNT = 16;          // 16 × 2.4KB，来回拖动时附近的缩略图都命中
+static constexpr int SCRUB_BTN_MARGIN = 100;          // 进度条拖动区域：目录按钮右侧到批注按钮左侧
+static constexpr int SCRUB_PANEL_HEIGHT = 230;        // 预览面板，紧贴底部栏上方
+
+void ThumbScrubber::start(const LibraryBook& book)
+{
+    stop();
+    _reader.close();
+    
+    // 全书页序：按章节顺序展开，条带布局按整屏计
+    book::ThumbSource source;
+    source.bookDir = "/sdcard/books/" + book.id;
+    source.strips = book.strips;
+    source.pageExtension = book.tiles ? book::TILE_PAGE_EXTENSION : (book.bands ? book::BAND_PAGE_EXTENSION : ".png");
+    for (const auto& sec : book.sections) {
+        for (int page = 1; page <= sec.pageCount; page++) {
+            source.pages.push_back({sec.index, page});
+        }
+    }
+    if (source.pages.empty()) return;
+    
+    if (!_builder.begin(source)) {
+        mclog::tagError(TAG, "Thumbnail atlas: {}", _builder.lastError());
+        return;
+    }
+    if (_builder.done()) {
+        _builder.end();
+        return;
+    }
+    
+    mclog::tagInfo(TAG, "Thumbnails: {}/{} pages, generating in background", _builder.generated(), _builder.total());
+    
+    _cancel = false;
+    _running = true;
+    BaseType_t ok = xTaskCreate(
+        [](void* arg) {
+            ThumbScrubber* self = (ThumbScrubber*)arg;
+            self->runJob();
+            self->_running = false;
+            vTaskDelete(NULL);
+        },
+        "thumbs", THUMB_TASK_STACK_SIZE, this, THUMB_TASK_PRIORITY, NULL);
+    if (ok != pdPASS) {
+        mclog::tagError(TAG, "Failed to start thumbnail task");
+        _builder.end();
+        _running = false;
+    }
+}
+
+void ThumbScrubber::stop()
+{
+    // 任务在页与页之间检查取消标志，最多等待一页的生成时间；已生成的缩略图保留，下次打开时继续
+    _cancel = true;
+    while (_running) {
+        GetHAL().delay(5);
+    }
+}
+
+void ThumbScrubber::close()
+{
+    stop();
+    _reader.close();
+    _scrubbing = false;
+    _arena.free(_buffer);
+    _buffer = nullptr;
+}
+
+void ThumbScrubber::runJob()
+{
+    uint32_t start = GetHAL().millis();
+    int first = _builder.generated();
+    
+    while (!_cancel && _builder.step()) {
+        // 每页之后让出 CPU，翻页和触摸优先
+        vTaskDelay(1);
+    }
+    
+    int count = _builder.generated() - first;
+    uint32_t elapsed = GetHAL().millis() - start;
+    if (!_builder.lastError().empty()) {
+        mclog::tagError(TAG, "Thumbnails: {}", _builder.lastError());
+    } else {
+        mclog::tagInfo(TAG, "Thumbnails: {}/{} pages ({} generated, {} ms/page){}",
+                       _builder.generated(), _builder.total(), count, count > 0 ? elapsed / count : 0,
+                       _builder.done() ? "" : ", paused");
+    }
+    _builder.end();
+}
+
+bool ThumbScrubber::handleTouch(const m5::Touch_Class::touch_detail_t& touch, const LibraryBook& book, int& jumpTo)
+{
+    jumpTo = -1;
+    
+    // 拖动区域 [SCRUB_BTN_MARGIN, scrubEnd)，右端与批注按钮留 10px
+    const int scrubEnd = INK_BTN_X - 10;
+    if (!_scrubbing) {
+        if (!touch.wasPressed() || touch.y < PAGE_CONTENT_HEIGHT || touch.x < SCRUB_BTN_MARGIN ||
+            touch.x >= scrubEnd) {
+            return false;
+        }
+        
+        // 后台任务仍在追加时重新读取文件长度，只预览已生成的部分
+        if (_reader.isOpen()) {
+            _reader.refresh();
+        } else {
+            std::string path = "/sdcard/books/" + book.id + "/" + book::THUMB_ATLAS_FILE_NAME;
+            _reader.open(path, THUMB_CACHE_COUNT);
+        }
+        if (_reader.available() == 0) return false;
+        
+        if (!_buffer) {
+            _buffer = (uint8_t*)_arena.alloc(book::THUMB_WIDTH * 2 * book::THUMB_HEIGHT * 2);
+            if (!_buffer) return false;
+        }
+        _scrubbing = true;
+        _page = -1;
+        GetHAL().display.setEpdMode(epd_mode_t::epd_fastest);
+    }
+    
+    // 拖动区域的横坐标线性映射到全书页序，最右一列对应最后一页
+    int total = _reader.pageCount();
+    int span = scrubEnd - SCRUB_BTN_MARGIN - 1;
+    int x = std::max(0, std::min(span, (int)touch.x - SCRUB_BTN_MARGIN));
+    int page = total > 1 ? x * (total - 1) / span : 0;
+    
+    if (touch.isPressed()) {
+        if (page != _page) {
+            _page = page;
+            drawPreview();
+        }
+        return true;
+    }
+    
+    // 松手：跳转到最后预览的页面，整页重绘会覆盖预览面板
+    _scrubbing = false;
+    _arena.free(_buffer);
+    _buffer = nullptr;
+    mclog::tagInfo(TAG, "Scrub: thumbnails read {}, cache hits {}", _reader.reads(), _reader.cacheHits());
+    jumpTo = _page;
+    return true;
+}
+
+void ThumbScrubber::drawPreview()
+{
+    // 当前页放大两倍居中，前后各两页原尺寸；尚未生成的页面只画边框
+    const int smallW = book::THUMB_WIDTH;
+    const int smallH = book::THUMB_HEIGHT;
+    const int bigW = smallW * 2;
+    const int bigH = smallH * 2;
+    const int gap = 10;
+    const int panelY = PAGE_CONTENT_HEIGHT - SCRUB_PANEL_HEIGHT;
+    const int thumbY = panelY + 10;
+    
+    uint32_t start = GetHAL().millis();
+    auto& display = GetHAL().display;
+    display.startWrite();
+    display.fillRect(0, panelY, SCREEN_WIDTH, SCRUB_PANEL_HEIGHT, COLOR_BG);
+    display.drawLine(0, panelY, SCREEN_WIDTH, panelY, COLOR_BORDER);
+    
+    int x = (SCREEN_WIDTH - bigW - 4 * smallW - 4 * gap) / 2;
+    for (int offset = -2; offset <= 2; offset++) {
+        int index = _page + offset;
+        bool center = offset == 0;
+        int w = center ? bigW : smallW;
+        int h = center ? bigH : smallH;
+        int y = thumbY + (bigH - h) / 2;
+        
+        if (index >= 0 && index < _reader.pageCount()) {
+            const uint8_t* thumb = _reader.thumb(index);
+            if (thumb) {
+                book::expand_thumb(thumb, center ? 2 : 1, _buffer);
+                display.pushGrayscaleImage(x, y, w, h, _buffer, lgfx::grayscale_8bit, COLOR_BG, COLOR_TEXT);
+            }
+            display.drawRect(x - 1, y - 1, w + 2, h + 2, center ? COLOR_TEXT : COLOR_BORDER);
+        }
+        x += w + gap;
+    }
+    
+    char label[64];
+    snprintf(label, sizeof(label), "第 %d / %d 页", _page + 1, _reader.pageCount());
+    display.setFont(&fonts::efontCN_16_b);
+    display.setTextDatum(middle_center);
+    display.setTextColor(COLOR_TEXT);
+    display.drawString(label, SCREEN_WIDTH / 2, thumbY + bigH + 20);
+    display.endWrite();
+    
+    mclog::tagInfo(TAG, "Scrub preview: page {} in {} ms", _page + 1, GetHAL().millis() - start);
+}
@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <M5GFX.h>
+#include <atomic>
+#include <cstdint>
+#include "thumb_atlas.h"
+#include "app_arena.h"
+#include "book_library.h"
+
+/**
+ * @brief 缩略图集与进度条拖动：打开书籍后由后台任务逐页生成缩略图，拖动底部进度条时预览
+ *
+ * 页序为全书页序：按章节顺序展开，条带布局按整屏计。
+ */
+class ThumbScrubber {
+public:
+    explicit ThumbScrubber(book::AppArena& arena) : _arena(arena)
+    {
+    }
+
+    /**
+     * @brief 后台补齐一本书的缩略图集，已完成的书不会启动任务
+     */
+    void start(const LibraryBook& book);
+    /**
+     * @brief 停止后台任务；已生成的缩略图保留，下次打开时继续
+     */
+    void stop();
+    /**
+     * @brief 停止任务、关闭缩略图集并释放预览缓冲（关闭书籍时调用）
+     */
+    void close();
+
+    /**
+     * @brief 按住底部进度区域左右拖动，预览缩略图
+     * @param jumpTo 松手时为要跳转的全书页序，否则为 -1
+     * @return 触摸已被拖动消耗时返回 true
+     */
+    bool handleTouch(const m5::Touch_Class::touch_detail_t& touch, const LibraryBook& book, int& jumpTo);
+
+private:
+    book::AppArena& _arena;
+    book::ThumbAtlasBuilder _builder;  // begin() 之后只由后台任务访问
+    book::ThumbAtlasReader _reader;
+    std::atomic<bool> _cancel{false};
+    std::atomic<bool> _running{false};
+    bool _scrubbing = false;
+    int _page = -1;                    // 预览中的全书页序（从 0 开始）
+    uint8_t* _buffer = nullptr;        // 放大两倍的缩略图，拖动期间分配
+
+    void runJob();
+    void drawPreview();
+};
@@ -0,0 +1,212 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "app_arena.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+namespace book {
+
+static constexpr uint32_t LARGE_MAGIC = 0x4C415247;  // "LARG"
+static constexpr uint32_t SMALL_MAGIC = 0x534D4C4C;  // "SMLL"
+static constexpr uint32_t FREED_MAGIC = 0x46524545;  // "FREE"
+
+struct AppArena::LargeHeader {
+    LargeHeader* prev;
+    LargeHeader* next;
+    size_t size;
+};
+
+struct AppArena::SmallHeader {
+    uint32_t size;
+    uint32_t magic;
+};
+
+// 大块块头补齐到 16 字节，标记放在紧挨数据的最后 4 字节
+static constexpr size_t LARGE_HEADER_SIZE = (sizeof(void*) * 2 + sizeof(size_t) + 4 + 15) / 16 * 16;
+static constexpr size_t SMALL_HEADER_SIZE = 8;
+
+static inline uint32_t& block_magic(void* ptr)
+{
+    return *(uint32_t*)((uint8_t*)ptr - 4);
+}
+
+// 大块和小对象页都放在 PSRAM，不够时退回默认堆
+static void* raw_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    void* ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return ptr ? ptr : heap_caps_malloc(size, MALLOC_CAP_8BIT);
+#else
+    return ::malloc(size);
+#endif
+}
+
+static void raw_free(void* ptr)
+{
+#ifdef ESP_PLATFORM
+    heap_caps_free(ptr);
+#else
+    ::free(ptr);
+#endif
+}
+
+AppArena::AppArena(const char* name) : _name(name)
+{
+    _stats.name = name;
+}
+
+AppArena::~AppArena()
+{
+    release();
+}
+
+void* AppArena::alloc(size_t size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.allocations++;
+
+    void* ptr = size + SMALL_HEADER_SIZE <= ARENA_SMALL_MAX ? allocSmall(size) : allocLarge(size);
+    if (!ptr) {
+        _stats.failures++;
+        return nullptr;
+    }
+    _stats.current += size;
+    _stats.peak         = std::max(_stats.peak, _stats.current);
+    _stats.reservedPeak = std::max(_stats.reservedPeak, _stats.reserved);
+    return ptr;
+}
+
+void* AppArena::allocLarge(size_t size)
+{
+    uint8_t* raw = (uint8_t*)raw_alloc(LARGE_HEADER_SIZE + size);
+    if (!raw) return nullptr;
+
+    LargeHeader* header = (LargeHeader*)raw;
+    header->prev        = nullptr;
+    header->next        = _large;
+    header->size        = size;
+    if (_large) _large->prev = header;
+    _large = header;
+
+    void* ptr        = raw + LARGE_HEADER_SIZE;
+    block_magic(ptr) = LARGE_MAGIC;
+    _stats.reserved += LARGE_HEADER_SIZE + size;
+    _stats.largeBlocks++;
+    return ptr;
+}
+
+void* AppArena::allocSmall(size_t size)
+{
+    size_t slot  = (size + SMALL_HEADER_SIZE + ARENA_SMALL_STEP - 1) / ARENA_SMALL_STEP * ARENA_SMALL_STEP;
+    size_t index = slot / ARENA_SMALL_STEP - 1;
+
+    uint8_t* raw = nullptr;
+    if (_free_slots[index]) {
+        raw                = (uint8_t*)_free_slots[index] - SMALL_HEADER_SIZE;
+        _free_slots[index] = _free_slots[index]->next;
+    } else {
+        // 当前页剩余部分不够时另开一页，剩余部分不再使用
+        if (!_slab_cursor || (size_t)(_slab_end - _slab_cursor) < slot) {
+            uint8_t* slab = (uint8_t*)raw_alloc(ARENA_SLAB_SIZE);
+            if (!slab) return nullptr;
+            _slabs.push_back(slab);
+            _slab_cursor = slab;
+            _slab_end    = slab + ARENA_SLAB_SIZE;
+            _stats.reserved += ARENA_SLAB_SIZE;
+            _stats.slabs++;
+        }
+        raw = _slab_cursor;
+        _slab_cursor += slot;
+    }
+
+    SmallHeader* header = (SmallHeader*)raw;
+    header->size        = (uint32_t)size;
+    header->magic       = SMALL_MAGIC;
+    _stats.smallObjects++;
+    return raw + SMALL_HEADER_SIZE;
+}
+
+void AppArena::free(void* ptr)
+{
+    if (!ptr) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint32_t& magic = block_magic(ptr);
+    if (magic == LARGE_MAGIC) {
+        LargeHeader* header = (LargeHeader*)((uint8_t*)ptr - LARGE_HEADER_SIZE);
+        if (header->prev) {
+            header->prev->next = header->next;
+        } else {
+            _large = header->next;
+        }
+        if (header->next) header->next->prev = header->prev;
+
+        _stats.current -= header->size;
+        _stats.reserved -= LARGE_HEADER_SIZE + header->size;
+        _stats.largeBlocks--;
+        magic = FREED_MAGIC;
+        raw_free(header);
+    } else if (magic == SMALL_MAGIC) {
+        SmallHeader* header = (SmallHeader*)((uint8_t*)ptr - SMALL_HEADER_SIZE);
+        size_t slot  = (header->size + SMALL_HEADER_SIZE + ARENA_SMALL_STEP - 1) / ARENA_SMALL_STEP * ARENA_SMALL_STEP;
+        size_t index = slot / ARENA_SMALL_STEP - 1;
+
+        _stats.current -= header->size;
+        _stats.smallObjects--;
+        header->magic = FREED_MAGIC;
+
+        // 空闲链表指针放在数据区，块头的标记保留用于发现重复释放
+        FreeSlot* free     = (FreeSlot*)ptr;
+        free->next         = _free_slots[index];
+        _free_slots[index] = free;
+    } else {
+        _stats.badFrees++;
+    }
+}
+
+void AppArena::release()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    releaseLocked();
+}
+
+void AppArena::releaseLocked()
+{
+    _stats.leakedBlocks = _stats.largeBlocks + _stats.smallObjects;
+    _stats.leakedBytes  = _stats.current;
+
+    while (_large) {
+        LargeHeader* next = _large->next;
+        raw_free(_large);
+        _large = next;
+    }
+    for (uint8_t* slab : _slabs) {
+        raw_free(slab);
+    }
+    _slabs.clear();
+    _slabs.shrink_to_fit();
+    _slab_cursor = nullptr;
+    _slab_end    = nullptr;
+    memset(_free_slots, 0, sizeof(_free_slots));
+
+    _stats.current      = 0;
+    _stats.reserved     = 0;
+    _stats.largeBlocks  = 0;
+    _stats.smallObjects = 0;
+    _stats.slabs        = 0;
+}
+
+ArenaStats AppArena::stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+}  // namespace book
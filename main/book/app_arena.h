@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+namespace book {
+
+/*
+ * 应用内存上下文：每个 mooncake 应用一个，应用自己的缓冲（封面、页面数据、帧缓冲、JSON 读入缓冲）从这里分配。
+ * 应用卸载时析构（或 onDestroy 中 release()）整体归还，某条 free*() 路径漏掉的块也一并收回，并在统计中记为泄漏。
+ *
+ * - 大块（> ARENA_SMALL_MAX）：直接向 PSRAM 申请，块头把所有块串成双向链表，单独释放或整体释放
+ * - 小对象：按 16 字节一级的大小分类，从 ARENA_SLAB_SIZE 的 PSRAM 页中切出，释放后挂在该类的空闲链表上复用，
+ *   整体释放时只归还各页，不逐个释放。页一旦申请就留到整体释放，应用内反复申请释放小对象不会产生碎片
+ *
+ * 每个块前有一个块头，末尾 4 字节为标记，free() 据此区分大块和小对象并发现重复释放。
+ * 小对象按 8 字节对齐，大块按 16 字节对齐。可以从多个任务调用（内部加锁）。
+ */
+static constexpr size_t ARENA_SLAB_SIZE  = 16 * 1024;
+static constexpr size_t ARENA_SMALL_MAX  = 512;  // 含块头
+static constexpr size_t ARENA_SMALL_STEP = 16;
+
+struct ArenaStats {
+    const char* name      = "";
+    size_t current        = 0;  // 应用持有的字节数（申请时的大小）
+    size_t peak           = 0;
+    size_t reserved       = 0;  // 实际占用：大块 + 小对象页
+    size_t reservedPeak   = 0;
+    uint32_t largeBlocks  = 0;  // 当前持有的大块数
+    uint32_t smallObjects = 0;  // 当前持有的小对象数
+    uint32_t slabs        = 0;
+    uint32_t allocations  = 0;  // 累计申请次数
+    uint32_t failures     = 0;
+    uint32_t badFrees     = 0;  // 重复释放或不是本上下文分配的指针，已忽略
+    uint32_t leakedBlocks = 0;  // 最近一次 release() 时仍未释放的块
+    size_t leakedBytes    = 0;
+};
+
+class AppArena {
+public:
+    explicit AppArena(const char* name);
+    ~AppArena();
+    AppArena(const AppArena&)            = delete;
+    AppArena& operator=(const AppArena&) = delete;
+
+    /**
+     * @return 失败时返回 nullptr；size 为 0 时也返回一个可以 free 的指针
+     */
+    void* alloc(size_t size);
+    /**
+     * @brief 释放 alloc() 得到的指针，nullptr 忽略
+     */
+    void free(void* ptr);
+
+    /**
+     * @brief 整体释放：归还全部大块和小对象页，统计未释放的块
+     */
+    void release();
+
+    ArenaStats stats() const;
+    const char* name() const
+    {
+        return _name;
+    }
+
+private:
+    struct LargeHeader;
+    struct SmallHeader;
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+    static constexpr size_t CLASS_COUNT = ARENA_SMALL_MAX / ARENA_SMALL_STEP;
+
+    const char* _name;
+    mutable std::mutex _mutex;
+    LargeHeader* _large = nullptr;         // 大块链表
+    std::vector<uint8_t*> _slabs;          // 小对象页
+    uint8_t* _slab_cursor = nullptr;       // 当前页中尚未切出的部分
+    uint8_t* _slab_end    = nullptr;
+    FreeSlot* _free_slots[CLASS_COUNT] = {};
+    ArenaStats _stats;
+
+    void* allocLarge(size_t size);
+    void* allocSmall(size_t size);
+    void releaseLocked();
+};
+
+/**
+ * @brief 从 AppArena 分配的标准库分配器，用于应用里的容器：std::vector<T, ArenaAllocator<T>>
+ */
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(AppArena& arena) noexcept : _arena(&arena)
+    {
+    }
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : _arena(other.arena())
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        // 固件关闭了 C++ 异常，分配失败时与 operator new 一样终止
+        void* ptr = _arena->alloc(n * sizeof(T));
+        if (!ptr) abort();
+        return static_cast<T*>(ptr);
+    }
+    void deallocate(T* ptr, size_t)
+    {
+        _arena->free(ptr);
+    }
+
+    AppArena* arena() const noexcept
+    {
+        return _arena;
+    }
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept
+    {
+        return _arena == other.arena();
+    }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept
+    {
+        return _arena != other.arena();
+    }
+
+private:
+    AppArena* _arena;
+};
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}  // namespace book
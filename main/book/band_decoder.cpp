@@ -0,0 +1,228 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "band_decoder.h"
+#include "gray_png.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace book {
+
+#ifdef ESP_PLATFORM
+
+// 两个核心各一个解码线程：调用方所在核心 + 另一核心上的工作任务
+static constexpr int MAX_WORKERS       = 2;
+static constexpr int WORKER_STACK_SIZE = 1024 * 8;
+static constexpr int WORKER_PRIORITY   = 5;
+
+class Semaphore {
+public:
+    Semaphore() : _handle(xSemaphoreCreateCounting(MAX_WORKERS, 0))
+    {
+    }
+    ~Semaphore()
+    {
+        vSemaphoreDelete(_handle);
+    }
+    Semaphore(const Semaphore&)            = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+    void post()
+    {
+        xSemaphoreGive(_handle);
+    }
+    void wait()
+    {
+        xSemaphoreTake(_handle, portMAX_DELAY);
+    }
+
+private:
+    SemaphoreHandle_t _handle;
+};
+
+#else
+
+static constexpr int MAX_WORKERS = 64;
+
+class Semaphore {
+public:
+    void post()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _count++;
+        _cv.notify_one();
+    }
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [this] { return _count > 0; });
+        _count--;
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    int _count = 0;
+};
+
+#endif
+
+// 每个工作线程一个唤醒信号；所有工作线程共用一个完成信号，调用方等满 workers - 1 次即为屏障
+struct BandDecoder::Impl {
+    std::vector<Semaphore> wake;
+    Semaphore done;
+#ifndef ESP_PLATFORM
+    std::vector<std::thread> threads;
+#endif
+
+    explicit Impl(int helpers) : wake(helpers)
+    {
+    }
+};
+
+struct WorkerArgs {
+    BandDecoder* self;
+    int worker;
+};
+
+BandDecoder::~BandDecoder()
+{
+    stop();
+}
+
+bool BandDecoder::start(int workers)
+{
+    stop();
+
+    workers  = std::max(1, std::min(MAX_WORKERS, workers));
+    _impl    = new Impl(workers - 1);
+    _workers = workers;
+    _stopping.store(false);
+    _bands_done.assign(workers, 0);
+
+    for (int i = 1; i < workers; i++) {
+#ifdef ESP_PLATFORM
+        // 固定到调用方之外的核心，mooncake 主循环所在的核心同时解码另一部分行带
+        WorkerArgs* args = new WorkerArgs{this, i};
+        BaseType_t ok    = xTaskCreatePinnedToCore(
+            [](void* arg) {
+                WorkerArgs* a = (WorkerArgs*)arg;
+                workerLoop(a->self, a->worker);
+                delete a;
+                vTaskDelete(NULL);
+            },
+            "band_dec", WORKER_STACK_SIZE, args, WORKER_PRIORITY, NULL, 1 - xPortGetCoreID());
+        if (ok != pdPASS) {
+            delete args;
+            _workers = i;
+            break;
+        }
+#else
+        _impl->threads.emplace_back(workerLoop, this, i);
+#endif
+    }
+    return true;
+}
+
+void BandDecoder::stop()
+{
+    if (!_impl) return;
+
+    _stopping.store(true);
+    for (int i = 1; i < _workers; i++) {
+        _impl->wake[i - 1].post();
+    }
+    // 工作线程退出前各发一次完成信号
+    for (int i = 1; i < _workers; i++) {
+        _impl->done.wait();
+    }
+#ifndef ESP_PLATFORM
+    for (auto& thread : _impl->threads) {
+        thread.join();
+    }
+#endif
+    delete _impl;
+    _impl    = nullptr;
+    _workers = 1;
+}
+
+void BandDecoder::workerLoop(BandDecoder* self, int worker)
+{
+    while (true) {
+        self->_impl->wake[worker - 1].wait();
+        if (self->_stopping.load()) break;
+        self->runBands(worker);
+        self->_impl->done.post();
+    }
+    self->_impl->done.post();
+}
+
+void BandDecoder::runBands(int worker)
+{
+    int count = 0;
+    while (!_failed.load(std::memory_order_relaxed)) {
+        int band = _next_band.fetch_add(1);
+        if (band >= _header.stripCount) break;
+
+        const int top  = band * _header.stripHeight;
+        const int rows = std::min(_header.stripHeight, _header.height - top);
+        uint8_t* dst   = _frame + (size_t)top * _header.width;
+
+        const StripEntry& entry = _entries[band];
+        bool ok = decode_gray_png(_data + entry.offset, entry.size, [&](int y, const uint8_t* gray, int width) {
+            if (y >= rows || width != _header.width) return false;
+            memcpy(dst + (size_t)y * width, gray, width);
+            return true;
+        });
+        if (!ok) {
+            _failed.store(true);
+            break;
+        }
+        count++;
+    }
+    _bands_done[worker] = count;
+}
+
+bool BandDecoder::decode(const uint8_t* data, size_t size, uint8_t* frame, size_t frameSize, StripFileHeader* info)
+{
+    if (!_impl && !start(1)) return false;
+
+    if (!parse_strip_header(data, size, _header) ||
+        !parse_strip_index(data + STRIP_FILE_HEADER_SIZE, size - STRIP_FILE_HEADER_SIZE, _header, size, _entries)) {
+        return false;
+    }
+    if (frameSize < (size_t)_header.width * _header.height) return false;
+    if (info) *info = _header;
+
+    _data  = data;
+    _frame = frame;
+    _next_band.store(0);
+    _failed.store(false);
+    std::fill(_bands_done.begin(), _bands_done.end(), 0);
+
+    // 信号量的 post / wait 保证工作线程看到上面写入的任务
+    for (int i = 1; i < _workers; i++) {
+        _impl->wake[i - 1].post();
+    }
+    runBands(0);
+    for (int i = 1; i < _workers; i++) {
+        _impl->done.wait();
+    }
+
+    _data  = nullptr;
+    _frame = nullptr;
+    return !_failed.load();
+}
+
+}  // namespace book
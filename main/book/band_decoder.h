@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "strip_file.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace book {
+
+/**
+ * @brief 行带并行解码：把 .bnd 页面的各行带分给多个线程，解码到同一帧缓冲中互不重叠的区域
+ *
+ * 调用 decode() 的线程自己也参与解码，另有 workers - 1 个常驻工作线程
+ * （设备端为固定在另一个核心上的 FreeRTOS 任务，主机端为 std::thread）。
+ * 行带通过原子计数器领取，先做完的线程继续领下一条；全部线程到达屏障后 decode() 返回。
+ */
+class BandDecoder {
+public:
+    BandDecoder() = default;
+    ~BandDecoder();
+    BandDecoder(const BandDecoder&)            = delete;
+    BandDecoder& operator=(const BandDecoder&) = delete;
+
+    /**
+     * @param workers 参与解码的线程总数（含调用线程），设备端最多 2
+     */
+    bool start(int workers);
+    void stop();
+    int workers() const
+    {
+        return _workers;
+    }
+
+    /**
+     * @brief 解码整页为 8-bit 灰度
+     * @param frame 帧缓冲，按页面宽度紧密排列，至少 width × height 字节
+     * @param info 可选，输出页面尺寸
+     */
+    bool decode(const uint8_t* data, size_t size, uint8_t* frame, size_t frameSize, StripFileHeader* info = nullptr);
+
+    /**
+     * @brief 最近一次 decode() 中各线程解码的行带数，下标 0 为调用线程
+     */
+    const std::vector<int>& bandsPerWorker() const
+    {
+        return _bands_done;
+    }
+
+private:
+    void runBands(int worker);
+    static void workerLoop(BandDecoder* self, int worker);
+
+    // 线程和信号量的平台实现，定义见 band_decoder.cpp
+    struct Impl;
+    Impl* _impl  = nullptr;
+    int _workers = 1;
+
+    // 当前任务，由 decode() 在唤醒工作线程前写入
+    const uint8_t* _data = nullptr;
+    uint8_t* _frame      = nullptr;
+    StripFileHeader _header;
+    std::vector<StripEntry> _entries;
+    std::atomic<int> _next_band{0};
+    std::atomic<bool> _failed{false};
+    std::atomic<bool> _stopping{false};
+    std::vector<int> _bands_done;
+};
+
+}  // namespace book
@@ -0,0 +1,343 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "copy_jobs.h"
+#include "crc32c.h"
+#include "file_checksums.h"
+#include "free_space.h"
+#include "fs_events.h"
+#include "read_ahead.h"
+#include "tar_archive.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include <mooncake_log.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+namespace book {
+
+#ifdef ESP_PLATFORM
+static constexpr int WORKER_STACK_SIZE = 1024 * 6;
+static constexpr int WORKER_PRIORITY   = 1;  // 低于 HTTP 服务器和界面
+static const char* TAG                 = "CopyJobs";
+#endif
+
+static void pause_ms(int ms)
+{
+#ifdef ESP_PLATFORM
+    vTaskDelay(pdMS_TO_TICKS(ms) > 0 ? pdMS_TO_TICKS(ms) : 1);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+}
+
+static bool finished(const CopyJobStatus& job)
+{
+    return job.state == "done" || job.state == "error";
+}
+
+bool normalize_path(const std::string& root, const std::string& path, std::string& out)
+{
+    out = root;
+    while (out.size() > 1 && out.back() == '/') out.pop_back();
+    size_t start = 0;
+    while (start < path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        std::string part = path.substr(start, end - start);
+        start            = end + 1;
+        if (part.empty()) continue;
+        if (part == "." || part == "..") return false;
+        out += "/" + part;
+    }
+    return true;
+}
+
+bool path_within(const std::string& path, const std::string& dir)
+{
+    return path.compare(0, dir.size(), dir) == 0 &&
+           (path.size() == dir.size() || path[dir.size()] == '/' || dir == "/");
+}
+
+// 不复制上传一半的文件和后台删除中的墓碑；.checksums 在复制时按实际内容重新生成
+bool CopyJobQueue::copyable(const DirWalker::Entry& entry) const
+{
+    if (_trash.isTrashPath(entry.path)) return false;
+    if (entry.dir) return true;
+    const char* name = strrchr(entry.path.c_str(), '/');
+    name             = name ? name + 1 : entry.path.c_str();
+    size_t length    = strlen(name);
+    return strcmp(name, CHECKSUM_SIDECAR_NAME) != 0 && (length < 5 || strcmp(name + length - 5, ".part") != 0);
+}
+
+CopyJobQueue& CopyJobQueue::getInstance()
+{
+    static CopyJobQueue instance;
+    return instance;
+}
+
+uint32_t CopyJobQueue::enqueue(const std::string& from, const std::string& to)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    CopyJobStatus job;
+    job.id        = _next_id++;
+    job.from      = from;
+    job.to        = to;
+    job.state     = "queued";
+    _jobs[job.id] = job;
+    _pending.push_back(job.id);
+    prune();
+    start();
+    return job.id;
+}
+
+bool CopyJobQueue::status(uint32_t id, CopyJobStatus& out)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _jobs.find(id);
+    if (it == _jobs.end()) return false;
+    out = it->second;
+    return true;
+}
+
+std::vector<CopyJobStatus> CopyJobQueue::jobs()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<CopyJobStatus> out;
+    for (auto& [id, job] : _jobs) out.push_back(job);
+    return out;
+}
+
+bool CopyJobQueue::busy()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _running;
+}
+
+// 调用方持有 _mutex
+void CopyJobQueue::prune()
+{
+    int finishedCount = 0;
+    for (auto& [id, job] : _jobs) {
+        if (finished(job)) finishedCount++;
+    }
+    for (auto it = _jobs.begin(); it != _jobs.end() && finishedCount > COPY_KEEP_FINISHED;) {
+        if (finished(it->second)) {
+            it = _jobs.erase(it);
+            finishedCount--;
+        } else {
+            ++it;
+        }
+    }
+}
+
+// 调用方持有 _mutex
+void CopyJobQueue::start()
+{
+    if (_running) return;
+    _running = true;
+#ifdef ESP_PLATFORM
+    BaseType_t ok = xTaskCreate(
+        [](void* arg) {
+            workerLoop((CopyJobQueue*)arg);
+            vTaskDelete(NULL);
+        },
+        "copy_jobs", WORKER_STACK_SIZE, this, WORKER_PRIORITY, NULL);
+    if (ok != pdPASS) {
+        mclog::tagError(TAG, "Failed to start copy task");
+        _running = false;
+    }
+#else
+    std::thread(workerLoop, this).detach();
+#endif
+}
+
+void CopyJobQueue::workerLoop(CopyJobQueue* self)
+{
+    while (true) {
+        CopyJobStatus job;
+        {
+            std::lock_guard<std::mutex> lock(self->_mutex);
+            if (self->_pending.empty()) {
+                self->_running = false;
+                return;
+            }
+            job = self->_jobs[self->_pending.front()];
+            self->_pending.erase(self->_pending.begin());
+        }
+        self->run(job);
+    }
+}
+
+void CopyJobQueue::report(const CopyJobStatus& job)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _jobs[job.id] = job;
+}
+
+bool CopyJobQueue::copyFile(const std::string& from, const std::string& to, uint64_t size, uint8_t* buffer,
+                            CopyJobStatus& job)
+{
+    FILE* in = fopen(from.c_str(), "rb");
+    if (!in) return false;
+    std::string part = to + ".part";
+    FILE* out        = fopen(part.c_str(), "wb");
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+
+    uint32_t crc    = 0;
+    uint64_t copied = 0;
+    bool ok         = true;
+    auto write      = [&](const uint8_t* data, size_t n) {
+        ok = ok && fwrite(data, 1, n, out) == n;
+        crc = crc32c_update(crc, data, n);
+        copied += n;
+        job.bytes += n;
+    };
+    if (size <= COPY_CHUNK_SIZE) {
+        // 小文件（大多数页面）一次读完，不值得启动预读任务
+        size_t n = fread(buffer, 1, COPY_CHUNK_SIZE, in);
+        write(buffer, n);
+    } else {
+        ReadAhead reader([in](uint8_t* chunk, size_t capacity) { return fread(chunk, 1, capacity, in); },
+                         COPY_CHUNK_SIZE);
+        ok = reader.start();
+        const uint8_t* data;
+        size_t n;
+        while (ok && reader.next(data, n)) {
+            write(data, n);
+            reader.release();
+            report(job);
+        }
+        reader.stop();
+    }
+    ok = ok && !ferror(in) && copied == size;
+    fclose(in);
+    ok = fclose(out) == 0 && ok;
+
+    if (!ok || rename(part.c_str(), to.c_str()) != 0) {
+        remove(part.c_str());
+        return false;
+    }
+    ChecksumSidecar::record(to, copied, crc);
+    FreeSpaceCache::getInstance().fileChanged(0, copied);
+    FsEventBus::getInstance().publish(FsEventType::Written, to);
+    return true;
+}
+
+void CopyJobQueue::run(CopyJobStatus& job)
+{
+    auto fail = [&](const char* error) {
+        job.state = "error";
+        job.error = error;
+        report(job);
+#ifdef ESP_PLATFORM
+        mclog::tagError(TAG, "Copy job {} ({} -> {}) failed: {}", job.id, job.from, job.to, error);
+#endif
+    };
+
+    // 目标在源之内时遍历会走进刚建的目标目录，一层层复制下去直到卡满
+    if (path_within(job.to, job.from)) return fail("Destination is inside the source");
+    struct stat st;
+    if (stat(job.from.c_str(), &st) != 0) return fail("Source not found");
+    bool isDir = S_ISDIR(st.st_mode);
+
+    // 统计总量，剩余空间不够时不开始
+    job.state = "scanning";
+    report(job);
+    if (isDir) {
+        DirWalker walker(job.from);
+        DirWalker::Entry entry;
+        while (walker.next(entry)) {
+            if (!copyable(entry)) {
+                if (entry.dir) walker.skipChildren();
+                continue;
+            }
+            if (entry.dir) continue;
+            job.totalFiles++;
+            job.totalBytes += entry.size;
+        }
+    } else {
+        job.totalFiles = 1;
+        job.totalBytes = (uint64_t)st.st_size;
+    }
+    FreeSpaceInfo space = FreeSpaceCache::getInstance().get();
+    if (space.valid && space.free < job.totalBytes) return fail("Not enough space");
+
+    uint8_t* buffer = (uint8_t*)malloc(COPY_CHUNK_SIZE);
+    if (!buffer) return fail("Out of memory");
+
+    job.state = "running";
+    report(job);
+    int batch = 0;
+    auto copy = [&](const std::string& from, const std::string& to, uint64_t size) {
+        if (copyFile(from, to, size, buffer, job)) {
+            job.files++;
+        } else {
+            job.errors++;
+        }
+        report(job);
+        if (++batch == COPY_BATCH_SIZE) {
+            batch = 0;
+            if (_batch_pause_ms > 0) pause_ms(_batch_pause_ms);
+        }
+    };
+
+    if (!isDir) {
+        copy(job.from, job.to, (uint64_t)st.st_size);
+    } else if (mkdir(job.to.c_str(), 0755) != 0) {
+        free(buffer);
+        return fail("Failed to create destination");
+    } else {
+        job.dirs++;
+        FreeSpaceCache::getInstance().dirChanged(true);
+        FsEventBus::getInstance().publish(FsEventType::DirCreated, job.to);
+
+        DirWalker walker(job.from);
+        DirWalker::Entry entry;
+        while (walker.next(entry)) {
+            if (!copyable(entry)) {
+                if (entry.dir) walker.skipChildren();
+                continue;
+            }
+            std::string target = job.to + "/" + entry.relative;
+            if (!entry.dir) {
+                copy(entry.path, target, entry.size);
+                continue;
+            }
+            if (mkdir(target.c_str(), 0755) == 0) {
+                job.dirs++;
+                FreeSpaceCache::getInstance().dirChanged(true);
+                FsEventBus::getInstance().publish(FsEventType::DirCreated, target);
+            } else {
+                // 目录建不了，其中的文件都会失败，不再进入
+                job.errors++;
+                walker.skipChildren();
+            }
+        }
+    }
+    free(buffer);
+
+    job.state = job.errors ? "error" : "done";
+    if (job.errors) job.error = "Some entries failed to copy";
+    report(job);
+#ifdef ESP_PLATFORM
+    mclog::tagInfo(TAG, "Copy job {} ({} -> {}) {}: {} files, {} dirs, {} KB, {} errors", job.id, job.from, job.to,
+                   job.state, job.files, job.dirs, job.bytes / 1024, job.errors);
+#endif
+}
+
+}  // namespace book
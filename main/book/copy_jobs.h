@@ -0,0 +1,103 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "delete_jobs.h"
+#include "tar_archive.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace book {
+
+/*
+ * 后台复制：文件或目录树在 SD 卡上直接复制，不经过客户端下载再上传
+ *
+ * 任务先遍历一遍统计文件数和字节数（scanning），剩余空间不够时直接失败；然后按目录在前的顺序建目录、复制文件
+ * （running）。每个文件先写 .part，完整写入后改名，中断时不会留下看似完整的半个文件；复制时边写边算 CRC32C，
+ * 记入目标目录的 .checksums。大于一个块的文件由预读任务读下一块、本任务写当前块。
+ * 不复制 .part、.checksums 和后台删除中的墓碑；目标在源之内的任务直接失败（否则会一直复制到卡满）。
+ * 每复制 COPY_BATCH_SIZE 个文件暂停 COPY_BATCH_PAUSE_MS，把卡让给阅读器。
+ * 任务只在内存中，重启后未完成的复制不再继续，已复制的文件保留。
+ */
+static constexpr size_t COPY_CHUNK_SIZE  = 64 * 1024;
+static constexpr int COPY_BATCH_SIZE     = 8;
+static constexpr int COPY_BATCH_PAUSE_MS = 10;
+static constexpr int COPY_KEEP_FINISHED  = 16;
+
+/**
+ * @brief 把客户端路径规范化为 root 下的完整路径：合并重复的 /，去掉末尾的 /，空路径和 "/" 得到 root 本身
+ * @return 含 . 或 .. 分量时返回 false
+ */
+bool normalize_path(const std::string& root, const std::string& path, std::string& out);
+
+/**
+ * @brief path 是否为 dir 本身或在 dir 之内（按路径分量比较，两者都已规范化）
+ */
+bool path_within(const std::string& path, const std::string& dir);
+
+struct CopyJobStatus {
+    uint32_t id = 0;
+    std::string from;
+    std::string to;
+    std::string state;  // queued / scanning / running / done / error
+    std::string error;  // state 为 error 时的原因
+    uint32_t files      = 0;
+    uint32_t totalFiles = 0;
+    uint32_t dirs       = 0;
+    uint32_t errors     = 0;
+    uint64_t bytes      = 0;
+    uint64_t totalBytes = 0;
+};
+
+class CopyJobQueue {
+public:
+    static CopyJobQueue& getInstance();
+
+    /**
+     * @param batchPauseMs 每批文件之后的暂停（毫秒），0 为不暂停
+     * @param trash 跳过其中墓碑的删除队列，为空时用 DeleteJobQueue::getInstance()
+     */
+    explicit CopyJobQueue(int batchPauseMs = COPY_BATCH_PAUSE_MS, DeleteJobQueue* trash = nullptr)
+        : _batch_pause_ms(batchPauseMs), _trash(trash ? *trash : DeleteJobQueue::getInstance())
+    {
+    }
+    CopyJobQueue(const CopyJobQueue&)            = delete;
+    CopyJobQueue& operator=(const CopyJobQueue&) = delete;
+
+    /**
+     * @brief 排队把 from 复制到 to；to 不能已存在，也不能在 from 之内（由调用方检查）
+     * @return 任务 id
+     */
+    uint32_t enqueue(const std::string& from, const std::string& to);
+
+    bool status(uint32_t id, CopyJobStatus& out);
+    std::vector<CopyJobStatus> jobs();
+    bool busy();
+
+private:
+    std::mutex _mutex;
+    std::map<uint32_t, CopyJobStatus> _jobs;
+    std::vector<uint32_t> _pending;
+    uint32_t _next_id = 1;
+    bool _running     = false;
+    int _batch_pause_ms;
+    DeleteJobQueue& _trash;
+
+    void start();
+    void prune();
+    void run(CopyJobStatus& job);
+    bool copyable(const DirWalker::Entry& entry) const;
+    bool copyFile(const std::string& from, const std::string& to, uint64_t size, uint8_t* buffer,
+                  CopyJobStatus& job);
+    void report(const CopyJobStatus& job);
+
+    static void workerLoop(CopyJobQueue* self);
+};
+
+}  // namespace book
@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "crc32c.h"
+#include <cstring>
+#include <strings.h>
+
+namespace book {
+
+static constexpr uint32_t CRC32C_POLY_REFLECTED = 0x82F63B78;
+
+// entries[0] 为逐字节查表；entries[k][i] 为字节 i 之后再经过 k 个零字节的 CRC，slice-by-8 一次查 8 张
+struct Crc32cTables {
+    uint32_t entries[8][256];
+
+    constexpr Crc32cTables() : entries()
+    {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (CRC32C_POLY_REFLECTED & (0u - (crc & 1)));
+            entries[0][i] = crc;
+        }
+        for (int k = 1; k < 8; k++) {
+            for (int i = 0; i < 256; i++) {
+                uint32_t prev = entries[k - 1][i];
+                entries[k][i] = (prev >> 8) ^ entries[0][prev & 0xFF];
+            }
+        }
+    }
+};
+
+// 编译期生成，放在 flash 中
+static constexpr Crc32cTables TABLES;
+
+static uint32_t crc32c_bytewise(uint32_t crc, const uint8_t* p, size_t len)
+{
+    crc = ~crc;
+    while (len--) crc = TABLES.entries[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+namespace detail {
+
+// 按小端读 8 字节（ESP32-S3 与 x86 都是小端）
+uint32_t crc32c_slice8(uint32_t crc, const uint8_t* p, size_t len)
+{
+    const auto& t = TABLES.entries;
+    crc           = ~crc;
+    while (len && ((uintptr_t)p & 3)) {
+        crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        len--;
+    }
+    while (len >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+    while (len--) crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+}  // namespace detail
+
+bool crc32c_kernel_available(Crc32cKernel kernel)
+{
+    switch (kernel) {
+        case Crc32cKernel::Auto:
+        case Crc32cKernel::Bytewise:
+        case Crc32cKernel::Slice8:
+            return true;
+        case Crc32cKernel::Sse42:
+#if defined(__x86_64__) || defined(__i386__)
+            return __builtin_cpu_supports("sse4.2");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+static Crc32cKernel resolve_kernel()
+{
+    static const Crc32cKernel best =
+        crc32c_kernel_available(Crc32cKernel::Sse42) ? Crc32cKernel::Sse42 : Crc32cKernel::Slice8;
+    return best;
+}
+
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t len, Crc32cKernel kernel)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    if (kernel == Crc32cKernel::Auto) kernel = resolve_kernel();
+    switch (kernel) {
+        case Crc32cKernel::Bytewise:
+            return crc32c_bytewise(crc, p, len);
+        case Crc32cKernel::Sse42:
+            return detail::crc32c_sse42(crc, p, len);
+        default:
+            return detail::crc32c_slice8(crc, p, len);
+    }
+}
+
+const char* crc32c_kernel_name(Crc32cKernel kernel)
+{
+    switch (kernel) {
+        case Crc32cKernel::Auto: return "auto";
+        case Crc32cKernel::Bytewise: return "bytewise";
+        case Crc32cKernel::Slice8: return "slice8";
+        case Crc32cKernel::Sse42: return "sse4.2";
+    }
+    return "unknown";
+}
+
+bool parse_crc32c(const char* text, uint32_t& crc)
+{
+    if (!text) return false;
+    while (*text == ' ') text++;
+    if (strncasecmp(text, "crc32c=", 7) == 0) text += 7;
+    uint32_t value = 0;
+    int digits     = 0;
+    for (; *text && *text != ' '; text++, digits++) {
+        char c = *text;
+        int v  = -1;
+        if (c >= '0' && c <= '9') {
+            v = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            v = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            v = c - 'A' + 10;
+        }
+        if (v < 0 || digits == 8) return false;
+        value = (value << 4) | (uint32_t)v;
+    }
+    while (*text == ' ') text++;
+    if (digits == 0 || *text) return false;
+    crc = value;
+    return true;
+}
+
+}  // namespace book
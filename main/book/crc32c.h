@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace book {
+
+/*
+ * CRC-32C（Castagnoli，多项式 0x1EDC6F41，反射），与 iSCSI / ext4 / 浏览器端的实现一致
+ *
+ * 分块计算时把上一块的结果传入：crc = crc32c_update(crc32c_update(0, a, n), b, m)
+ * ESP32-S3 没有 CRC32C 指令（ROM 中的 crc32_le 是 IEEE 多项式），设备上用 slice-by-8 查表，
+ * 每 8 字节查 8 张表，比逐字节查表少 7/8 的数据依赖；x86 主机上有 SSE4.2 时用 crc32 指令。
+ */
+enum class Crc32cKernel : uint8_t {
+    Auto = 0,
+    Bytewise,  // 参考实现，一张 256 项的表
+    Slice8,    // 8 张表，8KB，放在 flash 中
+    Sse42,     // x86 主机
+};
+
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t len, Crc32cKernel kernel = Crc32cKernel::Auto);
+
+inline uint32_t crc32c(const void* data, size_t len)
+{
+    return crc32c_update(0, data, len);
+}
+
+bool crc32c_kernel_available(Crc32cKernel kernel);
+const char* crc32c_kernel_name(Crc32cKernel kernel);
+
+/**
+ * @brief 解析 8 位以内的十六进制校验和，可带 "crc32c=" 前缀（X-Checksum 请求头的格式）
+ */
+bool parse_crc32c(const char* text, uint32_t& crc);
+
+namespace detail {
+
+uint32_t crc32c_slice8(uint32_t crc, const uint8_t* p, size_t len);
+uint32_t crc32c_sse42(uint32_t crc, const uint8_t* p, size_t len);
+
+}  // namespace detail
+
+}  // namespace book
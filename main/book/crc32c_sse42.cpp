@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "crc32c.h"
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#include <cstring>
+
+namespace book {
+namespace detail {
+
+uint32_t crc32c_sse42(uint32_t crc, const uint8_t* p, size_t len)
+{
+    crc = ~crc;
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        crc64 = _mm_crc32_u64(crc64, v);
+        p += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)crc64;
+#endif
+    while (len >= 4) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        crc = _mm_crc32_u32(crc, v);
+        p += 4;
+        len -= 4;
+    }
+    while (len--) crc = _mm_crc32_u8(crc, *p++);
+    return ~crc;
+}
+
+}  // namespace detail
+}  // namespace book
+
+#else
+
+namespace book {
+namespace detail {
+
+uint32_t crc32c_sse42(uint32_t crc, const uint8_t* p, size_t len)
+{
+    return crc32c_slice8(crc, p, len);
+}
+
+}  // namespace detail
+}  // namespace book
+
+#endif
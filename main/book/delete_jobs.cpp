@@ -0,0 +1,349 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "delete_jobs.h"
+#include "free_space.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+#ifdef ESP_PLATFORM
+#include <mooncake_log.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+namespace book {
+
+static constexpr int STATUS_UPDATE_BATCHES = 4;  // 每删几批写一次任务状态
+
+#ifdef ESP_PLATFORM
+static constexpr int WORKER_STACK_SIZE = 1024 * 6;
+static constexpr int WORKER_PRIORITY   = 1;  // 低于 HTTP 服务器和界面
+static const char* TAG                 = "DeleteJobs";
+#endif
+
+static void pause_ms(int ms)
+{
+#ifdef ESP_PLATFORM
+    vTaskDelay(pdMS_TO_TICKS(ms) > 0 ? pdMS_TO_TICKS(ms) : 1);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+}
+
+static bool finished(const DeleteJobStatus& job)
+{
+    return job.state == "done" || job.state == "error";
+}
+
+DeleteJobQueue& DeleteJobQueue::getInstance()
+{
+    static DeleteJobQueue instance;
+    return instance;
+}
+
+DeleteJobQueue::DeleteJobQueue(const std::string& trashDir) : _trash_dir(trashDir)
+{
+    while (_trash_dir.size() > 1 && _trash_dir.back() == '/') _trash_dir.pop_back();
+}
+
+bool DeleteJobQueue::isTrashPath(const std::string& path) const
+{
+    std::string p = path;
+    while (p.size() > 1 && p.back() == '/') p.pop_back();
+    return p.compare(0, _trash_dir.size(), _trash_dir) == 0 &&
+           (p.size() == _trash_dir.size() || p[_trash_dir.size()] == '/');
+}
+
+void DeleteJobQueue::writeStatus(const DeleteJobStatus& job)
+{
+    // 先写临时文件再改名，断电时不会留下半个状态文件
+    std::string path = _trash_dir + "/" + std::to_string(job.id) + ".job";
+    std::string temp = path + ".tmp";
+    FILE* f          = fopen(temp.c_str(), "wb");
+    if (!f) return;
+    fprintf(f, "%s\n%s %u %u %u\n", job.path.c_str(), job.state.c_str(), (unsigned)job.files, (unsigned)job.dirs,
+            (unsigned)job.errors);
+    fclose(f);
+    remove(path.c_str());  // FAT 上 rename 不覆盖已有文件
+    rename(temp.c_str(), path.c_str());
+}
+
+void DeleteJobQueue::load()
+{
+    if (_loaded) return;
+    _loaded = true;
+
+    DIR* dir = opendir(_trash_dir.c_str());
+    if (!dir) return;
+    std::set<uint32_t> tombstones;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        char* end   = nullptr;
+        uint32_t id = (uint32_t)strtoul(entry->d_name, &end, 10);
+        if (id == 0 || end == entry->d_name) continue;
+        _next_id = std::max(_next_id, id + 1);
+        if (*end == 0) {
+            tombstones.insert(id);
+            continue;
+        }
+        if (strcmp(end, ".job.tmp") == 0) remove((_trash_dir + "/" + entry->d_name).c_str());
+        if (strcmp(end, ".job") != 0) continue;
+
+        FILE* f = fopen((_trash_dir + "/" + entry->d_name).c_str(), "rb");
+        if (!f) continue;
+        DeleteJobStatus job;
+        job.id = id;
+        char line[512];
+        if (fgets(line, sizeof(line), f)) {
+            line[strcspn(line, "\r\n")] = 0;
+            job.path                    = line;
+        }
+        char state[16] = {0};
+        unsigned files = 0, dirs = 0, errors = 0;
+        if (fscanf(f, "%15s %u %u %u", state, &files, &dirs, &errors) >= 1) job.state = state;
+        fclose(f);
+        job.files  = files;
+        job.dirs   = dirs;
+        job.errors = errors;
+        if (job.state.empty()) job.state = "queued";
+        _jobs[id] = job;
+    }
+    closedir(dir);
+
+    for (auto& [id, job] : _jobs) {
+        if (finished(job)) continue;
+        if (tombstones.count(id)) {
+            _pending.push_back(id);
+        } else {
+            // 写完状态、改名之前断电：原路径没有动
+            job.state = "error";
+            writeStatus(job);
+        }
+    }
+    // 没有状态文件的墓碑（状态文件丢失）也要删掉
+    for (uint32_t id : tombstones) {
+        if (_jobs.count(id)) continue;
+        DeleteJobStatus job;
+        job.id    = id;
+        job.state = "queued";
+        _jobs[id] = job;
+        writeStatus(job);
+        _pending.push_back(id);
+    }
+}
+
+void DeleteJobQueue::prune()
+{
+    int finishedCount = 0;
+    for (auto& [id, job] : _jobs) {
+        if (finished(job)) finishedCount++;
+    }
+    for (auto it = _jobs.begin(); it != _jobs.end() && finishedCount > DELETE_KEEP_FINISHED;) {
+        // 出错的墓碑还在 .trash 中，保留它的状态
+        if (it->second.state == "done") {
+            remove((_trash_dir + "/" + std::to_string(it->first) + ".job").c_str());
+            it = _jobs.erase(it);
+            finishedCount--;
+        } else {
+            ++it;
+        }
+    }
+}
+
+uint32_t DeleteJobQueue::enqueue(const std::string& path)
+{
+    if (isTrashPath(path)) return 0;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    load();
+    mkdir(_trash_dir.c_str(), 0755);
+
+    DeleteJobStatus job;
+    job.id    = _next_id;
+    job.path  = path;
+    job.state = "queued";
+    writeStatus(job);
+    std::string tombstone = _trash_dir + "/" + std::to_string(job.id);
+    if (rename(path.c_str(), tombstone.c_str()) != 0) {
+        remove((_trash_dir + "/" + std::to_string(job.id) + ".job").c_str());
+        return 0;
+    }
+    _next_id++;
+
+    _jobs[job.id] = job;
+    _pending.push_back(job.id);
+    prune();
+    start();
+    return job.id;
+}
+
+void DeleteJobQueue::resume()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    load();
+    if (!_pending.empty()) start();
+}
+
+bool DeleteJobQueue::status(uint32_t id, DeleteJobStatus& out)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    load();
+    auto it = _jobs.find(id);
+    if (it == _jobs.end()) return false;
+    out = it->second;
+    return true;
+}
+
+std::vector<DeleteJobStatus> DeleteJobQueue::jobs()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    load();
+    std::vector<DeleteJobStatus> out;
+    for (auto& [id, job] : _jobs) out.push_back(job);
+    return out;
+}
+
+bool DeleteJobQueue::busy()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _running;
+}
+
+// 调用方持有 _mutex
+void DeleteJobQueue::start()
+{
+    if (_running) return;
+    _running = true;
+#ifdef ESP_PLATFORM
+    BaseType_t ok = xTaskCreate(
+        [](void* arg) {
+            workerLoop((DeleteJobQueue*)arg);
+            vTaskDelete(NULL);
+        },
+        "delete_jobs", WORKER_STACK_SIZE, this, WORKER_PRIORITY, NULL);
+    if (ok != pdPASS) {
+        mclog::tagError(TAG, "Failed to start delete task");
+        _running = false;
+    }
+#else
+    std::thread(workerLoop, this).detach();
+#endif
+}
+
+void DeleteJobQueue::workerLoop(DeleteJobQueue* self)
+{
+    while (true) {
+        DeleteJobStatus job;
+        {
+            std::lock_guard<std::mutex> lock(self->_mutex);
+            if (self->_pending.empty()) {
+                self->_running = false;
+                return;
+            }
+            job = self->_jobs[self->_pending.front()];
+            self->_pending.erase(self->_pending.begin());
+        }
+        self->run(job);
+    }
+}
+
+void DeleteJobQueue::run(DeleteJobStatus& job)
+{
+    std::string tombstone = _trash_dir + "/" + std::to_string(job.id);
+    auto report           = [&](bool persist) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs[job.id] = job;
+        if (persist) writeStatus(job);
+    };
+    job.state = "running";
+    report(true);
+
+    // 墓碑本身是文件（删除的是单个大文件）
+    struct stat st;
+    if (stat(tombstone.c_str(), &st) == 0 && !S_ISDIR(st.st_mode)) {
+        if (remove(tombstone.c_str()) == 0) {
+            job.files++;
+        } else {
+            job.errors++;
+        }
+    }
+
+    // 深度优先，只保持一个目录打开；进入子目录时关闭父目录，回来后从头读，已删除的条目不再出现
+    std::vector<std::string> stack;
+    std::set<std::string> failed;  // 删不掉的条目，重读目录时跳过
+    if (access(tombstone.c_str(), F_OK) == 0) stack.push_back(tombstone);
+    int batch   = 0;
+    int batches = 0;
+    while (!stack.empty()) {
+        std::string dirPath = stack.back();
+        DIR* dir            = opendir(dirPath.c_str());
+        if (!dir) {
+            job.errors++;
+            failed.insert(dirPath);
+            stack.pop_back();
+            continue;
+        }
+
+        bool descended = false;
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+            std::string child = dirPath + "/" + entry->d_name;
+            if (failed.count(child)) continue;
+
+            bool isDir = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN) {
+                isDir = stat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+            }
+            if (isDir) {
+                stack.push_back(child);
+                descended = true;
+                break;
+            }
+            if (unlink(child.c_str()) == 0) {
+                job.files++;
+            } else {
+                job.errors++;
+                failed.insert(child);
+            }
+            if (++batch == DELETE_BATCH_SIZE) {
+                batch = 0;
+                report(++batches % STATUS_UPDATE_BATCHES == 0);
+                pause_ms(DELETE_BATCH_PAUSE_MS);
+            }
+        }
+        closedir(dir);
+        if (descended) continue;
+
+        if (rmdir(dirPath.c_str()) == 0) {
+            job.dirs++;
+        } else {
+            job.errors++;
+            failed.insert(dirPath);
+        }
+        stack.pop_back();
+    }
+
+    job.state = job.errors ? "error" : "done";
+    report(true);
+    // 逐条删除时不 stat，不知道释放了多少空间
+    FreeSpaceCache::getInstance().invalidate();
+#ifdef ESP_PLATFORM
+    mclog::tagInfo(TAG, "Delete job {} ({}) {}: {} files, {} dirs, {} errors", job.id, job.path, job.state,
+                   job.files, job.dirs, job.errors);
+#endif
+}
+
+}  // namespace book
@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace book {
+
+/*
+ * 后台删除：大目录（一本书常有上千个文件）不在 HTTP 处理函数里逐个删除
+ *
+ *   .trash/
+ *   ├── {id}/             墓碑：原目录改名而来，原路径立即消失
+ *   └── {id}.job          任务状态：第一行原路径，第二行 "状态 已删文件数 已删目录数 错误数"
+ *
+ * enqueue() 先写任务状态再改名（同一卷内改名只改目录项），随即返回；工作任务以低优先级逐个删除墓碑：
+ * 只保持一个目录打开，用 readdir 的 d_type 区分文件和目录，不对每个条目 stat；每删 DELETE_BATCH_SIZE 个条目
+ * 暂停 DELETE_BATCH_PAUSE_MS，把卡让给阅读器和其它请求。进度定期写回任务状态，
+ * 重启后 resume() 继续未完成的墓碑。删除失败的条目跳过，任务结束为 error，墓碑保留在 .trash 中。
+ * 完成的任务只保留最近 DELETE_KEEP_FINISHED 个。
+ */
+static constexpr const char* DELETE_TRASH_DIR = "/sdcard/.trash";
+static constexpr int DELETE_BATCH_SIZE        = 32;
+static constexpr int DELETE_BATCH_PAUSE_MS    = 10;
+static constexpr int DELETE_KEEP_FINISHED     = 16;
+
+struct DeleteJobStatus {
+    uint32_t id = 0;
+    std::string path;  // 原路径
+    std::string state;  // queued / running / done / error
+    uint32_t files  = 0;
+    uint32_t dirs   = 0;
+    uint32_t errors = 0;
+};
+
+class DeleteJobQueue {
+public:
+    static DeleteJobQueue& getInstance();
+
+    /**
+     * @param trashDir 墓碑目录，须与要删除的路径在同一卷上
+     */
+    explicit DeleteJobQueue(const std::string& trashDir = DELETE_TRASH_DIR);
+    DeleteJobQueue(const DeleteJobQueue&)            = delete;
+    DeleteJobQueue& operator=(const DeleteJobQueue&) = delete;
+
+    /**
+     * @brief 把 path 改名为墓碑并排队
+     * @return 任务 id，改名失败时返回 0（path 不变）
+     */
+    uint32_t enqueue(const std::string& path);
+
+    /**
+     * @brief 读取 .trash 中的任务，继续重启前未完成的删除；SD 卡挂载后调用一次
+     */
+    void resume();
+
+    bool status(uint32_t id, DeleteJobStatus& out);
+    std::vector<DeleteJobStatus> jobs();
+    bool busy();
+
+    /**
+     * @brief path 是否为墓碑目录或在其中（不允许通过文件接口改动）
+     */
+    bool isTrashPath(const std::string& path) const;
+
+private:
+    std::string _trash_dir;
+    std::mutex _mutex;
+    std::map<uint32_t, DeleteJobStatus> _jobs;
+    std::vector<uint32_t> _pending;
+    uint32_t _next_id = 1;
+    bool _loaded      = false;
+    bool _running     = false;
+
+    void load();
+    void start();
+    void prune();
+    void writeStatus(const DeleteJobStatus& job);
+    void run(DeleteJobStatus& job);
+
+    static void workerLoop(DeleteJobQueue* self);
+};
+
+}  // namespace book
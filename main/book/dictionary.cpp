@@ -0,0 +1,467 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "dictionary.h"
+#include "text_book.h"
+#include "varint.h"
+#include <algorithm>
+#include <cstring>
+
+namespace book {
+
+static inline uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void append_u32(std::vector<uint8_t>& out, uint32_t v)
+{
+    uint8_t buf[4];
+    put_u32(buf, v);
+    out.insert(out.end(), buf, buf + 4);
+}
+
+// 拉丁字母组成的单词整体取词；撇号和连字符在单词内部时算作单词的一部分
+static inline bool is_word_char(uint32_t cp)
+{
+    return (cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 0xC0 && cp < 0x250);
+}
+
+static int compare_key(const std::string& key, const char* data, size_t size)
+{
+    int c = memcmp(key.data(), data, std::min(key.size(), size));
+    if (c != 0) return c;
+    return key.size() < size ? -1 : (key.size() > size ? 1 : 0);
+}
+
+std::string fold_dictionary_key(const std::string& word)
+{
+    std::string key;
+    const uint8_t* p = (const uint8_t*)word.data();
+    bool space       = false;
+    for (size_t pos = 0; pos < word.size();) {
+        uint32_t codepoint = 0;
+        size_t n           = decode_text_char(TextEncoding::Utf8, p + pos, word.size() - pos, codepoint);
+        if (n == 0) break;
+        pos += n;
+        codepoint = fold_search_char(codepoint);
+        if (codepoint == ' ') {
+            space = !key.empty();
+            continue;
+        }
+        if (codepoint == 0) continue;
+        if (space) key.push_back(' ');
+        space = false;
+        char utf8[4];
+        key.append(utf8, encode_utf8(codepoint, utf8));
+    }
+    return key;
+}
+
+std::string dictionary_text_at(const std::string& line, size_t offset)
+{
+    // 逐字解码，记下各字的起点
+    std::vector<size_t> starts;
+    std::vector<uint32_t> chars;
+    const uint8_t* p = (const uint8_t*)line.data();
+    for (size_t pos = 0; pos < line.size();) {
+        uint32_t codepoint = 0;
+        size_t n           = decode_text_char(TextEncoding::Utf8, p + pos, line.size() - pos, codepoint);
+        if (n == 0) break;
+        starts.push_back(pos);
+        chars.push_back(fold_search_char(codepoint));
+        pos += n;
+    }
+    starts.push_back(line.size());
+
+    size_t at = std::upper_bound(starts.begin(), starts.end() - 1, offset) - starts.begin();
+    if (at == 0 || at > chars.size()) return std::string();
+    at--;
+
+    if (is_word_char(chars[at])) {
+        auto inWord = [&](size_t i) {
+            if (is_word_char(chars[i])) return true;
+            bool joiner = chars[i] == '\'' || chars[i] == '-';
+            return joiner && i > 0 && i + 1 < chars.size() && is_word_char(chars[i - 1]) && is_word_char(chars[i + 1]);
+        };
+        size_t first = at;
+        size_t last  = at + 1;
+        while (first > 0 && inWord(first - 1)) first--;
+        while (last < chars.size() && inWord(last)) last++;
+        return line.substr(starts[first], starts[last] - starts[first]);
+    }
+
+    // 中文：从所在的字开始往后取，遇到空白为止
+    size_t last = at;
+    while (last < chars.size() && last - at < DICTIONARY_MAX_LOOKUP_CHARS && chars[last] != ' ' && chars[last] != 0) {
+        last++;
+    }
+    return line.substr(starts[at], starts[last] - starts[at]);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  编译                                      */
+/* -------------------------------------------------------------------------- */
+
+bool write_dictionary(const std::string& path, const std::string& name, std::vector<DictionaryEntry>& entries,
+                      DictionaryBuildStats& stats, std::string& error)
+{
+    stats               = DictionaryBuildStats();
+    stats.sourceEntries = (uint32_t)entries.size();
+
+    // 归一化词头，丢掉空的和过长的
+    size_t kept = 0;
+    for (auto& entry : entries) {
+        entry.headword = fold_dictionary_key(entry.headword);
+        if (entry.headword.empty() || entry.headword.size() > DICTIONARY_MAX_KEY_BYTES || entry.definition.empty()) {
+            stats.skipped++;
+            continue;
+        }
+        if (&entries[kept] != &entry) entries[kept] = std::move(entry);
+        kept++;
+    }
+    entries.resize(kept);
+
+    // 排序后合并相同的词头，保持原词典中的先后顺序
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const DictionaryEntry& a, const DictionaryEntry& b) { return a.headword < b.headword; });
+    size_t count = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (count > 0 && entries[count - 1].headword == entries[i].headword) {
+            entries[count - 1].definition += "\n\n";
+            entries[count - 1].definition += entries[i].definition;
+            stats.merged++;
+            continue;
+        }
+        if (count != i) entries[count] = std::move(entries[i]);
+        count++;
+    }
+    entries.resize(count);
+    if (entries.empty()) {
+        error = "No entries";
+        return false;
+    }
+
+    // 块目录、块首词头和前缀压缩的键区
+    std::vector<uint8_t> directory;
+    std::vector<uint8_t> firstKeys;
+    std::vector<uint8_t> keys;
+    uint64_t definitions = 0;
+    const std::string* previous = nullptr;
+    for (size_t i = 0; i < entries.size(); i++) {
+        const std::string& key = entries[i].headword;
+        size_t prefix          = 0;
+        if (i % DICTIONARY_BLOCK_SIZE == 0) {
+            append_u32(directory, (uint32_t)keys.size());
+            append_u32(directory, (uint32_t)definitions);
+            firstKeys.push_back((uint8_t)key.size());
+            firstKeys.insert(firstKeys.end(), key.begin(), key.end());
+        } else {
+            size_t limit = std::min(previous->size(), key.size());
+            while (prefix < limit && (*previous)[prefix] == key[prefix]) prefix++;
+        }
+        append_varint(keys, (uint32_t)prefix);
+        append_varint(keys, (uint32_t)(key.size() - prefix));
+        keys.insert(keys.end(), key.begin() + prefix, key.end());
+        append_varint(keys, (uint32_t)entries[i].definition.size());
+        definitions += entries[i].definition.size();
+        stats.idxBytes += key.size() + 9;
+        previous = &key;
+    }
+    if (definitions > UINT32_MAX) {
+        error = "Definitions exceed 4 GB";
+        return false;
+    }
+
+    std::string title = name.substr(0, 0xFFFF);
+    uint8_t header[DICTIONARY_HEADER_SIZE] = {0};
+    memcpy(header, "PS3D", 4);
+    put_u16(header + 4, DICTIONARY_VERSION);
+    put_u16(header + 6, DICTIONARY_BLOCK_SIZE);
+    put_u32(header + 8, (uint32_t)entries.size());
+    put_u32(header + 12, (uint32_t)(directory.size() / DICTIONARY_BLOCK_ENTRY_SIZE));
+    put_u32(header + 16, (uint32_t)firstKeys.size());
+    put_u32(header + 20, (uint32_t)keys.size());
+    put_u32(header + 24, (uint32_t)definitions);
+    put_u16(header + 28, (uint16_t)title.size());
+
+    std::string tmpPath = path + ".tmp";
+    FILE* f             = fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        error = "Failed to create " + tmpPath;
+        return false;
+    }
+    bool ok = fwrite(header, 1, sizeof(header), f) == sizeof(header) &&
+              fwrite(title.data(), 1, title.size(), f) == title.size() &&
+              fwrite(directory.data(), 1, directory.size(), f) == directory.size() &&
+              fwrite(firstKeys.data(), 1, firstKeys.size(), f) == firstKeys.size() &&
+              fwrite(keys.data(), 1, keys.size(), f) == keys.size();
+    for (size_t i = 0; ok && i < entries.size(); i++) {
+        const std::string& definition = entries[i].definition;
+        ok = fwrite(definition.data(), 1, definition.size(), f) == definition.size();
+    }
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        ::remove(tmpPath.c_str());
+        error = "Failed to write " + tmpPath;
+        return false;
+    }
+    ::remove(path.c_str());
+    if (::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        error = "Failed to rename " + tmpPath;
+        return false;
+    }
+
+    stats.entries       = (uint32_t)entries.size();
+    stats.blocks        = (uint32_t)(directory.size() / DICTIONARY_BLOCK_ENTRY_SIZE);
+    stats.keyBytes      = keys.size();
+    stats.bytes         = sizeof(header) + title.size() + directory.size() + firstKeys.size() + keys.size() + definitions;
+    stats.residentBytes = directory.size() + firstKeys.size() + stats.blocks * sizeof(uint32_t);
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  查词                                      */
+/* -------------------------------------------------------------------------- */
+
+Dictionary::~Dictionary()
+{
+    close();
+}
+
+bool Dictionary::open(const std::string& path)
+{
+    close();
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    uint8_t header[DICTIONARY_HEADER_SIZE];
+    fseek(f, 0, SEEK_END);
+    long fileSize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) || memcmp(header, "PS3D", 4) != 0 ||
+        get_u16(header + 4) != DICTIONARY_VERSION || get_u16(header + 6) == 0) {
+        fclose(f);
+        return false;
+    }
+    _block_entries       = get_u16(header + 6);
+    _entry_count         = get_u32(header + 8);
+    uint32_t blocks      = get_u32(header + 12);
+    uint32_t firstSize   = get_u32(header + 16);
+    _keys_size           = get_u32(header + 20);
+    _defs_size           = get_u32(header + 24);
+    uint32_t nameSize    = get_u16(header + 28);
+    uint64_t directory   = DICTIONARY_HEADER_SIZE + (uint64_t)nameSize;
+    uint64_t keysStart   = directory + (uint64_t)blocks * DICTIONARY_BLOCK_ENTRY_SIZE + firstSize;
+    uint64_t defsStart   = keysStart + _keys_size;
+    if (fileSize < 0 || (uint64_t)fileSize != defsStart + _defs_size || _entry_count == 0 ||
+        blocks != (_entry_count + _block_entries - 1) / _block_entries) {
+        fclose(f);
+        return false;
+    }
+    _keys_start = (uint32_t)keysStart;
+    _defs_start = (uint32_t)defsStart;
+
+    // 词典名、块目录和块首词头连续存放，一次读入
+    std::vector<uint8_t> data((size_t)(keysStart - DICTIONARY_HEADER_SIZE));
+    bool ok = fread(data.data(), 1, data.size(), f) == data.size();
+    if (ok) {
+        _name.assign((const char*)data.data(), nameSize);
+        _block_offsets.resize(blocks);
+        _block_definitions.resize(blocks);
+        const uint8_t* p = data.data() + nameSize;
+        for (uint32_t i = 0; ok && i < blocks; i++) {
+            _block_offsets[i]     = get_u32(p + i * DICTIONARY_BLOCK_ENTRY_SIZE);
+            _block_definitions[i] = get_u32(p + i * DICTIONARY_BLOCK_ENTRY_SIZE + 4);
+            ok = _block_offsets[i] <= _keys_size && _block_definitions[i] <= _defs_size &&
+                 (i == 0 || _block_offsets[i] > _block_offsets[i - 1]);
+        }
+
+        const uint8_t* first = p + (size_t)blocks * DICTIONARY_BLOCK_ENTRY_SIZE;
+        size_t pos           = 0;
+        _first_keys.reserve(blocks + 1);
+        for (uint32_t i = 0; ok && i < blocks; i++) {
+            ok = pos < firstSize && pos + 1 + first[pos] <= firstSize;
+            if (!ok) break;
+            _first_keys.push_back((uint32_t)_first_key_data.size());
+            _first_key_data.append((const char*)first + pos + 1, first[pos]);
+            pos += 1 + first[pos];
+        }
+        _first_keys.push_back((uint32_t)_first_key_data.size());
+        ok = ok && pos == firstSize;
+    }
+    if (!ok) {
+        fclose(f);
+        close();
+        return false;
+    }
+    _file  = f;
+    _reads = 0;
+    return true;
+}
+
+void Dictionary::close()
+{
+    if (_file) fclose(_file);
+    _file = nullptr;
+    _name.clear();
+    _entry_count = 0;
+    _block_offsets.clear();
+    _block_definitions.clear();
+    _first_keys.clear();
+    _first_key_data.clear();
+    for (auto& block : _cache) {
+        block.index = UINT32_MAX;
+        block.entries.clear();
+    }
+    _cache_next = 0;
+}
+
+size_t Dictionary::memoryBytes() const
+{
+    size_t bytes = (_block_offsets.capacity() + _block_definitions.capacity() + _first_keys.capacity()) * 4 +
+                   _first_key_data.capacity();
+    for (const auto& block : _cache) {
+        for (const auto& entry : block.entries) bytes += sizeof(KeyEntry) + entry.key.capacity();
+    }
+    return bytes;
+}
+
+bool Dictionary::findBlock(const std::string& key, uint32_t& block) const
+{
+    // 第一个块首词头 > key 的块
+    size_t low  = 0;
+    size_t high = _block_offsets.size();
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (compare_key(key, _first_key_data.data() + _first_keys[mid], _first_keys[mid + 1] - _first_keys[mid]) < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    if (low == 0) return false;
+    block = (uint32_t)(low - 1);
+    return true;
+}
+
+const Dictionary::Block* Dictionary::loadBlock(uint32_t index)
+{
+    for (const auto& block : _cache) {
+        if (block.index == index) return &block;
+    }
+
+    uint32_t start = _block_offsets[index];
+    uint32_t end   = index + 1 < _block_offsets.size() ? _block_offsets[index + 1] : _keys_size;
+    std::vector<uint8_t> data(end - start);
+    _reads++;
+    if (fseek(_file, (long)(_keys_start + start), SEEK_SET) != 0 ||
+        fread(data.data(), 1, data.size(), _file) != data.size()) {
+        return nullptr;
+    }
+
+    Block& block = _cache[_cache_next];
+    _cache_next  = (_cache_next + 1) % DICTIONARY_BLOCK_CACHE;
+    block.index  = UINT32_MAX;
+    block.entries.clear();
+
+    uint32_t count  = std::min<uint32_t>(_block_entries, _entry_count - index * _block_entries);
+    uint32_t offset = _block_definitions[index];
+    std::string key;
+    size_t pos = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t prefix = 0, suffix = 0, size = 0;
+        size_t n = read_varint(&data[pos], data.size() - pos, prefix);
+        if (n == 0 || prefix > key.size()) return nullptr;
+        pos += n;
+        n = read_varint(&data[pos], data.size() - pos, suffix);
+        if (n == 0 || pos + n + suffix > data.size()) return nullptr;
+        pos += n;
+        key.resize(prefix);
+        key.append((const char*)&data[pos], suffix);
+        pos += suffix;
+        n = read_varint(&data[pos], data.size() - pos, size);
+        if (n == 0 || (uint64_t)offset + size > _defs_size) return nullptr;
+        pos += n;
+
+        KeyEntry entry;
+        entry.key    = key;
+        entry.offset = offset;
+        entry.size   = size;
+        block.entries.push_back(std::move(entry));
+        offset += size;
+    }
+    block.index = index;
+    return &block;
+}
+
+const Dictionary::KeyEntry* Dictionary::findInBlock(const std::string& key)
+{
+    uint32_t index = 0;
+    if (!_file || key.empty() || !findBlock(key, index)) return nullptr;
+    const Block* block = loadBlock(index);
+    if (!block) return nullptr;
+    auto it = std::lower_bound(block->entries.begin(), block->entries.end(), key,
+                               [](const KeyEntry& entry, const std::string& k) { return entry.key < k; });
+    return it != block->entries.end() && it->key == key ? &*it : nullptr;
+}
+
+bool Dictionary::readDefinition(const KeyEntry& key, DictionaryEntry& entry)
+{
+    entry.headword = key.key;
+    entry.definition.resize(key.size);
+    _reads++;
+    return fseek(_file, (long)(_defs_start + key.offset), SEEK_SET) == 0 &&
+           fread(&entry.definition[0], 1, key.size, _file) == key.size;
+}
+
+bool Dictionary::lookup(const std::string& word, DictionaryEntry& entry)
+{
+    const KeyEntry* key = findInBlock(fold_dictionary_key(word));
+    return key && readDefinition(*key, entry);
+}
+
+bool Dictionary::lookupLongest(const std::string& text, DictionaryEntry& entry, size_t maxChars)
+{
+    std::string folded = fold_dictionary_key(text);
+
+    // 各字的结束位置，从最长的前缀开始试
+    std::vector<size_t> ends;
+    for (size_t pos = 0; pos < folded.size() && ends.size() < maxChars;) {
+        uint32_t codepoint = 0;
+        size_t n = decode_text_char(TextEncoding::Utf8, (const uint8_t*)folded.data() + pos, folded.size() - pos,
+                                    codepoint);
+        if (n == 0) break;
+        pos += n;
+        ends.push_back(pos);
+    }
+    for (size_t i = ends.size(); i > 0; i--) {
+        if (folded[ends[i - 1] - 1] == ' ') continue;
+        const KeyEntry* key = findInBlock(folded.substr(0, ends[i - 1]));
+        if (key) return readDefinition(*key, entry);
+    }
+    return false;
+}
+
+}  // namespace book
@@ -0,0 +1,170 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace book {
+
+/*
+ * 离线词典：/sdcard/dict/ 目录下的 .pdict 文件，由主机端 dict_compiler 从 StarDict / TSV 词典编译
+ *
+ * 词条按归一化后的词头（fold_dictionary_key）字节序排列，每 B 条一块，块内词头前缀压缩：
+ * 每条只存与上一条的公共前缀长度和其余字节。块目录和各块的首个词头常驻内存，
+ * 查词时在内存中二分找到块，读一次块（几百字节）解出词头，命中后再读一次释义。
+ * 文件格式（小端）：
+ *
+ *   0   char[4]  "PS3D"
+ *   4   u16      版本（1）
+ *   6   u16      每块词条数 B
+ *   8   u32      词条数 N
+ *   12  u32      块数 M = ⌈N / B⌉
+ *   16  u32      块首词头区字节数 F
+ *   20  u32      键区字节数 K
+ *   24  u32      释义区字节数 D
+ *   28  u16      词典名字节数 L
+ *   30  u16      保留（0）
+ *   32  L 字节   词典名（UTF-8）
+ *       M × { u32 块起点（相对键区）, u32 块内第一条释义的起点（相对释义区） }
+ *       F 字节   各块第一个词头：{ u8 长度, 词头 }
+ *       K 字节   键区：每条 { varint 与上一条的公共前缀字节数, varint 其余字节数, 其余字节, varint 释义字节数 }，
+ *                块内第一条的公共前缀为 0
+ *       D 字节   释义区：UTF-8，各词条首尾相接，按词条顺序
+ *
+ * 词头最长 DICTIONARY_MAX_KEY_BYTES 字节；同一归一化词头的多个原词条在编译时合并，释义以空行分隔。
+ */
+static constexpr uint32_t DICTIONARY_VERSION          = 1;
+static constexpr size_t DICTIONARY_HEADER_SIZE        = 32;
+static constexpr size_t DICTIONARY_BLOCK_ENTRY_SIZE   = 8;
+static constexpr size_t DICTIONARY_BLOCK_SIZE         = 32;
+static constexpr size_t DICTIONARY_MAX_KEY_BYTES      = 255;
+static constexpr size_t DICTIONARY_MAX_LOOKUP_CHARS   = 8;  // 中文取词时最多尝试的字数
+static constexpr size_t DICTIONARY_BLOCK_CACHE        = 4;
+static constexpr const char* DICTIONARY_DIR           = "/sdcard/dict";
+static constexpr const char* DICTIONARY_EXTENSION     = ".pdict";
+
+struct DictionaryEntry {
+    std::string headword;    // 归一化后的词头
+    std::string definition;  // UTF-8
+};
+
+/**
+ * @brief 词头归一化：逐字 fold_search_char（英文小写、全角转半角），连续空白合并为一个空格并去掉首尾空白
+ */
+std::string fold_dictionary_key(const std::string& word);
+
+/**
+ * @brief 从一行文字的 offset 处取词：落在英文单词中时取整个单词，否则取从 offset 开始的至多
+ *        DICTIONARY_MAX_LOOKUP_CHARS 个字符，交给 Dictionary::lookupLongest
+ */
+std::string dictionary_text_at(const std::string& line, size_t offset);
+
+struct DictionaryBuildStats {
+    uint32_t sourceEntries = 0;  // 输入的词条数
+    uint32_t entries       = 0;  // 合并后的词条数
+    uint32_t merged        = 0;  // 因归一化后词头相同而合并的词条
+    uint32_t skipped       = 0;  // 词头为空或过长
+    uint32_t blocks        = 0;
+    uint64_t keyBytes      = 0;  // 前缀压缩后的键区
+    uint64_t idxBytes      = 0;  // 同样词条的 StarDict .idx 大小（词头 + 0 + 8 字节偏移和长度），作比较
+    uint64_t bytes         = 0;  // 文件大小
+    size_t residentBytes   = 0;  // 打开后常驻内存（块目录 + 块首词头）
+};
+
+/**
+ * @brief 排序、合并后写出词典文件（主机端编译器使用），先写 .tmp 再改名
+ * @param entries 词头为原文，写入前就地归一化和排序
+ */
+bool write_dictionary(const std::string& path, const std::string& name, std::vector<DictionaryEntry>& entries,
+                      DictionaryBuildStats& stats, std::string& error);
+
+/**
+ * @brief 只读访问词典文件
+ */
+class Dictionary {
+public:
+    Dictionary() = default;
+    ~Dictionary();
+    Dictionary(const Dictionary&)            = delete;
+    Dictionary& operator=(const Dictionary&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const
+    {
+        return _file != nullptr;
+    }
+
+    const std::string& name() const
+    {
+        return _name;
+    }
+    uint32_t entryCount() const
+    {
+        return _entry_count;
+    }
+
+    /**
+     * @brief 按归一化后的词头精确查找
+     */
+    bool lookup(const std::string& word, DictionaryEntry& entry);
+
+    /**
+     * @brief 查找是 text 前缀的最长词头（至多 maxChars 个字符），用于中文取词
+     */
+    bool lookupLongest(const std::string& text, DictionaryEntry& entry,
+                       size_t maxChars = DICTIONARY_MAX_LOOKUP_CHARS);
+
+    size_t memoryBytes() const;
+    /**
+     * @brief 累计读卡次数
+     */
+    uint32_t reads() const
+    {
+        return _reads;
+    }
+
+private:
+    struct KeyEntry {
+        std::string key;
+        uint32_t offset = 0;  // 释义在释义区中的起点
+        uint32_t size   = 0;
+    };
+    struct Block {
+        uint32_t index = UINT32_MAX;
+        std::vector<KeyEntry> entries;
+    };
+
+    FILE* _file = nullptr;
+    std::string _name;
+    uint32_t _entry_count    = 0;
+    uint32_t _block_entries  = 0;
+    uint32_t _keys_start     = 0;
+    uint32_t _keys_size      = 0;
+    uint32_t _defs_start     = 0;
+    uint32_t _defs_size      = 0;
+    std::vector<uint32_t> _block_offsets;      // 块起点（相对键区）
+    std::vector<uint32_t> _block_definitions;  // 块内第一条释义的起点
+    std::vector<uint32_t> _first_keys;         // 块首词头在 _first_key_data 中的起点，多一项作结尾
+    std::string _first_key_data;
+    Block _cache[DICTIONARY_BLOCK_CACHE];  // 最近读过的块，取词时各前缀通常落在同一块
+    size_t _cache_next = 0;
+    uint32_t _reads    = 0;
+
+    /**
+     * @brief 第一个词头 > key 的块之前的那一块，即可能含 key 的块；key 小于所有词头时返回 false
+     */
+    bool findBlock(const std::string& key, uint32_t& block) const;
+    const Block* loadBlock(uint32_t block);
+    const KeyEntry* findInBlock(const std::string& key);
+    bool readDefinition(const KeyEntry& key, DictionaryEntry& entry);
+};
+
+}  // namespace book
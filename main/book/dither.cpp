@@ -0,0 +1,263 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "dither.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace book {
+namespace detail {
+
+// clang-format off
+const uint8_t BAYER8[8][8] = {
+    {  1, 129,  33, 161,   9, 137,  41, 169},
+    {193,  65, 225,  97, 201,  73, 233, 105},
+    { 49, 177,  17, 145,  57, 185,  25, 153},
+    {241, 113, 209,  81, 249, 121, 217,  89},
+    { 13, 141,  45, 173,   5, 133,  37, 165},
+    {205,  77, 237, 109, 197,  69, 229, 101},
+    { 61, 189,  29, 157,  53, 181,  21, 149},
+    {253, 125, 221,  93, 245, 117, 213,  85},
+};
+// clang-format on
+
+// 量化公式（所有实现共用）：
+//   q   = (v × (levels - 1) + bias) / 255    bias = 127（最近灰阶）或 Bayer 偏置
+//   out = q × (255 / (levels - 1))
+// SIMD 实现用 (x + 1 + (x >> 8)) >> 8 代替除以 255，对 x < 65535 精确成立。
+void quantize_rows_scalar(uint8_t* pixels, int width, int height, int stride, int levels, bool ordered)
+{
+    const int mul  = levels - 1;
+    const int step = 255 / mul;
+
+    for (int y = 0; y < height; y++) {
+        uint8_t* row        = pixels + (size_t)y * stride;
+        const uint8_t* bias = BAYER8[y & 7];
+        for (int x = 0; x < width; x++) {
+            int b  = ordered ? bias[x & 7] : 127;
+            int q  = (row[x] * mul + b) / 255;
+            row[x] = (uint8_t)(q * step);
+        }
+    }
+}
+
+// 16 像素一组，每组拆成两个 8 × u16 向量（对应 PIE 的 EE.VMUL.U16 / EE.VADDS.U16 / EE.VSR），
+// 循环体内没有分支和查表，移植到 PIE 汇编时一组正好占用两个 Q 寄存器
+void quantize_rows_pie(uint8_t* pixels, int width, int height, int stride, int levels, bool ordered)
+{
+    const uint16_t mul  = (uint16_t)(levels - 1);
+    const uint16_t step = (uint16_t)(255 / mul);
+    const int blocks    = width / 16;
+
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = pixels + (size_t)y * stride;
+
+        alignas(16) uint16_t bias[16];
+        for (int i = 0; i < 16; i++) {
+            bias[i] = ordered ? BAYER8[y & 7][i & 7] : 127;
+        }
+
+        for (int b = 0; b < blocks; b++) {
+            uint8_t* px = row + b * 16;
+            alignas(16) uint16_t acc[16];
+            for (int i = 0; i < 16; i++) acc[i] = (uint16_t)(px[i] * mul + bias[i]);
+            for (int i = 0; i < 16; i++) acc[i] = (uint16_t)((acc[i] + 1 + (acc[i] >> 8)) >> 8);
+            for (int i = 0; i < 16; i++) px[i] = (uint8_t)(acc[i] * step);
+        }
+
+        // 不足 16 像素的尾部逐个处理，bias[x & 15] 保持 Bayer 相位
+        for (int x = blocks * 16; x < width; x++) {
+            uint16_t acc = (uint16_t)(row[x] * mul + bias[x & 15]);
+            acc          = (uint16_t)((acc + 1 + (acc >> 8)) >> 8);
+            row[x]       = (uint8_t)(acc * step);
+        }
+    }
+}
+
+}  // namespace detail
+
+static bool levels_supported(int levels)
+{
+    return levels == 2 || levels == 4 || levels == 16;
+}
+
+// 误差以 16 倍（Floyd–Steinberg）或 8 倍（Atkinson）整数累加，读取时四舍五入，
+// 保证误差总量守恒且结果与平台无关
+static void diffuse_floyd_steinberg(uint8_t* pixels, int width, int height, int stride, int levels)
+{
+    const int mul  = levels - 1;
+    const int step = 255 / mul;
+
+    std::vector<int32_t> cur(width + 2, 0);
+    std::vector<int32_t> next(width + 2, 0);
+
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = pixels + (size_t)y * stride;
+        std::fill(next.begin(), next.end(), 0);
+
+        for (int x = 0; x < width; x++) {
+            int want = row[x] + ((cur[x + 1] + 8) >> 4);
+            if (want < 0) want = 0;
+            if (want > 255) want = 255;
+
+            int out = ((want * mul + 127) / 255) * step;
+            int err = want - out;
+            row[x]  = (uint8_t)out;
+
+            cur[x + 2] += err * 7;
+            next[x] += err * 3;
+            next[x + 1] += err * 5;
+            next[x + 2] += err;
+        }
+        cur.swap(next);
+    }
+}
+
+static void diffuse_atkinson(uint8_t* pixels, int width, int height, int stride, int levels)
+{
+    const int mul  = levels - 1;
+    const int step = 255 / mul;
+
+    // 三行误差缓冲，左右各留 2 列余量
+    std::vector<int32_t> rows[3];
+    for (auto& r : rows) r.assign(width + 4, 0);
+
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = pixels + (size_t)y * stride;
+        int32_t* e0  = rows[y % 3].data() + 2;
+        int32_t* e1  = rows[(y + 1) % 3].data() + 2;
+        int32_t* e2  = rows[(y + 2) % 3].data() + 2;
+
+        for (int x = 0; x < width; x++) {
+            int want = row[x] + ((e0[x] + 4) >> 3);
+            if (want < 0) want = 0;
+            if (want > 255) want = 255;
+
+            int out = ((want * mul + 127) / 255) * step;
+            int err = want - out;
+            row[x]  = (uint8_t)out;
+
+            e0[x + 1] += err;
+            e0[x + 2] += err;
+            e1[x - 1] += err;
+            e1[x] += err;
+            e1[x + 1] += err;
+            e2[x] += err;
+        }
+        std::fill(rows[y % 3].begin(), rows[y % 3].end(), 0);
+    }
+}
+
+bool dither_kernel_available(DitherKernel kernel)
+{
+    switch (kernel) {
+        case DitherKernel::Auto:
+        case DitherKernel::Scalar:
+        case DitherKernel::Pie:
+            return true;
+        case DitherKernel::Sse2:
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+            return true;
+#else
+            return false;
+#endif
+        case DitherKernel::Avx2:
+#if defined(__x86_64__) || defined(__i386__)
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+static DitherKernel resolve_kernel(DitherKernel kernel)
+{
+    if (kernel != DitherKernel::Auto) {
+        return kernel;
+    }
+    if (dither_kernel_available(DitherKernel::Avx2)) return DitherKernel::Avx2;
+    if (dither_kernel_available(DitherKernel::Sse2)) return DitherKernel::Sse2;
+    return DitherKernel::Pie;
+}
+
+bool dither_gray(uint8_t* pixels, int width, int height, int stride, int levels, DitherMethod method,
+                 DitherKernel kernel)
+{
+    if (!pixels || width <= 0 || height <= 0 || stride < width || !levels_supported(levels)) {
+        return false;
+    }
+    if (!dither_kernel_available(kernel)) {
+        return false;
+    }
+
+    switch (method) {
+        case DitherMethod::FloydSteinberg:
+            diffuse_floyd_steinberg(pixels, width, height, stride, levels);
+            return true;
+        case DitherMethod::Atkinson:
+            diffuse_atkinson(pixels, width, height, stride, levels);
+            return true;
+        default:
+            break;
+    }
+
+    bool ordered = method == DitherMethod::Ordered;
+    switch (resolve_kernel(kernel)) {
+        case DitherKernel::Avx2:
+            detail::quantize_rows_avx2(pixels, width, height, stride, levels, ordered);
+            break;
+        case DitherKernel::Sse2:
+            detail::quantize_rows_sse2(pixels, width, height, stride, levels, ordered);
+            break;
+        case DitherKernel::Pie:
+            detail::quantize_rows_pie(pixels, width, height, stride, levels, ordered);
+            break;
+        default:
+            detail::quantize_rows_scalar(pixels, width, height, stride, levels, ordered);
+            break;
+    }
+    return true;
+}
+
+const char* dither_kernel_name(DitherKernel kernel)
+{
+    switch (kernel) {
+        case DitherKernel::Auto: return "auto";
+        case DitherKernel::Scalar: return "scalar";
+        case DitherKernel::Pie: return "pie";
+        case DitherKernel::Sse2: return "sse2";
+        case DitherKernel::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+const char* dither_method_name(DitherMethod method)
+{
+    switch (method) {
+        case DitherMethod::None: return "none";
+        case DitherMethod::Ordered: return "ordered";
+        case DitherMethod::FloydSteinberg: return "fs";
+        case DitherMethod::Atkinson: return "atkinson";
+    }
+    return "unknown";
+}
+
+bool parse_dither_method(const char* name, DitherMethod& method)
+{
+    static const DitherMethod all[] = {DitherMethod::None, DitherMethod::Ordered, DitherMethod::FloydSteinberg,
+                                       DitherMethod::Atkinson};
+    for (DitherMethod m : all) {
+        if (strcmp(name, dither_method_name(m)) == 0) {
+            method = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace book
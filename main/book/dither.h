@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace book {
+
+/**
+ * @brief 灰度量化/抖动算法
+ */
+enum class DitherMethod {
+    None = 0,        // 直接取最近灰阶
+    Ordered,         // 8×8 Bayer 有序抖动
+    FloydSteinberg,  // 误差扩散 7/16 3/16 5/16 1/16
+    Atkinson,        // 误差扩散 6 × 1/8（丢弃 1/4 误差，对比度更高，适合文字）
+};
+
+/**
+ * @brief 内核实现
+ *
+ * 所有实现的输出与 Scalar 逐像素一致。误差扩散在行内存在串行依赖，
+ * 各实现中 FloydSteinberg / Atkinson 都走标量路径，SIMD 只加速 None / Ordered。
+ */
+enum class DitherKernel {
+    Auto = 0,  // 选择当前平台可用的最快实现
+    Scalar,    // 参考实现
+    Pie,       // 16 × u16 分块实现，与 ESP32-S3 PIE 的 128-bit Q 寄存器布局一一对应，纯 C 可在任意平台编译
+    Sse2,      // x86 主机
+    Avx2,      // x86 主机
+};
+
+/**
+ * @brief 原地量化 8-bit 灰度图
+ *
+ * 输出灰度为均匀分布的 levels 级：第 i 级 = i × 255 / (levels - 1)，
+ * 16 级时正好是面板的 0x00, 0x11 … 0xFF。
+ *
+ * @param levels 2、4 或 16（255 能被 levels - 1 整除）
+ * @return levels 不支持或内核不可用时返回 false，图像不变
+ */
+bool dither_gray(uint8_t* pixels, int width, int height, int stride, int levels, DitherMethod method,
+                 DitherKernel kernel = DitherKernel::Auto);
+
+bool dither_kernel_available(DitherKernel kernel);
+const char* dither_kernel_name(DitherKernel kernel);
+const char* dither_method_name(DitherMethod method);
+
+/**
+ * @brief 解析 none / ordered / fs / atkinson，失败返回 false
+ */
+bool parse_dither_method(const char* name, DitherMethod& method);
+
+namespace detail {
+
+// 各 SIMD 实现共用的查表，定义见 dither.cpp
+extern const uint8_t BAYER8[8][8];  // 偏置值 ((2t + 1) × 255) / 128，t 为 0..63 的 Bayer 序号
+
+void quantize_rows_scalar(uint8_t* pixels, int width, int height, int stride, int levels, bool ordered);
+void quantize_rows_pie(uint8_t* pixels, int width, int height, int stride, int levels, bool ordered);
+void quantize_rows_sse2(uint8_t* pixels, int width, int height, int stride, int levels, bool ordered);
+void quantize_rows_avx2(uint8_t* pixels, int width, int height, int stride, int levels, bool ordered);
+
+}  // namespace detail
+
+}  // namespace book
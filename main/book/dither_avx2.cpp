@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "dither.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace book {
+namespace detail {
+
+static inline __m256i quantize_u16(__m256i v, __m256i mul, __m256i bias, __m256i step)
+{
+    const __m256i one = _mm256_set1_epi16(1);
+    v                 = _mm256_add_epi16(_mm256_mullo_epi16(v, mul), bias);
+    v = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(v, one), _mm256_srli_epi16(v, 8)), 8);
+    return _mm256_mullo_epi16(v, step);
+}
+
+void quantize_rows_avx2(uint8_t* pixels, int width, int height, int stride, int levels, bool ordered)
+{
+    const __m256i mul  = _mm256_set1_epi16((short)(levels - 1));
+    const __m256i step = _mm256_set1_epi16((short)(255 / (levels - 1)));
+    const int blocks   = width / 32;
+
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = pixels + (size_t)y * stride;
+
+        // 每个 256-bit 向量 16 个 u16，Bayer 一行（8 个偏置）重复两次
+        const uint8_t* b = BAYER8[y & 7];
+        __m256i bias     = ordered ? _mm256_setr_epi16(b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7], b[0], b[1],
+                                                       b[2], b[3], b[4], b[5], b[6], b[7])
+                                   : _mm256_set1_epi16(127);
+
+        for (int i = 0; i < blocks; i++) {
+            uint8_t* px = row + i * 32;
+            __m256i lo  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)px));
+            __m256i hi  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(px + 16)));
+
+            lo = quantize_u16(lo, mul, bias, step);
+            hi = quantize_u16(hi, mul, bias, step);
+
+            // packus 按 128-bit 通道交错，重新排列 64-bit 块恢复像素顺序
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+            _mm256_storeu_si256((__m256i*)px, packed);
+        }
+
+        for (int x = blocks * 32; x < width; x++) {
+            int q  = (row[x] * (levels - 1) + (ordered ? b[x & 7] : 127)) / 255;
+            row[x] = (uint8_t)(q * (255 / (levels - 1)));
+        }
+    }
+}
+
+}  // namespace detail
+}  // namespace book
+
+#else
+
+namespace book {
+namespace detail {
+
+void quantize_rows_avx2(uint8_t* pixels, int width, int height, int stride, int levels, bool ordered)
+{
+    quantize_rows_scalar(pixels, width, height, stride, levels, ordered);
+}
+
+}  // namespace detail
+}  // namespace book
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "dither.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+namespace book {
+namespace detail {
+
+void quantize_rows_sse2(uint8_t* pixels, int width, int height, int stride, int levels, bool ordered)
+{
+    const __m128i mul  = _mm_set1_epi16((short)(levels - 1));
+    const __m128i step = _mm_set1_epi16((short)(255 / (levels - 1)));
+    const __m128i one  = _mm_set1_epi16(1);
+    const __m128i zero = _mm_setzero_si128();
+    const int blocks   = width / 16;
+
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = pixels + (size_t)y * stride;
+
+        // 16 像素拆成高低两半，每半 8 个 u16，Bayer 周期正好是 8
+        const uint8_t* b = BAYER8[y & 7];
+        __m128i bias     = ordered ? _mm_setr_epi16(b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7])
+                                   : _mm_set1_epi16(127);
+
+        for (int i = 0; i < blocks; i++) {
+            __m128i px = _mm_loadu_si128((const __m128i*)(row + i * 16));
+            __m128i lo = _mm_unpacklo_epi8(px, zero);
+            __m128i hi = _mm_unpackhi_epi8(px, zero);
+
+            lo = _mm_add_epi16(_mm_mullo_epi16(lo, mul), bias);
+            hi = _mm_add_epi16(_mm_mullo_epi16(hi, mul), bias);
+
+            // x / 255 == (x + 1 + (x >> 8)) >> 8
+            lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+
+            lo = _mm_mullo_epi16(lo, step);
+            hi = _mm_mullo_epi16(hi, step);
+            _mm_storeu_si128((__m128i*)(row + i * 16), _mm_packus_epi16(lo, hi));
+        }
+
+        for (int x = blocks * 16; x < width; x++) {
+            int q  = (row[x] * (levels - 1) + (ordered ? b[x & 7] : 127)) / 255;
+            row[x] = (uint8_t)(q * (255 / (levels - 1)));
+        }
+    }
+}
+
+}  // namespace detail
+}  // namespace book
+
+#else
+
+namespace book {
+namespace detail {
+
+void quantize_rows_sse2(uint8_t* pixels, int width, int height, int stride, int levels, bool ordered)
+{
+    quantize_rows_scalar(pixels, width, height, stride, levels, ordered);
+}
+
+}  // namespace detail
+}  // namespace book
+
+#endif
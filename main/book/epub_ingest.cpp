@@ -0,0 +1,838 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "epub_ingest.h"
+#include "free_space.h"
+#include "fs_events.h"
+#include "markup_scanner.h"
+#include "text_book.h"
+#include "zip_reader.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#ifdef ESP_PLATFORM
+#include <mooncake_log.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <thread>
+#endif
+
+namespace book {
+
+static constexpr size_t READ_CHUNK_SIZE     = 4096;
+static constexpr size_t OUTPUT_BUFFER_SIZE  = 4096;
+static constexpr int STATUS_UPDATE_INTERVAL = 8;  // 每导入几个正文文件更新一次状态文件
+
+#ifdef ESP_PLATFORM
+static constexpr int WORKER_STACK_SIZE = 1024 * 16;
+static constexpr int WORKER_PRIORITY   = 1;
+static const char* TAG                 = "EpubIngest";
+#endif
+
+static std::string json_escape(const std::string& s)
+{
+    std::string out;
+    out.reserve(s.size() + 8);
+    for (char c : s) {
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if ((uint8_t)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", (uint8_t)c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+// href 中的 %XX 解码并去掉 #片段，再与所在目录拼接，消去 . 和 ..
+static std::string resolve_href(const std::string& baseDir, const std::string& href)
+{
+    std::string decoded;
+    for (size_t i = 0; i < href.size() && href[i] != '#'; i++) {
+        if (href[i] == '%' && i + 2 < href.size() && isxdigit((uint8_t)href[i + 1]) && isxdigit((uint8_t)href[i + 2])) {
+            char hex[3] = {href[i + 1], href[i + 2], 0};
+            decoded += (char)strtol(hex, nullptr, 16);
+            i += 2;
+        } else {
+            decoded += href[i];
+        }
+    }
+
+    std::string joined = decoded.empty() || decoded[0] != '/' ? baseDir + decoded : decoded.substr(1);
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= joined.size()) {
+        size_t slash     = joined.find('/', start);
+        std::string part = joined.substr(start, slash == std::string::npos ? std::string::npos : slash - start);
+        if (part == "..") {
+            if (!parts.empty()) parts.pop_back();
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        if (slash == std::string::npos) break;
+        start = slash + 1;
+    }
+    std::string result;
+    for (const auto& part : parts) {
+        if (!result.empty()) result += '/';
+        result += part;
+    }
+    return result;
+}
+
+static inline bool is_ascii_space(uint8_t c)
+{
+    return c <= 0x20;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   输出                                     */
+/* -------------------------------------------------------------------------- */
+
+// 正文输出：带缓冲写入，非 ASCII 部分按 UTF-8 校验，非法字节替换为 U+FFFD（保证阅读时按 UTF-8 识别）
+class TextSink {
+public:
+    bool open(const std::string& path)
+    {
+        _file = fopen(path.c_str(), "wb");
+        _buffer.resize(OUTPUT_BUFFER_SIZE);
+        _len      = 0;
+        _position = 0;
+        _newlines = 0;
+        _failed   = _file == nullptr;
+        return _file != nullptr;
+    }
+
+    bool close()
+    {
+        if (!_file) return false;
+        flush();
+        bool ok = !_failed && fflush(_file) == 0;
+        fclose(_file);
+        _file = nullptr;
+        return ok;
+    }
+
+    void write(const char* data, size_t len)
+    {
+        const uint8_t* p = (const uint8_t*)data;
+        size_t pos       = 0;
+        while (pos < len) {
+            size_t start = pos;
+            while (pos < len && p[pos] < 0x80) pos++;
+            append(data + start, pos - start);
+            if (pos == len) break;
+
+            uint32_t cp;
+            size_t n = decode_text_char(TextEncoding::Utf8, p + pos, len - pos, cp);
+            if (n == 0) {
+                cp = TEXT_REPLACEMENT_CHAR;
+                n  = len - pos;
+            }
+            char utf8[4];
+            append(utf8, encode_utf8(cp, utf8));
+            pos += n;
+        }
+        if (len > 0) _newlines = 0;
+    }
+
+    void newline()
+    {
+        append("\n", 1);
+        _newlines++;
+    }
+
+    uint32_t position() const
+    {
+        return _position;
+    }
+    int trailingNewlines() const
+    {
+        return _newlines;
+    }
+
+private:
+    FILE* _file = nullptr;
+    std::vector<char> _buffer;
+    size_t _len        = 0;
+    uint32_t _position = 0;
+    int _newlines      = 0;  // 末尾连续的换行数
+    bool _failed       = false;
+
+    void append(const char* data, size_t len)
+    {
+        while (len > 0) {
+            if (_len == _buffer.size()) flush();
+            size_t n = std::min(len, _buffer.size() - _len);
+            memcpy(_buffer.data() + _len, data, n);
+            _len += n;
+            _position += (uint32_t)n;
+            data += n;
+            len -= n;
+        }
+    }
+
+    void flush()
+    {
+        if (_len > 0 && fwrite(_buffer.data(), 1, _len, _file) != _len) _failed = true;
+        _len = 0;
+    }
+};
+
+// 锚点表边导入边写出，不在内存中保留
+class AnchorWriter {
+public:
+    bool open(const std::string& path)
+    {
+        _file  = fopen(path.c_str(), "wb");
+        _count = 0;
+        if (_file) fputs("{", _file);
+        return _file != nullptr;
+    }
+
+    void add(const std::string& key, uint32_t offset)
+    {
+        if (!_file) return;
+        fprintf(_file, "%s\n\"%s\":{\"offset\":%u}", _count > 0 ? "," : "", json_escape(key).c_str(), (unsigned)offset);
+        _count++;
+    }
+
+    bool close()
+    {
+        if (!_file) return false;
+        fputs("\n}\n", _file);
+        bool ok = fflush(_file) == 0;
+        fclose(_file);
+        _file = nullptr;
+        return ok;
+    }
+
+    int count() const
+    {
+        return _count;
+    }
+
+private:
+    FILE* _file = nullptr;
+    int _count  = 0;
+};
+
+/* -------------------------------------------------------------------------- */
+/*                               容器与 OPF                                   */
+/* -------------------------------------------------------------------------- */
+
+class ContainerHandler : public MarkupScanner::Handler {
+public:
+    std::string rootFile;
+
+    void startTag(const std::string& name, const std::string& attrs, bool) override
+    {
+        if (name == "rootfile" && rootFile.empty()) {
+            MarkupScanner::attribute(attrs, "full-path", rootFile);
+        }
+    }
+    void endTag(const std::string&) override
+    {
+    }
+    void text(const char*, size_t) override
+    {
+    }
+};
+
+class OpfHandler : public MarkupScanner::Handler {
+public:
+    struct Item {
+        std::string id;
+        std::string href;
+    };
+
+    std::string title;
+    std::string author;
+    std::vector<Item> manifest;  // 只保留 XHTML 条目
+    std::vector<std::string> spine;
+
+    void startTag(const std::string& name, const std::string& attrs, bool selfClosing) override
+    {
+        if (name == "metadata") {
+            _in_metadata = !selfClosing;
+        } else if (_in_metadata && (name == "title" || name == "creator")) {
+            _capture = name == "title" ? (title.empty() ? &title : nullptr) : (author.empty() ? &author : nullptr);
+        } else if (name == "item") {
+            std::string mediaType;
+            Item item;
+            MarkupScanner::attribute(attrs, "media-type", mediaType);
+            if ((mediaType == "application/xhtml+xml" || mediaType == "text/html") &&
+                MarkupScanner::attribute(attrs, "id", item.id) && MarkupScanner::attribute(attrs, "href", item.href)) {
+                manifest.push_back(std::move(item));
+            }
+        } else if (name == "itemref") {
+            std::string idref;
+            if (MarkupScanner::attribute(attrs, "idref", idref)) spine.push_back(std::move(idref));
+        }
+    }
+
+    void endTag(const std::string& name) override
+    {
+        if (name == "metadata") _in_metadata = false;
+        if (name == "title" || name == "creator") _capture = nullptr;
+    }
+
+    void text(const char* data, size_t len) override
+    {
+        if (_capture && _capture->size() < EPUB_MAX_TITLE_BYTES) _capture->append(data, len);
+    }
+
+private:
+    bool _in_metadata     = false;
+    std::string* _capture = nullptr;
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                 正文提取                                   */
+/* -------------------------------------------------------------------------- */
+
+struct EpubSection {
+    std::string title;
+    uint32_t offset;
+};
+
+// 块级元素：前后换行
+static const char* const BLOCK_TAGS[] = {
+    "p", "div", "br", "li", "ul", "ol", "dl", "dt", "dd", "pre", "hr", "nav", "section", "header", "footer",
+    "aside", "body", "table", "tr", "figure", "article", "figcaption", "blockquote",
+};
+
+// 内容不导入的元素
+static const char* const SKIP_TAGS[] = {"head", "script", "style", "svg", "math", "rt", "rp"};
+
+static bool tag_in(const std::string& name, const char* const* list, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (name == list[i]) return true;
+    }
+    return false;
+}
+
+// 去掉截断在字符中间的 UTF-8 尾部和首尾空白
+static void trim_title(std::string& title)
+{
+    size_t end = title.size();
+    size_t pos = 0;
+    while (pos < end) {
+        uint8_t c   = (uint8_t)title[pos];
+        size_t need = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        if (pos + need > end) break;
+        pos += need;
+    }
+    title.resize(pos);
+    while (!title.empty() && title.back() == ' ') title.pop_back();
+    size_t first = 0;
+    while (first < title.size() && title[first] == ' ') first++;
+    title.erase(0, first);
+}
+
+class TextExtractor : public MarkupScanner::Handler {
+public:
+    TextExtractor(TextSink& sink, AnchorWriter& anchors) : _sink(sink), _anchors(anchors)
+    {
+    }
+
+    std::vector<EpubSection> headings;   // h1 - h3
+    std::vector<EpubSection> documents;  // 每个有文字的正文文件：起点 + 第一个标题
+
+    void beginDocument(const std::string& key)
+    {
+        _key        = key;
+        _skip_depth = 0;
+        _heading    = 0;
+        _has_text   = false;
+        _doc_title.clear();
+        requestBreak(2);
+        _doc_start = pendingPosition();
+        _anchors.add(key, _doc_start);
+    }
+
+    void endDocument()
+    {
+        if (_has_text && (int)documents.size() < EPUB_MAX_SECTIONS) {
+            documents.push_back({_doc_title, _doc_start});
+        }
+    }
+
+    void startTag(const std::string& name, const std::string& attrs, bool selfClosing) override
+    {
+        if (tag_in(name, SKIP_TAGS, sizeof(SKIP_TAGS) / sizeof(SKIP_TAGS[0]))) {
+            if (!selfClosing) _skip_depth++;
+            return;
+        }
+        if (_skip_depth > 0) return;
+
+        std::string id;
+        if (MarkupScanner::attribute(attrs, "id", id) && !id.empty()) {
+            _anchors.add(_key + "#" + id, pendingPosition());
+        }
+
+        int level = heading_level(name);
+        if (level > 0 && !selfClosing) {
+            requestBreak(_sink.position() > 0 ? 2 : 1);
+            _heading       = level;
+            _heading_start = UINT32_MAX;
+            _heading_text.clear();
+        } else if (tag_in(name, BLOCK_TAGS, sizeof(BLOCK_TAGS) / sizeof(BLOCK_TAGS[0]))) {
+            requestBreak(1);
+        }
+    }
+
+    void endTag(const std::string& name) override
+    {
+        if (tag_in(name, SKIP_TAGS, sizeof(SKIP_TAGS) / sizeof(SKIP_TAGS[0]))) {
+            if (_skip_depth > 0) _skip_depth--;
+            return;
+        }
+        if (_skip_depth > 0) return;
+
+        int level = heading_level(name);
+        if (level > 0 && level == _heading) {
+            trim_title(_heading_text);
+            if (!_heading_text.empty() && _heading_start != UINT32_MAX) {
+                if (level <= 3 && (int)headings.size() < EPUB_MAX_SECTIONS) {
+                    headings.push_back({_heading_text, _heading_start});
+                }
+                if (_doc_title.empty()) _doc_title = _heading_text;
+            }
+            _heading = 0;
+            requestBreak(1);
+        } else if (tag_in(name, BLOCK_TAGS, sizeof(BLOCK_TAGS) / sizeof(BLOCK_TAGS[0]))) {
+            requestBreak(1);
+        }
+    }
+
+    void text(const char* data, size_t len) override
+    {
+        if (_skip_depth > 0) return;
+
+        // HTML 空白折叠：连续空白（含源文件中的换行）合并为一个空格，行首的空白丢弃
+        const uint8_t* p = (const uint8_t*)data;
+        size_t pos       = 0;
+        while (pos < len) {
+            if (is_ascii_space(p[pos]) || (p[pos] == 0xC2 && pos + 1 < len && p[pos + 1] == 0xA0)) {
+                _pending_space = true;
+                pos += p[pos] == 0xC2 ? 2 : 1;
+                continue;
+            }
+            size_t start = pos;
+            while (pos < len && !is_ascii_space(p[pos]) && !(p[pos] == 0xC2 && pos + 1 < len && p[pos + 1] == 0xA0)) {
+                pos++;
+            }
+            emit(data + start, pos - start);
+        }
+    }
+
+private:
+    TextSink& _sink;
+    AnchorWriter& _anchors;
+    std::string _key;
+    int _skip_depth         = 0;
+    int _pending_break      = 0;  // 下一段文字之前需要的换行数（1 = 换行，2 = 空一行）
+    bool _pending_space     = false;
+    bool _has_text          = false;
+    int _heading            = 0;  // 当前所在标题的级别
+    uint32_t _heading_start = 0;
+    std::string _heading_text;
+    std::string _doc_title;
+    uint32_t _doc_start = 0;
+
+    static int heading_level(const std::string& name)
+    {
+        if (name.size() == 2 && name[0] == 'h' && name[1] >= '1' && name[1] <= '6') return name[1] - '0';
+        return 0;
+    }
+
+    void requestBreak(int lines)
+    {
+        _pending_break = std::max(_pending_break, lines);
+    }
+
+    // 下一段文字将要开始的位置（锚点和标题以此定位，总在行首）
+    uint32_t pendingPosition() const
+    {
+        if (_sink.position() == 0) return 0;
+        int lines = std::max(0, _pending_break - _sink.trailingNewlines());
+        return _sink.position() + (uint32_t)lines;
+    }
+
+    void emit(const char* data, size_t len)
+    {
+        if (_sink.position() > 0 && _pending_break > 0) {
+            while (_sink.trailingNewlines() < _pending_break) _sink.newline();
+            if (_heading && !_heading_text.empty()) _heading_text += ' ';
+        } else if (_pending_space && _sink.position() > 0 && _sink.trailingNewlines() == 0) {
+            _sink.write(" ", 1);
+            if (_heading && !_heading_text.empty()) _heading_text += ' ';
+        }
+        _pending_break = 0;
+        _pending_space = false;
+
+        if (_heading) {
+            if (_heading_start == UINT32_MAX) _heading_start = _sink.position();
+            if (_heading_text.size() < EPUB_MAX_TITLE_BYTES) {
+                _heading_text.append(data, std::min(len, EPUB_MAX_TITLE_BYTES - _heading_text.size()));
+            }
+        }
+        _sink.write(data, len);
+        _has_text = true;
+    }
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                EpubIngestor                                */
+/* -------------------------------------------------------------------------- */
+
+static bool scan_entry(ZipReader& zip, ZipEntryReader& reader, const ZipEntry& entry, MarkupScanner& scanner,
+                       std::vector<uint8_t>& buffer, uint32_t& inflated, std::string& error)
+{
+    if (!reader.open(zip, entry)) {
+        error = reader.lastError();
+        return false;
+    }
+    scanner.reset();
+    bool first = true;
+    while (true) {
+        int n = reader.read(buffer.data(), buffer.size());
+        if (n < 0) {
+            error = reader.lastError();
+            return false;
+        }
+        if (n == 0) break;
+        const uint8_t* data = buffer.data();
+        size_t len          = (size_t)n;
+        if (first) {
+            // UTF-8 BOM；UTF-16 编码的正文不支持
+            if (len >= 2 && ((data[0] == 0xFF && data[1] == 0xFE) || (data[0] == 0xFE && data[1] == 0xFF))) {
+                error = "UTF-16 content is not supported: " + entry.name;
+                return false;
+            }
+            if (len >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF) {
+                data += 3;
+                len -= 3;
+            }
+            first = false;
+        }
+        scanner.feed((const char*)data, len);
+        inflated += (uint32_t)n;
+    }
+    scanner.finish();
+    reader.close();
+    return true;
+}
+
+static bool write_metadata(const std::string& path, const std::string& title, const std::string& author,
+                           const std::vector<EpubSection>& sections)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    char timeStr[64];
+    time_t now         = time(nullptr);
+    struct tm* tm_info = localtime(&now);
+    strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%SZ", tm_info);
+
+    fprintf(f, "{\n  \"title\": \"%s\",\n  \"author\": \"%s\",\n  \"addedAt\": \"%s\",\n", json_escape(title).c_str(),
+            json_escape(author).c_str(), timeStr);
+    fprintf(f, "  \"format\": \"text\",\n  \"source\": \"epub\",\n  \"textFile\": \"%s\",\n  \"sections\": [",
+            EPUB_TEXT_FILE_NAME);
+    for (size_t i = 0; i < sections.size(); i++) {
+        fprintf(f, "%s\n    {\"index\": %u, \"title\": \"%s\", \"offset\": %u, \"pageCount\": 0}", i > 0 ? "," : "",
+                (unsigned)i, json_escape(sections[i].title).c_str(), (unsigned)sections[i].offset);
+    }
+    fputs("\n  ]\n}\n", f);
+    bool ok = fflush(f) == 0;
+    fclose(f);
+    return ok;
+}
+
+bool EpubIngestor::run(const std::string& epubPath, const std::string& bookDir, ProgressFn progress)
+{
+    _title.clear();
+    _author.clear();
+    _stats = EpubIngestStats();
+    _error.clear();
+
+    ZipReader zip;
+    if (!zip.open(epubPath) || !zip.buildIndex()) {
+        _error = zip.lastError();
+        return false;
+    }
+
+    ZipEntryReader reader;
+    std::vector<uint8_t> buffer(READ_CHUNK_SIZE);
+    ZipEntry entry;
+    uint32_t inflated = 0;
+
+    // META-INF/container.xml → OPF 路径
+    ContainerHandler container;
+    MarkupScanner containerScanner(container);
+    if (!zip.find("META-INF/container.xml", entry) ||
+        !scan_entry(zip, reader, entry, containerScanner, buffer, inflated, _error) || container.rootFile.empty()) {
+        if (_error.empty()) _error = "META-INF/container.xml missing or invalid";
+        return false;
+    }
+
+    // OPF：书名、作者、spine 顺序
+    OpfHandler opf;
+    MarkupScanner opfScanner(opf);
+    if (!zip.find(container.rootFile, entry) || !scan_entry(zip, reader, entry, opfScanner, buffer, inflated, _error)) {
+        if (_error.empty()) _error = "OPF not found: " + container.rootFile;
+        return false;
+    }
+    size_t slash       = container.rootFile.rfind('/');
+    std::string opfDir = slash == std::string::npos ? "" : container.rootFile.substr(0, slash + 1);
+    _title             = opf.title;
+    _author            = opf.author;
+    trim_title(_title);
+    trim_title(_author);
+
+    // spine 解析为 ZIP 内的完整路径，之后不再需要 manifest
+    std::vector<std::string> documents;
+    documents.reserve(opf.spine.size());
+    for (const auto& idref : opf.spine) {
+        for (const auto& item : opf.manifest) {
+            if (item.id == idref) {
+                documents.push_back(resolve_href(opfDir, item.href));
+                break;
+            }
+        }
+    }
+    opf = OpfHandler();
+    if (documents.empty()) {
+        _error = "EPUB spine is empty";
+        return false;
+    }
+
+    TextSink sink;
+    AnchorWriter anchors;
+    if (!sink.open(bookDir + "/" + EPUB_TEXT_FILE_NAME) || !anchors.open(bookDir + "/" + EPUB_ANCHORS_FILE_NAME)) {
+        sink.close();
+        anchors.close();
+        _error = "Failed to create output in " + bookDir;
+        return false;
+    }
+
+    TextExtractor extractor(sink, anchors);
+    MarkupScanner scanner(extractor);
+    inflated = 0;
+    for (size_t i = 0; i < documents.size(); i++) {
+        // 缺失的正文文件跳过，不影响其余部分；锚点以相对 OPF 目录的路径为键，与 OPF 中的 href 一致
+        const std::string& path = documents[i];
+        if (zip.find(path, entry)) {
+            bool inOpfDir = path.compare(0, opfDir.size(), opfDir) == 0;
+            extractor.beginDocument(inOpfDir ? path.substr(opfDir.size()) : path);
+            if (!scan_entry(zip, reader, entry, scanner, buffer, inflated, _error)) break;
+            extractor.endDocument();
+            _stats.documents++;
+        }
+        if (progress && !progress((int)i + 1, (int)documents.size())) {
+            _error = "Cancelled";
+            break;
+        }
+    }
+    _stats.inflatedBytes = inflated;
+    _stats.textBytes     = sink.position();
+    _stats.anchors       = anchors.count();
+    bool written         = sink.close();
+    written              = anchors.close() && written;
+    if (!_error.empty()) return false;
+    if (!written) {
+        _error = "Failed to write " + bookDir;
+        return false;
+    }
+    if (_stats.textBytes == 0) {
+        _error = "No text content";
+        return false;
+    }
+
+    // 章节：优先使用 h1 - h3 标题；全书没有标题时按正文文件分节
+    std::vector<EpubSection>& sections = extractor.headings.empty() ? extractor.documents : extractor.headings;
+    for (size_t i = 0; i < sections.size(); i++) {
+        if (sections[i].title.empty()) sections[i].title = "第 " + std::to_string(i + 1) + " 部分";
+    }
+    if (sections.empty() || sections.front().offset > 0) {
+        sections.insert(sections.begin(), {_title.empty() ? "开始" : _title, 0});
+    }
+    _stats.sections = (int)sections.size();
+    if (_title.empty()) _title = "未知书名";
+    if (_author.empty()) _author = "未知作者";
+
+    // 最后写入 metadata.json：书架以它的存在判断导入完成
+    std::string metadataPath = bookDir + "/metadata.json";
+    std::string tempPath     = metadataPath + ".tmp";
+    if (!write_metadata(tempPath, _title, _author, sections)) {
+        _error = "Failed to write metadata.json";
+        return false;
+    }
+    remove(metadataPath.c_str());
+    if (rename(tempPath.c_str(), metadataPath.c_str()) != 0) {
+        _error = "Failed to rename metadata.json";
+        return false;
+    }
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 后台队列                                   */
+/* -------------------------------------------------------------------------- */
+
+void write_epub_ingest_status(const std::string& bookDir, const char* state, int progress, int total,
+                              const std::string& error)
+{
+    FILE* f = fopen((bookDir + "/" + EPUB_STATUS_FILE_NAME).c_str(), "wb");
+    if (!f) return;
+    fprintf(f, "{\"state\":\"%s\",\"progress\":%d,\"total\":%d,\"error\":\"%s\"}\n", state, progress, total,
+            json_escape(error).c_str());
+    fclose(f);
+}
+
+bool epub_ingest_pending(const std::string& bookDir)
+{
+    struct stat st;
+    if (stat((bookDir + "/" + EPUB_SOURCE_FILE_NAME).c_str(), &st) != 0 ||
+        stat((bookDir + "/metadata.json").c_str(), &st) == 0) {
+        return false;
+    }
+
+    // 已经失败过的不再自动重试，避免每次打开书架都重复导入同一本坏书
+    char status[64] = {0};
+    FILE* f         = fopen((bookDir + "/" + EPUB_STATUS_FILE_NAME).c_str(), "rb");
+    if (f) {
+        fread(status, 1, sizeof(status) - 1, f);
+        fclose(f);
+    }
+    return strstr(status, "\"state\":\"error\"") == nullptr;
+}
+
+struct EpubIngestQueue::Impl {
+    std::mutex mutex;
+    std::deque<std::string> pending;
+    std::string current;
+    bool running = false;
+};
+
+EpubIngestQueue& EpubIngestQueue::getInstance()
+{
+    static EpubIngestQueue instance;
+    return instance;
+}
+
+EpubIngestQueue::Impl* EpubIngestQueue::impl()
+{
+    static Impl instance;
+    return &instance;
+}
+
+void EpubIngestQueue::enqueue(const std::string& bookDir)
+{
+    Impl* state = impl();
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->current == bookDir || std::find(state->pending.begin(), state->pending.end(), bookDir) !=
+                                         state->pending.end()) {
+        return;
+    }
+    state->pending.push_back(bookDir);
+    write_epub_ingest_status(bookDir, "queued", 0, 0, "");
+    if (state->running) return;
+
+    state->running = true;
+#ifdef ESP_PLATFORM
+    BaseType_t ok = xTaskCreate(
+        [](void* arg) {
+            workerLoop((EpubIngestQueue*)arg);
+            vTaskDelete(NULL);
+        },
+        "epub_ingest", WORKER_STACK_SIZE, this, WORKER_PRIORITY, NULL);
+    if (ok != pdPASS) {
+        mclog::tagError(TAG, "Failed to start ingest task");
+        state->running = false;
+    }
+#else
+    std::thread(workerLoop, this).detach();
+#endif
+}
+
+bool EpubIngestQueue::busy()
+{
+    Impl* state = impl();
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->running;
+}
+
+void EpubIngestQueue::workerLoop(EpubIngestQueue* self)
+{
+    Impl* state = self->impl();
+    while (true) {
+        std::string bookDir;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->pending.empty()) {
+                state->current.clear();
+                state->running = false;
+                return;
+            }
+            bookDir        = state->pending.front();
+            state->current = bookDir;
+            state->pending.pop_front();
+        }
+
+        write_epub_ingest_status(bookDir, "running", 0, 0, "");
+        time_t start = time(nullptr);
+        EpubIngestor ingestor;
+        bool ok = ingestor.run(bookDir + "/" + EPUB_SOURCE_FILE_NAME, bookDir, [&](int done, int total) {
+            if (done % STATUS_UPDATE_INTERVAL == 0) write_epub_ingest_status(bookDir, "running", done, total, "");
+            return true;
+        });
+        const EpubIngestStats& stats = ingestor.stats();
+        write_epub_ingest_status(bookDir, ok ? "done" : "error", stats.documents, stats.documents,
+                                 ok ? "" : ingestor.lastError());
+        if (ok) FsEventBus::getInstance().publish(FsEventType::Written, bookDir);
+        FreeSpaceCache::getInstance().invalidate();
+#ifdef ESP_PLATFORM
+        if (ok) {
+            mclog::tagInfo(TAG, "Ingested {}: {} documents, {} sections, {} anchors, {} KB text in {} s", bookDir,
+                           stats.documents, stats.sections, stats.anchors, stats.textBytes / 1024,
+                           (long)(time(nullptr) - start));
+        } else {
+            mclog::tagError(TAG, "Ingest {} failed: {}", bookDir, ingestor.lastError());
+        }
+#else
+        (void)start;
+#endif
+    }
+}
+
+}  // namespace book
@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace book {
+
+/*
+ * 设备端 EPUB 导入：把上传的 .epub 转换为纯文本引擎的书籍目录
+ *
+ *   books/{id}/
+ *   ├── source.epub       上传的原文件
+ *   ├── ingest.json       导入状态 {"state", "progress", "total", "error"}
+ *   ├── book.txt          正文（UTF-8），按 text_book.h 排版
+ *   ├── anchors.json      锚点表 {"Text/ch01.xhtml#note1": {"offset": N}, ...}
+ *   └── metadata.json     书名、作者、章节表（"format": "text"，章节以 offset 定位），最后写入
+ *
+ * 按 OPF spine 顺序逐个解压正文 XHTML，边解压边提取文本，不把任何文件整体读入内存：
+ * ZIP 输入缓冲 4KB + inflate 字典 32KB + 输出缓冲 4KB + 标签缓冲 2KB，另有与条目数 / 章节数成正比的索引。
+ * 图片、表格样式和脚本不导入。
+ */
+static constexpr const char* EPUB_SOURCE_FILE_NAME  = "source.epub";
+static constexpr const char* EPUB_STATUS_FILE_NAME  = "ingest.json";
+static constexpr const char* EPUB_TEXT_FILE_NAME    = "book.txt";
+static constexpr const char* EPUB_ANCHORS_FILE_NAME = "anchors.json";
+static constexpr int EPUB_MAX_SECTIONS              = 4096;
+static constexpr size_t EPUB_MAX_TITLE_BYTES        = 120;
+
+struct EpubIngestStats {
+    int documents          = 0;  // 导入的正文文件数
+    int sections           = 0;
+    int anchors            = 0;
+    uint32_t inflatedBytes = 0;  // 解压的正文字节数
+    uint32_t textBytes     = 0;  // 输出的文本字节数
+};
+
+class EpubIngestor {
+public:
+    /**
+     * @brief 进度回调，每个正文文件之后调用
+     * @return false 表示取消
+     */
+    using ProgressFn = std::function<bool(int done, int total)>;
+
+    /**
+     * @brief 导入 epubPath，输出到 bookDir（须已存在）；metadata.json 在全部完成后才写入
+     */
+    bool run(const std::string& epubPath, const std::string& bookDir, ProgressFn progress = nullptr);
+
+    const std::string& title() const
+    {
+        return _title;
+    }
+    const std::string& author() const
+    {
+        return _author;
+    }
+    const EpubIngestStats& stats() const
+    {
+        return _stats;
+    }
+    const std::string& lastError() const
+    {
+        return _error;
+    }
+
+private:
+    std::string _title;
+    std::string _author;
+    EpubIngestStats _stats;
+    std::string _error;
+};
+
+/**
+ * @brief 写入导入状态文件 {bookDir}/ingest.json
+ */
+void write_epub_ingest_status(const std::string& bookDir, const char* state, int progress, int total,
+                              const std::string& error);
+
+/**
+ * @brief 目录中有 source.epub 而没有 metadata.json：上传后尚未导入，或导入被重启打断（导入失败过的除外）
+ */
+bool epub_ingest_pending(const std::string& bookDir);
+
+/**
+ * @brief 后台导入队列，一次只导入一本，工作任务在队列清空后退出
+ */
+class EpubIngestQueue {
+public:
+    static EpubIngestQueue& getInstance();
+
+    /**
+     * @brief 加入队列；已在队列中或正在导入的目录忽略
+     */
+    void enqueue(const std::string& bookDir);
+    bool busy();
+
+private:
+    EpubIngestQueue() = default;
+
+    static void workerLoop(EpubIngestQueue* self);
+
+    // 状态定义见 epub_ingest.cpp，避免在头文件中引入线程相关的头文件
+    struct Impl;
+    Impl* impl();
+};
+
+}  // namespace book
@@ -0,0 +1,235 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "file_checksums.h"
+#include "crc32c.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace book {
+
+static void split_path(const std::string& filePath, std::string& dir, std::string& name)
+{
+    size_t slash = filePath.rfind('/');
+    dir          = slash == std::string::npos ? "." : filePath.substr(0, slash);
+    name         = slash == std::string::npos ? filePath : filePath.substr(slash + 1);
+}
+
+// .checksums 由多个任务共用：HTTP 处理函数和复制任务追加，阅读器和同步清单读取。
+// 追加、读取、压缩都持同一把锁，否则两个任务同时追加、或压缩与追加交错都会丢记录
+struct SidecarLock {
+    std::mutex mutex;
+    std::string dir;     // 最近追加的目录
+    long compactAt = 0;  // 该目录的记录文件长到这么大时检查是否需要压缩
+};
+
+static SidecarLock& sidecar_lock()
+{
+    static SidecarLock instance;
+    return instance;
+}
+
+static constexpr long COMPACT_MIN_BYTES = 4096;
+
+// 调用方持有锁
+static bool read_entries(const std::string& path, std::map<std::string, ChecksumEntry>& entries, size_t& lines)
+{
+    entries.clear();
+    lines   = 0;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char line[320];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = 0;
+        lines++;
+        if (line[0] == '-' && line[1] == ' ') {
+            entries.erase(line + 2);
+            continue;
+        }
+        ManifestEntry entry;
+        if (parse_manifest_line(line, entry)) entries[entry.path] = {entry.size, entry.crc};
+    }
+    fclose(f);
+    return true;
+}
+
+// 重复记录超过一半时压缩，先写临时文件再改名；返回压缩后的文件长度。调用方持有锁
+static long compact(const std::string& path, long size)
+{
+    std::map<std::string, ChecksumEntry> entries;
+    size_t lines = 0;
+    if (!read_entries(path, entries, lines) || lines <= 16 || lines <= entries.size() * 2) return size;
+    std::string temp = path + ".tmp";
+    FILE* out        = fopen(temp.c_str(), "wb");
+    if (!out) return size;
+    for (const auto& [name, entry] : entries) {
+        fprintf(out, "%08" PRIx32 " %" PRIu64 " %s\n", entry.crc, entry.size, name.c_str());
+    }
+    long compacted = ftell(out);
+    if (fclose(out) != 0) {
+        remove(temp.c_str());
+        return size;
+    }
+    remove(path.c_str());
+    rename(temp.c_str(), path.c_str());
+    return compacted;
+}
+
+static void append_line(const std::string& filePath, const char* line)
+{
+    std::string dir, name;
+    split_path(filePath, dir, name);
+    if (name.empty() || name == CHECKSUM_SIDECAR_NAME) return;
+
+    SidecarLock& lock = sidecar_lock();
+    std::lock_guard<std::mutex> guard(lock.mutex);
+    std::string path = dir + "/" + CHECKSUM_SIDECAR_NAME;
+    FILE* f          = fopen(path.c_str(), "ab");
+    if (!f) return;
+    fprintf(f, "%s%s\n", line, name.c_str());
+    long size = ftell(f);
+    fclose(f);
+
+    // 追加通常集中在一个目录（上传、复制一本书）：换目录时检查一次，之后文件长度翻倍才再读一遍，
+    // 总读取量与追加次数成正比
+    if (dir != lock.dir) {
+        lock.dir       = dir;
+        lock.compactAt = std::max(size, COMPACT_MIN_BYTES);
+    }
+    if (size >= lock.compactAt) {
+        size           = compact(path, size);
+        lock.compactAt = std::max(size * 2, COMPACT_MIN_BYTES);
+    }
+}
+
+void ChecksumSidecar::record(const std::string& filePath, uint64_t size, uint32_t crc)
+{
+    char line[40];
+    snprintf(line, sizeof(line), "%08" PRIx32 " %" PRIu64 " ", crc, size);
+    append_line(filePath, line);
+}
+
+void ChecksumSidecar::forget(const std::string& filePath)
+{
+    append_line(filePath, "- ");
+}
+
+void ChecksumSidecar::move(const std::string& fromPath, const std::string& toPath)
+{
+    std::string dir, name;
+    split_path(fromPath, dir, name);
+    ChecksumSidecar sidecar;
+    sidecar.load(dir);
+    const ChecksumEntry* entry = sidecar.find(name);
+    if (entry) {
+        record(toPath, entry->size, entry->crc);
+    } else {
+        forget(toPath);
+    }
+    forget(fromPath);
+}
+
+bool ChecksumSidecar::load(const std::string& dir)
+{
+    std::lock_guard<std::mutex> guard(sidecar_lock().mutex);
+    size_t lines = 0;
+    return read_entries(dir + "/" + CHECKSUM_SIDECAR_NAME, _entries, lines);
+}
+
+const ChecksumEntry* ChecksumSidecar::find(const std::string& name) const
+{
+    auto it = _entries.find(name);
+    return it == _entries.end() ? nullptr : &it->second;
+}
+
+VerifyResult ChecksumSampler::verify(const std::string& filePath, const void* data, size_t size)
+{
+    bool retry = filePath == _last_corrupt;
+    if (!retry && (_every == 0 || ++_count < _every)) return VerifyResult::Skipped;
+    _count = 0;
+    _checked++;
+
+    std::string dir, name;
+    split_path(filePath, dir, name);
+    uint32_t crc = crc32c(data, size);
+    bool fresh   = dir != _dir;
+    if (fresh) {
+        _dir = dir;
+        _sidecar.load(dir);
+    }
+    const ChecksumEntry* entry = _sidecar.find(name);
+    if (!fresh && !(entry && entry->size == size && entry->crc == crc)) {
+        // 缓存的记录可能早于文件服务器刚写入的新版本，对不上时重读一次
+        _sidecar.load(dir);
+        entry = _sidecar.find(name);
+    }
+    if (!entry || (entry->size == size && entry->crc == crc)) {
+        if (retry) _last_corrupt.clear();
+        return entry ? VerifyResult::Ok : VerifyResult::Unknown;
+    }
+    _corrupt++;
+    _last_corrupt = filePath;
+    return VerifyResult::Corrupt;
+}
+
+static bool safe_relative(const std::string& path)
+{
+    if (path.empty() || path[0] == '/') return false;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        if (path.compare(start, end - start, "..") == 0 && end - start == 2) return false;
+        start = end + 1;
+    }
+    return true;
+}
+
+bool parse_manifest_line(const char* line, ManifestEntry& out)
+{
+    char* end    = nullptr;
+    uint32_t crc = (uint32_t)strtoul(line, &end, 16);
+    if (end != line + 8 || *end != ' ') return false;
+    char* sizeEnd = nullptr;
+    uint64_t size = strtoull(end + 1, &sizeEnd, 10);
+    if (sizeEnd == end + 1 || *sizeEnd != ' ' || sizeEnd[1] == 0) return false;
+    out.crc  = crc;
+    out.size = size;
+    out.path.assign(sizeEnd + 1, strcspn(sizeEnd + 1, "\r\n"));
+    return !out.path.empty();
+}
+
+ManifestComparer::ManifestComparer(const std::string& baseDir) : _base_dir(baseDir)
+{
+    while (_base_dir.size() > 1 && _base_dir.back() == '/') _base_dir.pop_back();
+}
+
+ManifestState ManifestComparer::check(const ManifestEntry& file)
+{
+    if (!safe_relative(file.path)) return ManifestState::Changed;
+
+    std::string fullPath = _base_dir + "/" + file.path;
+    struct stat st;
+    if (stat(fullPath.c_str(), &st) != 0) return ManifestState::Missing;
+
+    std::string dir, name;
+    split_path(fullPath, dir, name);
+    if (dir != _dir) {
+        _dir = dir;
+        _sidecar.load(dir);
+    }
+    const ChecksumEntry* entry = _sidecar.find(name);
+    if (entry && entry->size == file.size && entry->crc == file.crc && (uint64_t)st.st_size == file.size) {
+        return ManifestState::Unchanged;
+    }
+    return ManifestState::Changed;
+}
+
+}  // namespace book
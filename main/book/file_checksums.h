@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace book {
+
+/*
+ * 每个目录一个校验和记录 {dir}/.checksums，文件服务器写入文件时边接收边计算 CRC32C 并追加一行：
+ *
+ *   1a2b3c4d 123456 001.png      CRC32C（8 位十六进制） 大小 文件名
+ *   - 002.png                    文件已删除
+ *
+ * 只追加，同名以最后一行为准；追加后重复行超过一半就压缩重写，读取方不改动文件。追加、读取和压缩
+ * 持同一把锁，各任务可以同时使用。不经过文件服务器的改动不会记录，对照清单时还会 stat 文件确认大小，
+ * 对不上的当作已改变。
+ */
+static constexpr const char* CHECKSUM_SIDECAR_NAME = ".checksums";
+
+struct ChecksumEntry {
+    uint64_t size = 0;
+    uint32_t crc  = 0;
+};
+
+class ChecksumSidecar {
+public:
+    /**
+     * @brief 记录 filePath 的大小和 CRC32C（追加到所在目录的 .checksums）
+     */
+    static void record(const std::string& filePath, uint64_t size, uint32_t crc);
+    /**
+     * @brief 记录 filePath 已删除
+     */
+    static void forget(const std::string& filePath);
+    /**
+     * @brief 文件改名后把记录移到新路径（原路径没有记录时只删除新路径上的旧记录）
+     */
+    static void move(const std::string& fromPath, const std::string& toPath);
+
+    /**
+     * @brief 读入 dir 的记录（只读）；没有记录文件时为空，返回 false
+     */
+    bool load(const std::string& dir);
+    const ChecksumEntry* find(const std::string& name) const;
+    size_t size() const
+    {
+        return _entries.size();
+    }
+
+private:
+    std::map<std::string, ChecksumEntry> _entries;
+};
+
+/*
+ * 阅读时抽样校验页面：每读 every 页校验一次（1 为每页，0 关闭），与写入时记录的 CRC32C 对照。
+ * 页面已整个读入内存，校验只多一遍查表，不多读卡；上次校验失败的文件每次都校验。
+ */
+static constexpr uint32_t PAGE_VERIFY_EVERY = 4;
+
+enum class VerifyResult : uint8_t {
+    Skipped = 0,  // 本次没有抽中
+    Ok      = 1,
+    Unknown = 2,  // 没有记录（不经文件服务器写入的文件）
+    Corrupt = 3,  // 大小或 CRC32C 与记录不同
+};
+
+class ChecksumSampler {
+public:
+    explicit ChecksumSampler(uint32_t every = PAGE_VERIFY_EVERY) : _every(every)
+    {
+    }
+
+    void setEvery(uint32_t every)
+    {
+        _every = every;
+    }
+
+    /**
+     * @brief 本次抽中时计算 data 的 CRC32C，与 filePath 所在目录 .checksums 中的记录对照
+     */
+    VerifyResult verify(const std::string& filePath, const void* data, size_t size);
+
+    uint32_t checked() const
+    {
+        return _checked;
+    }
+    uint32_t corrupt() const
+    {
+        return _corrupt;
+    }
+
+private:
+    uint32_t _every;
+    uint32_t _count   = 0;
+    uint32_t _checked = 0;
+    uint32_t _corrupt = 0;
+    std::string _dir;  // _sidecar 对应的目录
+    std::string _last_corrupt;
+    ChecksumSidecar _sidecar;
+};
+
+enum class ManifestState : uint8_t {
+    Unchanged = 0,
+    Missing   = 1,  // 设备上没有
+    Changed   = 2,  // 大小或 CRC32C 不同，或者没有记录
+};
+
+struct ManifestEntry {
+    std::string path;  // 相对 baseDir
+    uint64_t size = 0;
+    uint32_t crc  = 0;
+};
+
+/**
+ * @brief 解析一行清单，格式与 .checksums 相同："CRC32C 大小 路径"
+ */
+bool parse_manifest_line(const char* line, ManifestEntry& out);
+
+/**
+ * @brief 逐条对照客户端的清单，只需上传 Missing 和 Changed 的文件
+ *
+ * 只缓存最近一个目录的 .checksums，清单按目录排列时每个目录只读一次，内存与清单长度无关。
+ * 路径为空、绝对路径或含 .. 分量的条目不查文件，视为 Changed。
+ */
+class ManifestComparer {
+public:
+    explicit ManifestComparer(const std::string& baseDir);
+
+    ManifestState check(const ManifestEntry& file);
+
+private:
+    std::string _base_dir;
+    std::string _dir;  // _sidecar 对应的目录
+    ChecksumSidecar _sidecar;
+};
+
+}  // namespace book
@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "free_space.h"
+#include <algorithm>
+
+#ifdef ESP_PLATFORM
+#include <mooncake_log.h>
+#include "ff.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <sys/statvfs.h>
+#include <thread>
+#endif
+
+namespace book {
+
+#ifdef ESP_PLATFORM
+static constexpr int WORKER_STACK_SIZE = 1024 * 4;
+static constexpr int WORKER_PRIORITY   = 1;
+static const char* TAG                 = "FreeSpace";
+
+static bool scan_volume(uint64_t& total, uint64_t& free, uint32_t& clusterBytes)
+{
+    FATFS* fs;
+    DWORD freeClusters;
+    if (f_getfree("0:", &freeClusters, &fs) != FR_OK) return false;
+    clusterBytes = (uint32_t)fs->csize * 512;
+    total        = (uint64_t)(fs->n_fatent - 2) * clusterBytes;
+    free         = (uint64_t)freeClusters * clusterBytes;
+    return true;
+}
+#else
+static bool scan_volume(uint64_t& total, uint64_t& free, uint32_t& clusterBytes)
+{
+    struct statvfs st;
+    if (statvfs(".", &st) != 0) return false;
+    clusterBytes = (uint32_t)st.f_frsize;
+    total        = (uint64_t)st.f_blocks * st.f_frsize;
+    free         = (uint64_t)st.f_bavail * st.f_frsize;
+    return true;
+}
+#endif
+
+FreeSpaceCache& FreeSpaceCache::getInstance()
+{
+    static FreeSpaceCache instance;
+    return instance;
+}
+
+FreeSpaceCache::FreeSpaceCache(ScanFn scan, uint32_t resyncMs)
+    : _scan(scan ? std::move(scan) : ScanFn(scan_volume)), _resync_ms(resyncMs)
+{
+}
+
+FreeSpaceInfo FreeSpaceCache::get()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    FreeSpaceInfo info;
+    info.valid = _valid;
+    if (_valid) {
+        int64_t clusters = std::max<int64_t>(_free_clusters, 0);
+        info.total       = _total;
+        info.free        = std::min<uint64_t>((uint64_t)clusters * _cluster_bytes, _total);
+        info.estimated   = _estimated;
+    }
+
+    bool expired = _valid && Clock::now() - _scanned_at > std::chrono::milliseconds(_resync_ms);
+    if (!_valid || _stale || expired) start();
+    return info;
+}
+
+void FreeSpaceCache::refresh()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    start();
+}
+
+// 调用方持有 _mutex
+void FreeSpaceCache::adjust(int64_t clusters)
+{
+    if (clusters == 0) return;
+    if (_valid) {
+        _free_clusters -= clusters;
+        _estimated = true;
+    }
+    if (_scanning) _scan_delta += clusters;
+}
+
+void FreeSpaceCache::fileChanged(uint64_t oldBytes, uint64_t newBytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_cluster_bytes == 0) {
+        // 还不知道簇大小，留给正在进行的扫描
+        return;
+    }
+    auto clusters = [&](uint64_t bytes) { return (int64_t)((bytes + _cluster_bytes - 1) / _cluster_bytes); };
+    adjust(clusters(newBytes) - clusters(oldBytes));
+}
+
+void FreeSpaceCache::dirChanged(bool created)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_cluster_bytes) adjust(created ? 1 : -1);
+}
+
+void FreeSpaceCache::invalidate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stale = true;
+}
+
+bool FreeSpaceCache::scanning()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _scanning;
+}
+
+uint32_t FreeSpaceCache::scans()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _scans;
+}
+
+// 调用方持有 _mutex
+void FreeSpaceCache::start()
+{
+    if (_scanning) return;
+    _scanning   = true;
+    _stale      = false;
+    _scan_delta = 0;
+#ifdef ESP_PLATFORM
+    BaseType_t ok = xTaskCreate(
+        [](void* arg) {
+            workerLoop((FreeSpaceCache*)arg);
+            vTaskDelete(NULL);
+        },
+        "free_space", WORKER_STACK_SIZE, this, WORKER_PRIORITY, NULL);
+    if (ok != pdPASS) {
+        mclog::tagError(TAG, "Failed to start scan task");
+        _scanning = false;
+    }
+#else
+    std::thread(workerLoop, this).detach();
+#endif
+}
+
+void FreeSpaceCache::workerLoop(FreeSpaceCache* self)
+{
+    uint64_t total        = 0;
+    uint64_t free         = 0;
+    uint32_t clusterBytes = 0;
+    auto start            = Clock::now();
+    bool ok               = self->_scan(total, free, clusterBytes) && clusterBytes > 0;
+
+    std::lock_guard<std::mutex> lock(self->_mutex);
+    self->_scanning = false;
+    self->_scans++;
+    if (!ok) {
+#ifdef ESP_PLATFORM
+        mclog::tagError(TAG, "Free space scan failed");
+#endif
+        // 下次查询再试
+        self->_stale = true;
+        return;
+    }
+    self->_total         = total;
+    self->_cluster_bytes = clusterBytes;
+    self->_free_clusters = (int64_t)(free / clusterBytes) - self->_scan_delta;
+    self->_estimated     = self->_scan_delta != 0;
+    self->_valid         = true;
+    self->_scanned_at    = Clock::now();
+#ifdef ESP_PLATFORM
+    mclog::tagInfo(TAG, "Free space {} MB of {} MB, scanned in {} ms", free >> 20, total >> 20,
+                   (long)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count());
+#else
+    (void)start;
+#endif
+}
+
+}  // namespace book
@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace book {
+
+/*
+ * SD 卡剩余空间缓存：/api/info 常数时间返回，不在请求中调用 f_getfree
+ *
+ * 大容量 FAT32 卡的 FSInfo 无效时，f_getfree 第一次要经 SPI 读完整个 FAT（32GB 卡约 4MB），
+ * 期间卷被锁住。这里在后台扫描一次，之后按文件服务器自己写入、删除的字节数（按簇取整）调整，
+ * 无法得知字节数的改动（后台删除、EPUB 导入、递归建目录）调用 invalidate()，下次查询时在后台重新扫描；
+ * 距上次扫描超过 resyncMs 也重新扫描，纠正估算的误差。扫描期间的调整在扫描结果上再加一次。
+ */
+static constexpr uint32_t FREE_SPACE_RESYNC_MS = 10 * 60 * 1000;
+
+struct FreeSpaceInfo {
+    uint64_t total = 0;
+    uint64_t free  = 0;
+    bool valid     = false;  // 第一次扫描完成之前为 false
+    bool estimated = false;  // 上次扫描之后按写入 / 删除字节数调整过
+};
+
+class FreeSpaceCache {
+public:
+    /**
+     * @brief 扫描整个卷，返回总容量、剩余空间和簇大小（字节）
+     */
+    using ScanFn = std::function<bool(uint64_t& total, uint64_t& free, uint32_t& clusterBytes)>;
+
+    static FreeSpaceCache& getInstance();
+
+    /**
+     * @param scan 为空时扫描 SD 卡（主机上为当前目录所在的文件系统）
+     */
+    explicit FreeSpaceCache(ScanFn scan = nullptr, uint32_t resyncMs = FREE_SPACE_RESYNC_MS);
+    FreeSpaceCache(const FreeSpaceCache&)            = delete;
+    FreeSpaceCache& operator=(const FreeSpaceCache&) = delete;
+
+    /**
+     * @brief 返回缓存的结果；还没有结果、已失效或过期时启动后台扫描，不等待
+     */
+    FreeSpaceInfo get();
+
+    /**
+     * @brief 立即启动后台扫描（已在扫描时忽略），SD 卡挂载后调用一次
+     */
+    void refresh();
+
+    /**
+     * @brief 文件从 oldBytes 变为 newBytes（新建为 0 → n，删除为 n → 0）
+     */
+    void fileChanged(uint64_t oldBytes, uint64_t newBytes);
+    /**
+     * @brief 新建或删除一个空目录（占一个簇）
+     */
+    void dirChanged(bool created);
+    /**
+     * @brief 发生了无法计量的改动，下次查询时重新扫描
+     */
+    void invalidate();
+
+    bool scanning();
+    uint32_t scans();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    ScanFn _scan;
+    uint32_t _resync_ms;
+    std::mutex _mutex;
+    uint64_t _total          = 0;
+    int64_t _free_clusters   = 0;
+    uint32_t _cluster_bytes  = 0;
+    int64_t _scan_delta      = 0;  // 扫描期间的调整（簇）
+    bool _valid              = false;
+    bool _estimated          = false;
+    bool _stale              = false;
+    bool _scanning           = false;
+    uint32_t _scans          = 0;
+    Clock::time_point _scanned_at;
+
+    void adjust(int64_t clusters);
+    void start();
+    static void workerLoop(FreeSpaceCache* self);
+};
+
+}  // namespace book
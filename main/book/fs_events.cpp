@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "fs_events.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <thread>
+#endif
+
+namespace book {
+
+static constexpr size_t PATH_WORDS = FS_EVENT_PATH_MAX / 4;
+
+// 槽位的所有字段都是原子量，读者与覆盖它的写者并发时没有数据竞争，读完再检查序列字段丢弃不完整的数据。
+// seq：2t+1 为序号 t 写入中，2t+2 为序号 t 已完成。容量为 2 的幂，序号回绕后槽位对应关系不变
+struct FsEventBus::Slot {
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint32_t> meta{0};  // 类型 << 16 | 路径长度
+    std::atomic<uint32_t> path[PATH_WORDS];
+
+    Slot()
+    {
+        for (auto& word : path) word.store(0, std::memory_order_relaxed);
+    }
+};
+
+static void wait_a_moment()
+{
+#ifdef ESP_PLATFORM
+    // 持有槽位的发布者可能优先级更低，要让出给它
+    vTaskDelay(1);
+#else
+    std::this_thread::yield();
+#endif
+}
+
+bool fs_path_related(const std::string& path, const std::string& prefix)
+{
+    size_t n = std::min(path.size(), prefix.size());
+    if (path.compare(0, n, prefix, 0, n) != 0) return false;
+    // 较长的一方在公共部分之后必须是分量边界
+    if (path.size() == prefix.size()) return true;
+    const std::string& longer = path.size() > prefix.size() ? path : prefix;
+    return n == 0 || longer[n] == '/' || longer[n - 1] == '/';
+}
+
+FsEventBus& FsEventBus::getInstance()
+{
+    static FsEventBus instance;
+    return instance;
+}
+
+static size_t round_up_pow2(size_t n)
+{
+    size_t p = 2;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+FsEventBus::FsEventBus(size_t capacity)
+    : _slots(new Slot[round_up_pow2(capacity)]), _capacity(round_up_pow2(capacity))
+{
+    // 初始值当作上一圈已完成，发布者和读者都不必区分第一圈
+    for (size_t i = 0; i < _capacity; i++) {
+        _slots[i].seq.store(2 * ((uint32_t)i - (uint32_t)_capacity) + 2, std::memory_order_relaxed);
+    }
+}
+
+FsEventBus::~FsEventBus()
+{
+    delete[] _slots;
+}
+
+void FsEventBus::publish(FsEventType type, const std::string& raw)
+{
+    // 合并重复的 /、去掉末尾的 /（调用方常把目录和相对路径直接拼接），前缀比较才可靠
+    char path[FS_EVENT_PATH_MAX];
+    size_t len = 0;
+    size_t i   = 0;
+    for (; i < raw.size() && len < FS_EVENT_PATH_MAX - 1; i++) {
+        if (raw[i] != '/' || len == 0 || path[len - 1] != '/') path[len++] = raw[i];
+    }
+    if (i < raw.size()) {
+        // 过长的路径截断到最后一个完整的目录
+        while (len > 1 && path[len - 1] != '/') len--;
+    }
+    while (len > 1 && path[len - 1] == '/') len--;
+
+    uint32_t ticket = _head.fetch_add(1, std::memory_order_acq_rel);
+    Slot& slot      = _slots[ticket % _capacity];
+
+    // 上一圈的发布者还没写完时等待
+    uint32_t previous = 2 * (ticket - (uint32_t)_capacity) + 2;
+    while (slot.seq.load(std::memory_order_acquire) != previous) {
+        wait_a_moment();
+    }
+
+    slot.seq.store(2 * ticket + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.meta.store((uint32_t)type << 16 | (uint32_t)len, std::memory_order_relaxed);
+    for (size_t w = 0; w * 4 < len; w++) {
+        uint32_t word = 0;
+        memcpy(&word, path + w * 4, std::min<size_t>(4, len - w * 4));
+        slot.path[w].store(word, std::memory_order_relaxed);
+    }
+
+    slot.seq.store(2 * ticket + 2, std::memory_order_release);
+}
+
+void FsEventBus::subscribe(FsSubscription& sub, const std::string& prefix)
+{
+    sub.prefix   = prefix;
+    sub.cursor   = _head.load(std::memory_order_acquire);
+    sub.dropped  = 0;
+    sub.received = 0;
+}
+
+void FsEventBus::overflow(FsSubscription& sub, FsEvent& event)
+{
+    // 跳到仍在环中的最早一个事件
+    uint32_t head   = _head.load(std::memory_order_acquire);
+    uint32_t oldest = head - sub.cursor > _capacity ? head - (uint32_t)_capacity : sub.cursor + 1;
+
+    event.type     = FsEventType::Overflow;
+    event.sequence = sub.cursor;
+    event.dropped  = oldest - sub.cursor;
+    event.path.clear();
+    sub.dropped += event.dropped;
+    sub.cursor = oldest;
+}
+
+bool FsEventBus::poll(FsSubscription& sub, FsEvent& event)
+{
+    char buffer[FS_EVENT_PATH_MAX];
+    while (true) {
+        uint32_t head = _head.load(std::memory_order_acquire);
+        if (sub.cursor == head) return false;
+        if (head - sub.cursor > _capacity) {
+            overflow(sub, event);
+            return true;
+        }
+
+        Slot& slot     = _slots[sub.cursor % _capacity];
+        uint32_t ready = 2 * sub.cursor + 2;
+        uint32_t seq   = slot.seq.load(std::memory_order_acquire);
+        if ((int32_t)(seq - ready) < 0) return false;  // 发布者还在写，保持顺序，下次再读
+        if (seq != ready) {
+            overflow(sub, event);
+            return true;
+        }
+
+        uint32_t meta = slot.meta.load(std::memory_order_relaxed);
+        size_t len    = std::min<size_t>(meta & 0xFFFF, FS_EVENT_PATH_MAX - 1);
+        for (size_t w = 0; w * 4 < len; w++) {
+            uint32_t word = slot.path[w].load(std::memory_order_relaxed);
+            memcpy(buffer + w * 4, &word, std::min<size_t>(4, len - w * 4));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) {
+            overflow(sub, event);
+            return true;
+        }
+
+        uint32_t sequence = sub.cursor++;
+        if (!fs_path_related(std::string(buffer, len), sub.prefix)) continue;
+
+        event.type     = (FsEventType)(meta >> 16);
+        event.sequence = sequence;
+        event.dropped  = 0;
+        event.path.assign(buffer, len);
+        sub.received++;
+        return true;
+    }
+}
+
+}  // namespace book
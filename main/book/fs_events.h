@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace book {
+
+/*
+ * 文件系统变化总线：改动卡上文件的代码（HTTP 文件服务器、EPUB 导入）发布事件，
+ * 缓存和索引各自订阅一个路径前缀，在自己的任务里轮询，只让受影响的部分失效
+ *
+ * 事件放在固定大小的环形缓冲中，发布和轮询都不加锁：发布者用原子计数取得序号，
+ * 写入对应的槽位，槽位的序列字段表示写入中 / 已完成（seqlock）；每个订阅者只保存自己的读取位置，
+ * 不回写总线，订阅者再多也不拖慢发布者。订阅者落后超过一圈时，被覆盖的事件丢失，
+ * 轮询得到一个 Overflow 事件，订阅者应当把前缀下的内容全部视为已变化。
+ *
+ * 发布时合并路径中重复的 / 并去掉末尾的 /。路径超过 FS_EVENT_PATH_MAX 时截断到最后一个完整的目录，
+ * 事件变为覆盖该目录的前缀事件，仍然不会漏掉失效。
+ * 事件路径与订阅前缀互为前缀（按路径分量）即视为相关：books/a/1.png 影响前缀 books/a，
+ * 删除 books 也影响前缀 books/a。
+ *
+ * 只用 32 位原子量（ESP32-S3 上 64 位原子操作要借助临界区），序号按 32 位回绕比较。
+ */
+static constexpr size_t FS_EVENT_RING_SIZE = 64;
+static constexpr size_t FS_EVENT_PATH_MAX  = 128;  // 含结尾的 0
+
+enum class FsEventType : uint8_t {
+    Written    = 1,  // 文件创建或覆盖
+    Removed    = 2,
+    DirCreated = 3,
+    DirRemoved = 4,  // 递归删除目录
+    Overflow   = 5,  // 订阅者落后，丢失了事件
+};
+
+struct FsEvent {
+    FsEventType type  = FsEventType::Written;
+    uint32_t sequence = 0;
+    uint32_t dropped  = 0;  // Overflow：丢失的事件数
+    std::string path;       // Overflow 时为空
+};
+
+/**
+ * @brief 路径按分量比较是否互为前缀；前缀为空时总是相关
+ */
+bool fs_path_related(const std::string& path, const std::string& prefix);
+
+struct FsSubscription {
+    std::string prefix;
+    uint32_t cursor   = 0;  // 下一个要读的序号
+    uint32_t dropped  = 0;  // 累计丢失的事件数
+    uint32_t received = 0;  // 累计收到的相关事件数
+};
+
+class FsEventBus {
+public:
+    static FsEventBus& getInstance();
+
+    /**
+     * @param capacity 向上取整到 2 的幂
+     */
+    explicit FsEventBus(size_t capacity = FS_EVENT_RING_SIZE);
+    ~FsEventBus();
+    FsEventBus(const FsEventBus&)            = delete;
+    FsEventBus& operator=(const FsEventBus&) = delete;
+
+    /**
+     * @brief 发布一个事件，可以从任意任务调用
+     *
+     * 只有在另一个发布者写同一个槽位写了一整圈还没写完时才会等待（让出 CPU）。
+     */
+    void publish(FsEventType type, const std::string& path);
+
+    /**
+     * @brief 订阅 prefix 下的事件，从当前位置开始（之前的事件不会收到）
+     */
+    void subscribe(FsSubscription& sub, const std::string& prefix);
+
+    /**
+     * @brief 取下一个相关事件，没有时返回 false；不相关的事件直接跳过
+     *
+     * 同一个订阅只能由一个任务轮询。
+     */
+    bool poll(FsSubscription& sub, FsEvent& event);
+
+    uint32_t published() const
+    {
+        return _head.load(std::memory_order_acquire);
+    }
+    size_t capacity() const
+    {
+        return _capacity;
+    }
+
+private:
+    struct Slot;
+
+    Slot* _slots;
+    size_t _capacity;
+    std::atomic<uint32_t> _head{0};  // 下一个发布序号
+
+    void overflow(FsSubscription& sub, FsEvent& event);
+};
+
+}  // namespace book
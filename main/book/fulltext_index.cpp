@@ -0,0 +1,748 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "fulltext_index.h"
+#include "text_book.h"
+#include "varint.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace book {
+
+static constexpr uint32_t PAGE_END         = '\n';
+static constexpr size_t RUN_ENTRY_SIZE     = 12;
+static constexpr size_t OUTPUT_BUFFER_SIZE = 16 * 1024;
+static constexpr size_t SNIPPET_BEFORE     = 8;   // 上下文：命中之前的字符数
+static constexpr size_t SNIPPET_AFTER      = 16;  // 命中之后的字符数
+static constexpr size_t MAX_BOXES          = 16;  // 每页最多标出的框数
+
+static inline uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void append_u32(std::vector<uint8_t>& out, uint32_t v)
+{
+    uint8_t buf[4];
+    put_u32(buf, v);
+    out.insert(out.end(), buf, buf + 4);
+}
+
+// 一个倒排表：差值累加还原页序
+static bool decode_postings(const uint8_t* data, size_t size, std::vector<uint32_t>& pages)
+{
+    pages.clear();
+    uint32_t page = 0;
+    for (size_t pos = 0; pos < size;) {
+        uint32_t delta = 0;
+        size_t n       = read_varint(data + pos, size - pos, delta);
+        if (n == 0) return false;
+        pos += n;
+        page += delta;
+        pages.push_back(page);
+    }
+    return true;
+}
+
+static inline uint32_t bigram_key(uint32_t a, uint32_t b)
+{
+    return ((a & 0xFFFF) << 16) | (b & 0xFFFF);
+}
+
+// 与 efontCN_24 的字宽一致：中日文及全角字符为半角的两倍
+static inline uint8_t char_units(uint32_t cp)
+{
+    bool wide = (cp >= 0x2E80 && cp <= 0xA4CF) || (cp >= 0xAC00 && cp <= 0xD7A3) || (cp >= 0xF900 && cp <= 0xFAFF) ||
+                (cp >= 0xFE30 && cp <= 0xFE4F) || (cp >= 0xFF00 && cp <= 0xFF60) || (cp >= 0xFFE0 && cp <= 0xFFE6) ||
+                cp == 0x2026 || cp == 0x2014 || cp >= 0x20000;
+    return wide ? 2 : 1;
+}
+
+// 英文等按空格分词的文字，换行处需要补空格
+static inline bool is_word_char(uint32_t cp)
+{
+    return (cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 0xC0 && cp < 0x250);
+}
+
+void fold_search_query(const std::string& query, std::vector<uint32_t>& chars)
+{
+    chars.clear();
+    const uint8_t* p = (const uint8_t*)query.data();
+    size_t pos       = 0;
+    while (pos < query.size()) {
+        uint32_t codepoint = 0;
+        size_t n           = decode_text_char(TextEncoding::Utf8, p + pos, query.size() - pos, codepoint);
+        if (n == 0) break;
+        pos += n;
+        codepoint = fold_search_char(codepoint);
+        if (codepoint == 0 || (codepoint == ' ' && (chars.empty() || chars.back() == ' '))) continue;
+        chars.push_back(codepoint);
+    }
+    if (!chars.empty() && chars.back() == ' ') chars.pop_back();
+}
+
+void fold_page_text(const TextLayer& layer, int page, std::vector<SearchChar>& chars)
+{
+    chars.clear();
+    size_t begin = 0, end = 0;
+    layer.pageLines(page, begin, end);
+    for (size_t line = begin; line < end; line++) {
+        size_t bytes     = 0;
+        const uint8_t* p = (const uint8_t*)layer.lineText(line, bytes);
+        size_t pos       = 0;
+        bool lineStart   = true;
+        while (pos < bytes) {
+            uint32_t codepoint = 0;
+            size_t n           = decode_text_char(TextEncoding::Utf8, p + pos, bytes - pos, codepoint);
+            if (n == 0) break;
+            SearchChar c;
+            c.codepoint = fold_search_char(codepoint);
+            c.line      = (uint32_t)line;
+            c.offset    = (uint32_t)pos;
+            c.bytes     = (uint8_t)n;
+            c.units     = char_units(codepoint);
+            pos += n;
+            if (c.codepoint == 0 || (c.codepoint == ' ' && (chars.empty() || chars.back().codepoint == ' '))) {
+                continue;
+            }
+            // 上一行以字母数字结尾、本行以字母数字开头：行间补一个空格
+            if (lineStart && !chars.empty() && is_word_char(chars.back().codepoint) && is_word_char(c.codepoint)) {
+                SearchChar space;
+                space.codepoint = ' ';
+                space.line      = (uint32_t)line;
+                space.bytes     = 0;
+                chars.push_back(space);
+            }
+            lineStart = false;
+            chars.push_back(c);
+        }
+    }
+    if (!chars.empty() && chars.back().codepoint == ' ') chars.pop_back();
+}
+
+// 命中 [first, last) 在各行上的部分，按该行已知字符的宽度比例换算到行框内
+static void add_match_boxes(const TextLayer& layer, const std::vector<SearchChar>& chars, size_t first, size_t last,
+                            std::vector<TextBox>& boxes)
+{
+    size_t i = first;
+    while (i < last && boxes.size() < MAX_BOXES) {
+        uint32_t line = chars[i].line;
+        // 该行全部字符的宽度，以及命中部分之前和命中部分的宽度
+        size_t lineBegin = i;
+        while (lineBegin > 0 && chars[lineBegin - 1].line == line) lineBegin--;
+        size_t lineEnd = i;
+        while (lineEnd < chars.size() && chars[lineEnd].line == line) lineEnd++;
+        int total = 0, before = 0, width = 0;
+        for (size_t k = lineBegin; k < lineEnd; k++) {
+            if (chars[k].bytes == 0) continue;
+            total += chars[k].units;
+            if (k < i) before += chars[k].units;
+            if (k >= i && k < last) width += chars[k].units;
+        }
+        TextBox lineBox = layer.lineBox(line);
+        if (total > 0 && width > 0) {
+            TextBox box;
+            box.x = lineBox.x + lineBox.w * before / total;
+            box.w = std::max(1, lineBox.w * width / total);
+            box.y = lineBox.y;
+            box.h = lineBox.h;
+            boxes.push_back(box);
+        }
+        i = std::min(last, lineEnd);
+    }
+}
+
+bool find_page_matches(const TextLayer& layer, int page, const std::vector<uint32_t>& query, FulltextHit& hit)
+{
+    hit.matches = 0;
+    hit.snippet.clear();
+    hit.boxes.clear();
+    if (query.empty()) return false;
+
+    std::vector<SearchChar> chars;
+    fold_page_text(layer, page, chars);
+    size_t firstMatch = SIZE_MAX;
+    for (size_t i = 0; i + query.size() <= chars.size();) {
+        size_t k = 0;
+        while (k < query.size() && chars[i + k].codepoint == query[k]) k++;
+        if (k < query.size()) {
+            i++;
+            continue;
+        }
+        if (hit.matches++ == 0) firstMatch = i;
+        add_match_boxes(layer, chars, i, i + query.size(), hit.boxes);
+        i += query.size();
+    }
+    if (hit.matches == 0) return false;
+
+    // 上下文：取原文字符，空白和行间补的空格都显示为一个空格
+    size_t from = firstMatch > SNIPPET_BEFORE ? firstMatch - SNIPPET_BEFORE : 0;
+    size_t to   = std::min(chars.size(), firstMatch + query.size() + SNIPPET_AFTER);
+    if (from > 0) hit.snippet += "…";
+    for (size_t i = from; i < to; i++) {
+        if (chars[i].codepoint == ' ' || chars[i].bytes == 0) {
+            hit.snippet.push_back(' ');
+            continue;
+        }
+        size_t bytes     = 0;
+        const char* text = layer.lineText(chars[i].line, bytes);
+        hit.snippet.append(text + chars[i].offset, chars[i].bytes);
+    }
+    if (to < chars.size()) hit.snippet += "…";
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  生成                                      */
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+// 临时段：若干 { u32 键, u32 最后一个页序, u32 字节数 } + 倒排表，键升序
+struct RunReader {
+    FILE* file    = nullptr;
+    uint32_t key  = 0;
+    uint32_t last = 0;
+    bool valid    = false;
+    std::vector<uint8_t> data;
+
+    bool next()
+    {
+        uint8_t entry[RUN_ENTRY_SIZE];
+        valid = false;
+        if (fread(entry, 1, RUN_ENTRY_SIZE, file) != RUN_ENTRY_SIZE) return false;
+        key  = get_u32(entry);
+        last = get_u32(entry + 4);
+        data.resize(get_u32(entry + 8));
+        valid = fread(data.data(), 1, data.size(), file) == data.size();
+        return valid;
+    }
+};
+
+// 攒满 OUTPUT_BUFFER_SIZE 再写，减少 SD 卡上的小块写入
+class BufferedWriter {
+public:
+    explicit BufferedWriter(FILE* file) : _file(file)
+    {
+        _buffer.reserve(OUTPUT_BUFFER_SIZE);
+    }
+
+    std::vector<uint8_t>& buffer()
+    {
+        return _buffer;
+    }
+    bool maybeFlush()
+    {
+        return _buffer.size() < OUTPUT_BUFFER_SIZE || flush();
+    }
+    bool flush()
+    {
+        bool ok = _buffer.empty() || fwrite(_buffer.data(), 1, _buffer.size(), _file) == _buffer.size();
+        _buffer.clear();
+        return ok;
+    }
+
+private:
+    FILE* _file = nullptr;
+    std::vector<uint8_t> _buffer;
+};
+
+}  // namespace
+
+FulltextIndexBuilder::~FulltextIndexBuilder()
+{
+    end();
+}
+
+bool FulltextIndexBuilder::begin(const FulltextSource& source)
+{
+    end();
+    _source = source;
+    _path   = source.bookDir + "/" + FULLTEXT_INDEX_FILE_NAME;
+    _next   = 0;
+    _done   = false;
+    _error.clear();
+    _stats = FulltextBuildStats();
+    _pages.clear();
+    _char_counts.clear();
+
+    FulltextIndex existing;
+    if (existing.open(_path)) {
+        _stats.pages = (uint32_t)existing.pageCount();
+        _done        = true;
+        return true;
+    }
+    removeRuns();
+    _pairs.reserve(FULLTEXT_RUN_PAIRS + 4096);
+    _active = true;
+    return true;
+}
+
+void FulltextIndexBuilder::end()
+{
+    if (_active && !_done) removeRuns();
+    _active = false;
+    std::vector<uint64_t>().swap(_pairs);
+    std::vector<SearchChar>().swap(_chars);
+    std::vector<uint32_t>().swap(_keys);
+    std::unordered_map<uint32_t, uint32_t>().swap(_char_counts);
+}
+
+std::string FulltextIndexBuilder::runPath(uint32_t run) const
+{
+    return _path + ".run" + std::to_string(run);
+}
+
+void FulltextIndexBuilder::removeRuns()
+{
+    // 上次中断留下的段也一并删除：段号连续，遇到不存在的为止
+    for (uint32_t run = 0;; run++) {
+        if (::remove(runPath(run).c_str()) != 0 && run >= _stats.runs) break;
+    }
+    ::remove((_path + ".keys").c_str());
+    ::remove((_path + ".tmp").c_str());
+}
+
+bool FulltextIndexBuilder::step()
+{
+    if (!_active || _done) return false;
+
+    if (_next >= _source.sections.size()) {
+        _done = merge();
+        _active = false;
+        return false;
+    }
+
+    int section = _source.sections[_next++];
+    char path[32];
+    snprintf(path, sizeof(path), "/sections/%03d/", section);
+    TextLayer layer;
+    if (!layer.load(_source.bookDir + path + TEXT_LAYER_FILE_NAME)) {
+        return true;  // 没有文字层的章节不参与检索
+    }
+
+    for (int page = 1; page <= layer.pageCount(); page++) {
+        uint32_t index = (uint32_t)_pages.size();
+        _pages.push_back({section, page});
+        fold_page_text(layer, page, _chars);
+        _stats.chars += _chars.size();
+
+        _keys.clear();
+        for (size_t i = 0; i < _chars.size(); i++) {
+            uint32_t cp = _chars[i].codepoint;
+            if (cp >= 0x80) _char_counts[cp]++;
+            _keys.push_back(bigram_key(cp, i + 1 < _chars.size() ? _chars[i + 1].codepoint : PAGE_END));
+        }
+        std::sort(_keys.begin(), _keys.end());
+        _keys.erase(std::unique(_keys.begin(), _keys.end()), _keys.end());
+        for (uint32_t key : _keys) _pairs.push_back((uint64_t)key << 32 | index);
+
+        if (_pairs.size() >= FULLTEXT_RUN_PAIRS && !flushRun()) return false;
+    }
+    return true;
+}
+
+bool FulltextIndexBuilder::flushRun()
+{
+    if (_pairs.empty()) return true;
+    std::sort(_pairs.begin(), _pairs.end());
+    _stats.postings += _pairs.size();
+
+    std::vector<uint8_t> out;
+    out.reserve(_pairs.size() * 2);
+    std::vector<uint8_t> list;
+    for (size_t i = 0; i < _pairs.size();) {
+        uint32_t key      = (uint32_t)(_pairs[i] >> 32);
+        uint32_t previous = 0;
+        list.clear();
+        for (; i < _pairs.size() && (uint32_t)(_pairs[i] >> 32) == key; i++) {
+            uint32_t page = (uint32_t)_pairs[i];
+            append_varint(list, page - previous);
+            previous = page;
+        }
+        append_u32(out, key);
+        append_u32(out, previous);
+        append_u32(out, (uint32_t)list.size());
+        out.insert(out.end(), list.begin(), list.end());
+    }
+    _pairs.clear();
+
+    std::string path = runPath(_stats.runs);
+    FILE* f          = fopen(path.c_str(), "wb");
+    bool ok          = f && fwrite(out.data(), 1, out.size(), f) == out.size();
+    if (f) ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        _error = "Failed to write " + path;
+        return false;
+    }
+    _stats.runs++;
+    return true;
+}
+
+bool FulltextIndexBuilder::merge()
+{
+    if (!flushRun()) return false;
+
+    // 联想字：全书最常见的非 ASCII 字符
+    std::vector<std::pair<uint32_t, uint32_t>> counts(_char_counts.begin(), _char_counts.end());
+    size_t topCount = std::min(counts.size(), FULLTEXT_TOP_CHARS);
+    std::partial_sort(counts.begin(), counts.begin() + topCount, counts.end(),
+                      [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) {
+                          return a.second != b.second ? a.second > b.second : a.first < b.first;
+                      });
+
+    std::string tempPath = _path + ".tmp";
+    std::string keysPath = _path + ".keys";
+    FILE* out            = fopen(tempPath.c_str(), "wb");
+    FILE* keys           = fopen(keysPath.c_str(), "w+b");
+    std::vector<RunReader> runs(_stats.runs);
+    bool ok = out && keys;
+    for (uint32_t r = 0; ok && r < _stats.runs; r++) {
+        runs[r].file = fopen(runPath(r).c_str(), "rb");
+        ok           = runs[r].file != nullptr;
+        if (ok) runs[r].next();
+    }
+
+    std::vector<uint32_t> blocks;  // 每块 { 第一个键, 块起点, 倒排表起点 }
+    uint32_t postingsSize = 0;
+    uint32_t keysSize     = 0;
+    uint32_t keyCount     = 0;
+    uint32_t previousKey  = 0;
+    if (ok) {
+        BufferedWriter writer(out);
+        std::vector<uint8_t>& buffer = writer.buffer();
+        buffer.resize(FULLTEXT_INDEX_HEADER_SIZE);
+        for (const auto& ref : _pages) {
+            uint8_t entry[4];
+            put_u16(entry, (uint16_t)ref.section);
+            put_u16(entry + 2, (uint16_t)ref.page);
+            buffer.insert(buffer.end(), entry, entry + 4);
+            ok = writer.maybeFlush() && ok;
+        }
+        for (size_t i = 0; i < topCount; i++) append_u32(buffer, counts[i].first);
+
+        // 多路归并：段数不多（每段 FULLTEXT_RUN_PAIRS 对），线性找最小键即可
+        BufferedWriter keyWriter(keys);
+        while (ok) {
+            uint32_t key = UINT32_MAX;
+            bool any     = false;
+            for (const auto& run : runs) {
+                if (run.valid && (!any || run.key < key)) key = run.key;
+                any = any || run.valid;
+            }
+            if (!any) break;
+
+            uint32_t offset   = postingsSize;
+            uint32_t previous = 0;
+            for (auto& run : runs) {
+                if (!run.valid || run.key != key) continue;
+                // 段内第一项是页序本身，改写为相对上一段最后一个页序的差值
+                uint32_t first = 0;
+                size_t n       = read_varint(run.data.data(), run.data.size(), first);
+                size_t before  = buffer.size();
+                append_varint(buffer, first - previous);
+                buffer.insert(buffer.end(), run.data.begin() + n, run.data.end());
+                postingsSize += (uint32_t)(buffer.size() - before);
+                previous = run.last;
+                ok       = writer.maybeFlush() && ok;
+                run.next();
+            }
+
+            std::vector<uint8_t>& keyBuffer = keyWriter.buffer();
+            if (keyCount % FULLTEXT_KEY_BLOCK == 0) {
+                blocks.insert(blocks.end(), {key, keysSize, offset});
+                previousKey = key;
+            }
+            size_t before = keyBuffer.size();
+            append_varint(keyBuffer, key - previousKey);
+            append_varint(keyBuffer, postingsSize - offset);
+            keysSize += (uint32_t)(keyBuffer.size() - before);
+            previousKey = key;
+            ok          = keyWriter.maybeFlush() && ok;
+            keyCount++;
+        }
+        ok = keyWriter.flush() && ok;
+
+        // 键表接在倒排区之后，最后是块目录
+        rewind(keys);
+        std::vector<uint8_t> chunk(OUTPUT_BUFFER_SIZE);
+        ok = writer.flush() && ok;
+        size_t n;
+        while (ok && (n = fread(chunk.data(), 1, chunk.size(), keys)) > 0) {
+            ok = fwrite(chunk.data(), 1, n, out) == n;
+        }
+        for (uint32_t value : blocks) {
+            append_u32(buffer, value);
+            ok = writer.maybeFlush() && ok;
+        }
+        ok = writer.flush() && ok;
+
+        uint8_t header[FULLTEXT_INDEX_HEADER_SIZE] = {0};
+        memcpy(header, "PS3F", 4);
+        put_u16(header + 4, FULLTEXT_INDEX_VERSION);
+        put_u16(header + 6, (uint16_t)topCount);
+        put_u32(header + 8, (uint32_t)_pages.size());
+        put_u32(header + 12, keyCount);
+        put_u32(header + 16, postingsSize);
+        put_u32(header + 20, keysSize);
+        ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(header), out) == sizeof(header);
+        _stats.bytes = FULLTEXT_INDEX_HEADER_SIZE + _pages.size() * 4 + topCount * 4 + postingsSize + keysSize +
+                       blocks.size() * 4;
+    }
+
+    for (auto& run : runs) {
+        if (run.file) fclose(run.file);
+    }
+    if (keys) fclose(keys);
+    if (out) ok = fclose(out) == 0 && ok;
+    _stats.pages = (uint32_t)_pages.size();
+    _stats.keys  = keyCount;
+    if (ok) {
+        ::remove(_path.c_str());
+        ok = rename(tempPath.c_str(), _path.c_str()) == 0;
+    }
+    removeRuns();
+    if (!ok) {
+        _error = "Failed to write " + _path;
+        return false;
+    }
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  查询                                      */
+/* -------------------------------------------------------------------------- */
+
+FulltextIndex::~FulltextIndex()
+{
+    close();
+}
+
+bool FulltextIndex::open(const std::string& path)
+{
+    close();
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    uint8_t header[FULLTEXT_INDEX_HEADER_SIZE];
+    fseek(f, 0, SEEK_END);
+    long fileSize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) || memcmp(header, "PS3F", 4) != 0 ||
+        get_u16(header + 4) != FULLTEXT_INDEX_VERSION) {
+        fclose(f);
+        return false;
+    }
+    uint32_t topCount  = get_u16(header + 6);
+    uint32_t pageCount = get_u32(header + 8);
+    _key_count         = get_u32(header + 12);
+    _postings_size     = get_u32(header + 16);
+    _keys_size         = get_u32(header + 20);
+    _postings_start    = (uint32_t)(FULLTEXT_INDEX_HEADER_SIZE + (uint64_t)pageCount * 4 + topCount * 4);
+    _keys_start        = _postings_start + _postings_size;
+    size_t blocks      = (_key_count + FULLTEXT_KEY_BLOCK - 1) / FULLTEXT_KEY_BLOCK;
+    uint64_t expected  = (uint64_t)_keys_start + _keys_size + blocks * FULLTEXT_BLOCK_ENTRY_SIZE;
+    if (fileSize < 0 || (uint64_t)fileSize != expected) {
+        fclose(f);
+        return false;
+    }
+
+    std::vector<uint8_t> data((size_t)pageCount * 4 + topCount * 4);
+    bool ok = fread(data.data(), 1, data.size(), f) == data.size();
+    _pages.resize(pageCount);
+    for (uint32_t i = 0; ok && i < pageCount; i++) {
+        _pages[i] = (uint32_t)get_u16(&data[i * 4]) << 16 | get_u16(&data[i * 4 + 2]);
+    }
+    _top_chars.resize(topCount);
+    for (uint32_t i = 0; ok && i < topCount; i++) _top_chars[i] = get_u32(&data[pageCount * 4 + i * 4]);
+
+    data.resize(blocks * FULLTEXT_BLOCK_ENTRY_SIZE);
+    ok = ok && fseek(f, (long)(_keys_start + _keys_size), SEEK_SET) == 0 &&
+         fread(data.data(), 1, data.size(), f) == data.size();
+    _block_keys.resize(blocks);
+    _block_offsets.resize(blocks);
+    _block_postings.resize(blocks);
+    for (size_t i = 0; ok && i < blocks; i++) {
+        const uint8_t* p   = &data[i * FULLTEXT_BLOCK_ENTRY_SIZE];
+        _block_keys[i]     = get_u32(p);
+        _block_offsets[i]  = get_u32(p + 4);
+        _block_postings[i] = get_u32(p + 8);
+        ok = _block_offsets[i] <= _keys_size && _block_postings[i] <= _postings_size;
+    }
+
+    if (!ok) {
+        fclose(f);
+        close();
+        return false;
+    }
+    _file  = f;
+    _reads = 0;
+    return true;
+}
+
+void FulltextIndex::close()
+{
+    if (_file) fclose(_file);
+    _file = nullptr;
+    _pages.clear();
+    _top_chars.clear();
+    _block_keys.clear();
+    _block_offsets.clear();
+    _block_postings.clear();
+    _key_count = 0;
+    std::vector<uint8_t>().swap(_buffer);
+}
+
+FulltextPageRef FulltextIndex::pageRef(uint32_t index) const
+{
+    FulltextPageRef ref;
+    if (index < _pages.size()) {
+        ref.section = (int)(_pages[index] >> 16);
+        ref.page    = (int)(_pages[index] & 0xFFFF);
+    }
+    return ref;
+}
+
+size_t FulltextIndex::memoryBytes() const
+{
+    return (_pages.capacity() + _top_chars.capacity() + _block_keys.capacity() + _block_offsets.capacity() +
+            _block_postings.capacity()) *
+               4 +
+           _buffer.capacity();
+}
+
+bool FulltextIndex::findKeys(uint32_t low, uint32_t high, std::vector<KeyEntry>& entries)
+{
+    entries.clear();
+    if (_block_keys.empty() || high < low) return true;
+
+    // 覆盖 [low, high] 的块：从 low 所在的块到 high 所在的块
+    auto blockOf = [&](uint32_t key) {
+        size_t b = std::upper_bound(_block_keys.begin(), _block_keys.end(), key) - _block_keys.begin();
+        return b > 0 ? b - 1 : 0;
+    };
+    size_t first = blockOf(low);
+    size_t last  = blockOf(high);
+    uint32_t start = _block_offsets[first];
+    uint32_t end   = last + 1 < _block_offsets.size() ? _block_offsets[last + 1] : _keys_size;
+    if (end < start) return false;
+
+    _buffer.resize(end - start);
+    _reads++;
+    if (fseek(_file, (long)(_keys_start + start), SEEK_SET) != 0 ||
+        fread(_buffer.data(), 1, _buffer.size(), _file) != _buffer.size()) {
+        return false;
+    }
+
+    for (size_t b = first; b <= last; b++) {
+        size_t pos      = _block_offsets[b] - start;
+        size_t blockEnd = (b + 1 < _block_offsets.size() ? _block_offsets[b + 1] : _keys_size) - start;
+        uint32_t key    = _block_keys[b];
+        uint32_t offset = _block_postings[b];
+        while (pos < blockEnd) {
+            uint32_t delta = 0, bytes = 0;
+            size_t n = read_varint(&_buffer[pos], blockEnd - pos, delta);
+            size_t m = n ? read_varint(&_buffer[pos + n], blockEnd - pos - n, bytes) : 0;
+            if (m == 0) return false;
+            pos += n + m;
+            key += delta;
+            if (key > high) return true;
+            if (key >= low) entries.push_back({key, offset, offset + bytes});
+            offset += bytes;
+        }
+    }
+    return true;
+}
+
+bool FulltextIndex::readPostings(uint32_t start, uint32_t end, std::vector<uint8_t>& data)
+{
+    data.clear();
+    if (end < start || end > _postings_size) return false;
+    data.resize(end - start);
+    _reads++;
+    return fseek(_file, (long)(_postings_start + start), SEEK_SET) == 0 &&
+           fread(data.data(), 1, data.size(), _file) == data.size();
+}
+
+bool FulltextIndex::search(const std::vector<uint32_t>& query, std::vector<uint32_t>& pages)
+{
+    pages.clear();
+    if (!_file || query.empty()) return _file != nullptr;
+
+    std::vector<KeyEntry> entries;
+    std::vector<uint8_t> raw;
+    std::vector<uint32_t> list;
+
+    if (query.size() == 1) {
+        // 单字：以它开头的键在键表中连续，对应的倒排表在倒排区中也连续，各读一次后取并集
+        uint32_t low = bigram_key(query[0], 0);
+        if (!findKeys(low, low | 0xFFFF, entries)) return false;
+        if (entries.empty()) return true;
+        uint32_t start = entries.front().start;
+        if (!readPostings(start, entries.back().end, raw)) return false;
+        std::vector<uint8_t> seen(_pages.size(), 0);
+        for (const auto& entry : entries) {
+            if (!decode_postings(&raw[entry.start - start], entry.end - entry.start, list)) return false;
+            for (uint32_t page : list) {
+                if (page < seen.size()) seen[page] = 1;
+            }
+        }
+        for (uint32_t i = 0; i < seen.size(); i++) {
+            if (seen[i]) pages.push_back(i);
+        }
+        return true;
+    }
+
+    // 多字：各 bigram 的倒排表取交集，从最短的开始
+    std::vector<uint32_t> keys;
+    for (size_t i = 0; i + 1 < query.size(); i++) keys.push_back(bigram_key(query[i], query[i + 1]));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::vector<KeyEntry> ranges;
+    for (uint32_t key : keys) {
+        if (!findKeys(key, key, entries)) return false;
+        if (entries.empty()) return true;  // 有一个 bigram 不存在，没有结果
+        ranges.push_back(entries.front());
+    }
+    std::sort(ranges.begin(), ranges.end(),
+              [](const KeyEntry& a, const KeyEntry& b) { return a.end - a.start < b.end - b.start; });
+
+    std::vector<uint32_t> merged;
+    for (size_t r = 0; r < ranges.size(); r++) {
+        if (!readPostings(ranges[r].start, ranges[r].end, raw) ||
+            !decode_postings(raw.data(), raw.size(), r == 0 ? pages : list)) {
+            return false;
+        }
+        if (r == 0) continue;
+        merged.clear();
+        std::set_intersection(pages.begin(), pages.end(), list.begin(), list.end(), std::back_inserter(merged));
+        pages.swap(merged);
+        if (pages.empty()) break;
+    }
+    return true;
+}
+
+}  // namespace book
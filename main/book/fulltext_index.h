@@ -0,0 +1,252 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "text_layer.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace book {
+
+/*
+ * 全文检索：books/{id}/search.idx，由设备在后台根据各章文字层（text_layer.h）生成
+ *
+ * 与书名检索相同按相邻两个字符（bigram）建立倒排索引，码位各取低 16 位拼成 32 位键，
+ * 每页最后一个字符与换行再组成一个键，单字查询取以它开头的键（在键表中连续）。倒排单位是页，
+ * 全书各页按章节顺序编号（页序），每个键的倒排表为页序升序的差值（第一项为页序本身），LEB128 varint 编码。
+ * 页内文字按行拼接，相邻两行首尾都是字母数字时补一个空格；跨页的命中查不到。
+ *
+ * 文件格式（小端）：
+ *
+ *   0   char[4]  "PS3F"
+ *   4   u16      版本（1）
+ *   6   u16      联想字个数 C
+ *   8   u32      页数 N
+ *   12  u32      键数 K
+ *   16  u32      倒排区字节数 S
+ *   20  u32      键表字节数 T
+ *   24  N × { u16 章节, u16 页码 }      页序 → 页面
+ *       u32[C]   全书最常见的非 ASCII 字符，按出现次数降序
+ *       S 字节   倒排区，各键的倒排表按键的顺序首尾相接
+ *       T 字节   键表：每个键 { varint 与前一个键的差值, varint 倒排表字节数 }，每 128 个键一块，
+ *                块内第一个键的差值为 0
+ *       ⌈K / 128⌉ × { u32 块内第一个键, u32 块起点（相对键表）, u32 块内第一个倒排表的起点（相对倒排区） }
+ *
+ * 打开时只读入页表、联想字和块目录（每 128 个键 12 字节），查询时每个键读一块键表（几百字节）和它的倒排表；
+ * 单字查询的各个键在键表和倒排区中都连续，各读一次。
+ *
+ * 生成时每处理一章把 (键, 页序) 攒在内存中，超过 FULLTEXT_RUN_PAIRS 对就排序后写成一个临时的有序段
+ * （search.idx.run{N}），全部章节处理完后多路归并写出索引。各段的页序区间互不重叠且递增，
+ * 归并时同一个键的倒排表按段顺序首尾相接，只需改写每段的第一项差值。
+ */
+static constexpr uint32_t FULLTEXT_INDEX_VERSION      = 1;
+static constexpr size_t FULLTEXT_INDEX_HEADER_SIZE    = 24;
+static constexpr size_t FULLTEXT_BLOCK_ENTRY_SIZE     = 12;
+static constexpr size_t FULLTEXT_KEY_BLOCK            = 128;
+static constexpr size_t FULLTEXT_TOP_CHARS            = 40;
+static constexpr size_t FULLTEXT_RUN_PAIRS            = 128 * 1024;  // 每段 1MB（8 字节一对）
+static constexpr const char* FULLTEXT_INDEX_FILE_NAME = "search.idx";
+
+/**
+ * @brief 页面文字中的一个字符：归一化后的码位和在文字层中的位置
+ */
+struct SearchChar {
+    uint32_t codepoint = 0;  // fold_search_char 之后的字符
+    uint32_t line      = 0;  // 文字层行序号
+    uint32_t offset    = 0;  // 在该行文字中的字节位置
+    uint8_t bytes      = 0;  // 原文字节数；行间补的空格为 0
+    uint8_t units      = 1;  // 显示宽度：全角字符 2，其余 1，用于估算命中在行框中的横向位置
+};
+
+/**
+ * @brief 归一化查询串：逐字 fold_search_char，空白合并为一个空格并去掉首尾空白
+ */
+void fold_search_query(const std::string& query, std::vector<uint32_t>& chars);
+
+/**
+ * @brief 取出一页的检索文字（与建索引时相同的规则）
+ */
+void fold_page_text(const TextLayer& layer, int page, std::vector<SearchChar>& chars);
+
+struct FulltextHit {
+    int section = 0;
+    int page    = 1;
+    int matches = 0;             // 本页命中次数
+    std::string snippet;         // 第一处命中及前后文
+    std::vector<TextBox> boxes;  // 命中在页面上的位置（页面内坐标），跨行的命中每行一个框
+};
+
+/**
+ * @brief 在一页中查找查询串，得到命中次数、上下文和位置
+ * @param query fold_search_query 的结果
+ * @return 本页没有命中（索引的候选页可能是 bigram 都出现但不连续）时返回 false
+ */
+bool find_page_matches(const TextLayer& layer, int page, const std::vector<uint32_t>& query, FulltextHit& hit);
+
+struct FulltextPageRef {
+    int section = 0;
+    int page    = 1;  // 从 1 开始
+};
+
+/**
+ * @brief 生成索引所需的书籍信息：按章节顺序列出有文字层的章节
+ */
+struct FulltextSource {
+    std::string bookDir;  // books/{id}
+    std::vector<int> sections;
+};
+
+struct FulltextBuildStats {
+    uint32_t pages    = 0;
+    uint64_t chars    = 0;  // 归一化后的字符数
+    uint64_t postings = 0;  // (键, 页) 对数
+    uint32_t keys     = 0;
+    uint32_t runs     = 0;
+    uint64_t bytes    = 0;  // 索引文件大小
+};
+
+/**
+ * @brief 增量生成全文索引，每次 step() 处理一章，便于后台任务在章与章之间让出 CPU 和检查取消
+ *
+ * 中途 end() 时删除临时段，下次从头开始。
+ */
+class FulltextIndexBuilder {
+public:
+    FulltextIndexBuilder() = default;
+    ~FulltextIndexBuilder();
+    FulltextIndexBuilder(const FulltextIndexBuilder&)            = delete;
+    FulltextIndexBuilder& operator=(const FulltextIndexBuilder&) = delete;
+
+    /**
+     * @brief 开始生成；索引文件已存在且有效时 done() 直接为 true
+     */
+    bool begin(const FulltextSource& source);
+    void end();
+
+    /**
+     * @brief 处理下一章，全部处理完后的一次调用归并写出索引
+     * @return 已全部完成或出错时返回 false
+     */
+    bool step();
+
+    bool done() const
+    {
+        return _done;
+    }
+    int processed() const
+    {
+        return (int)_next;
+    }
+    int total() const
+    {
+        return (int)_source.sections.size();
+    }
+    const FulltextBuildStats& stats() const
+    {
+        return _stats;
+    }
+    const std::string& lastError() const
+    {
+        return _error;
+    }
+
+private:
+    FulltextSource _source;
+    std::string _path;
+    size_t _next = 0;
+    bool _active = false;
+    bool _done   = false;
+    std::string _error;
+    FulltextBuildStats _stats;
+    std::vector<uint64_t> _pairs;  // 键 << 32 | 页序
+    std::vector<FulltextPageRef> _pages;
+    std::unordered_map<uint32_t, uint32_t> _char_counts;
+    std::vector<SearchChar> _chars;  // 复用
+    std::vector<uint32_t> _keys;     // 复用
+
+    std::string runPath(uint32_t run) const;
+    bool flushRun();
+    bool merge();
+    void removeRuns();
+};
+
+/**
+ * @brief 只读访问全文索引
+ */
+class FulltextIndex {
+public:
+    FulltextIndex() = default;
+    ~FulltextIndex();
+    FulltextIndex(const FulltextIndex&)            = delete;
+    FulltextIndex& operator=(const FulltextIndex&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const
+    {
+        return _file != nullptr;
+    }
+
+    size_t pageCount() const
+    {
+        return _pages.size();
+    }
+    FulltextPageRef pageRef(uint32_t index) const;
+    const std::vector<uint32_t>& topChars() const
+    {
+        return _top_chars;
+    }
+
+    /**
+     * @brief 候选页：含查询串全部 bigram 的页（单字查询为含该字的页），页序升序
+     *
+     * 候选页需要再用 find_page_matches 确认。
+     * @param query fold_search_query 的结果
+     */
+    bool search(const std::vector<uint32_t>& query, std::vector<uint32_t>& pages);
+
+    size_t memoryBytes() const;
+    /**
+     * @brief 累计读卡次数
+     */
+    uint32_t reads() const
+    {
+        return _reads;
+    }
+
+private:
+    struct KeyEntry {
+        uint32_t key   = 0;
+        uint32_t start = 0;  // 倒排表在倒排区中的范围
+        uint32_t end   = 0;
+    };
+
+    FILE* _file = nullptr;
+    std::vector<uint32_t> _pages;  // 章节 << 16 | 页码
+    std::vector<uint32_t> _top_chars;
+    std::vector<uint32_t> _block_keys;      // 块目录：块内第一个键
+    std::vector<uint32_t> _block_offsets;   // 块起点（相对键表）
+    std::vector<uint32_t> _block_postings;  // 块内第一个倒排表的起点
+    uint32_t _key_count      = 0;
+    uint32_t _postings_start = 0;
+    uint32_t _postings_size  = 0;
+    uint32_t _keys_start     = 0;
+    uint32_t _keys_size      = 0;
+    uint32_t _reads          = 0;
+    std::vector<uint8_t> _buffer;  // 读取键表，复用
+
+    /**
+     * @brief 键表中 [low, high] 内的各键，一次读出覆盖它们的各块
+     */
+    bool findKeys(uint32_t low, uint32_t high, std::vector<KeyEntry>& entries);
+    bool readPostings(uint32_t start, uint32_t end, std::vector<uint8_t>& data);
+};
+
+}  // namespace book
@@ -0,0 +1,192 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "gray_png.h"
+#include "inflater.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace book {
+
+static const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+static inline uint32_t read_u32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+bool gray_png_probe(const uint8_t* data, size_t size, GrayPngInfo& info)
+{
+    // 签名 8 + 长度 4 + "IHDR" 4 + 数据 13
+    if (!data || size < 8 + 8 + 13 || memcmp(data, PNG_SIGNATURE, 8) != 0) {
+        return false;
+    }
+    const uint8_t* ihdr = data + 8;
+    if (read_u32(ihdr) != 13 || memcmp(ihdr + 4, "IHDR", 4) != 0) {
+        return false;
+    }
+
+    const uint8_t* p = ihdr + 8;
+    uint32_t width   = read_u32(p);
+    uint32_t height  = read_u32(p + 4);
+    int bitDepth     = p[8];
+    int colorType    = p[9];
+    int interlace    = p[12];
+
+    if (width == 0 || height == 0 || width > 0x7FFF || height > 0x7FFF) return false;
+    if (colorType != 0 || interlace != 0 || p[10] != 0 || p[11] != 0) return false;
+    if (bitDepth != 1 && bitDepth != 2 && bitDepth != 4 && bitDepth != 8) return false;
+
+    info.width    = (int)width;
+    info.height   = (int)height;
+    info.bitDepth = bitDepth;
+    return true;
+}
+
+static inline uint8_t paeth(int a, int b, int c)
+{
+    int p  = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    if (pb <= pc) return (uint8_t)b;
+    return (uint8_t)c;
+}
+
+// 灰度位深不超过 8，滤波器的 bpp 按规范取 1 字节
+static bool unfilter_row(int type, uint8_t* cur, const uint8_t* prev, size_t len)
+{
+    switch (type) {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = 1; i < len; i++) cur[i] = (uint8_t)(cur[i] + cur[i - 1]);
+            break;
+        case 2:
+            for (size_t i = 0; i < len; i++) cur[i] = (uint8_t)(cur[i] + prev[i]);
+            break;
+        case 3:
+            cur[0] = (uint8_t)(cur[0] + (prev[0] >> 1));
+            for (size_t i = 1; i < len; i++) cur[i] = (uint8_t)(cur[i] + ((cur[i - 1] + prev[i]) >> 1));
+            break;
+        case 4:
+            cur[0] = (uint8_t)(cur[0] + prev[0]);
+            for (size_t i = 1; i < len; i++) cur[i] = (uint8_t)(cur[i] + paeth(cur[i - 1], prev[i], prev[i - 1]));
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+void expand_gray_row(const uint8_t* packed, int width, int bitDepth, uint8_t* gray)
+{
+    switch (bitDepth) {
+        case 1:
+            for (int x = 0; x < width; x++) {
+                gray[x] = (packed[x >> 3] >> (7 - (x & 7))) & 1 ? 0xFF : 0x00;
+            }
+            break;
+        case 2:
+            for (int x = 0; x < width; x++) {
+                gray[x] = (uint8_t)(((packed[x >> 2] >> (6 - 2 * (x & 3))) & 3) * 0x55);
+            }
+            break;
+        case 4: {
+            int pairs = width >> 1;
+            for (int i = 0; i < pairs; i++) {
+                uint8_t b       = packed[i];
+                gray[2 * i]     = (uint8_t)((b >> 4) * 0x11);
+                gray[2 * i + 1] = (uint8_t)((b & 0x0F) * 0x11);
+            }
+            if (width & 1) {
+                gray[width - 1] = (uint8_t)((packed[pairs] >> 4) * 0x11);
+            }
+            break;
+        }
+        default:
+            memcpy(gray, packed, width);
+            break;
+    }
+}
+
+bool decode_gray_png(const uint8_t* data, size_t size, const GrayRowCallback& onRow, GrayPngInfo* info)
+{
+    GrayPngInfo header;
+    if (!gray_png_probe(data, size, header)) {
+        return false;
+    }
+    if (info) *info = header;
+
+    const size_t rowBytes = ((size_t)header.width * header.bitDepth + 7) / 8;
+
+    // 当前行（含滤波类型字节）、上一行、展开后的输出行
+    std::vector<uint8_t> cur(rowBytes + 1);
+    std::vector<uint8_t> prev(rowBytes, 0);
+    std::vector<uint8_t> gray(header.bitDepth == 8 ? 0 : header.width);
+
+    Inflater inflater;
+    if (!inflater.begin(Inflater::Format::Zlib)) {
+        return false;
+    }
+
+    int y         = 0;
+    size_t filled = 0;
+    size_t pos    = 8;
+
+    while (y < header.height && pos + 12 <= size) {
+        uint32_t len     = read_u32(data + pos);
+        const uint8_t* t = data + pos + 4;
+        if (len > size - pos - 12) {
+            return false;
+        }
+        const uint8_t* chunk = data + pos + 8;
+        pos += 12 + len;
+
+        if (memcmp(t, "IEND", 4) == 0) break;
+        if (memcmp(t, "IDAT", 4) != 0) continue;
+
+        inflater.setInput(chunk, len);
+        while (y < header.height) {
+            size_t produced        = 0;
+            Inflater::Status status = inflater.read(cur.data() + filled, cur.size() - filled, produced);
+            filled += produced;
+            if (status == Inflater::Status::Error) {
+                return false;
+            }
+
+            if (filled == cur.size()) {
+                uint8_t* row = cur.data() + 1;
+                if (!unfilter_row(cur[0], row, prev.data(), rowBytes)) {
+                    return false;
+                }
+
+                const uint8_t* out = row;
+                if (header.bitDepth != 8) {
+                    expand_gray_row(row, header.width, header.bitDepth, gray.data());
+                    out = gray.data();
+                }
+                if (!onRow(y, out, header.width)) {
+                    return false;
+                }
+
+                memcpy(prev.data(), row, rowBytes);
+                filled = 0;
+                y++;
+                continue;
+            }
+
+            if (status == Inflater::Status::Done) {
+                return false;  // 数据不足一整幅图
+            }
+            break;  // NeedInput：读取下一个 IDAT
+        }
+    }
+    return y == header.height;
+}
+
+}  // namespace book
@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace book {
+
+struct GrayPngInfo {
+    int width    = 0;
+    int height   = 0;
+    int bitDepth = 0;  // 1 / 2 / 4 / 8
+};
+
+/**
+ * @brief 解析 IHDR，判断能否走灰度快速路径
+ *
+ * 仅接受灰度（color type 0）、非隔行、位深 1/2/4/8 的 PNG；
+ * 其余格式（RGB、调色板、Alpha、16-bit）返回 false，由调用方回退到通用解码器。
+ */
+bool gray_png_probe(const uint8_t* data, size_t size, GrayPngInfo& info);
+
+/**
+ * @brief 逐行回调，gray 为展开后的 8-bit 灰度（第 i 级 = i × 255 / (2^bitDepth - 1)），返回 false 中止解码
+ */
+using GrayRowCallback = std::function<bool(int y, const uint8_t* gray, int width)>;
+
+/**
+ * @brief 打包行（高位在前）展开为 8-bit 灰度
+ */
+void expand_gray_row(const uint8_t* packed, int width, int bitDepth, uint8_t* gray);
+
+/**
+ * @brief 流式解码灰度 PNG
+ *
+ * 内存占用为两行打包数据 + 一行 8-bit 输出 + Inflater 状态，与图片高度无关。
+ * 不校验 CRC（与设备端通用解码器一致）。
+ *
+ * @return 格式不支持、数据损坏或回调中止时返回 false
+ */
+bool decode_gray_png(const uint8_t* data, size_t size, const GrayRowCallback& onRow, GrayPngInfo* info = nullptr);
+
+}  // namespace book
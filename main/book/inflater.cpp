@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "inflater.h"
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "rom/miniz.h"
+#else
+#include <zlib.h>
+#endif
+
+namespace book {
+
+#ifdef ESP_PLATFORM
+
+// tinfl 以 32KB 环形字典作为输出缓冲，解压结果先落在字典里再拷贝给调用方
+struct Inflater::Impl {
+    tinfl_decompressor decomp;
+    uint8_t dict[TINFL_LZ_DICT_SIZE];
+    size_t dictPos      = 0;  // 下一次写入位置
+    size_t pendingStart = 0;  // 尚未交给调用方的数据
+    size_t pendingLen   = 0;
+};
+
+bool Inflater::begin(Format format)
+{
+    // 重复使用时保留已分配的字典，只重置解码状态
+    if (!_impl) {
+        _impl = (Impl*)malloc(sizeof(Impl));
+        if (!_impl) return false;
+    }
+    tinfl_init(&_impl->decomp);
+    _impl->dictPos      = 0;
+    _impl->pendingStart = 0;
+    _impl->pendingLen   = 0;
+
+    _format  = format;
+    _started = true;
+    _done    = false;
+    _in      = nullptr;
+    _in_len  = 0;
+    return true;
+}
+
+void Inflater::end()
+{
+    free(_impl);
+    _impl    = nullptr;
+    _started = false;
+}
+
+Inflater::Status Inflater::read(uint8_t* out, size_t len, size_t& produced)
+{
+    produced = 0;
+    if (!_started) return Status::Error;
+
+    const mz_uint32 flags =
+        TINFL_FLAG_HAS_MORE_INPUT | (_format == Format::Zlib ? TINFL_FLAG_PARSE_ZLIB_HEADER : 0);
+
+    while (produced < len) {
+        if (_impl->pendingLen > 0) {
+            size_t n = _impl->pendingLen < len - produced ? _impl->pendingLen : len - produced;
+            memcpy(out + produced, _impl->dict + _impl->pendingStart, n);
+            produced += n;
+            _impl->pendingStart += n;
+            _impl->pendingLen -= n;
+            continue;
+        }
+        if (_done) return Status::Done;
+
+        size_t inSize  = _in_len;
+        size_t outSize = TINFL_LZ_DICT_SIZE - _impl->dictPos;
+        tinfl_status status =
+            tinfl_decompress(&_impl->decomp, _in, &inSize, _impl->dict, _impl->dict + _impl->dictPos, &outSize, flags);
+
+        _in += inSize;
+        _in_len -= inSize;
+        _impl->pendingStart = _impl->dictPos;
+        _impl->pendingLen   = outSize;
+        _impl->dictPos      = (_impl->dictPos + outSize) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status < TINFL_STATUS_DONE) return Status::Error;
+        if (status == TINFL_STATUS_DONE) {
+            _done = true;
+        } else if (status == TINFL_STATUS_NEEDS_MORE_INPUT && outSize == 0) {
+            return Status::NeedInput;
+        }
+    }
+    return Status::Ok;
+}
+
+#else
+
+struct Inflater::Impl {
+    z_stream stream;
+};
+
+bool Inflater::begin(Format format)
+{
+    int windowBits = format == Format::Zlib ? 15 : -15;
+    if (_impl) {
+        // 重复使用时只重置流状态
+        if (inflateReset2(&_impl->stream, windowBits) != Z_OK) {
+            end();
+        }
+    }
+    if (!_impl) {
+        _impl = new Impl();
+        memset(&_impl->stream, 0, sizeof(_impl->stream));
+        if (inflateInit2(&_impl->stream, windowBits) != Z_OK) {
+            delete _impl;
+            _impl = nullptr;
+            return false;
+        }
+    }
+
+    _format  = format;
+    _started = true;
+    _done    = false;
+    _in      = nullptr;
+    _in_len  = 0;
+    return true;
+}
+
+void Inflater::end()
+{
+    if (_impl) {
+        inflateEnd(&_impl->stream);
+        delete _impl;
+        _impl = nullptr;
+    }
+    _started = false;
+}
+
+Inflater::Status Inflater::read(uint8_t* out, size_t len, size_t& produced)
+{
+    produced = 0;
+    if (!_started) return Status::Error;
+    if (_done) return Status::Done;
+
+    z_stream& s = _impl->stream;
+    s.next_in   = const_cast<Bytef*>(_in);
+    s.avail_in  = (uInt)_in_len;
+    s.next_out  = out;
+    s.avail_out = (uInt)len;
+
+    int ret  = inflate(&s, Z_NO_FLUSH);
+    produced = len - s.avail_out;
+    _in      = s.next_in;
+    _in_len  = s.avail_in;
+
+    if (ret == Z_STREAM_END) {
+        _done = true;
+        return Status::Done;
+    }
+    if (ret != Z_OK && ret != Z_BUF_ERROR) return Status::Error;
+    if (produced == len) return Status::Ok;
+    return Status::NeedInput;
+}
+
+#endif
+
+Inflater::~Inflater()
+{
+    end();
+}
+
+void Inflater::setInput(const uint8_t* data, size_t len)
+{
+    _in     = data;
+    _in_len = len;
+}
+
+}  // namespace book
@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace book {
+
+/**
+ * @brief 流式 inflate，设备端使用 ROM 中的 tinfl，主机端使用 zlib
+ *
+ * 调用方通过 setInput() 提供输入（不复制，NeedInput 之前必须保持有效），
+ * 再用 read() 按需取出解压数据。内存占用固定：设备端为 32KB 字典 + tinfl 状态。
+ */
+class Inflater {
+public:
+    enum class Format {
+        Zlib,  // 带 zlib 头（PNG IDAT）
+        Raw,   // 裸 deflate（ZIP 条目）
+    };
+
+    enum class Status {
+        Ok,         // out 已填满
+        NeedInput,  // 输入耗尽，out 可能部分填充
+        Done,       // 流结束，out 可能部分填充
+        Error,
+    };
+
+    Inflater() = default;
+    ~Inflater();
+    Inflater(const Inflater&)            = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+    /**
+     * @brief 开始新的流，可重复调用；已分配的状态会被复用
+     */
+    bool begin(Format format);
+    void end();
+
+    void setInput(const uint8_t* data, size_t len);
+    size_t inputRemaining() const
+    {
+        return _in_len;
+    }
+
+    /**
+     * @brief 解压最多 len 字节到 out
+     * @param produced 实际写入的字节数
+     */
+    Status read(uint8_t* out, size_t len, size_t& produced);
+
+private:
+    const uint8_t* _in = nullptr;
+    size_t _in_len     = 0;
+    bool _started      = false;
+    bool _done         = false;
+    Format _format     = Format::Zlib;
+
+    // 具体实现的状态（tinfl 或 z_stream），定义见 inflater.cpp
+    struct Impl;
+    Impl* _impl = nullptr;
+};
+
+}  // namespace book
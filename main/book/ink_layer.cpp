@@ -0,0 +1,483 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "ink_layer.h"
+#include "varint.h"
+#include <algorithm>
+#include <cstring>
+
+namespace book {
+
+static inline uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static void write_record_header(uint8_t* p, uint32_t key, uint8_t type, uint8_t width, uint16_t bytes)
+{
+    put_u32(p, key);
+    p[4] = type;
+    p[5] = width;
+    put_u16(p + 6, bytes);
+}
+
+static void write_file_header(uint8_t* p)
+{
+    memcpy(p, "PS3I", 4);
+    put_u16(p + 4, INK_VERSION);
+    put_u16(p + 6, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    编码                                    */
+/* -------------------------------------------------------------------------- */
+
+void InkRect::include(InkPoint p, int radius)
+{
+    int x0 = p.x - radius;
+    int y0 = p.y - radius;
+    int x1 = p.x + radius + 1;
+    int y1 = p.y + radius + 1;
+    if (!empty()) {
+        x0 = std::min(x0, x);
+        y0 = std::min(y0, y);
+        x1 = std::max(x1, x + w);
+        y1 = std::max(y1, y + h);
+    }
+    x = x0;
+    y = y0;
+    w = x1 - x0;
+    h = y1 - y0;
+}
+
+void encode_ink_stroke(const InkStroke& stroke, std::vector<uint8_t>& out)
+{
+    out.clear();
+    append_varint(out, (uint32_t)stroke.points.size());
+    if (stroke.points.empty()) return;
+
+    // 坐标不会为负（屏幕内），第一个点直接存
+    InkPoint prev = stroke.points[0];
+    append_varint(out, (uint32_t)std::max<int>(0, prev.x));
+    append_varint(out, (uint32_t)std::max<int>(0, prev.y));
+    for (size_t i = 1; i < stroke.points.size(); i++) {
+        const InkPoint& p = stroke.points[i];
+        append_varint(out, zigzag(p.x - prev.x));
+        append_varint(out, zigzag(p.y - prev.y));
+        prev = p;
+    }
+}
+
+bool decode_ink_stroke(const uint8_t* data, size_t size, uint8_t width, InkStroke& stroke)
+{
+    stroke.width = width;
+    stroke.points.clear();
+
+    uint32_t count = 0;
+    size_t pos     = read_varint(data, size, count);
+    if (pos == 0 || count > INK_MAX_STROKE_POINTS) return false;
+    stroke.points.reserve(count);
+
+    int32_t x = 0;
+    int32_t y = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t vx, vy;
+        size_t n = read_varint(data + pos, size - pos, vx);
+        if (n == 0) return false;
+        pos += n;
+        n = read_varint(data + pos, size - pos, vy);
+        if (n == 0) return false;
+        pos += n;
+
+        if (i == 0) {
+            x = (int32_t)vx;
+            y = (int32_t)vy;
+        } else {
+            x += unzigzag(vx);
+            y += unzigzag(vy);
+        }
+        InkPoint p;
+        p.x = (int16_t)x;
+        p.y = (int16_t)y;
+        stroke.points.push_back(p);
+    }
+    return pos == size;
+}
+
+InkRect ink_stroke_bounds(const InkStroke& stroke)
+{
+    InkRect rect;
+    int radius = (stroke.width + 1) / 2;
+    for (const auto& p : stroke.points) {
+        rect.include(p, radius);
+    }
+    return rect;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 InkBatcher                                 */
+/* -------------------------------------------------------------------------- */
+
+InkBatcher::InkBatcher(uint32_t batchMs, int maxSide, int minDistance)
+    : _batch_ms(batchMs), _max_side(maxSide), _min_distance(minDistance)
+{
+}
+
+void InkBatcher::begin(InkPoint p, uint32_t timeMs, uint8_t width)
+{
+    _active       = true;
+    _stroke.width = width;
+    _stroke.points.clear();
+    _stroke.points.push_back(p);
+
+    // 落笔点本身作为一段（长度为 0）立即输出，第一笔墨迹不等攒批
+    _segments.clear();
+    _segments.push_back({p, p});
+    _rect = InkRect();
+    _rect.include(p, (width + 1) / 2);
+    _oldest_ms = timeMs;
+    _first     = true;
+}
+
+bool InkBatcher::add(InkPoint p, uint32_t timeMs)
+{
+    if (!_active) return false;
+
+    const InkPoint last = _stroke.points.back();
+    int dx              = p.x - last.x;
+    int dy              = p.y - last.y;
+    if (dx * dx + dy * dy < _min_distance * _min_distance) return due(timeMs);
+
+    if (_segments.empty()) {
+        _oldest_ms = timeMs;
+    }
+    _stroke.points.push_back(p);
+    _segments.push_back({last, p});
+    int radius = (_stroke.width + 1) / 2;
+    _rect.include(last, radius);
+    _rect.include(p, radius);
+    return due(timeMs);
+}
+
+bool InkBatcher::due(uint32_t timeMs) const
+{
+    if (_segments.empty()) return false;
+    return _first || timeMs - _oldest_ms >= _batch_ms || _rect.w > _max_side || _rect.h > _max_side;
+}
+
+void InkBatcher::take(std::vector<InkSegment>& segments, InkRect& rect, uint32_t& oldestMs)
+{
+    segments.swap(_segments);
+    _segments.clear();
+    rect     = _rect;
+    oldestMs = _oldest_ms;
+    _rect    = InkRect();
+    _first   = false;
+}
+
+InkStroke InkBatcher::finish()
+{
+    _active = false;
+    _segments.clear();
+    _rect = InkRect();
+    InkStroke stroke;
+    stroke.width = _stroke.width;
+    stroke.points.swap(_stroke.points);
+    return stroke;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               InkLatencyStats                              */
+/* -------------------------------------------------------------------------- */
+
+uint32_t InkLatencyStats::percentile(int percent) const
+{
+    if (_samples.empty()) return 0;
+    std::vector<uint32_t> sorted = _samples;
+    size_t index = std::min(sorted.size() - 1, sorted.size() * (size_t)percent / 100);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+uint32_t InkLatencyStats::max() const
+{
+    return _samples.empty() ? 0 : *std::max_element(_samples.begin(), _samples.end());
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  InkStore                                  */
+/* -------------------------------------------------------------------------- */
+
+InkStore::~InkStore()
+{
+    close();
+}
+
+bool InkStore::open(const std::string& path)
+{
+    close();
+    _path = path;
+
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return true;  // 还没有笔迹
+
+    fseek(f, 0, SEEK_END);
+    long fileSize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    _buffer.resize(fileSize > 0 ? (size_t)fileSize : 0);
+    bool ok = _buffer.empty() || fread(_buffer.data(), 1, _buffer.size(), f) == _buffer.size();
+    fclose(f);
+    if (!ok) {
+        close();
+        return false;
+    }
+
+    bool truncated = false;
+    if (!scan(truncated)) {
+        // 文件头无效：当作没有笔迹，第一次写入时重建
+        _pages.clear();
+        _size    = 0;
+        _garbage = 0;
+    } else if (truncated || (_garbage * 2 > _size && _size >= INK_COMPACT_MIN_BYTES)) {
+        compact();
+    } else {
+        _file = fopen(path.c_str(), "r+b");
+    }
+    _buffer.clear();
+    _buffer.shrink_to_fit();
+    return true;
+}
+
+void InkStore::close()
+{
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+    _path.clear();
+    _pages.clear();
+    _size    = 0;
+    _garbage = 0;
+    _buffer.clear();
+}
+
+bool InkStore::scan(bool& truncated)
+{
+    truncated = false;
+    if (_buffer.size() < INK_HEADER_SIZE || memcmp(_buffer.data(), "PS3I", 4) != 0 ||
+        get_u16(_buffer.data() + 4) != INK_VERSION) {
+        return false;
+    }
+
+    size_t pos = INK_HEADER_SIZE;
+    while (pos + INK_RECORD_HEADER_SIZE <= _buffer.size()) {
+        const uint8_t* p = _buffer.data() + pos;
+        uint32_t key     = get_u32(p);
+        uint8_t type     = p[4];
+        uint8_t width    = p[5];
+        uint16_t bytes   = get_u16(p + 6);
+        if (pos + INK_RECORD_HEADER_SIZE + bytes > _buffer.size()) break;
+
+        if (type == INK_RECORD_STROKE) {
+            StrokeRef ref;
+            ref.offset = (uint32_t)(pos + INK_RECORD_HEADER_SIZE);
+            ref.bytes  = bytes;
+            ref.width  = width;
+            _pages[key].push_back(ref);
+        } else if (type == INK_RECORD_UNDO) {
+            auto it = _pages.find(key);
+            if (it != _pages.end() && !it->second.empty()) {
+                _garbage += INK_RECORD_HEADER_SIZE + it->second.back().bytes;
+                it->second.pop_back();
+                if (it->second.empty()) _pages.erase(it);
+            }
+            _garbage += INK_RECORD_HEADER_SIZE + bytes;
+        } else {
+            break;
+        }
+        pos += INK_RECORD_HEADER_SIZE + bytes;
+    }
+
+    _size     = pos;
+    truncated = pos != _buffer.size();
+    return true;
+}
+
+bool InkStore::compact()
+{
+    std::string tmpPath = _path + ".tmp";
+    FILE* f             = fopen(tmpPath.c_str(), "wb");
+    if (!f) return false;
+
+    uint8_t header[INK_HEADER_SIZE];
+    write_file_header(header);
+    bool ok = fwrite(header, 1, sizeof(header), f) == sizeof(header);
+
+    // 按页键顺序写出现存的笔画，同一页的笔画保持书写顺序
+    std::vector<uint32_t> keys;
+    keys.reserve(_pages.size());
+    for (const auto& page : _pages) {
+        keys.push_back(page.first);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    uint64_t size = INK_HEADER_SIZE;
+    for (uint32_t key : keys) {
+        for (auto& ref : _pages[key]) {
+            uint8_t record[INK_RECORD_HEADER_SIZE];
+            write_record_header(record, key, INK_RECORD_STROKE, ref.width, ref.bytes);
+            ok = ok && fwrite(record, 1, sizeof(record), f) == sizeof(record);
+            ok = ok && fwrite(_buffer.data() + ref.offset, 1, ref.bytes, f) == ref.bytes;
+            ref.offset = (uint32_t)(size + INK_RECORD_HEADER_SIZE);
+            size += INK_RECORD_HEADER_SIZE + ref.bytes;
+        }
+    }
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        ::remove(tmpPath.c_str());
+        return false;
+    }
+
+    ::remove(_path.c_str());
+    if (::rename(tmpPath.c_str(), _path.c_str()) != 0) return false;
+    _size    = size;
+    _garbage = 0;
+    _file    = fopen(_path.c_str(), "r+b");
+    return _file != nullptr;
+}
+
+bool InkStore::openForWrite()
+{
+    if (_file) return true;
+    if (_path.empty()) return false;
+
+    // 文件不存在或文件头无效：重新创建
+    _file = fopen(_path.c_str(), "w+b");
+    if (!_file) return false;
+    uint8_t header[INK_HEADER_SIZE];
+    write_file_header(header);
+    if (fwrite(header, 1, sizeof(header), _file) != sizeof(header)) {
+        fclose(_file);
+        _file = nullptr;
+        return false;
+    }
+    _size = INK_HEADER_SIZE;
+    return true;
+}
+
+bool InkStore::appendRecord(uint32_t key, uint8_t type, uint8_t width, const std::vector<uint8_t>& data)
+{
+    if (!openForWrite() || data.size() > UINT16_MAX) return false;
+    if (fseek(_file, (long)_size, SEEK_SET) != 0) return false;
+
+    uint8_t record[INK_RECORD_HEADER_SIZE];
+    write_record_header(record, key, type, width, (uint16_t)data.size());
+    bool ok = fwrite(record, 1, sizeof(record), _file) == sizeof(record);
+    ok      = ok && (data.empty() || fwrite(data.data(), 1, data.size(), _file) == data.size());
+    ok      = ok && fflush(_file) == 0;
+    if (!ok) return false;
+
+    _size += INK_RECORD_HEADER_SIZE + data.size();
+    return true;
+}
+
+size_t InkStore::strokeCount(uint32_t key) const
+{
+    auto it = _pages.find(key);
+    return it == _pages.end() ? 0 : it->second.size();
+}
+
+bool InkStore::loadPage(uint32_t key, std::vector<InkStroke>& strokes)
+{
+    strokes.clear();
+    auto it = _pages.find(key);
+    if (it == _pages.end()) return true;
+    if (!_file) return false;
+
+    strokes.reserve(it->second.size());
+    for (const auto& ref : it->second) {
+        _buffer.resize(ref.bytes);
+        if (fseek(_file, ref.offset, SEEK_SET) != 0 || fread(_buffer.data(), 1, ref.bytes, _file) != ref.bytes) {
+            return false;
+        }
+        InkStroke stroke;
+        if (decode_ink_stroke(_buffer.data(), ref.bytes, ref.width, stroke)) {
+            strokes.push_back(std::move(stroke));
+        }
+    }
+    return true;
+}
+
+bool InkStore::append(uint32_t key, const InkStroke& stroke)
+{
+    if (stroke.points.empty()) return false;
+
+    // 超长的一笔分段保存，相邻两段共用一个点，连起来仍是一笔
+    size_t first = 0;
+    while (first < stroke.points.size()) {
+        size_t last = std::min(stroke.points.size(), first + INK_MAX_STROKE_POINTS);
+        InkStroke part;
+        part.width = stroke.width;
+        part.points.assign(stroke.points.begin() + first, stroke.points.begin() + last);
+
+        std::vector<uint8_t> data;
+        encode_ink_stroke(part, data);
+        if (!appendRecord(key, INK_RECORD_STROKE, stroke.width, data)) return false;
+
+        // 第一次写入时 openForWrite 才建好文件，数据位置在追加之后计算
+        StrokeRef ref;
+        ref.offset = (uint32_t)(_size - data.size());
+        ref.bytes  = (uint16_t)data.size();
+        ref.width  = stroke.width;
+        _pages[key].push_back(ref);
+
+        if (last == stroke.points.size()) break;
+        first = last - 1;
+    }
+    return true;
+}
+
+bool InkStore::undo(uint32_t key)
+{
+    auto it = _pages.find(key);
+    if (it == _pages.end() || it->second.empty()) return false;
+    if (!appendRecord(key, INK_RECORD_UNDO, 0, std::vector<uint8_t>())) return false;
+
+    _garbage += INK_RECORD_HEADER_SIZE * 2 + it->second.back().bytes;
+    it->second.pop_back();
+    if (it->second.empty()) _pages.erase(it);
+    return true;
+}
+
+}  // namespace book
@@ -0,0 +1,240 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace book {
+
+/*
+ * 批注笔迹：books/{id}/ink.bin（纯文本书籍为 {正文}.ink），阅读器批注模式中用手指或触控笔书写
+ *
+ * 每一笔存为折线：第一个点的坐标，之后每点相对前一点的差值，zigzag + LEB128 varint 编码。
+ * 书写时相邻采样点相距只有几个像素，每点通常 2 字节。文件只追加：每写完一笔追加一条笔画记录，
+ * 撤销追加一条撤销记录，打开时顺序扫描得到各页现存的笔画；被撤销的字节超过一半、
+ * 或文件尾有不完整的记录（写入中断电）时，打开时重写文件（先写 .tmp 再改名）。
+ * 文件格式（小端）：
+ *
+ *   0   char[4]  "PS3I"
+ *   4   u16      版本（1）
+ *   6   u16      保留（0）
+ *   8   记录，首尾相接：{ u32 页键, u8 类型, u8 笔宽, u16 数据字节数, 数据 }
+ *
+ * 类型 1 为笔画，数据为 { varint 点数, varint x0, varint y0, 之后每点 zigzag varint dx, dy }；
+ * 类型 2 撤销该页最后一笔，没有数据。页键由阅读器决定：分页的书为 章节 << 16 | 页码，纯文本书籍为页首偏移。
+ */
+static constexpr uint32_t INK_VERSION           = 1;
+static constexpr size_t INK_HEADER_SIZE         = 8;
+static constexpr size_t INK_RECORD_HEADER_SIZE  = 8;
+static constexpr uint8_t INK_RECORD_STROKE      = 1;
+static constexpr uint8_t INK_RECORD_UNDO        = 2;
+static constexpr size_t INK_MAX_STROKE_POINTS   = 8192;  // 数据不超过 u16，更长的一笔分成多笔
+static constexpr size_t INK_COMPACT_MIN_BYTES   = 4096;
+static constexpr int INK_MIN_DISTANCE           = 2;   // 与上一点相距小于此值（像素）的采样点丢弃
+static constexpr uint32_t INK_BATCH_MS          = 24;  // 一批线段最多攒这么久
+static constexpr int INK_BATCH_MAX_SIDE         = 96;  // 一批的脏矩形边长超过时立即输出
+static constexpr const char* INK_FILE_NAME      = "ink.bin";
+static constexpr const char* INK_TEXT_SUFFIX    = ".ink";
+
+struct InkPoint {
+    int16_t x = 0;
+    int16_t y = 0;
+};
+
+struct InkStroke {
+    uint8_t width = 3;  // 像素
+    std::vector<InkPoint> points;
+};
+
+struct InkRect {
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+
+    bool empty() const
+    {
+        return w <= 0 || h <= 0;
+    }
+    /**
+     * @brief 扩展到包含以 p 为中心、半径 radius 的正方形
+     */
+    void include(InkPoint p, int radius);
+};
+
+/**
+ * @brief 笔画编码为记录数据（不含记录头）
+ */
+void encode_ink_stroke(const InkStroke& stroke, std::vector<uint8_t>& out);
+bool decode_ink_stroke(const uint8_t* data, size_t size, uint8_t width, InkStroke& stroke);
+
+/**
+ * @brief 笔画的包围盒（已按笔宽外扩）
+ */
+InkRect ink_stroke_bounds(const InkStroke& stroke);
+
+struct InkSegment {
+    InkPoint a;
+    InkPoint b;
+};
+
+/**
+ * @brief 书写中的一笔：过滤采样点，把新线段攒成批，每批输出一个脏矩形
+ *
+ * EPD 每次刷新的耗时与区域大小关系不大，逐段刷新时刷新请求排队，笔迹越来越落后于手指；
+ * 攒批后一次刷新覆盖一批线段的包围盒。落笔点立即输出，之后一批攒够 INK_BATCH_MS
+ * 或包围盒边长超过 INK_BATCH_MAX_SIDE 时到期；调用方还要等面板空闲（上一批刷新完）再输出，
+ * 面板忙时线段继续攒在这一批里，笔迹最多落后一次刷新。
+ */
+class InkBatcher {
+public:
+    InkBatcher(uint32_t batchMs = INK_BATCH_MS, int maxSide = INK_BATCH_MAX_SIDE, int minDistance = INK_MIN_DISTANCE);
+
+    /**
+     * @brief 落笔
+     */
+    void begin(InkPoint p, uint32_t timeMs, uint8_t width);
+
+    /**
+     * @brief 输入一个采样点
+     * @return 当前一批应当输出时返回 true
+     */
+    bool add(InkPoint p, uint32_t timeMs);
+
+    /**
+     * @brief 当前一批是否到期（没有新采样点时由调用方轮询）
+     */
+    bool due(uint32_t timeMs) const;
+
+    bool pending() const
+    {
+        return !_segments.empty();
+    }
+
+    /**
+     * @brief 取出当前一批：线段、脏矩形和其中最早的采样时间
+     */
+    void take(std::vector<InkSegment>& segments, InkRect& rect, uint32_t& oldestMs);
+
+    bool active() const
+    {
+        return _active;
+    }
+    const InkStroke& stroke() const
+    {
+        return _stroke;
+    }
+    /**
+     * @brief 抬笔，返回整笔（只有一个点时为一个点的笔画）
+     */
+    InkStroke finish();
+
+private:
+    uint32_t _batch_ms;
+    int _max_side;
+    int _min_distance;
+    bool _active = false;
+    bool _first  = false;  // 本笔的第一批还没输出
+    InkStroke _stroke;
+    std::vector<InkSegment> _segments;
+    InkRect _rect;
+    uint32_t _oldest_ms = 0;
+};
+
+/**
+ * @brief 延迟统计：保留全部样本，按需排序取分位数
+ */
+class InkLatencyStats {
+public:
+    void add(uint32_t ms)
+    {
+        _samples.push_back(ms);
+    }
+    void clear()
+    {
+        _samples.clear();
+    }
+    size_t count() const
+    {
+        return _samples.size();
+    }
+    /**
+     * @param percent 0-100
+     */
+    uint32_t percentile(int percent) const;
+    uint32_t max() const;
+
+private:
+    std::vector<uint32_t> _samples;
+};
+
+/**
+ * @brief 一本书的笔迹文件
+ */
+class InkStore {
+public:
+    InkStore() = default;
+    ~InkStore();
+    InkStore(const InkStore&)            = delete;
+    InkStore& operator=(const InkStore&) = delete;
+
+    /**
+     * @brief 打开并扫描；文件不存在时也返回 true，第一次写入时创建
+     */
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const
+    {
+        return !_path.empty();
+    }
+
+    size_t strokeCount(uint32_t key) const;
+    bool loadPage(uint32_t key, std::vector<InkStroke>& strokes);
+
+    /**
+     * @brief 追加一笔并 fflush
+     */
+    bool append(uint32_t key, const InkStroke& stroke);
+    /**
+     * @brief 撤销该页最后一笔
+     */
+    bool undo(uint32_t key);
+
+    uint64_t fileBytes() const
+    {
+        return _size;
+    }
+    uint64_t garbageBytes() const
+    {
+        return _garbage;
+    }
+
+private:
+    struct StrokeRef {
+        uint32_t offset = 0;  // 数据在文件中的位置
+        uint16_t bytes  = 0;
+        uint8_t width   = 0;
+    };
+
+    std::string _path;
+    FILE* _file = nullptr;  // 第一次写入时以 r+b 打开
+    std::unordered_map<uint32_t, std::vector<StrokeRef>> _pages;
+    uint64_t _size    = 0;  // 有效记录的末尾
+    uint64_t _garbage = 0;  // 被撤销的笔画和撤销记录
+    std::vector<uint8_t> _buffer;
+
+    bool scan(bool& truncated);
+    bool compact();
+    bool openForWrite();
+    bool appendRecord(uint32_t key, uint8_t type, uint8_t width, const std::vector<uint8_t>& data);
+};
+
+}  // namespace book
@@ -0,0 +1,70 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "library_changes.h"
+
+namespace book {
+
+LibraryChanges& LibraryChanges::getInstance()
+{
+    static LibraryChanges instance(FsEventBus::getInstance());
+    return instance;
+}
+
+LibraryChanges::LibraryChanges(FsEventBus& bus, const std::string& root) : _bus(bus), _root(root)
+{
+    while (_root.size() > 1 && _root.back() == '/') _root.pop_back();
+    _bus.subscribe(_sub, _root);
+}
+
+void LibraryChanges::notify(const std::string& path)
+{
+    // 合并重复的 /（调用方常把目录和相对路径直接拼接）
+    std::string p;
+    p.reserve(path.size());
+    for (char c : path) {
+        if (c != '/' || p.empty() || p.back() != '/') p += c;
+    }
+    while (p.size() > 1 && p.back() == '/') p.pop_back();
+
+    // 书架目录本身或它的上层
+    if (_root.compare(0, p.size(), p) == 0 && (p.size() == _root.size() || _root[p.size()] == '/' || p == "/")) {
+        notifyAll();
+        return;
+    }
+    if (p.size() <= _root.size() + 1 || p.compare(0, _root.size(), _root) != 0 || p[_root.size()] != '/') return;
+
+    size_t start = _root.size() + 1;
+    size_t end   = p.find('/', start);
+    std::string id = p.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    if (id.empty() || id[0] == '.') return;
+    if (!_all) _ids.insert(id);
+}
+
+void LibraryChanges::notifyAll()
+{
+    _all = true;
+    _ids.clear();
+}
+
+bool LibraryChanges::take(std::vector<std::string>& ids)
+{
+    FsEvent event;
+    while (_bus.poll(_sub, event)) {
+        if (event.type == FsEventType::Overflow) {
+            notifyAll();
+        } else {
+            notify(event.path);
+        }
+    }
+
+    ids.assign(_ids.begin(), _ids.end());
+    _ids.clear();
+    bool all = _all;
+    _all     = false;
+    return all;
+}
+
+}  // namespace book
@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+#include "fs_events.h"
+
+namespace book {
+
+/*
+ * 书架变化：订阅 FsEventBus 上 books/ 前缀的事件，书架打开时取出，只重新读取变化的书籍
+ *
+ * books/{id} 及其下的路径记为书籍 id 变化（id 为目录名或 .txt 文件名，以 . 开头的书架自用文件忽略）；
+ * books/ 本身或它的上层目录、以及总线溢出记为需要全量扫描。只在书架所在的任务中使用。
+ */
+static constexpr const char* LIBRARY_ROOT = "/sdcard/books";
+
+class LibraryChanges {
+public:
+    static LibraryChanges& getInstance();
+
+    /**
+     * @brief 从构造时起订阅 bus 上 root 下的事件
+     */
+    LibraryChanges(FsEventBus& bus, const std::string& root = LIBRARY_ROOT);
+
+    /**
+     * @brief 直接记录一次改动（不经过总线），path 为完整路径，可以带末尾的 /
+     */
+    void notify(const std::string& path);
+    /**
+     * @brief 下次取出时要求全量扫描
+     */
+    void notifyAll();
+
+    /**
+     * @brief 取出总线上积累的事件并清空
+     * @param ids 变化的书籍 id，去重
+     * @return 需要全量扫描时返回 true（此时 ids 为空）
+     */
+    bool take(std::vector<std::string>& ids);
+
+    const FsSubscription& subscription() const
+    {
+        return _sub;
+    }
+
+private:
+    FsEventBus& _bus;
+    FsSubscription _sub;
+    std::string _root;
+    std::set<std::string> _ids;
+    bool _all = false;
+};
+
+}  // namespace book
@@ -0,0 +1,331 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "markup_scanner.h"
+#include "text_book.h"
+#include <algorithm>
+#include <cstring>
+
+namespace book {
+
+struct NamedEntity {
+    const char* name;
+    uint32_t codepoint;
+};
+
+// XML 预定义实体 + 电子书中常见的 HTML 实体
+static const NamedEntity NAMED_ENTITIES[] = {
+    {"amp", '&'},       {"lt", '<'},        {"gt", '>'},        {"quot", '"'},      {"apos", '\''},
+    {"nbsp", 0x00A0},   {"shy", 0x00AD},    {"copy", 0x00A9},   {"reg", 0x00AE},    {"middot", 0x00B7},
+    {"laquo", 0x00AB},  {"raquo", 0x00BB},  {"ensp", 0x2002},   {"emsp", 0x2003},   {"thinsp", 0x2009},
+    {"ndash", 0x2013},  {"mdash", 0x2014},  {"lsquo", 0x2018},  {"rsquo", 0x2019},  {"ldquo", 0x201C},
+    {"rdquo", 0x201D},  {"bull", 0x2022},   {"hellip", 0x2026}, {"trade", 0x2122},
+};
+
+static inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline char to_lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c + 32) : c;
+}
+
+// 小写并去掉命名空间前缀
+static std::string local_name(const char* data, size_t len)
+{
+    const char* colon = (const char*)memchr(data, ':', len);
+    if (colon) {
+        len -= (size_t)(colon + 1 - data);
+        data = colon + 1;
+    }
+    std::string name(data, len);
+    for (auto& c : name) c = to_lower(c);
+    return name;
+}
+
+MarkupScanner::MarkupScanner(Handler& handler) : _handler(handler)
+{
+    _tag.reserve(64);
+}
+
+void MarkupScanner::reset()
+{
+    _state      = State::Text;
+    _quote      = 0;
+    _entity_len = 0;
+    _text_len   = 0;
+    _tail       = 0;
+    _tag.clear();
+}
+
+void MarkupScanner::putText(const char* data, size_t len)
+{
+    while (len > 0) {
+        if (_text_len == TEXT_BUFFER_SIZE) flushFull();
+        size_t n = std::min(len, TEXT_BUFFER_SIZE - _text_len);
+        memcpy(_text + _text_len, data, n);
+        _text_len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void MarkupScanner::putCodepoint(uint32_t codepoint)
+{
+    char utf8[4];
+    putText(utf8, encode_utf8(codepoint, utf8));
+}
+
+void MarkupScanner::flushFull()
+{
+    // 缓冲区满时不在 UTF-8 字符中间断开：末尾不完整的字符留到下一次
+    size_t keep = 0;
+    for (size_t back = 1; back <= 3 && back <= _text_len; back++) {
+        uint8_t c = (uint8_t)_text[_text_len - back];
+        if ((c & 0xC0) == 0x80) continue;
+        size_t need = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        if (need > back) keep = back;
+        break;
+    }
+    _handler.text(_text, _text_len - keep);
+    memmove(_text, _text + _text_len - keep, keep);
+    _text_len = keep;
+}
+
+void MarkupScanner::flushText()
+{
+    if (_text_len > 0) {
+        _handler.text(_text, _text_len);
+        _text_len = 0;
+    }
+}
+
+void MarkupScanner::endTag()
+{
+    flushText();
+
+    const char* p = _tag.data();
+    size_t len    = _tag.size();
+    while (len > 0 && is_space(p[len - 1])) len--;
+    if (len == 0) return;
+
+    if (p[0] == '/') {
+        size_t start = 1;
+        size_t end   = start;
+        while (end < len && !is_space(p[end])) end++;
+        _handler.endTag(local_name(p + start, end - start));
+        return;
+    }
+
+    bool selfClosing = p[len - 1] == '/';
+    if (selfClosing) len--;
+    size_t nameEnd = 0;
+    while (nameEnd < len && !is_space(p[nameEnd]) && p[nameEnd] != '/') nameEnd++;
+    if (nameEnd == 0) return;
+
+    std::string attrs = nameEnd < len ? std::string(p + nameEnd, len - nameEnd) : std::string();
+    _handler.startTag(local_name(p, nameEnd), attrs, selfClosing);
+}
+
+void MarkupScanner::feed(const char* data, size_t len)
+{
+    size_t i = 0;
+    while (i < len) {
+        char c = data[i];
+        switch (_state) {
+            case State::Text: {
+                // 普通文本整段复制，不逐字节判断
+                size_t start = i;
+                while (i < len && data[i] != '<' && data[i] != '&') i++;
+                putText(data + start, i - start);
+                if (i == len) break;
+                if (data[i] == '<') {
+                    _state = State::TagStart;
+                    _quote = 0;
+                    _tag.clear();
+                } else {
+                    _state      = State::Entity;
+                    _entity_len = 0;
+                }
+                i++;
+                break;
+            }
+            case State::Entity:
+                if (c == ';') {
+                    uint32_t codepoint = decodeEntity(_entity, _entity_len);
+                    if (codepoint) {
+                        putCodepoint(codepoint);
+                    } else {
+                        putText("&", 1);
+                        putText(_entity, _entity_len);
+                        putText(";", 1);
+                    }
+                    _state = State::Text;
+                    i++;
+                } else if (_entity_len < sizeof(_entity) &&
+                           ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '#')) {
+                    _entity[_entity_len++] = c;
+                    i++;
+                } else {
+                    // 不是实体（如单独的 &），原样输出，当前字符按文本重新处理
+                    putText("&", 1);
+                    putText(_entity, _entity_len);
+                    _state = State::Text;
+                }
+                break;
+            case State::TagStart:
+                if (c == '!' || c == '?') {
+                    _state = State::Declaration;
+                    _tag.push_back(c);
+                    i++;
+                } else {
+                    _state = State::Tag;
+                }
+                break;
+            case State::Tag:
+                if (_quote) {
+                    if (c == _quote) _quote = 0;
+                } else if (c == '"' || c == '\'') {
+                    _quote = c;
+                } else if (c == '>') {
+                    endTag();
+                    _state = State::Text;
+                    i++;
+                    break;
+                }
+                if (_tag.size() < MAX_TAG_BYTES) _tag.push_back(c);
+                i++;
+                break;
+            case State::Declaration:
+                if (_tag.size() < 16) _tag.push_back(c);
+                if (_tag == "!--") {
+                    _state = State::Comment;
+                    _tail  = 0;
+                } else if (_tag == "![CDATA[") {
+                    _state = State::CData;
+                    _tail  = 0;
+                } else if (c == '>') {
+                    // <?xml ...?>、<!DOCTYPE ...> 等直接跳过
+                    _state = State::Text;
+                }
+                i++;
+                break;
+            case State::Comment:
+                _tail = ((_tail << 8) | (uint8_t)c) & 0xFFFFFF;
+                if (_tail == (('-' << 16) | ('-' << 8) | '>')) _state = State::Text;
+                i++;
+                break;
+            case State::CData:
+                if (c == ']') {
+                    _tail++;
+                } else if (c == '>' && _tail >= 2) {
+                    for (uint32_t k = 2; k < _tail; k++) putText("]", 1);
+                    _state = State::Text;
+                } else {
+                    for (uint32_t k = 0; k < _tail; k++) putText("]", 1);
+                    _tail = 0;
+                    putText(&c, 1);
+                }
+                i++;
+                break;
+        }
+    }
+}
+
+void MarkupScanner::finish()
+{
+    if (_state == State::Entity) {
+        putText("&", 1);
+        putText(_entity, _entity_len);
+    }
+    flushText();
+    _state = State::Text;
+}
+
+uint32_t MarkupScanner::decodeEntity(const char* name, size_t len)
+{
+    if (len == 0) return 0;
+
+    if (name[0] == '#') {
+        uint32_t codepoint = 0;
+        bool hex           = len > 1 && (name[1] == 'x' || name[1] == 'X');
+        size_t start       = hex ? 2 : 1;
+        if (start >= len) return 0;
+        for (size_t i = start; i < len; i++) {
+            char c    = name[i];
+            int digit = -1;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (hex && c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+            else if (hex && c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+            if (digit < 0) return 0;
+            codepoint = codepoint * (hex ? 16 : 10) + (uint32_t)digit;
+            if (codepoint > 0x10FFFF) return 0;
+        }
+        if (codepoint == 0 || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) return 0;
+        return codepoint;
+    }
+
+    for (const auto& entity : NAMED_ENTITIES) {
+        if (strlen(entity.name) == len && memcmp(entity.name, name, len) == 0) return entity.codepoint;
+    }
+    return 0;
+}
+
+bool MarkupScanner::attribute(const std::string& attrs, const char* key, std::string& value)
+{
+    const char* p   = attrs.data();
+    const char* end = p + attrs.size();
+
+    while (p < end) {
+        while (p < end && (is_space(*p) || *p == '/')) p++;
+        const char* nameStart = p;
+        while (p < end && !is_space(*p) && *p != '=' && *p != '/') p++;
+        std::string name = local_name(nameStart, (size_t)(p - nameStart));
+        while (p < end && is_space(*p)) p++;
+
+        const char* valueStart = p;
+        const char* valueEnd   = p;
+        if (p < end && *p == '=') {
+            p++;
+            while (p < end && is_space(*p)) p++;
+            if (p < end && (*p == '"' || *p == '\'')) {
+                char quote = *p++;
+                valueStart = p;
+                while (p < end && *p != quote) p++;
+                valueEnd = p;
+                if (p < end) p++;
+            } else {
+                valueStart = p;
+                while (p < end && !is_space(*p)) p++;
+                valueEnd = p;
+            }
+        }
+        if (name.empty() || name != key) continue;
+
+        // 属性值中的实体
+        value.clear();
+        for (const char* q = valueStart; q < valueEnd; q++) {
+            if (*q == '&') {
+                const char* semi = (const char*)memchr(q, ';', (size_t)(valueEnd - q));
+                if (semi && semi - q - 1 <= 10) {
+                    uint32_t codepoint = decodeEntity(q + 1, (size_t)(semi - q - 1));
+                    if (codepoint) {
+                        char utf8[4];
+                        value.append(utf8, encode_utf8(codepoint, utf8));
+                        q = semi;
+                        continue;
+                    }
+                }
+            }
+            value.push_back(*q);
+        }
+        return true;
+    }
+    return false;
+}
+
+}  // namespace book
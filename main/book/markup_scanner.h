@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace book {
+
+/**
+ * @brief 流式 XML / XHTML 扫描器，输入可以在任意字节处分段
+ *
+ * 只区分标签、文本、注释、CDATA 和声明，不建树、不校验嵌套，适合 EPUB 中的 container.xml、OPF 和正文 XHTML。
+ * 标签名转为小写并去掉命名空间前缀（dc:title → title）；文本中的实体已解码为 UTF-8，
+ * 输入为合法 UTF-8 时 text() 不会在字符中间分段。
+ * 内存固定：标签缓冲和文本缓冲都有上限，超长的标签只保留前 MAX_TAG_BYTES 字节。
+ */
+class MarkupScanner {
+public:
+    static constexpr size_t MAX_TAG_BYTES    = 2048;
+    static constexpr size_t TEXT_BUFFER_SIZE = 512;
+
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+
+        virtual void startTag(const std::string& name, const std::string& attrs, bool selfClosing) = 0;
+        virtual void endTag(const std::string& name)                                               = 0;
+        virtual void text(const char* data, size_t len)                                            = 0;
+    };
+
+    explicit MarkupScanner(Handler& handler);
+
+    void reset();
+    void feed(const char* data, size_t len);
+    /**
+     * @brief 输入结束，输出缓冲中剩余的文本
+     */
+    void finish();
+
+    /**
+     * @brief 从标签的属性部分取出 key（小写）的值，实体已解码；属性名不区分大小写，忽略命名空间前缀
+     */
+    static bool attribute(const std::string& attrs, const char* key, std::string& value);
+
+    /**
+     * @brief 解码实体 &amp; &#x4E2D; 等，name 不含 & 和 ;
+     * @return 码位，无法识别时返回 0
+     */
+    static uint32_t decodeEntity(const char* name, size_t len);
+
+private:
+    enum class State : uint8_t {
+        Text,
+        Entity,
+        TagStart,  // 刚读到 <
+        Tag,
+        Comment,
+        CData,
+        Declaration,
+    };
+
+    Handler& _handler;
+    State _state = State::Text;
+    std::string _tag;  // 当前标签（不含 < >）或声明，超出 MAX_TAG_BYTES 的部分丢弃
+    char _quote = 0;   // 标签内当前引号，0 表示不在引号内
+    char _entity[12];
+    size_t _entity_len = 0;
+    char _text[TEXT_BUFFER_SIZE];
+    size_t _text_len = 0;
+    uint32_t _tail   = 0;  // 注释中最近的 3 个字节 / CDATA 中连续的 ]，用于识别结束符
+
+    void putText(const char* data, size_t len);
+    void putCodepoint(uint32_t codepoint);
+    void flushText();
+    void flushFull();
+    void endTag();
+};
+
+}  // namespace book
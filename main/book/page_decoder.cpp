@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "page_decoder.h"
+#include "strip_file.h"
+#include "tile_page.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace book {
+
+static bool decode_banded(const uint8_t* data, size_t size, const GrayRowCallback& onRow)
+{
+    StripFileHeader header;
+    std::vector<StripEntry> entries;
+    if (!parse_strip_header(data, size, header) ||
+        !parse_strip_index(data + STRIP_FILE_HEADER_SIZE, size - STRIP_FILE_HEADER_SIZE, header, size, entries)) {
+        return false;
+    }
+
+    for (int band = 0; band < header.stripCount; band++) {
+        const int top  = band * header.stripHeight;
+        const int rows = std::min(header.stripHeight, header.height - top);
+        bool ok = decode_gray_png(data + entries[band].offset, entries[band].size,
+                                  [&](int y, const uint8_t* gray, int width) {
+                                      if (y >= rows || width != header.width) return false;
+                                      return onRow(top + y, gray, width);
+                                  });
+        if (!ok) return false;
+    }
+    return true;
+}
+
+static bool decode_tiled(const uint8_t* data, size_t size, const GrayRowCallback& onRow)
+{
+    TilePageView view;
+    if (!view.parse(data, size)) return false;
+
+    // 一次解码一行块，拼成 width × tileSize 的缓冲后逐行输出
+    const int tileSize = view.tileSize();
+    std::vector<uint8_t> rows((size_t)view.width() * tileSize);
+    std::vector<uint8_t> tile((size_t)tileSize * tileSize);
+
+    for (int row = 0; row < view.rows(); row++) {
+        int bandHeight = 0;
+        for (int col = 0; col < view.cols(); col++) {
+            int index = row * view.cols() + col;
+            int x, y, w, h;
+            view.tileRect(index, x, y, w, h);
+            if (!view.decodeTile(index, tile.data())) return false;
+            for (int ty = 0; ty < h; ty++) {
+                memcpy(rows.data() + (size_t)ty * view.width() + x, tile.data() + (size_t)ty * w, w);
+            }
+            bandHeight = h;
+        }
+        for (int ty = 0; ty < bandHeight; ty++) {
+            if (!onRow(row * tileSize + ty, rows.data() + (size_t)ty * view.width(), view.width())) return false;
+        }
+    }
+    return true;
+}
+
+bool decode_page_gray(const uint8_t* data, size_t size, const GrayRowCallback& onRow)
+{
+    if (!data || size < 4) return false;
+    if (memcmp(data, "PS3S", 4) == 0) return decode_banded(data, size, onRow);
+    if (memcmp(data, "PS3T", 4) == 0) return decode_tiled(data, size, onRow);
+    return decode_gray_png(data, size, onRow);
+}
+
+}  // namespace book
@@ -0,0 +1,22 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "gray_png.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace book {
+
+/**
+ * @brief 按文件头识别页面格式（灰度 PNG / .bnd 行带 / .tpg 分块），逐行输出 8-bit 灰度
+ *
+ * 供缩略图等需要顺序读取整页像素、又不关心存储格式的场合使用；绘制路径仍按格式各自优化。
+ * 内存占用：PNG 和行带为两行打包数据，分块为一行块（宽度 × 块边长）。
+ */
+bool decode_page_gray(const uint8_t* data, size_t size, const GrayRowCallback& onRow);
+
+}  // namespace book
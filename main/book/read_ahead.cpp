@@ -0,0 +1,206 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "read_ahead.h"
+#include <chrono>
+#include <cstdlib>
+
+#ifdef ESP_PLATFORM
+#include <mooncake_log.h>
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+namespace book {
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t elapsed_us(Clock::time_point start)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+#ifdef ESP_PLATFORM
+static constexpr int WORKER_STACK_SIZE = 1024 * 6;
+static constexpr int WORKER_PRIORITY   = 5;  // 与 HTTP 服务器相同，发送方阻塞在套接字上时轮到读卡
+static const char* TAG                 = "ReadAhead";
+#endif
+
+// 块缓冲放在 PSRAM，不够时退回默认堆
+static void* buffer_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    void* ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return ptr ? ptr : heap_caps_malloc(size, MALLOC_CAP_8BIT);
+#else
+    return ::malloc(size);
+#endif
+}
+
+static void buffer_free(void* ptr)
+{
+#ifdef ESP_PLATFORM
+    heap_caps_free(ptr);
+#else
+    ::free(ptr);
+#endif
+}
+
+ReadAhead::ReadAhead(Source source, size_t chunkSize, int chunks)
+    : _source(std::move(source)), _chunk_size(chunkSize), _chunks(chunks < 1 ? 1 : chunks)
+{
+}
+
+ReadAhead::~ReadAhead()
+{
+    stop();
+    buffer_free(_buffer);
+    delete[] _sizes;
+}
+
+bool ReadAhead::start()
+{
+    _buffer = (uint8_t*)buffer_alloc(_chunk_size * _chunks);
+    _sizes  = new size_t[_chunks]();
+    if (!_buffer) {
+        _chunks = 1;
+        _buffer = (uint8_t*)buffer_alloc(_chunk_size);
+        if (!_buffer) return false;
+    }
+    if (_chunks < 2) {
+        // 只有一块时不预读
+        _synchronous = true;
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _running = true;
+#ifdef ESP_PLATFORM
+    BaseType_t ok = xTaskCreate(
+        [](void* arg) {
+            workerLoop((ReadAhead*)arg);
+            vTaskDelete(NULL);
+        },
+        "read_ahead", WORKER_STACK_SIZE, this, WORKER_PRIORITY, NULL);
+    if (ok != pdPASS) {
+        mclog::tagError(TAG, "Failed to start read-ahead task");
+        _running     = false;
+        _synchronous = true;
+    }
+#else
+    _thread = std::thread(workerLoop, this);
+#endif
+    return true;
+}
+
+void ReadAhead::workerLoop(ReadAhead* self)
+{
+    self->produce();
+    std::lock_guard<std::mutex> lock(self->_mutex);
+    self->_running = false;
+    self->_cv.notify_all();
+}
+
+void ReadAhead::produce()
+{
+    int writeIndex = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_filled == _chunks && !_cancel) {
+                _stats.readerStalls++;
+                auto waitStart = Clock::now();
+                _cv.wait(lock, [this] { return _filled < _chunks || _cancel; });
+                _stats.readerStallUs += elapsed_us(waitStart);
+            }
+            if (_cancel) return;
+        }
+
+        // 读卡不持锁，发送方同时可以取走其它块
+        uint8_t* chunk  = _buffer + (size_t)writeIndex * _chunk_size;
+        auto readStart  = Clock::now();
+        size_t size     = _source(chunk, _chunk_size);
+        uint64_t readUs = elapsed_us(readStart);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.readUs += readUs;
+        if (size == 0) {
+            _eof = true;
+            _cv.notify_all();
+            return;
+        }
+        _sizes[writeIndex] = size;
+        _filled++;
+        _stats.bytes += size;
+        _stats.chunks++;
+        writeIndex = (writeIndex + 1) % _chunks;
+        _cv.notify_all();
+    }
+}
+
+bool ReadAhead::next(const uint8_t*& data, size_t& size)
+{
+    if (!_buffer) return false;
+    if (_synchronous) {
+        if (_eof || _cancel) return false;
+        auto readStart = Clock::now();
+        size           = _source(_buffer, _chunk_size);
+        _stats.readUs += elapsed_us(readStart);
+        if (size == 0) {
+            _eof = true;
+            return false;
+        }
+        _stats.bytes += size;
+        _stats.chunks++;
+        data = _buffer;
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_filled == 0 && !_eof && !_cancel) {
+        _stats.senderStalls++;
+        auto waitStart = Clock::now();
+        _cv.wait(lock, [this] { return _filled > 0 || _eof || _cancel; });
+        _stats.senderStallUs += elapsed_us(waitStart);
+    }
+    if (_filled == 0 || _cancel) return false;
+    data     = _buffer + (size_t)_read_index * _chunk_size;
+    size     = _sizes[_read_index];
+    _holding = true;
+    return true;
+}
+
+void ReadAhead::release()
+{
+    if (_synchronous) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_holding) return;
+    _holding    = false;
+    _filled--;
+    _read_index = (_read_index + 1) % _chunks;
+    _cv.notify_all();
+}
+
+void ReadAhead::stop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cancel = true;
+    _cv.notify_all();
+    // 读卡任务可能正在读一块，等它读完这一块后退出，之后才能释放缓冲和数据源
+    _cv.wait(lock, [this] { return !_running; });
+#ifndef ESP_PLATFORM
+    lock.unlock();
+    if (_thread.joinable()) _thread.join();
+#endif
+}
+
+ReadAheadStats ReadAhead::stats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+}  // namespace book
@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#ifndef ESP_PLATFORM
+#include <thread>
+#endif
+
+namespace book {
+
+/*
+ * 预读环形缓冲：读卡任务把数据源读进 chunks 个块，发送方取出已读好的块发送
+ *
+ * 读卡和发送交替进行时，一方等待另一方的时间都浪费掉；这里读卡任务在发送方等待套接字时继续读下一块，
+ * 总时间从 读卡 + 发送 接近 max(读卡, 发送)。两边各自等待的次数和时间记在 stats() 中：
+ * 读卡任务等得多说明发送（网络）是瓶颈，发送方等得多说明读卡是瓶颈。
+ */
+static constexpr size_t READ_AHEAD_CHUNK_SIZE = 32 * 1024;
+static constexpr int READ_AHEAD_CHUNKS        = 3;
+
+struct ReadAheadStats {
+    uint64_t bytes        = 0;
+    uint32_t chunks       = 0;
+    uint32_t readerStalls = 0;  // 缓冲全满，读卡任务等待发送方
+    uint32_t senderStalls = 0;  // 缓冲全空，发送方等待读卡任务
+    uint64_t readUs        = 0;  // 读数据源的总时间
+    uint64_t readerStallUs = 0;
+    uint64_t senderStallUs = 0;
+};
+
+class ReadAhead {
+public:
+    /**
+     * @brief 向 out 写入至多 capacity 字节，返回写入的字节数，0 表示结束
+     */
+    using Source = std::function<size_t(uint8_t* out, size_t capacity)>;
+
+    ReadAhead(Source source, size_t chunkSize = READ_AHEAD_CHUNK_SIZE, int chunks = READ_AHEAD_CHUNKS);
+    ~ReadAhead();
+    ReadAhead(const ReadAhead&)            = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    /**
+     * @brief 分配缓冲并启动读卡任务；内存不足或任务启动失败时退回单块缓冲，next() 在调用方线程中同步读取
+     * @return 连一块缓冲也分配不到时返回 false
+     */
+    bool start();
+
+    /**
+     * @brief 取下一块，数据在调用 release() 之前有效；没有更多数据时返回 false
+     */
+    bool next(const uint8_t*& data, size_t& size);
+    void release();
+
+    /**
+     * @brief 停止读卡任务并等待其退出（析构时自动调用）；之后 next() 返回 false
+     */
+    void stop();
+
+    ReadAheadStats stats();
+
+private:
+    Source _source;
+    size_t _chunk_size;
+    int _chunks;
+    uint8_t* _buffer = nullptr;
+    size_t* _sizes   = nullptr;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    int _filled       = 0;  // 已读好、未释放的块数
+    int _read_index   = 0;  // 发送方下一个取的块
+    bool _eof         = false;
+    bool _cancel      = false;
+    bool _running     = false;
+    bool _holding     = false;  // 发送方持有一块未释放
+    bool _synchronous = false;
+    ReadAheadStats _stats;
+#ifndef ESP_PLATFORM
+    std::thread _thread;
+#endif
+
+    void produce();
+    static void workerLoop(ReadAhead* self);
+};
+
+}  // namespace book
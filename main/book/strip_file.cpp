@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "strip_file.h"
+#include <cstring>
+
+namespace book {
+
+static inline uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+bool parse_strip_header(const uint8_t* data, size_t size, StripFileHeader& header)
+{
+    if (!data || size < STRIP_FILE_HEADER_SIZE || memcmp(data, "PS3S", 4) != 0) {
+        return false;
+    }
+    if (get_u16(data + 4) != STRIP_FILE_VERSION) {
+        return false;
+    }
+
+    header.stripHeight = get_u16(data + 6);
+    header.width       = get_u16(data + 8);
+    header.height      = (int)get_u32(data + 12);
+    header.stripCount  = (int)get_u32(data + 16);
+
+    if (header.stripHeight <= 0 || header.width <= 0 || header.height <= 0) return false;
+    // 条带数必须正好覆盖整幅长图
+    return header.stripCount == (header.height + header.stripHeight - 1) / header.stripHeight;
+}
+
+bool parse_strip_index(const uint8_t* data, size_t size, const StripFileHeader& header, size_t fileSize,
+                       std::vector<StripEntry>& entries)
+{
+    if (size < (size_t)header.stripCount * STRIP_FILE_ENTRY_SIZE) {
+        return false;
+    }
+
+    entries.resize(header.stripCount);
+    for (int i = 0; i < header.stripCount; i++) {
+        const uint8_t* p = data + (size_t)i * STRIP_FILE_ENTRY_SIZE;
+        entries[i].offset = get_u32(p);
+        entries[i].size   = get_u32(p + 4);
+        if ((uint64_t)entries[i].offset + entries[i].size > fileSize) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<uint8_t> build_strip_file(const StripFileHeader& header, const std::vector<std::vector<uint8_t>>& strips)
+{
+    size_t indexEnd = STRIP_FILE_HEADER_SIZE + strips.size() * STRIP_FILE_ENTRY_SIZE;
+    size_t total    = indexEnd;
+    for (const auto& strip : strips) {
+        total += strip.size();
+    }
+
+    std::vector<uint8_t> out(indexEnd, 0);
+    out.reserve(total);
+
+    memcpy(out.data(), "PS3S", 4);
+    put_u16(out.data() + 4, STRIP_FILE_VERSION);
+    put_u16(out.data() + 6, (uint16_t)header.stripHeight);
+    put_u16(out.data() + 8, (uint16_t)header.width);
+    put_u32(out.data() + 12, (uint32_t)header.height);
+    put_u32(out.data() + 16, (uint32_t)strips.size());
+
+    for (size_t i = 0; i < strips.size(); i++) {
+        uint8_t* entry = out.data() + STRIP_FILE_HEADER_SIZE + i * STRIP_FILE_ENTRY_SIZE;
+        put_u32(entry, (uint32_t)out.size());
+        put_u32(entry + 4, (uint32_t)strips[i].size());
+        out.insert(out.end(), strips[i].begin(), strips[i].end());
+    }
+    return out;
+}
+
+}  // namespace book
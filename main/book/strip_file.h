@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace book {
+
+/*
+ * 条带存储的章节文件：sections/{section}/strips.bin
+ *
+ * 章节长图（540 宽）按固定高度切成水平条带，每条带是一个独立的灰度 PNG，
+ * 相邻条带不重叠。文件头（小端）：
+ *
+ *   0   char[4]  "PS3S"
+ *   4   u16      版本（1）
+ *   6   u16      条带高度（最后一条可以更矮）
+ *   8   u16      宽度
+ *   10  u16      保留
+ *   12  u32      章节长图总高度
+ *   16  u32      条带数
+ *   20  u32      保留
+ *   24  条带数 × { u32 偏移（相对文件起始）, u32 字节数 }
+ *
+ * 之后依次存放各条带 PNG。
+ *
+ * 同一容器也用于按行带存储的单页 sections/{section}/{page}.bnd：高度为页面高度，
+ * 各行带互相独立，可以分给两个核心并行解码（见 band_decoder.h）。
+ */
+static constexpr uint32_t STRIP_FILE_VERSION     = 1;
+static constexpr size_t STRIP_FILE_HEADER_SIZE   = 24;
+static constexpr size_t STRIP_FILE_ENTRY_SIZE    = 8;
+static constexpr const char* STRIP_FILE_NAME     = "strips.bin";
+static constexpr const char* BAND_PAGE_EXTENSION = ".bnd";
+
+struct StripEntry {
+    uint32_t offset = 0;
+    uint32_t size   = 0;
+};
+
+struct StripFileHeader {
+    int stripHeight = 0;
+    int width       = 0;
+    int height      = 0;
+    int stripCount  = 0;
+};
+
+/**
+ * @brief 解析 24 字节文件头
+ */
+bool parse_strip_header(const uint8_t* data, size_t size, StripFileHeader& header);
+
+/**
+ * @brief 解析紧随文件头的条带索引，校验偏移不越界
+ */
+bool parse_strip_index(const uint8_t* data, size_t size, const StripFileHeader& header, size_t fileSize,
+                       std::vector<StripEntry>& entries);
+
+/**
+ * @brief 由各条带 PNG 拼出完整文件（主机端编译器使用）
+ */
+std::vector<uint8_t> build_strip_file(const StripFileHeader& header, const std::vector<std::vector<uint8_t>>& strips);
+
+}  // namespace book
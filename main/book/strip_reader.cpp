@@ -0,0 +1,143 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "strip_reader.h"
+#include <algorithm>
+#include <cstring>
+
+namespace book {
+
+StripReader::~StripReader()
+{
+    close();
+}
+
+bool StripReader::open(const std::string& path, int cacheStrips)
+{
+    close();
+
+    _file = fopen(path.c_str(), "rb");
+    if (!_file) {
+        return false;
+    }
+
+    fseek(_file, 0, SEEK_END);
+    size_t fileSize = (size_t)ftell(_file);
+    fseek(_file, 0, SEEK_SET);
+
+    uint8_t head[STRIP_FILE_HEADER_SIZE];
+    if (fread(head, 1, sizeof(head), _file) != sizeof(head) || !parse_strip_header(head, sizeof(head), _header)) {
+        close();
+        return false;
+    }
+
+    std::vector<uint8_t> index((size_t)_header.stripCount * STRIP_FILE_ENTRY_SIZE);
+    if (fread(index.data(), 1, index.size(), _file) != index.size() ||
+        !parse_strip_index(index.data(), index.size(), _header, fileSize, _entries)) {
+        close();
+        return false;
+    }
+
+    _path = path;
+    _cache.assign(cacheStrips > 0 ? cacheStrips : 1, CacheEntry());
+    _white_row.assign(_header.width, 0xFF);
+    return true;
+}
+
+void StripReader::close()
+{
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+    _path.clear();
+    _header = StripFileHeader();
+    _entries.clear();
+    _cache.clear();
+    _file_buffer.clear();
+    _file_buffer.shrink_to_fit();
+}
+
+const uint8_t* StripReader::getStrip(int strip)
+{
+    _clock++;
+
+    CacheEntry* victim = &_cache[0];
+    for (auto& entry : _cache) {
+        if (entry.strip == strip) {
+            entry.lastUse = _clock;
+            _hits++;
+            return entry.pixels.data();
+        }
+        if (entry.strip < 0 || (victim->strip >= 0 && entry.lastUse < victim->lastUse)) {
+            victim = &entry;
+        }
+    }
+
+    // 未命中：读取该条带 PNG 并解码到最久未用的缓存槽
+    const StripEntry& info = _entries[strip];
+    _file_buffer.resize(info.size);
+    if (fseek(_file, info.offset, SEEK_SET) != 0 || fread(_file_buffer.data(), 1, info.size, _file) != info.size) {
+        return nullptr;
+    }
+
+    int rows = std::min(_header.stripHeight, _header.height - strip * _header.stripHeight);
+    victim->strip = -1;
+    victim->pixels.resize((size_t)_header.width * rows);
+
+    bool ok = decode_gray_png(_file_buffer.data(), _file_buffer.size(), [&](int y, const uint8_t* gray, int width) {
+        if (y >= rows || width != _header.width) return false;
+        memcpy(victim->pixels.data() + (size_t)y * width, gray, width);
+        return true;
+    });
+    if (!ok) {
+        return nullptr;
+    }
+
+    victim->strip   = strip;
+    victim->lastUse = _clock;
+    _decoded++;
+    return victim->pixels.data();
+}
+
+bool StripReader::composeRows(int y, int rows, const GrayRowCallback& onRow)
+{
+    if (!_file) return false;
+
+    int row = 0;
+    while (row < rows) {
+        int srcY = y + row;
+        if (srcY < 0 || srcY >= _header.height) {
+            if (!onRow(row, _white_row.data(), _header.width)) return false;
+            row++;
+            continue;
+        }
+
+        int strip             = srcY / _header.stripHeight;
+        const uint8_t* pixels = getStrip(strip);
+        if (!pixels) return false;
+
+        int stripTop = strip * _header.stripHeight;
+        int stripEnd = std::min(stripTop + _header.stripHeight, _header.height);
+        for (int sy = srcY; sy < stripEnd && row < rows; sy++, row++) {
+            if (!onRow(row, pixels + (size_t)(sy - stripTop) * _header.width, _header.width)) return false;
+        }
+    }
+    return true;
+}
+
+bool StripReader::prefetch(int y, int rows)
+{
+    if (!_file) return false;
+
+    int first = std::max(0, y) / _header.stripHeight;
+    int last  = std::min(_header.height - 1, y + rows - 1) / _header.stripHeight;
+    for (int strip = first; strip <= last; strip++) {
+        if (!getStrip(strip)) return false;
+    }
+    return true;
+}
+
+}  // namespace book
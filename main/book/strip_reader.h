@@ -0,0 +1,97 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "gray_png.h"
+#include "strip_file.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace book {
+
+/**
+ * @brief 条带章节读取器：按任意纵向偏移拼出视口，只解码尚未缓存的条带
+ *
+ * 解码后的条带以 8-bit 灰度保存在 LRU 缓存中（540 × 100 约 53KB，设备端位于 PSRAM），
+ * 视口移动时已缓存的条带直接复用，只有新露出的条带需要读卡和 inflate。
+ */
+class StripReader {
+public:
+    StripReader() = default;
+    ~StripReader();
+    StripReader(const StripReader&)            = delete;
+    StripReader& operator=(const StripReader&) = delete;
+
+    /**
+     * @param cacheStrips 缓存的条带数，应覆盖一屏加上一次滚动的距离
+     */
+    bool open(const std::string& path, int cacheStrips);
+    void close();
+    bool isOpen() const
+    {
+        return _file != nullptr;
+    }
+    const std::string& path() const
+    {
+        return _path;
+    }
+
+    int width() const
+    {
+        return _header.width;
+    }
+    int height() const
+    {
+        return _header.height;
+    }
+    int stripHeight() const
+    {
+        return _header.stripHeight;
+    }
+
+    /**
+     * @brief 输出 [y, y + rows) 行，超出长图的部分输出白色
+     */
+    bool composeRows(int y, int rows, const GrayRowCallback& onRow);
+
+    /**
+     * @brief 预先解码 [y, y + rows) 覆盖的条带（不输出）
+     */
+    bool prefetch(int y, int rows);
+
+    // 统计：累计解码的条带数 / 缓存命中数
+    uint32_t stripsDecoded() const
+    {
+        return _decoded;
+    }
+    uint32_t cacheHits() const
+    {
+        return _hits;
+    }
+
+private:
+    struct CacheEntry {
+        int strip         = -1;
+        uint32_t lastUse  = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    FILE* _file = nullptr;
+    std::string _path;
+    StripFileHeader _header;
+    std::vector<StripEntry> _entries;
+    std::vector<CacheEntry> _cache;
+    std::vector<uint8_t> _file_buffer;  // 条带 PNG 读取缓冲，复用
+    std::vector<uint8_t> _white_row;
+    uint32_t _clock   = 0;
+    uint32_t _decoded = 0;
+    uint32_t _hits    = 0;
+
+    const uint8_t* getStrip(int strip);
+};
+
+}  // namespace book
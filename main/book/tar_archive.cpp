@@ -0,0 +1,243 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "tar_archive.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+namespace book {
+
+DirWalker::DirWalker(const std::string& root) : _root(root)
+{
+    while (_root.size() > 1 && _root.back() == '/') _root.pop_back();
+    DIR* dir = opendir(_root.c_str());
+    if (dir) _stack.emplace_back(dir, "");
+}
+
+DirWalker::~DirWalker()
+{
+    for (auto& level : _stack) closedir(level.first);
+}
+
+void DirWalker::skipChildren()
+{
+    _has_pending = false;
+}
+
+bool DirWalker::next(Entry& out)
+{
+    if (_has_pending) {
+        _has_pending = false;
+        DIR* dir     = opendir((_root + "/" + _pending).c_str());
+        if (dir) _stack.emplace_back(dir, _pending);
+    }
+
+    while (!_stack.empty()) {
+        struct dirent* entry = readdir(_stack.back().first);
+        if (!entry) {
+            closedir(_stack.back().first);
+            _stack.pop_back();
+            continue;
+        }
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+
+        const std::string& parent = _stack.back().second;
+        out.relative              = parent.empty() ? entry->d_name : parent + "/" + entry->d_name;
+        out.path                  = _root + "/" + out.relative;
+        struct stat st;
+        if (stat(out.path.c_str(), &st) != 0) continue;
+        out.dir   = S_ISDIR(st.st_mode);
+        out.size  = out.dir ? 0 : (uint64_t)st.st_size;
+        out.mtime = (int64_t)st.st_mtime;
+        if (out.dir) {
+            _pending     = out.relative;
+            _has_pending = true;
+        }
+        return true;
+    }
+    return false;
+}
+
+// 数字段：width - 1 位八进制数加一个 NUL；放不下时（文件不小于 8GB）按 GNU 扩展写成 base-256：
+// 首字节 0x80，其余字节为大端二进制，GNU tar、bsdtar、Python tarfile 都能读
+static void put_octal(char* field, size_t width, uint64_t value)
+{
+    char digits[24];
+    int length = snprintf(digits, sizeof(digits), "%" PRIo64, value);
+    if (length >= 0 && (size_t)length < width) {
+        memset(field, '0', width - 1 - length);
+        memcpy(field + width - 1 - length, digits, length);
+        field[width - 1] = 0;
+        return;
+    }
+    field[0] = (char)0x80;
+    for (size_t i = width - 1; i > 0; i--) {
+        field[i] = (char)(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+// 按 ustar 规则把名字拆成 prefix + "/" + name，拆不开时返回 false
+static bool split_ustar_name(const std::string& name, std::string& prefix, std::string& rest)
+{
+    if (name.size() <= 100) {
+        prefix.clear();
+        rest = name;
+        return true;
+    }
+    size_t slash = name.find('/', name.size() > 101 ? name.size() - 101 : 0);
+    while (slash != std::string::npos) {
+        if (slash <= 155 && name.size() - slash - 1 <= 100 && slash + 1 < name.size()) {
+            prefix = name.substr(0, slash);
+            rest   = name.substr(slash + 1);
+            return true;
+        }
+        if (slash > 155) break;
+        slash = name.find('/', slash + 1);
+    }
+    return false;
+}
+
+static void fill_header(uint8_t* block, const std::string& name, const std::string& prefix, char type,
+                        uint64_t size, int64_t mtime, uint32_t mode)
+{
+    memset(block, 0, TAR_BLOCK_SIZE);
+    char* h = (char*)block;
+    memcpy(h, name.data(), std::min<size_t>(name.size(), 100));
+    put_octal(h + 100, 8, mode);
+    put_octal(h + 108, 8, 0);
+    put_octal(h + 116, 8, 0);
+    put_octal(h + 124, 12, size);
+    put_octal(h + 136, 12, (uint64_t)std::max<int64_t>(mtime, 0));
+    h[156] = type;
+    memcpy(h + 257, "ustar", 6);
+    memcpy(h + 263, "00", 2);
+    memcpy(h + 345, prefix.data(), std::min<size_t>(prefix.size(), 155));
+
+    // 校验和按校验和字段全为空格计算
+    memset(h + 148, ' ', 8);
+    uint32_t sum = 0;
+    for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) sum += block[i];
+    put_octal(h + 148, 7, sum);
+    h[155] = ' ';
+}
+
+TarWriter::TarWriter(const std::string& root, const std::string& prefix, int64_t since, Filter filter)
+    : _walker(root), _prefix(prefix), _since(since), _filter(std::move(filter))
+{
+    while (!_prefix.empty() && _prefix.back() == '/') _prefix.pop_back();
+}
+
+TarWriter::~TarWriter()
+{
+    if (_file) fclose(_file);
+}
+
+void TarWriter::buildHeader(const DirWalker::Entry& entry, const std::string& name)
+{
+    std::string full = name + (entry.dir ? "/" : "");
+    std::string prefix, rest;
+    _header_size = 0;
+    _header_pos  = 0;
+    if (!split_ustar_name(full, prefix, rest)) {
+        // GNU 长文件名：类型 L 的条目，内容为以 NUL 结尾的完整名字（这里限制在一个块内）
+        size_t length = std::min<size_t>(full.size() + 1, TAR_BLOCK_SIZE);
+        fill_header(_header, "././@LongLink", "", 'L', length, 0, 0644);
+        memset(_header + TAR_BLOCK_SIZE, 0, TAR_BLOCK_SIZE);
+        memcpy(_header + TAR_BLOCK_SIZE, full.data(), length - 1);
+        _header_size = TAR_BLOCK_SIZE * 2;
+        prefix.clear();
+        rest = full.substr(0, 100);
+    }
+    fill_header(_header + _header_size, rest, prefix, entry.dir ? '5' : '0', entry.size, entry.mtime,
+                entry.dir ? 0755 : 0644);
+    _header_size += TAR_BLOCK_SIZE;
+}
+
+bool TarWriter::nextEntry()
+{
+    DirWalker::Entry entry;
+    while (_walker.next(entry)) {
+        if (_filter && !_filter(entry)) {
+            if (entry.dir) _walker.skipChildren();
+            _stats.skipped++;
+            continue;
+        }
+        std::string name = _prefix.empty() ? entry.relative : _prefix + "/" + entry.relative;
+        if (entry.dir) {
+            if (_since > 0) continue;
+            _stats.dirs++;
+            buildHeader(entry, name);
+            return true;
+        }
+        if (_since > 0 && entry.mtime < _since) {
+            _stats.skipped++;
+            continue;
+        }
+        // 先打开再写条目头，打不开的文件整条跳过
+        _file = fopen(entry.path.c_str(), "rb");
+        if (!_file) {
+            _stats.errors++;
+            continue;
+        }
+        _stats.files++;
+        _remaining = entry.size;
+        _short     = false;
+        _padding   = (TAR_BLOCK_SIZE - entry.size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+        buildHeader(entry, name);
+        return true;
+    }
+    return false;
+}
+
+size_t TarWriter::read(uint8_t* out, size_t capacity)
+{
+    size_t written = 0;
+    while (written < capacity) {
+        if (_header_pos < _header_size) {
+            size_t n = std::min(capacity - written, _header_size - _header_pos);
+            memcpy(out + written, _header + _header_pos, n);
+            _header_pos += n;
+            written += n;
+            continue;
+        }
+        if (_remaining > 0) {
+            size_t n = (size_t)std::min<uint64_t>(capacity - written, _remaining);
+            size_t got = _short ? 0 : fread(out + written, 1, n, _file);
+            if (got < n) {
+                if (!_short) _stats.errors++;
+                _short = true;
+                memset(out + written + got, 0, n - got);
+            }
+            _remaining -= n;
+            _stats.bytes += got;
+            written += n;
+            continue;
+        }
+        if (_file) {
+            if (!_short && fgetc(_file) != EOF) _stats.errors++;  // 读取期间文件变长
+            fclose(_file);
+            _file = nullptr;
+        }
+        if (_padding > 0) {
+            size_t n = std::min(capacity - written, _padding);
+            memset(out + written, 0, n);
+            _padding -= n;
+            written += n;
+            continue;
+        }
+        if (_finished) break;
+        if (!nextEntry()) {
+            // 结尾两个空块
+            _finished = true;
+            _padding  = TAR_BLOCK_SIZE * 2;
+        }
+    }
+    return written;
+}
+
+}  // namespace book
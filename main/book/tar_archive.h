@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <dirent.h>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace book {
+
+/**
+ * @brief 深度优先遍历目录树，目录先于其内容返回
+ *
+ * 只保存从根到当前目录这一条路径上打开的目录，内存与文件数无关。
+ */
+class DirWalker {
+public:
+    struct Entry {
+        std::string path;      // 完整路径
+        std::string relative;  // 相对根目录，不含开头的 /
+        bool dir      = false;
+        uint64_t size = 0;
+        int64_t mtime = 0;
+    };
+
+    explicit DirWalker(const std::string& root);
+    ~DirWalker();
+    DirWalker(const DirWalker&)            = delete;
+    DirWalker& operator=(const DirWalker&) = delete;
+
+    bool next(Entry& out);
+    /**
+     * @brief 不进入上一次 next() 返回的目录
+     */
+    void skipChildren();
+
+private:
+    std::string _root;
+    std::vector<std::pair<DIR*, std::string>> _stack;  // 打开的目录及其相对路径
+    std::string _pending;  // 上次返回的目录，下次 next() 时进入
+    bool _has_pending = false;
+};
+
+/*
+ * 把目录树编码为 POSIX ustar 流，按需拉取：read() 每次填满调用方的缓冲，文件内容直接读进缓冲，不经过中间拷贝
+ *
+ * 条目名为 prefix/相对路径；超过 ustar 的 prefix(155) + name(100) 时加一个 GNU 长文件名条目（././@LongLink），
+ * GNU tar、bsdtar、Python tarfile 都能解开。since 大于 0 时只输出修改时间不早于 since 的文件，
+ * 不输出目录条目（解包时自动创建父目录），用于增量备份。
+ * 读取过程中文件变短时补零、变长时截断，保证与条目头中的大小一致，计入 errors。
+ */
+static constexpr size_t TAR_BLOCK_SIZE = 512;
+
+struct TarStats {
+    uint32_t files   = 0;
+    uint32_t dirs    = 0;
+    uint32_t skipped = 0;  // 早于 since 或被过滤
+    uint32_t errors  = 0;  // 打不开或读取中大小变化
+    uint64_t bytes   = 0;  // 文件内容字节数
+};
+
+class TarWriter {
+public:
+    /**
+     * @brief 返回 false 时跳过该条目（目录连同其内容）
+     */
+    using Filter = std::function<bool(const DirWalker::Entry& entry)>;
+
+    TarWriter(const std::string& root, const std::string& prefix, int64_t since = 0, Filter filter = nullptr);
+    ~TarWriter();
+    TarWriter(const TarWriter&)            = delete;
+    TarWriter& operator=(const TarWriter&) = delete;
+
+    /**
+     * @brief 向 out 写入至多 capacity 字节，返回写入的字节数，0 表示结束
+     */
+    size_t read(uint8_t* out, size_t capacity);
+
+    const TarStats& stats() const
+    {
+        return _stats;
+    }
+
+private:
+    DirWalker _walker;
+    std::string _prefix;
+    int64_t _since;
+    Filter _filter;
+    TarStats _stats;
+
+    uint8_t _header[TAR_BLOCK_SIZE * 3];  // 长文件名条目 + 名字 + 条目头
+    size_t _header_size = 0;
+    size_t _header_pos  = 0;
+    FILE* _file         = nullptr;
+    uint64_t _remaining = 0;  // 当前文件还要输出的字节
+    bool _short         = false;  // 当前文件提前结束，剩余部分补零
+    size_t _padding     = 0;
+    bool _finished      = false;  // 已输出结尾的两个空块
+
+    bool nextEntry();
+    void buildHeader(const DirWalker::Entry& entry, const std::string& name);
+};
+
+}  // namespace book
@@ -0,0 +1,568 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "text_book.h"
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace book {
+
+#include "gbk_table.inc"
+
+static constexpr size_t DETECT_SAMPLE_SIZE = 64 * 1024;
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    编码                                    */
+/* -------------------------------------------------------------------------- */
+
+static size_t decode_utf8(const uint8_t* data, size_t size, uint32_t& cp)
+{
+    const uint8_t b = data[0];
+    if (b < 0x80) {
+        cp = b;
+        return 1;
+    }
+
+    size_t need;
+    uint32_t min;
+    if ((b & 0xE0) == 0xC0) {
+        need = 2;
+        min  = 0x80;
+        cp   = b & 0x1F;
+    } else if ((b & 0xF0) == 0xE0) {
+        need = 3;
+        min  = 0x800;
+        cp   = b & 0x0F;
+    } else if ((b & 0xF8) == 0xF0) {
+        need = 4;
+        min  = 0x10000;
+        cp   = b & 0x07;
+    } else {
+        cp = TEXT_REPLACEMENT_CHAR;
+        return 1;
+    }
+
+    for (size_t i = 1; i < need; i++) {
+        if (i >= size) return 0;
+        if ((data[i] & 0xC0) != 0x80) {
+            cp = TEXT_REPLACEMENT_CHAR;
+            return 1;
+        }
+        cp = (cp << 6) | (data[i] & 0x3F);
+    }
+    // 过长编码、代理区、超出 Unicode 范围
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        cp = TEXT_REPLACEMENT_CHAR;
+        return 1;
+    }
+    return need;
+}
+
+static size_t decode_gbk(const uint8_t* data, size_t size, uint32_t& cp)
+{
+    const uint8_t lead = data[0];
+    if (lead < 0x80) {
+        cp = lead;
+        return 1;
+    }
+    if (lead == 0x80 || lead == 0xFF) {
+        cp = TEXT_REPLACEMENT_CHAR;
+        return 1;
+    }
+    if (size < 2) return 0;
+
+    const uint8_t trail = data[1];
+    if (trail < 0x40 || trail == 0x7F || trail == 0xFF) {
+        cp = TEXT_REPLACEMENT_CHAR;
+        return 1;
+    }
+    uint16_t code = GBK_TO_UNICODE[(lead - 0x81) * 191 + (trail - 0x40)];
+    cp            = code ? code : TEXT_REPLACEMENT_CHAR;
+    return 2;
+}
+
+size_t decode_text_char(TextEncoding encoding, const uint8_t* data, size_t size, uint32_t& codepoint)
+{
+    if (size == 0) return 0;
+    return encoding == TextEncoding::Gbk ? decode_gbk(data, size, codepoint) : decode_utf8(data, size, codepoint);
+}
+
+TextEncoding detect_text_encoding(const uint8_t* data, size_t size, size_t& bomSize)
+{
+    bomSize = 0;
+    if (size >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF) {
+        bomSize = 3;
+        return TextEncoding::Utf8;
+    }
+
+    // 样本末尾截断的多字节字符不算错误
+    size_t pos = 0;
+    while (pos < size) {
+        uint32_t cp;
+        size_t n = decode_utf8(data + pos, size - pos, cp);
+        if (n == 0) break;
+        if (cp == TEXT_REPLACEMENT_CHAR && n == 1) return TextEncoding::Gbk;
+        pos += n;
+    }
+    return TextEncoding::Utf8;
+}
+
+size_t encode_utf8(uint32_t cp, char* out)
+{
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+uint32_t fold_search_char(uint32_t cp)
+{
+    // 全角 ASCII → 半角，全角空格按空白处理
+    if (cp >= 0xFF01 && cp <= 0xFF5E) cp -= 0xFEE0;
+    if (cp >= 'A' && cp <= 'Z') cp += 32;
+    if (cp == ' ' || cp == '\t' || cp == '\r' || cp == '\n' || cp == 0x3000 || cp == 0x00A0) return ' ';
+    if (cp < 0x20 || cp == TEXT_REPLACEMENT_CHAR) return 0;
+    return cp;
+}
+
+std::string text_to_utf8(TextEncoding encoding, const uint8_t* data, size_t size)
+{
+    std::string out;
+    out.reserve(size + size / 2);
+
+    size_t pos = 0;
+    char buf[4];
+    while (pos < size) {
+        uint32_t cp;
+        size_t n = decode_text_char(encoding, data + pos, size - pos, cp);
+        if (n == 0) {
+            cp = TEXT_REPLACEMENT_CHAR;
+            n  = 1;
+        }
+        pos += n;
+        if (cp == '\r' || cp == '\n') continue;
+        if (cp == '\t') cp = ' ';
+        out.append(buf, encode_utf8(cp, buf));
+    }
+    return out;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 GlyphWidths                                */
+/* -------------------------------------------------------------------------- */
+
+GlyphWidths::GlyphWidths(MeasureFn measure) : _measure(std::move(measure))
+{
+}
+
+GlyphWidths::~GlyphWidths()
+{
+    free(_table);
+}
+
+int GlyphWidths::width(uint32_t codepoint)
+{
+    if (codepoint > 0xFFFF) return _measure(codepoint);
+
+    if (!_table) {
+        _table = (uint8_t*)calloc(0x10000, 1);
+        if (!_table) return _measure(codepoint);
+    }
+    uint8_t cached = _table[codepoint];
+    if (cached) return cached - 1;
+
+    int w             = std::max(0, std::min(254, _measure(codepoint)));
+    _table[codepoint] = (uint8_t)(w + 1);
+    return w;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    断行                                    */
+/* -------------------------------------------------------------------------- */
+
+// 避头标点：不能出现在行首，行满时悬挂在行尾
+static bool is_no_line_start(uint32_t cp)
+{
+    switch (cp) {
+        case 0x3001:  // 、
+        case 0x3002:  // 。
+        case 0x3009:  // 〉
+        case 0x300B:  // 》
+        case 0x300D:  // 」
+        case 0x300F:  // 』
+        case 0x3011:  // 】
+        case 0x3015:  // 〕
+        case 0x2019:  // ’
+        case 0x201D:  // ”
+        case 0x2026:  // …
+        case 0xFF01:  // ！
+        case 0xFF09:  // ）
+        case 0xFF0C:  // ，
+        case 0xFF0E:  // ．
+        case 0xFF1A:  // ：
+        case 0xFF1B:  // ；
+        case 0xFF1F:  // ？
+            return true;
+        default:
+            return false;
+    }
+}
+
+TextLineBreaker::TextLineBreaker(GlyphWidths& widths, int lineWidth) : _widths(widths), _line_width(lineWidth)
+{
+}
+
+void TextLineBreaker::reset(uint32_t offset)
+{
+    _start       = offset;
+    _pos         = offset;
+    _width       = 0;
+    _break       = NO_BREAK;
+    _break_end   = 0;
+    _width_after = 0;
+    _hanging     = false;
+}
+
+bool TextLineBreaker::push(uint32_t cp, uint32_t offset, uint32_t size, TextLine& line)
+{
+    _pos = offset + size;
+
+    if (cp == '\n') {
+        line = {_start, offset};
+        reset(offset + size);
+        return true;
+    }
+    if (cp == '\r') return false;
+
+    const bool space = cp == ' ' || cp == '\t';
+    const bool word  = !space && cp > 0x20 && cp < 0x2E80;  // 拉丁字母、数字和西文标点，按单词整体换行
+    const int w      = _widths.width(space ? ' ' : cp);
+
+    const bool tooLong = offset + size - _start > TEXT_MAX_LINE_BYTES;
+    if (offset > _start && (tooLong || _width + w > _line_width)) {
+        // 行尾悬挂一个空格或避头标点
+        if (!tooLong && !_hanging && (space || is_no_line_start(cp))) {
+            _hanging     = true;
+            _break       = offset + size;
+            _break_end   = space ? offset : offset + size;
+            _width_after = 0;
+            if (!space) _width += w;
+            return false;
+        }
+
+        // 单词整体移到下一行
+        if (word && !tooLong && _break != NO_BREAK && _break > _start) {
+            line         = {_start, _break_end};
+            _start       = _break;
+            _width       = _width_after + w;
+            _width_after = _width;
+            _break       = NO_BREAK;
+            _hanging     = false;
+            return true;
+        }
+
+        // 在当前字符前断开；行首的空格丢弃
+        line     = {_start, offset};
+        _start   = space ? offset + size : offset;
+        _width   = space ? 0 : w;
+        _hanging = false;
+        if (word) {
+            _break       = NO_BREAK;
+            _width_after = w;
+        } else {
+            _break       = offset + size;
+            _break_end   = offset + size;
+            _width_after = 0;
+        }
+        return true;
+    }
+
+    _width += w;
+    if (space) {
+        _break       = offset + size;
+        _break_end   = offset;
+        _width_after = 0;
+    } else if (word) {
+        _width_after += w;
+    } else {
+        // 中日文字符之后都可以断开
+        _break       = offset + size;
+        _break_end   = offset + size;
+        _width_after = 0;
+    }
+    return false;
+}
+
+bool TextLineBreaker::finish(TextLine& line)
+{
+    if (_pos <= _start) return false;
+    line = {_start, _pos};
+    reset(_pos);
+    return true;
+}
+
+uint32_t TextLayoutParams::key() const
+{
+    uint32_t h = 2166136261u;
+    for (uint32_t v : {(uint32_t)lineWidth, (uint32_t)linesPerPage, fontId, (uint32_t)TEXT_MAX_LINE_BYTES}) {
+        for (int i = 0; i < 4; i++) {
+            h ^= (v >> (i * 8)) & 0xFF;
+            h *= 16777619u;
+        }
+    }
+    return h;
+}
+
+void layout_text_page(TextEncoding encoding, const uint8_t* data, size_t size, uint32_t pageStart, bool atEof,
+                      GlyphWidths& widths, const TextLayoutParams& params, std::vector<TextLine>& lines,
+                      uint32_t& nextPage)
+{
+    lines.clear();
+    TextLineBreaker breaker(widths, params.lineWidth);
+    breaker.reset(pageStart);
+
+    TextLine line;
+    size_t pos = 0;
+    while (pos < size) {
+        uint32_t cp;
+        size_t n = decode_text_char(encoding, data + pos, size - pos, cp);
+        if (n == 0) {
+            if (!atEof) break;
+            cp = TEXT_REPLACEMENT_CHAR;
+            n  = 1;
+        }
+        if (breaker.push(cp, pageStart + (uint32_t)pos, (uint32_t)n, line)) {
+            lines.push_back(line);
+            if ((int)lines.size() == params.linesPerPage) {
+                nextPage = breaker.lineStart();
+                return;
+            }
+        }
+        pos += n;
+    }
+
+    if (atEof && breaker.finish(line)) {
+        lines.push_back(line);
+    }
+    nextPage = atEof ? pageStart + (uint32_t)size : breaker.lineStart();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                TextPaginator                               */
+/* -------------------------------------------------------------------------- */
+
+TextPaginator::TextPaginator(GlyphWidths::MeasureFn measure) : _widths(std::move(measure)), _breaker(_widths, 0)
+{
+}
+
+TextPaginator::~TextPaginator()
+{
+    end();
+}
+
+bool TextPaginator::begin(const std::string& textPath, const TextLayoutParams& params)
+{
+    end();
+    _params   = params;
+    _complete = false;
+    _pages.clear();
+    _error.clear();
+    _breaker.setLineWidth(params.lineWidth);
+
+    _text = fopen(textPath.c_str(), "rb");
+    if (!_text) {
+        _error = "Failed to open " + textPath;
+        return false;
+    }
+    fseek(_text, 0, SEEK_END);
+    _file_size = (uint32_t)ftell(_text);
+    fseek(_text, 0, SEEK_SET);
+
+    _buffer.resize(std::min<size_t>(_file_size, DETECT_SAMPLE_SIZE));
+    size_t bomSize = 0;
+    if (fread(_buffer.data(), 1, _buffer.size(), _text) != _buffer.size()) {
+        _error = "Failed to read " + textPath;
+        end();
+        return false;
+    }
+    _encoding = detect_text_encoding(_buffer.data(), _buffer.size(), bomSize);
+
+    if (!openIndex(textPath + TEXT_INDEX_SUFFIX)) {
+        // 重新分页：第一页从 BOM 之后开始
+        _pages.assign(1, (uint32_t)bomSize);
+        _saved = 0;
+        if (!saveIndex()) {
+            end();
+            return false;
+        }
+    }
+
+    // 从最后一个页首继续（完成时不再处理）
+    _pos   = _pages.back();
+    _lines = 0;
+    _breaker.reset(_pos);
+    return true;
+}
+
+void TextPaginator::end()
+{
+    if (_text) {
+        fclose(_text);
+        _text = nullptr;
+    }
+    if (_index) {
+        fclose(_index);
+        _index = nullptr;
+    }
+    _buffer.clear();
+    _buffer.shrink_to_fit();
+}
+
+bool TextPaginator::openIndex(const std::string& indexPath)
+{
+    _index = fopen(indexPath.c_str(), "r+b");
+    if (_index) {
+        uint8_t head[TEXT_INDEX_HEADER_SIZE];
+        if (fread(head, 1, sizeof(head), _index) == sizeof(head) && memcmp(head, "PS3X", 4) == 0 &&
+            (head[4] | (head[5] << 8)) == TEXT_INDEX_VERSION && head[6] == (uint8_t)_encoding &&
+            get_u32(head + 8) == _file_size && get_u32(head + 12) == _params.key()) {
+            uint32_t count = get_u32(head + 16);
+            std::vector<uint8_t> raw((size_t)count * 4);
+            if (count > 0 && fread(raw.data(), 1, raw.size(), _index) == raw.size()) {
+                _pages.resize(count);
+                bool ordered = true;
+                for (uint32_t i = 0; i < count; i++) {
+                    _pages[i] = get_u32(raw.data() + i * 4);
+                    if (_pages[i] > _file_size || (i > 0 && _pages[i] <= _pages[i - 1])) ordered = false;
+                }
+                if (ordered) {
+                    _saved    = count;
+                    _complete = head[7] != 0;
+                    return true;
+                }
+                _pages.clear();
+            }
+        }
+        fclose(_index);
+    }
+
+    _index = fopen(indexPath.c_str(), "w+b");
+    if (!_index) {
+        _error = "Failed to create " + indexPath;
+    }
+    return false;
+}
+
+bool TextPaginator::saveIndex()
+{
+    if (!_index) return false;
+
+    _saved = std::min(_saved, _pages.size());
+    if (_pages.size() > _saved) {
+        std::vector<uint8_t> raw((_pages.size() - _saved) * 4);
+        for (size_t i = _saved; i < _pages.size(); i++) {
+            put_u32(raw.data() + (i - _saved) * 4, _pages[i]);
+        }
+        if (fseek(_index, (long)(TEXT_INDEX_HEADER_SIZE + _saved * 4), SEEK_SET) != 0 ||
+            fwrite(raw.data(), 1, raw.size(), _index) != raw.size()) {
+            _error = "Failed to write page index";
+            return false;
+        }
+        _saved = _pages.size();
+    }
+
+    // 先追加页首再更新文件头中的页数；读取时还会检查页首递增且不超过文件长度
+    uint8_t head[TEXT_INDEX_HEADER_SIZE] = {'P', 'S', '3', 'X'};
+    head[4]                              = (uint8_t)TEXT_INDEX_VERSION;
+    head[6]                              = (uint8_t)_encoding;
+    head[7]                              = _complete ? 1 : 0;
+    put_u32(head + 8, _file_size);
+    put_u32(head + 12, _params.key());
+    put_u32(head + 16, (uint32_t)_pages.size());
+    if (fseek(_index, 0, SEEK_SET) != 0 || fwrite(head, 1, sizeof(head), _index) != sizeof(head)) {
+        _error = "Failed to write page index";
+        return false;
+    }
+    fflush(_index);
+    fsync(fileno(_index));
+    return true;
+}
+
+bool TextPaginator::step(size_t maxBytes)
+{
+    if (_complete || !_text || !_index) return false;
+
+    const size_t want = std::min<size_t>(maxBytes, _file_size - _pos);
+    const bool atEof  = _pos + want >= _file_size;
+    _buffer.resize(want);
+    if (fseek(_text, (long)_pos, SEEK_SET) != 0 || fread(_buffer.data(), 1, want, _text) != want) {
+        _error = "Failed to read text";
+        return false;
+    }
+
+    TextLine line;
+    size_t pos = 0;
+    while (pos < want) {
+        uint32_t cp;
+        size_t n = decode_text_char(_encoding, _buffer.data() + pos, want - pos, cp);
+        if (n == 0) {
+            // 多字节字符被本段截断，下次从它开始读
+            if (!atEof) break;
+            cp = TEXT_REPLACEMENT_CHAR;
+            n  = 1;
+        }
+        if (_breaker.push(cp, _pos + (uint32_t)pos, (uint32_t)n, line) && ++_lines == _params.linesPerPage) {
+            _pages.push_back(_breaker.lineStart());
+            _lines = 0;
+        }
+        pos += n;
+    }
+    _pos += (uint32_t)pos;
+
+    if (atEof && _pos >= _file_size) {
+        if (_breaker.finish(line)) _lines++;
+        // 最后一页恰好排满时，末尾多出的页首没有内容
+        if (_lines == 0 && _pages.size() > 1 && _pages.back() >= _file_size) {
+            _pages.pop_back();
+        }
+        _complete = true;
+    }
+
+    if (!saveIndex()) return false;
+    return !_complete;
+}
+
+}  // namespace book
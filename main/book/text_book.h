@@ -0,0 +1,249 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace book {
+
+/*
+ * 纯文本（.txt）书籍：设备端直接排版，不需要预先栅格化
+ *
+ * 分页结果保存在同目录的 {name}.txt.idx（小端）：
+ *
+ *   0   char[4]  "PS3X"
+ *   4   u16      版本（1）
+ *   6   u8       编码（0 = UTF-8，1 = GBK）
+ *   7   u8       分页是否完成
+ *   8   u32      文本文件长度
+ *   12  u32      排版参数键（字体、行宽、每页行数），与当前参数不一致时重新分页
+ *   16  u32      页数 N
+ *   20  u32[N]   各页首字节在文本文件中的偏移
+ *
+ * 页首总在行首，从任一页首开始排版的结果只取决于其后的文本，分页中断后从最后一个页首继续，
+ * 阅读器也可以从当前页首自行排出下一页，不必等待分页到达。
+ */
+static constexpr uint32_t TEXT_INDEX_VERSION     = 1;
+static constexpr size_t TEXT_INDEX_HEADER_SIZE   = 20;
+static constexpr const char* TEXT_INDEX_SUFFIX   = ".idx";
+static constexpr const char* TEXT_STATUS_SUFFIX  = ".status.json";
+static constexpr size_t TEXT_MAX_LINE_BYTES      = 256;  // 单行字节数上限，超过时强制换行
+static constexpr uint32_t TEXT_REPLACEMENT_CHAR  = 0xFFFD;
+
+enum class TextEncoding : uint8_t {
+    Utf8 = 0,
+    Gbk  = 1,
+};
+
+/**
+ * @brief 按开头的样本判断编码：有 UTF-8 BOM 或样本是合法 UTF-8 时为 UTF-8，否则按 GBK 处理
+ * @param bomSize 输出 BOM 长度（正文从这里开始）
+ */
+TextEncoding detect_text_encoding(const uint8_t* data, size_t size, size_t& bomSize);
+
+/**
+ * @brief 解码一个字符
+ * @return 消耗的字节数；数据不完整（需要更多输入）时返回 0。非法字节按 1 字节 U+FFFD 处理
+ */
+size_t decode_text_char(TextEncoding encoding, const uint8_t* data, size_t size, uint32_t& codepoint);
+
+/**
+ * @brief 编码为 UTF-8，返回写入的字节数（1-4）
+ */
+size_t encode_utf8(uint32_t codepoint, char* out);
+
+/**
+ * @brief 检索用的字符归一化：全角 ASCII 转半角，字母转小写
+ * @return 空白字符返回 ' '，控制字符和 U+FFFD 返回 0（跳过），其余返回归一化后的字符
+ */
+uint32_t fold_search_char(uint32_t codepoint);
+
+/**
+ * @brief 把一段文本转换为 UTF-8，跳过 \r、\n，制表符替换为空格
+ */
+std::string text_to_utf8(TextEncoding encoding, const uint8_t* data, size_t size);
+
+/**
+ * @brief 字符宽度缓存
+ *
+ * 测量函数（设备端为字体的 x_advance）只在每个 BMP 字符第一次出现时调用，之后查 64KB 表。
+ * 每个线程使用自己的实例。
+ */
+class GlyphWidths {
+public:
+    using MeasureFn = std::function<int(uint32_t codepoint)>;
+
+    explicit GlyphWidths(MeasureFn measure);
+    ~GlyphWidths();
+    GlyphWidths(const GlyphWidths&)            = delete;
+    GlyphWidths& operator=(const GlyphWidths&) = delete;
+
+    int width(uint32_t codepoint);
+
+private:
+    MeasureFn _measure;
+    uint8_t* _table = nullptr;  // 宽度 + 1，0 表示尚未测量
+};
+
+/**
+ * @brief 一行在文本文件中的字节范围 [start, end)，不含行尾换行符
+ */
+struct TextLine {
+    uint32_t start = 0;
+    uint32_t end   = 0;
+};
+
+/**
+ * @brief 逐字符断行
+ *
+ * 中日文字符之间可以断开；拉丁字母组成的单词整体换行，在空格处断开；行尾的空格和避头标点（，。）」等）
+ * 允许悬挂到行宽之外一个字符，不放到下一行行首。\n 强制换行，\r 忽略。
+ */
+class TextLineBreaker {
+public:
+    TextLineBreaker(GlyphWidths& widths, int lineWidth);
+
+    /**
+     * @brief 从 offset 处开始新的一行（必须是行首）
+     */
+    void reset(uint32_t offset);
+
+    /**
+     * @brief 输入位于 offset、长 size 字节的字符
+     * @return 有一行结束时返回 true 并填写 line，此时 lineStart() 为下一行的起点
+     */
+    bool push(uint32_t codepoint, uint32_t offset, uint32_t size, TextLine& line);
+
+    /**
+     * @brief 文本结束，输出最后一行（非空时）
+     */
+    bool finish(TextLine& line);
+
+    void setLineWidth(int lineWidth)
+    {
+        _line_width = lineWidth;
+    }
+    uint32_t lineStart() const
+    {
+        return _start;
+    }
+
+private:
+    static constexpr uint32_t NO_BREAK = UINT32_MAX;
+
+    GlyphWidths& _widths;
+    int _line_width;
+    uint32_t _start     = 0;         // 当前行起点
+    uint32_t _pos       = 0;         // 已输入文本的末尾
+    int _width          = 0;         // 当前行已占宽度
+    uint32_t _break     = NO_BREAK;  // 最近的断行点：下一行从这里开始
+    uint32_t _break_end = 0;         // 在断行点断开时本行的结束位置
+    int _width_after    = 0;         // 断行点之后的宽度（整体移到下一行的部分）
+    bool _hanging       = false;     // 本行已有一个悬挂字符
+};
+
+/**
+ * @brief 排版参数，key() 写入索引文件，任一项变化都需要重新分页
+ */
+struct TextLayoutParams {
+    int lineWidth    = 492;
+    int linesPerPage = 23;
+    uint32_t fontId  = 0;
+
+    uint32_t key() const;
+};
+
+/**
+ * @brief 从页首排出一页
+ * @param data 从 pageStart 开始的文本，至少 linesPerPage × TEXT_MAX_LINE_BYTES + 8 字节（文件末尾除外）
+ * @param atEof data 是否到达文件末尾
+ * @param nextPage 输出下一页页首；atEof 且已排完时等于 pageStart + size
+ */
+void layout_text_page(TextEncoding encoding, const uint8_t* data, size_t size, uint32_t pageStart, bool atEof,
+                      GlyphWidths& widths, const TextLayoutParams& params, std::vector<TextLine>& lines,
+                      uint32_t& nextPage);
+
+/**
+ * @brief 一页排版需要读取的最大字节数
+ */
+inline size_t text_page_window(const TextLayoutParams& params)
+{
+    return (size_t)params.linesPerPage * TEXT_MAX_LINE_BYTES + 8;
+}
+
+/**
+ * @brief 增量分页：每次 step() 处理一段文本，新的页首追加到索引文件，中断后从最后一个页首继续
+ */
+class TextPaginator {
+public:
+    explicit TextPaginator(GlyphWidths::MeasureFn measure);
+    ~TextPaginator();
+    TextPaginator(const TextPaginator&)            = delete;
+    TextPaginator& operator=(const TextPaginator&) = delete;
+
+    /**
+     * @brief 打开文本和索引；索引与文本长度、排版参数一致时沿用，否则重新分页
+     */
+    bool begin(const std::string& textPath, const TextLayoutParams& params);
+    void end();
+
+    /**
+     * @brief 处理至多 maxBytes 字节的文本
+     * @return 分页完成或出错时返回 false
+     */
+    bool step(size_t maxBytes = 32 * 1024);
+
+    bool done() const
+    {
+        return _complete;
+    }
+    TextEncoding encoding() const
+    {
+        return _encoding;
+    }
+    uint32_t fileSize() const
+    {
+        return _file_size;
+    }
+    uint32_t processed() const
+    {
+        return _pos;
+    }
+    const std::vector<uint32_t>& pages() const
+    {
+        return _pages;
+    }
+    const std::string& lastError() const
+    {
+        return _error;
+    }
+
+private:
+    GlyphWidths _widths;
+    TextLineBreaker _breaker;
+    TextLayoutParams _params;
+    FILE* _text            = nullptr;
+    FILE* _index           = nullptr;
+    TextEncoding _encoding = TextEncoding::Utf8;
+    uint32_t _file_size    = 0;
+    uint32_t _pos          = 0;  // 下一次读取的位置
+    int _lines             = 0;  // 当前页已排的行数
+    bool _complete         = false;
+    size_t _saved          = 0;  // 已写入索引文件的页数
+    std::vector<uint32_t> _pages;
+    std::vector<uint8_t> _buffer;
+    std::string _error;
+
+    bool openIndex(const std::string& indexPath);
+    bool saveIndex();
+};
+
+}  // namespace book
@@ -0,0 +1,180 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "text_layer.h"
+#include <cstdio>
+#include <cstring>
+
+namespace book {
+
+static inline uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+std::vector<uint8_t> build_text_layer(const std::vector<std::vector<TextLayerLine>>& pages)
+{
+    size_t lineCount = 0;
+    size_t textSize  = 0;
+    for (const auto& page : pages) {
+        lineCount += page.size();
+        for (const auto& line : page) textSize += line.text.size();
+    }
+
+    size_t linesStart = TEXT_LAYER_HEADER_SIZE + (pages.size() + 1) * 4;
+    size_t textStart  = linesStart + lineCount * TEXT_LAYER_LINE_SIZE;
+    std::vector<uint8_t> out(textStart + textSize);
+
+    memcpy(out.data(), "PS3T", 4);
+    put_u16(out.data() + 4, TEXT_LAYER_VERSION);
+    put_u16(out.data() + 6, (uint16_t)pages.size());
+    put_u32(out.data() + 8, (uint32_t)lineCount);
+    put_u32(out.data() + 12, (uint32_t)textSize);
+
+    size_t line   = 0;
+    size_t offset = 0;
+    for (size_t p = 0; p < pages.size(); p++) {
+        put_u32(out.data() + TEXT_LAYER_HEADER_SIZE + p * 4, (uint32_t)line);
+        for (const auto& item : pages[p]) {
+            uint8_t* entry = out.data() + linesStart + line * TEXT_LAYER_LINE_SIZE;
+            put_u32(entry, (uint32_t)offset);
+            put_u16(entry + 4, (uint16_t)(int16_t)item.box.x);
+            put_u16(entry + 6, (uint16_t)(int16_t)item.box.y);
+            put_u16(entry + 8, (uint16_t)item.box.w);
+            put_u16(entry + 10, (uint16_t)item.box.h);
+            memcpy(out.data() + textStart + offset, item.text.data(), item.text.size());
+            offset += item.text.size();
+            line++;
+        }
+    }
+    put_u32(out.data() + TEXT_LAYER_HEADER_SIZE + pages.size() * 4, (uint32_t)line);
+    return out;
+}
+
+bool TextLayer::load(const std::string& path)
+{
+    clear();
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    std::vector<uint8_t> data(size > 0 ? (size_t)size : 0);
+    bool ok = size > 0 && fread(data.data(), 1, data.size(), f) == data.size();
+    fclose(f);
+    return ok && parse(std::move(data));
+}
+
+bool TextLayer::parse(std::vector<uint8_t> data)
+{
+    clear();
+    if (data.size() < TEXT_LAYER_HEADER_SIZE || memcmp(data.data(), "PS3T", 4) != 0 ||
+        get_u16(data.data() + 4) != TEXT_LAYER_VERSION) {
+        return false;
+    }
+    int pages         = get_u16(data.data() + 6);
+    size_t lines      = get_u32(data.data() + 8);
+    uint32_t textSize = get_u32(data.data() + 12);
+
+    uint64_t linesStart = TEXT_LAYER_HEADER_SIZE + ((uint64_t)pages + 1) * 4;
+    uint64_t textStart  = linesStart + (uint64_t)lines * TEXT_LAYER_LINE_SIZE;
+    if (textStart + textSize != data.size()) return false;
+
+    // 各页首行序号递增且以 L 结尾，各行起点递增且不越界
+    const uint8_t* firstLines = data.data() + TEXT_LAYER_HEADER_SIZE;
+    uint32_t previous         = 0;
+    for (int p = 0; p <= pages; p++) {
+        uint32_t first = get_u32(firstLines + p * 4);
+        if (first < previous || first > lines || (p == 0 && first != 0)) return false;
+        previous = first;
+    }
+    if (previous != lines) return false;
+    previous = 0;
+    for (size_t i = 0; i < lines; i++) {
+        uint32_t offset = get_u32(data.data() + linesStart + i * TEXT_LAYER_LINE_SIZE);
+        if (offset < previous || offset > textSize) return false;
+        previous = offset;
+    }
+
+    _data        = std::move(data);
+    _page_count  = pages;
+    _line_count  = lines;
+    _text_size   = textSize;
+    _first_lines = _data.data() + TEXT_LAYER_HEADER_SIZE;
+    _lines       = _data.data() + linesStart;
+    _text        = (const char*)_data.data() + textStart;
+    return true;
+}
+
+void TextLayer::clear()
+{
+    _data.clear();
+    _page_count  = 0;
+    _line_count  = 0;
+    _text_size   = 0;
+    _first_lines = nullptr;
+    _lines       = nullptr;
+    _text        = nullptr;
+}
+
+void TextLayer::pageLines(int page, size_t& begin, size_t& end) const
+{
+    if (page < 1 || page > _page_count) {
+        begin = end = 0;
+        return;
+    }
+    begin = get_u32(_first_lines + (page - 1) * 4);
+    end   = get_u32(_first_lines + page * 4);
+}
+
+TextBox TextLayer::lineBox(size_t line) const
+{
+    TextBox box;
+    if (line >= _line_count) return box;
+    const uint8_t* entry = _lines + line * TEXT_LAYER_LINE_SIZE;
+    box.x                = (int16_t)get_u16(entry + 4);
+    box.y                = (int16_t)get_u16(entry + 6);
+    box.w                = get_u16(entry + 8);
+    box.h                = get_u16(entry + 10);
+    return box;
+}
+
+const char* TextLayer::lineText(size_t line, size_t& bytes) const
+{
+    if (line >= _line_count) {
+        bytes = 0;
+        return "";
+    }
+    uint32_t start = lineOffset(line);
+    uint32_t end   = line + 1 < _line_count ? lineOffset(line + 1) : _text_size;
+    bytes          = end - start;
+    return _text + start;
+}
+
+uint32_t TextLayer::lineOffset(size_t line) const
+{
+    return line < _line_count ? get_u32(_lines + line * TEXT_LAYER_LINE_SIZE) : _text_size;
+}
+
+}  // namespace book
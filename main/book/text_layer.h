@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace book {
+
+/*
+ * 章节文字层：sections/{section}/text.bin（可选，由主机端编译器根据章节元数据的 lines 生成）
+ *
+ * 页面是栅格化的图片，文字层记录每页各行的文字和行框（页面内坐标，540 × 900），
+ * 供设备端建立全文索引和在页面上标出检索命中。文件格式（小端）：
+ *
+ *   0   char[4]  "PS3T"
+ *   4   u16      版本（1）
+ *   6   u16      页数 P
+ *   8   u32      行数 L
+ *   12  u32      正文字节数 T
+ *   16  u32[P+1] 各页第一行的序号，最后一项为 L
+ *       L × { u32 文字起点（相对正文区）, i16 x, i16 y, u16 宽, u16 高 }
+ *       T 字节   UTF-8 正文，各行首尾相接；第 i 行为 [起点 i, 起点 i+1)
+ *
+ * 整个文件一次读入后直接在缓冲上访问，一章通常只有几十 KB。
+ */
+static constexpr uint32_t TEXT_LAYER_VERSION      = 1;
+static constexpr size_t TEXT_LAYER_HEADER_SIZE    = 16;
+static constexpr size_t TEXT_LAYER_LINE_SIZE      = 12;
+static constexpr const char* TEXT_LAYER_FILE_NAME = "text.bin";
+
+struct TextBox {
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+};
+
+struct TextLayerLine {
+    std::string text;
+    TextBox box;
+};
+
+/**
+ * @brief 由各页的行拼出 text.bin（主机端编译器使用）
+ * @param pages 第 N 项为第 N + 1 页
+ */
+std::vector<uint8_t> build_text_layer(const std::vector<std::vector<TextLayerLine>>& pages);
+
+class TextLayer {
+public:
+    bool load(const std::string& path);
+    /**
+     * @brief 解析整个文件，校验各表不越界
+     */
+    bool parse(std::vector<uint8_t> data);
+    void clear();
+
+    int pageCount() const
+    {
+        return _page_count;
+    }
+    /**
+     * @brief 第 page 页（从 1 开始）的行序号范围 [begin, end)
+     */
+    void pageLines(int page, size_t& begin, size_t& end) const;
+    TextBox lineBox(size_t line) const;
+    /**
+     * @return 行文字（UTF-8，不以 0 结尾），长度写入 bytes
+     */
+    const char* lineText(size_t line, size_t& bytes) const;
+    /**
+     * @brief 行文字在正文区中的起点，同一章内唯一，用于定位检索命中
+     */
+    uint32_t lineOffset(size_t line) const;
+
+private:
+    std::vector<uint8_t> _data;
+    int _page_count     = 0;
+    size_t _line_count  = 0;
+    uint32_t _text_size = 0;
+    const uint8_t* _first_lines = nullptr;
+    const uint8_t* _lines       = nullptr;
+    const char* _text           = nullptr;
+};
+
+}  // namespace book
@@ -0,0 +1,320 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "thumb_atlas.h"
+#include "page_decoder.h"
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+namespace book {
+
+static constexpr int SCALE_X = THUMB_PAGE_WIDTH / THUMB_WIDTH;
+static constexpr int SCALE_Y = THUMB_PAGE_HEIGHT / THUMB_HEIGHT;
+
+static inline uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void build_header(uint8_t* out, int pageCount)
+{
+    memset(out, 0, THUMB_ATLAS_HEADER_SIZE);
+    memcpy(out, "PS3A", 4);
+    out[4]  = (uint8_t)THUMB_ATLAS_VERSION;
+    out[6]  = THUMB_WIDTH;
+    out[7]  = THUMB_HEIGHT;
+    out[8]  = THUMB_BIT_DEPTH;
+    out[12] = (uint8_t)pageCount;
+    out[13] = (uint8_t)(pageCount >> 8);
+    out[14] = (uint8_t)(pageCount >> 16);
+    out[15] = (uint8_t)(pageCount >> 24);
+}
+
+static bool parse_header(const uint8_t* data, int& pageCount)
+{
+    if (memcmp(data, "PS3A", 4) != 0 || get_u16(data + 4) != THUMB_ATLAS_VERSION) return false;
+    if (data[6] != THUMB_WIDTH || data[7] != THUMB_HEIGHT || data[8] != THUMB_BIT_DEPTH) return false;
+    pageCount = (int)get_u32(data + 12);
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 ThumbScaler                                */
+/* -------------------------------------------------------------------------- */
+
+ThumbScaler::ThumbScaler() : _sums(THUMB_WIDTH * THUMB_HEIGHT, 0)
+{
+}
+
+void ThumbScaler::pushRow(const uint8_t* gray, int width)
+{
+    if (_rows >= THUMB_PAGE_HEIGHT) return;
+
+    uint32_t* dst = _sums.data() + (_rows / SCALE_Y) * THUMB_WIDTH;
+    int count     = std::min(width, THUMB_PAGE_WIDTH);
+    for (int x = 0; x < count; x++) {
+        dst[x / SCALE_X] += gray[x];
+    }
+    // 窄于 540 的页面右侧按白色计算
+    for (int x = count; x < THUMB_PAGE_WIDTH; x++) {
+        dst[x / SCALE_X] += 255;
+    }
+    _rows++;
+}
+
+void ThumbScaler::finish(uint8_t* packed)
+{
+    // 不足 900 行的部分按白色补齐
+    while (_rows < THUMB_PAGE_HEIGHT) {
+        uint32_t* dst = _sums.data() + (_rows / SCALE_Y) * THUMB_WIDTH;
+        for (int x = 0; x < THUMB_WIDTH; x++) dst[x] += 255 * SCALE_X;
+        _rows++;
+    }
+
+    const uint32_t area = SCALE_X * SCALE_Y;
+    memset(packed, 0, THUMB_BYTES);
+    for (int y = 0; y < THUMB_HEIGHT; y++) {
+        uint8_t* row = packed + y * THUMB_ROW_BYTES;
+        for (int x = 0; x < THUMB_WIDTH; x++) {
+            uint32_t avg = (_sums[y * THUMB_WIDTH + x] + area / 2) / area;
+            uint8_t v    = (uint8_t)((avg * 15 + 127) / 255);
+            row[x >> 1] |= (x & 1) ? v : (uint8_t)(v << 4);
+        }
+    }
+    std::fill(_sums.begin(), _sums.end(), 0);
+    _rows = 0;
+}
+
+void expand_thumb(const uint8_t* packed, int scale, uint8_t* gray)
+{
+    const int width = THUMB_WIDTH * scale;
+    for (int y = 0; y < THUMB_HEIGHT; y++) {
+        const uint8_t* src = packed + y * THUMB_ROW_BYTES;
+        uint8_t* dst       = gray + (size_t)y * scale * width;
+        for (int x = 0; x < THUMB_WIDTH; x++) {
+            uint8_t v = (uint8_t)(((x & 1) ? (src[x >> 1] & 0x0F) : (src[x >> 1] >> 4)) * 0x11);
+            memset(dst + x * scale, v, scale);
+        }
+        for (int r = 1; r < scale; r++) {
+            memcpy(dst + (size_t)r * width, dst, width);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              ThumbAtlasBuilder                             */
+/* -------------------------------------------------------------------------- */
+
+ThumbAtlasBuilder::~ThumbAtlasBuilder()
+{
+    end();
+}
+
+bool ThumbAtlasBuilder::begin(const ThumbSource& source)
+{
+    end();
+    _source = source;
+    _next   = 0;
+    _error.clear();
+
+    const std::string path = _source.bookDir + "/" + THUMB_ATLAS_FILE_NAME;
+    const int total        = (int)_source.pages.size();
+
+    // 已有图集且页数一致：从已生成的张数继续，末尾不完整的一张会被覆盖
+    _file = fopen(path.c_str(), "r+b");
+    if (_file) {
+        uint8_t head[THUMB_ATLAS_HEADER_SIZE];
+        int pageCount = -1;
+        fseek(_file, 0, SEEK_END);
+        long fileSize = ftell(_file);
+        fseek(_file, 0, SEEK_SET);
+        if (fread(head, 1, sizeof(head), _file) == sizeof(head) && parse_header(head, pageCount) &&
+            pageCount == total) {
+            _next = (int)std::min<long>(total, (fileSize - (long)THUMB_ATLAS_HEADER_SIZE) / (long)THUMB_BYTES);
+            return true;
+        }
+        fclose(_file);
+        _file = nullptr;
+    }
+
+    _file = fopen(path.c_str(), "w+b");
+    if (!_file) {
+        _error = "Failed to create " + path;
+        return false;
+    }
+    uint8_t head[THUMB_ATLAS_HEADER_SIZE];
+    build_header(head, total);
+    if (fwrite(head, 1, sizeof(head), _file) != sizeof(head)) {
+        _error = "Failed to write " + path;
+        end();
+        return false;
+    }
+    return true;
+}
+
+void ThumbAtlasBuilder::end()
+{
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+    _strip_reader.close();
+    _strip_section = -1;
+    _page_buffer.clear();
+    _page_buffer.shrink_to_fit();
+}
+
+bool ThumbAtlasBuilder::renderPage(const ThumbPageRef& ref, ThumbScaler& scaler)
+{
+    char name[64];
+    auto onRow = [&](int y, const uint8_t* gray, int width) {
+        scaler.pushRow(gray, width);
+        return true;
+    };
+
+    if (_source.strips) {
+        if (_strip_section != ref.section) {
+            snprintf(name, sizeof(name), "/sections/%03d/%s", ref.section, STRIP_FILE_NAME);
+            // 只需顺序读一屏，缓存一屏所含的条带即可
+            if (!_strip_reader.open(_source.bookDir + name, 1)) return false;
+            _strip_section = ref.section;
+        }
+        return _strip_reader.composeRows((ref.page - 1) * THUMB_PAGE_HEIGHT, THUMB_PAGE_HEIGHT, onRow);
+    }
+
+    snprintf(name, sizeof(name), "/sections/%03d/%03d%s", ref.section, ref.page, _source.pageExtension.c_str());
+    FILE* f = fopen((_source.bookDir + name).c_str(), "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    _page_buffer.resize(size > 0 ? (size_t)size : 0);
+    bool ok = size > 0 && fread(_page_buffer.data(), 1, _page_buffer.size(), f) == _page_buffer.size();
+    fclose(f);
+
+    return ok && decode_page_gray(_page_buffer.data(), _page_buffer.size(), onRow);
+}
+
+bool ThumbAtlasBuilder::step()
+{
+    if (!_file || done()) return false;
+
+    const ThumbPageRef& ref = _source.pages[_next];
+    ThumbScaler scaler;
+    uint8_t packed[THUMB_BYTES];
+    if (!renderPage(ref, scaler)) {
+        // 单页损坏不影响其余页面，缩略图留白
+        scaler = ThumbScaler();
+    }
+    scaler.finish(packed);
+
+    long offset = (long)THUMB_ATLAS_HEADER_SIZE + (long)_next * (long)THUMB_BYTES;
+    if (fseek(_file, offset, SEEK_SET) != 0 || fwrite(packed, 1, THUMB_BYTES, _file) != THUMB_BYTES) {
+        _error = "Failed to write thumbnail " + std::to_string(_next);
+        return false;
+    }
+    // 同步目录项，阅读器重新打开文件时才能看到新的长度
+    fflush(_file);
+    fsync(fileno(_file));
+    _next++;
+    return !done();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              ThumbAtlasReader                              */
+/* -------------------------------------------------------------------------- */
+
+ThumbAtlasReader::~ThumbAtlasReader()
+{
+    close();
+}
+
+bool ThumbAtlasReader::open(const std::string& path, int cacheSize)
+{
+    close();
+
+    _file = fopen(path.c_str(), "rb");
+    if (!_file) return false;
+
+    uint8_t head[THUMB_ATLAS_HEADER_SIZE];
+    if (fread(head, 1, sizeof(head), _file) != sizeof(head) || !parse_header(head, _page_count)) {
+        close();
+        return false;
+    }
+
+    _path = path;
+    _cache.assign(std::max(1, cacheSize), CacheEntry());
+    updateAvailable();
+    return true;
+}
+
+void ThumbAtlasReader::close()
+{
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+    _path.clear();
+    _page_count = 0;
+    _available  = 0;
+    _cache.clear();
+}
+
+void ThumbAtlasReader::refresh()
+{
+    // 已打开的句柄看不到其他句柄追加的长度，重新打开；缓存的缩略图内容不变，保留
+    if (!_file) return;
+    fclose(_file);
+    _file = fopen(_path.c_str(), "rb");
+    if (!_file) {
+        _available = 0;
+        return;
+    }
+    updateAvailable();
+}
+
+void ThumbAtlasReader::updateAvailable()
+{
+    fseek(_file, 0, SEEK_END);
+    long fileSize = ftell(_file);
+    _available    = (int)std::min<long>(_page_count,
+                                        std::max<long>(0, fileSize - (long)THUMB_ATLAS_HEADER_SIZE) / (long)THUMB_BYTES);
+}
+
+const uint8_t* ThumbAtlasReader::thumb(int index)
+{
+    if (!_file || index < 0 || index >= _available) return nullptr;
+
+    _clock++;
+    CacheEntry* victim = &_cache[0];
+    for (auto& entry : _cache) {
+        if (entry.index == index) {
+            entry.lastUse = _clock;
+            _hits++;
+            return entry.data;
+        }
+        if (entry.index < 0 || (victim->index >= 0 && entry.lastUse < victim->lastUse)) {
+            victim = &entry;
+        }
+    }
+
+    long offset   = (long)THUMB_ATLAS_HEADER_SIZE + (long)index * (long)THUMB_BYTES;
+    victim->index = -1;
+    if (fseek(_file, offset, SEEK_SET) != 0 || fread(victim->data, 1, THUMB_BYTES, _file) != THUMB_BYTES) {
+        return nullptr;
+    }
+    victim->index   = index;
+    victim->lastUse = _clock;
+    _reads++;
+    return victim->data;
+}
+
+}  // namespace book
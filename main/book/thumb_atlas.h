@@ -0,0 +1,206 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "strip_reader.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace book {
+
+/*
+ * 缩略图集：books/{id}/thumbs.bin，全书每页一张缩略图，供拖动进度条时预览
+ *
+ * 缩略图为页面内容区（540 × 900）按 10 × 10 取平均缩小到 54 × 90，4-bit 灰度不压缩，
+ * 每张 27 × 90 = 2430 字节，第 N 页（全书页序，从 0 开始）位于 头 + N × 2430，可以直接定位。
+ * 文件头（小端）：
+ *
+ *   0   char[4]  "PS3A"
+ *   4   u16      版本（1）
+ *   6   u8       缩略图宽度
+ *   7   u8       缩略图高度
+ *   8   u8       位深（4）
+ *   9   u8       保留
+ *   10  u16      保留
+ *   12  u32      全书页数
+ *
+ * 后台任务按页序追加，文件长度即进度：已生成的张数 = (文件长度 - 16) / 2430，中断后从这里继续。
+ */
+static constexpr uint32_t THUMB_ATLAS_VERSION      = 1;
+static constexpr size_t THUMB_ATLAS_HEADER_SIZE    = 16;
+static constexpr int THUMB_WIDTH                   = 54;
+static constexpr int THUMB_HEIGHT                  = 90;
+static constexpr int THUMB_BIT_DEPTH               = 4;
+static constexpr size_t THUMB_ROW_BYTES            = (THUMB_WIDTH * THUMB_BIT_DEPTH + 7) / 8;
+static constexpr size_t THUMB_BYTES                = THUMB_ROW_BYTES * THUMB_HEIGHT;
+static constexpr int THUMB_PAGE_WIDTH              = 540;
+static constexpr int THUMB_PAGE_HEIGHT             = 900;
+static constexpr const char* THUMB_ATLAS_FILE_NAME = "thumbs.bin";
+
+/**
+ * @brief 逐行输入页面，按面积平均缩小并打包为 4-bit
+ *
+ * 页面不足 THUMB_PAGE_HEIGHT 的部分按白色计算。
+ */
+class ThumbScaler {
+public:
+    ThumbScaler();
+
+    void pushRow(const uint8_t* gray, int width);
+    /**
+     * @param packed 至少 THUMB_BYTES 字节
+     */
+    void finish(uint8_t* packed);
+
+private:
+    std::vector<uint32_t> _sums;  // THUMB_WIDTH × THUMB_HEIGHT 个累加值
+    int _rows = 0;
+};
+
+/**
+ * @brief 4-bit 缩略图展开为 8-bit 灰度并按整数倍放大
+ * @param gray 至少 (THUMB_WIDTH × scale) × (THUMB_HEIGHT × scale) 字节
+ */
+void expand_thumb(const uint8_t* packed, int scale, uint8_t* gray);
+
+/**
+ * @brief 缩略图页序对应的页面来源
+ */
+struct ThumbPageRef {
+    int section = 0;
+    int page    = 1;  // 从 1 开始；条带布局时为第几屏
+};
+
+/**
+ * @brief 生成缩略图集所需的书籍信息（与设备端 / 主机端的 metadata 解析方式无关）
+ */
+struct ThumbSource {
+    std::string bookDir;        // books/{id}
+    std::string pageExtension;  // ".png" / ".tpg" / ".bnd"
+    bool strips = false;        // 条带布局：每页为章节长图中第 page 屏（y = (page - 1) × 900）
+    std::vector<ThumbPageRef> pages;
+};
+
+/**
+ * @brief 增量生成缩略图集，每次 step() 处理一页，便于后台任务在页与页之间让出 CPU 和检查取消
+ */
+class ThumbAtlasBuilder {
+public:
+    ThumbAtlasBuilder() = default;
+    ~ThumbAtlasBuilder();
+    ThumbAtlasBuilder(const ThumbAtlasBuilder&)            = delete;
+    ThumbAtlasBuilder& operator=(const ThumbAtlasBuilder&) = delete;
+
+    /**
+     * @brief 打开或新建图集；页数与现有文件不一致时重新生成
+     */
+    bool begin(const ThumbSource& source);
+    void end();
+
+    /**
+     * @brief 生成下一页
+     * @return 已全部完成或出错时返回 false
+     */
+    bool step();
+
+    bool done() const
+    {
+        return _next >= (int)_source.pages.size();
+    }
+    int generated() const
+    {
+        return _next;
+    }
+    int total() const
+    {
+        return (int)_source.pages.size();
+    }
+    const std::string& lastError() const
+    {
+        return _error;
+    }
+
+private:
+    ThumbSource _source;
+    FILE* _file = nullptr;
+    int _next   = 0;
+    std::string _error;
+    std::vector<uint8_t> _page_buffer;  // 页面文件读取缓冲，复用
+    StripReader _strip_reader;
+    int _strip_section = -1;
+
+    bool renderPage(const ThumbPageRef& ref, ThumbScaler& scaler);
+};
+
+/**
+ * @brief 只读访问缩略图集，带固定容量的 LRU 缓存
+ *
+ * 拖动进度条时同一区间会被反复请求，缓存命中不读卡；未命中时只读取一张 2430 字节。
+ */
+class ThumbAtlasReader {
+public:
+    ThumbAtlasReader() = default;
+    ~ThumbAtlasReader();
+    ThumbAtlasReader(const ThumbAtlasReader&)            = delete;
+    ThumbAtlasReader& operator=(const ThumbAtlasReader&) = delete;
+
+    bool open(const std::string& path, int cacheSize);
+    void close();
+    bool isOpen() const
+    {
+        return _file != nullptr;
+    }
+
+    int pageCount() const
+    {
+        return _page_count;
+    }
+    /**
+     * @brief 已生成的张数（后台任务仍在追加时调用 refresh() 更新）
+     */
+    int available() const
+    {
+        return _available;
+    }
+    void refresh();
+
+    /**
+     * @return 4-bit 打包数据，尚未生成或读取失败时返回 nullptr；指针在下一次调用前有效
+     */
+    const uint8_t* thumb(int index);
+
+    uint32_t reads() const
+    {
+        return _reads;
+    }
+    uint32_t cacheHits() const
+    {
+        return _hits;
+    }
+
+private:
+    struct CacheEntry {
+        int index        = -1;
+        uint32_t lastUse = 0;
+        uint8_t data[THUMB_BYTES];
+    };
+
+    FILE* _file = nullptr;
+    std::string _path;
+    int _page_count = 0;
+    int _available  = 0;
+    std::vector<CacheEntry> _cache;
+    uint32_t _clock = 0;
+    uint32_t _reads = 0;
+    uint32_t _hits  = 0;
+
+    void updateAvailable();
+};
+
+}  // namespace book
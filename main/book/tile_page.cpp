@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "tile_page.h"
+#include "gray_png.h"
+#include <algorithm>
+#include <cstring>
+
+namespace book {
+
+static inline uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint32_t tile_hash(const uint8_t* data, size_t size)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    if (h == TILE_HASH_BLANK) return 1;
+    if (h == TILE_HASH_INVALID) return TILE_HASH_INVALID - 1;
+    return h;
+}
+
+bool TilePageView::parse(const uint8_t* data, size_t size)
+{
+    if (parseLayout(data, size)) {
+        _data = data;
+        _size = size;
+        return true;
+    }
+    _data     = nullptr;
+    _size     = 0;
+    _cols     = 0;
+    _rows     = 0;
+    _occupied = 0;
+    _entries.clear();
+    return false;
+}
+
+bool TilePageView::parseLayout(const uint8_t* data, size_t size)
+{
+    _entries.clear();
+    _occupied = 0;
+
+    if (!data || size < TILE_PAGE_HEADER_SIZE || memcmp(data, "PS3T", 4) != 0) {
+        return false;
+    }
+    if (get_u16(data + 4) != TILE_PAGE_VERSION) {
+        return false;
+    }
+
+    _tile_size = data[6];
+    _bit_depth = data[7];
+    _width     = get_u16(data + 8);
+    _height    = get_u16(data + 10);
+    _cols      = get_u16(data + 12);
+    _rows      = get_u16(data + 14);
+
+    if (_tile_size == 0 || _width == 0 || _height == 0) return false;
+    if (_bit_depth != 1 && _bit_depth != 2 && _bit_depth != 4 && _bit_depth != 8) return false;
+    if (_cols != (_width + _tile_size - 1) / _tile_size || _rows != (_height + _tile_size - 1) / _tile_size) {
+        return false;
+    }
+
+    const int count     = _cols * _rows;
+    const size_t bitmap = ((size_t)count + 7) / 8;
+    if (size < TILE_PAGE_HEADER_SIZE + bitmap) return false;
+
+    const uint8_t* bits = data + TILE_PAGE_HEADER_SIZE;
+    for (int i = 0; i < count; i++) {
+        if (bits[i >> 3] & (1 << (i & 7))) _occupied++;
+    }
+
+    size_t pos = TILE_PAGE_HEADER_SIZE + bitmap;
+    if (size < pos + (size_t)_occupied * TILE_PAGE_ENTRY_SIZE) return false;
+
+    // 块数据紧跟在块表之后，偏移按顺序累加
+    size_t offset = pos + (size_t)_occupied * TILE_PAGE_ENTRY_SIZE;
+    _entries.assign(count, Entry());
+    for (int i = 0; i < count; i++) {
+        if (!(bits[i >> 3] & (1 << (i & 7)))) continue;
+        Entry& entry = _entries[i];
+        entry.hash   = get_u32(data + pos);
+        entry.size   = get_u16(data + pos + 4);
+        entry.offset = (uint32_t)offset;
+        pos += TILE_PAGE_ENTRY_SIZE;
+        offset += entry.size;
+        if (entry.size == 0 || offset > size) return false;
+    }
+    return true;
+}
+
+void TilePageView::tileRect(int tile, int& x, int& y, int& w, int& h) const
+{
+    x = (tile % _cols) * _tile_size;
+    y = (tile / _cols) * _tile_size;
+    w = std::min(_tile_size, _width - x);
+    h = std::min(_tile_size, _height - y);
+}
+
+bool TilePageView::decodeTile(int tile, uint8_t* gray)
+{
+    if (!_data || tile < 0 || tile >= tileCount()) return false;
+
+    int x, y, w, h;
+    tileRect(tile, x, y, w, h);
+
+    const Entry& entry = _entries[tile];
+    if (entry.size == 0) {
+        memset(gray, 0xFF, (size_t)w * h);
+        return true;
+    }
+
+    const size_t rowBytes = ((size_t)w * _bit_depth + 7) / 8;
+    _packed.resize(rowBytes * h);
+
+    if (!_inflater.begin(Inflater::Format::Raw)) return false;
+    _inflater.setInput(_data + entry.offset, entry.size);
+
+    size_t filled = 0;
+    while (filled < _packed.size()) {
+        size_t produced         = 0;
+        Inflater::Status status = _inflater.read(_packed.data() + filled, _packed.size() - filled, produced);
+        filled += produced;
+        if (status == Inflater::Status::Error) return false;
+        if (status != Inflater::Status::Ok && filled < _packed.size()) return false;
+    }
+
+    for (int row = 0; row < h; row++) {
+        expand_gray_row(_packed.data() + row * rowBytes, w, _bit_depth, gray + (size_t)row * w);
+    }
+    return true;
+}
+
+}  // namespace book
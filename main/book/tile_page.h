@@ -0,0 +1,137 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "inflater.h"
+
+namespace book {
+
+/*
+ * 分块页面：sections/{section}/{page}.tpg
+ *
+ * 页面切成固定大小的方块（默认 60 × 60，540 × 900 即 9 × 15 块），全白块既不存储也不解码。
+ * 文件布局（小端）：
+ *
+ *   0   char[4]  "PS3T"
+ *   4   u16      版本（1）
+ *   6   u8       块边长
+ *   7   u8       位深（1 / 2 / 4 / 8）
+ *   8   u16      宽度
+ *   10  u16      高度
+ *   12  u16      列数
+ *   14  u16      行数
+ *   16  占用位图，ceil(列 × 行 / 8) 字节，第 i 块对应字节 i / 8 的第 i % 8 位（置 1 表示非空白）
+ *   ..  每个非空白块 { u32 内容哈希, u16 压缩字节数 }
+ *   ..  各非空白块的裸 deflate 数据，按块序号排列
+ *
+ * 块内像素按行打包（高位在前，每行按字节对齐），各块独立压缩，可单独解码。
+ * 内容哈希为打包数据的 FNV-1a，阅读器用它判断与上一页相同的块，跳过解码和推送。
+ */
+static constexpr uint32_t TILE_PAGE_VERSION      = 1;
+static constexpr size_t TILE_PAGE_HEADER_SIZE    = 16;
+static constexpr size_t TILE_PAGE_ENTRY_SIZE     = 6;
+static constexpr uint32_t TILE_HASH_BLANK        = 0;           // 空白块的哈希
+static constexpr uint32_t TILE_HASH_INVALID      = 0xFFFFFFFF;  // 保留：阅读器标记屏幕上被覆盖的块
+static constexpr const char* TILE_PAGE_EXTENSION = ".tpg";
+
+/**
+ * @brief 打包像素的 FNV-1a 哈希，避开 TILE_HASH_BLANK 和 TILE_HASH_INVALID 两个保留值
+ */
+uint32_t tile_hash(const uint8_t* data, size_t size);
+
+/**
+ * @brief 只读视图：解析文件头和块表，数据仍在调用方的缓冲区中
+ */
+class TilePageView {
+public:
+    /**
+     * @return 格式错误时返回 false，此后 tileCount() 为 0
+     */
+    bool parse(const uint8_t* data, size_t size);
+
+    int width() const
+    {
+        return _width;
+    }
+    int height() const
+    {
+        return _height;
+    }
+    int tileSize() const
+    {
+        return _tile_size;
+    }
+    int bitDepth() const
+    {
+        return _bit_depth;
+    }
+    int cols() const
+    {
+        return _cols;
+    }
+    int rows() const
+    {
+        return _rows;
+    }
+    int tileCount() const
+    {
+        return _cols * _rows;
+    }
+    int occupiedCount() const
+    {
+        return _occupied;
+    }
+
+    bool occupied(int tile) const
+    {
+        return _entries[tile].size > 0;
+    }
+    uint32_t hash(int tile) const
+    {
+        return _entries[tile].hash;
+    }
+
+    /**
+     * @brief 块在页面中的位置，边缘块可能小于 tileSize
+     */
+    void tileRect(int tile, int& x, int& y, int& w, int& h) const;
+
+    /**
+     * @brief 解码单个块为 8-bit 灰度（第 i 级 = i × 255 / (2^bitDepth - 1)）
+     * @param gray 至少 tileSize × tileSize 字节，按块实际宽度紧密排列
+     * @return 空白块直接填充白色
+     */
+    bool decodeTile(int tile, uint8_t* gray);
+
+private:
+    struct Entry {
+        uint32_t hash   = TILE_HASH_BLANK;
+        uint32_t offset = 0;
+        uint32_t size   = 0;  // 0 = 空白块
+    };
+
+    const uint8_t* _data = nullptr;
+    size_t _size         = 0;
+    int _width           = 0;
+    int _height          = 0;
+    int _tile_size       = 0;
+    int _bit_depth       = 0;
+    int _cols            = 0;
+    int _rows            = 0;
+    int _occupied        = 0;
+    std::vector<Entry> _entries;
+
+    bool parseLayout(const uint8_t* data, size_t size);
+
+    // 解码状态在各块之间复用，避免逐块分配 inflate 字典
+    Inflater _inflater;
+    std::vector<uint8_t> _packed;
+};
+
+}  // namespace book
@@ -0,0 +1,424 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "title_index.h"
+#include "text_book.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+
+namespace book {
+
+static constexpr char TITLE_INDEX_MAGIC[4] = {'P', 'S', '3', 'I'};
+static constexpr size_t TOP_CHARS_COUNT    = 64;
+static constexpr uint32_t FIELD_SEPARATOR  = '\n';
+static constexpr size_t MAX_FIELD_BYTES    = 1024;
+
+static inline uint32_t bigram_key(uint32_t a, uint32_t b)
+{
+    return ((a & 0xFFFF) << 16) | (b & 0xFFFF);
+}
+
+static void append_utf8(std::string& out, uint32_t codepoint)
+{
+    char utf8[4];
+    out.append(utf8, encode_utf8(codepoint, utf8));
+}
+
+// 逐个取出 UTF-8 字符；text 来自 normalize_title_text，一定是合法 UTF-8
+template <typename Fn>
+static void for_each_char(const std::string& text, Fn fn)
+{
+    const uint8_t* p = (const uint8_t*)text.data();
+    size_t size      = text.size();
+    size_t pos       = 0;
+    while (pos < size) {
+        uint32_t codepoint = 0;
+        size_t n           = decode_text_char(TextEncoding::Utf8, p + pos, size - pos, codepoint);
+        if (n == 0) break;
+        fn(codepoint, pos, n);
+        pos += n;
+    }
+}
+
+// fieldEnds：每个字段的最后一个字符再与分隔符组成一个 bigram，使每个字符都是某个键的首字符，单字查询也能走索引
+static void collect_bigrams(const std::string& text, bool fieldEnds, std::vector<uint32_t>& keys)
+{
+    uint32_t previous = 0;
+    for_each_char(text, [&](uint32_t codepoint, size_t, size_t) {
+        if (codepoint == FIELD_SEPARATOR) {
+            if (fieldEnds && previous != 0) keys.push_back(bigram_key(previous, FIELD_SEPARATOR));
+            previous = 0;
+            return;
+        }
+        if (previous != 0) keys.push_back(bigram_key(previous, codepoint));
+        previous = codepoint;
+    });
+    if (fieldEnds && previous != 0) keys.push_back(bigram_key(previous, FIELD_SEPARATOR));
+}
+
+std::string normalize_title_text(const std::string& text)
+{
+    std::string out;
+    out.reserve(std::min(text.size(), MAX_FIELD_BYTES));
+    bool pendingSpace = false;
+    const uint8_t* p  = (const uint8_t*)text.data();
+    size_t size       = std::min(text.size(), MAX_FIELD_BYTES);
+    size_t pos        = 0;
+    while (pos < size) {
+        uint32_t codepoint = 0;
+        size_t n           = decode_text_char(TextEncoding::Utf8, p + pos, size - pos, codepoint);
+        if (n == 0) break;  // 截断处的半个字符
+        pos += n;
+
+        codepoint = fold_search_char(codepoint);
+        if (codepoint == ' ') {
+            pendingSpace = !out.empty();
+            continue;
+        }
+        if (codepoint == 0) continue;
+        if (pendingSpace) out.push_back(' ');
+        pendingSpace = false;
+        append_utf8(out, codepoint);
+    }
+    return out;
+}
+
+void TitleIndex::clear()
+{
+    _docs.clear();
+    _by_id.clear();
+    _keys.clear();
+    _offsets.assign(1, 0);
+    _postings.clear();
+    _top_chars.clear();
+    _indexed_docs = 0;
+    _dirty        = false;
+}
+
+bool TitleIndex::addDoc(const std::string& id, std::string text)
+{
+    if (_docs.size() >= TITLE_INDEX_MAX_DOCS) {
+        rebuild();  // 清除已删除的条目
+        if (_docs.size() >= TITLE_INDEX_MAX_DOCS) return false;
+    }
+    _by_id[id] = (uint32_t)_docs.size();
+    _docs.push_back({id, std::move(text)});
+    // 待合并的条目超过已索引的 1/4 时重建，逐本加入整个书库时总耗时仍为 O(n log n)
+    size_t pending = _docs.size() - _indexed_docs;
+    if (pending > std::max<size_t>(TITLE_INDEX_MERGE_THRESHOLD, _indexed_docs / 4)) rebuild();
+    return true;
+}
+
+bool TitleIndex::update(const std::string& id, const std::string& title, const std::string& author)
+{
+    std::string text = normalize_title_text(title);
+    text.push_back((char)FIELD_SEPARATOR);
+    text += normalize_title_text(author);
+
+    auto it = _by_id.find(id);
+    if (it != _by_id.end()) {
+        if (_docs[it->second].text == text) return false;
+        _docs[it->second].text.clear();
+    }
+    _dirty = true;
+    return addDoc(id, std::move(text));
+}
+
+bool TitleIndex::remove(const std::string& id)
+{
+    auto it = _by_id.find(id);
+    if (it == _by_id.end()) return false;
+    _docs[it->second].text.clear();
+    _by_id.erase(it);
+    _dirty = true;
+    return true;
+}
+
+size_t TitleIndex::prune(const std::vector<std::string>& liveIds)
+{
+    std::unordered_set<std::string> live(liveIds.begin(), liveIds.end());
+    std::vector<std::string> stale;
+    for (const auto& entry : _by_id) {
+        if (live.count(entry.first) == 0) stale.push_back(entry.first);
+    }
+    for (const auto& id : stale) remove(id);
+    return stale.size();
+}
+
+void TitleIndex::rebuild()
+{
+    // 去掉已删除的条目，序号重新编排
+    std::vector<Doc> docs;
+    docs.reserve(_by_id.size());
+    for (auto& doc : _docs) {
+        if (!doc.text.empty()) docs.push_back(std::move(doc));
+    }
+    _docs.swap(docs);
+    _by_id.clear();
+    for (size_t i = 0; i < _docs.size(); i++) _by_id[_docs[i].id] = (uint32_t)i;
+
+    // (键, 序号) 对排序后去重，得到每个键的倒排表
+    std::vector<uint64_t> pairs;
+    std::vector<uint32_t> keys;
+    for (size_t i = 0; i < _docs.size(); i++) {
+        keys.clear();
+        collect_bigrams(_docs[i].text, true, keys);
+        for (uint32_t key : keys) pairs.push_back(((uint64_t)key << 16) | i);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    _keys.clear();
+    _offsets.clear();
+    _postings.clear();
+    _postings.reserve(pairs.size());
+    for (uint64_t pair : pairs) {
+        uint32_t key = (uint32_t)(pair >> 16);
+        if (_keys.empty() || _keys.back() != key) {
+            _keys.push_back(key);
+            _offsets.push_back((uint32_t)_postings.size());
+        }
+        _postings.push_back((uint16_t)(pair & 0xFFFF));
+    }
+    _offsets.push_back((uint32_t)_postings.size());
+    _indexed_docs = (uint32_t)_docs.size();
+    countChars();
+}
+
+void TitleIndex::countChars()
+{
+    std::unordered_map<uint32_t, uint32_t> charCounts;
+    for (const auto& doc : _docs) {
+        for_each_char(doc.text, [&](uint32_t codepoint, size_t, size_t) {
+            if (codepoint >= 0x80) charCounts[codepoint]++;
+        });
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> chars(charCounts.begin(), charCounts.end());
+    size_t top = std::min(chars.size(), TOP_CHARS_COUNT);
+    std::partial_sort(chars.begin(), chars.begin() + top, chars.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    _top_chars.clear();
+    for (size_t i = 0; i < top; i++) _top_chars.push_back(chars[i].first);
+}
+
+void TitleIndex::search(const std::string& query, size_t maxResults, size_t maxNextChars,
+                        TitleSearchResult& result) const
+{
+    result.ids.clear();
+    result.nextChars.clear();
+    result.total = 0;
+
+    std::string needle = normalize_title_text(query);
+    if (needle.empty()) {
+        size_t n = std::min(maxNextChars, _top_chars.size());
+        result.nextChars.assign(_top_chars.begin(), _top_chars.begin() + n);
+        return;
+    }
+
+    // 候选：多字符查询取各 bigram 倒排表的交集，单字查询取以它开头的所有键的并集，再加上待合并的条目
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> keys;
+    collect_bigrams(needle, false, keys);
+    if (keys.empty()) {
+        uint32_t codepoint = 0;
+        decode_text_char(TextEncoding::Utf8, (const uint8_t*)needle.data(), needle.size(), codepoint);
+        uint32_t first = bigram_key(codepoint, 0);
+        auto begin     = std::lower_bound(_keys.begin(), _keys.end(), first);
+        auto end       = begin;
+        while (end != _keys.end() && (*end >> 16) == (first >> 16)) end++;
+        if (begin != end) {
+            size_t from = _offsets[begin - _keys.begin()];
+            size_t to   = _offsets[end - _keys.begin()];
+            candidates.assign(_postings.begin() + from, _postings.begin() + to);
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        }
+    } else {
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        std::vector<std::pair<uint32_t, uint32_t>> lists;  // 倒排表区间，最短的先求交
+        for (uint32_t key : keys) {
+            auto it = std::lower_bound(_keys.begin(), _keys.end(), key);
+            if (it == _keys.end() || *it != key) {
+                lists.clear();
+                break;
+            }
+            size_t k = (size_t)(it - _keys.begin());
+            lists.push_back({_offsets[k], _offsets[k + 1]});
+        }
+        std::sort(lists.begin(), lists.end(),
+                  [](const auto& a, const auto& b) { return a.second - a.first < b.second - b.first; });
+
+        if (!lists.empty()) {
+            candidates.assign(_postings.begin() + lists[0].first, _postings.begin() + lists[0].second);
+            for (size_t l = 1; l < lists.size() && !candidates.empty(); l++) {
+                const uint16_t* begin = _postings.data() + lists[l].first;
+                const uint16_t* end   = _postings.data() + lists[l].second;
+                size_t kept           = 0;
+                for (uint32_t doc : candidates) {
+                    begin = std::lower_bound(begin, end, (uint16_t)doc);
+                    if (begin == end) break;
+                    if (*begin == doc) candidates[kept++] = doc;
+                }
+                candidates.resize(kept);
+            }
+        }
+    }
+    for (size_t i = _indexed_docs; i < _docs.size(); i++) candidates.push_back((uint32_t)i);
+
+    // 复核并打分：书名开头 < 书名中 < 作者中，同分时书名短的在前
+    struct Match {
+        uint32_t doc;
+        uint32_t score;
+    };
+    std::vector<Match> matches;
+    std::unordered_map<uint32_t, uint32_t> nextCounts;
+    for (uint32_t doc : candidates) {
+        const std::string& text = _docs[doc].text;
+        size_t pos              = text.find(needle);
+        if (pos == std::string::npos) continue;
+
+        size_t separator = text.find((char)FIELD_SEPARATOR);
+        uint32_t rank    = pos == 0 ? 0 : pos < separator ? 1 : 2;
+        matches.push_back({doc, (rank << 16) | (uint32_t)std::min<size_t>(separator, 0xFFFF)});
+
+        if (maxNextChars == 0) continue;
+        for (; pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+            size_t next = pos + needle.size();
+            if (next >= text.size()) break;
+            uint32_t codepoint = 0;
+            decode_text_char(TextEncoding::Utf8, (const uint8_t*)text.data() + next, text.size() - next, codepoint);
+            if (codepoint >= 0x80) nextCounts[codepoint]++;
+        }
+    }
+
+    result.total = matches.size();
+    size_t n     = std::min(maxResults, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + n, matches.end(), [](const Match& a, const Match& b) {
+        return a.score != b.score ? a.score < b.score : a.doc < b.doc;
+    });
+    for (size_t i = 0; i < n; i++) result.ids.push_back(_docs[matches[i].doc].id);
+
+    std::vector<std::pair<uint32_t, uint32_t>> chars(nextCounts.begin(), nextCounts.end());
+    n = std::min(maxNextChars, chars.size());
+    std::partial_sort(chars.begin(), chars.begin() + n, chars.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    for (size_t i = 0; i < n; i++) result.nextChars.push_back(chars[i].first);
+}
+
+size_t TitleIndex::memoryBytes() const
+{
+    size_t bytes = _keys.capacity() * 4 + _offsets.capacity() * 4 + _postings.capacity() * 2;
+    for (const auto& doc : _docs) bytes += sizeof(Doc) + doc.id.capacity() + doc.text.capacity();
+    bytes += _by_id.size() * (sizeof(std::string) + 16) + _top_chars.capacity() * 4;
+    return bytes;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   文件                                     */
+/* -------------------------------------------------------------------------- */
+
+static bool read_u32(FILE* f, uint32_t& value)
+{
+    return fread(&value, 4, 1, f) == 1;
+}
+
+static bool read_string(FILE* f, std::string& value)
+{
+    uint16_t len = 0;
+    if (fread(&len, 2, 1, f) != 1) return false;
+    value.resize(len);
+    return len == 0 || fread(&value[0], 1, len, f) == len;
+}
+
+static bool write_string(FILE* f, const std::string& value)
+{
+    uint16_t len = (uint16_t)std::min<size_t>(value.size(), 0xFFFF);
+    return fwrite(&len, 2, 1, f) == 1 && fwrite(value.data(), 1, len, f) == len;
+}
+
+bool TitleIndex::load(const std::string& path)
+{
+    clear();
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    char magic[4];
+    uint32_t version = 0, docCount = 0, keyCount = 0, postingCount = 0;
+    bool ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, TITLE_INDEX_MAGIC, 4) == 0 && read_u32(f, version) &&
+              version == TITLE_INDEX_VERSION && read_u32(f, docCount) && read_u32(f, keyCount) &&
+              read_u32(f, postingCount) && docCount <= TITLE_INDEX_MAX_DOCS;
+
+    if (ok) {
+        _docs.resize(docCount);
+        for (uint32_t i = 0; ok && i < docCount; i++) {
+            ok = read_string(f, _docs[i].id) && read_string(f, _docs[i].text) && !_docs[i].text.empty();
+            if (ok) _by_id[_docs[i].id] = i;
+        }
+    }
+    if (ok) {
+        _keys.resize(keyCount);
+        _offsets.resize(keyCount + 1);
+        _postings.resize(postingCount);
+        ok = fread(_keys.data(), 4, keyCount, f) == keyCount &&
+             fread(_offsets.data(), 4, keyCount + 1, f) == keyCount + 1 &&
+             fread(_postings.data(), 2, postingCount, f) == postingCount;
+    }
+    fclose(f);
+
+    // 偏移必须单调且不越界，序号必须小于条目数
+    for (uint32_t k = 0; ok && k < keyCount; k++) {
+        ok = _offsets[k] <= _offsets[k + 1] && (k == 0 || _keys[k - 1] < _keys[k]);
+    }
+    ok = ok && _offsets.front() == 0 && _offsets.back() == postingCount && _by_id.size() == docCount;
+    for (uint32_t i = 0; ok && i < postingCount; i++) ok = _postings[i] < docCount;
+    if (!ok) {
+        clear();
+        return false;
+    }
+
+    // 联想字不持久化，按条目重新统计
+    _indexed_docs = docCount;
+    countChars();
+    return true;
+}
+
+bool TitleIndex::save(const std::string& path)
+{
+    rebuild();
+
+    std::string tempPath = path + ".tmp";
+    FILE* f              = fopen(tempPath.c_str(), "wb");
+    if (!f) return false;
+
+    uint32_t head[4] = {TITLE_INDEX_VERSION, (uint32_t)_docs.size(), (uint32_t)_keys.size(),
+                        (uint32_t)_postings.size()};
+    bool ok          = fwrite(TITLE_INDEX_MAGIC, 1, 4, f) == 4 && fwrite(head, 4, 4, f) == 4;
+    for (size_t i = 0; ok && i < _docs.size(); i++) {
+        ok = write_string(f, _docs[i].id) && write_string(f, _docs[i].text);
+    }
+    ok = ok && fwrite(_keys.data(), 4, _keys.size(), f) == _keys.size() &&
+         fwrite(_offsets.data(), 4, _offsets.size(), f) == _offsets.size() &&
+         fwrite(_postings.data(), 2, _postings.size(), f) == _postings.size();
+    ok = fclose(f) == 0 && ok;
+
+    if (ok) {
+        ::remove(path.c_str());
+        ok = rename(tempPath.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        ::remove(tempPath.c_str());
+        return false;
+    }
+    _dirty = false;
+    return true;
+}
+
+}  // namespace book
@@ -0,0 +1,118 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace book {
+
+/*
+ * 书名 / 作者检索：books/.title_index，按相邻两个字符（bigram）建立倒排索引，中日文不需要分词
+ *
+ * 书名和作者先归一化（ASCII 和全角字母数字转为半角小写，空白合并为一个空格），再取每对相邻字符，
+ * 码位各取低 16 位拼成 32 位键（BMP 以外的字符会冲突，查询时按子串复核，不影响结果）；
+ * 字段的最后一个字符与换行组成一个键，这样每个字符都是某些键的首字符。
+ * 多字符查询取各 bigram 倒排表的交集，单字查询取以它开头的键（在有序键表中连续）的并集，
+ * 再在候选书中确认查询串确实连续出现。
+ *
+ * 文件格式（小端）：
+ *
+ *   0   char[4]  "PS3I"
+ *   4   u32      版本（1）
+ *   8   u32      条目数 D
+ *   12  u32      键数 K
+ *   16  u32      倒排项数 P
+ *   20  D × { u16 id 长度, id, u16 文本长度, 归一化的 "书名\n作者" }
+ *       u32[K]   键，升序
+ *       u32[K+1] 各键倒排表在 postings 中的起点
+ *       u16[P]   postings：条目序号，每个键内升序
+ *
+ * 加载后直接在这几个数组上查询，不需要重新排序。新增的条目先放在待合并列表中（查询时逐条复核），
+ * 超过 TITLE_INDEX_MERGE_THRESHOLD 条（且超过已索引条目的 1/4）或保存时再整体重建；删除只做标记，重建时清除。
+ */
+static constexpr uint32_t TITLE_INDEX_VERSION       = 1;
+static constexpr size_t TITLE_INDEX_HEADER_SIZE     = 20;
+static constexpr size_t TITLE_INDEX_MAX_DOCS        = 65535;
+static constexpr size_t TITLE_INDEX_MERGE_THRESHOLD = 64;
+static constexpr const char* TITLE_INDEX_FILE_NAME  = ".title_index";
+
+/**
+ * @brief 归一化书名 / 作者：半角小写，空白合并为一个空格，去掉首尾空白
+ */
+std::string normalize_title_text(const std::string& text);
+
+struct TitleSearchResult {
+    std::vector<std::string> ids;     // 按相关度排序，至多 maxResults 个
+    size_t total = 0;                 // 匹配的条目总数
+    std::vector<uint32_t> nextChars;  // 联想字：匹配结果中紧跟查询串之后的非 ASCII 字符，按出现次数降序
+};
+
+class TitleIndex {
+public:
+    void clear();
+
+    bool load(const std::string& path);
+    /**
+     * @brief 合并待合并列表后写入 path（先写 .tmp 再改名）
+     */
+    bool save(const std::string& path);
+
+    /**
+     * @brief 新增或更新一本书；书名和作者归一化后未变化时不做任何事
+     * @return 索引是否变化
+     */
+    bool update(const std::string& id, const std::string& title, const std::string& author);
+    bool remove(const std::string& id);
+    /**
+     * @brief 删除 liveIds 以外的条目，用于书架扫描之后
+     * @return 删除的条目数
+     */
+    size_t prune(const std::vector<std::string>& liveIds);
+
+    /**
+     * @brief 查询；query 为空时只返回全库最常见的字符作为联想字
+     * @param maxNextChars 联想字个数上限，0 表示不需要
+     */
+    void search(const std::string& query, size_t maxResults, size_t maxNextChars, TitleSearchResult& result) const;
+
+    size_t size() const
+    {
+        return _by_id.size();
+    }
+    bool dirty() const
+    {
+        return _dirty;
+    }
+    /**
+     * @brief 索引占用的内存（估算）
+     */
+    size_t memoryBytes() const;
+
+private:
+    struct Doc {
+        std::string id;
+        std::string text;  // 归一化的 "书名\n作者"，空表示已删除
+    };
+
+    std::vector<Doc> _docs;
+    std::unordered_map<std::string, uint32_t> _by_id;
+    std::vector<uint32_t> _keys;
+    std::vector<uint32_t> _offsets;
+    std::vector<uint16_t> _postings;
+    std::vector<uint32_t> _top_chars;  // 全库最常见的非 ASCII 字符
+    uint32_t _indexed_docs = 0;        // [0, _indexed_docs) 已在倒排表中，之后的待合并
+    bool _dirty            = false;
+
+    void rebuild();
+    void countChars();
+    bool addDoc(const std::string& id, std::string text);
+};
+
+}  // namespace book
@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace book {
+
+/*
+ * LEB128 无符号变长整数：每字节低 7 位为数据，最高位为 1 表示后面还有字节，低位在前；
+ * uint32_t 最多 5 字节。全文索引的倒排表、词典的键区、墨迹笔画的坐标差都用它压缩小整数
+ */
+inline void append_varint(std::vector<uint8_t>& out, uint32_t v)
+{
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+// 返回消耗的字节数，数据不完整时返回 0
+inline size_t read_varint(const uint8_t* p, size_t size, uint32_t& v)
+{
+    v = 0;
+    for (size_t i = 0; i < size && i < 5; i++) {
+        v |= (uint32_t)(p[i] & 0x7F) << (7 * i);
+        if (!(p[i] & 0x80)) return i + 1;
+    }
+    return 0;
+}
+
+}  // namespace book
@@ -0,0 +1,332 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "zip_reader.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "esp_rom_crc.h"
+#else
+#include <zlib.h>
+#endif
+
+namespace book {
+
+static constexpr uint32_t EOCD_SIGNATURE    = 0x06054B50;
+static constexpr uint32_t CENTRAL_SIGNATURE = 0x02014B50;
+static constexpr uint32_t LOCAL_SIGNATURE   = 0x04034B50;
+static constexpr size_t EOCD_SIZE           = 22;
+static constexpr size_t CENTRAL_HEADER_SIZE = 46;
+static constexpr size_t LOCAL_HEADER_SIZE   = 30;
+static constexpr size_t EOCD_SEARCH_CHUNK   = 1024;
+static constexpr size_t MAX_COMMENT_SIZE    = 0xFFFF;
+
+static inline uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t name_hash(const char* name, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t zip_crc32(uint32_t crc, const uint8_t* data, size_t len)
+{
+#ifdef ESP_PLATFORM
+    return esp_rom_crc32_le(crc, data, len);
+#else
+    return (uint32_t)crc32(crc, data, (uInt)len);
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  ZipReader                                 */
+/* -------------------------------------------------------------------------- */
+
+ZipReader::~ZipReader()
+{
+    close();
+}
+
+bool ZipReader::open(const std::string& path)
+{
+    close();
+    _error.clear();
+
+    _file = fopen(path.c_str(), "rb");
+    if (!_file) {
+        _error = "Failed to open " + path;
+        return false;
+    }
+    fseek(_file, 0, SEEK_END);
+    long fileSize = ftell(_file);
+    if (fileSize < (long)EOCD_SIZE) {
+        _error = "Not a ZIP file";
+        close();
+        return false;
+    }
+
+    // 目录结束记录在文件末尾，之后最多跟 64KB 注释；从后向前按块查找签名，块之间重叠 3 字节
+    uint8_t chunk[EOCD_SEARCH_CHUNK + 3];
+    long limit = std::max<long>(0, fileSize - (long)(EOCD_SIZE + MAX_COMMENT_SIZE));
+    long end   = fileSize;
+    long found = -1;
+    uint8_t eocd[EOCD_SIZE];
+    while (end > limit && found < 0) {
+        long start = std::max(limit, end - (long)EOCD_SEARCH_CHUNK);
+        size_t len = (size_t)std::min<long>(fileSize - start, (long)sizeof(chunk));
+        if (fseek(_file, start, SEEK_SET) != 0 || fread(chunk, 1, len, _file) != len) break;
+        for (long i = (long)len - 4; i >= 0; i--) {
+            if (get_u32(chunk + i) == EOCD_SIGNATURE && start + i + (long)EOCD_SIZE <= fileSize) {
+                found = start + i;
+                break;
+            }
+        }
+        end = start;
+    }
+    if (found < 0 || fseek(_file, found, SEEK_SET) != 0 || fread(eocd, 1, EOCD_SIZE, _file) != EOCD_SIZE) {
+        _error = "ZIP end of central directory not found";
+        close();
+        return false;
+    }
+
+    uint16_t count = get_u16(eocd + 10);
+    _cd_size       = get_u32(eocd + 12);
+    _cd_offset     = get_u32(eocd + 16);
+    if (count == 0xFFFF || _cd_offset == 0xFFFFFFFF || get_u16(eocd + 4) != 0) {
+        _error = "ZIP64 and multi-disk archives are not supported";
+        close();
+        return false;
+    }
+    if ((long)_cd_offset + (long)_cd_size > found || count > MAX_ENTRIES) {
+        _error = "Invalid ZIP central directory";
+        close();
+        return false;
+    }
+    _entry_count = count;
+    rewind();
+    return true;
+}
+
+void ZipReader::close()
+{
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+    _entry_count = 0;
+    _cd_offset   = 0;
+    _cd_size     = 0;
+    _cd_pos      = 0;
+    _index.clear();
+    _index.shrink_to_fit();
+}
+
+void ZipReader::rewind()
+{
+    _cd_pos = _cd_offset;
+}
+
+bool ZipReader::readRecord(uint32_t offset, ZipEntry& entry, uint32_t& recordSize)
+{
+    uint8_t head[CENTRAL_HEADER_SIZE];
+    if (offset + CENTRAL_HEADER_SIZE > _cd_offset + _cd_size) return false;
+    if (fseek(_file, offset, SEEK_SET) != 0 || fread(head, 1, sizeof(head), _file) != sizeof(head)) return false;
+    if (get_u32(head) != CENTRAL_SIGNATURE) return false;
+
+    uint16_t nameLen    = get_u16(head + 28);
+    uint16_t extraLen   = get_u16(head + 30);
+    uint16_t commentLen = get_u16(head + 32);
+    recordSize          = (uint32_t)CENTRAL_HEADER_SIZE + nameLen + extraLen + commentLen;
+    if (offset + recordSize > _cd_offset + _cd_size) return false;
+
+    entry.name.resize(nameLen);
+    if (nameLen > 0 && fread(&entry.name[0], 1, nameLen, _file) != nameLen) return false;
+    // bit 0：加密
+    if (get_u16(head + 8) & 0x0001) entry.method = 0xFFFF;
+    else entry.method = get_u16(head + 10);
+    entry.crc32          = get_u32(head + 16);
+    entry.compressedSize = get_u32(head + 20);
+    entry.size           = get_u32(head + 24);
+    entry.localOffset    = get_u32(head + 42);
+    return true;
+}
+
+bool ZipReader::next(ZipEntry& entry)
+{
+    if (!_file || _cd_pos >= _cd_offset + _cd_size) return false;
+    uint32_t recordSize = 0;
+    if (!readRecord(_cd_pos, entry, recordSize)) {
+        _error  = "Invalid ZIP central directory record";
+        _cd_pos = _cd_offset + _cd_size;
+        return false;
+    }
+    _cd_pos += recordSize;
+    return true;
+}
+
+bool ZipReader::buildIndex()
+{
+    if (!_file) return false;
+
+    _index.clear();
+    _index.reserve(_entry_count);
+    rewind();
+    ZipEntry entry;
+    uint32_t offset = _cd_pos;
+    while (next(entry)) {
+        _index.push_back({name_hash(entry.name.data(), entry.name.size()), offset});
+        offset = _cd_pos;
+    }
+    if (!_error.empty()) return false;
+
+    std::sort(_index.begin(), _index.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return a.hash < b.hash || (a.hash == b.hash && a.offset < b.offset);
+    });
+    rewind();
+    return true;
+}
+
+bool ZipReader::find(const std::string& name, ZipEntry& entry)
+{
+    if (!_file) return false;
+
+    uint32_t hash = name_hash(name.data(), name.size());
+    auto it       = std::lower_bound(_index.begin(), _index.end(), hash,
+                                     [](const IndexEntry& e, uint32_t h) { return e.hash < h; });
+    // 哈希相同的条目逐个比较名称
+    for (; it != _index.end() && it->hash == hash; ++it) {
+        uint32_t recordSize = 0;
+        if (readRecord(it->offset, entry, recordSize) && entry.name == name) return true;
+    }
+    return false;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               ZipEntryReader                               */
+/* -------------------------------------------------------------------------- */
+
+bool ZipEntryReader::open(ZipReader& zip, const ZipEntry& entry)
+{
+    close();
+    _error.clear();
+    _file  = zip.file();
+    _entry = entry;
+
+    if (entry.method != 0 && entry.method != 8) {
+        _error = "Unsupported ZIP method for " + entry.name;
+        _file  = nullptr;
+        return false;
+    }
+
+    // 本地文件头的名称和扩展字段长度可能与中央目录不同，以本地文件头为准
+    uint8_t head[LOCAL_HEADER_SIZE];
+    if (!_file || fseek(_file, entry.localOffset, SEEK_SET) != 0 ||
+        fread(head, 1, sizeof(head), _file) != sizeof(head) || get_u32(head) != LOCAL_SIGNATURE) {
+        _error = "Invalid ZIP local header for " + entry.name;
+        _file  = nullptr;
+        return false;
+    }
+    _file_pos  = entry.localOffset + (uint32_t)LOCAL_HEADER_SIZE + get_u16(head + 26) + get_u16(head + 28);
+    _remaining = entry.compressedSize;
+    _produced  = 0;
+    _crc       = 0;
+    _finished  = false;
+
+    if (entry.method == 8) {
+        if (_input.size() != INPUT_BUFFER_SIZE) _input.resize(INPUT_BUFFER_SIZE);
+        if (!_inflater.begin(Inflater::Format::Raw)) {
+            _error = "Out of memory";
+            _file  = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+void ZipEntryReader::close()
+{
+    _file = nullptr;
+}
+
+int ZipEntryReader::finish()
+{
+    _finished = true;
+    if (_produced != _entry.size || _crc != _entry.crc32) {
+        _error = "CRC mismatch in " + _entry.name;
+        return -1;
+    }
+    return 0;
+}
+
+int ZipEntryReader::read(uint8_t* out, size_t len)
+{
+    if (!_file) return -1;
+    if (_finished || len == 0) return 0;
+
+    size_t produced = 0;
+    if (_entry.method == 0) {
+        // stored：直接读取
+        size_t n = std::min<size_t>(len, _remaining);
+        if (n == 0) return finish();
+        if (fseek(_file, _file_pos, SEEK_SET) != 0 || fread(out, 1, n, _file) != n) {
+            _error = "Failed to read " + _entry.name;
+            return -1;
+        }
+        _file_pos += (uint32_t)n;
+        _remaining -= (uint32_t)n;
+        produced = n;
+    } else {
+        while (produced < len) {
+            size_t n                = 0;
+            Inflater::Status status = _inflater.read(out + produced, len - produced, n);
+            produced += n;
+            if (status == Inflater::Status::Error) {
+                _error = "Corrupt deflate data in " + _entry.name;
+                return -1;
+            }
+            if (status == Inflater::Status::Done) {
+                if (produced == 0) return finish();
+                break;
+            }
+            if (status == Inflater::Status::NeedInput) {
+                if (_remaining == 0) {
+                    if (produced > 0) break;
+                    _error = "Truncated deflate data in " + _entry.name;
+                    return -1;
+                }
+                size_t chunk = std::min<size_t>(_input.size(), _remaining);
+                if (fseek(_file, _file_pos, SEEK_SET) != 0 || fread(_input.data(), 1, chunk, _file) != chunk) {
+                    _error = "Failed to read " + _entry.name;
+                    return -1;
+                }
+                _file_pos += (uint32_t)chunk;
+                _remaining -= (uint32_t)chunk;
+                _inflater.setInput(_input.data(), chunk);
+            }
+        }
+    }
+
+    _crc = zip_crc32(_crc, out, produced);
+    _produced += (uint32_t)produced;
+    if (_produced > _entry.size) {
+        _error = "Size mismatch in " + _entry.name;
+        return -1;
+    }
+    return (int)produced;
+}
+
+}  // namespace book
@@ -0,0 +1,129 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "inflater.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace book {
+
+/**
+ * @brief ZIP 中央目录中的一个条目
+ */
+struct ZipEntry {
+    std::string name;
+    uint16_t method         = 0;  // 0 = stored，8 = deflate
+    uint32_t crc32          = 0;
+    uint32_t compressedSize = 0;
+    uint32_t size           = 0;
+    uint32_t localOffset    = 0;  // 本地文件头在 ZIP 中的偏移
+};
+
+/**
+ * @brief 只读 ZIP（EPUB）访问，不整体载入中央目录
+ *
+ * open() 只读取文件末尾的目录结束记录；next() 顺序读取中央目录，每次一条。
+ * buildIndex() 遍历一次中央目录，为每个条目保存 8 字节（名称哈希 + 记录偏移），之后 find() 按名称定位，
+ * 内存只与条目数有关，与 ZIP 大小无关。不支持 ZIP64 和加密条目。
+ */
+class ZipReader {
+public:
+    static constexpr int MAX_ENTRIES = 16384;
+
+    ZipReader() = default;
+    ~ZipReader();
+    ZipReader(const ZipReader&)            = delete;
+    ZipReader& operator=(const ZipReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    int entryCount() const
+    {
+        return _entry_count;
+    }
+    const std::string& lastError() const
+    {
+        return _error;
+    }
+    FILE* file() const
+    {
+        return _file;
+    }
+
+    /**
+     * @brief 回到中央目录开头，之后用 next() 逐条读取
+     */
+    void rewind();
+    bool next(ZipEntry& entry);
+
+    bool buildIndex();
+    bool find(const std::string& name, ZipEntry& entry);
+
+private:
+    struct IndexEntry {
+        uint32_t hash;
+        uint32_t offset;  // 中央目录记录在 ZIP 中的偏移
+    };
+
+    FILE* _file         = nullptr;
+    int _entry_count    = 0;
+    uint32_t _cd_offset = 0;
+    uint32_t _cd_size   = 0;
+    uint32_t _cd_pos    = 0;  // next() 的读取位置
+    std::vector<IndexEntry> _index;
+    std::string _error;
+
+    bool readRecord(uint32_t offset, ZipEntry& entry, uint32_t& recordSize);
+};
+
+/**
+ * @brief 流式读取一个条目的内容（deflate 时边读边解压），读完后校验 CRC32
+ *
+ * 内存占用固定：4KB 输入缓冲 + Inflater 的 32KB 字典。同一实例可以依次读取多个条目，缓冲区复用。
+ */
+class ZipEntryReader {
+public:
+    static constexpr size_t INPUT_BUFFER_SIZE = 4096;
+
+    bool open(ZipReader& zip, const ZipEntry& entry);
+    void close();
+
+    /**
+     * @return 写入 out 的字节数；条目结束时返回 0，出错时返回 -1
+     */
+    int read(uint8_t* out, size_t len);
+
+    const std::string& lastError() const
+    {
+        return _error;
+    }
+
+private:
+    FILE* _file = nullptr;
+    ZipEntry _entry;
+    Inflater _inflater;
+    std::vector<uint8_t> _input;
+    uint32_t _file_pos  = 0;  // 下一次读取压缩数据的位置
+    uint32_t _remaining = 0;  // 尚未读取的压缩数据
+    uint32_t _produced  = 0;
+    uint32_t _crc       = 0;
+    bool _finished      = false;
+    std::string _error;
+
+    int finish();
+};
+
+/**
+ * @brief 标准 CRC-32（ZIP 使用的多项式）
+ */
+uint32_t zip_crc32(uint32_t crc, const uint8_t* data, size_t len);
+
+}  // namespace book
@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: MIT
  */
 #include "hal.h"
+#include "delete_jobs.h"
+#include "free_space.h"
 #include <memory>
 #include <mooncake_log.h>
 #include <M5Unified.hpp>
@@ -246,6 +248,10 @@ void Hal::sd_card_init()
     sdmmc_card_print_info(stdout, _sd_card);
 
     _is_sd_card_mounted = true;
+
+    // 继续重启前没有删完的目录；剩余空间在后台扫描，/api/info 不等待
+    book::DeleteJobQueue::getInstance().resume();
+    book::FreeSpaceCache::getInstance().refresh();
 }
 
 void Hal::sdCardTest()
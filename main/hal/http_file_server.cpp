@@ -4,12 +4,24 @@
  * SPDX-License-Identifier: MIT
  */
 #include "http_file_server.h"
+#include "epub_ingest.h"
+#include "delete_jobs.h"
+#include "copy_jobs.h"
+#include "file_checksums.h"
+#include "crc32c.h"
+#include "free_space.h"
+#include "fs_events.h"
+#include "read_ahead.h"
+#include "tar_archive.h"
 #include <mooncake_log.h>
+#include <esp_timer.h>
 #include <esp_wifi.h>
 #include <esp_netif.h>
 #include <esp_vfs_fat.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <strings.h>
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
 
@@ -23,6 +35,9 @@ static const size_t FILE_BUFFER_SIZE = 262144;  // 256KB
 // SD卡根路径
 static const char* SD_ROOT = "/sdcard";
 
+// 书架目录（相对SD卡根路径）
+static const char* BOOKS_DIR = "/books";
+
 HttpFileServer& HttpFileServer::getInstance()
 {
     static HttpFileServer instance;
@@ -172,6 +187,51 @@ void HttpFileServer::registerUriHandlers()
     };
     httpd_register_uri_handler(_server, &delete_rmdir);
     
+    // GET /api/jobs - 后台删除任务状态
+    httpd_uri_t get_jobs = {
+        .uri = "/api/jobs",
+        .method = HTTP_GET,
+        .handler = handleGetJobs,
+        .user_ctx = nullptr
+    };
+    httpd_register_uri_handler(_server, &get_jobs);
+    
+    // GET /api/archive - 把目录打包为 tar 流式下载
+    httpd_uri_t get_archive = {
+        .uri = "/api/archive",
+        .method = HTTP_GET,
+        .handler = handleGetArchive,
+        .user_ctx = nullptr
+    };
+    httpd_register_uri_handler(_server, &get_archive);
+    
+    // POST /api/move - 移动或改名
+    httpd_uri_t post_move = {
+        .uri = "/api/move",
+        .method = HTTP_POST,
+        .handler = handleMove,
+        .user_ctx = nullptr
+    };
+    httpd_register_uri_handler(_server, &post_move);
+    
+    // POST /api/copy - 后台复制
+    httpd_uri_t post_copy = {
+        .uri = "/api/copy",
+        .method = HTTP_POST,
+        .handler = handleCopy,
+        .user_ctx = nullptr
+    };
+    httpd_register_uri_handler(_server, &post_copy);
+    
+    // POST /api/sync/manifest - 对照文件清单，只返回需要上传的文件
+    httpd_uri_t post_sync_manifest = {
+        .uri = "/api/sync/manifest",
+        .method = HTTP_POST,
+        .handler = handleSyncManifest,
+        .user_ctx = nullptr
+    };
+    httpd_register_uri_handler(_server, &post_sync_manifest);
+    
     // POST /api/upload-batch - 批量上传文件
     httpd_uri_t post_upload_batch = {
         .uri = "/api/upload-batch",
@@ -181,6 +241,15 @@ void HttpFileServer::registerUriHandlers()
     };
     httpd_register_uri_handler(_server, &post_upload_batch);
     
+    // POST /api/upload - 上传书籍（.epub 在设备上导入）
+    httpd_uri_t post_upload = {
+        .uri = "/api/upload",
+        .method = HTTP_POST,
+        .handler = handleUpload,
+        .user_ctx = nullptr
+    };
+    httpd_register_uri_handler(_server, &post_upload);
+    
     mclog::tagInfo(TAG, "URI handlers registered");
 }
 
@@ -196,7 +265,7 @@ void HttpFileServer::setCorsHeaders(httpd_req_t* req)
 {
     httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
     httpd_resp_set_hdr(req, "Access-Control-Allow-Methods", "GET, POST, DELETE, OPTIONS");
-    httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "Content-Type");
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "Content-Type, X-Checksum");
 }
 
 std::string HttpFileServer::getQueryParam(httpd_req_t* req, const char* key)
@@ -256,6 +325,8 @@ void HttpFileServer::sendErrorResponse(httpd_req_t* req, int code, const char* m
         httpd_resp_set_status(req, "404 Not Found");
     } else if (code == 400) {
         httpd_resp_set_status(req, "400 Bad Request");
+    } else if (code == 409) {
+        httpd_resp_set_status(req, "409 Conflict");
     } else if (code == 500) {
         httpd_resp_set_status(req, "500 Internal Server Error");
     }
@@ -287,16 +358,10 @@ esp_err_t HttpFileServer::handleGetInfo(httpd_req_t* req)
         rssi = ap_info.rssi;
     }
     
-    // 获取SD卡空间信息（使用esp_vfs_fat API）
-    uint64_t total_bytes = 0;
-    uint64_t free_bytes = 0;
-    
-    FATFS* fs;
-    DWORD fre_clust;
-    if (f_getfree("0:", &fre_clust, &fs) == FR_OK) {
-        total_bytes = (uint64_t)(fs->n_fatent - 2) * fs->csize * 512;
-        free_bytes = (uint64_t)fre_clust * fs->csize * 512;
-    }
+    // SD卡空间信息：后台扫描的缓存，不在请求中遍历FAT；第一次扫描完成前 valid 为 false
+    book::FreeSpaceInfo space = book::FreeSpaceCache::getInstance().get();
+    uint64_t total_bytes = space.total;
+    uint64_t free_bytes = space.free;
     
     char json[512];
     snprintf(json, sizeof(json),
@@ -304,10 +369,11 @@ esp_err_t HttpFileServer::handleGetInfo(httpd_req_t* req)
         "\"device\":\"M5PaperS3\","
         "\"ip\":\"%s\","
         "\"wifi\":{\"ssid\":\"%s\",\"rssi\":%d},"
-        "\"storage\":{\"total\":%llu,\"free\":%llu,\"used\":%llu}"
+        "\"storage\":{\"total\":%llu,\"free\":%llu,\"used\":%llu,\"valid\":%s,\"estimated\":%s}"
         "}",
         ip_str, ssid, rssi,
-        total_bytes, free_bytes, total_bytes - free_bytes
+        total_bytes, free_bytes, total_bytes - free_bytes,
+        space.valid ? "true" : "false", space.estimated ? "true" : "false"
     );
     
     sendJsonResponse(req, json);
@@ -375,7 +441,23 @@ esp_err_t HttpFileServer::handleListDir(httpd_req_t* req)
     return ESP_OK;
 }
 
+// 发送整段数据；httpd_send 可能只发出一部分
+static bool sendAll(httpd_req_t* req, const char* data, size_t size)
+{
+    while (size > 0) {
+        int sent = httpd_send(req, data, size);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
 // GET /api/file?path=/path/to/file
+// 读卡任务预读后面的块，本任务发送当前块，读卡与等待网络重叠进行。
+// 普通文件带 Content-Length 发送（客户端能显示进度、能发现中途断开），取不到大小时退回分块传输
 esp_err_t HttpFileServer::handleGetFile(httpd_req_t* req)
 {
     std::string path = getQueryParam(req, "path");
@@ -392,9 +474,9 @@ esp_err_t HttpFileServer::handleGetFile(httpd_req_t* req)
         sendErrorResponse(req, 404, "File not found");
         return ESP_OK;
     }
-    
-    // 设置响应头
-    setCorsHeaders(req);
+    struct stat st;
+    bool sized = fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode);
+    uint64_t length = sized ? (uint64_t)st.st_size : 0;
     
     // 根据文件扩展名设置Content-Type
     std::string content_type = "application/octet-stream";
@@ -413,71 +495,174 @@ esp_err_t HttpFileServer::handleGetFile(httpd_req_t* req)
         else if (ext == ".pdf") content_type = "application/pdf";
     }
     
-    httpd_resp_set_type(req, content_type.c_str());
-    
-    // 设置Content-Disposition用于下载
+    // Content-Disposition用于下载
     std::string filename = path.substr(path.rfind('/') + 1);
     std::string disposition = "attachment; filename=\"" + filename + "\"";
-    httpd_resp_set_hdr(req, "Content-Disposition", disposition.c_str());
     
-    // 分块发送文件
-    char* buffer = new char[FILE_BUFFER_SIZE];
-    size_t read_bytes;
+    // 按 Content-Length 发送时最多读开始时的大小，发送期间文件变大也不会多发
+    uint64_t remaining = length;
+    book::ReadAhead reader([fp, sized, &remaining](uint8_t* out, size_t capacity) {
+        if (sized) {
+            capacity = (size_t)std::min<uint64_t>(capacity, remaining);
+        }
+        size_t n = capacity > 0 ? fread(out, 1, capacity, fp) : 0;
+        remaining -= sized ? n : 0;
+        return n;
+    });
+    if (!reader.start()) {
+        fclose(fp);
+        sendErrorResponse(req, 500, "Out of memory");
+        return ESP_OK;
+    }
     
-    while ((read_bytes = fread(buffer, 1, FILE_BUFFER_SIZE, fp)) > 0) {
-        if (httpd_resp_send_chunk(req, buffer, read_bytes) != ESP_OK) {
+    bool sent = true;
+    if (sized) {
+        // httpd_resp_send_chunk 总是分块传输，带 Content-Length 的流式响应只能自己写响应头
+        std::string headers = "HTTP/1.1 200 OK\r\n"
+                              "Content-Type: " + content_type + "\r\n"
+                              "Content-Length: " + std::to_string(length) + "\r\n"
+                              "Content-Disposition: " + disposition + "\r\n"
+                              "Access-Control-Allow-Origin: *\r\n"
+                              "Access-Control-Allow-Methods: GET, POST, DELETE, OPTIONS\r\n"
+                              "Access-Control-Allow-Headers: Content-Type, X-Checksum\r\n"
+                              "\r\n";
+        sent = sendAll(req, headers.data(), headers.size());
+    } else {
+        setCorsHeaders(req);
+        httpd_resp_set_type(req, content_type.c_str());
+        httpd_resp_set_hdr(req, "Content-Disposition", disposition.c_str());
+    }
+    
+    int64_t start = esp_timer_get_time();
+    int64_t send_us = 0;
+    uint64_t sent_bytes = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    while (sent && reader.next(data, size)) {
+        int64_t send_start = esp_timer_get_time();
+        if (sized) {
+            sent = sendAll(req, (const char*)data, size);
+        } else {
+            sent = httpd_resp_send_chunk(req, (const char*)data, size) == ESP_OK;
+        }
+        send_us += esp_timer_get_time() - send_start;
+        reader.release();
+        if (!sent) {
             mclog::tagError(TAG, "Failed to send file chunk");
             break;
         }
+        sent_bytes += size;
     }
-    
-    // 发送结束标记
-    httpd_resp_send_chunk(req, nullptr, 0);
-    
-    delete[] buffer;
+    reader.stop();
     fclose(fp);
     
+    // 读卡任务等得多说明网络是瓶颈，发送方等得多说明读卡是瓶颈
+    book::ReadAheadStats io = reader.stats();
+    mclog::tagInfo(TAG, "Sent {} KB in {} ms: read {} ms, send {} ms, reader waited {} ms, sender waited {} ms",
+                   sent_bytes / 1024, (esp_timer_get_time() - start) / 1000, io.readUs / 1000, send_us / 1000,
+                   io.readerStallUs / 1000, io.senderStallUs / 1000);
+    if (sized && sent && sent_bytes != length) {
+        mclog::tagError(TAG, "File shrank while sending: {} of {} bytes", sent_bytes, length);
+        sent = false;
+    }
+    if (!sent) {
+        // 返回错误让服务器关闭连接，客户端不会把截断的文件当作完整的
+        return ESP_FAIL;
+    }
+    if (!sized) {
+        httpd_resp_send_chunk(req, nullptr, 0);
+    }
+    
     return ESP_OK;
 }
 
-// POST /api/file?path=/path/to/file
-esp_err_t HttpFileServer::handlePostFile(httpd_req_t* req)
+// GET /api/archive?path=/books&since=1735689600
+// 把目录树打包为 tar 分块返回：读卡任务预读下一块的同时发送当前块，内存固定为几个块缓冲，与文件数无关。
+// since（Unix 秒）大于 0 时只打包此后修改过的文件，用于增量备份
+esp_err_t HttpFileServer::handleGetArchive(httpd_req_t* req)
 {
     std::string path = getQueryParam(req, "path");
+    while (path.size() > 1 && path.back() == '/') {
+        path.pop_back();
+    }
     if (path.empty()) {
-        sendErrorResponse(req, 400, "Path parameter required");
-        return ESP_OK;
+        path = "/";
     }
+    std::string since_param = getQueryParam(req, "since");
+    int64_t since = since_param.empty() ? 0 : strtoll(since_param.c_str(), nullptr, 10);
     
-    std::string full_path = SD_ROOT + path;
-    mclog::tagInfo(TAG, "POST /api/file path={}, size={}", full_path, req->content_len);
+    std::string full_path = path == "/" ? SD_ROOT : SD_ROOT + path;
+    mclog::tagInfo(TAG, "GET /api/archive path={}, since={}", full_path, since);
     
-    // 自动创建父目录（如果不存在）
-    size_t last_slash = full_path.rfind('/');
-    if (last_slash != std::string::npos && last_slash > strlen(SD_ROOT)) {
-        std::string parent_dir = full_path.substr(0, last_slash);
-        struct stat st;
-        if (stat(parent_dir.c_str(), &st) != 0) {
-            if (!createDirectoryRecursive(parent_dir)) {
-                mclog::tagError(TAG, "Failed to create parent directory: {}", parent_dir);
-                sendErrorResponse(req, 500, "Failed to create parent directory");
-                return ESP_OK;
-            }
-        }
+    struct stat st;
+    if (stat(full_path.c_str(), &st) != 0) {
+        sendErrorResponse(req, 404, "Directory not found");
+        return ESP_OK;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        sendErrorResponse(req, 400, "Not a directory");
+        return ESP_OK;
     }
     
-    FILE* fp = fopen(full_path.c_str(), "wb");
-    if (fp == nullptr) {
-        mclog::tagError(TAG, "Failed to create file: {} (errno={})", full_path, errno);
-        sendErrorResponse(req, 500, "Failed to create file");
+    // 条目以目录名开头，解包后得到同名目录；不打包后台删除中的墓碑和上传一半的 .part
+    std::string name = path == "/" ? "sdcard" : path.substr(path.rfind('/') + 1);
+    book::TarWriter writer(full_path, name, since, [](const book::DirWalker::Entry& entry) {
+        if (book::DeleteJobQueue::getInstance().isTrashPath(entry.path)) {
+            return false;
+        }
+        size_t length = entry.path.size();
+        return entry.dir || length < 5 || entry.path.compare(length - 5, 5, ".part") != 0;
+    });
+    book::ReadAhead reader([&writer](uint8_t* out, size_t capacity) { return writer.read(out, capacity); });
+    if (!reader.start()) {
+        sendErrorResponse(req, 500, "Out of memory");
         return ESP_OK;
     }
     
-    // 接收并写入文件
+    setCorsHeaders(req);
+    httpd_resp_set_type(req, "application/x-tar");
+    // 文件名只用 ASCII，非 ASCII 的目录名（中文书名）由客户端自行命名
+    bool ascii = std::all_of(name.begin(), name.end(), [](char c) { return c > 0x20 && c < 0x7F && c != '"'; });
+    std::string disposition = "attachment; filename=\"" + (ascii ? name : std::string("archive")) + ".tar\"";
+    httpd_resp_set_hdr(req, "Content-Disposition", disposition.c_str());
+    
+    int64_t start = esp_timer_get_time();
+    bool sent = true;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    while (reader.next(data, size)) {
+        esp_err_t ret = httpd_resp_send_chunk(req, (const char*)data, size);
+        reader.release();
+        if (ret != ESP_OK) {
+            mclog::tagError(TAG, "Failed to send archive chunk");
+            sent = false;
+            break;
+        }
+    }
+    reader.stop();
+    
+    const book::TarStats& stats = writer.stats();
+    book::ReadAheadStats io = reader.stats();
+    mclog::tagInfo(TAG, "Archive {}: {} files, {} dirs, {} skipped, {} errors, {} KB in {} ms", full_path, stats.files,
+                   stats.dirs, stats.skipped, stats.errors, io.bytes / 1024, (esp_timer_get_time() - start) / 1000);
+    mclog::tagInfo(TAG, "Archive read-ahead: reader waited {} times / {} ms, sender waited {} times / {} ms",
+                   io.readerStalls, io.readerStallUs / 1000, io.senderStalls, io.senderStallUs / 1000);
+    if (!sent) {
+        // 返回错误让服务器关闭连接，客户端不会把截断的流当作完整的 tar
+        return ESP_FAIL;
+    }
+    httpd_resp_send_chunk(req, nullptr, 0);
+    return ESP_OK;
+}
+
+// 把请求体写入 fp，边接收边计算 CRC32C，返回是否完整接收
+bool HttpFileServer::receiveToFile(httpd_req_t* req, FILE* fp, size_t& total_written, uint32_t& crc)
+{
     char* buffer = new char[FILE_BUFFER_SIZE];
     int remaining = req->content_len;
     int received;
-    size_t total_written = 0;
+    total_written = 0;
+    crc = 0;
     
     while (remaining > 0) {
         int to_read = std::min(remaining, (int)FILE_BUFFER_SIZE);
@@ -497,29 +682,223 @@ esp_err_t HttpFileServer::handlePostFile(httpd_req_t* req)
             break;
         }
         
+        crc = book::crc32c_update(crc, buffer, written);
         total_written += written;
         remaining -= received;
     }
     
     delete[] buffer;
+    return remaining == 0;
+}
+
+// 读取 X-Checksum 请求头（CRC32C，十六进制，可带 "crc32c=" 前缀），没有该请求头时 present 为 false
+bool HttpFileServer::getChecksumHeader(httpd_req_t* req, bool& present, uint32_t& expected)
+{
+    char value[32];
+    esp_err_t ret = httpd_req_get_hdr_value_str(req, "X-Checksum", value, sizeof(value));
+    present = ret != ESP_ERR_NOT_FOUND;
+    if (!present) {
+        return true;
+    }
+    return ret == ESP_OK && book::parse_crc32c(value, expected);
+}
+
+// POST /api/file?path=/path/to/file
+// 先写入 .part，完整接收且与 X-Checksum 一致后再替换原文件，失败时原文件不变
+esp_err_t HttpFileServer::handlePostFile(httpd_req_t* req)
+{
+    std::string path = getQueryParam(req, "path");
+    if (path.empty()) {
+        sendErrorResponse(req, 400, "Path parameter required");
+        return ESP_OK;
+    }
+    
+    bool has_checksum = false;
+    uint32_t expected_crc = 0;
+    if (!getChecksumHeader(req, has_checksum, expected_crc)) {
+        sendErrorResponse(req, 400, "Invalid X-Checksum header");
+        return ESP_OK;
+    }
+    
+    std::string full_path = SD_ROOT + path;
+    mclog::tagInfo(TAG, "POST /api/file path={}, size={}", full_path, req->content_len);
+    
+    // 自动创建父目录（如果不存在）
+    size_t last_slash = full_path.rfind('/');
+    if (last_slash != std::string::npos && last_slash > strlen(SD_ROOT)) {
+        std::string parent_dir = full_path.substr(0, last_slash);
+        struct stat st;
+        if (stat(parent_dir.c_str(), &st) != 0) {
+            if (!createDirectoryRecursive(parent_dir)) {
+                mclog::tagError(TAG, "Failed to create parent directory: {}", parent_dir);
+                sendErrorResponse(req, 500, "Failed to create parent directory");
+                return ESP_OK;
+            }
+        }
+    }
+    
+    // 覆盖已有文件时按新旧大小之差调整剩余空间
+    struct stat old_st;
+    bool had_old = stat(full_path.c_str(), &old_st) == 0;
+    uint64_t old_size = had_old ? (uint64_t)old_st.st_size : 0;
+    
+    std::string part_path = full_path + ".part";
+    FILE* fp = fopen(part_path.c_str(), "wb");
+    if (fp == nullptr) {
+        mclog::tagError(TAG, "Failed to create file: {} (errno={})", part_path, errno);
+        sendErrorResponse(req, 500, "Failed to create file");
+        return ESP_OK;
+    }
+    
+    size_t total_written = 0;
+    uint32_t crc = 0;
+    bool complete = receiveToFile(req, fp, total_written, crc);
     fclose(fp);
     
-    if (remaining > 0) {
+    if (!complete) {
         // 删除不完整的文件
-        remove(full_path.c_str());
+        remove(part_path.c_str());
         sendErrorResponse(req, 500, "File upload incomplete");
         return ESP_OK;
     }
+    if (has_checksum && crc != expected_crc) {
+        mclog::tagError(TAG, "Checksum mismatch: {} (expected {:08x}, got {:08x})", full_path, expected_crc, crc);
+        remove(part_path.c_str());
+        sendErrorResponse(req, 400, "Checksum mismatch");
+        return ESP_OK;
+    }
     
-    mclog::tagInfo(TAG, "File uploaded successfully: {} bytes", total_written);
+    // FAT 上 rename 不覆盖已有文件，先删除原文件
+    if (had_old) {
+        remove(full_path.c_str());
+    }
+    if (rename(part_path.c_str(), full_path.c_str()) != 0) {
+        mclog::tagError(TAG, "Failed to rename {} (errno={})", part_path, errno);
+        remove(part_path.c_str());
+        if (had_old) {
+            book::ChecksumSidecar::forget(full_path);
+            book::FreeSpaceCache::getInstance().fileChanged(old_size, 0);
+            book::FsEventBus::getInstance().publish(book::FsEventType::Removed, full_path);
+        }
+        sendErrorResponse(req, 500, "Failed to replace file");
+        return ESP_OK;
+    }
+    book::FreeSpaceCache::getInstance().fileChanged(old_size, total_written);
+    book::ChecksumSidecar::record(full_path, total_written, crc);
     
-    char json[128];
-    snprintf(json, sizeof(json), "{\"success\":true,\"path\":\"%s\",\"size\":%zu}", path.c_str(), total_written);
+    mclog::tagInfo(TAG, "File uploaded successfully: {} bytes, crc32c {:08x}", total_written, crc);
+    book::FsEventBus::getInstance().publish(book::FsEventType::Written, full_path);
+    
+    char json[384];
+    snprintf(json, sizeof(json), "{\"success\":true,\"path\":\"%s\",\"size\":%zu,\"crc32c\":\"%08x\"}", path.c_str(),
+             total_written, (unsigned)crc);
     sendJsonResponse(req, json);
     
     return ESP_OK;
 }
 
+// POST /api/upload?name=book.epub
+// .txt 直接放入书架目录；.epub 存入新书籍目录后由后台任务导入为纯文本书籍，立即返回 202
+esp_err_t HttpFileServer::handleUpload(httpd_req_t* req)
+{
+    std::string name = getQueryParam(req, "name");
+    size_t slash = name.find_last_of("/\\");
+    if (slash != std::string::npos) {
+        name = name.substr(slash + 1);
+    }
+    size_t dot = name.rfind('.');
+    if (name.empty() || dot == std::string::npos || dot == 0) {
+        sendErrorResponse(req, 400, "Name parameter required");
+        return ESP_OK;
+    }
+    std::string ext = name.substr(dot);
+    bool is_epub = strcasecmp(ext.c_str(), ".epub") == 0;
+    if (!is_epub && strcasecmp(ext.c_str(), ".txt") != 0) {
+        sendErrorResponse(req, 400, "Only .epub and .txt are supported");
+        return ESP_OK;
+    }
+    bool has_checksum = false;
+    uint32_t expected_crc = 0;
+    if (!getChecksumHeader(req, has_checksum, expected_crc)) {
+        sendErrorResponse(req, 400, "Invalid X-Checksum header");
+        return ESP_OK;
+    }
+    mclog::tagInfo(TAG, "POST /api/upload name={}, size={}", name, req->content_len);
+    
+    std::string books_dir = std::string(SD_ROOT) + BOOKS_DIR;
+    createDirectoryRecursive(books_dir);
+    
+    // 书籍ID：.txt 为文件名，.epub 为去掉扩展名的目录名；重名时追加序号
+    std::string stem = is_epub ? name.substr(0, dot) : name;
+    std::string book_id = stem;
+    struct stat st;
+    for (int n = 2; stat((books_dir + "/" + book_id).c_str(), &st) == 0; n++) {
+        book_id = is_epub ? stem + "_" + std::to_string(n)
+                          : name.substr(0, dot) + "_" + std::to_string(n) + ext;
+    }
+    
+    std::string book_path = books_dir + "/" + book_id;
+    std::string target = book_path;
+    if (is_epub) {
+        if (mkdir(book_path.c_str(), 0755) != 0) {
+            sendErrorResponse(req, 500, "Failed to create book directory");
+            return ESP_OK;
+        }
+        target = book_path + "/" + book::EPUB_SOURCE_FILE_NAME;
+    }
+    
+    // 先写入 .part，完整接收后再改名，书架不会看到一半的文件
+    std::string part_path = target + ".part";
+    FILE* fp = fopen(part_path.c_str(), "wb");
+    if (fp == nullptr) {
+        mclog::tagError(TAG, "Failed to create file: {} (errno={})", part_path, errno);
+        if (is_epub) rmdir(book_path.c_str());
+        sendErrorResponse(req, 500, "Failed to create file");
+        return ESP_OK;
+    }
+    size_t total_written = 0;
+    uint32_t crc = 0;
+    bool complete = receiveToFile(req, fp, total_written, crc);
+    fclose(fp);
+    
+    if (complete && has_checksum && crc != expected_crc) {
+        mclog::tagError(TAG, "Checksum mismatch: {} (expected {:08x}, got {:08x})", target, expected_crc, crc);
+        remove(part_path.c_str());
+        if (is_epub) rmdir(book_path.c_str());
+        sendErrorResponse(req, 400, "Checksum mismatch");
+        return ESP_OK;
+    }
+    if (!complete || rename(part_path.c_str(), target.c_str()) != 0) {
+        remove(part_path.c_str());
+        if (is_epub) rmdir(book_path.c_str());
+        sendErrorResponse(req, 500, "File upload incomplete");
+        return ESP_OK;
+    }
+    mclog::tagInfo(TAG, "Book uploaded: {} ({} bytes)", target, total_written);
+    if (is_epub) book::FreeSpaceCache::getInstance().dirChanged(true);
+    book::FreeSpaceCache::getInstance().fileChanged(0, total_written);
+    book::ChecksumSidecar::record(target, total_written, crc);
+    book::FsEventBus::getInstance().publish(is_epub ? book::FsEventType::DirCreated : book::FsEventType::Written, book_path);
+    
+    char json[384];
+    if (is_epub) {
+        book::write_epub_ingest_status(book_path, "queued", 0, 0, "");
+        book::EpubIngestQueue::getInstance().enqueue(book_path);
+        snprintf(json, sizeof(json), "{\"success\":true,\"bookId\":\"%s\",\"status\":\"%s/%s/%s\"}", book_id.c_str(),
+                 BOOKS_DIR, book_id.c_str(), book::EPUB_STATUS_FILE_NAME);
+        setCorsHeaders(req);
+        httpd_resp_set_status(req, "202 Accepted");
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_send(req, json, strlen(json));
+        return ESP_OK;
+    }
+    
+    snprintf(json, sizeof(json), "{\"success\":true,\"bookId\":\"%s\",\"size\":%zu}", book_id.c_str(),
+             total_written);
+    sendJsonResponse(req, json);
+    return ESP_OK;
+}
+
 // DELETE /api/file?path=/path/to/file
 esp_err_t HttpFileServer::handleDeleteFile(httpd_req_t* req)
 {
@@ -552,6 +931,13 @@ esp_err_t HttpFileServer::handleDeleteFile(httpd_req_t* req)
     }
     
     mclog::tagInfo(TAG, "Deleted successfully: {}", full_path);
+    if (S_ISDIR(st.st_mode)) {
+        book::FreeSpaceCache::getInstance().dirChanged(false);
+    } else {
+        book::FreeSpaceCache::getInstance().fileChanged(st.st_size, 0);
+        book::ChecksumSidecar::forget(full_path);
+    }
+    book::FsEventBus::getInstance().publish(S_ISDIR(st.st_mode) ? book::FsEventType::DirRemoved : book::FsEventType::Removed, full_path);
     
     char json[128];
     snprintf(json, sizeof(json), "{\"success\":true,\"path\":\"%s\"}", path.c_str());
@@ -580,6 +966,9 @@ esp_err_t HttpFileServer::handleMkdir(httpd_req_t* req)
     }
     
     mclog::tagInfo(TAG, "Directory created: {}", full_path);
+    // 可能一次建了多级目录
+    book::FreeSpaceCache::getInstance().invalidate();
+    book::FsEventBus::getInstance().publish(book::FsEventType::DirCreated, full_path);
     
     char json[128];
     snprintf(json, sizeof(json), "{\"success\":true,\"path\":\"%s\"}", path.c_str());
@@ -588,57 +977,8 @@ esp_err_t HttpFileServer::handleMkdir(httpd_req_t* req)
     return ESP_OK;
 }
 
-// 递归删除目录
-bool HttpFileServer::removeDirectoryRecursive(const std::string& path)
-{
-    DIR* dir = opendir(path.c_str());
-    if (dir == nullptr) {
-        return false;
-    }
-    
-    struct dirent* entry;
-    bool success = true;
-    
-    while ((entry = readdir(dir)) != nullptr) {
-        // 跳过 . 和 ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        std::string item_path = path + "/" + entry->d_name;
-        struct stat st;
-        
-        if (stat(item_path.c_str(), &st) != 0) {
-            success = false;
-            continue;
-        }
-        
-        if (S_ISDIR(st.st_mode)) {
-            // 递归删除子目录
-            if (!removeDirectoryRecursive(item_path)) {
-                success = false;
-            }
-        } else {
-            // 删除文件
-            if (remove(item_path.c_str()) != 0) {
-                mclog::tagError(TAG, "Failed to delete file: {}", item_path);
-                success = false;
-            }
-        }
-    }
-    
-    closedir(dir);
-    
-    // 删除空目录本身
-    if (rmdir(path.c_str()) != 0) {
-        mclog::tagError(TAG, "Failed to delete directory: {}", path);
-        success = false;
-    }
-    
-    return success;
-}
-
 // DELETE /api/rmdir?path=/path/to/dir - 递归删除目录
+// 目录改名为墓碑后立即返回 202，后台任务逐批删除，进度见 /api/jobs?id=
 esp_err_t HttpFileServer::handleRmdir(httpd_req_t* req)
 {
     std::string path = getQueryParam(req, "path");
@@ -656,6 +996,12 @@ esp_err_t HttpFileServer::handleRmdir(httpd_req_t* req)
     std::string full_path = SD_ROOT + path;
     mclog::tagInfo(TAG, "DELETE /api/rmdir path={}", full_path);
     
+    auto& jobs = book::DeleteJobQueue::getInstance();
+    if (jobs.isTrashPath(full_path)) {
+        sendErrorResponse(req, 400, "Cannot delete the trash directory");
+        return ESP_OK;
+    }
+    
     struct stat st;
     if (stat(full_path.c_str(), &st) != 0) {
         sendErrorResponse(req, 404, "Directory not found");
@@ -667,17 +1013,307 @@ esp_err_t HttpFileServer::handleRmdir(httpd_req_t* req)
         return ESP_OK;
     }
     
-    if (!removeDirectoryRecursive(full_path)) {
-        sendErrorResponse(req, 500, "Failed to delete directory completely");
+    uint32_t job_id = jobs.enqueue(full_path);
+    if (job_id == 0) {
+        mclog::tagError(TAG, "Failed to move {} to trash (errno={})", full_path, errno);
+        sendErrorResponse(req, 500, "Failed to delete directory");
         return ESP_OK;
     }
+    mclog::tagInfo(TAG, "Directory queued for deletion: {} (job {})", full_path, job_id);
+    book::FsEventBus::getInstance().publish(book::FsEventType::DirRemoved, full_path);
+    
+    char json[384];
+    snprintf(json, sizeof(json), "{\"success\":true,\"path\":\"%s\",\"jobId\":%u,\"status\":\"/api/jobs?id=%u\"}",
+             path.c_str(), (unsigned)job_id, (unsigned)job_id);
+    setCorsHeaders(req);
+    httpd_resp_set_status(req, "202 Accepted");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json, strlen(json));
     
-    mclog::tagInfo(TAG, "Directory deleted recursively: {}", full_path);
+    return ESP_OK;
+}
+
+static std::string formatDeleteJob(const book::DeleteJobStatus& job, const char* sd_root)
+{
+    // 原路径以 SD 卡根路径开头，返回客户端使用的路径
+    std::string path = job.path;
+    size_t root_len = strlen(sd_root);
+    if (path.compare(0, root_len, sd_root) == 0) path = path.substr(root_len);
+    
+    char json[384];
+    snprintf(json, sizeof(json), "{\"type\":\"delete\",\"id\":%u,\"path\":\"%s\",\"state\":\"%s\",\"files\":%u,\"dirs\":%u,\"errors\":%u}",
+             (unsigned)job.id, path.c_str(), job.state.c_str(), (unsigned)job.files, (unsigned)job.dirs,
+             (unsigned)job.errors);
+    return json;
+}
+
+static std::string formatCopyJob(const book::CopyJobStatus& job, const char* sd_root)
+{
+    size_t root_len = strlen(sd_root);
+    std::string from = job.from.compare(0, root_len, sd_root) == 0 ? job.from.substr(root_len) : job.from;
+    std::string to = job.to.compare(0, root_len, sd_root) == 0 ? job.to.substr(root_len) : job.to;
     
-    char json[128];
-    snprintf(json, sizeof(json), "{\"success\":true,\"path\":\"%s\"}", path.c_str());
+    char json[640];
+    snprintf(json, sizeof(json),
+             "{\"type\":\"copy\",\"id\":%u,\"from\":\"%s\",\"to\":\"%s\",\"state\":\"%s\",\"error\":\"%s\","
+             "\"files\":%u,\"totalFiles\":%u,\"dirs\":%u,\"errors\":%u,\"bytes\":%llu,\"totalBytes\":%llu}",
+             (unsigned)job.id, from.c_str(), to.c_str(), job.state.c_str(), job.error.c_str(), (unsigned)job.files,
+             (unsigned)job.totalFiles, (unsigned)job.dirs, (unsigned)job.errors, (unsigned long long)job.bytes,
+             (unsigned long long)job.totalBytes);
+    return json;
+}
+
+// GET /api/jobs?id=N&type=copy - 单个后台任务的状态（type 默认为 delete）；不带 id 时列出全部
+esp_err_t HttpFileServer::handleGetJobs(httpd_req_t* req)
+{
+    auto& jobs = book::DeleteJobQueue::getInstance();
+    auto& copies = book::CopyJobQueue::getInstance();
+    std::string id = getQueryParam(req, "id");
+    if (!id.empty()) {
+        uint32_t job_id = (uint32_t)strtoul(id.c_str(), nullptr, 10);
+        if (getQueryParam(req, "type") == "copy") {
+            book::CopyJobStatus job;
+            if (!copies.status(job_id, job)) {
+                sendErrorResponse(req, 404, "Job not found");
+                return ESP_OK;
+            }
+            sendJsonResponse(req, formatCopyJob(job, SD_ROOT).c_str());
+            return ESP_OK;
+        }
+        book::DeleteJobStatus job;
+        if (!jobs.status(job_id, job)) {
+            sendErrorResponse(req, 404, "Job not found");
+            return ESP_OK;
+        }
+        sendJsonResponse(req, formatDeleteJob(job, SD_ROOT).c_str());
+        return ESP_OK;
+    }
+    
+    std::string json = "{\"jobs\":[";
+    bool first = true;
+    for (const auto& job : jobs.jobs()) {
+        if (!first) json += ",";
+        json += formatDeleteJob(job, SD_ROOT);
+        first = false;
+    }
+    for (const auto& job : copies.jobs()) {
+        if (!first) json += ",";
+        json += formatCopyJob(job, SD_ROOT);
+        first = false;
+    }
+    json += "]}";
+    sendJsonResponse(req, json.c_str());
+    return ESP_OK;
+}
+
+// 移动 / 复制前规范化并检查源和目标，得到完整路径；返回错误信息，没有问题时返回 nullptr
+// 任何一方都不能是根目录或墓碑目录，目标不能是源本身或在源之内；目标的父目录不存在时创建
+const char* HttpFileServer::checkTransferPaths(const std::string& from_param, const std::string& to_param,
+                                               std::string& from, std::string& to, int& code)
+{
+    code = 400;
+    if (from_param.empty() || to_param.empty()) {
+        return "From and to parameters required";
+    }
+    if (!book::normalize_path(SD_ROOT, from_param, from) || !book::normalize_path(SD_ROOT, to_param, to)) {
+        return "Invalid path";
+    }
+    if (from == SD_ROOT || to == SD_ROOT) {
+        return "Cannot move or copy the root directory";
+    }
+    auto& trash = book::DeleteJobQueue::getInstance();
+    if (trash.isTrashPath(from) || trash.isTrashPath(to)) {
+        return "Cannot move or copy the trash directory";
+    }
+    if (book::path_within(to, from)) {
+        return "Destination is inside the source";
+    }
+    
+    struct stat st;
+    if (stat(from.c_str(), &st) != 0) {
+        code = 404;
+        return "Source not found";
+    }
+    if (stat(to.c_str(), &st) == 0) {
+        code = 409;
+        return "Destination exists";
+    }
+    std::string parent = to.substr(0, to.rfind('/'));
+    if (parent.size() > strlen(SD_ROOT) && stat(parent.c_str(), &st) != 0) {
+        if (!createDirectoryRecursive(parent)) {
+            code = 500;
+            return "Failed to create parent directory";
+        }
+        book::FreeSpaceCache::getInstance().invalidate();
+    }
+    return nullptr;
+}
+
+// POST /api/move?from=/books/a&to=/books/b - 移动或改名文件、目录
+// 同一卷内改名只改目录项，耗时与文件大小、目录中的文件数无关
+esp_err_t HttpFileServer::handleMove(httpd_req_t* req)
+{
+    std::string full_from, full_to;
+    int code = 0;
+    const char* invalid = checkTransferPaths(getQueryParam(req, "from"), getQueryParam(req, "to"), full_from,
+                                             full_to, code);
+    if (invalid) {
+        sendErrorResponse(req, code, invalid);
+        return ESP_OK;
+    }
+    mclog::tagInfo(TAG, "POST /api/move from={}, to={}", full_from, full_to);
+    // 返回规范化后客户端使用的路径
+    std::string from = full_from.substr(strlen(SD_ROOT));
+    std::string to = full_to.substr(strlen(SD_ROOT));
+    
+    struct stat st;
+    stat(full_from.c_str(), &st);
+    if (rename(full_from.c_str(), full_to.c_str()) != 0) {
+        mclog::tagError(TAG, "Failed to move {} (errno={})", full_from, errno);
+        sendErrorResponse(req, 500, "Failed to move");
+        return ESP_OK;
+    }
+    
+    // 目录的 .checksums 随目录一起移动；单个文件的记录移到目标目录
+    auto& bus = book::FsEventBus::getInstance();
+    if (S_ISDIR(st.st_mode)) {
+        bus.publish(book::FsEventType::DirRemoved, full_from);
+        bus.publish(book::FsEventType::DirCreated, full_to);
+    } else {
+        book::ChecksumSidecar::move(full_from, full_to);
+        bus.publish(book::FsEventType::Removed, full_from);
+        bus.publish(book::FsEventType::Written, full_to);
+    }
+    
+    char json[640];
+    snprintf(json, sizeof(json), "{\"success\":true,\"from\":\"%s\",\"to\":\"%s\"}", from.c_str(), to.c_str());
     sendJsonResponse(req, json);
+    return ESP_OK;
+}
+
+// POST /api/copy?from=/books/a&to=/books/b - 复制文件或目录
+// 在后台任务中 SD 卡到 SD 卡直接复制，立即返回 202，进度见 /api/jobs?type=copy&id=
+esp_err_t HttpFileServer::handleCopy(httpd_req_t* req)
+{
+    std::string full_from, full_to;
+    int code = 0;
+    const char* invalid = checkTransferPaths(getQueryParam(req, "from"), getQueryParam(req, "to"), full_from,
+                                             full_to, code);
+    if (invalid) {
+        sendErrorResponse(req, code, invalid);
+        return ESP_OK;
+    }
+    mclog::tagInfo(TAG, "POST /api/copy from={}, to={}", full_from, full_to);
+    // 返回规范化后客户端使用的路径
+    std::string from = full_from.substr(strlen(SD_ROOT));
+    std::string to = full_to.substr(strlen(SD_ROOT));
+    
+    uint32_t job_id = book::CopyJobQueue::getInstance().enqueue(full_from, full_to);
+    
+    char json[640];
+    snprintf(json, sizeof(json),
+             "{\"success\":true,\"from\":\"%s\",\"to\":\"%s\",\"jobId\":%u,"
+             "\"status\":\"/api/jobs?type=copy&id=%u\"}",
+             from.c_str(), to.c_str(), (unsigned)job_id, (unsigned)job_id);
+    setCorsHeaders(req);
+    httpd_resp_set_status(req, "202 Accepted");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json, strlen(json));
+    return ESP_OK;
+}
+
+// POST /api/sync/manifest?dir=/books/id
+// 请求体每行一个文件 "CRC32C 大小 相对路径"（与 .checksums 同格式），与写入时记录的校验和对照，
+// 边接收边比较、边分块返回需要上传的文件，内存与清单长度无关
+esp_err_t HttpFileServer::handleSyncManifest(httpd_req_t* req)
+{
+    std::string dir = getQueryParam(req, "dir");
+    if (dir.empty()) {
+        sendErrorResponse(req, 400, "Dir parameter required");
+        return ESP_OK;
+    }
+    std::string full_dir = SD_ROOT + dir;
+    mclog::tagInfo(TAG, "POST /api/sync/manifest dir={}, size={}", full_dir, req->content_len);
     
+    book::ManifestComparer comparer(full_dir);
+    uint32_t total = 0, unchanged = 0, missing = 0, changed = 0, invalid = 0;
+    uint64_t skip_bytes = 0, upload_bytes = 0;
+    
+    setCorsHeaders(req);
+    httpd_resp_set_type(req, "application/json");
+    std::string out = "{\"upload\":[";
+    bool first = true;
+    
+    auto process = [&](const std::string& line) {
+        if (line.empty()) return;
+        book::ManifestEntry entry;
+        if (!book::parse_manifest_line(line.c_str(), entry)) {
+            invalid++;
+            return;
+        }
+        total++;
+        book::ManifestState state = comparer.check(entry);
+        if (state == book::ManifestState::Unchanged) {
+            unchanged++;
+            skip_bytes += entry.size;
+            return;
+        }
+        if (state == book::ManifestState::Missing) {
+            missing++;
+        } else {
+            changed++;
+        }
+        upload_bytes += entry.size;
+        
+        if (!first) out += ",";
+        first = false;
+        out += "{\"path\":\"";
+        for (char c : entry.path) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        out += state == book::ManifestState::Missing ? "\",\"state\":\"missing\"}" : "\",\"state\":\"changed\"}";
+        if (out.size() > 1024) {
+            httpd_resp_send_chunk(req, out.data(), out.size());
+            out.clear();
+        }
+    };
+    
+    char buffer[1024];
+    std::string line;
+    int remaining = req->content_len;
+    while (remaining > 0) {
+        int received = httpd_req_recv(req, buffer, std::min(remaining, (int)sizeof(buffer)));
+        if (received <= 0) {
+            if (received == HTTPD_SOCK_ERR_TIMEOUT) {
+                continue;
+            }
+            break;
+        }
+        remaining -= received;
+        for (int i = 0; i < received; i++) {
+            if (buffer[i] == '\n') {
+                process(line);
+                line.clear();
+            } else if (line.size() < 512) {
+                line += buffer[i];
+            }
+        }
+    }
+    process(line);
+    
+    char tail[256];
+    snprintf(tail, sizeof(tail),
+             "],\"complete\":%s,\"total\":%u,\"unchanged\":%u,\"missing\":%u,\"changed\":%u,\"invalid\":%u,"
+             "\"skipBytes\":%llu,\"uploadBytes\":%llu}",
+             remaining == 0 ? "true" : "false", (unsigned)total, (unsigned)unchanged, (unsigned)missing,
+             (unsigned)changed, (unsigned)invalid, (unsigned long long)skip_bytes, (unsigned long long)upload_bytes);
+    out += tail;
+    httpd_resp_send_chunk(req, out.data(), out.size());
+    httpd_resp_send_chunk(req, nullptr, 0);
+    
+    mclog::tagInfo(TAG, "Manifest {}: {} files, {} unchanged ({} KB skipped), {} missing, {} changed", full_dir, total,
+                   unchanged, skip_bytes / 1024, missing, changed);
     return ESP_OK;
 }
 
@@ -761,8 +1397,47 @@ esp_err_t HttpFileServer::handleUploadBatch(httpd_req_t* req)
     std::string accumulated_data;
     std::string current_filename;
     FILE* current_file = nullptr;
+    uint64_t current_old_size = 0;  // 覆盖前的大小，用于调整剩余空间
+    bool current_had_old = false;
+    uint32_t current_crc = 0;
+    bool current_ok = true;  // 写入没有出错
+    std::string current_path;
     bool in_file_content = false;
     
+    // 每个文件先写 .part，收到下一个 boundary（文件完整）才替换原文件；连接中途断开时原文件和校验和记录不变
+    auto finish_file = [&]() {
+        long size = ftell(current_file);
+        current_ok = fclose(current_file) == 0 && current_ok && size >= 0;
+        current_file = nullptr;
+        std::string part_path = current_path + ".part";
+        if (!current_ok) {
+            mclog::tagError(TAG, "Failed to write file: {}", current_path);
+            remove(part_path.c_str());
+            return;
+        }
+        // FAT 上 rename 不覆盖已有文件，先删除原文件
+        if (current_had_old) {
+            remove(current_path.c_str());
+        }
+        if (rename(part_path.c_str(), current_path.c_str()) != 0) {
+            mclog::tagError(TAG, "Failed to rename {} (errno={})", part_path, errno);
+            remove(part_path.c_str());
+            if (current_had_old) {
+                book::ChecksumSidecar::forget(current_path);
+                book::FreeSpaceCache::getInstance().fileChanged(current_old_size, 0);
+                book::FsEventBus::getInstance().publish(book::FsEventType::Removed, current_path);
+            }
+            return;
+        }
+        book::FreeSpaceCache::getInstance().fileChanged(current_old_size, size);
+        book::ChecksumSidecar::record(current_path, size, current_crc);
+        book::FsEventBus::getInstance().publish(book::FsEventType::Written, current_path);
+        
+        if (file_count > 0) json_result += ",";
+        json_result += "\"" + current_filename + "\"";
+        file_count++;
+    };
+    
     while (remaining > 0) {
         int to_read = std::min(remaining, (int)buf_size);
         int received = httpd_req_recv(req, buffer, to_read);
@@ -843,7 +1518,13 @@ esp_err_t HttpFileServer::handleUploadBatch(httpd_req_t* req)
                         
                         mclog::tagInfo(TAG, "Receiving file: {}", file_path);
                         
-                        current_file = fopen(file_path.c_str(), "wb");
+                        struct stat old_st;
+                        current_had_old = stat(file_path.c_str(), &old_st) == 0 && S_ISREG(old_st.st_mode);
+                        current_old_size = current_had_old ? (uint64_t)old_st.st_size : 0;
+                        current_file = fopen((file_path + ".part").c_str(), "wb");
+                        current_crc = 0;
+                        current_ok = true;
+                        current_path = file_path;
                         if (current_file) {
                             in_file_content = true;
                         } else {
@@ -866,16 +1547,13 @@ esp_err_t HttpFileServer::handleUploadBatch(httpd_req_t* req)
                     }
                     
                     if (current_file && content_end > 0) {
-                        fwrite(accumulated_data.data(), 1, content_end, current_file);
+                        size_t written = fwrite(accumulated_data.data(), 1, content_end, current_file);
+                        current_ok = current_ok && written == content_end;
+                        current_crc = book::crc32c_update(current_crc, accumulated_data.data(), content_end);
                     }
                     
                     if (current_file) {
-                        fclose(current_file);
-                        current_file = nullptr;
-                        
-                        if (file_count > 0) json_result += ",";
-                        json_result += "\"" + current_filename + "\"";
-                        file_count++;
+                        finish_file();
                     }
                     
                     in_file_content = false;
@@ -886,7 +1564,9 @@ esp_err_t HttpFileServer::handleUploadBatch(httpd_req_t* req)
                                       accumulated_data.length() - boundary.length() - 2 : 0;
                     
                     if (current_file && safe_len > 0) {
-                        fwrite(accumulated_data.data(), 1, safe_len, current_file);
+                        size_t written = fwrite(accumulated_data.data(), 1, safe_len, current_file);
+                        current_ok = current_ok && written == safe_len;
+                        current_crc = book::crc32c_update(current_crc, accumulated_data.data(), safe_len);
                         accumulated_data = accumulated_data.substr(safe_len);
                     }
                     break;
@@ -895,12 +1575,12 @@ esp_err_t HttpFileServer::handleUploadBatch(httpd_req_t* req)
         }
     }
     
-    // 关闭任何未关闭的文件
+    // 没等到 boundary 连接就断了：最后一个文件不完整，丢弃 .part，不算上传成功
     if (current_file) {
+        mclog::tagError(TAG, "Upload interrupted, discarding incomplete file: {}", current_path);
         fclose(current_file);
-        if (file_count > 0) json_result += ",";
-        json_result += "\"" + current_filename + "\"";
-        file_count++;
+        remove((current_path + ".part").c_str());
+        current_file = nullptr;
     }
     
     delete[] buffer;
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <esp_http_server.h>
+#include <cstdio>
 #include <string>
 
 /**
@@ -15,11 +16,17 @@
  * - GET  /api/info              - 获取设备信息
  * - GET  /api/list?path=        - 列出目录内容
  * - GET  /api/file?path=        - 下载文件
- * - POST /api/file?path=        - 上传文件
+ * - GET  /api/archive?path=&since= - 目录打包为 tar 流式下载(since 为 Unix 秒，增量备份)
+ * - POST /api/file?path=        - 上传文件(可带 X-Checksum: CRC32C，替换前校验)
  * - DELETE /api/file?path=      - 删除文件
  * - POST /api/mkdir?path=       - 创建目录
- * - DELETE /api/rmdir?path=     - 递归删除目录
+ * - DELETE /api/rmdir?path=     - 递归删除目录(后台删除，返回 202)
+ * - POST /api/move?from=&to=    - 移动或改名文件、目录(同卷改名)
+ * - POST /api/copy?from=&to=    - 复制文件或目录(后台复制，返回 202)
+ * - GET  /api/jobs?id=&type=    - 后台删除 / 复制任务状态
+ * - POST /api/sync/manifest?dir= - 对照文件清单(每行 "CRC32C 大小 路径")，返回需要上传的文件
  * - POST /api/upload-batch?dir= - 批量上传文件(multipart/form-data)
+ * - POST /api/upload?name=      - 上传书籍(.txt / .epub，EPUB 在后台导入)
  */
 class HttpFileServer {
 public:
@@ -74,7 +81,13 @@ private:
     static esp_err_t handleDeleteFile(httpd_req_t* req);
     static esp_err_t handleMkdir(httpd_req_t* req);
     static esp_err_t handleRmdir(httpd_req_t* req);
+    static esp_err_t handleGetJobs(httpd_req_t* req);
+    static esp_err_t handleGetArchive(httpd_req_t* req);
+    static esp_err_t handleMove(httpd_req_t* req);
+    static esp_err_t handleCopy(httpd_req_t* req);
+    static esp_err_t handleSyncManifest(httpd_req_t* req);
     static esp_err_t handleUploadBatch(httpd_req_t* req);
+    static esp_err_t handleUpload(httpd_req_t* req);
     static esp_err_t handleCors(httpd_req_t* req);
     
     // 辅助函数
@@ -82,6 +95,9 @@ private:
     static void sendJsonResponse(httpd_req_t* req, const char* json);
     static void sendErrorResponse(httpd_req_t* req, int code, const char* message);
     static void setCorsHeaders(httpd_req_t* req);
-    static bool removeDirectoryRecursive(const std::string& path);
+    static bool receiveToFile(httpd_req_t* req, FILE* fp, size_t& total_written, uint32_t& crc);
+    static bool getChecksumHeader(httpd_req_t* req, bool& present, uint32_t& expected);
     static bool createDirectoryRecursive(const std::string& path);
+    static const char* checkTransferPaths(const std::string& from_param, const std::string& to_param,
+                                          std::string& from, std::string& to, int& code);
 };
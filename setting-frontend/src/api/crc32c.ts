@@ -0,0 +1,28 @@
+/**
+ * CRC32C (Castagnoli) 校验
+ * 与设备文件服务器写入时记录的校验和一致，用于增量同步清单
+ */
+
+const TABLE = (() => {
+  const table = new Uint32Array(256);
+  for (let i = 0; i < 256; i++) {
+    let crc = i;
+    for (let j = 0; j < 8; j++) {
+      crc = crc & 1 ? (crc >>> 1) ^ 0x82f63b78 : crc >>> 1;
+    }
+    table[i] = crc >>> 0;
+  }
+  return table;
+})();
+
+export function crc32c(data: Uint8Array, crc = 0): number {
+  crc = ~crc >>> 0;
+  for (let i = 0; i < data.length; i++) {
+    crc = TABLE[(crc ^ data[i]) & 0xff] ^ (crc >>> 8);
+  }
+  return ~crc >>> 0;
+}
+
+export async function crc32cBlob(blob: Blob): Promise<number> {
+  return crc32c(new Uint8Array(await blob.arrayBuffer()));
+}
@@ -3,6 +3,8 @@
  * 基于 HTTP REST API 与设备通信
  */
 
+import { crc32cBlob } from './crc32c';
+
 // ============ 类型定义 ============
 
 export type ConnectionType = 'http';
@@ -236,16 +238,20 @@ class HttpDeviceClient implements IDeviceClient {
       }
     }
     
-    // 3. 使用批量上传
+    // 3. 与设备上已有的文件对照（重新转换同一本书时只上传变化的页面）
+    onProgress?.('对照文件', 5);
+    const pending = await this.syncManifest(bookPath, filesToUpload);
+    
+    // 4. 使用批量上传
     onProgress?.('上传文件', 10);
     
     // 分批上传，每批最多40个文件（优化后的图片更小，设备buffer已增大）
     const BATCH_SIZE = 40;
-    const totalFiles = filesToUpload.length;
+    const totalFiles = pending.length;
     let uploadedFiles = 0;
     
-    for (let i = 0; i < filesToUpload.length; i += BATCH_SIZE) {
-      const batch = filesToUpload.slice(i, i + BATCH_SIZE);
+    for (let i = 0; i < pending.length; i += BATCH_SIZE) {
+      const batch = pending.slice(i, i + BATCH_SIZE);
       
       const formData = new FormData();
       for (const file of batch) {
@@ -269,7 +275,7 @@ class HttpDeviceClient implements IDeviceClient {
       onProgress?.('上传文件', percent);
     }
     
-    // 4. 处理链接目标解析
+    // 5. 处理链接目标解析
     onProgress?.('处理链接信息', 85);
     
     // 构建锚点映射
@@ -293,7 +299,7 @@ class HttpDeviceClient implements IDeviceClient {
       }
     }
     
-    // 5. 上传每个章节的 links.json（包含页面元数据）
+    // 6. 上传每个章节的 links.json（包含页面元数据）
     onProgress?.('上传页面元数据', 90);
     
     for (const section of sections) {
@@ -313,7 +319,7 @@ class HttpDeviceClient implements IDeviceClient {
       }
     }
     
-    // 6. 创建 metadata.json
+    // 7. 创建 metadata.json
     onProgress?.('保存元数据', 95);
     
     const metadata: any = {
@@ -357,11 +363,50 @@ class HttpDeviceClient implements IDeviceClient {
     }
   }
 
+  /**
+   * 把文件清单（每行 "CRC32C 大小 相对路径"）发给设备，返回设备上缺失或内容不同的文件；
+   * 设备不支持或对照失败时返回全部文件
+   */
+  private async syncManifest(
+    dir: string,
+    files: Array<{ path: string; blob: Blob }>
+  ): Promise<Array<{ path: string; blob: Blob }>> {
+    try {
+      const lines: string[] = [];
+      for (const file of files) {
+        const crc = await crc32cBlob(file.blob);
+        lines.push(`${crc.toString(16).padStart(8, '0')} ${file.blob.size} ${file.path}`);
+      }
+      
+      const response = await fetch(
+        `${this.baseUrl}/api/sync/manifest?dir=${encodeURIComponent(dir)}`,
+        {
+          method: 'POST',
+          headers: { 'Content-Type': 'text/plain' },
+          body: lines.join('\n'),
+        }
+      );
+      if (!response.ok) return files;
+      
+      const result = await response.json();
+      if (!result.complete) return files;
+      const upload = new Set<string>(result.upload.map((item: { path: string }) => item.path));
+      console.log(`增量同步: ${result.unchanged}/${result.total} 个文件未变化，跳过 ${result.skipBytes} 字节`);
+      return files.filter(file => upload.has(file.path));
+    } catch (e) {
+      console.warn('文件清单对照失败，全部上传:', e);
+      return files;
+    }
+  }
+
   private async uploadFile(blob: Blob, path: string): Promise<void> {
+    // 设备接收完整后核对 CRC32C，不一致时保留原文件并返回 400
+    const crc = await crc32cBlob(blob);
     const response = await fetch(
       `${this.baseUrl}/api/file?path=${encodeURIComponent(path)}`,
       {
         method: 'POST',
+        headers: { 'X-Checksum': `crc32c=${crc.toString(16).padStart(8, '0')}` },
         body: blob,
       }
     );
@@ -0,0 +1,225 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "read_ahead.h"
+#include "tar_archive.h"
+#include "bench_util.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace book;
+
+static void write_file(const std::string& path, size_t size, std::mt19937& rng)
+{
+    std::vector<uint8_t> data(size);
+    for (auto& b : data) b = (uint8_t)rng();
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, size, f);
+    fclose(f);
+}
+
+static std::string read_file(const std::string& path)
+{
+    std::string data;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return "<missing>";
+    char buffer[8192];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) data.append(buffer, n);
+    fclose(f);
+    return data;
+}
+
+// 与文件服务器相同的过滤：跳过上传一半的 .part
+static bool keep(const DirWalker::Entry& entry)
+{
+    size_t length = entry.path.size();
+    return entry.dir || length < 5 || entry.path.compare(length - 5, 5, ".part") != 0;
+}
+
+// 经过预读缓冲把整个 tar 流写入 out；readMBps / sendMBps 大于 0 时按该速度模拟读卡和发送
+static double stream(const std::string& root, const std::string& out, int64_t since, int chunks, double readMBps,
+                     double sendMBps, ReadAheadStats& io)
+{
+    TarWriter writer(root, "library", since, keep);
+    ReadAhead reader(
+        [&](uint8_t* buffer, size_t capacity) {
+            size_t n = writer.read(buffer, capacity);
+            if (readMBps > 0) std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(n / readMBps)));
+            return n;
+        },
+        READ_AHEAD_CHUNK_SIZE, chunks);
+    FILE* f    = fopen(out.c_str(), "wb");
+    auto start = Clock::now();
+    reader.start();
+    const uint8_t* data;
+    size_t size;
+    while (reader.next(data, size)) {
+        fwrite(data, 1, size, f);
+        if (sendMBps > 0) std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(size / sendMBps)));
+        reader.release();
+    }
+    double ms = elapsed_ms(start);
+    fclose(f);
+    io = reader.stats();
+    return ms;
+}
+
+int main(int argc, char** argv)
+{
+    std::string dir = "/tmp/archive_bench";
+    int books       = 3;
+    int pages       = 120;
+    double readMBps = 2.0;
+    double sendMBps = 1.5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--dir" && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (arg == "--books" && i + 1 < argc) {
+            books = atoi(argv[++i]);
+        } else if (arg == "--pages" && i + 1 < argc) {
+            pages = atoi(argv[++i]);
+        } else if (arg == "--read-mbps" && i + 1 < argc) {
+            readMBps = atof(argv[++i]);
+        } else if (arg == "--send-mbps" && i + 1 < argc) {
+            sendMBps = atof(argv[++i]);
+        } else {
+            printf("Usage: %s [--dir PATH] [--books N] [--pages N] [--read-mbps R] [--send-mbps S]\n", argv[0]);
+            printf("\n");
+            printf("  Builds --books books of --pages pages under --dir, streams them as a tar through the\n");
+            printf("  read-ahead buffer and unpacks the result with the system tar to compare every file.\n");
+            printf("  Then times the same stream with the card throttled to R MB/s and the socket to S MB/s,\n");
+            printf("  with and without read-ahead, and checks the since filter. --dir is wiped first.\n");
+            return 1;
+        }
+    }
+
+    remove_tree(dir);
+    mkdir(dir.c_str(), 0755);
+    std::string root = dir + "/books";
+    mkdir(root.c_str(), 0755);
+
+    std::mt19937 rng(1);
+    std::vector<std::string> files;
+    for (int b = 0; b < books; b++) {
+        std::string book = root + "/book" + std::to_string(b);
+        mkdir(book.c_str(), 0755);
+        mkdir((book + "/sections").c_str(), 0755);
+        for (int p = 0; p < pages; p++) {
+            std::string section = book + "/sections/" + std::to_string(p / 40);
+            mkdir(section.c_str(), 0755);
+            std::string path = section + "/" + std::to_string(p % 40) + ".png";
+            write_file(path, 1000 + rng() % 30000, rng);
+            files.push_back(path);
+        }
+        write_file(book + "/metadata.json", 511, rng);
+        files.push_back(book + "/metadata.json");
+    }
+    write_file(root + "/empty.txt", 0, rng);
+    files.push_back(root + "/empty.txt");
+    write_file(root + "/book0/cover.png.part", 100, rng);
+
+    // 超过 ustar 100 字节名字的路径：能拆进 prefix 的，和只能用 GNU 长文件名的
+    std::string deep = root + "/" + std::string(60, 'd') + "/" + std::string(60, 'e');
+    mkdir((root + "/" + std::string(60, 'd')).c_str(), 0755);
+    mkdir(deep.c_str(), 0755);
+    write_file(deep + "/page.png", 700, rng);
+    files.push_back(deep + "/page.png");
+    std::string wide = root + "/" + std::string(150, 'w');
+    mkdir(wide.c_str(), 0755);
+    write_file(wide + "/" + std::string(120, 'n') + ".png", 900, rng);
+    files.push_back(wide + "/" + std::string(120, 'n') + ".png");
+
+    // 1. 不限速，解包核对
+    std::string tarPath = dir + "/out.tar";
+    ReadAheadStats io;
+    double fastMs = stream(root, tarPath, 0, READ_AHEAD_CHUNKS, 0, 0, io);
+    std::string unpack = dir + "/unpack";
+    mkdir(unpack.c_str(), 0755);
+    std::string cmd = "tar -xf " + tarPath + " -C " + unpack + " 2>&1";
+    bool ok         = system(cmd.c_str()) == 0;
+    int mismatches  = 0;
+    for (const auto& path : files) {
+        std::string copy = unpack + "/library" + path.substr(root.size());
+        if (read_file(path) != read_file(copy)) mismatches++;
+    }
+    struct stat st;
+    bool partSkipped = stat((unpack + "/library/book0/cover.png.part").c_str(), &st) != 0;
+    stat(tarPath.c_str(), &st);
+    ok = ok && mismatches == 0 && partSkipped;
+    printf("unpack:    %zu files, %.1f MB tar in %.1f ms unthrottled, %d mismatches, .part skipped: %s\n",
+           files.size(), st.st_size / 1048576.0, fastMs, mismatches, ok ? "ok" : "FAILED");
+
+    // 2. 限速：同步（一块，读完再发）与预读（三块）
+    double syncMs = stream(root, tarPath, 0, 1, readMBps, sendMBps, io);
+    double aheadMs = stream(root, tarPath, 0, READ_AHEAD_CHUNKS, readMBps, sendMBps, io);
+    double ideal   = st.st_size / 1048576.0 / std::min(readMBps, sendMBps) * 1000;
+    printf("throttled: card %.1f MB/s, socket %.1f MB/s: synchronous %.0f ms, read-ahead %.0f ms (%.0f%% faster,"
+           " bound %.0f ms)\n",
+           readMBps, sendMBps, syncMs, aheadMs, 100.0 * (syncMs - aheadMs) / syncMs, ideal);
+    printf("           read-ahead stalls: reader %u, sender %u over %u chunks\n", io.readerStalls, io.senderStalls,
+           io.chunks);
+
+    // 3. since：把两个文件改到未来，只应打包这两个
+    int64_t since = (int64_t)time(nullptr) + 3600;
+    struct utimbuf times = {(time_t)since, (time_t)since};
+    utime(files[5].c_str(), &times);
+    utime(files[files.size() - 1].c_str(), &times);
+    stream(root, tarPath, since, READ_AHEAD_CHUNKS, 0, 0, io);
+    cmd          = "tar -tf " + tarPath;
+    FILE* pipe   = popen(cmd.c_str(), "r");
+    int listed   = 0;
+    char line[1024];
+    while (pipe && fgets(line, sizeof(line), pipe)) listed++;
+    bool sinceOk = pipe && pclose(pipe) == 0 && listed == 2;
+    printf("since:     %d entries in the incremental archive: %s\n", listed, sinceOk ? "ok" : "FAILED");
+    ok = ok && sinceOk;
+
+    // 4. 8GB 以上的文件：大小字段放不下 11 位八进制，应写成 base-256（稀疏文件，只读条目头）
+    {
+        std::string large = dir + "/large";
+        mkdir(large.c_str(), 0755);
+        uint64_t largeSize = (8ULL << 30) + 12345;
+        FILE* f            = fopen((large + "/huge.bin").c_str(), "wb");
+        bool sparse        = f && ftruncate(fileno(f), (off_t)largeSize) == 0;
+        if (f) fclose(f);
+        TarWriter writer(large, "large", 0, keep);
+        uint8_t header[TAR_BLOCK_SIZE];
+        size_t n         = writer.read(header, sizeof(header));
+        uint64_t decoded = 0;
+        for (int i = 1; i < 12; i++) decoded = (decoded << 8) | header[124 + i];
+        bool base256 = !sparse || (n == sizeof(header) && header[124] == 0x80 && decoded == largeSize);
+        printf("large:     %s: %s\n", sparse ? "8GB size written as base-256" : "sparse file not supported, skipped",
+               base256 ? "ok" : "FAILED");
+        ok = ok && base256;
+    }
+
+    // 5. 提前停止：发送方中途断开，读卡任务必须退出
+    {
+        TarWriter writer(root, "library", 0, keep);
+        ReadAhead reader([&](uint8_t* buffer, size_t capacity) { return writer.read(buffer, capacity); });
+        reader.start();
+        const uint8_t* data;
+        size_t size;
+        reader.next(data, size);
+        reader.release();
+        reader.stop();
+        printf("cancel:    stopped after one chunk: ok\n");
+    }
+
+    remove_tree(dir);
+    return ok ? 0 : 1;
+}
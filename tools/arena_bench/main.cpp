@@ -0,0 +1,176 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "app_arena.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Op {
+    bool alloc  = true;
+    size_t size = 0;
+    size_t slot = 0;  // 块在 live 表中的位置
+};
+
+// 模拟书架应用一次打开到关闭：帧缓冲和灰度带常驻，翻页时申请释放页面数据和封面，
+// 夹杂大量短命的小对象（JSON 读入缓冲、路径、容器增长），最后漏掉 leak 个块
+static std::vector<Op> make_session(size_t pages, size_t leak, uint32_t seed, size_t& slots)
+{
+    std::mt19937 rng(seed);
+    std::vector<Op> ops;
+    std::vector<size_t> live;
+    slots = 0;
+
+    auto alloc = [&](size_t size) {
+        ops.push_back({true, size, slots});
+        live.push_back(slots++);
+    };
+    auto free_at = [&](size_t i) {
+        ops.push_back({false, 0, live[i]});
+        live.erase(live.begin() + i);
+    };
+
+    alloc(540 * 960 / 2);  // 帧缓冲
+    alloc(540 * 960 / 2);  // 后台缓冲
+    alloc(16 * 1024);      // 灰度带
+    for (size_t p = 0; p < pages; p++) {
+        alloc(20 * 1024 + rng() % (100 * 1024));  // 页面数据
+        if (rng() % 8 == 0) alloc(30 * 1024 + rng() % (60 * 1024));  // 封面
+        for (int k = 0; k < 40; k++) {
+            alloc(16 + rng() % 400);
+            if (live.size() > 4 && rng() % 3) free_at(3 + rng() % (live.size() - 3));
+        }
+        while (live.size() > 24) free_at(3 + rng() % (live.size() - 3));
+    }
+    while (live.size() > leak) free_at(rng() % live.size());
+    return ops;
+}
+
+struct RunResult {
+    double ms      = 0;
+    uint32_t slabs = 0;  // 整体释放前
+    book::ArenaStats stats;
+};
+
+static RunResult run_arena(const std::vector<Op>& ops, size_t slots, size_t sessions)
+{
+    RunResult result;
+    std::vector<void*> ptrs(slots);
+    auto start = Clock::now();
+    for (size_t s = 0; s < sessions; s++) {
+        book::AppArena arena("bench");
+        for (const auto& op : ops) {
+            if (op.alloc) {
+                ptrs[op.slot] = arena.alloc(op.size);
+                memset(ptrs[op.slot], 0, std::min<size_t>(op.size, 64));
+            } else {
+                arena.free(ptrs[op.slot]);
+            }
+        }
+        result.slabs = arena.stats().slabs;
+        arena.release();
+        result.stats = arena.stats();
+    }
+    result.ms = elapsed_ms(start);
+    return result;
+}
+
+static double run_malloc(const std::vector<Op>& ops, size_t slots, size_t sessions)
+{
+    std::vector<void*> ptrs(slots, nullptr);
+    auto start = Clock::now();
+    for (size_t s = 0; s < sessions; s++) {
+        std::vector<bool> freed(slots, false);
+        for (const auto& op : ops) {
+            if (op.alloc) {
+                ptrs[op.slot] = malloc(op.size);
+                memset(ptrs[op.slot], 0, std::min<size_t>(op.size, 64));
+            } else {
+                free(ptrs[op.slot]);
+                freed[op.slot] = true;
+            }
+        }
+        // 没有整体释放，漏掉的块要逐个找出来
+        for (size_t i = 0; i < slots; i++) {
+            if (!freed[i]) free(ptrs[i]);
+        }
+    }
+    return elapsed_ms(start);
+}
+
+int main(int argc, char** argv)
+{
+    size_t pages    = 400;
+    size_t sessions = 50;
+    size_t leak     = 5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--pages" && i + 1 < argc) {
+            pages = (size_t)atol(argv[++i]);
+        } else if (arg == "--sessions" && i + 1 < argc) {
+            sessions = (size_t)atol(argv[++i]);
+        } else if (arg == "--leak" && i + 1 < argc) {
+            leak = (size_t)atol(argv[++i]);
+        } else {
+            printf("Usage: %s [--pages N] [--sessions N] [--leak N]\n", argv[0]);
+            printf("\n");
+            printf("  Replays a synthetic reader session (resident frame buffers, per-page data and covers,\n");
+            printf("  short-lived small objects) --sessions times against an AppArena and against malloc,\n");
+            printf("  leaving --leak blocks unfreed each time. Reports time, peak and reserved bytes, checks\n");
+            printf("  that release() reclaims the leaked blocks, and that double frees are rejected.\n");
+            return 1;
+        }
+    }
+    if (sessions == 0) return 1;
+
+    size_t slots = 0;
+    auto ops     = make_session(pages, leak, 1, slots);
+    size_t allocs = 0;
+    size_t small  = 0;
+    for (const auto& op : ops) {
+        if (!op.alloc) continue;
+        allocs++;
+        if (op.size + 8 <= book::ARENA_SMALL_MAX) small++;
+    }
+    printf("session:   %zu allocations (%zu small), %zu pages, %zu blocks leaked\n", allocs, small, pages, leak);
+
+    RunResult arena = run_arena(ops, slots, sessions);
+    double mallocMs = run_malloc(ops, slots, sessions);
+    const auto& st  = arena.stats;
+    printf("arena:     %.3f ms/session, malloc %.3f ms/session\n", arena.ms / sessions, mallocMs / sessions);
+    printf("usage:     peak %.1f KB held, %.1f KB reserved (%.1f%% overhead), %u slabs before release\n",
+           st.peak / 1024.0, st.reservedPeak / 1024.0, 100.0 * (st.reservedPeak - st.peak) / st.peak, arena.slabs);
+    bool reclaimed = st.leakedBlocks == leak && st.current == 0 && st.reserved == 0 && st.failures == 0;
+    printf("release:   %u blocks / %.1f KB leaked and reclaimed, %s\n", st.leakedBlocks, st.leakedBytes / 1024.0,
+           reclaimed ? "ok" : "FAILED");
+
+    // 重复释放、外来指针、ArenaVector
+    book::AppArena arena2("check");
+    void* a   = arena2.alloc(40);
+    void* b   = arena2.alloc(100 * 1024);
+    int other = 0;
+    arena2.free(a);
+    arena2.free(a);
+    arena2.free((uint8_t*)&other + 4);
+    bool reused = arena2.alloc(40) == a;
+    arena2.free(b);
+    {
+        book::ArenaVector<uint32_t> v{book::ArenaAllocator<uint32_t>(arena2)};
+        for (uint32_t i = 0; i < 100000; i++) v.push_back(i);
+        reused = reused && v[99999] == 99999 && arena2.stats().largeBlocks == 1;
+    }
+    auto st2     = arena2.stats();
+    bool checked = reused && st2.badFrees == 2 && st2.largeBlocks == 0 && st2.smallObjects == 1;
+    printf("checks:    double free and foreign pointer rejected (%u), slot reuse, ArenaVector: %s\n", st2.badFrees,
+           checked ? "ok" : "FAILED");
+
+    return reclaimed && checked ? 0 : 1;
+}
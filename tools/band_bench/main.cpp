@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "band_decoder.h"
+#include "band_encoder.h"
+#include "gray_png.h"
+#include "png_codec.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Page {
+    GrayImage image;
+    std::vector<uint8_t> png;
+    std::vector<uint8_t> banded;
+};
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s <book_dir> [band_height] [iterations] [max_threads]\n", argv[0]);
+        printf("\n");
+        printf("  Re-encodes the page PNGs of a compiled book as banded pages and decodes every page\n");
+        printf("  with 1, 2, 4 ... max_threads threads, reporting wall-clock time and speedup.\n");
+        return 1;
+    }
+    int bandHeight = argc > 2 ? std::max(10, std::min(900, atoi(argv[2]))) : 150;
+    int iterations = argc > 3 ? std::max(1, atoi(argv[3])) : 5;
+    int maxThreads = argc > 4 ? std::max(1, atoi(argv[4])) : std::max(2, (int)std::thread::hardware_concurrency());
+
+    std::vector<Page> pages;
+    for (const auto& entry : fs::recursive_directory_iterator(argv[1])) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".png" || entry.path().filename() == "cover.png") {
+            continue;
+        }
+        std::string error;
+        Page page;
+        page.image = read_png_gray(entry.path().string(), &error);
+        if (page.image.empty()) {
+            fprintf(stderr, "Skip %s: %s\n", entry.path().c_str(), error.c_str());
+            continue;
+        }
+        int depth   = detect_bit_depth(page.image);
+        page.png    = encode_png_gray(page.image, 9, depth);
+        page.banded = encode_band_page(page.image, depth, bandHeight);
+        pages.push_back(std::move(page));
+    }
+    if (pages.empty()) {
+        fprintf(stderr, "No PNG pages found under %s\n", argv[1]);
+        return 1;
+    }
+
+    uint64_t pngBytes = 0, bandBytes = 0;
+    for (const auto& page : pages) {
+        pngBytes += page.png.size();
+        bandBytes += page.banded.size();
+    }
+
+    // 基线：整页 PNG 单线程流式解码
+    std::vector<uint8_t> frame;
+    volatile uint32_t sink = 0;
+    auto start             = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (const auto& page : pages) {
+            book::decode_gray_png(page.png.data(), page.png.size(), [&](int, const uint8_t* gray, int) {
+                sink = sink + gray[0];
+                return true;
+            });
+        }
+    }
+    double baseMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations / pages.size();
+
+    printf("pages: %zu, %d px bands, %u hardware threads\n", pages.size(), bandHeight,
+           std::thread::hardware_concurrency());
+    printf("size: whole-page PNG %.1f KB, banded %.1f KB (%+.1f%%)\n\n", pngBytes / 1024.0, bandBytes / 1024.0,
+           (double)bandBytes * 100.0 / pngBytes - 100.0);
+    printf("%-24s %12s %10s %16s\n", "decoder", "ms / page", "speedup", "bands / thread");
+    printf("%-24s %12.3f %10s %16s\n", "whole-page PNG", baseMs, "-", "-");
+
+    double singleMs = 0;
+    int mismatches  = 0;
+    std::vector<int> threadCounts;
+    for (int n = 1; n < maxThreads; n *= 2) threadCounts.push_back(n);
+    threadCounts.push_back(maxThreads);
+
+    for (int threads : threadCounts) {
+        book::BandDecoder decoder;
+        decoder.start(threads);
+
+        std::vector<uint64_t> perThread(decoder.workers(), 0);
+        start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            for (const auto& page : pages) {
+                frame.resize(page.image.pixels.size());
+                if (!decoder.decode(page.banded.data(), page.banded.size(), frame.data(), frame.size())) {
+                    mismatches++;
+                    continue;
+                }
+                for (size_t w = 0; w < perThread.size(); w++) perThread[w] += decoder.bandsPerWorker()[w];
+                if (i == 0 && frame != page.image.pixels) mismatches++;
+            }
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations / pages.size();
+        if (threads == 1) singleMs = ms;
+
+        std::string split;
+        for (uint64_t n : perThread) {
+            if (!split.empty()) split += "/";
+            split += std::to_string((n + iterations / 2) / iterations);
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "banded, %d thread%s", threads, threads > 1 ? "s" : "");
+        printf("%-24s %12.3f %9.2fx %16s\n", label, ms, singleMs / ms, split.c_str());
+    }
+    printf("\nspeedup is relative to banded decode on 1 thread\n");
+
+    if (mismatches > 0) {
+        printf("\n%d page decodes differed from the source\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
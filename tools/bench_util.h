@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+// 各主机端 bench 共用的小工具函数
+#pragma once
+#include "book_compiler/gray_image.h"
+#include <dirent.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+inline double elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// 递归删除文件或目录，用于清理 bench 生成的临时目录
+inline void remove_tree(const std::string& path)
+{
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        remove(path.c_str());
+        return;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        remove_tree(path + "/" + entry->d_name);
+    }
+    closedir(dir);
+    rmdir(path.c_str());
+}
+
+// 与设备端 efontCN_24 相同的字宽：中日文及全角字符 24px，其余 12px
+inline int efont24_width(uint32_t cp)
+{
+    bool wide = (cp >= 0x2E80 && cp <= 0xA4CF) || (cp >= 0xAC00 && cp <= 0xD7A3) || (cp >= 0xF900 && cp <= 0xFAFF) ||
+                (cp >= 0xFE30 && cp <= 0xFE4F) || (cp >= 0xFF00 && cp <= 0xFF60) || (cp >= 0xFFE0 && cp <= 0xFFE6) ||
+                cp == 0x2026 || cp == 0x2014 || cp >= 0x20000;
+    return wide ? 24 : 12;
+}
+
+inline size_t heap_in_use()
+{
+    return mallinfo2().uordblks;
+}
+
+// 页面实际使用的最小位深：所有像素都落在 2^d 级均匀灰阶上
+inline int detect_bit_depth(const GrayImage& image)
+{
+    for (int depth : {1, 2, 4}) {
+        const int step = 255 / ((1 << depth) - 1);
+        bool fits      = true;
+        for (uint8_t v : image.pixels) {
+            if (v % step != 0) {
+                fits = false;
+                break;
+            }
+        }
+        if (fits) return depth;
+    }
+    return 8;
+}
@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "band_encoder.h"
+#include "png_codec.h"
+#include "strip_file.h"
+#include <algorithm>
+
+std::vector<uint8_t> encode_band_page(const GrayImage& image, int bitDepth, int bandHeight)
+{
+    bandHeight = std::max(1, std::min(image.height, bandHeight));
+
+    std::vector<std::vector<uint8_t>> bands;
+    for (int y = 0; y < image.height; y += bandHeight) {
+        int rows = std::min(bandHeight, image.height - y);
+        bands.push_back(encode_png_gray(crop_rows(image, y, rows), 9, bitDepth));
+    }
+
+    book::StripFileHeader header;
+    header.stripHeight = bandHeight;
+    header.width       = image.width;
+    header.height      = image.height;
+    header.stripCount  = (int)bands.size();
+    return book::build_strip_file(header, bands);
+}
@@ -0,0 +1,18 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "gray_image.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 编码为按行带存储的页面（.bnd，容器格式见 main/book/strip_file.h）
+ *
+ * 每 bandHeight 行编码为一个独立的灰度 PNG，设备端可以把各行带分给两个核心并行解码。
+ * 输入应已量化到对应级数（见 png_bit_depth_for_levels）。
+ */
+std::vector<uint8_t> encode_band_page(const GrayImage& image, int bitDepth, int bandHeight = 150);
@@ -0,0 +1,666 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "book_compiler.h"
+#include "band_encoder.h"
+#include "gray_image.h"
+#include "paginator.h"
+#include "png_codec.h"
+#include "strip_file.h"
+#include "text_layer.h"
+#include "tile_encoder.h"
+#include "tile_page.h"
+#include "work_stealing_pool.h"
+#include <json/json.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// 分页参数，与 BOOK_FORMAT_SPECIFICATION.md / EpubToImages.tsx 保持一致
+static constexpr int PAGE_WIDTH   = 540;
+static constexpr int PAGE_HEIGHT  = 900;
+static constexpr int OVERLAP      = 100;  // 固定步进 800
+static constexpr int COVER_SIZE   = 540;
+
+// 章节长图中的链接（坐标已缩放到 540 宽）
+struct LinkSpec {
+    std::string text;
+    int x = 0, y = 0, w = 0, h = 0;
+    std::string href;
+    std::string type;
+};
+
+// 章节长图中的一行文字（坐标已缩放到 540 宽），生成文字层
+struct LineSpec {
+    std::string text;
+    int x = 0, y = 0, w = 0, h = 0;
+};
+
+struct ImageSpec {
+    int y      = 0;
+    int height = 0;
+};
+
+struct ChapterSpec {
+    std::string title;
+    std::string imagePath;
+    std::string metaPath;
+};
+
+struct PageResult {
+    int initialLevels = 0;
+    int levels      = 0;
+    size_t bytes    = 0;
+    bool overBudget = false;
+};
+
+// 锚点目标：页面布局使用 page，条带布局使用 y
+struct AnchorTarget {
+    int section = 0;
+    int page    = 1;
+    int y       = 0;
+};
+
+struct SectionResult {
+    int index = 0;
+    std::string title;
+    int height         = 0;         // 缩放到 540 宽后的长图高度
+    int pageCount      = 0;         // 页面布局为页数，条带布局为条带数
+    int fixedPageCount = 0;         // 固定 800px 步进时的页数，用于统计
+    std::vector<PageSlice> slices;  // 每页在长图中的裁剪位置
+    std::vector<LinkSpec> links;
+    std::vector<LineSpec> lines;
+    std::vector<ImageSpec> images;
+    std::map<std::string, int> anchors;  // anchor -> 长图 y 坐标
+    std::vector<PageResult> pages;
+    std::vector<std::vector<uint8_t>> strips;  // 条带布局：各条带 PNG，全部完成后写入 strips.bin
+    std::string error;
+};
+
+static bool load_json(const std::string& path, Json::Value& root, std::string& error)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "Failed to open " + path;
+        return false;
+    }
+    Json::CharReaderBuilder builder;
+    std::string errs;
+    if (!Json::parseFromStream(builder, in, &root, &errs)) {
+        error = "Failed to parse " + path + ": " + errs;
+        return false;
+    }
+    return true;
+}
+
+static bool save_json(const std::string& path, const Json::Value& root)
+{
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    builder["emitUTF8"]    = true;
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    out << Json::writeString(builder, root);
+    return (bool)out;
+}
+
+static std::string generate_book_id()
+{
+    // 与前端 generateBookId() 相同的格式：book_{秒级时间戳}_{6位随机}
+    static const char charset[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<int> dist(0, sizeof(charset) - 2);
+
+    std::string id = "book_" + std::to_string((long long)time(nullptr)) + "_";
+    for (int i = 0; i < 6; i++) {
+        id += charset[dist(gen)];
+    }
+    return id;
+}
+
+static std::string iso8601_now()
+{
+    char buf[32];
+    time_t now = time(nullptr);
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    return buf;
+}
+
+// 读取章节元数据（锚点、链接、文字行、图片区域），坐标乘以 scale 转换到 540 宽
+static void parse_chapter_meta(const Json::Value& meta, double scale, SectionResult& section)
+{
+    const Json::Value& anchors = meta["anchors"];
+    for (const auto& name : anchors.getMemberNames()) {
+        section.anchors[name] = (int)(anchors[name].asDouble() * scale);
+    }
+
+    for (const auto& item : meta["links"]) {
+        LinkSpec link;
+        const Json::Value& rect = item["rect"];
+        link.text = item["text"].asString().substr(0, 100);
+        link.x    = (int)(rect["x"].asDouble() * scale);
+        link.y    = (int)(rect["y"].asDouble() * scale);
+        link.w    = (int)(rect["width"].asDouble() * scale);
+        link.h    = (int)(rect["height"].asDouble() * scale);
+        link.href = item["href"].asString();
+        link.type = item.get("type", "").asString();
+        if (link.type.empty()) {
+            link.type = (!link.href.empty() && link.href[0] == '#') ? "internal" : "external";
+        }
+        section.links.push_back(link);
+    }
+
+    for (const auto& item : meta["lines"]) {
+        LineSpec line;
+        const Json::Value& rect = item["rect"];
+        line.text = item["text"].asString();
+        line.x    = (int)(rect["x"].asDouble() * scale);
+        line.y    = (int)(rect["y"].asDouble() * scale);
+        line.w    = (int)(rect["width"].asDouble() * scale);
+        line.h    = (int)std::ceil(rect["height"].asDouble() * scale);
+        if (!line.text.empty()) section.lines.push_back(line);
+    }
+
+    for (const auto& item : meta["images"]) {
+        ImageSpec image;
+        image.y      = (int)(item["y"].asDouble() * scale);
+        image.height = (int)std::ceil(item["height"].asDouble() * scale);
+        section.images.push_back(image);
+    }
+}
+
+// 量化并编码（PNG、分块或行带页面），超出预算时逐级降低灰度级数（16 → 4 → 2，即 4 → 2 → 1 bit）
+static std::vector<uint8_t> encode_within_budget(const GrayImage& page, int levels, book::DitherMethod dither,
+                                                 const CompilerOptions& options, size_t budget, PageResult& result)
+{
+    std::vector<uint8_t> encoded;
+    for (int lv = levels; lv >= 2; lv = lv > 4 ? 4 : lv / 2) {
+        GrayImage quantized = page;
+        book::dither_gray(quantized.pixels.data(), quantized.width, quantized.height, quantized.width, lv, dither);
+        int bitDepth  = options.packed ? png_bit_depth_for_levels(lv) : 8;
+        if (options.tiles) {
+            encoded = encode_tile_page(quantized, bitDepth, options.tileSize);
+        } else if (options.bands) {
+            encoded = encode_band_page(quantized, bitDepth, options.bandHeight);
+        } else {
+            encoded = encode_png_gray(quantized, 9, bitDepth);
+        }
+        result.levels = lv;
+        if (encoded.size() <= budget) {
+            result.overBudget = false;
+            return encoded;
+        }
+        result.overBudget = true;
+    }
+    return encoded;
+}
+
+static bool page_has_image(const SectionResult& section, int page)
+{
+    int top    = section.slices[page].top;
+    int bottom = top + section.slices[page].height;
+    for (const auto& image : section.images) {
+        if (image.y < bottom && image.y + image.height > top) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::string section_dir_name(int index)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%03d", index);
+    return buf;
+}
+
+static std::string page_file_name(int page, const CompilerOptions& options)
+{
+    const char* extension = ".png";
+    if (options.tiles) {
+        extension = book::TILE_PAGE_EXTENSION;
+    } else if (options.bands) {
+        extension = book::BAND_PAGE_EXTENSION;
+    }
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%03d%s", page, extension);
+    return buf;
+}
+
+static void set_link_target(Json::Value& item, const LinkSpec& link,
+                            const std::map<std::string, AnchorTarget>& anchorMap, bool strips)
+{
+    if (link.type != "internal") return;
+
+    size_t hash = link.href.find('#');
+    if (hash == std::string::npos) return;
+
+    auto it = anchorMap.find(link.href.substr(hash + 1));
+    if (it == anchorMap.end()) return;
+
+    item["target"]["section"] = it->second.section;
+    if (strips) {
+        item["target"]["y"] = it->second.y;
+    } else {
+        item["target"]["page"] = it->second.page;
+    }
+}
+
+static Json::Value build_links_json(const SectionResult& section, const std::map<std::string, AnchorTarget>& anchorMap)
+{
+    Json::Value pages(Json::arrayValue);
+
+    for (int p = 0; p < section.pageCount; p++) {
+        const PageSlice& slice = section.slices[p];
+        int top                = slice.top;
+        int bottom             = top + slice.height;
+        int next               = p + 1 < section.pageCount ? section.slices[p + 1].top : INT_MAX;
+
+        Json::Value page;
+        page["page"] = p + 1;
+
+        page["hasImage"] = page_has_image(section, p);
+
+        Json::Value links(Json::arrayValue);
+        for (const auto& link : section.links) {
+            // 完整落在本页内的链接（重叠区中的链接会同时出现在相邻两页）；
+            // 跨页边界的链接只归属到其顶部所在的页面
+            bool inside  = link.y >= top && link.y + link.h <= bottom;
+            bool topHere = link.y >= top && link.y < std::min(bottom, next);
+            if (!inside && !topHere) continue;
+
+            Json::Value item;
+            item["text"]           = link.text;
+            item["rect"]["x"]      = link.x;
+            item["rect"]["y"]      = link.y - top;
+            item["rect"]["width"]  = link.w;
+            item["rect"]["height"] = link.h;
+            item["href"]           = link.href;
+            item["type"]           = link.type;
+            set_link_target(item, link, anchorMap, false);
+            links.append(item);
+        }
+        page["links"] = links;
+        pages.append(page);
+    }
+
+    Json::Value root;
+    root["pages"] = pages;
+    return root;
+}
+
+// 文字层：各行按与链接相同的规则归属到页面，坐标转换为页面内坐标
+static std::vector<uint8_t> build_section_text_layer(const SectionResult& section)
+{
+    std::vector<std::vector<book::TextLayerLine>> pages(section.pageCount);
+    for (int p = 0; p < section.pageCount; p++) {
+        int top    = section.slices[p].top;
+        int bottom = top + section.slices[p].height;
+        int next   = p + 1 < section.pageCount ? section.slices[p + 1].top : INT_MAX;
+        for (const auto& line : section.lines) {
+            bool inside  = line.y >= top && line.y + line.h <= bottom;
+            bool topHere = line.y >= top && line.y < std::min(bottom, next);
+            if (!inside && !topHere) continue;
+
+            book::TextLayerLine item;
+            item.text  = line.text;
+            item.box.x = line.x;
+            item.box.y = line.y - top;
+            item.box.w = line.w;
+            item.box.h = line.h;
+            pages[p].push_back(item);
+        }
+    }
+    return book::build_text_layer(pages);
+}
+
+// 条带布局：整章一个链接列表，坐标为章节长图坐标；图片区域供设备端判断视口是否含图
+static Json::Value build_strip_links_json(const SectionResult& section,
+                                          const std::map<std::string, AnchorTarget>& anchorMap)
+{
+    Json::Value links(Json::arrayValue);
+    for (const auto& link : section.links) {
+        Json::Value item;
+        item["text"]           = link.text;
+        item["rect"]["x"]      = link.x;
+        item["rect"]["y"]      = link.y;
+        item["rect"]["width"]  = link.w;
+        item["rect"]["height"] = link.h;
+        item["href"]           = link.href;
+        item["type"]           = link.type;
+        set_link_target(item, link, anchorMap, true);
+        links.append(item);
+    }
+
+    Json::Value images(Json::arrayValue);
+    for (const auto& image : section.images) {
+        Json::Value item;
+        item["y"]      = image.y;
+        item["height"] = image.height;
+        images.append(item);
+    }
+
+    Json::Value root;
+    root["links"]  = links;
+    root["images"] = images;
+    return root;
+}
+
+static bool compile_cover(const std::string& coverPath, const std::string& outPath, std::string& error)
+{
+    GrayImage cover = read_png_gray(coverPath, &error);
+    if (cover.empty()) return false;
+
+    // 居中裁切为正方形后缩放到 540×540
+    int side = std::min(cover.width, cover.height);
+    GrayImage square(side, side);
+    int ox = (cover.width - side) / 2;
+    int oy = (cover.height - side) / 2;
+    for (int y = 0; y < side; y++) {
+        std::copy_n(cover.row(y + oy) + ox, side, square.row(y));
+    }
+
+    GrayImage scaled = scale_to_width(square, COVER_SIZE);
+    if (!write_file(outPath, encode_png_gray(scaled, 9))) {
+        error = "Failed to write " + outPath;
+        return false;
+    }
+    return true;
+}
+
+bool BookCompiler::compile(CompileStats& stats)
+{
+    stats = CompileStats();
+    auto startTime = std::chrono::steady_clock::now();
+
+    Json::Value book;
+    fs::path inputDir(_options.inputDir);
+    if (!load_json((inputDir / "book.json").string(), book, _error)) {
+        return false;
+    }
+
+    std::string bookId = _options.bookId.empty() ? book.get("id", "").asString() : _options.bookId;
+    if (bookId.empty()) {
+        bookId = generate_book_id();
+    }
+
+    std::vector<ChapterSpec> chapters;
+    for (const auto& item : book["chapters"]) {
+        ChapterSpec chapter;
+        chapter.title     = item["title"].asString();
+        chapter.imagePath = (inputDir / item["image"].asString()).string();
+        if (item.isMember("meta")) {
+            chapter.metaPath = (inputDir / item["meta"].asString()).string();
+        }
+        chapters.push_back(chapter);
+    }
+    if (chapters.empty()) {
+        _error = "book.json contains no chapters";
+        return false;
+    }
+
+    fs::path bookDir = fs::path(_options.outputDir) / bookId;
+    std::error_code ec;
+    fs::create_directories(bookDir / "sections", ec);
+    if (ec) {
+        _error = "Failed to create " + bookDir.string() + ": " + ec.message();
+        return false;
+    }
+
+    std::vector<SectionResult> sections(chapters.size());
+    std::mutex statsMutex;
+
+    {
+        WorkStealingPool pool(_options.threads);
+        stats.threads = (int)pool.threadCount();
+
+        for (size_t i = 0; i < chapters.size(); i++) {
+            pool.submit([&, i]() {
+                SectionResult& section = sections[i];
+                section.index          = (int)i;
+                section.title          = chapters[i].title;
+
+                std::string error;
+                GrayImage raw = read_png_gray(chapters[i].imagePath, &error);
+                if (raw.empty()) {
+                    section.error = chapters[i].imagePath + ": " + error;
+                    return;
+                }
+
+                double scale = (double)PAGE_WIDTH / raw.width;
+                if (!chapters[i].metaPath.empty()) {
+                    Json::Value meta;
+                    if (!load_json(chapters[i].metaPath, meta, error)) {
+                        section.error = error;
+                        return;
+                    }
+                    parse_chapter_meta(meta, scale, section);
+                }
+
+                auto image = std::make_shared<const GrayImage>(scale_to_width(raw, PAGE_WIDTH));
+                raw        = GrayImage();
+
+                section.height = image->height;
+
+                PaginationOptions pagination;
+                pagination.pageHeight = PAGE_HEIGHT;
+                pagination.overlap    = OVERLAP;
+                pagination.cutWindow  = _options.cutWindow;
+
+                std::vector<PageSlice> fixed = paginate_fixed(image->height, pagination);
+                section.fixedPageCount       = (int)fixed.size();
+                if (_options.strips) {
+                    // 条带之间不重叠，由阅读器按任意偏移拼接
+                    PaginationOptions stripLayout;
+                    stripLayout.pageHeight = _options.stripHeight;
+                    stripLayout.overlap    = 0;
+                    section.slices         = paginate_fixed(image->height, stripLayout);
+                    section.strips.resize(section.slices.size());
+                } else if (_options.smartPagination) {
+                    std::vector<std::pair<int, int>> keepTogether;
+                    for (const auto& spec : section.images) {
+                        keepTogether.emplace_back(spec.y, spec.y + spec.height);
+                    }
+                    section.slices = paginate_smart(*image, keepTogether, pagination);
+                } else {
+                    section.slices = std::move(fixed);
+                }
+                section.pageCount = (int)section.slices.size();
+                section.pages.resize(section.pageCount);
+
+                fs::path sectionDir = bookDir / "sections" / section_dir_name(section.index);
+                fs::create_directories(sectionDir);
+
+                // 每页一个任务，留在本线程队列中供空闲线程窃取
+                for (int p = 0; p < section.pageCount; p++) {
+                    pool.submit([&, image, sectionDir, p]() {
+                        const PageSlice& slice = section.slices[p];
+                        GrayImage page =
+                            crop_rows(*image, slice.top, slice.height, _options.strips ? 0 : PAGE_HEIGHT);
+                        PageResult& result   = section.pages[p];
+                        bool hasImage        = page_has_image(section, p);
+                        result.initialLevels = hasImage ? _options.levels : _options.textLevels;
+
+                        // 条带很小，不做预算降级
+                        std::vector<uint8_t> encoded =
+                            encode_within_budget(page, result.initialLevels,
+                                                 hasImage ? _options.dither : _options.textDither, _options,
+                                                 _options.strips ? SIZE_MAX : _options.pageBudget, result);
+                        result.bytes = encoded.size();
+
+                        if (_options.strips) {
+                            section.strips[p] = std::move(encoded);
+                        } else if (!write_file((sectionDir / page_file_name(p + 1, _options)).string(),
+                                               encoded)) {
+                            std::lock_guard<std::mutex> lock(statsMutex);
+                            section.error = "Failed to write page " + std::to_string(p + 1);
+                        }
+                    });
+                }
+            });
+        }
+
+        pool.wait();
+        stats.steals = pool.stealCount();
+    }
+
+    // 汇总锚点：anchor -> (section, page, y)，页码按裁剪位置计算
+    std::map<std::string, AnchorTarget> anchorMap;
+    for (const auto& section : sections) {
+        if (!section.error.empty()) {
+            _error = section.error;
+            return false;
+        }
+        for (const auto& anchor : section.anchors) {
+            AnchorTarget target;
+            target.section = section.index;
+            target.y       = anchor.second;
+            target.page    = _options.strips ? anchor.second / PAGE_HEIGHT + 1
+                                             : page_index_for_y(section.slices, anchor.second) + 1;
+            anchorMap[anchor.first] = target;
+        }
+    }
+
+    Json::Value metadata;
+    metadata["id"]      = bookId;
+    metadata["title"]   = book.get("title", bookId).asString();
+    metadata["author"]  = book.get("author", "").asString();
+    metadata["addedAt"] = iso8601_now();
+    metadata["sections"] = Json::Value(Json::arrayValue);
+    if (_options.strips) {
+        metadata["layout"] = "strips";
+    } else if (_options.tiles) {
+        metadata["pageFormat"] = "tiles";
+        metadata["tileSize"]   = _options.tileSize;
+    } else if (_options.bands) {
+        metadata["pageFormat"] = "bands";
+        metadata["bandHeight"] = _options.bandHeight;
+    }
+
+    stats.bookId = bookId;
+    for (const auto& section : sections) {
+        Json::Value item;
+        item["index"] = section.index;
+        item["title"] = section.title;
+
+        fs::path sectionDir = bookDir / "sections" / section_dir_name(section.index);
+        Json::Value links;
+
+        if (_options.strips) {
+            // pageCount 为整屏数，仅用于进度显示
+            item["pageCount"]   = std::max(1, (section.height + PAGE_HEIGHT - 1) / PAGE_HEIGHT);
+            item["height"]      = section.height;
+            item["stripHeight"] = _options.stripHeight;
+
+            book::StripFileHeader header;
+            header.stripHeight = _options.stripHeight;
+            header.width       = PAGE_WIDTH;
+            header.height      = section.height;
+            header.stripCount  = (int)section.strips.size();
+            if (!write_file((sectionDir / book::STRIP_FILE_NAME).string(),
+                            book::build_strip_file(header, section.strips))) {
+                _error = "Failed to write strips for section " + std::to_string(section.index);
+                return false;
+            }
+            links = build_strip_links_json(section, anchorMap);
+        } else {
+            item["pageCount"] = section.pageCount;
+
+            // 每页在章节长图（540 宽）中的裁剪位置，页面内坐标 = 长图坐标 - y
+            Json::Value pages(Json::arrayValue);
+            for (const auto& slice : section.slices) {
+                Json::Value page;
+                page["y"]      = slice.top;
+                page["height"] = slice.height;
+                pages.append(page);
+            }
+            item["pages"] = pages;
+            links         = build_links_json(section, anchorMap);
+
+            // 文字层只用于页面布局，供设备端全文检索
+            if (!section.lines.empty()) {
+                if (!write_file((sectionDir / book::TEXT_LAYER_FILE_NAME).string(),
+                                build_section_text_layer(section))) {
+                    _error = "Failed to write text layer for section " + std::to_string(section.index);
+                    return false;
+                }
+                metadata["textLayer"] = true;
+                stats.textLines += (int)section.lines.size();
+            }
+        }
+        metadata["sections"].append(item);
+
+        if (!save_json((sectionDir / "links.json").string(), links)) {
+            _error = "Failed to write links.json for section " + std::to_string(section.index);
+            return false;
+        }
+
+        stats.sections++;
+        stats.fixedPages += section.fixedPageCount;
+        for (int p = 0; !_options.strips && p + 1 < section.pageCount; p++) {
+            if (section.slices[p].cleanCut) {
+                stats.cleanCuts++;
+            } else {
+                stats.overlapCuts++;
+            }
+        }
+        for (const auto& page : section.pages) {
+            stats.pages++;
+            stats.totalBytes += page.bytes;
+            if (page.levels < page.initialLevels) stats.fallbackPages++;
+            if (page.overBudget) stats.overBudgetPages++;
+        }
+    }
+
+    if (!anchorMap.empty()) {
+        Json::Value anchors(Json::objectValue);
+        for (const auto& anchor : anchorMap) {
+            anchors[anchor.first]["section"] = anchor.second.section;
+            anchors[anchor.first]["page"]    = anchor.second.page;
+            if (_options.strips) {
+                anchors[anchor.first]["y"] = anchor.second.y;
+            }
+        }
+        metadata["anchorMap"] = anchors;
+    }
+
+    if (!save_json((bookDir / "metadata.json").string(), metadata)) {
+        _error = "Failed to write metadata.json";
+        return false;
+    }
+
+    Json::Value status;
+    status["currentSection"] = sections.front().index;
+    status["currentPage"]    = 1;
+    status["lastReadTime"]   = "";
+    if (!save_json((bookDir / "reading_status.json").string(), status)) {
+        _error = "Failed to write reading_status.json";
+        return false;
+    }
+
+    if (book.isMember("cover")) {
+        if (!compile_cover((inputDir / book["cover"].asString()).string(), (bookDir / "cover.png").string(),
+                           _error)) {
+            return false;
+        }
+    }
+
+    stats.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
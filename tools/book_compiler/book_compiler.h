@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "dither.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief 书籍编译参数
+ */
+struct CompilerOptions {
+    std::string inputDir;   // 包含 book.json 的源目录
+    std::string outputDir;  // 输出根目录，书籍写入 {outputDir}/{bookId}/
+    std::string bookId;     // 为空时使用 book.json 中的 id，仍为空则自动生成
+    int threads          = 0;          // 0 = 使用全部核心
+    int levels           = 16;         // 含图片页面的初始灰度级数（2 / 4 / 16）
+    int textLevels       = 2;          // 纯文字页面的灰度级数（与前端 hasImages ? 16 : 2 一致）
+    size_t pageBudget    = 80 * 1024;  // 单页 PNG 大小上限（BOOK_FORMAT_SPECIFICATION.md）
+    bool packed          = true;       // 按灰度级数输出 1/2/4-bit PNG，false 时固定 8-bit
+    bool smartPagination = true;       // 在行间空白处切页，false 时使用固定 800px 步进 + 100px 重叠
+    int cutWindow        = 200;        // 空白切点的搜索窗口（页面底部向上的行数）
+    bool strips          = false;      // 条带布局：每章一个 strips.bin，供连续滚动阅读
+    int stripHeight      = 100;        // 条带高度
+    bool tiles           = false;      // 页面写成 .tpg 分块格式，阅读器只重绘与上一页不同的块
+    int tileSize         = 60;         // 块边长
+    bool bands           = false;      // 页面写成 .bnd 行带格式，设备端双核并行解码
+    int bandHeight       = 150;        // 行带高度
+    book::DitherMethod dither     = book::DitherMethod::FloydSteinberg;  // 含图片页面
+    book::DitherMethod textDither = book::DitherMethod::Atkinson;        // 纯文字页面
+};
+
+/**
+ * @brief 编译统计，用于基准测试输出
+ */
+struct CompileStats {
+    int sections          = 0;
+    int pages             = 0;
+    int fallbackPages     = 0;  // 因超出预算而降低灰度级数的页面
+    int overBudgetPages   = 0;  // 降到 2 级仍超出预算的页面
+    int fixedPages        = 0;  // 固定步进分页时的总页数
+    int cleanCuts         = 0;  // 落在行间空白处的切点
+    int overlapCuts       = 0;  // 找不到空白、保留重叠的切点
+    int textLines         = 0;  // 写入文字层的行数（章节元数据含 lines 时）
+    uint64_t totalBytes   = 0;
+    uint64_t steals       = 0;
+    int threads           = 0;
+    double seconds        = 0;
+    std::string bookId;
+
+    double pagesPerSecond() const
+    {
+        return seconds > 0 ? pages / seconds : 0;
+    }
+};
+
+/**
+ * @brief 将章节长图编译为设备端书籍目录（sections/NNN/PPP.png / .tpg / .bnd + links.json + metadata.json）
+ */
+class BookCompiler {
+public:
+    explicit BookCompiler(const CompilerOptions& options) : _options(options)
+    {
+    }
+
+    bool compile(CompileStats& stats);
+
+    const std::string& lastError() const
+    {
+        return _error;
+    }
+
+private:
+    CompilerOptions _options;
+    std::string _error;
+};
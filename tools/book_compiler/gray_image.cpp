@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "gray_image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static GrayImage scale_down_area(const GrayImage& src, int dstW, int dstH)
+{
+    GrayImage dst(dstW, dstH);
+
+    // 源像素在目标坐标系中的跨度（>= 1）
+    const double sx = (double)src.width / dstW;
+    const double sy = (double)src.height / dstH;
+
+    // 先做水平方向面积平均，按行累加到浮点缓冲
+    std::vector<float> rowAcc(dstW);
+    std::vector<float> colAcc(dstW);
+
+    for (int dy = 0; dy < dstH; dy++) {
+        double y0 = dy * sy;
+        double y1 = std::min((double)src.height, y0 + sy);
+        std::fill(colAcc.begin(), colAcc.end(), 0.0f);
+
+        for (int y = (int)y0; y < (int)std::ceil(y1); y++) {
+            double wy = std::min(y1, (double)y + 1) - std::max(y0, (double)y);
+            if (wy <= 0) continue;
+
+            const uint8_t* srow = src.row(y);
+            for (int dx = 0; dx < dstW; dx++) {
+                double x0  = dx * sx;
+                double x1  = std::min((double)src.width, x0 + sx);
+                double sum = 0;
+                for (int x = (int)x0; x < (int)std::ceil(x1); x++) {
+                    double wx = std::min(x1, (double)x + 1) - std::max(x0, (double)x);
+                    sum += wx * srow[x];
+                }
+                rowAcc[dx] = (float)(sum / (x1 - x0));
+            }
+            for (int dx = 0; dx < dstW; dx++) {
+                colAcc[dx] += (float)(rowAcc[dx] * wy);
+            }
+        }
+
+        uint8_t* drow = dst.row(dy);
+        float norm    = (float)(y1 - y0);
+        for (int dx = 0; dx < dstW; dx++) {
+            drow[dx] = (uint8_t)std::clamp((int)std::lround(colAcc[dx] / norm), 0, 255);
+        }
+    }
+    return dst;
+}
+
+static GrayImage scale_up_bilinear(const GrayImage& src, int dstW, int dstH)
+{
+    GrayImage dst(dstW, dstH);
+
+    const float sx = (float)src.width / dstW;
+    const float sy = (float)src.height / dstH;
+
+    for (int dy = 0; dy < dstH; dy++) {
+        float fy = std::max(0.0f, (dy + 0.5f) * sy - 0.5f);
+        int y0   = std::min((int)fy, src.height - 1);
+        int y1   = std::min(y0 + 1, src.height - 1);
+        float ty = fy - y0;
+
+        const uint8_t* r0 = src.row(y0);
+        const uint8_t* r1 = src.row(y1);
+        uint8_t* drow     = dst.row(dy);
+
+        for (int dx = 0; dx < dstW; dx++) {
+            float fx = std::max(0.0f, (dx + 0.5f) * sx - 0.5f);
+            int x0   = std::min((int)fx, src.width - 1);
+            int x1   = std::min(x0 + 1, src.width - 1);
+            float tx = fx - x0;
+
+            float top    = r0[x0] + (r0[x1] - r0[x0]) * tx;
+            float bottom = r1[x0] + (r1[x1] - r1[x0]) * tx;
+            drow[dx]     = (uint8_t)std::clamp((int)std::lround(top + (bottom - top) * ty), 0, 255);
+        }
+    }
+    return dst;
+}
+
+GrayImage scale_to_width(const GrayImage& src, int targetWidth)
+{
+    if (src.empty() || src.width == targetWidth) {
+        return src;
+    }
+
+    int targetHeight = std::max(1, (int)std::lround((double)src.height * targetWidth / src.width));
+    if (targetWidth < src.width) {
+        return scale_down_area(src, targetWidth, targetHeight);
+    }
+    return scale_up_bilinear(src, targetWidth, targetHeight);
+}
+
+GrayImage crop_rows(const GrayImage& src, int y, int height, int outHeight)
+{
+    GrayImage dst(src.width, std::max(height, outHeight), 255);
+
+    int copyRows = std::min(height, src.height - y);
+    if (copyRows > 0) {
+        memcpy(dst.row(0), src.row(y), (size_t)copyRows * src.width);
+    }
+    return dst;
+}
@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 8-bit 灰度图（0 = 黑，255 = 白），按行紧密排列
+ */
+struct GrayImage {
+    int width  = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+
+    GrayImage() = default;
+    GrayImage(int w, int h, uint8_t fill = 255) : width(w), height(h), pixels((size_t)w * h, fill)
+    {
+    }
+
+    uint8_t* row(int y)
+    {
+        return pixels.data() + (size_t)y * width;
+    }
+    const uint8_t* row(int y) const
+    {
+        return pixels.data() + (size_t)y * width;
+    }
+    bool empty() const
+    {
+        return width <= 0 || height <= 0;
+    }
+};
+
+/**
+ * @brief 等比缩放到指定宽度（缩小用面积平均，放大用双线性）
+ */
+GrayImage scale_to_width(const GrayImage& src, int targetWidth);
+
+/**
+ * @brief 裁剪 [y, y + height) 行，超出原图的部分填充白色
+ * @param outHeight 输出高度，大于 height 时在底部补白；0 表示与 height 相同
+ */
+GrayImage crop_rows(const GrayImage& src, int y, int height, int outHeight = 0);
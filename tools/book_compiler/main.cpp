@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "book_compiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void print_usage(const char* prog)
+{
+    printf("Usage: %s <input_dir> <output_dir> [options]\n", prog);
+    printf("\n");
+    printf("  input_dir    directory containing book.json and chapter long-images\n");
+    printf("  output_dir   books root, the book is written to <output_dir>/<book_id>/\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -j, --threads N     worker threads (default: all cores)\n");
+    printf("  -l, --levels N      grayscale levels for pages with images, 2/4/16 (default: 16)\n");
+    printf("  -t, --text-levels N grayscale levels for text-only pages, 2/4/16 (default: 2)\n");
+    printf("  --dither M          none|ordered|fs|atkinson for pages with images (default: fs)\n");
+    printf("  --text-dither M     none|ordered|fs|atkinson for text-only pages (default: atkinson)\n");
+    printf("  --budget KB         page size budget in KB (default: 80)\n");
+    printf("  --strips [H]        store each section as H px strips for continuous scroll (default H: 100)\n");
+    printf("  --tiles [N]         write pages as N x N tiled .tpg files that skip blank tiles (default N: 60)\n");
+    printf("  --bands [H]         write pages as .bnd files of H px bands for dual-core decode (default H: 150)\n");
+    printf("  --8bit              always write 8-bit PNG instead of 1/2/4-bit packed pages\n");
+    printf("  --pagination M      smart|fixed, cut pages at inter-line whitespace or every 800px (default: smart)\n");
+    printf("  --cut-window PX     how far above the page bottom to look for whitespace (default: 200)\n");
+    printf("  --bench             compile with 1, 2, 4 ... N threads and report pages/s\n");
+}
+
+static void print_stats(const CompileStats& stats)
+{
+    printf("%-8d %7d %9d %8d %10.1f %9.2f %10.1f %8llu\n", stats.threads, stats.pages, stats.fallbackPages,
+           stats.overBudgetPages, stats.totalBytes / 1024.0 / std::max(1, stats.pages), stats.seconds,
+           stats.pagesPerSecond(), (unsigned long long)stats.steals);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    CompilerOptions options;
+    options.inputDir  = argv[1];
+    options.outputDir = argv[2];
+    bool bench        = false;
+
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-j" || arg == "--threads") && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+        } else if ((arg == "-l" || arg == "--levels") && i + 1 < argc) {
+            options.levels = atoi(argv[++i]);
+        } else if ((arg == "-t" || arg == "--text-levels") && i + 1 < argc) {
+            options.textLevels = atoi(argv[++i]);
+        } else if (arg == "--dither" && i + 1 < argc) {
+            if (!book::parse_dither_method(argv[++i], options.dither)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--text-dither" && i + 1 < argc) {
+            if (!book::parse_dither_method(argv[++i], options.textDither)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--budget" && i + 1 < argc) {
+            options.pageBudget = (size_t)atoi(argv[++i]) * 1024;
+        } else if (arg == "--pagination" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode != "smart" && mode != "fixed") {
+                print_usage(argv[0]);
+                return 1;
+            }
+            options.smartPagination = mode == "smart";
+        } else if (arg == "--cut-window" && i + 1 < argc) {
+            options.cutWindow = std::max(0, std::min(800, atoi(argv[++i])));
+        } else if (arg == "--strips") {
+            options.strips = true;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                options.stripHeight = std::max(10, std::min(900, atoi(argv[++i])));
+            }
+        } else if (arg == "--tiles") {
+            options.tiles = true;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                options.tileSize = std::max(8, std::min(255, atoi(argv[++i])));
+            }
+        } else if (arg == "--bands") {
+            options.bands = true;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                options.bandHeight = std::max(10, std::min(900, atoi(argv[++i])));
+            }
+        } else if (arg == "--8bit") {
+            options.packed = false;
+        } else if (arg == "--bench") {
+            bench = true;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    auto validLevels = [](int levels) { return levels == 2 || levels == 4 || levels == 16; };
+    if (!validLevels(options.levels) || !validLevels(options.textLevels)) {
+        fprintf(stderr, "levels must be 2, 4 or 16\n");
+        return 1;
+    }
+    if ((int)options.tiles + (int)options.strips + (int)options.bands > 1) {
+        fprintf(stderr, "--tiles, --bands and --strips cannot be combined\n");
+        return 1;
+    }
+
+    std::vector<int> threadCounts;
+    if (bench) {
+        int maxThreads = options.threads > 0 ? options.threads : (int)std::thread::hardware_concurrency();
+        for (int n = 1; n < maxThreads; n *= 2) {
+            threadCounts.push_back(n);
+        }
+        threadCounts.push_back(std::max(1, maxThreads));
+    } else {
+        threadCounts.push_back(options.threads);
+    }
+
+    printf("%-8s %7s %9s %8s %10s %9s %10s %8s\n", "threads", "pages", "fallback", "over", "avg KB", "seconds",
+           "pages/s", "steals");
+
+    CompileStats stats;
+    for (int threads : threadCounts) {
+        options.threads = threads;
+        BookCompiler compiler(options);
+        if (!compiler.compile(stats)) {
+            fprintf(stderr, "Compile failed: %s\n", compiler.lastError().c_str());
+            return 1;
+        }
+        print_stats(stats);
+
+        // 基准测试的多轮编译覆盖同一本书
+        options.bookId = stats.bookId;
+    }
+
+    printf("\nBook written to %s/%s (%d sections)\n", options.outputDir.c_str(), stats.bookId.c_str(),
+           stats.sections);
+    if (options.strips) {
+        printf("Layout: %d strips of %d px, fixed 800px pages would need %d pages\n", stats.pages,
+               options.stripHeight, stats.fixedPages);
+    } else if (stats.fixedPages > 0) {
+        printf("Pagination: %d pages, fixed 800px step would need %d (%+.1f%%); %d cuts in whitespace, %d with overlap\n",
+               stats.pages, stats.fixedPages, stats.pages * 100.0 / stats.fixedPages - 100.0, stats.cleanCuts,
+               stats.overlapCuts);
+    }
+    if (stats.textLines > 0) {
+        printf("Text layer: %d lines for full-text search\n", stats.textLines);
+    }
+    if (stats.overBudgetPages > 0) {
+        printf("Warning: %d pages exceed the %zu KB budget even at 2 levels\n", stats.overBudgetPages,
+               options.pageBudget / 1024);
+    }
+    return 0;
+}
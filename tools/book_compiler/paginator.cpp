@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "paginator.h"
+#include <algorithm>
+
+std::vector<PageSlice> paginate_fixed(int height, const PaginationOptions& options)
+{
+    // 与 Python 示例 while (y_offset < total_height) 相同：ceil(H / step) 页
+    const int step = options.pageHeight - options.overlap;
+    int count      = std::max(1, (height + step - 1) / step);
+
+    std::vector<PageSlice> slices(count);
+    for (int p = 0; p < count; p++) {
+        slices[p].top      = p * step;
+        slices[p].height   = std::max(0, std::min(options.pageHeight, height - slices[p].top));
+        slices[p].cleanCut = p == count - 1;
+    }
+    return slices;
+}
+
+std::vector<PageSlice> paginate_smart(const GrayImage& image, const std::vector<std::pair<int, int>>& keepTogether,
+                                      const PaginationOptions& options)
+{
+    const int height = image.height;
+
+    // 行墨迹直方图 → 空白行标记，blankPrefix[y] = [0, y) 中的空白行数
+    std::vector<uint8_t> blank(height, 0);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = image.row(y);
+        int ink            = 0;
+        for (int x = 0; x < image.width && ink <= options.inkTolerance; x++) {
+            ink += row[x] < options.inkThreshold;
+        }
+        blank[y] = ink <= options.inkTolerance;
+    }
+    for (const auto& range : keepTogether) {
+        // 区间内部不可切，上下边缘仍可作为切点
+        for (int y = std::max(0, range.first + 1); y < std::min(height, range.second - 1); y++) {
+            blank[y] = 0;
+        }
+    }
+
+    std::vector<int> blankPrefix(height + 1, 0);
+    for (int y = 0; y < height; y++) {
+        blankPrefix[y + 1] = blankPrefix[y] + blank[y];
+    }
+    auto allBlank = [&](int y0, int y1) {
+        y0 = std::max(0, y0);
+        y1 = std::min(height, y1);
+        return y0 >= y1 || blankPrefix[y1] - blankPrefix[y0] == y1 - y0;
+    };
+
+    // 切点 c 表示本页结束于 c（不含），两侧各 minGap / 2 行都是空白
+    const int halfGap = options.minGap / 2;
+    auto cleanAt      = [&](int c) { return allBlank(c - halfGap, c + options.minGap - halfGap); };
+
+    std::vector<PageSlice> slices;
+    int top = 0;
+    while (top < height) {
+        if (height - top <= options.pageHeight) {
+            slices.push_back({top, height - top, true});
+            break;
+        }
+
+        int cut = -1;
+        for (int c = top + options.pageHeight; c >= top + options.pageHeight - options.cutWindow && c > top; c--) {
+            if (cleanAt(c)) {
+                cut = c;
+                break;
+            }
+        }
+
+        if (cut < 0) {
+            // 窗口内没有行间空白：保持固定步进并与下一页重叠
+            slices.push_back({top, options.pageHeight, false});
+            top += options.pageHeight - options.overlap;
+            continue;
+        }
+
+        slices.push_back({top, cut - top, true});
+
+        // 下一页跳过多余的段间空白，只保留 topMargin 行
+        int next = cut;
+        while (next < height && blank[next]) next++;
+        top = std::max(cut, next - options.topMargin);
+        if (next >= height) break;  // 剩余全是空白
+    }
+
+    if (slices.empty()) {
+        slices.push_back({0, std::min(height, options.pageHeight), true});
+    }
+    return slices;
+}
+
+int page_index_for_y(const std::vector<PageSlice>& slices, int y)
+{
+    // 重叠区归属后一页（与固定步进的 y / 800 一致）；
+    // 落在被跳过的段间空白里的坐标归属下一页
+    int page = 0;
+    for (size_t p = 0; p < slices.size(); p++) {
+        if (slices[p].top <= y) page = (int)p;
+    }
+    if (!slices.empty() && y >= slices[page].top + slices[page].height && page + 1 < (int)slices.size()) {
+        page++;
+    }
+    return page;
+}
@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "gray_image.h"
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 一页在章节长图中的位置：内容为 [top, top + height)，页面其余部分补白
+ */
+struct PageSlice {
+    int top       = 0;
+    int height    = 0;
+    bool cleanCut = false;  // 底边落在空白行上（或到达长图末尾），无需与下一页重叠
+};
+
+struct PaginationOptions {
+    int pageHeight   = 900;
+    int overlap      = 100;  // 找不到空白切点时与下一页重叠的行数
+    int cutWindow    = 200;  // 切点搜索范围：[top + pageHeight - cutWindow, top + pageHeight]
+    int minGap       = 6;    // 切点两侧至少连续这么多空白行才算行间空白
+    int topMargin    = 8;    // 干净切点之后跳过多余空白，只保留这么多行页边距
+    int inkThreshold = 160;  // 灰度低于此值的像素计为墨迹
+    int inkTolerance = 1;    // 每行允许的墨迹像素数（容忍扫描噪点）
+};
+
+/**
+ * @brief 固定步进分页（pageHeight - overlap），与 BOOK_FORMAT_SPECIFICATION.md 一致
+ */
+std::vector<PageSlice> paginate_fixed(int height, const PaginationOptions& options);
+
+/**
+ * @brief 按行墨迹直方图在行间空白处切页
+ *
+ * 在窗口内自下而上寻找最靠后的空白切点，使每页尽量填满；
+ * 窗口内没有空白（大图、密集表格）时退回固定步进并保留重叠。
+ *
+ * @param keepTogether 不允许切开的行区间 [y0, y1)，如章节元数据中的图片区域
+ */
+std::vector<PageSlice> paginate_smart(const GrayImage& image, const std::vector<std::pair<int, int>>& keepTogether,
+                                      const PaginationOptions& options);
+
+/**
+ * @brief 长图 y 坐标所属的页（从 0 开始），用于锚点定位
+ */
+int page_index_for_y(const std::vector<PageSlice>& slices, int y);
@@ -0,0 +1,275 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "png_codec.h"
+#include <png.h>
+#include <zlib.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+GrayImage read_png_gray(const std::string& path, std::string* error)
+{
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_file(&image, path.c_str())) {
+        if (error) *error = image.message;
+        return GrayImage();
+    }
+
+    image.format = PNG_FORMAT_GRAY;
+    GrayImage result((int)image.width, (int)image.height);
+
+    // 透明像素合成到白色背景，与设备端白底显示一致
+    png_color background = {255, 255, 255};
+    if (!png_image_finish_read(&image, &background, result.pixels.data(), (png_int_32)image.width, nullptr)) {
+        if (error) *error = image.message;
+        png_image_free(&image);
+        return GrayImage();
+    }
+    return result;
+}
+
+static const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+static void put_u32(std::vector<uint8_t>& out, uint32_t v)
+{
+    out.push_back((uint8_t)(v >> 24));
+    out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+static void put_chunk(std::vector<uint8_t>& out, const char type[4], const uint8_t* data, size_t len)
+{
+    put_u32(out, (uint32_t)len);
+    size_t crcStart = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (len > 0) {
+        out.insert(out.end(), data, data + len);
+    }
+    uint32_t crc = crc32(0L, out.data() + crcStart, (uInt)(len + 4));
+    put_u32(out, crc);
+}
+
+static inline uint8_t paeth(int a, int b, int c)
+{
+    int p  = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    if (pb <= pc) return (uint8_t)b;
+    return (uint8_t)c;
+}
+
+// 按 PNG 规范对一行做指定类型的滤波（位深不超过 8 时 bpp 取 1 字节）
+static void filter_row(int type, const uint8_t* cur, const uint8_t* prev, size_t len, uint8_t* out)
+{
+    for (size_t i = 0; i < len; i++) {
+        int a = i > 0 ? cur[i - 1] : 0;
+        int b = prev ? prev[i] : 0;
+        int c = (prev && i > 0) ? prev[i - 1] : 0;
+        switch (type) {
+            case 0: out[i] = cur[i]; break;
+            case 1: out[i] = (uint8_t)(cur[i] - a); break;
+            case 2: out[i] = (uint8_t)(cur[i] - b); break;
+            case 3: out[i] = (uint8_t)(cur[i] - ((a + b) >> 1)); break;
+            default: out[i] = (uint8_t)(cur[i] - paeth(a, b, c)); break;
+        }
+    }
+}
+
+std::vector<uint8_t> pack_gray_rows(const GrayImage& image, int bitDepth, size_t rowBytes)
+{
+    std::vector<uint8_t> packed(rowBytes * image.height, 0);
+    if (bitDepth == 8) {
+        memcpy(packed.data(), image.pixels.data(), packed.size());
+        return packed;
+    }
+
+    const int maxValue = (1 << bitDepth) - 1;
+    const int perByte  = 8 / bitDepth;
+    for (int y = 0; y < image.height; y++) {
+        const uint8_t* src = image.row(y);
+        uint8_t* dst       = packed.data() + rowBytes * y;
+        for (int x = 0; x < image.width; x++) {
+            int v = (src[x] * maxValue + 127) / 255;
+            dst[x / perByte] |= (uint8_t)(v << (8 - bitDepth * (x % perByte + 1)));
+        }
+    }
+    return packed;
+}
+
+// 按给定的每行滤波类型生成 IDAT 原始数据
+static std::vector<uint8_t> build_filtered(const std::vector<uint8_t>& packed, size_t rowBytes, int height,
+                                           const std::vector<uint8_t>& types)
+{
+    std::vector<uint8_t> raw((rowBytes + 1) * height);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* cur  = packed.data() + rowBytes * y;
+        const uint8_t* prev = y > 0 ? cur - rowBytes : nullptr;
+        uint8_t* out        = raw.data() + (rowBytes + 1) * y;
+        out[0]              = types[y];
+        filter_row(types[y], cur, prev, rowBytes, out + 1);
+    }
+    return raw;
+}
+
+// libpng 默认启发式：每行选择绝对值和最小的滤波器
+static std::vector<uint8_t> choose_min_sum(const std::vector<uint8_t>& packed, size_t rowBytes, int height)
+{
+    std::vector<uint8_t> types(height, 0);
+    std::vector<uint8_t> candidate(rowBytes);
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* cur  = packed.data() + rowBytes * y;
+        const uint8_t* prev = y > 0 ? cur - rowBytes : nullptr;
+
+        uint64_t bestCost = UINT64_MAX;
+        for (int type = 0; type < 5; type++) {
+            filter_row(type, cur, prev, rowBytes, candidate.data());
+            uint64_t cost = 0;
+            for (size_t i = 0; i < rowBytes; i++) {
+                cost += candidate[i] < 128 ? candidate[i] : 256 - candidate[i];
+            }
+            if (cost < bestCost) {
+                bestCost = cost;
+                types[y] = (uint8_t)type;
+            }
+        }
+    }
+    return types;
+}
+
+// 以实际压缩结果选择滤波器：把上一行（已选定）与候选行一起 deflate，取输出最短者。
+// 绝对值和对低位深打包数据几乎没有意义（一个字节里混着多个像素），这里直接度量字节数。
+static std::vector<uint8_t> choose_by_deflate(const std::vector<uint8_t>& packed, size_t rowBytes, int height)
+{
+    std::vector<uint8_t> types(height, 0);
+    std::vector<uint8_t> window(2 * (rowBytes + 1));
+    std::vector<uint8_t> scratch(compressBound((uLong)window.size()) + 64);
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, 9, Z_DEFLATED, 15, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return choose_min_sum(packed, rowBytes, height);
+    }
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* cur  = packed.data() + rowBytes * y;
+        const uint8_t* prev = y > 0 ? cur - rowBytes : nullptr;
+
+        // window 前半段是上一行已选定的滤波结果
+        size_t offset = 0;
+        if (prev) {
+            const uint8_t* prevPrev = y > 1 ? prev - rowBytes : nullptr;
+            window[0]               = types[y - 1];
+            filter_row(types[y - 1], prev, prevPrev, rowBytes, window.data() + 1);
+            offset = rowBytes + 1;
+        }
+
+        size_t bestSize = SIZE_MAX;
+        for (int type = 0; type < 5; type++) {
+            window[offset] = (uint8_t)type;
+            filter_row(type, cur, prev, rowBytes, window.data() + offset + 1);
+
+            deflateReset(&zs);
+            zs.next_in   = window.data();
+            zs.avail_in  = (uInt)(offset + rowBytes + 1);
+            zs.next_out  = scratch.data();
+            zs.avail_out = (uInt)scratch.size();
+            deflate(&zs, Z_FINISH);
+
+            if (zs.total_out < bestSize) {
+                bestSize = zs.total_out;
+                types[y] = (uint8_t)type;
+            }
+        }
+    }
+    deflateEnd(&zs);
+    return types;
+}
+
+static std::vector<uint8_t> zlib_compress(const std::vector<uint8_t>& raw, int level)
+{
+    uLongf zlen = compressBound((uLong)raw.size());
+    std::vector<uint8_t> zdata(zlen);
+    compress2(zdata.data(), &zlen, raw.data(), (uLong)raw.size(), level);
+    zdata.resize(zlen);
+    return zdata;
+}
+
+std::vector<uint8_t> encode_png_gray(const GrayImage& image, int compressionLevel, int bitDepth,
+                                     FilterStrategy strategy)
+{
+    if (bitDepth != 1 && bitDepth != 2 && bitDepth != 4) bitDepth = 8;
+
+    const size_t rowBytes        = ((size_t)image.width * bitDepth + 7) / 8;
+    std::vector<uint8_t> packed  = pack_gray_rows(image, bitDepth, rowBytes);
+
+    std::vector<uint8_t> zdata;
+    if (strategy == FilterStrategy::MinSum) {
+        zdata = zlib_compress(build_filtered(packed, rowBytes, image.height, choose_min_sum(packed, rowBytes, image.height)),
+                              compressionLevel);
+    } else {
+        // 候选：全 None、全 Up、绝对值和启发式、逐行 deflate 度量，整幅压缩后取最小
+        std::vector<std::vector<uint8_t>> candidates;
+        candidates.push_back(std::vector<uint8_t>(image.height, 0));
+        candidates.push_back(std::vector<uint8_t>(image.height, 2));
+        candidates.push_back(choose_min_sum(packed, rowBytes, image.height));
+        candidates.push_back(choose_by_deflate(packed, rowBytes, image.height));
+
+        for (const auto& types : candidates) {
+            std::vector<uint8_t> z = zlib_compress(build_filtered(packed, rowBytes, image.height, types), compressionLevel);
+            if (zdata.empty() || z.size() < zdata.size()) {
+                zdata.swap(z);
+            }
+        }
+    }
+
+    std::vector<uint8_t> out(PNG_SIGNATURE, PNG_SIGNATURE + 8);
+
+    uint8_t ihdr[13];
+    ihdr[0]  = (uint8_t)(image.width >> 24);
+    ihdr[1]  = (uint8_t)(image.width >> 16);
+    ihdr[2]  = (uint8_t)(image.width >> 8);
+    ihdr[3]  = (uint8_t)image.width;
+    ihdr[4]  = (uint8_t)(image.height >> 24);
+    ihdr[5]  = (uint8_t)(image.height >> 16);
+    ihdr[6]  = (uint8_t)(image.height >> 8);
+    ihdr[7]  = (uint8_t)image.height;
+    ihdr[8]  = (uint8_t)bitDepth;
+    ihdr[9]  = 0;  // color type: grayscale
+    ihdr[10] = 0;  // compression
+    ihdr[11] = 0;  // filter
+    ihdr[12] = 0;  // interlace
+    put_chunk(out, "IHDR", ihdr, sizeof(ihdr));
+    put_chunk(out, "IDAT", zdata.data(), zdata.size());
+    put_chunk(out, "IEND", nullptr, 0);
+    return out;
+}
+
+int png_bit_depth_for_levels(int levels)
+{
+    switch (levels) {
+        case 2: return 1;
+        case 4: return 2;
+        case 16: return 4;
+        default: return 8;
+    }
+}
+
+bool write_file(const std::string& path, const std::vector<uint8_t>& data)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    size_t written = fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+    return written == data.size();
+}
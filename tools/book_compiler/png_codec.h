@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "gray_image.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 读取任意 PNG 并转换为 8-bit 灰度（透明区域合成到白底）
+ * @return 失败时返回空图，错误信息写入 error
+ */
+GrayImage read_png_gray(const std::string& path, std::string* error = nullptr);
+
+/**
+ * @brief 滤波器选择策略
+ */
+enum class FilterStrategy {
+    MinSum,    // 每行取绝对值和最小的滤波器（libpng 默认启发式，速度快）
+    MinSize,   // 多种候选整幅压缩后取最小，低位深页面明显更小
+};
+
+/**
+ * @brief 编码为灰度 PNG（无 Alpha）
+ *
+ * @param bitDepth 1 / 2 / 4 / 8；低位深时像素按最近灰阶打包，
+ *                 输入应已量化到对应级数（见 png_bit_depth_for_levels）
+ */
+std::vector<uint8_t> encode_png_gray(const GrayImage& image, int compressionLevel = 9, int bitDepth = 8,
+                                     FilterStrategy strategy = FilterStrategy::MinSize);
+
+/**
+ * @brief 灰度级数对应的最小位深：2 → 1，4 → 2，16 → 4，其余 8
+ */
+int png_bit_depth_for_levels(int levels);
+
+/**
+ * @brief 把 8-bit 灰度打包为 bitDepth 位，高位在前，每行 rowBytes 字节；像素按最近灰阶取整
+ */
+std::vector<uint8_t> pack_gray_rows(const GrayImage& image, int bitDepth, size_t rowBytes);
+
+bool write_file(const std::string& path, const std::vector<uint8_t>& data);
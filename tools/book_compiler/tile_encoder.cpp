@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "tile_encoder.h"
+#include "png_codec.h"
+#include "tile_page.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+
+static void append_u16(std::vector<uint8_t>& out, uint16_t v)
+{
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+}
+
+static void append_u32(std::vector<uint8_t>& out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+// 裸 deflate（无 zlib 头和 Adler-32），设备端用 Inflater::Format::Raw 解压
+static std::vector<uint8_t> raw_deflate(const std::vector<uint8_t>& raw, int level)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, level, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
+
+    std::vector<uint8_t> out(deflateBound(&zs, (uLong)raw.size()));
+    zs.next_in   = const_cast<Bytef*>(raw.data());
+    zs.avail_in  = (uInt)raw.size();
+    zs.next_out  = out.data();
+    zs.avail_out = (uInt)out.size();
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+std::vector<uint8_t> encode_tile_page(const GrayImage& image, int bitDepth, int tileSize, int compressionLevel)
+{
+    if (bitDepth != 1 && bitDepth != 2 && bitDepth != 4) bitDepth = 8;
+    tileSize = std::max(1, std::min(255, tileSize));
+
+    const int cols  = (image.width + tileSize - 1) / tileSize;
+    const int rows  = (image.height + tileSize - 1) / tileSize;
+    const int count = cols * rows;
+    const int white = (1 << bitDepth) - 1;
+
+    std::vector<uint8_t> bitmap((count + 7) / 8, 0);
+    std::vector<uint8_t> table;
+    std::vector<uint8_t> data;
+
+    for (int t = 0; t < count; t++) {
+        const int x = (t % cols) * tileSize;
+        const int y = (t / cols) * tileSize;
+        const int w = std::min(tileSize, image.width - x);
+        const int h = std::min(tileSize, image.height - y);
+
+        GrayImage tile(w, h);
+        bool blank = true;
+        for (int row = 0; row < h; row++) {
+            const uint8_t* src = image.row(y + row) + x;
+            memcpy(tile.row(row), src, w);
+            for (int i = 0; i < w && blank; i++) {
+                // 打包后会取整到最白一级的像素同样视为空白
+                if ((src[i] * white + 127) / 255 != white) blank = false;
+            }
+        }
+        if (blank) continue;
+
+        const size_t rowBytes       = ((size_t)w * bitDepth + 7) / 8;
+        std::vector<uint8_t> packed = pack_gray_rows(tile, bitDepth, rowBytes);
+        std::vector<uint8_t> z      = raw_deflate(packed, compressionLevel);
+        if (z.size() > 0xFFFF) return {};  // 60 × 60 的 8-bit 块最坏也只有约 3.6KB，不会发生
+
+        bitmap[t >> 3] |= (uint8_t)(1 << (t & 7));
+        append_u32(table, book::tile_hash(packed.data(), packed.size()));
+        append_u16(table, (uint16_t)z.size());
+        data.insert(data.end(), z.begin(), z.end());
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve(book::TILE_PAGE_HEADER_SIZE + bitmap.size() + table.size() + data.size());
+    for (char c : {'P', 'S', '3', 'T'}) out.push_back((uint8_t)c);
+    append_u16(out, (uint16_t)book::TILE_PAGE_VERSION);
+    out.push_back((uint8_t)tileSize);
+    out.push_back((uint8_t)bitDepth);
+    append_u16(out, (uint16_t)image.width);
+    append_u16(out, (uint16_t)image.height);
+    append_u16(out, (uint16_t)cols);
+    append_u16(out, (uint16_t)rows);
+    out.insert(out.end(), bitmap.begin(), bitmap.end());
+    out.insert(out.end(), table.begin(), table.end());
+    out.insert(out.end(), data.begin(), data.end());
+    return out;
+}
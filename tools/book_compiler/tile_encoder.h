@@ -0,0 +1,21 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include "gray_image.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 编码为分块页面（格式见 main/book/tile_page.h）
+ *
+ * 全白块只在占用位图中记一位；其余块各自打包为 bitDepth 位并用裸 deflate 独立压缩。
+ * 输入应已量化到对应级数（见 png_bit_depth_for_levels）。
+ *
+ * @param tileSize 块边长，1 ~ 255
+ */
+std::vector<uint8_t> encode_tile_page(const GrayImage& image, int bitDepth, int tileSize = 60,
+                                      int compressionLevel = 9);
@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "work_stealing_pool.h"
+#include <algorithm>
+
+// 当前线程在池中的下标，非工作线程为 -1
+static thread_local int t_worker_index = -1;
+static thread_local const WorkStealingPool* t_worker_pool = nullptr;
+
+WorkStealingPool::WorkStealingPool(size_t threadCount)
+{
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < threadCount; i++) {
+        _workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        _threads.emplace_back([this, i]() { run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _stop = true;
+    }
+    _wake_cv.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    size_t index;
+    if (t_worker_pool == this && t_worker_index >= 0) {
+        index = (size_t)t_worker_index;
+    } else {
+        index = _next_queue.fetch_add(1, std::memory_order_relaxed) % _workers.size();
+    }
+
+    _pending.fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::lock_guard<std::mutex> lock(_workers[index]->mutex);
+        _workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // 持锁递增，保证等待中的线程不会错过唤醒
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _queued.fetch_add(1, std::memory_order_release);
+    }
+    _wake_cv.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(_wake_mutex);
+    _done_cv.wait(lock, [this]() { return _pending.load(std::memory_order_acquire) == 0; });
+}
+
+bool WorkStealingPool::popLocal(size_t index, Task& task)
+{
+    Worker& worker = *_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, Task& task)
+{
+    size_t count = _workers.size();
+    for (size_t offset = 1; offset < count; offset++) {
+        Worker& victim = *_workers[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) {
+            continue;
+        }
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        _steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::finishTask()
+{
+    if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _done_cv.notify_all();
+    }
+}
+
+void WorkStealingPool::run(size_t index)
+{
+    t_worker_index = (int)index;
+    t_worker_pool  = this;
+
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            _queued.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            finishTask();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_wake_mutex);
+        _wake_cv.wait(lock, [this]() { return _stop || _queued.load(std::memory_order_acquire) > 0; });
+        if (_stop && _queued.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
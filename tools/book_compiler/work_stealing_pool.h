@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 工作窃取线程池
+ *
+ * 每个工作线程持有自己的双端队列：
+ * - 线程内提交的任务压入自己队列尾部，并从尾部取出（LIFO，缓存友好）
+ * - 空闲线程从其他线程队列头部窃取（FIFO，优先偷走粒度最大的任务）
+ *
+ * 章节任务会在工作线程内继续拆分出页面任务，长章节因此能被所有核心分担。
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(size_t threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&)            = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief 提交任务；工作线程内调用时进入本线程队列，否则轮询分配
+     */
+    void submit(Task task);
+
+    /**
+     * @brief 阻塞直到所有已提交任务（包括任务中派生的任务）执行完毕
+     */
+    void wait();
+
+    size_t threadCount() const
+    {
+        return _workers.size();
+    }
+    uint64_t stealCount() const
+    {
+        return _steals.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::vector<std::thread> _threads;
+
+    std::mutex _wake_mutex;
+    std::condition_variable _wake_cv;
+    std::condition_variable _done_cv;
+
+    std::atomic<size_t> _queued{0};    // 队列中尚未被取走的任务数
+    std::atomic<size_t> _pending{0};   // 已提交但未执行完的任务数
+    std::atomic<size_t> _next_queue{0};
+    std::atomic<uint64_t> _steals{0};
+    bool _stop = false;
+
+    void run(size_t index);
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+    void finishTask();
+};
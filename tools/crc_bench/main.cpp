@@ -0,0 +1,211 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "crc32c.h"
+#include "file_checksums.h"
+#include "bench_util.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace book;
+
+static double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static volatile uint32_t sink;
+
+// 各实现与逐字节查表逐一对照：长度 0..1024、起始地址 8 种对齐、任意分块
+static int check_kernels(const std::vector<uint8_t>& data)
+{
+    const Crc32cKernel kernels[] = {Crc32cKernel::Slice8, Crc32cKernel::Sse42, Crc32cKernel::Auto};
+    std::mt19937 rng(7);
+    int mismatches = 0;
+    for (Crc32cKernel kernel : kernels) {
+        if (!crc32c_kernel_available(kernel)) continue;
+        for (size_t len = 0; len <= 1024; len++) {
+            size_t offset = len % 8;
+            uint32_t ref  = crc32c_update(0, data.data() + offset, len, Crc32cKernel::Bytewise);
+            uint32_t one  = crc32c_update(0, data.data() + offset, len, kernel);
+            size_t split  = len ? rng() % len : 0;
+            uint32_t two  = crc32c_update(crc32c_update(0, data.data() + offset, split, kernel),
+                                          data.data() + offset + split, len - split, kernel);
+            if (one != ref || two != ref) mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static bool check_parse()
+{
+    uint32_t crc = 0;
+    bool ok      = parse_crc32c("e3069283", crc) && crc == 0xE3069283;
+    ok           = ok && parse_crc32c("crc32c=E3069283", crc) && crc == 0xE3069283;
+    ok           = ok && parse_crc32c(" 1f ", crc) && crc == 0x1F;
+    ok           = ok && !parse_crc32c("", crc) && !parse_crc32c("123456789", crc) && !parse_crc32c("12g4", crc);
+    ok           = ok && !parse_crc32c("crc32c=", crc) && !parse_crc32c("12 34", crc);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    std::string root  = "/tmp/crc_bench";
+    double minSeconds = 0.3;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--dir" && i + 1 < argc) {
+            root = argv[++i];
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            minSeconds = atof(argv[++i]);
+        } else {
+            printf("Usage: %s [--dir PATH] [--seconds S]\n", argv[0]);
+            printf("\n");
+            printf("  Checks every CRC32C kernel against the bytewise reference, measures their\n");
+            printf("  throughput, the cost of computing the CRC while writing an upload, and the cost\n");
+            printf("  of sampled page verification when reading a section back. --dir is wiped first.\n");
+            return 1;
+        }
+    }
+
+    std::vector<uint8_t> buffer(1 << 20);
+    std::mt19937 rng(1);
+    for (auto& b : buffer) b = (uint8_t)rng();
+
+    bool ok        = crc32c("123456789", 9) == 0xE3069283;
+    int mismatches = check_kernels(buffer);
+    bool parsed    = check_parse();
+    printf("check:     check value %s, kernel mismatches %d, X-Checksum parsing %s\n", ok ? "ok" : "FAILED",
+           mismatches, parsed ? "ok" : "FAILED");
+    ok = ok && mismatches == 0 && parsed;
+
+    // 吞吐量：1MB 缓冲反复计算
+    printf("\n%-10s %10s\n", "kernel", "MB/s");
+    const Crc32cKernel kernels[] = {Crc32cKernel::Bytewise, Crc32cKernel::Slice8, Crc32cKernel::Sse42};
+    for (Crc32cKernel kernel : kernels) {
+        if (!crc32c_kernel_available(kernel)) {
+            printf("%-10s %10s\n", crc32c_kernel_name(kernel), "n/a");
+            continue;
+        }
+        size_t bytes = 0;
+        auto start   = Clock::now();
+        uint32_t crc = 0;
+        do {
+            crc = crc32c_update(crc, buffer.data(), buffer.size(), kernel);
+            bytes += buffer.size();
+        } while (seconds_since(start) < minSeconds);
+        sink = crc;
+        printf("%-10s %10.0f\n", crc32c_kernel_name(kernel), bytes / 1048576.0 / seconds_since(start));
+    }
+
+    remove_tree(root);
+    mkdir(root.c_str(), 0755);
+
+    // 上传：按 256KB 块写入（文件服务器的接收缓冲），对比写入时是否同时计算 CRC
+    auto upload = [&](bool withCrc) {
+        std::string path = root + "/upload.bin";
+        size_t bytes     = 0;
+        auto start       = Clock::now();
+        do {
+            FILE* f      = fopen(path.c_str(), "wb");
+            uint32_t crc = 0;
+            for (int i = 0; i < 16; i++) {
+                for (size_t off = 0; off < buffer.size(); off += 256 * 1024) {
+                    fwrite(buffer.data() + off, 1, 256 * 1024, f);
+                    if (withCrc) crc = crc32c_update(crc, buffer.data() + off, 256 * 1024);
+                }
+            }
+            fclose(f);
+            sink = crc;
+            bytes += buffer.size() * 16;
+        } while (seconds_since(start) < minSeconds);
+        return bytes / 1048576.0 / seconds_since(start);
+    };
+    double plain = upload(false);
+    double crced = upload(true);
+    printf("\nupload:    write %.0f MB/s, write + crc32c %.0f MB/s (%.1f%% slower)\n", plain, crced,
+           100.0 * (plain - crced) / plain);
+
+    // 阅读：一章 60 页写入并记录校验和，反复整页读入内存，分别按 关闭 / 每 4 页 / 每页 校验
+    std::string section = root + "/sections/001";
+    mkdir((root + "/sections").c_str(), 0755);
+    mkdir(section.c_str(), 0755);
+    std::vector<std::string> pages;
+    for (int p = 1; p <= 60; p++) {
+        char name[16];
+        snprintf(name, sizeof(name), "/%03d.png", p);
+        std::string path = section + name;
+        size_t size      = 20 * 1024 + rng() % (40 * 1024);
+        FILE* f          = fopen(path.c_str(), "wb");
+        fwrite(buffer.data() + p, 1, size, f);
+        fclose(f);
+        ChecksumSidecar::record(path, size, crc32c(buffer.data() + p, size));
+        pages.push_back(path);
+    }
+    std::vector<uint8_t> page(64 * 1024);
+    auto read_pages = [&](uint32_t every, uint32_t& corrupt) {
+        ChecksumSampler sampler(every);
+        size_t count = 0;
+        auto start   = Clock::now();
+        do {
+            for (const auto& path : pages) {
+                FILE* f  = fopen(path.c_str(), "rb");
+                size_t n = fread(page.data(), 1, page.size(), f);
+                fclose(f);
+                sampler.verify(path, page.data(), n);
+                count++;
+            }
+        } while (seconds_since(start) < minSeconds);
+        corrupt = sampler.corrupt();
+        return count / seconds_since(start);
+    };
+    uint32_t corrupt = 0, falseAlarms = 0;
+    double off     = read_pages(0, corrupt);
+    double sampled = read_pages(PAGE_VERIFY_EVERY, corrupt);
+    falseAlarms += corrupt;
+    double every = read_pages(1, corrupt);
+    falseAlarms += corrupt;
+    printf("read:      %.0f pages/s unverified, %.0f verifying every %u pages (%.1f%% slower),\n", off, sampled,
+           (unsigned)PAGE_VERIFY_EVERY, 100.0 * (off - sampled) / off);
+    printf("           %.0f verifying every page (%.1f%% slower)\n", every, 100.0 * (off - every) / off);
+
+    // 翻转一个被抽中的页面（每 4 页的第 4 页）中的一个字节：抽样时发现，之后重读这一页每次都校验
+    std::string bad = pages[PAGE_VERIFY_EVERY * 3 - 1];
+    {
+        FILE* f = fopen(bad.c_str(), "r+b");
+        fseek(f, 100, SEEK_SET);
+        int c = fgetc(f);
+        fseek(f, 100, SEEK_SET);
+        fputc(c ^ 0x01, f);
+        fclose(f);
+    }
+    ChecksumSampler sampler(PAGE_VERIFY_EVERY);
+    auto verify = [&](const std::string& path) {
+        FILE* f  = fopen(path.c_str(), "rb");
+        size_t n = fread(page.data(), 1, page.size(), f);
+        fclose(f);
+        return sampler.verify(path, page.data(), n);
+    };
+    int detected = 0;
+    for (const auto& path : pages) {
+        if (verify(path) == VerifyResult::Corrupt) detected++;
+    }
+    bool retried = verify(bad) == VerifyResult::Corrupt && verify(bad) == VerifyResult::Corrupt;
+    bool caught  = falseAlarms == 0 && detected == 1 && retried;
+    printf("checks:    no false alarms, flipped byte found by sampling and on every re-read: %s\n",
+           caught ? "ok" : "FAILED");
+    ok = ok && caught;
+
+    remove_tree(root);
+    return ok ? 0 : 1;
+}
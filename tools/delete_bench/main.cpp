@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "delete_jobs.h"
+#include "bench_util.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// 模拟一本图片书：封面、metadata 和 sections/{章}/{页}.png
+static size_t make_book(const std::string& dir, size_t sections, size_t pages)
+{
+    size_t files = 0;
+    mkdir(dir.c_str(), 0755);
+    mkdir((dir + "/sections").c_str(), 0755);
+    for (const char* name : {"/cover.png", "/metadata.json"}) {
+        FILE* f = fopen((dir + name).c_str(), "wb");
+        if (f) fclose(f), files++;
+    }
+    for (size_t s = 0; s < sections; s++) {
+        char sec[32];
+        snprintf(sec, sizeof(sec), "/sections/%03zu", s);
+        mkdir((dir + sec).c_str(), 0755);
+        for (size_t p = 0; p < pages; p++) {
+            char page[48];
+            snprintf(page, sizeof(page), "%s/%03zu.png", sec, p);
+            FILE* f = fopen((dir + page).c_str(), "wb");
+            if (!f) continue;
+            fputs("page", f);
+            fclose(f);
+            files++;
+        }
+    }
+    return files;
+}
+
+// 改动前 handleRmdir 的做法：每个条目 stat，递归
+static bool remove_recursive(const std::string& path)
+{
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return false;
+    bool ok = true;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string item = path + "/" + entry->d_name;
+        struct stat st;
+        if (stat(item.c_str(), &st) != 0) {
+            ok = false;
+            continue;
+        }
+        ok = (S_ISDIR(st.st_mode) ? remove_recursive(item) : remove(item.c_str()) == 0) && ok;
+    }
+    closedir(dir);
+    return rmdir(path.c_str()) == 0 && ok;
+}
+
+static bool wait_idle(book::DeleteJobQueue& queue, double timeoutMs)
+{
+    auto start = Clock::now();
+    while (queue.busy()) {
+        if (elapsed_ms(start) > timeoutMs) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+static bool exists(const std::string& path)
+{
+    return access(path.c_str(), F_OK) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    std::string root = "/tmp/delete_bench";
+    size_t sections  = 20;
+    size_t pages     = 60;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--dir" && i + 1 < argc) {
+            root = argv[++i];
+        } else if (arg == "--sections" && i + 1 < argc) {
+            sections = (size_t)atol(argv[++i]);
+        } else if (arg == "--pages" && i + 1 < argc) {
+            pages = (size_t)atol(argv[++i]);
+        } else {
+            printf("Usage: %s [--dir PATH] [--sections N] [--pages N]\n", argv[0]);
+            printf("\n");
+            printf("  Builds a book tree of --sections x --pages files under --dir (it is wiped first) and\n");
+            printf("  deletes it synchronously with per-entry stat(), then through a DeleteJobQueue. Reports\n");
+            printf("  how long the request would block in each case, checks the job counts, and simulates a\n");
+            printf("  reboot in the middle of a job by resuming a half-deleted tombstone with a fresh queue.\n");
+            return 1;
+        }
+    }
+    remove_recursive(root);
+    mkdir(root.c_str(), 0755);
+    std::string trash = root + "/.trash";
+
+    // 同步删除
+    size_t files = make_book(root + "/sync_book", sections, pages);
+    auto start   = Clock::now();
+    bool syncOk  = remove_recursive(root + "/sync_book");
+    double syncMs = elapsed_ms(start);
+    printf("book:      %zu files in %zu directories\n", files, sections + 2);
+    printf("sync:      request blocked %.2f ms (%s)\n", syncMs, syncOk ? "ok" : "FAILED");
+
+    // 后台删除
+    bool ok = syncOk;
+    {
+        book::DeleteJobQueue queue(trash);
+        make_book(root + "/book", sections, pages);
+        start           = Clock::now();
+        uint32_t id     = queue.enqueue(root + "/book");
+        double enqueueMs = elapsed_ms(start);
+        bool gone       = !exists(root + "/book");
+        bool idle       = wait_idle(queue, 60000);
+        double totalMs  = elapsed_ms(start);
+        book::DeleteJobStatus job;
+        bool counted = queue.status(id, job) && job.state == "done" && job.files == files &&
+                       job.dirs == sections + 2 && job.errors == 0 && !exists(trash + "/" + std::to_string(id));
+        printf("job:       request blocked %.3f ms, deleted in background over %.1f ms "
+               "(%d-entry batches, %d ms pauses)\n",
+               enqueueMs, totalMs, book::DELETE_BATCH_SIZE, book::DELETE_BATCH_PAUSE_MS);
+        printf("checks:    path gone at once, %u files / %u dirs deleted: %s\n", job.files, job.dirs,
+               id && gone && idle && counted ? "ok" : "FAILED");
+        ok = ok && id && gone && idle && counted;
+
+        bool rejected = queue.enqueue(trash) == 0 && queue.enqueue(root + "/missing") == 0;
+        printf("checks:    trash and missing paths rejected: %s\n", rejected ? "ok" : "FAILED");
+        ok = ok && rejected;
+    }
+
+    // 重启：墓碑删了一半，状态文件停在 running
+    {
+        std::string tomb = trash + "/7";
+        make_book(tomb, sections, pages);
+        remove_recursive(tomb + "/sections/000");
+        remove((tomb + "/cover.png").c_str());
+        FILE* f = fopen((trash + "/7.job").c_str(), "wb");
+        if (f) {
+            fprintf(f, "%s\nrunning %zu 1 0\n", (root + "/old_book").c_str(), pages + 1);
+            fclose(f);
+        }
+        // 状态文件丢失的墓碑
+        make_book(trash + "/9", 1, 5);
+
+        book::DeleteJobQueue queue(trash);
+        queue.resume();
+        bool idle = wait_idle(queue, 60000);
+        book::DeleteJobStatus a, b;
+        bool resumed = queue.status(7, a) && a.state == "done" && a.files == files && a.dirs == sections + 2 &&
+                       a.path == root + "/old_book" && queue.status(9, b) && b.state == "done" && b.files == 7 &&
+                       !exists(trash + "/7") && !exists(trash + "/9");
+        uint32_t next = queue.enqueue((make_book(root + "/next", 1, 1), root + "/next"));
+        idle          = wait_idle(queue, 60000) && idle;
+        printf("reboot:    resumed job 7 (%u files total) and orphan tombstone 9, next id %u: %s\n", a.files, next,
+               idle && resumed && next == 10 ? "ok" : "FAILED");
+        ok = ok && idle && resumed && next == 10;
+    }
+
+    remove_recursive(root);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,433 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "dictionary.h"
+#include "text_book.h"
+#include "bench_util.h"
+#include <zlib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static void print_usage(const char* prog)
+{
+    printf("Usage: %s <input> <output.pdict> [options]\n", prog);
+    printf("\n");
+    printf("  input        StarDict .ifo (with .idx/.idx.gz and .dict/.dict.dz next to it),\n");
+    printf("               or a UTF-8 TSV file: headword<TAB>definition, \\n and \\t escapes in the definition\n");
+    printf("  output       compiled dictionary, copy it to /sdcard/dict/ on the device\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  --name NAME        dictionary name shown on the device (default: bookname or file name)\n");
+    printf("  --synthetic N      ignore <input> and generate N synthetic entries (English and Chinese)\n");
+    printf("  --bench N          run N lookups against the compiled file and check them against the source\n");
+}
+
+// 整个文件读入内存，.gz / .dz（dictzip 与 gzip 兼容）自动解压
+static bool read_file(const fs::path& path, std::string& data)
+{
+    std::string ext = path.extension().string();
+    if (ext == ".gz" || ext == ".dz") {
+        gzFile gz = gzopen(path.string().c_str(), "rb");
+        if (!gz) return false;
+        char buffer[64 * 1024];
+        int n = 0;
+        data.clear();
+        while ((n = gzread(gz, buffer, sizeof(buffer))) > 0) data.append(buffer, n);
+        bool ok = n == 0;
+        gzclose(gz);
+        return ok;
+    }
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    data = ss.str();
+    return true;
+}
+
+static bool find_existing(const fs::path& base, const std::vector<std::string>& suffixes, fs::path& found)
+{
+    for (const auto& suffix : suffixes) {
+        fs::path candidate = base.string() + suffix;
+        if (fs::exists(candidate)) {
+            found = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// HTML / XDXF 释义去掉标签，换行类标签转为换行，解码常见实体
+static std::string strip_markup(const std::string& text)
+{
+    static const std::pair<const char*, const char*> ENTITIES[] = {
+        {"&lt;", "<"}, {"&gt;", ">"}, {"&amp;", "&"}, {"&quot;", "\""}, {"&apos;", "'"}, {"&nbsp;", " "}};
+    std::string out;
+    for (size_t i = 0; i < text.size();) {
+        if (text[i] == '<') {
+            size_t end = text.find('>', i);
+            if (end == std::string::npos) break;
+            std::string tag = text.substr(i + 1, std::min<size_t>(end - i - 1, 8));
+            for (auto& c : tag) c = (char)tolower((unsigned char)c);
+            if (tag.rfind("br", 0) == 0 || tag.rfind("/p", 0) == 0 || tag.rfind("/div", 0) == 0 ||
+                tag.rfind("/li", 0) == 0 || tag.rfind("/k", 0) == 0) {
+                if (!out.empty() && out.back() != '\n') out.push_back('\n');
+            }
+            i = end + 1;
+            continue;
+        }
+        if (text[i] == '&') {
+            bool matched = false;
+            for (const auto& entity : ENTITIES) {
+                size_t len = strlen(entity.first);
+                if (text.compare(i, len, entity.first) == 0) {
+                    out += entity.second;
+                    i += len;
+                    matched = true;
+                    break;
+                }
+            }
+            if (matched) continue;
+        }
+        out.push_back(text[i++]);
+    }
+    while (!out.empty() && (out.back() == '\n' || out.back() == ' ')) out.pop_back();
+    return out;
+}
+
+// 一个 StarDict 字段：小写类型为以 0 结尾（最后一个字段可省略）的文字，大写类型为 u32 长度 + 二进制数据
+static std::string stardict_text(char type, const std::string& data)
+{
+    if (type == 'h' || type == 'x' || type == 'g') return strip_markup(data);
+    if (type == 'm' || type == 't' || type == 'y' || type == 'l' || type == 'k' || type == 'w' || type == 'r') {
+        return data;
+    }
+    return std::string();
+}
+
+static std::string stardict_definition(const std::string& record, const std::string& sameTypes)
+{
+    std::string out;
+    auto add = [&](const std::string& text) {
+        if (text.empty()) return;
+        if (!out.empty()) out += "\n";
+        out += text;
+    };
+
+    size_t pos = 0;
+    if (!sameTypes.empty()) {
+        // 各字段没有类型字符，最后一个字段到记录末尾
+        for (size_t t = 0; t < sameTypes.size() && pos <= record.size(); t++) {
+            char type = sameTypes[t];
+            bool last = t + 1 == sameTypes.size();
+            if (isupper((unsigned char)type)) {
+                if (last) break;
+                if (pos + 4 > record.size()) break;
+                uint32_t size = ((uint8_t)record[pos] << 24) | ((uint8_t)record[pos + 1] << 16) |
+                                ((uint8_t)record[pos + 2] << 8) | (uint8_t)record[pos + 3];
+                pos += 4 + size;
+                continue;
+            }
+            size_t end = last ? record.size() : record.find('\0', pos);
+            if (end == std::string::npos) end = record.size();
+            add(stardict_text(type, record.substr(pos, end - pos)));
+            pos = end + 1;
+        }
+        return out;
+    }
+
+    while (pos < record.size()) {
+        char type = record[pos++];
+        if (isupper((unsigned char)type)) {
+            if (pos + 4 > record.size()) break;
+            uint32_t size = ((uint8_t)record[pos] << 24) | ((uint8_t)record[pos + 1] << 16) |
+                            ((uint8_t)record[pos + 2] << 8) | (uint8_t)record[pos + 3];
+            pos += 4 + size;
+            continue;
+        }
+        size_t end = record.find('\0', pos);
+        if (end == std::string::npos) end = record.size();
+        add(stardict_text(type, record.substr(pos, end - pos)));
+        pos = end + 1;
+    }
+    return out;
+}
+
+static bool load_stardict(const fs::path& ifoPath, std::string& name, std::vector<book::DictionaryEntry>& entries,
+                          std::string& error)
+{
+    std::string ifo;
+    if (!read_file(ifoPath, ifo)) {
+        error = "Failed to read " + ifoPath.string();
+        return false;
+    }
+    std::map<std::string, std::string> info;
+    std::istringstream lines(ifo);
+    for (std::string line; std::getline(lines, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t eq = line.find('=');
+        if (eq != std::string::npos) info[line.substr(0, eq)] = line.substr(eq + 1);
+    }
+    if (name.empty()) name = info["bookname"];
+    bool offset64          = info["idxoffsetbits"] == "64";
+    std::string sameTypes  = info["sametypesequence"];
+
+    fs::path base = ifoPath;
+    base.replace_extension();
+    fs::path idxPath, dictPath;
+    if (!find_existing(base, {".idx", ".idx.gz"}, idxPath) || !find_existing(base, {".dict", ".dict.dz"}, dictPath)) {
+        error = "Missing .idx or .dict next to " + ifoPath.string();
+        return false;
+    }
+    std::string idx, dict;
+    if (!read_file(idxPath, idx) || !read_file(dictPath, dict)) {
+        error = "Failed to read " + idxPath.string() + " / " + dictPath.string();
+        return false;
+    }
+
+    // .idx：{ 以 0 结尾的词头, u32 / u64 偏移, u32 长度 }，大端
+    size_t numberSize = offset64 ? 12 : 8;
+    for (size_t pos = 0; pos < idx.size();) {
+        size_t end = idx.find('\0', pos);
+        if (end == std::string::npos || end + 1 + numberSize > idx.size()) {
+            error = "Truncated " + idxPath.string();
+            return false;
+        }
+        const uint8_t* p = (const uint8_t*)idx.data() + end + 1;
+        uint64_t offset  = 0;
+        for (size_t i = 0; i < numberSize - 4; i++) offset = (offset << 8) | p[i];
+        p += numberSize - 4;
+        uint32_t size = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+        if (offset + size > dict.size()) {
+            error = "Definition out of range in " + dictPath.string();
+            return false;
+        }
+        book::DictionaryEntry entry;
+        entry.headword   = idx.substr(pos, end - pos);
+        entry.definition = stardict_definition(dict.substr((size_t)offset, size), sameTypes);
+        entries.push_back(std::move(entry));
+        pos = end + 1 + numberSize;
+    }
+    return true;
+}
+
+static bool load_tsv(const fs::path& path, std::vector<book::DictionaryEntry>& entries, std::string& error)
+{
+    std::string data;
+    if (!read_file(path, data)) {
+        error = "Failed to read " + path.string();
+        return false;
+    }
+    std::istringstream lines(data);
+    for (std::string line; std::getline(lines, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos || line[0] == '#') continue;
+        book::DictionaryEntry entry;
+        entry.headword = line.substr(0, tab);
+        for (size_t i = tab + 1; i < line.size(); i++) {
+            if (line[i] == '\\' && i + 1 < line.size() && (line[i + 1] == 'n' || line[i + 1] == 't')) {
+                entry.definition.push_back(line[++i] == 'n' ? '\n' : '\t');
+            } else {
+                entry.definition.push_back(line[i]);
+            }
+        }
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+static std::string utf8(uint32_t codepoint)
+{
+    char out[4];
+    return std::string(out, book::encode_utf8(codepoint, out));
+}
+
+// 合成词典：约一半英文单词（3-12 个字母，少量首字母大写的重复词头），一半中文词（1-4 字，常用字按齐夫分布）
+static std::vector<book::DictionaryEntry> make_synthetic(size_t count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint32_t> pool;
+    for (uint32_t cp = 0x4E00; cp < 0x4E00 + 4000; cp++) pool.push_back(cp);
+    std::shuffle(pool.begin(), pool.end(), rng);
+    std::vector<double> weights(pool.size());
+    for (size_t i = 0; i < pool.size(); i++) weights[i] = 1.0 / (double)(i + 20);
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+
+    std::vector<book::DictionaryEntry> entries;
+    for (size_t i = 0; i < count; i++) {
+        book::DictionaryEntry entry;
+        if (i % 2 == 0) {
+            int len = 3 + rng() % 10;
+            for (int c = 0; c < len; c++) entry.headword.push_back((char)('a' + rng() % 26));
+            if (rng() % 20 == 0) entry.headword[0] = (char)(entry.headword[0] - 32);
+            entry.definition = "n. " + entry.headword + " 的释义";
+        } else {
+            int len = 1 + rng() % 4;
+            for (int c = 0; c < len; c++) entry.headword += utf8(pool[pick(rng)]);
+            entry.definition = "【" + entry.headword + "】";
+        }
+        int extra = 20 + rng() % 200;
+        for (int c = 0; c < extra; c++) entry.definition += utf8(pool[pick(rng)]);
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+static double percentile(std::vector<double> values, double p)
+{
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+// 查词耗时与正确性：随机选取已有词头（原文写法）、不存在的词和带后缀的中文取词
+static int run_bench(const std::string& path, const std::vector<book::DictionaryEntry>& source, size_t count)
+{
+    // 与编译器相同的归一化和合并，作为正确结果
+    std::map<std::string, std::string> expected;
+    for (const auto& entry : source) {
+        std::string key = book::fold_dictionary_key(entry.headword);
+        if (key.empty() || key.size() > book::DICTIONARY_MAX_KEY_BYTES || entry.definition.empty()) continue;
+        auto it = expected.find(key);
+        if (it == expected.end()) {
+            expected[key] = entry.definition;
+        } else {
+            it->second += "\n\n" + entry.definition;
+        }
+    }
+
+    auto start = Clock::now();
+    book::Dictionary dict;
+    if (!dict.open(path)) {
+        fprintf(stderr, "Failed to open %s\n", path.c_str());
+        return 1;
+    }
+    printf("open:      %.2f ms, %.1f KB resident, %u entries\n", elapsed_ms(start), dict.memoryBytes() / 1024.0,
+           dict.entryCount());
+
+    std::mt19937 rng(7);
+    std::vector<double> hits, misses, longest;
+    uint32_t reads = 0, longestReads = 0, mismatches = 0;
+    book::DictionaryEntry entry;
+    for (size_t i = 0; i < count; i++) {
+        const auto& item = source[rng() % source.size()];
+        std::string key  = book::fold_dictionary_key(item.headword);
+        auto it          = expected.find(key);
+        if (it == expected.end()) continue;
+
+        uint32_t before = dict.reads();
+        start           = Clock::now();
+        bool found      = dict.lookup(item.headword, entry);
+        hits.push_back(elapsed_ms(start));
+        reads += dict.reads() - before;
+        if (!found || entry.definition != it->second) mismatches++;
+
+        // 不存在的词：在词头后加一个不会出现的字符
+        start = Clock::now();
+        if (dict.lookup(item.headword + "\xE3\x80\x87", entry)) mismatches++;
+        misses.push_back(elapsed_ms(start));
+
+        // 中文取词：词头后接几个字，应得到不短于词头的匹配
+        if ((uint8_t)key[0] >= 0x80) {
+            std::string text = key + "的一是了";
+            before           = dict.reads();
+            start            = Clock::now();
+            found            = dict.lookupLongest(text, entry);
+            longest.push_back(elapsed_ms(start));
+            longestReads += dict.reads() - before;
+            if (!found || entry.headword.size() < key.size() || text.compare(0, entry.headword.size(), entry.headword)) {
+                mismatches++;
+            }
+        }
+    }
+
+    printf("lookup:    %zu hits, p50 %.3f ms, p99 %.3f ms, max %.3f ms, %.2f reads each\n", hits.size(),
+           percentile(hits, 0.5), percentile(hits, 0.99), percentile(hits, 1.0),
+           hits.empty() ? 0.0 : (double)reads / hits.size());
+    printf("miss:      p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", percentile(misses, 0.5), percentile(misses, 0.99),
+           percentile(misses, 1.0));
+    printf("longest:   %zu lookups, p50 %.3f ms, p99 %.3f ms, max %.3f ms, %.2f reads each\n", longest.size(),
+           percentile(longest, 0.5), percentile(longest, 0.99), percentile(longest, 1.0),
+           longest.empty() ? 0.0 : (double)longestReads / longest.size());
+    printf("check:     %u mismatches\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    fs::path input  = argv[1];
+    fs::path output = argv[2];
+    std::string name;
+    size_t synthetic = 0;
+    size_t bench     = 0;
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (arg == "--synthetic" && i + 1 < argc) {
+            synthetic = (size_t)atol(argv[++i]);
+        } else if (arg == "--bench" && i + 1 < argc) {
+            bench = (size_t)atol(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<book::DictionaryEntry> entries;
+    std::string error;
+    auto start = Clock::now();
+    if (synthetic > 0) {
+        entries = make_synthetic(synthetic, 1);
+        if (name.empty()) name = "synthetic";
+    } else if (input.extension() == ".ifo") {
+        if (!load_stardict(input, name, entries, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    } else if (!load_tsv(input, entries, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (name.empty()) name = input.stem().string();
+    double loadMs = elapsed_ms(start);
+
+    std::vector<book::DictionaryEntry> source;
+    if (bench > 0) source = entries;
+
+    book::DictionaryBuildStats stats;
+    start = Clock::now();
+    if (!book::write_dictionary(output.string(), name, entries, stats, error)) {
+        fprintf(stderr, "Compile failed: %s\n", error.c_str());
+        return 1;
+    }
+    printf("source:    %u entries in %.1f ms\n", stats.sourceEntries, loadMs);
+    printf("compiled:  %u entries (%u merged, %u skipped), %u blocks in %.1f ms\n", stats.entries, stats.merged,
+           stats.skipped, stats.blocks, elapsed_ms(start));
+    printf("size:      %.2f MB, keys %.1f KB front-coded (StarDict .idx: %.1f KB), %.1f KB resident on the device\n",
+           stats.bytes / 1048576.0, stats.keyBytes / 1024.0, stats.idxBytes / 1024.0,
+           stats.residentBytes / 1024.0);
+    printf("written:   %s (%s)\n", output.string().c_str(), name.c_str());
+
+    return bench > 0 ? run_bench(output.string(), source, bench) : 0;
+}
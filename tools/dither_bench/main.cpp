@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "dither.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace book;
+
+struct TestImage {
+    const char* name;
+    int width;
+    int height;
+    std::vector<uint8_t> pixels;
+};
+
+// 横向渐变 + 纵向正弦 + 噪声，覆盖全部 256 个灰度值
+static TestImage make_image(const char* name, int width, int height, unsigned seed)
+{
+    TestImage image{name, width, height, std::vector<uint8_t>((size_t)width * height)};
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> noise(-24, 24);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double v = 255.0 * x / (width - 1) * 0.7 + 40.0 * std::sin(y * 0.05) + 30;
+            int p    = (int)v + noise(gen);
+            image.pixels[(size_t)y * width + x] = (uint8_t)(p < 0 ? 0 : (p > 255 ? 255 : p));
+        }
+    }
+    return image;
+}
+
+int main(int argc, char** argv)
+{
+    double minSeconds = argc > 1 ? atof(argv[1]) : 0.2;
+
+    std::vector<TestImage> images;
+    images.push_back(make_image("page 540x900", 540, 900, 1));
+    images.push_back(make_image("odd 541x907", 541, 907, 2));
+    images.push_back(make_image("large 2160x3600", 2160, 3600, 3));
+
+    const DitherMethod methods[] = {DitherMethod::None, DitherMethod::Ordered, DitherMethod::FloydSteinberg,
+                                    DitherMethod::Atkinson};
+    const DitherKernel kernels[] = {DitherKernel::Scalar, DitherKernel::Pie, DitherKernel::Sse2,
+                                    DitherKernel::Avx2};
+    const int levelsList[]       = {2, 4, 16};
+
+    int mismatches = 0;
+
+    printf("%-16s %-9s %6s %-7s %10s  %s\n", "image", "method", "levels", "kernel", "MP/s", "check");
+    for (const auto& image : images) {
+        for (DitherMethod method : methods) {
+            for (int levels : levelsList) {
+                std::vector<uint8_t> reference = image.pixels;
+                dither_gray(reference.data(), image.width, image.height, image.width, levels, method,
+                            DitherKernel::Scalar);
+
+                bool diffusion = method == DitherMethod::FloydSteinberg || method == DitherMethod::Atkinson;
+                for (DitherKernel kernel : kernels) {
+                    if (!dither_kernel_available(kernel)) continue;
+                    // 误差扩散在所有内核下都走同一份标量代码，只测一次
+                    if (diffusion && kernel != DitherKernel::Scalar) continue;
+
+                    // 逐像素对比参考实现
+                    std::vector<uint8_t> work = image.pixels;
+                    dither_gray(work.data(), image.width, image.height, image.width, levels, method, kernel);
+                    bool match = memcmp(work.data(), reference.data(), work.size()) == 0;
+                    if (!match) mismatches++;
+
+                    int iterations = 0;
+                    auto start     = std::chrono::steady_clock::now();
+                    double elapsed = 0;
+                    while (elapsed < minSeconds) {
+                        memcpy(work.data(), image.pixels.data(), work.size());
+                        dither_gray(work.data(), image.width, image.height, image.width, levels, method, kernel);
+                        iterations++;
+                        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    }
+
+                    double mps = (double)image.width * image.height * iterations / elapsed / 1e6;
+                    printf("%-16s %-9s %6d %-7s %10.1f  %s\n", image.name, dither_method_name(method), levels,
+                           dither_kernel_name(kernel), mps, match ? "ok" : "MISMATCH");
+                }
+            }
+        }
+    }
+
+    if (mismatches > 0) {
+        printf("\n%d kernel results differ from the scalar reference\n", mismatches);
+        return 1;
+    }
+    printf("\nAll kernels match the scalar reference\n");
+    return 0;
+}
@@ -0,0 +1,248 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "crc32c.h"
+#include "read_ahead.h"
+#include "bench_util.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace book;
+
+static constexpr size_t OLD_BUFFER_SIZE = 256 * 1024;  // 原来的 FILE_BUFFER_SIZE
+static constexpr int SOCKET_BUFFER_SIZE = 16 * 1024;  // 接近 lwIP 的发送窗口
+
+static bool send_all(int fd, const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    while (size > 0) {
+        ssize_t sent = send(fd, p, size, 0);
+        if (sent <= 0) return false;
+        p += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+// 网络的替身：按 mbps 限速读取套接字，解析响应头（Content-Length 或分块传输），返回正文的 CRC32C
+struct Receiver {
+    int fd;
+    double mbps;
+    uint64_t body     = 0;
+    uint32_t crc      = 0;
+    bool complete     = false;
+    bool chunked      = false;
+    bool hasLength    = false;
+    double finishedMs = 0;
+    Clock::time_point start;
+
+    void run()
+    {
+        std::string pending;
+        Clock::time_point ready = start;
+        char buffer[4096];
+        auto pull = [&]() {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) return false;
+            pending.append(buffer, n);
+            // 每块按限速占用链路的时间；发送方空闲的时间不能攒下来之后突发
+            ready = std::max(ready, Clock::now()) + std::chrono::microseconds((int64_t)(n / mbps));
+            std::this_thread::sleep_until(ready);
+            return true;
+        };
+        auto take = [&](size_t n) {
+            crc = crc32c_update(crc, pending.data(), n);
+            body += n;
+            pending.erase(0, n);
+        };
+
+        size_t end;
+        while ((end = pending.find("\r\n\r\n")) == std::string::npos) {
+            if (!pull()) return;
+        }
+        std::string headers = pending.substr(0, end + 2);
+        pending.erase(0, end + 4);
+        uint64_t length = 0;
+        size_t pos      = headers.find("Content-Length: ");
+        if (pos != std::string::npos) {
+            hasLength = true;
+            length    = strtoull(headers.c_str() + pos + 16, nullptr, 10);
+        }
+        chunked = headers.find("Transfer-Encoding: chunked") != std::string::npos;
+
+        if (!chunked) {
+            while (body < length) {
+                if (pending.empty() && !pull()) return;
+                take(std::min<uint64_t>(pending.size(), length - body));
+            }
+            complete = hasLength;
+        } else {
+            while (true) {
+                while ((end = pending.find("\r\n")) == std::string::npos) {
+                    if (!pull()) return;
+                }
+                size_t size = strtoul(pending.c_str(), nullptr, 16);
+                pending.erase(0, end + 2);
+                while (pending.size() < size + 2) {
+                    if (!pull()) return;
+                }
+                take(size);
+                pending.erase(0, 2);
+                if (size == 0) break;
+            }
+            complete = true;
+        }
+        finishedMs = elapsed_ms(start);
+    }
+};
+
+// 读卡的替身：按 mbps 限速的 fread
+static size_t card_read(FILE* f, uint8_t* out, size_t capacity, double mbps)
+{
+    auto start = Clock::now();
+    size_t n   = fread(out, 1, capacity, f);
+    if (mbps > 0) std::this_thread::sleep_until(start + std::chrono::microseconds((int64_t)(n / mbps)));
+    return n;
+}
+
+// 原来的做法：读 256KB、发一块，交替进行，分块传输
+static void send_alternating(int fd, const std::string& path, double readMBps)
+{
+    FILE* f             = fopen(path.c_str(), "rb");
+    std::string headers = "HTTP/1.1 200 OK\r\nContent-Type: application/epub+zip\r\nTransfer-Encoding: chunked\r\n\r\n";
+    send_all(fd, headers.data(), headers.size());
+    std::vector<uint8_t> buffer(OLD_BUFFER_SIZE);
+    size_t n;
+    while ((n = card_read(f, buffer.data(), buffer.size(), readMBps)) > 0) {
+        char size[16];
+        int len = snprintf(size, sizeof(size), "%zx\r\n", n);
+        if (!send_all(fd, size, len) || !send_all(fd, buffer.data(), n) || !send_all(fd, "\r\n", 2)) break;
+    }
+    send_all(fd, "0\r\n\r\n", 5);
+    fclose(f);
+}
+
+// 现在的做法：预读 + Content-Length，与 handleGetFile 相同
+static void send_read_ahead(int fd, const std::string& path, uint64_t length, double readMBps, ReadAheadStats& io,
+                            double& sendMs)
+{
+    FILE* f            = fopen(path.c_str(), "rb");
+    uint64_t remaining = length;
+    ReadAhead reader([&](uint8_t* out, size_t capacity) {
+        size_t n = card_read(f, out, (size_t)std::min<uint64_t>(capacity, remaining), readMBps);
+        remaining -= n;
+        return n;
+    });
+    reader.start();
+    std::string headers = "HTTP/1.1 200 OK\r\nContent-Type: application/epub+zip\r\nContent-Length: " +
+                          std::to_string(length) + "\r\n\r\n";
+    send_all(fd, headers.data(), headers.size());
+    sendMs = 0;
+    const uint8_t* data;
+    size_t size;
+    while (reader.next(data, size)) {
+        auto start = Clock::now();
+        bool ok    = send_all(fd, data, size);
+        sendMs += elapsed_ms(start);
+        reader.release();
+        if (!ok) break;
+    }
+    reader.stop();
+    io = reader.stats();
+    fclose(f);
+}
+
+// 建一对套接字，发送方在本线程，接收方在另一个线程；返回端到端毫秒数
+template <typename Send>
+static double transfer(double sendMBps, Receiver& receiver, Send send)
+{
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    int size = SOCKET_BUFFER_SIZE;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    receiver.fd    = fds[1];
+    receiver.mbps  = sendMBps;
+    receiver.start = Clock::now();
+    std::thread thread(&Receiver::run, &receiver);
+    send(fds[0]);
+    shutdown(fds[0], SHUT_WR);
+    thread.join();
+    close(fds[0]);
+    close(fds[1]);
+    return receiver.finishedMs;
+}
+
+int main(int argc, char** argv)
+{
+    std::string path = "/tmp/download_bench.bin";
+    int sizeMB       = 8;
+    double readMBps  = 2.0;
+    double sendMBps  = 1.5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--file" && i + 1 < argc) {
+            path = argv[++i];
+        } else if (arg == "--size-mb" && i + 1 < argc) {
+            sizeMB = atoi(argv[++i]);
+        } else if (arg == "--read-mbps" && i + 1 < argc) {
+            readMBps = atof(argv[++i]);
+        } else if (arg == "--send-mbps" && i + 1 < argc) {
+            sendMBps = atof(argv[++i]);
+        } else {
+            printf("Usage: %s [--file PATH] [--size-mb N] [--read-mbps R] [--send-mbps S]\n", argv[0]);
+            printf("\n");
+            printf("  Writes an N MB file and sends it as an HTTP response over a socket pair whose reader\n");
+            printf("  is throttled to S MB/s, with card reads throttled to R MB/s: first the old way\n");
+            printf("  (256KB read, then send, chunked), then with read-ahead and Content-Length. Checks the\n");
+            printf("  received body and reports end-to-end MB/s and where each side waited.\n");
+            return 1;
+        }
+    }
+
+    uint64_t length = (uint64_t)sizeMB << 20;
+    std::vector<uint8_t> data(length);
+    std::mt19937 rng(1);
+    for (auto& b : data) b = (uint8_t)rng();
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+    uint32_t crc = crc32c(data.data(), data.size());
+    double mb    = length / 1048576.0;
+    double bound = mb / std::min(readMBps, sendMBps) * 1000;
+    printf("file:      %.1f MB, card %.1f MB/s, socket %.1f MB/s, bound %.0f ms\n", mb, readMBps, sendMBps, bound);
+
+    Receiver before;
+    double beforeMs = transfer(sendMBps, before, [&](int fd) { send_alternating(fd, path, readMBps); });
+    bool beforeOk   = before.complete && before.chunked && before.body == length && before.crc == crc;
+    printf("before:    256KB read / send alternating, chunked: %.0f ms (%.2f MB/s), body %s\n", beforeMs,
+           mb / (beforeMs / 1000), beforeOk ? "ok" : "FAILED");
+
+    Receiver after;
+    ReadAheadStats io;
+    double sendMs  = 0;
+    double afterMs = transfer(sendMBps, after,
+                              [&](int fd) { send_read_ahead(fd, path, length, readMBps, io, sendMs); });
+    bool afterOk   = after.complete && after.hasLength && !after.chunked && after.body == length && after.crc == crc;
+    printf("after:     read-ahead %d x %zuKB, Content-Length: %.0f ms (%.2f MB/s, %.0f%% faster), body %s\n",
+           READ_AHEAD_CHUNKS, READ_AHEAD_CHUNK_SIZE / 1024, afterMs, mb / (afterMs / 1000),
+           100.0 * (beforeMs - afterMs) / beforeMs, afterOk ? "ok" : "FAILED");
+    printf("           read %.0f ms, send %.0f ms, reader waited %.0f ms (%u times), "
+           "sender waited %.0f ms (%u times)\n",
+           io.readUs / 1000.0, sendMs, io.readerStallUs / 1000.0, io.readerStalls, io.senderStallUs / 1000.0,
+           io.senderStalls);
+
+    remove(path.c_str());
+    return beforeOk && afterOk ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "epub_ingest.h"
+#include "text_book.h"
+#include "bench_util.h"
+#include <json/json.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static std::string read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static bool load_json(const std::string& path, Json::Value& root)
+{
+    std::ifstream in(path, std::ios::binary);
+    Json::CharReaderBuilder builder;
+    std::string errs;
+    if (!in || !Json::parseFromStream(builder, in, &root, &errs)) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), errs.c_str());
+        return false;
+    }
+    return true;
+}
+
+// 导入到 outDir（先清空），返回峰值堆内存
+static bool ingest(const std::string& epub, const std::string& outDir, book::EpubIngestor& ingestor, size_t& peak,
+                   double& ms)
+{
+    fs::remove_all(outDir);
+    fs::create_directories(outDir);
+
+    size_t base = heap_in_use();
+    peak        = 0;
+    auto start  = Clock::now();
+    bool ok     = ingestor.run(epub, outDir, [&](int, int) {
+        peak = std::max(peak, heap_in_use() - base);
+        return true;
+    });
+    ms          = elapsed_ms(start);
+    if (!ok) fprintf(stderr, "ingest failed: %s\n", ingestor.lastError().c_str());
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s <book.epub> [out_dir]\n", argv[0]);
+        printf("\n");
+        printf("  Converts an EPUB into a text-engine book the way the device does after /api/upload\n");
+        printf("  (book.txt + metadata.json + anchors.json in out_dir, default <book.epub>.ingest), reports\n");
+        printf("  throughput and peak heap, and checks the section / anchor tables, pagination of the\n");
+        printf("  output and that a second run produces identical files.\n");
+        return 1;
+    }
+    std::string epub   = argv[1];
+    std::string outDir = argc > 2 ? argv[2] : epub + ".ingest";
+    std::string text   = outDir + "/" + book::EPUB_TEXT_FILE_NAME;
+
+    // 1. 导入
+    book::EpubIngestor ingestor;
+    size_t peak = 0;
+    double ms   = 0;
+    if (!ingest(epub, outDir, ingestor, peak, ms)) return 1;
+    const book::EpubIngestStats& stats = ingestor.stats();
+    const double epubMB                = fs::file_size(epub) / 1048576.0;
+
+    printf("epub:      %s, %.2f MB\n", epub.c_str(), epubMB);
+    printf("book:      %s / %s\n", ingestor.title().c_str(), ingestor.author().c_str());
+    printf("\ningest:    %d documents, %.2f MB inflated -> %.2f MB text in %.1f ms (%.1f MB/s of EPUB)\n",
+           stats.documents, stats.inflatedBytes / 1048576.0, stats.textBytes / 1048576.0, ms, epubMB / (ms / 1000.0));
+    printf("peak heap: %.1f KB\n", peak / 1024.0);
+    printf("tables:    %d sections, %d anchors\n", stats.sections, stats.anchors);
+
+    // 2. 输出检查：正文为 UTF-8，章节在行首且递增，锚点不越界
+    std::string content = read_file(text);
+    int problems        = 0;
+    size_t bom          = 0;
+    if (book::detect_text_encoding((const uint8_t*)content.data(), content.size(), bom) != book::TextEncoding::Utf8) {
+        fprintf(stderr, "book.txt is not valid UTF-8\n");
+        problems++;
+    }
+
+    Json::Value metadata, anchors;
+    if (!load_json(outDir + "/metadata.json", metadata) ||
+        !load_json(outDir + "/" + book::EPUB_ANCHORS_FILE_NAME, anchors)) {
+        return 1;
+    }
+    if (metadata["format"].asString() != "text") problems++;
+    uint32_t previous = 0;
+    for (const auto& section : metadata["sections"]) {
+        uint32_t offset = section["offset"].asUInt();
+        bool lineStart  = offset == 0 || (offset <= content.size() && content[offset - 1] == '\n');
+        if (offset < previous || offset >= content.size() || !lineStart) {
+            if (problems++ < 5) {
+                fprintf(stderr, "section '%s' at %u is not at a line start\n", section["title"].asCString(), offset);
+            }
+        }
+        previous = offset;
+    }
+    for (const auto& key : anchors.getMemberNames()) {
+        if (anchors[key]["offset"].asUInt() > content.size() && problems++ < 5) {
+            fprintf(stderr, "anchor '%s' beyond end of text\n", key.c_str());
+        }
+    }
+    printf("check:     sections %zu, first titles:", (size_t)metadata["sections"].size());
+    for (Json::ArrayIndex i = 0; i < std::min(3u, metadata["sections"].size()); i++) {
+        printf(" [%s]", metadata["sections"][i]["title"].asCString());
+    }
+    printf("\n");
+
+    // 3. 与设备端阅读器相同的分页
+    book::TextLayoutParams params;
+    params.lineWidth    = 492;
+    params.linesPerPage = 23;
+    params.fontId       = 24;
+    book::TextPaginator paginator(efont24_width);
+    auto start = Clock::now();
+    if (!paginator.begin(text, params)) {
+        fprintf(stderr, "%s\n", paginator.lastError().c_str());
+        return 1;
+    }
+    while (paginator.step()) {
+    }
+    printf("paginate:  %zu pages in %.1f ms\n", paginator.pages().size(), elapsed_ms(start));
+    paginator.end();
+
+    // 4. 再导入一次，输出应逐字节相同（metadata.json 含导入时间，不比较）
+    book::EpubIngestor second;
+    size_t peak2 = 0;
+    double ms2   = 0;
+    std::string outDir2 = outDir + ".2";
+    if (!ingest(epub, outDir2, second, peak2, ms2)) return 1;
+    bool identical = read_file(outDir2 + "/" + book::EPUB_TEXT_FILE_NAME) == content &&
+                     read_file(outDir2 + "/" + book::EPUB_ANCHORS_FILE_NAME) ==
+                         read_file(outDir + "/" + book::EPUB_ANCHORS_FILE_NAME);
+    fs::remove_all(outDir2);
+    printf("repeat:    %s\n", identical ? "identical" : "DIFFERENT");
+
+    if (problems > 0) printf("\n%d problems\n", problems);
+    return problems == 0 && identical ? 0 : 1;
+}
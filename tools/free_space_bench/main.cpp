@@ -0,0 +1,231 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "free_space.h"
+#include "bench_util.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr uint32_t SECTOR_SIZE = 512;
+static constexpr uint32_t FAT_EOC     = 0x0FFFFFFF;
+
+// FAT32 卡的 FAT 表：每簇 4 字节，高 4 位保留。模拟的卷只保留 FAT，数据区不占空间
+struct FatImage {
+    int fd = -1;
+    std::vector<uint32_t> fat;  // 内存副本，分配时使用
+    uint32_t clusterBytes = 0;
+    uint32_t nextFree     = 2;
+
+    void writeEntry(uint32_t cluster, uint32_t value)
+    {
+        fat[cluster] = value;
+        pwrite(fd, &value, 4, (off_t)cluster * 4);
+    }
+
+    // 分配 n 个簇（首次适配，按链连接），返回簇号
+    std::vector<uint32_t> allocate(uint32_t n)
+    {
+        std::vector<uint32_t> chain;
+        for (uint32_t c = nextFree; c < fat.size() && chain.size() < n; c++) {
+            if ((fat[c] & 0x0FFFFFFF) == 0) chain.push_back(c);
+        }
+        for (size_t i = 0; i < chain.size(); i++) writeEntry(chain[i], i + 1 < chain.size() ? chain[i + 1] : FAT_EOC);
+        return chain;
+    }
+
+    void release(const std::vector<uint32_t>& chain)
+    {
+        for (uint32_t c : chain) writeEntry(c, 0);
+        if (!chain.empty()) nextFree = std::min(nextFree, chain.front());
+    }
+};
+
+// f_getfree 在 FSInfo 无效时的做法：逐个扇区读 FAT，数值为 0 的表项为空闲簇
+static bool scan_fat(int fd, uint32_t entries, uint32_t clusterBytes, uint64_t& total, uint64_t& free,
+                     uint32_t& outClusterBytes)
+{
+    uint32_t sector[SECTOR_SIZE / 4];
+    uint64_t freeClusters = 0;
+    for (uint64_t offset = 0; offset < (uint64_t)entries * 4; offset += SECTOR_SIZE) {
+        if (pread(fd, sector, SECTOR_SIZE, (off_t)offset) != (ssize_t)SECTOR_SIZE) return false;
+        for (uint32_t i = 0; i < SECTOR_SIZE / 4; i++) {
+            uint64_t cluster = offset / 4 + i;
+            if (cluster >= 2 && cluster < entries && (sector[i] & 0x0FFFFFFF) == 0) freeClusters++;
+        }
+    }
+    outClusterBytes = clusterBytes;
+    total           = (uint64_t)(entries - 2) * clusterBytes;
+    free            = freeClusters * clusterBytes;
+    return true;
+}
+
+static bool wait_valid(book::FreeSpaceCache& cache, uint32_t scans, double timeoutMs)
+{
+    auto start = Clock::now();
+    while (cache.scanning() || cache.scans() < scans) {
+        if (elapsed_ms(start) > timeoutMs) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::string image = "/tmp/free_space_bench.fat";
+    uint32_t cardGb   = 64;
+    uint32_t clusterKb = 32;
+    double used       = 0.6;
+    double spiMBps    = 4.0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--image" && i + 1 < argc) {
+            image = argv[++i];
+        } else if (arg == "--card-gb" && i + 1 < argc) {
+            cardGb = (uint32_t)atol(argv[++i]);
+        } else if (arg == "--cluster-kb" && i + 1 < argc) {
+            clusterKb = (uint32_t)atol(argv[++i]);
+        } else if (arg == "--used" && i + 1 < argc) {
+            used = atof(argv[++i]);
+        } else if (arg == "--spi-mbps" && i + 1 < argc) {
+            spiMBps = atof(argv[++i]);
+        } else {
+            printf("Usage: %s [--image PATH] [--card-gb N] [--cluster-kb N] [--used F] [--spi-mbps F]\n", argv[0]);
+            printf("\n");
+            printf("  Writes the FAT of a --card-gb FAT32 card (--cluster-kb clusters, --used fraction allocated\n");
+            printf("  in fragmented chains) to --image. Times a full sector-by-sector free-cluster scan, the\n");
+            printf("  way f_getfree works without a valid FSInfo, against FreeSpaceCache::get(), and estimates\n");
+            printf("  the device scan time at --spi-mbps. Then replays writes, overwrites and deletes through\n");
+            printf("  the cache's per-cluster accounting and checks the estimate against a fresh scan.\n");
+            return 1;
+        }
+    }
+    if (cardGb == 0 || clusterKb == 0) return 1;
+
+    FatImage fat;
+    fat.clusterBytes = clusterKb * 1024;
+    uint32_t entries = (uint32_t)((uint64_t)cardGb * 1024 * 1024 / clusterKb) + 2;
+    fat.fd           = open(image.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fat.fd < 0) {
+        printf("Failed to create %s\n", image.c_str());
+        return 1;
+    }
+
+    // 已用空间由长短不一的链组成，中间夹着空闲的间隙
+    std::mt19937 rng(1);
+    fat.fat.assign(entries, 0);
+    fat.fat[0] = 0x0FFFFFF8;
+    fat.fat[1] = FAT_EOC;
+    uint32_t c = 2;
+    while (c < entries) {
+        uint32_t run = 1 + rng() % 256;
+        bool inUse   = (rng() % 1000) < used * 1000;
+        for (uint32_t i = 0; i < run && c < entries; i++, c++) fat.fat[c] = inUse ? (i + 1 < run ? c + 1 : FAT_EOC) : 0;
+    }
+    uint64_t fatBytes = (uint64_t)entries * 4;
+    uint64_t padded   = (fatBytes + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE;
+    fat.fat.resize(padded / 4, 0);
+    if (pwrite(fat.fd, fat.fat.data(), padded, 0) != (ssize_t)padded) {
+        printf("Failed to write %s\n", image.c_str());
+        return 1;
+    }
+    fat.fat.resize(entries);
+
+    book::FreeSpaceCache::ScanFn scan = [&](uint64_t& total, uint64_t& free, uint32_t& clusterBytes) {
+        return scan_fat(fat.fd, entries, fat.clusterBytes, total, free, clusterBytes);
+    };
+
+    // 改动前每次 /api/info 都扫描
+    uint64_t total = 0, free = 0;
+    uint32_t cb    = 0;
+    const int runs = 5;
+    auto start     = Clock::now();
+    for (int i = 0; i < runs; i++) scan_fat(fat.fd, entries, fat.clusterBytes, total, free, cb);
+    double scanMs = elapsed_ms(start) / runs;
+    printf("card:      %u GB, %u KB clusters, FAT %.1f MB, %.1f%% free\n", cardGb, clusterKb, fatBytes / 1048576.0,
+           100.0 * free / total);
+    printf("scan:      %.2f ms per /api/info on host (page cache), ~%.0f ms over SPI at %.1f MB/s\n", scanMs,
+           fatBytes / (spiMBps * 1e6) * 1000, spiMBps);
+
+    // 缓存：第一次查询不等待扫描
+    book::FreeSpaceCache cache(scan);
+    start                    = Clock::now();
+    book::FreeSpaceInfo info = cache.get();
+    double firstUs           = elapsed_ms(start) * 1000;
+    bool firstOk             = !info.valid;
+    bool ready               = wait_valid(cache, 1, 60000);
+    double readyMs           = elapsed_ms(start);
+    info                     = cache.get();
+    bool sameAsScan          = info.valid && !info.estimated && info.free == free && info.total == total;
+
+    const int queries = 1000000;
+    start             = Clock::now();
+    volatile uint64_t sink = 0;  // 防止查询被优化掉
+    for (int i = 0; i < queries; i++) sink = sink + cache.get().free;
+    double getNs = elapsed_ms(start) * 1e6 / queries;
+    printf("cached:    first query %.1f us (not valid yet), valid after %.1f ms, then %.1f ns per query\n", firstUs,
+           readyMs, getNs);
+    bool ok = firstOk && ready && sameAsScan;
+    printf("checks:    first result equals a direct scan: %s\n", ready && sameAsScan ? "ok" : "FAILED");
+
+    // 按簇调整：新建、覆盖（变大 / 变小）、删除，与重新扫描比较
+    std::vector<std::vector<uint32_t>> files;
+    std::vector<uint64_t> sizes;
+    auto clusters = [&](uint64_t bytes) { return (uint32_t)((bytes + fat.clusterBytes - 1) / fat.clusterBytes); };
+    int ops       = 0;
+    for (int i = 0; i < 3000; i++) {
+        uint32_t kind = files.empty() ? 0 : rng() % 3;
+        if (kind == 0) {
+            uint64_t size = rng() % (2 * 1024 * 1024);
+            files.push_back(fat.allocate(clusters(size)));
+            sizes.push_back(size);
+            cache.fileChanged(0, size);
+        } else if (kind == 1) {
+            size_t k      = rng() % files.size();
+            uint64_t size = rng() % (2 * 1024 * 1024);
+            fat.release(files[k]);
+            files[k] = fat.allocate(clusters(size));
+            cache.fileChanged(sizes[k], size);
+            sizes[k] = size;
+        } else {
+            size_t k = rng() % files.size();
+            fat.release(files[k]);
+            cache.fileChanged(sizes[k], 0);
+            files.erase(files.begin() + k);
+            sizes.erase(sizes.begin() + k);
+        }
+        ops++;
+    }
+    info = cache.get();
+    scan_fat(fat.fd, entries, fat.clusterBytes, total, free, cb);
+    bool tracked = info.valid && info.estimated && info.free == free;
+    printf("tracked:   %d writes / overwrites / deletes, estimate %.1f MB vs rescan %.1f MB: %s\n", ops,
+           info.free / 1048576.0, free / 1048576.0, tracked ? "ok" : "FAILED");
+    ok = ok && tracked;
+
+    // 无法计量的改动：失效后下次查询在后台重扫
+    fat.allocate(1000);
+    cache.invalidate();
+    uint32_t before = cache.scans();
+    cache.get();
+    bool rescanned = wait_valid(cache, before + 1, 60000);
+    info           = cache.get();
+    scan_fat(fat.fd, entries, fat.clusterBytes, total, free, cb);
+    rescanned = rescanned && !info.estimated && info.free == free;
+    printf("resync:    invalidate() rescans in the background: %s\n", rescanned ? "ok" : "FAILED");
+    ok = ok && rescanned;
+
+    wait_valid(cache, 0, 60000);
+    close(fat.fd);
+    unlink(image.c_str());
+    return ok ? 0 : 1;
+}
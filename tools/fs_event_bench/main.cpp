@@ -0,0 +1,224 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "fs_events.h"
+#include "library_changes.h"
+#include "bench_util.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 路径带生产者编号、序号和由序号决定长度与内容的填充，读到不完整的槽位时校验不过
+static std::string make_path(size_t producer, uint32_t i)
+{
+    std::string path = "/sdcard/books/p" + std::to_string(producer) + "/" + std::to_string(i) + "/";
+    path.append(i % 60, (char)('a' + i % 26));
+    return path;
+}
+
+static bool parse_path(const std::string& path, size_t& producer, uint32_t& i)
+{
+    if (sscanf(path.c_str(), "/sdcard/books/p%zu/%u", &producer, &i) != 2) return false;
+    std::string expected = make_path(producer, i);
+    // 填充为空时发布端去掉了末尾的 /
+    if (expected.back() == '/') expected.pop_back();
+    return path == expected;
+}
+
+struct Consumer {
+    const char* name;
+    std::string prefix;
+    int sleepEvery = 0;  // 每读这么多个事件睡一会，制造溢出
+    book::FsSubscription sub{};
+    uint32_t overflows = 0;
+    uint32_t corrupt   = 0;
+    uint32_t reordered = 0;
+    uint32_t foreign   = 0;  // 不在前缀下的事件
+};
+
+static void consume(book::FsEventBus& bus, Consumer& c, size_t producers, const std::atomic<bool>& done)
+{
+    std::vector<int64_t> last(producers, -1);
+    book::FsEvent event;
+    uint32_t count = 0;
+    while (true) {
+        bool finished = done.load(std::memory_order_acquire);
+        if (!bus.poll(c.sub, event)) {
+            if (finished && c.sub.cursor == bus.published()) break;
+            std::this_thread::yield();
+            continue;
+        }
+        if (event.type == book::FsEventType::Overflow) {
+            c.overflows++;
+            continue;
+        }
+        size_t p   = 0;
+        uint32_t i = 0;
+        if (!parse_path(event.path, p, i) || p >= producers || event.type != book::FsEventType::Written) {
+            c.corrupt++;
+            continue;
+        }
+        if ((int64_t)i <= last[p]) c.reordered++;
+        last[p] = i;
+        if (!book::fs_path_related(event.path, c.prefix)) c.foreign++;
+        if (c.sleepEvery && ++count % c.sleepEvery == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+static bool check(const char* what, bool ok)
+{
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static bool check_semantics()
+{
+    bool ok = true;
+    printf("semantics:\n");
+    ok &= check("related: child, parent, equal, sibling, partial name",
+                book::fs_path_related("/sdcard/books/a/1.png", "/sdcard/books/a") &&
+                    book::fs_path_related("/sdcard/books", "/sdcard/books/a") &&
+                    book::fs_path_related("/sdcard/books/a", "/sdcard/books/a") &&
+                    !book::fs_path_related("/sdcard/books/b/1.png", "/sdcard/books/a") &&
+                    !book::fs_path_related("/sdcard/books/ab", "/sdcard/books/a") &&
+                    book::fs_path_related("/sdcard/dict/x.pdict", "") && book::fs_path_related("/", "/sdcard/dict"));
+
+    book::FsEventBus bus(8);
+    book::FsSubscription all, dict;
+    bus.subscribe(all, "");
+    bus.subscribe(dict, "/sdcard/dict");
+    book::FsEvent e;
+
+    bus.publish(book::FsEventType::Written, "/sdcard//dict//en.pdict/");
+    bool normalized = bus.poll(all, e) && e.path == "/sdcard/dict/en.pdict";
+    std::string longPath = "/sdcard/books/" + std::string(100, 'x') + "/" + std::string(100, 'y') + ".png";
+    bus.publish(book::FsEventType::Removed, longPath);
+    bool truncated = bus.poll(all, e) && e.type == book::FsEventType::Removed &&
+                     e.path == "/sdcard/books/" + std::string(100, 'x') && book::fs_path_related(longPath, e.path);
+    ok &= check("paths normalized, long path truncated to its directory", normalized && truncated);
+
+    bool filtered = bus.poll(dict, e) && e.path == "/sdcard/dict/en.pdict" && !bus.poll(dict, e);
+    ok &= check("prefix subscriber skips unrelated events", filtered);
+
+    for (int i = 0; i < 20; i++) bus.publish(book::FsEventType::Written, "/sdcard/dict/" + std::to_string(i));
+    bool over = bus.poll(dict, e) && e.type == book::FsEventType::Overflow && e.dropped == 20 - 8 + 0;
+    int rest = 0;
+    while (bus.poll(dict, e)) rest++;
+    ok &= check("lagging subscriber gets one Overflow then the newest events", over && rest == 8 && dict.dropped == 12);
+
+    // 书架变化映射
+    book::FsEventBus libBus(8);
+    book::LibraryChanges changes(libBus);
+    std::vector<std::string> ids;
+    libBus.publish(book::FsEventType::Written, "/sdcard/books/alpha/page_001.png");
+    libBus.publish(book::FsEventType::Written, "/sdcard/books//beta.txt");
+    libBus.publish(book::FsEventType::Written, "/sdcard/books/.index.bin");
+    libBus.publish(book::FsEventType::Written, "/sdcard/dict/en.pdict");
+    libBus.publish(book::FsEventType::DirRemoved, "/sdcard/books/alpha");
+    bool mapped = !changes.take(ids) && ids == std::vector<std::string>{"alpha", "beta.txt"};
+    libBus.publish(book::FsEventType::DirRemoved, "/sdcard/books");
+    bool rootAll = changes.take(ids) && ids.empty();
+    for (int i = 0; i < 20; i++) libBus.publish(book::FsEventType::Written, "/sdcard/books/b" + std::to_string(i));
+    bool overAll = changes.take(ids) && ids.empty() && !changes.take(ids);
+    ok &= check("library: ids, dot files ignored, root and overflow rescan", mapped && rootAll && overAll);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    size_t producers = 4;
+    uint32_t events  = 200000;
+    size_t capacity  = book::FS_EVENT_RING_SIZE;
+    uint32_t burst   = 16;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--producers" && i + 1 < argc) {
+            producers = (size_t)atol(argv[++i]);
+        } else if (arg == "--events" && i + 1 < argc) {
+            events = (uint32_t)atol(argv[++i]);
+        } else if (arg == "--capacity" && i + 1 < argc) {
+            capacity = (size_t)atol(argv[++i]);
+        } else if (arg == "--burst" && i + 1 < argc) {
+            burst = (uint32_t)atol(argv[++i]);
+        } else {
+            printf("Usage: %s [--producers N] [--events N] [--capacity N] [--burst N]\n", argv[0]);
+            printf("\n");
+            printf("  Times publish() with no subscribers, then --producers threads each publish --events\n");
+            printf("  paths (yielding after every --burst) while a full, a prefix-filtered and a deliberately\n");
+            printf("  slow subscriber poll concurrently. Checks that no subscriber sees a torn or reordered\n");
+            printf("  event, that received + dropped == published and that prefix filtering holds; then checks\n");
+            printf("  path normalization, truncation, overflow and the bookshelf id mapping single-threaded.\n");
+            return 1;
+        }
+    }
+    if (producers == 0 || events == 0) return 1;
+
+    // 只计发布本身：没有订阅者，生产者不让出
+    uint32_t total = (uint32_t)(producers * events);
+    double publishMs = 0;
+    {
+        book::FsEventBus bus(capacity);
+        std::vector<std::string> paths;
+        for (uint32_t i = 0; i < 1024; i++) paths.push_back(make_path(0, i));
+        auto start = Clock::now();
+        std::vector<std::thread> writers;
+        for (size_t p = 0; p < producers; p++) {
+            writers.emplace_back([&bus, &paths, events] {
+                for (uint32_t i = 0; i < events; i++) bus.publish(book::FsEventType::Written, paths[i % paths.size()]);
+            });
+        }
+        for (auto& t : writers) t.join();
+        publishMs = elapsed_ms(start);
+        printf("publish:   capacity %zu, %zu producers x %u events, %.1f ns/publish (%.2f M events/s)\n",
+               bus.capacity(), producers, events, publishMs * 1e6 / total, total / publishMs / 1000.0);
+    }
+
+    book::FsEventBus bus(capacity);
+    Consumer consumers[] = {
+        {"full", ""},
+        {"prefix", "/sdcard/books/p0"},
+        {"slow", "", 64},
+    };
+    for (auto& c : consumers) bus.subscribe(c.sub, c.prefix);
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (auto& c : consumers) readers.emplace_back(consume, std::ref(bus), std::ref(c), producers, std::cref(done));
+
+    // 实际的发布者（HTTP 处理函数）每次改动才发布一次，这里成批发布后让出，单核上读者也能跟上
+    auto start = Clock::now();
+    std::vector<std::thread> writers;
+    for (size_t p = 0; p < producers; p++) {
+        writers.emplace_back([&bus, p, events, burst] {
+            for (uint32_t i = 0; i < events; i++) {
+                bus.publish(book::FsEventType::Written, make_path(p, i));
+                if (burst && (i + 1) % burst == 0) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : writers) t.join();
+    done.store(true, std::memory_order_release);
+    for (auto& t : readers) t.join();
+    printf("stress:    bursts of %u, %.1f ms with 3 subscribers polling\n", burst, elapsed_ms(start));
+
+    bool ok = bus.published() == total;
+    for (auto& c : consumers) {
+        bool accounted = c.prefix.empty() ? c.sub.received + c.sub.dropped == total : c.sub.received <= events;
+        bool clean     = c.corrupt == 0 && c.reordered == 0 && c.foreign == 0 && accounted;
+        printf("%-10s received %u, dropped %u in %u overflows, torn %u, reordered %u, foreign %u: %s\n",
+               (std::string(c.name) + ":").c_str(), c.sub.received, c.sub.dropped, c.overflows, c.corrupt, c.reordered,
+               c.foreign, clean ? "ok" : "FAILED");
+        ok = ok && clean;
+    }
+    bool slowOverflowed = consumers[2].overflows > 0;
+    printf("slow subscriber overflowed: %s\n", slowOverflowed ? "yes" : "no (raise --events)");
+
+    ok = check_semantics() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,295 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "fulltext_index.h"
+#include "text_book.h"
+#include "text_layer.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static constexpr int PAGES_PER_SECTION = 40;
+static constexpr int MARGIN_X          = 24;
+static constexpr int MARGIN_TOP        = 24;
+static constexpr int LINE_HEIGHT       = 36;
+static constexpr size_t RESULTS_SHOWN  = 6;  // 设备端一屏显示的命中数
+
+static std::string read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static bool write_file(const std::string& path, const std::vector<uint8_t>& data)
+{
+    std::ofstream out(path, std::ios::binary);
+    out.write((const char*)data.data(), (std::streamsize)data.size());
+    return (bool)out;
+}
+
+// 用设备端纯文本排版把 UTF-8 文本排成 540 × 900 的页面，写出各章的 text.bin，相当于编译器从章节长图得到的文字层
+static int make_book(const std::string& text, const std::string& bookDir, int& sections)
+{
+    book::TextLayoutParams params;
+    params.lineWidth    = 492;
+    params.linesPerPage = 23;
+    book::GlyphWidths widths(efont24_width);
+
+    std::vector<std::vector<book::TextLayerLine>> pages;
+    std::vector<book::TextLine> lines;
+    const uint8_t* data = (const uint8_t*)text.data();
+    uint32_t start      = text.size() >= 3 && text.compare(0, 3, "\xEF\xBB\xBF") == 0 ? 3 : 0;
+    int totalPages      = 0;
+    sections            = 0;
+
+    auto flush = [&]() {
+        if (pages.empty()) return;
+        char dir[32];
+        snprintf(dir, sizeof(dir), "/sections/%03d", sections++);
+        fs::create_directories(bookDir + dir);
+        write_file(bookDir + dir + "/" + book::TEXT_LAYER_FILE_NAME, book::build_text_layer(pages));
+        pages.clear();
+    };
+
+    while (start < text.size()) {
+        size_t window = std::min(text.size() - start, book::text_page_window(params));
+        bool atEof    = start + window >= text.size();
+        uint32_t next = 0;
+        book::layout_text_page(book::TextEncoding::Utf8, data + start, window, start, atEof, widths, params, lines,
+                               next);
+        std::vector<book::TextLayerLine> page;
+        for (size_t i = 0; i < lines.size(); i++) {
+            book::TextLayerLine line;
+            line.text  = text.substr(lines[i].start, lines[i].end - lines[i].start);
+            line.box.x = MARGIN_X;
+            line.box.y = MARGIN_TOP + (int)i * LINE_HEIGHT;
+            line.box.h = LINE_HEIGHT;
+            for (size_t pos = 0; pos < line.text.size();) {
+                uint32_t cp = 0;
+                size_t n    = book::decode_text_char(book::TextEncoding::Utf8, (const uint8_t*)line.text.data() + pos,
+                                                     line.text.size() - pos, cp);
+                if (n == 0) break;
+                line.box.w += efont24_width(cp);
+                pos += n;
+            }
+            page.push_back(line);
+        }
+        pages.push_back(page);
+        totalPages++;
+        if (pages.size() == PAGES_PER_SECTION) flush();
+        if (next <= start) break;
+        start = next;
+    }
+    flush();
+    return totalPages;
+}
+
+struct PageText {
+    int section = 0;
+    int page    = 1;
+    std::vector<uint32_t> chars;
+};
+
+// 逐页子串匹配，作为正确结果
+static size_t brute_force(const std::vector<PageText>& pages, const std::vector<uint32_t>& query)
+{
+    size_t count = 0;
+    for (const auto& page : pages) {
+        if (std::search(page.chars.begin(), page.chars.end(), query.begin(), query.end()) != page.chars.end()) count++;
+    }
+    return count;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s <novel.txt (UTF-8)> [queries]\n", argv[0]);
+        printf("\n");
+        printf("  Lays the text out into pages with the device text engine, writes per-section text layers\n");
+        printf("  (text.bin), builds search.idx the way the device does in the background and reports index\n");
+        printf("  size, build time, peak heap and query latency; every query is checked against a scan of\n");
+        printf("  all pages.\n");
+        return 1;
+    }
+    std::string text = read_file(argv[1]);
+    size_t queryCount = argc > 2 ? (size_t)atoi(argv[2]) : 500;
+    std::string bookDir = (fs::temp_directory_path() / "fulltext_bench_book").string();
+    fs::remove_all(bookDir);
+    fs::create_directories(bookDir);
+
+    // 1. 文字层
+    auto start     = Clock::now();
+    int sections   = 0;
+    int totalPages = make_book(text, bookDir, sections);
+    uint64_t layerBytes = 0;
+    for (const auto& entry : fs::recursive_directory_iterator(bookDir)) {
+        if (entry.is_regular_file()) layerBytes += entry.file_size();
+    }
+    printf("text:      %s, %.2f MB\n", argv[1], text.size() / 1048576.0);
+    printf("layers:    %d sections, %d pages, %.2f MB text.bin in %.0f ms\n", sections, totalPages,
+           layerBytes / 1048576.0, elapsed_ms(start));
+
+    // 2. 建索引：与设备端后台任务相同，每次处理一章
+    book::FulltextSource source;
+    source.bookDir = bookDir;
+    for (int s = 0; s < sections; s++) source.sections.push_back(s);
+    book::FulltextIndexBuilder builder;
+    size_t base = heap_in_use();
+    size_t peak = 0;
+    double slowestStep = 0;
+    start = Clock::now();
+    builder.begin(source);
+    for (;;) {
+        auto stepStart = Clock::now();
+        bool more      = builder.step();
+        slowestStep    = std::max(slowestStep, elapsed_ms(stepStart));
+        peak           = std::max(peak, heap_in_use() - base);
+        if (!more) break;
+    }
+    double buildMs = elapsed_ms(start);
+    builder.end();
+    if (!builder.done()) {
+        fprintf(stderr, "build failed: %s\n", builder.lastError().c_str());
+        return 1;
+    }
+    const book::FulltextBuildStats& stats = builder.stats();
+    printf("build:     %.0f ms (slowest step %.0f ms), %u runs, peak heap %.1f KB\n", buildMs, slowestStep,
+           stats.runs, peak / 1024.0);
+    printf("index:     %.2f MB (%.0f%% of text), %u keys, %llu postings (%.2f bytes each), %llu chars\n",
+           stats.bytes / 1048576.0, 100.0 * stats.bytes / text.size(), stats.keys,
+           (unsigned long long)stats.postings, (double)(stats.bytes) / std::max<uint64_t>(1, stats.postings),
+           (unsigned long long)stats.chars);
+
+    // 3. 打开：只读入页表和块首键
+    book::FulltextIndex index;
+    start = Clock::now();
+    if (!index.open(bookDir + "/" + book::FULLTEXT_INDEX_FILE_NAME)) {
+        fprintf(stderr, "open failed\n");
+        return 1;
+    }
+    printf("open:      %.2f ms, %.1f KB in memory, %zu pages\n", elapsed_ms(start), index.memoryBytes() / 1024.0,
+           index.pageCount());
+
+    // 全部页面的检索文字，用于出题和校验
+    std::vector<PageText> pages;
+    std::vector<book::TextLayer> layers(sections);
+    for (int s = 0; s < sections; s++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sections/%03d/%s", s, book::TEXT_LAYER_FILE_NAME);
+        layers[s].load(bookDir + path);
+        std::vector<book::SearchChar> chars;
+        for (int p = 1; p <= layers[s].pageCount(); p++) {
+            book::fold_page_text(layers[s], p, chars);
+            PageText page;
+            page.section = s;
+            page.page    = p;
+            for (const auto& c : chars) page.chars.push_back(c.codepoint);
+            pages.push_back(std::move(page));
+        }
+    }
+    int mismatches = index.pageCount() == pages.size() ? 0 : 1;
+
+    // 4. 查询：取自正文的 1-6 个字符，外加不存在的串
+    std::mt19937 rng(1);
+    std::vector<std::vector<uint32_t>> queries;
+    while (queries.size() < queryCount) {
+        const PageText& page = pages[rng() % pages.size()];
+        if (page.chars.size() < 8) continue;
+        size_t len   = 1 + rng() % 6;
+        size_t first = rng() % (page.chars.size() - len);
+        std::vector<uint32_t> q(page.chars.begin() + first, page.chars.begin() + first + len);
+        if (q.front() == ' ' || q.back() == ' ') continue;
+        queries.push_back(q);
+    }
+    std::vector<uint32_t> missing;
+    book::fold_search_query("不存在的句子 zzzz", missing);
+    queries.push_back(missing);
+
+    std::vector<double> lookupTimes, screenTimes;
+    uint64_t candidates = 0, confirmed = 0;
+    uint32_t readsBefore = index.reads();
+    std::vector<uint32_t> found;
+    book::FulltextHit hit;
+    for (const auto& q : queries) {
+        // 候选页
+        start = Clock::now();
+        index.search(q, found);
+        lookupTimes.push_back(elapsed_ms(start));
+
+        // 设备端一屏：依次确认候选页直到凑够 6 个命中
+        size_t shown = 0;
+        for (size_t i = 0; i < found.size() && shown < RESULTS_SHOWN; i++) {
+            book::FulltextPageRef ref = index.pageRef(found[i]);
+            if (book::find_page_matches(layers[ref.section], ref.page, q, hit)) shown++;
+        }
+        screenTimes.push_back(elapsed_ms(start));
+
+        // 全部候选确认后与逐页匹配比较
+        size_t matched = 0;
+        for (uint32_t page : found) {
+            book::FulltextPageRef ref = index.pageRef(page);
+            if (book::find_page_matches(layers[ref.section], ref.page, q, hit)) matched++;
+        }
+        candidates += found.size();
+        confirmed += matched;
+        size_t expected = brute_force(pages, q);
+        if ((matched != expected || found.size() < expected) && mismatches++ < 5) {
+            std::string utf8;
+            for (uint32_t cp : q) {
+                char buf[4];
+                utf8.append(buf, book::encode_utf8(cp, buf));
+            }
+            fprintf(stderr, "query '%s': %zu candidates, %zu confirmed, expected %zu\n", utf8.c_str(), found.size(),
+                    matched, expected);
+        }
+    }
+
+    auto report = [](const char* label, std::vector<double> times) {
+        std::sort(times.begin(), times.end());
+        auto pct = [&](double p) { return times[std::min(times.size() - 1, (size_t)(p * times.size()))]; };
+        printf("%s p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", label, pct(0.5), pct(0.99), times.back());
+    };
+    printf("\nqueries:   %zu, %.1f reads each, %.1f candidate pages each, %.1f%% confirmed\n", queries.size(),
+           (double)(index.reads() - readsBefore) / queries.size(), (double)candidates / queries.size(),
+           candidates ? 100.0 * confirmed / candidates : 100.0);
+    report("lookup:   ", lookupTimes);
+    report("screen:   ", screenTimes);
+
+    // 单字查询的候选最多，单独报告
+    double singleMax = 0;
+    for (size_t i = 0; i < queries.size(); i++) {
+        if (queries[i].size() == 1) singleMax = std::max(singleMax, lookupTimes[i]);
+    }
+    printf("           single-char lookup max %.3f ms\n", singleMax);
+
+    printf("suggest:   %zu top chars, first:", index.topChars().size());
+    for (size_t i = 0; i < std::min<size_t>(index.topChars().size(), 8); i++) {
+        char buf[5] = {0};
+        book::encode_utf8(index.topChars()[i], buf);
+        printf(" %s", buf);
+    }
+    printf("\n");
+
+    // 5. 已有索引时 begin() 直接完成
+    book::FulltextIndexBuilder again;
+    again.begin(source);
+    if (!again.done()) mismatches++;
+    printf("reopen:    %s\n", again.done() ? "index reused" : "REBUILT (unexpected)");
+
+    index.close();
+    fs::remove_all(bookDir);
+    if (mismatches > 0) printf("\n%d mismatches\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
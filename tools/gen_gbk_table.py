@@ -0,0 +1,30 @@
+"""生成 main/book/gbk_table.inc：GBK 双字节编码到 Unicode（BMP）的映射表
+
+    python3 tools/gen_gbk_table.py > main/book/gbk_table.inc
+
+首字节 0x81-0xFE、尾字节 0x40-0xFE，共 126 x 191 项，无对应字符为 0。
+"""
+import sys
+
+
+def main():
+    out = sys.stdout
+    out.write("// 由 tools/gen_gbk_table.py 生成，请勿手工修改\n")
+    out.write("// GBK 双字节 -> Unicode，下标 (首字节 - 0x81) * 191 + (尾字节 - 0x40)，0 表示无对应字符\n")
+    out.write("static const uint16_t GBK_TO_UNICODE[126 * 191] = {\n")
+    values = []
+    for lead in range(0x81, 0xFF):
+        for trail in range(0x40, 0xFF):
+            try:
+                ch = bytes([lead, trail]).decode("gbk")
+                code = ord(ch) if len(ch) == 1 and ord(ch) <= 0xFFFF else 0
+            except UnicodeDecodeError:
+                code = 0
+            values.append(code)
+    for i in range(0, len(values), 16):
+        out.write("    " + ", ".join("0x%04X" % v for v in values[i : i + 16]) + ",\n")
+    out.write("};\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,269 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "ink_layer.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static constexpr int SCREEN_WIDTH        = 540;
+static constexpr int PAGE_CONTENT_HEIGHT = 900;
+static constexpr uint32_t PEN_UP_MS      = 300;  // 两笔之间的间隔
+
+struct Sample {
+    book::InkPoint point;
+    uint32_t timeMs = 0;
+};
+
+// 合成书写：每笔 150-900ms，速度 150-900 px/s，方向缓慢转动，按触摸屏报点率采样
+static std::vector<std::vector<Sample>> make_strokes(size_t count, int rateHz, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<std::vector<Sample>> strokes;
+    double interval = 1000.0 / rateHz;
+    double now      = 0;
+
+    for (size_t s = 0; s < count; s++) {
+        double x        = 40 + unit(rng) * (SCREEN_WIDTH - 80);
+        double y        = 40 + unit(rng) * (PAGE_CONTENT_HEIGHT - 80);
+        double angle    = unit(rng) * 2 * M_PI;
+        double turn     = (unit(rng) - 0.5) * 8;  // rad/s
+        double speed    = 150 + unit(rng) * 750;
+        double duration = 150 + unit(rng) * 750;
+
+        std::vector<Sample> stroke;
+        for (double t = 0; t <= duration; t += interval) {
+            Sample sample;
+            sample.point.x = (int16_t)std::max(0.0, std::min<double>(SCREEN_WIDTH - 1, x));
+            sample.point.y = (int16_t)std::max(0.0, std::min<double>(PAGE_CONTENT_HEIGHT - 1, y));
+            sample.timeMs  = (uint32_t)(now + t);
+            stroke.push_back(sample);
+
+            angle += turn * interval / 1000 + (unit(rng) - 0.5) * 0.2;
+            turn += (unit(rng) - 0.5) * 2;
+            x += std::cos(angle) * speed * interval / 1000;
+            y += std::sin(angle) * speed * interval / 1000;
+        }
+        strokes.push_back(std::move(stroke));
+        now += duration + PEN_UP_MS;
+    }
+    return strokes;
+}
+
+enum class Policy {
+    PerSample,  // 每个采样点立即刷新
+    Timed,      // 只按 InkBatcher 的期限攒批
+    Paced,      // 期限到且面板空闲才输出（设备端的做法）
+};
+
+struct PolicyResult {
+    size_t refreshes = 0;
+    double area      = 0;  // 脏矩形面积之和
+    book::InkLatencyStats latency;
+};
+
+// 面板模型：刷新请求排队，逐个执行，每次 refreshMs，与区域大小无关；每笔开始时面板空闲
+static PolicyResult simulate(const std::vector<std::vector<Sample>>& strokes, Policy policy, uint32_t refreshMs)
+{
+    PolicyResult result;
+    uint32_t panelFree = 0;
+    std::vector<book::InkSegment> segments;
+    std::vector<uint32_t> waiting;  // 当前一批中各采样点的时间
+
+    auto flush = [&](book::InkBatcher& batcher, uint32_t now) {
+        book::InkRect rect;
+        uint32_t oldest = 0;
+        batcher.take(segments, rect, oldest);
+        uint32_t done = std::max(now, panelFree) + refreshMs;
+        panelFree     = done;
+        result.refreshes++;
+        result.area += (double)rect.w * rect.h;
+        for (uint32_t t : waiting) result.latency.add(done - t);
+        waiting.clear();
+    };
+
+    for (const auto& stroke : strokes) {
+        // 抬笔的间隔里面板排空，各笔单独计算
+        panelFree = 0;
+        book::InkBatcher batcher = policy == Policy::PerSample ? book::InkBatcher(0, 0, 0) : book::InkBatcher();
+        batcher.begin(stroke[0].point, stroke[0].timeMs, 3);
+        waiting.push_back(stroke[0].timeMs);
+
+        // 主循环约每毫秒轮询一次，新采样点到来时输入
+        size_t next = 1;
+        uint32_t end = stroke.back().timeMs;
+        for (uint32_t now = stroke[0].timeMs; now <= end || batcher.pending(); now++) {
+            while (next < stroke.size() && stroke[next].timeMs <= now) {
+                // 被过滤的采样点与已画出的墨迹相距不到 2px，不计延迟
+                size_t before = batcher.stroke().points.size();
+                batcher.add(stroke[next].point, stroke[next].timeMs);
+                if (batcher.stroke().points.size() > before) waiting.push_back(stroke[next].timeMs);
+                next++;
+            }
+            bool lifted = now >= end;
+            bool ready  = batcher.due(now) || (lifted && batcher.pending());
+            if (policy == Policy::Paced) ready = ready && panelFree <= now;
+            if (ready) flush(batcher, now);
+        }
+        batcher.finish();
+        waiting.clear();
+    }
+    return result;
+}
+
+static void print_policy(const char* name, const PolicyResult& r, size_t samples)
+{
+    printf("  %-10s %6zu refreshes (%.1f samples each), avg rect %6.0f px², touch→ink p50 %4u ms, p99 %5u ms, "
+           "max %5u ms\n",
+           name, r.refreshes, (double)samples / std::max<size_t>(1, r.refreshes),
+           r.area / std::max<size_t>(1, r.refreshes), r.latency.percentile(50), r.latency.percentile(99),
+           r.latency.max());
+}
+
+static bool same_pages(book::InkStore& store, const std::vector<std::vector<book::InkStroke>>& expected)
+{
+    std::vector<book::InkStroke> strokes;
+    for (size_t page = 0; page < expected.size(); page++) {
+        if (!store.loadPage((uint32_t)page, strokes) || strokes.size() != expected[page].size()) return false;
+        for (size_t i = 0; i < strokes.size(); i++) {
+            const auto& a = strokes[i].points;
+            const auto& b = expected[page][i].points;
+            if (a.size() != b.size() || strokes[i].width != expected[page][i].width) return false;
+            for (size_t k = 0; k < a.size(); k++) {
+                if (a[k].x != b[k].x || a[k].y != b[k].y) return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    size_t strokeCount = 2000;
+    int rateHz         = 100;
+    uint32_t refreshMs = 120;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--strokes" && i + 1 < argc) {
+            strokeCount = (size_t)atol(argv[++i]);
+        } else if (arg == "--rate" && i + 1 < argc) {
+            rateHz = atoi(argv[++i]);
+        } else if (arg == "--refresh" && i + 1 < argc) {
+            refreshMs = (uint32_t)atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--strokes N] [--rate HZ] [--refresh MS]\n", argv[0]);
+            printf("\n");
+            printf("  Synthetic handwriting sampled at the touch report rate. Reports the size of the\n");
+            printf("  delta-encoded strokes, simulates touch-to-ink latency for per-sample, timed and\n");
+            printf("  panel-paced batching against a model panel that serializes refreshes of --refresh ms,\n");
+            printf("  and checks the ink file round trip, undo, compaction and recovery from a torn write.\n");
+            return 1;
+        }
+    }
+    if (strokeCount == 0 || rateHz <= 0) return 1;
+
+    auto strokes = make_strokes(strokeCount, rateHz, 1);
+    size_t samples = 0;
+    for (const auto& s : strokes) samples += s.size();
+
+    // 1. 编码：设备端按 INK_MIN_DISTANCE 过滤采样点后保存
+    std::vector<book::InkStroke> kept;
+    size_t keptPoints = 0;
+    size_t encoded    = 0;
+    std::vector<uint8_t> data;
+    auto start = Clock::now();
+    for (const auto& stroke : strokes) {
+        book::InkBatcher batcher;
+        batcher.begin(stroke[0].point, stroke[0].timeMs, 3);
+        for (size_t i = 1; i < stroke.size(); i++) batcher.add(stroke[i].point, stroke[i].timeMs);
+        kept.push_back(batcher.finish());
+        keptPoints += kept.back().points.size();
+        book::encode_ink_stroke(kept.back(), data);
+        encoded += data.size() + book::INK_RECORD_HEADER_SIZE;
+    }
+    double encodeMs = elapsed_ms(start);
+    printf("strokes:   %zu, %zu samples at %d Hz, %zu kept after %d px filter\n", strokeCount, samples, rateHz,
+           keptPoints, book::INK_MIN_DISTANCE);
+    printf("encoded:   %.1f KB with record headers, %.2f bytes/point (int16 x,y: 4), %.0f bytes/stroke, %.1f ms\n",
+           encoded / 1024.0, (double)encoded / keptPoints, (double)encoded / strokeCount, encodeMs);
+
+    // 2. 攒批与延迟：面板模型，不是实测
+    printf("latency (model panel, %u ms per refresh, refreshes serialized):\n", refreshMs);
+    print_policy("per-sample", simulate(strokes, Policy::PerSample, refreshMs), samples);
+    print_policy("timed", simulate(strokes, Policy::Timed, refreshMs), samples);
+    print_policy("paced", simulate(strokes, Policy::Paced, refreshMs), samples);
+
+    // 3. 笔迹文件：每页若干笔，撤销一部分，重新打开后一致
+    std::string path = (fs::temp_directory_path() / "ink_bench.bin").string();
+    fs::remove(path);
+    const size_t pageCount = 50;
+    std::vector<std::vector<book::InkStroke>> expected(pageCount);
+    std::mt19937 rng(2);
+    book::InkStore store;
+    store.open(path);
+    start = Clock::now();
+    for (size_t i = 0; i < kept.size(); i++) {
+        uint32_t page = (uint32_t)(rng() % pageCount);
+        store.append(page, kept[i]);
+        expected[page].push_back(kept[i]);
+        if (rng() % 10 == 0 && store.undo(page)) expected[page].pop_back();
+    }
+    double appendMs = elapsed_ms(start);
+    printf("store:     %.1f KB, %.1f KB undone, %.3f ms per append\n", store.fileBytes() / 1024.0,
+           store.garbageBytes() / 1024.0, appendMs / kept.size());
+
+    bool ok = same_pages(store, expected);
+    store.close();
+    start = Clock::now();
+    store.open(path);
+    double openMs = elapsed_ms(start);
+    start = Clock::now();
+    ok = ok && same_pages(store, expected);
+    printf("reopen:    %.2f ms, all pages %.2f ms, %s\n", openMs, elapsed_ms(start), ok ? "ok" : "MISMATCH");
+
+    // 4. 大量撤销后重新打开时压缩
+    for (size_t page = 0; page < pageCount; page += 2) {
+        while (store.undo((uint32_t)page)) expected[page].pop_back();
+    }
+    uint64_t before = store.fileBytes();
+    store.close();
+    store.open(path);
+    bool compacted = store.garbageBytes() == 0 && store.fileBytes() < before && same_pages(store, expected);
+    printf("compact:   %.1f KB -> %.1f KB, %s\n", before / 1024.0, store.fileBytes() / 1024.0,
+           compacted ? "ok" : "FAILED");
+
+    // 5. 写入中断电：文件尾只有半条记录，重新打开时丢弃
+    uint64_t good = store.fileBytes();
+    store.close();
+    {
+        FILE* f = fopen(path.c_str(), "ab");
+        uint8_t torn[5] = {1, 0, 0, 0, book::INK_RECORD_STROKE};
+        fwrite(torn, 1, sizeof(torn), f);
+        fclose(f);
+    }
+    store.open(path);
+    bool recovered = store.fileBytes() == good && fs::file_size(path) == good && same_pages(store, expected);
+    book::InkStroke extra = kept[0];
+    recovered = recovered && store.append(0, extra);
+    expected[0].push_back(extra);
+    store.close();
+    store.open(path);
+    recovered = recovered && same_pages(store, expected);
+    printf("torn tail: %s\n", recovered ? "ok" : "FAILED");
+    store.close();
+    fs::remove(path);
+
+    return ok && compacted && recovered ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "gray_png.h"
+#include "png_codec.h"
+#include "bench_util.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// 返回单次解码的平均毫秒数，解码结果与 expected 不一致时返回负数
+static double time_decode(const std::vector<uint8_t>& png, const GrayImage& expected, int iterations)
+{
+    bool match = true;
+    book::decode_gray_png(png.data(), png.size(), [&](int y, const uint8_t* gray, int width) {
+        if (width != expected.width || memcmp(gray, expected.row(y), width) != 0) match = false;
+        return true;
+    });
+    if (!match) return -1;
+
+    volatile uint32_t sink = 0;
+    auto start             = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        book::decode_gray_png(png.data(), png.size(), [&](int, const uint8_t* gray, int) {
+            sink = sink + gray[0];
+            return true;
+        });
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return elapsed * 1000.0 / iterations;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s <pages_dir> [iterations]\n", argv[0]);
+        printf("\n");
+        printf("  Re-encodes every page PNG under pages_dir (cover.png is skipped) as 8-bit and as\n");
+        printf("  1/2/4-bit packed PNG, then reports file size and decode time of both.\n");
+        return 1;
+    }
+    int iterations = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::recursive_directory_iterator(argv[1])) {
+        if (entry.is_regular_file() && entry.path().extension() == ".png" && entry.path().filename() != "cover.png") {
+            files.push_back(entry.path());
+        }
+    }
+    if (files.empty()) {
+        fprintf(stderr, "No PNG pages found under %s\n", argv[1]);
+        return 1;
+    }
+
+    uint64_t legacyBytes = 0, minSumBytes = 0, packedBytes = 0;
+    double legacyMs = 0, packedMs = 0;
+    int depthCount[9] = {0};
+    int mismatches    = 0;
+
+    for (const auto& path : files) {
+        std::string error;
+        GrayImage image = read_png_gray(path.string(), &error);
+        if (image.empty()) {
+            fprintf(stderr, "Skip %s: %s\n", path.c_str(), error.c_str());
+            continue;
+        }
+
+        int depth = detect_bit_depth(image);
+        depthCount[depth]++;
+
+        std::vector<uint8_t> legacy = encode_png_gray(image, 9, 8, FilterStrategy::MinSum);
+        std::vector<uint8_t> minSum = encode_png_gray(image, 9, depth, FilterStrategy::MinSum);
+        std::vector<uint8_t> packed = encode_png_gray(image, 9, depth, FilterStrategy::MinSize);
+
+        double legacyTime = time_decode(legacy, image, iterations);
+        double packedTime = time_decode(packed, image, iterations);
+        if (legacyTime < 0 || packedTime < 0) {
+            fprintf(stderr, "Decode mismatch: %s\n", path.c_str());
+            mismatches++;
+            continue;
+        }
+
+        legacyBytes += legacy.size();
+        minSumBytes += minSum.size();
+        packedBytes += packed.size();
+        legacyMs += legacyTime;
+        packedMs += packedTime;
+    }
+
+    int pages = (int)files.size() - mismatches;
+    if (pages <= 0) return 1;
+
+    printf("pages: %d  (1-bit %d, 2-bit %d, 4-bit %d, 8-bit %d)\n", pages, depthCount[1], depthCount[2],
+           depthCount[4], depthCount[8]);
+    printf("\n%-28s %12s %10s %12s\n", "encoding", "total KB", "avg KB", "decode ms");
+    printf("%-28s %12.1f %10.2f %12.3f\n", "8-bit, min-sum filters", legacyBytes / 1024.0,
+           legacyBytes / 1024.0 / pages, legacyMs / pages);
+    printf("%-28s %12.1f %10.2f %12s\n", "packed, min-sum filters", minSumBytes / 1024.0,
+           minSumBytes / 1024.0 / pages, "-");
+    printf("%-28s %12.1f %10.2f %12.3f\n", "packed, min-size filters", packedBytes / 1024.0,
+           packedBytes / 1024.0 / pages, packedMs / pages);
+    printf("\nsize delta:   %+.1f%%\n", (double)packedBytes * 100.0 / legacyBytes - 100.0);
+    printf("decode delta: %+.1f%%\n", packedMs * 100.0 / legacyMs - 100.0);
+
+    if (mismatches > 0) {
+        printf("\n%d pages decoded differently from the source\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "crc32c.h"
+#include "file_checksums.h"
+#include "bench_util.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BookFile {
+    std::string path;  // 相对书籍目录
+    std::vector<uint8_t> data;
+};
+
+static std::vector<uint8_t> make_page(std::mt19937& rng)
+{
+    std::vector<uint8_t> data(20 * 1024 + rng() % (60 * 1024));
+    for (auto& b : data) b = (uint8_t)rng();
+    return data;
+}
+
+// 模拟转换器的输出：封面 + sections/{章}/{页}.png
+static std::vector<BookFile> convert(size_t sections, size_t pages, std::mt19937& rng)
+{
+    std::vector<BookFile> files;
+    files.push_back({"cover.png", make_page(rng)});
+    for (size_t s = 0; s < sections; s++) {
+        for (size_t p = 0; p < pages; p++) {
+            char path[48];
+            snprintf(path, sizeof(path), "sections/%03zu/%03zu.png", s, p + 1);
+            files.push_back({path, make_page(rng)});
+        }
+    }
+    return files;
+}
+
+// 模拟文件服务器写入：按 4KB 分块边写边算 CRC32C，写完记录到 .checksums
+static void upload(const std::string& bookDir, const BookFile& file)
+{
+    std::string path = bookDir + "/" + file.path;
+    for (size_t slash = bookDir.size() + 1; (slash = path.find('/', slash)) != std::string::npos; slash++) {
+        mkdir(path.substr(0, slash).c_str(), 0755);
+    }
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return;
+    uint32_t crc = 0;
+    for (size_t off = 0; off < file.data.size(); off += 4096) {
+        size_t n = std::min<size_t>(4096, file.data.size() - off);
+        fwrite(file.data.data() + off, 1, n, f);
+        crc = book::crc32c_update(crc, file.data.data() + off, n);
+    }
+    fclose(f);
+    book::ChecksumSidecar::record(path, file.data.size(), crc);
+}
+
+int main(int argc, char** argv)
+{
+    std::string root = "/tmp/sync_bench";
+    size_t sections  = 20;
+    size_t pages     = 60;
+    double changed   = 0.05;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--dir" && i + 1 < argc) {
+            root = argv[++i];
+        } else if (arg == "--sections" && i + 1 < argc) {
+            sections = (size_t)atol(argv[++i]);
+        } else if (arg == "--pages" && i + 1 < argc) {
+            pages = (size_t)atol(argv[++i]);
+        } else if (arg == "--changed" && i + 1 < argc) {
+            changed = atof(argv[++i]);
+        } else {
+            printf("Usage: %s [--dir PATH] [--sections N] [--pages N] [--changed F]\n", argv[0]);
+            printf("\n");
+            printf("  Uploads a synthetic book (--sections x --pages pages) into --dir through the checksum\n");
+            printf("  sidecar, re-converts it with --changed of the pages re-rendered and one extra section,\n");
+            printf("  then compares the new manifest against the device and reports the bytes a manifest\n");
+            printf("  sync sends versus a full re-upload. The directory is wiped first.\n");
+            return 1;
+        }
+    }
+
+    bool ok = book::crc32c("123456789", 9) == 0xE3069283 &&
+              book::crc32c_update(book::crc32c("1234", 4), "56789", 5) == 0xE3069283;
+    printf("crc32c:    check value and chunked update: %s\n", ok ? "ok" : "FAILED");
+
+    remove_tree(root);
+    mkdir(root.c_str(), 0755);
+    std::string bookDir = root + "/book";
+    mkdir(bookDir.c_str(), 0755);
+
+    std::mt19937 rng(1);
+    auto original = convert(sections, pages, rng);
+    uint64_t fullBytes = 0;
+    for (const auto& f : original) upload(bookDir, f);
+
+    // 重新转换：一部分页面重新渲染（内容不同），追加一个章节
+    auto current = original;
+    std::set<std::string> expected;
+    for (size_t i = 1; i < current.size(); i++) {
+        if (rng() % 10000 < changed * 10000) {
+            current[i].data = make_page(rng);
+            expected.insert(current[i].path);
+        }
+    }
+    for (size_t p = 0; p < pages; p++) {
+        char path[48];
+        snprintf(path, sizeof(path), "sections/%03zu/%03zu.png", sections, p + 1);
+        current.push_back({path, make_page(rng)});
+        expected.insert(path);
+    }
+
+    // 客户端清单
+    std::string manifest;
+    for (const auto& f : current) {
+        char line[64];
+        snprintf(line, sizeof(line), "%08" PRIx32 " %zu ", book::crc32c(f.data.data(), f.data.size()), f.data.size());
+        manifest += line + f.path + "\n";
+        fullBytes += f.data.size();
+    }
+
+    // 设备端对照，逐行处理
+    auto start = Clock::now();
+    book::ManifestComparer comparer(bookDir);
+    std::set<std::string> upload;
+    uint64_t uploadBytes = 0;
+    size_t missing = 0, lines = 0;
+    for (size_t pos = 0; pos < manifest.size();) {
+        size_t end = manifest.find('\n', pos);
+        book::ManifestEntry entry;
+        if (book::parse_manifest_line(manifest.substr(pos, end - pos).c_str(), entry)) {
+            lines++;
+            book::ManifestState state = comparer.check(entry);
+            if (state != book::ManifestState::Unchanged) {
+                upload.insert(entry.path);
+                uploadBytes += entry.size;
+                if (state == book::ManifestState::Missing) missing++;
+            }
+        }
+        pos = end + 1;
+    }
+    double compareMs = elapsed_ms(start);
+
+    bool exact = upload == expected && lines == current.size();
+    printf("book:      %zu files, %.1f MB; re-conversion changed %zu pages and added %zu\n", current.size(),
+           fullBytes / 1048576.0, expected.size() - pages, pages);
+    printf("manifest:  %.1f KB, compared in %.2f ms on host, %zu to upload (%zu missing): %s\n",
+           manifest.size() / 1024.0, compareMs, upload.size(), missing, exact ? "ok" : "FAILED");
+    uint64_t syncBytes = manifest.size() + uploadBytes;
+    printf("wire:      full re-upload %.1f MB, manifest sync %.2f MB (%.1f%% saved)\n", fullBytes / 1048576.0,
+           syncBytes / 1048576.0, 100.0 - 100.0 * syncBytes / fullBytes);
+    ok = ok && exact;
+
+    // 上传之后再对照一次应当全部不变；绕过文件服务器改动的文件按大小识别
+    for (const auto& f : current) {
+        if (upload.count(f.path)) ::upload(bookDir, f);
+    }
+    {
+        FILE* f = fopen((bookDir + "/cover.png").c_str(), "ab");
+        if (f) fputs("x", f), fclose(f);
+    }
+    book::ManifestComparer again(bookDir);
+    size_t stale = 0, different = 0;
+    for (const auto& f : current) {
+        book::ManifestEntry entry{f.path, f.data.size(), book::crc32c(f.data.data(), f.data.size())};
+        if (again.check(entry) != book::ManifestState::Unchanged) {
+            different++;
+            if (f.path == "cover.png") stale++;
+        }
+    }
+    book::ManifestEntry escape{"../book/cover.png", 1, 0};
+    bool rejected = again.check(escape) == book::ManifestState::Changed;
+    bool settled  = different == 1 && stale == 1 && rejected;
+    printf("checks:    second pass all unchanged except the file edited behind the server, .. rejected: %s\n",
+           settled ? "ok" : "FAILED");
+    ok = ok && settled;
+
+    // 同一目录反复覆盖：写入方压缩 .checksums，文件不随覆盖次数增长；读取不改动文件
+    std::string sidecar = bookDir + "/sections/000/" + book::CHECKSUM_SIDECAR_NAME;
+    size_t minimal      = 0;
+    for (size_t i = 1; i <= pages; i++) {
+        std::string name = current[i].path.substr(current[i].path.rfind('/') + 1);
+        minimal += snprintf(nullptr, 0, "%08x %zu %s\n", 0u, current[i].data.size(), name.c_str());
+    }
+    for (int round = 0; round < 3; round++) {
+        for (size_t i = 1; i <= pages; i++) ::upload(bookDir, current[i]);
+    }
+    book::ChecksumSidecar loaded;
+    struct stat before, after;
+    stat(sidecar.c_str(), &before);
+    loaded.load(bookDir + "/sections/000");
+    stat(sidecar.c_str(), &after);
+    bool compacted = loaded.size() == pages && before.st_size < (off_t)(minimal * 4) &&
+                     after.st_size == before.st_size && after.st_mtime == before.st_mtime;
+    printf("checks:    sidecar %ld bytes after 4 writes per page (%zu without compaction), load read-only: %s\n",
+           (long)before.st_size, minimal * 4, compacted ? "ok" : "FAILED");
+    ok = ok && compacted;
+
+    // 两个写入任务（上传、复制）同时追加同一目录，读取任务（阅读器）同时读入：不丢记录
+    std::string shared = root + "/shared";
+    mkdir(shared.c_str(), 0755);
+    constexpr int WRITES = 3000, NAMES = 40;
+    std::atomic<bool> writing{true};
+    auto writer = [&](int id) {
+        for (int k = 0; k < WRITES; k++) {
+            std::string path = shared + "/w" + std::to_string(id) + "_" + std::to_string(k % NAMES) + ".png";
+            if (k % 7 == 3) {
+                book::ChecksumSidecar::forget(path);
+            } else {
+                book::ChecksumSidecar::record(path, (uint64_t)k, (uint32_t)(id * WRITES + k));
+            }
+        }
+    };
+    std::thread reader([&] {
+        book::ChecksumSidecar sidecar;
+        while (writing) sidecar.load(shared);
+    });
+    std::thread w0(writer, 0), w1(writer, 1);
+    w0.join();
+    w1.join();
+    writing = false;
+    reader.join();
+    book::ChecksumSidecar result;
+    result.load(shared);
+    int lost = 0;
+    for (int id = 0; id < 2; id++) {
+        for (int n = 0; n < NAMES; n++) {
+            int last                     = WRITES - NAMES + n;  // 每个名字最后一次写入
+            std::string name             = "w" + std::to_string(id) + "_" + std::to_string(n) + ".png";
+            const book::ChecksumEntry* e = result.find(name);
+            uint32_t crc                 = (uint32_t)(id * WRITES + last);
+            bool expected = last % 7 == 3 ? e == nullptr : e && e->size == (uint64_t)last && e->crc == crc;
+            if (!expected) lost++;
+        }
+    }
+    printf("checks:    2 writers x %d appends with a concurrent reader, %d records wrong: %s\n", WRITES, lost,
+           lost == 0 ? "ok" : "FAILED");
+    ok = ok && lost == 0;
+
+    remove_tree(root);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "text_book.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static bool paginate(const std::string& path, const book::TextLayoutParams& params, size_t stepBytes, int maxSteps,
+                     std::vector<uint32_t>& pages, size_t* peakHeap)
+{
+    size_t base = heap_in_use();
+    size_t peak = 0;
+
+    book::TextPaginator paginator(efont24_width);
+    if (!paginator.begin(path, params)) {
+        fprintf(stderr, "%s\n", paginator.lastError().c_str());
+        return false;
+    }
+    peak = std::max(peak, heap_in_use() - base);
+    for (int i = 0; (maxSteps < 0 || i < maxSteps) && paginator.step(stepBytes); i++) {
+        peak = std::max(peak, heap_in_use() - base);
+    }
+    peak = std::max(peak, heap_in_use() - base);
+    if (!paginator.lastError().empty()) {
+        fprintf(stderr, "%s\n", paginator.lastError().c_str());
+        return false;
+    }
+    pages = paginator.pages();
+    if (peakHeap) *peakHeap = peak;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s <book.txt> [step_kb]\n", argv[0]);
+        printf("\n");
+        printf("  Paginates a UTF-8 / GBK text file the way the device does in the background (writing\n");
+        printf("  <book.txt>.idx), reports throughput and peak heap, checks that laying out pages one by one\n");
+        printf("  from the first page matches the index, and that an interrupted run resumes to the same result.\n");
+        return 1;
+    }
+    std::string path = argv[1];
+    size_t stepBytes = (argc > 2 ? std::max(1, atoi(argv[2])) : 32) * 1024;
+    std::string idx  = path + book::TEXT_INDEX_SUFFIX;
+
+    // 与设备端阅读器相同的版面：efontCN_24，行宽 492px，每页 23 行
+    book::TextLayoutParams params;
+    params.lineWidth    = 492;
+    params.linesPerPage = 23;
+    params.fontId       = 24;
+
+    const uint32_t fileSize = (uint32_t)fs::file_size(path);
+
+    // 1. 从头分页
+    fs::remove(idx);
+    std::vector<uint32_t> pages;
+    size_t peak = 0;
+    auto start  = Clock::now();
+    if (!paginate(path, params, stepBytes, -1, pages, &peak)) return 1;
+    double paginateMs = elapsed_ms(start);
+
+    book::TextPaginator probe(efont24_width);
+    probe.begin(path, params);
+    bool reloaded = probe.done() && probe.pages() == pages;
+    const book::TextEncoding encoding = probe.encoding();
+    probe.end();
+
+    printf("file:      %s, %.2f MB, %s\n", path.c_str(), fileSize / 1048576.0,
+           encoding == book::TextEncoding::Gbk ? "GBK" : "UTF-8");
+    printf("layout:    %d px x %d lines, step %zu KB\n", params.lineWidth, params.linesPerPage, stepBytes / 1024);
+    printf("\npaginate:  %zu pages in %.1f ms, %.1f MB/s, %.0f pages/s\n", pages.size(), paginateMs,
+           fileSize / 1048576.0 / (paginateMs / 1000.0), pages.size() / (paginateMs / 1000.0));
+    printf("peak heap: %.1f KB (read buffer %zu KB, glyph width table 64 KB, page offsets %.1f KB + vector growth)\n",
+           peak / 1024.0, stepBytes / 1024, pages.size() * 4 / 1024.0);
+    printf("index:     %.1f KB on disk, reload %s\n", fs::file_size(idx) / 1024.0, reloaded ? "ok" : "FAILED");
+
+    // 2. 阅读器逐页排版：从第一页起只靠上一页的结果求下一页页首，应与索引一致
+    book::GlyphWidths widths(efont24_width);
+    std::vector<book::TextLine> lines;
+    std::vector<uint8_t> window(book::text_page_window(params));
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return 1;
+
+    int mismatches = 0;
+    size_t checked = 0;
+    double layoutMs = 0, slowest = 0;
+    uint32_t offset = pages.empty() ? 0 : pages.front();
+    while (offset < fileSize && checked < pages.size()) {
+        if (offset != pages[checked]) {
+            if (mismatches++ < 5) {
+                fprintf(stderr, "page %zu: layout starts at %u, index has %u\n", checked + 1, offset, pages[checked]);
+            }
+            offset = pages[checked];
+        }
+        size_t size = std::min<size_t>(window.size(), fileSize - offset);
+        fseek(f, offset, SEEK_SET);
+        if (fread(window.data(), 1, size, f) != size) break;
+
+        auto pageStart = Clock::now();
+        uint32_t next  = 0;
+        book::layout_text_page(encoding, window.data(), size, offset, offset + size >= fileSize, widths, params,
+                               lines, next);
+        for (const auto& line : lines) {
+            const uint8_t* text = window.data() + (line.start - offset);
+            std::string utf8    = book::text_to_utf8(encoding, text, line.end - line.start);
+            (void)utf8;
+        }
+        double ms = elapsed_ms(pageStart);
+        layoutMs += ms;
+        slowest = std::max(slowest, ms);
+        checked++;
+        offset = next;
+    }
+    fclose(f);
+    if (checked != pages.size()) {
+        fprintf(stderr, "page walk ended after %zu of %zu pages\n", checked, pages.size());
+        mismatches++;
+    }
+    printf("\nper page:  %.3f ms layout + UTF-8 (slowest %.3f ms), window %zu KB, %zu pages walked, %d mismatches\n",
+           layoutMs / std::max<size_t>(1, checked), slowest, window.size() / 1024, checked, mismatches);
+
+    // 3. 中断后继续：先处理一部分，关闭后重新打开，应从最后一个页首接着分页
+    fs::remove(idx);
+    std::vector<uint32_t> partial, resumed;
+    int halfSteps = (int)(fileSize / stepBytes / 2);
+    if (!paginate(path, params, stepBytes, halfSteps, partial, nullptr)) return 1;
+    if (!paginate(path, params, stepBytes, -1, resumed, nullptr)) return 1;
+    bool resumeOk = resumed == pages;
+    printf("resume:    interrupted at %zu pages, resumed to %zu pages, %s\n", partial.size(), resumed.size(),
+           resumeOk ? "identical" : "DIFFERENT");
+
+    return mismatches == 0 && reloaded && resumeOk ? 0 : 1;
+}
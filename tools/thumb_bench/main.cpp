@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "thumb_atlas.h"
+#include "bench_util.h"
+#include <json/json.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// 与设备端 BookInfo 解析相同：按 pageFormat / layout 选择页面来源
+static bool load_source(const fs::path& bookDir, book::ThumbSource& source)
+{
+    std::ifstream in(bookDir / "metadata.json");
+    Json::Value metadata;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    if (!in || !Json::parseFromStream(builder, in, &metadata, &errors)) {
+        fprintf(stderr, "Failed to read %s/metadata.json %s\n", bookDir.c_str(), errors.c_str());
+        return false;
+    }
+
+    source.bookDir = bookDir.string();
+    source.strips  = metadata.get("layout", "").asString() == "strips";
+
+    std::string format = metadata.get("pageFormat", "").asString();
+    if (format == "tiles") {
+        source.pageExtension = ".tpg";
+    } else if (format == "bands") {
+        source.pageExtension = ".bnd";
+    } else {
+        source.pageExtension = ".png";
+    }
+
+    for (const auto& section : metadata["sections"]) {
+        int index = section.get("index", 0).asInt();
+        int count = section.get("pageCount", 0).asInt();
+        for (int page = 1; page <= count; page++) {
+            source.pages.push_back({index, page});
+        }
+    }
+    return !source.pages.empty();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s <book_dir> [cache_size] [sweeps]\n", argv[0]);
+        printf("\n");
+        printf("  Builds <book_dir>/thumbs.bin from a compiled book (any page format), then simulates\n");
+        printf("  dragging the progress bar back and forth and reports thumbnail lookups per second.\n");
+        return 1;
+    }
+    int cacheSize = argc > 2 ? std::max(1, atoi(argv[2])) : 16;
+    int sweeps    = argc > 3 ? std::max(1, atoi(argv[3])) : 20;
+
+    fs::path bookDir = argv[1];
+    book::ThumbSource source;
+    if (!load_source(bookDir, source)) return 1;
+
+    // 从头生成，测量每页耗时
+    fs::path atlasPath = bookDir / book::THUMB_ATLAS_FILE_NAME;
+    fs::remove(atlasPath);
+
+    book::ThumbAtlasBuilder builder;
+    if (!builder.begin(source)) {
+        fprintf(stderr, "%s\n", builder.lastError().c_str());
+        return 1;
+    }
+    auto start = Clock::now();
+    double slowest = 0;
+    while (!builder.done()) {
+        auto pageStart = Clock::now();
+        builder.step();
+        if (!builder.lastError().empty()) {
+            fprintf(stderr, "%s\n", builder.lastError().c_str());
+            return 1;
+        }
+        slowest = std::max(slowest, elapsed_ms(pageStart));
+    }
+    double buildMs = elapsed_ms(start);
+    builder.end();
+
+    // 中断后续生成：已完成的图集再次 begin() 应直接处于完成状态
+    book::ThumbAtlasBuilder resume;
+    if (!resume.begin(source) || !resume.done()) {
+        fprintf(stderr, "Resume check failed: %d / %d\n", resume.generated(), resume.total());
+        return 1;
+    }
+    resume.end();
+
+    const int total = (int)source.pages.size();
+    printf("pages: %d (%s%s)\n", total, source.strips ? "strips" : "pages, ",
+           source.strips ? "" : source.pageExtension.c_str());
+    printf("atlas: %.1f KB, %zu bytes per thumbnail (%dx%d, %d-bit)\n", fs::file_size(atlasPath) / 1024.0,
+           book::THUMB_BYTES, book::THUMB_WIDTH, book::THUMB_HEIGHT, book::THUMB_BIT_DEPTH);
+    printf("build: %.2f ms/page (slowest %.2f ms), %.1f ms total\n", buildMs / total, slowest, buildMs);
+
+    // 拖动模拟：每次扫过全书，手指每移动一步请求相邻 5 张（当前页 ± 2），来回往复
+    book::ThumbAtlasReader reader;
+    if (!reader.open(atlasPath.string(), cacheSize) || reader.available() != total) {
+        fprintf(stderr, "Failed to open %s\n", atlasPath.c_str());
+        return 1;
+    }
+
+    const int steps = 300;  // 进度条宽度方向上的触摸采样数
+    std::vector<uint8_t> expanded((size_t)book::THUMB_WIDTH * 2 * book::THUMB_HEIGHT * 2);
+    uint64_t lookups = 0;
+    start            = Clock::now();
+    for (int sweep = 0; sweep < sweeps; sweep++) {
+        for (int step = 0; step < steps; step++) {
+            int pos    = (sweep & 1) ? steps - 1 - step : step;
+            int center = pos * (total - 1) / (steps - 1);
+            for (int offset = -2; offset <= 2; offset++) {
+                const uint8_t* thumb = reader.thumb(std::max(0, std::min(total - 1, center + offset)));
+                if (!thumb) {
+                    fprintf(stderr, "Missing thumbnail near %d\n", center);
+                    return 1;
+                }
+                book::expand_thumb(thumb, 2, expanded.data());
+                lookups++;
+            }
+        }
+    }
+    double scrubMs = elapsed_ms(start);
+
+    printf("\nscrub: %d sweeps x %d steps, cache %d thumbnails (%.1f KB)\n", sweeps, steps, cacheSize,
+           cacheSize * book::THUMB_BYTES / 1024.0);
+    printf("  lookups:    %llu (%.0f/s including 2x expand)\n", (unsigned long long)lookups,
+           lookups * 1000.0 / scrubMs);
+    printf("  file reads: %u (%.1f KB), cache hits: %u (%.1f%%)\n", reader.reads(),
+           reader.reads() * book::THUMB_BYTES / 1024.0, reader.cacheHits(),
+           reader.cacheHits() * 100.0 / std::max<uint64_t>(1, lookups));
+    return 0;
+}
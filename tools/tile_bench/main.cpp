@@ -0,0 +1,183 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "gray_png.h"
+#include "png_codec.h"
+#include "tile_encoder.h"
+#include "tile_page.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static double time_png(const std::vector<uint8_t>& png, int iterations)
+{
+    volatile uint32_t sink = 0;
+    auto start             = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        book::decode_gray_png(png.data(), png.size(), [&](int, const uint8_t* gray, int) {
+            sink = sink + gray[0];
+            return true;
+        });
+    }
+    return elapsed_ms(start) / iterations;
+}
+
+// 解码 tiles 中列出的块（空白块只填白），返回单次平均毫秒数
+static double time_tiles(book::TilePageView& view, const std::vector<int>& tiles, int iterations)
+{
+    std::vector<uint8_t> gray((size_t)view.tileSize() * view.tileSize());
+    volatile uint32_t sink = 0;
+    auto start             = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (int tile : tiles) {
+            view.decodeTile(tile, gray.data());
+            sink = sink + gray[0];
+        }
+    }
+    return elapsed_ms(start) / iterations;
+}
+
+// 逐块解码并与原图比较
+static bool verify_tiles(book::TilePageView& view, const GrayImage& expected)
+{
+    std::vector<uint8_t> gray((size_t)view.tileSize() * view.tileSize());
+    for (int tile = 0; tile < view.tileCount(); tile++) {
+        int x, y, w, h;
+        view.tileRect(tile, x, y, w, h);
+        if (!view.decodeTile(tile, gray.data())) return false;
+        for (int row = 0; row < h; row++) {
+            if (memcmp(gray.data() + (size_t)row * w, expected.row(y + row) + x, w) != 0) return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s <book_dir> [tile_size] [iterations]\n", argv[0]);
+        printf("\n");
+        printf("  Re-encodes the page PNGs of a compiled book (sections/NNN/PPP.png) as tiled pages and\n");
+        printf("  reports blank tiles, tiles unchanged from the previous page, size and decode time.\n");
+        return 1;
+    }
+    int tileSize   = argc > 2 ? std::max(8, std::min(255, atoi(argv[2]))) : 60;
+    int iterations = argc > 3 ? std::max(1, atoi(argv[3])) : 5;
+
+    // 按章节、页码顺序排列，模拟顺序翻页
+    std::map<fs::path, std::vector<fs::path>> sections;
+    fs::path sectionsDir = fs::path(argv[1]) / "sections";
+    if (!fs::is_directory(sectionsDir)) {
+        fprintf(stderr, "No sections directory under %s\n", argv[1]);
+        return 1;
+    }
+    for (const auto& entry : fs::recursive_directory_iterator(sectionsDir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".png") {
+            sections[entry.path().parent_path()].push_back(entry.path());
+        }
+    }
+
+    int pages = 0, mismatches = 0;
+    uint64_t tilesTotal = 0, tilesBlank = 0, tilesCompared = 0, tilesSame = 0, tilesSameBlank = 0;
+    uint64_t pngBytes = 0, tileBytes = 0;
+    double pngMs = 0, fullMs = 0, diffMs = 0;
+    double minHit = 1.0, maxHit = 0.0;
+
+    for (auto& section : sections) {
+        std::sort(section.second.begin(), section.second.end());
+        std::vector<uint32_t> previous;  // 上一页各块的哈希，章节开头为空（整页刷新）
+
+        for (const auto& path : section.second) {
+            std::string error;
+            GrayImage image = read_png_gray(path.string(), &error);
+            if (image.empty()) {
+                fprintf(stderr, "Skip %s: %s\n", path.c_str(), error.c_str());
+                continue;
+            }
+
+            int depth                   = detect_bit_depth(image);
+            std::vector<uint8_t> png    = encode_png_gray(image, 9, depth);
+            std::vector<uint8_t> tiled  = encode_tile_page(image, depth, tileSize);
+            book::TilePageView view;
+            if (!view.parse(tiled.data(), tiled.size()) || !verify_tiles(view, image)) {
+                fprintf(stderr, "Tile mismatch: %s\n", path.c_str());
+                mismatches++;
+                continue;
+            }
+
+            std::vector<int> all, changed;
+            std::vector<uint32_t> hashes(view.tileCount());
+            int same = 0;
+            for (int tile = 0; tile < view.tileCount(); tile++) {
+                hashes[tile] = view.hash(tile);
+                if (view.occupied(tile)) all.push_back(tile);
+                if (previous.empty()) continue;
+                if (previous[tile] == hashes[tile]) {
+                    same++;
+                    if (hashes[tile] == book::TILE_HASH_BLANK) tilesSameBlank++;
+                } else {
+                    changed.push_back(tile);
+                }
+            }
+
+            pages++;
+            tilesTotal += view.tileCount();
+            tilesBlank += view.tileCount() - view.occupiedCount();
+            pngBytes += png.size();
+            tileBytes += tiled.size();
+            pngMs += time_png(png, iterations);
+            double full = time_tiles(view, all, iterations);
+            fullMs += full;
+            if (previous.empty()) {
+                diffMs += full;
+            } else {
+                tilesCompared += view.tileCount();
+                tilesSame += same;
+                double hit = (double)same / view.tileCount();
+                minHit     = std::min(minHit, hit);
+                maxHit     = std::max(maxHit, hit);
+                diffMs += time_tiles(view, changed, iterations);
+            }
+            previous = std::move(hashes);
+        }
+    }
+
+    if (pages == 0) {
+        fprintf(stderr, "No pages found under %s\n", sectionsDir.c_str());
+        return 1;
+    }
+
+    printf("pages: %d in %zu sections, %d x %d tiles\n", pages, sections.size(), tileSize, tileSize);
+    printf("\nblank tiles:              %5.1f%%\n", tilesBlank * 100.0 / tilesTotal);
+    if (tilesCompared > 0) {
+        printf("unchanged vs prev page:   %5.1f%%  (min %.1f%%, max %.1f%%; blank on both pages %.1f%%)\n",
+               tilesSame * 100.0 / tilesCompared, minHit * 100.0, maxHit * 100.0,
+               tilesSameBlank * 100.0 / tilesCompared);
+    }
+    printf("\n%-32s %10s %10s %12s\n", "encoding", "total KB", "avg KB", "decode ms");
+    printf("%-32s %10.1f %10.2f %12.3f\n", "packed PNG, whole page", pngBytes / 1024.0, pngBytes / 1024.0 / pages,
+           pngMs / pages);
+    printf("%-32s %10.1f %10.2f %12.3f\n", "tiled, all non-blank tiles", tileBytes / 1024.0,
+           tileBytes / 1024.0 / pages, fullMs / pages);
+    printf("%-32s %10s %10s %12.3f\n", "tiled, changed tiles only", "-", "-", diffMs / pages);
+    printf("\nsize delta:         %+.1f%%\n", (double)tileBytes * 100.0 / pngBytes - 100.0);
+    printf("decode delta (all): %+.1f%%\n", fullMs * 100.0 / pngMs - 100.0);
+    printf("decode delta (diff):%+.1f%%\n", diffMs * 100.0 / pngMs - 100.0);
+
+    if (mismatches > 0) {
+        printf("\n%d pages decoded differently from the source\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
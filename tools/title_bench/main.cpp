@@ -0,0 +1,228 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "title_index.h"
+#include "text_book.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Book {
+    std::string id;
+    std::string title;
+    std::string author;
+};
+
+static std::string utf8(uint32_t codepoint)
+{
+    char out[4];
+    return std::string(out, book::encode_utf8(codepoint, out));
+}
+
+// 合成书库：中文书名 2-12 字（常用字按齐夫分布抽取，书名常见的字更集中），作者 2-3 字，另有约 1/5 英文书名
+static std::vector<Book> make_library(size_t count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint32_t> pool;
+    for (uint32_t cp = 0x4E00; cp < 0x4E00 + 3000; cp += 1) pool.push_back(cp);
+    std::shuffle(pool.begin(), pool.end(), rng);
+    std::vector<double> weights(pool.size());
+    for (size_t i = 0; i < pool.size(); i++) weights[i] = 1.0 / (double)(i + 10);
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+
+    static const char* WORDS[] = {"the",  "of",    "night", "city",   "river", "winter", "garden", "machine",
+                                  "last", "light", "house", "empire", "stars", "memory", "ocean",  "silent"};
+    std::vector<Book> books;
+    for (size_t i = 0; i < count; i++) {
+        Book b;
+        b.id = "book_" + std::to_string(i);
+        if (rng() % 5 == 0) {
+            int words = 2 + rng() % 4;
+            for (int w = 0; w < words; w++) {
+                std::string word = WORDS[rng() % 16];
+                if (w == 0) word[0] = (char)(word[0] - 32);
+                b.title += (w ? " " : "") + word;
+            }
+            b.author = std::string(1, (char)('A' + rng() % 26)) + ". Writer" + std::to_string(rng() % 300);
+        } else {
+            int len = 2 + rng() % 11;
+            for (int c = 0; c < len; c++) b.title += utf8(pool[pick(rng)]);
+            if (rng() % 4 == 0) b.title += "（第" + std::to_string(1 + rng() % 9) + "卷）";
+            int alen = 2 + rng() % 2;
+            for (int c = 0; c < alen; c++) b.author += utf8(pool[pick(rng)]);
+        }
+        books.push_back(b);
+    }
+    return books;
+}
+
+// 逐本子串匹配，作为正确结果
+static size_t brute_force(const std::vector<Book>& books, const std::string& query)
+{
+    std::string needle = book::normalize_title_text(query);
+    size_t count       = 0;
+    for (const auto& b : books) {
+        if (book::normalize_title_text(b.title).find(needle) != std::string::npos ||
+            book::normalize_title_text(b.author).find(needle) != std::string::npos) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// 从书库中取查询：某本书书名 / 作者的一段，外加一些不存在的组合
+static std::vector<std::string> make_queries(const std::vector<Book>& books, size_t count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<std::string> queries;
+    for (size_t i = 0; i < count; i++) {
+        const Book& b          = books[rng() % books.size()];
+        const std::string& src = rng() % 4 == 0 ? b.author : b.title;
+        std::vector<size_t> starts;
+        for (size_t p = 0; p < src.size(); p++) {
+            if (((uint8_t)src[p] & 0xC0) != 0x80) starts.push_back(p);
+        }
+        starts.push_back(src.size());
+        size_t chars = starts.size() - 1;
+        size_t len   = std::min<size_t>(chars, 1 + rng() % 4);
+        size_t first = rng() % (chars - len + 1);
+        std::string query = src.substr(starts[first], starts[first + len] - starts[first]);
+        if (book::normalize_title_text(query).empty()) continue;  // 只有空白
+        queries.push_back(query);
+    }
+    queries.push_back("不存在的书名");
+    queries.push_back("zzzz");
+    queries.push_back("NIGHT CITY");
+    return queries;
+}
+
+int main(int argc, char** argv)
+{
+    size_t count              = argc > 1 ? (size_t)atoi(argv[1]) : 5000;
+    size_t queryCount         = 500;
+    std::string path          = (fs::temp_directory_path() / "title_bench.idx").string();
+    std::vector<Book> library = make_library(count, 1);
+
+    // 1. 首次扫描：逐本加入后保存
+    book::TitleIndex index;
+    auto start = Clock::now();
+    for (const auto& b : library) index.update(b.id, b.title, b.author);
+    double addMs = elapsed_ms(start);
+    start        = Clock::now();
+    if (!index.save(path)) {
+        fprintf(stderr, "save failed: %s\n", path.c_str());
+        return 1;
+    }
+    double saveMs = elapsed_ms(start);
+    printf("library:   %zu books\n", count);
+    printf("build:     add %.1f ms, merge + save %.1f ms, file %.1f KB, memory %.1f KB\n", addMs, saveMs,
+           fs::file_size(path) / 1024.0, index.memoryBytes() / 1024.0);
+
+    // 2. 重新打开书架：加载 + 扫描结果无变化
+    book::TitleIndex loaded;
+    start = Clock::now();
+    if (!loaded.load(path)) {
+        fprintf(stderr, "load failed\n");
+        return 1;
+    }
+    double loadMs = elapsed_ms(start);
+    start         = Clock::now();
+    bool changed  = false;
+    std::vector<std::string> ids;
+    for (const auto& b : library) {
+        changed = loaded.update(b.id, b.title, b.author) || changed;
+        ids.push_back(b.id);
+    }
+    changed = loaded.prune(ids) > 0 || changed;
+    printf("reopen:    load %.1f ms, sync %.1f ms, %s\n", loadMs, elapsed_ms(start),
+           changed ? "CHANGED (unexpected)" : "unchanged");
+
+    // 3. 查询：耗时分布，结果数与逐本匹配一致
+    std::vector<std::string> queries = make_queries(library, queryCount, 2);
+    std::vector<double> times;
+    int mismatches = changed ? 1 : 0;
+    book::TitleSearchResult result;
+    for (const auto& q : queries) {
+        start = Clock::now();
+        loaded.search(q, 8, 20, result);
+        times.push_back(elapsed_ms(start));
+        size_t expected = brute_force(library, q);
+        if (result.total != expected && mismatches++ < 5) {
+            fprintf(stderr, "query '%s': %zu results, expected %zu\n", q.c_str(), result.total, expected);
+        }
+    }
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    auto pct = [&](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))]; };
+    printf("search:    %zu queries, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", sorted.size(), pct(0.5), pct(0.99),
+           sorted.back());
+
+    // 单字查询的候选最多，单独报告
+    double singleMax = 0;
+    for (size_t i = 0; i < queries.size(); i++) {
+        std::string n = book::normalize_title_text(queries[i]);
+        size_t chars  = 0;
+        for (char c : n) chars += ((uint8_t)c & 0xC0) != 0x80;
+        if (chars == 1) singleMax = std::max(singleMax, times[i]);
+    }
+    printf("           single-char max %.3f ms\n", singleMax);
+
+    loaded.search("", 0, 20, result);
+    printf("suggest:   %zu top chars, first:", result.nextChars.size());
+    for (size_t i = 0; i < std::min<size_t>(result.nextChars.size(), 8); i++) {
+        printf(" %s", utf8(result.nextChars[i]).c_str());
+    }
+    printf("\n");
+
+    // 4. 增量：改名、删除、新增后查询仍与逐本匹配一致，保存后再加载结果不变
+    std::mt19937 rng(3);
+    start = Clock::now();
+    for (int i = 0; i < 50; i++) {
+        Book& b = library[rng() % library.size()];
+        b.title = "新版" + b.title;
+        loaded.update(b.id, b.title, b.author);
+    }
+    for (int i = 0; i < 20; i++) {
+        size_t k = rng() % library.size();
+        loaded.remove(library[k].id);
+        library.erase(library.begin() + k);
+    }
+    std::vector<Book> extra = make_library(30, 4);
+    for (auto& b : extra) {
+        b.id = "new_" + b.id;
+        loaded.update(b.id, b.title, b.author);
+        library.push_back(b);
+    }
+    double updateMs = elapsed_ms(start);
+    for (const auto& q : make_queries(library, 200, 5)) {
+        loaded.search(q, 8, 0, result);
+        size_t expected = brute_force(library, q);
+        if (result.total != expected && mismatches++ < 5) {
+            fprintf(stderr, "after update, query '%s': %zu results, expected %zu\n", q.c_str(), result.total,
+                    expected);
+        }
+    }
+    loaded.search("新版", 8, 0, result);
+    size_t renamed = result.total;
+    loaded.save(path);
+    book::TitleIndex reloaded;
+    reloaded.load(path);
+    reloaded.search("新版", 8, 0, result);
+    if (reloaded.size() != library.size() || result.total != renamed) mismatches++;
+    printf("update:    50 renamed, 20 removed, 30 added in %.1f ms; %zu books after reload\n", updateMs,
+           reloaded.size());
+
+    fs::remove(path);
+    if (mismatches > 0) printf("\n%d mismatches\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}